@@ -171,7 +171,7 @@
   *
   * - Bounce2
   *   https://github.com/thomasfredericks/Bounce2
-  *   (used for debouncing the joystick button)  *
+  *   (required to compile the Monocle library joystick module)
   */
 
 /**
@@ -182,16 +182,19 @@
 
 /* REQUIRED FOR WIRELESS NETWORK ON ESP32 */
 #include <WiFi.h>
+#include <WiFiUdp.h>
 
 /* REQUIRED FOR MONOCLE GATEWAY CLIENT */
 #include <ArduinoHttpClient.h>
 #include <ArduinoJson.h>
 
-/* REQUIRED FOR JOYSTICK DIGITAL INPUTS */
-#include <Bounce2.h>
-
 /* MONOCLE IMPLEMENTATION MODULES */
 #include <MonocleGatewayClient.h>
+#include <MonocleDigitalPad.h>
+#include <MonocleDiscovery.h>
+#include <MonocleStorage.h>
+#include <MonocleSnapshot.h>
+#include <MonocleScheduler.h>
 
 /* YOUR PRIVATE INFORMATION */
 #include "private.h"
@@ -207,10 +210,31 @@
 #define PROGRAM_NAME    "Monocle PTZ Controller - AtariJoystick (ESP8622)"
 #define PROGRAM_VERSION "0.0.1"
 
-/* DEFINE PAN, TILT, ZOOM SPEEDS */
-#define PAN_SPEED   2 // 1=low, 2=medium; 3=high
-#define TILT_SPEED  2 // 1=low, 2=medium; 3=high
-#define ZOOM_SPEED  2 // 1=low, 2=medium; 3=high
+/* DEFINE PAN, TILT, ZOOM SPEED (WHEN NOT ACCELERATING) */
+#define PTZ_SPEED   2 // 1=low, 2=medium; 3=high
+
+/* HOLD-TO-ACCELERATE; HELD DIRECTIONS START SLOW AND SPEED UP (0 = DISABLED) */
+#define PTZ_ACCELERATE_MED_DELAY   750   // milliseconds until medium speed
+#define PTZ_ACCELERATE_HIGH_DELAY  2000  // milliseconds until high speed
+
+/* TIME TO WAIT FOR GATEWAY DISCOVERY BEFORE USING THE ADDRESS IN 'private.h' */
+#define DISCOVERY_TIMEOUT 5000  // milliseconds
+
+/* TIME TO WAIT FOR A FAST WI-FI JOIN (SAVED CHANNEL AND ACCESS POINT) BEFORE A FULL SCAN */
+#define WIFI_FAST_JOIN_TIMEOUT 3000  // milliseconds
+
+/* STORAGE ADDRESS OF THE BOOT SNAPSHOT (THE DISCOVERED GATEWAY IS STORED AT 0) */
+#define SNAPSHOT_STORAGE_ADDRESS 32
+
+/* DEFINE THE NETWORK CONNECTION CHECK AND GATEWAY RECONNECT INTERVALS */
+#define LINK_CHECK_INTERVAL      500   // milliseconds
+#define GATEWAY_RECONNECT_DELAY  5000  // milliseconds
+
+/* NETWORK CONNECTION STATES */
+#define LINK_WIFI_CONNECTING     0
+#define LINK_GATEWAY_DISCOVERING 1
+#define LINK_GATEWAY_CONNECTED   2
+#define LINK_RESTARTING          3
 
 
 /* BELOW IS THE PINOUT FOR A ATARI/COMMODORE JOYSTICK DB9 CONNECTOR */
@@ -244,25 +268,34 @@ char* password = WIFI_PASS;
 // wifi client; needed for Monocle Gateway Client
 WiFiClient wifi;
 
-// create Monocle Gateway Client instance
-MonocleGatewayClient monocle = MonocleGatewayClient(wifi, MONOCLE_GATEWAY_ADDRESS, MONOCLE_GATEWAY_PORT);
+// udp socket and persistent storage; needed for Monocle Gateway discovery
+WiFiUDP udp;
+MonocleEEPROMStorage storage;
+
+// create Monocle Gateway discovery instance (finds the gateway on the local network)
+MonocleDiscovery discovery(udp);
+
+// boot snapshot; remembers the Wi-Fi channel and access point for a fast join
+MonocleSnapshot snapshot(storage, SNAPSHOT_STORAGE_ADDRESS);
+
+// Monocle Gateway Client instance; created once the gateway endpoint is known
+MonocleGatewayClient* monocle = NULL;
 
-// create an array of buttons
-const uint8_t JOYSTICK_PINS[] = {JOYSTICK_PIN_UP, JOYSTICK_PIN_DOWN, JOYSTICK_PIN_LEFT, JOYSTICK_PIN_RIGHT, JOYSTICK_PIN_FIRE};
-Bounce * debounce = new Bounce[sizeof(JOYSTICK_PINS)];
+// the discovered gateway endpoint changed while connected
+bool gatewayMoved = false;
 
-// create PTZ instance values
-int pan  = 0;
-int tilt = 0;
-int zoom = 0;
+// cooperative scheduler; services all components from the main loop
+MonocleScheduler scheduler;
 
-// create PTZ last reported values
-int lastPan  = 0;
-int lastTilt = 0;
-int lastZoom = 0;
+// scheduler task ids and the network connection state
+int gatewayTask;
+int linkTask;
+int linkState = LINK_WIFI_CONNECTING;
+unsigned long linkTime = 0;   // start of the current join or discovery attempt
+bool wifiFastJoin = false;    // joining the access point used last time
 
-// double-click timer tracking variable
-unsigned long doubleClickTimer = 0;
+// create Monocle digital pad instance (debounces all joystick switches)
+MonocleDigitalPad pad;
 
 
 /**
@@ -277,22 +310,17 @@ void setup() {
   Serial.begin(115200);
 
   // configure joystick digital input pins
-  // we use a PULLUP to give these pins a HIGH (3.3VDC bias)
+  // the pad uses a PULLUP to give these pins a HIGH (3.3VDC bias)
   // when the joystick makes a contact closure, it will ground each pin
-  // so we need them to be "Pulled Up (to high)" by default
-  // we could use 4.7 - 10K resistors to pull up, but the embedded chip
-  // pull up in software is easier for this prototype
-  pinMode(JOYSTICK_PIN_UP,    INPUT_PULLUP);
-  pinMode(JOYSTICK_PIN_DOWN,  INPUT_PULLUP);
-  pinMode(JOYSTICK_PIN_LEFT,  INPUT_PULLUP);
-  pinMode(JOYSTICK_PIN_RIGHT, INPUT_PULLUP);
-  pinMode(JOYSTICK_PIN_FIRE,  INPUT_PULLUP);
-
-  // attach each joystick pin to the debounce instance
-  for (int i = 0; i < sizeof(JOYSTICK_PINS); i++) {
-    debounce[i].attach(JOYSTICK_PINS[i] , INPUT_PULLUP);
-    debounce[i].interval(10);   // interval in ms
-  }
+  pad.setupPins(JOYSTICK_PIN_UP, JOYSTICK_PIN_DOWN, JOYSTICK_PIN_LEFT, JOYSTICK_PIN_RIGHT, JOYSTICK_PIN_FIRE);
+
+  // LEFT/RIGHT pan; UP/DOWN tilt; UP/DOWN zoom while the fire button is held
+  pad.setSpeed(PTZ_SPEED);
+  pad.setAcceleration(PTZ_ACCELERATE_MED_DELAY, PTZ_ACCELERATE_HIGH_DELAY);
+
+  // register pad event handlers
+  pad.onPTZ(&padPTZChangeHandler);
+  pad.onDoubleClick(&padDoubleClickHandler);
 
   Serial.println("================================================");
   Serial.print(" PROGRAM: ");
@@ -305,16 +333,40 @@ void setup() {
   Serial.print("Connecting to wireless network: ");
   Serial.println(ssid);
 
-  // start the connection to the user's wireless access point
+  // join the access point used last time directly on its channel (skips the
+  // channel scan); the network connection task falls back to a normal join
+  // if that does not succeed
   // @see: https://www.arduino.cc/en/Reference/WiFiBegin
-  WiFi.begin(ssid, password);
-
-  // wait until the wireless network connection has been established
-  while (WiFi.status() != WL_CONNECTED) {
-    delay(500);
-    Serial.print(".");  // print something the let the user know we are still working
-  }
+  storage.begin();
+  wifiFastJoin = snapshot.restore() && snapshot.has(MONOCLE_SNAPSHOT_WIFI);
+  if (wifiFastJoin) WiFi.begin(ssid, password, snapshot.wifiChannel(), snapshot.wifiBSSID());
+  else WiFi.begin(ssid, password);
+  linkTime = millis();
+
+  // a cached gateway endpoint is available immediately once discovery
+  // starts and is revalidated in the background while connected
+  discovery.setStorage(&storage);
+  discovery.onDiscovered(&discoveryHandler);
+
+  // register the digital pad service task; the gateway client task is
+  // registered once the gateway endpoint is known
+  pad.schedule(scheduler);
+
+  // the network connection task waits for the wireless network connection,
+  // finds the Monocle Gateway and connects to it without blocking the main loop
+  linkTask = scheduler.every(LINK_CHECK_INTERVAL, &linkTaskHandler);
+
+  // yield to the WiFi stack between tasks
+  scheduler.onIdle(&idleHandler);
+}
 
+/**
+ * WIRELESS NETWORK CONNECTED
+ * ----------------------------------------------
+ * This method is called once the wireless
+ * network connection has been established.
+ */
+void wifiConnected(){
   // let the user know we have successfully connected to the network
   IPAddress myIP = WiFi.localIP();
   String ip_address = String(myIP[0])+"."+String(myIP[1])+"."+String(myIP[2])+"."+String(myIP[3]);
@@ -324,108 +376,194 @@ void setup() {
   Serial.print(" - IP Address : ");
   Serial.println(ip_address);
   Serial.println("================================================");
-}
 
+  // remember the channel and access point for the next boot
+  snapshot.setWiFi(WiFi.channel(), WiFi.BSSID());
+  snapshot.save();
+
+  // find the Monocle Gateway
+  discovery.begin();
+  discovery.schedule(scheduler);
+}
 
 /**
- * ------------------------------------------------------------------------
- * PROGRAM MAINLINE (LOOP)
- * ------------------------------------------------------------------------
+ * CREATE THE MONOCLE GATEWAY CLIENT
+ * ----------------------------------------------
+ * This method creates the gateway client for the
+ * discovered endpoint (or the endpoint in 'private.h'
+ * if no gateway answered) and registers its task.
  */
-void loop() {
+void gatewayCreate(){
+  if (discovery.found()) {
+    monocle = new MonocleGatewayClient(wifi, discovery.address(), discovery.port());
+  }
+  else {
+    Serial.println("No Monocle Gateway discovered; using the address in 'private.h'.");
+    monocle = new MonocleGatewayClient(wifi, MONOCLE_GATEWAY_ADDRESS, MONOCLE_GATEWAY_PORT);
+  }
 
+  // the gateway client is suspended until the gateway connection is established
+  gatewayTask = monocle->schedule(scheduler);
+  scheduler.suspend(gatewayTask);
+}
+
+/**
+ * CONNECT TO THE MONOCLE GATEWAY
+ * ----------------------------------------------
+ * This method attempts a connection to the
+ * Monocle Gateway and starts servicing the
+ * gateway client on success.
+ */
+void gatewayConnect(){
   // let the user know we are going to attempt a connection to the Monocle Gateway
   Serial.println("Connecting to Monocle Gateway");
 
   // attmept to connect to the Monocle Gateway now
-  monocle.begin();
+  monocle->begin();
+  if (!monocle->connected()) {
+    // the cached gateway endpoint is stale; discover it again after the restart
+    if (discovery.found()) discovery.invalidate();
+    gatewayDisconnected();
+    return;
+  }
 
   // let the user know we are connected to the Monocle Gateway
-  if (monocle.connected()) {
-    Serial.println("Successfully connected to Monocle Gateway.");
-  }
+  Serial.println("Successfully connected to Monocle Gateway.");
+  linkState = LINK_GATEWAY_CONNECTED;
 
-  // continuous loop while we are connected to the Monocle Gateway
-  while (monocle.connected()) {
-
-    // we must call the 'loop' function on the Monocle
-    // client to service communication and raise events
-    monocle.loop();
-
-    // iterate over all the joystick pins in the debounce instance and update them
-    for (int i = 0; i < sizeof(JOYSTICK_PINS); i++)  {
-      debounce[i].update();
-    }
-
-    // WATCH FOR DOUBLE CLICKS ON THE FIRE BUTTON (2 clicks within 250 ms)
-    // (if detected, send the camera to its home position)
-    if(debounce[4].fell()){
-      if(doubleClickTimer > 0 && millis() - doubleClickTimer < 250){
-        Serial.println("--> HOME");
-        monocle.home();
-        doubleClickTimer = 0;
-      }
-      else {
-        doubleClickTimer = millis();
-      }
-    }
-
-    // PROCESS PAN (X-AXIS)
-    if(debounce[2].read() == LOW)       // PA LEFT
-      pan = -PAN_SPEED;                 // (negative pan speed means 'left')
-    else if(debounce[3].read() == LOW)  // PA RIGHT
-      pan = PAN_SPEED;                  // (positive pan speed means 'right')
-    else                                //
-      pan = 0;                          // PAN STOP
-
-    // PROCESS TILT (Y-AXIS) <when fire button is not pressed>
-    if(debounce[4].read() == HIGH && debounce[0].read() == LOW)       // TILT UP
-      tilt = TILT_SPEED;                                              // (positive tilt speed means 'up')
-    else if(debounce[4].read() == HIGH && debounce[1].read() == LOW)  // TILT DOWN
-      tilt = -TILT_SPEED;                                             // (negative tilt speed means 'down')
-    else                                                              //
-      tilt = 0;                                                       // TILT STOP
-
-    // PROCESS ZOOM (Y-AXIS) <when fire button is pressed>
-    if(debounce[4].read() == LOW && debounce[0].read() == LOW)        // ZOOM IN
-      zoom = ZOOM_SPEED;                                              // (positive zoom speed means 'in')
-    else if(debounce[4].read() == LOW && debounce[1].read() == LOW)   // ZOOM OUT DOWN
-      zoom = -ZOOM_SPEED;                                             // (negative zoom speed means 'out')
-    else                                                              //
-      zoom = 0;                                                       // ZOOM STOP
-
-    // do we need to send a PTZ command to the Monocle gateway?
-    if(pan != lastPan || tilt != lastTilt || zoom != lastZoom){
-      // sycn last known PTZ states
-      lastPan  = pan;
-      lastTilt = tilt;
-      lastZoom = zoom;
-
-      // build a display string of the current  PTZ action(s)
-      String info = "--> ";
-      if(pan > 0) info+="PAN RIGHT; ";
-      if(pan < 0) info+="PAN LEFT; ";
-      if(tilt > 0) info+="TILT UP; ";
-      if(tilt < 0) info+="TILT DOWN; ";
-      if(zoom > 0) info+="ZOOM IN; ";
-      if(zoom < 0) info+="ZOOM OUT; ";
-      if(pan == 0 && tilt == 0 && zoom == 0) info+="STOP";
-      Serial.println(info);
-
-      // send PTZ to Monocle gateway
-      monocle.ptz(pan, tilt, zoom);
-    }
-    delay(10);
-  }
+  // start servicing the Monocle client
+  scheduler.resume(gatewayTask);
+}
+
+/**
+ * MONOCLE GATEWAY DISCONNECTED
+ * ----------------------------------------------
+ * This method is called when the gateway connection
+ * fails or is lost; a restart is scheduled.
+ */
+void gatewayDisconnected(){
+  // stop servicing the Monocle client
+  scheduler.suspend(gatewayTask);
 
   // let the user know that we are now disconnected from the Monocle Gateway
   Serial.println("Disconnected from Monocle Gateway.");
   Serial.println("We will attempt to reconnect to the Monocle Gateway in 5 seconds.");
-  delay(5000); // wait 5 seconds before attempting to reconnect
 
-  // I'm not sure why yet, still need to track down this bug, but after a websocket
-  // disconnects, future re-connections are not maintained and continually
-  // disconnect immediately after connect. So we will restart the micro-controller
-  // for the time being.
-  ESP.restart();
+  // wait 5 seconds before attempting to reconnect
+  linkState = LINK_RESTARTING;
+  scheduler.reschedule(linkTask, GATEWAY_RECONNECT_DELAY);
+}
+
+/**
+ * NETWORK CONNECTION TASK
+ * ----------------------------------------------
+ * This scheduler task is called periodically to
+ * advance the network connection state machine.
+ */
+void linkTaskHandler(void* context){
+  switch(linkState){
+    case LINK_WIFI_CONNECTING:
+      // wait until the wireless network connection has been established
+      if(WiFi.status() != WL_CONNECTED){
+        // fall back to a normal join if the fast join does not succeed
+        if(wifiFastJoin && (millis() - linkTime) >= WIFI_FAST_JOIN_TIMEOUT){
+          wifiFastJoin = false;
+          WiFi.disconnect();
+          WiFi.begin(ssid, password);
+        }
+        Serial.print(".");  // print something the let the user know we are still working
+        return;
+      }
+      wifiConnected();
+      linkTime = millis();
+      linkState = LINK_GATEWAY_DISCOVERING;
+      break;
+    case LINK_GATEWAY_DISCOVERING:
+      // wait for a gateway to answer (or use the address in 'private.h')
+      if(!discovery.found() && (millis() - linkTime) < DISCOVERY_TIMEOUT) return;
+      gatewayCreate();
+      gatewayConnect();
+      break;
+    case LINK_GATEWAY_CONNECTED:
+      if(!monocle->connected() || gatewayMoved) gatewayDisconnected();
+      break;
+    case LINK_RESTARTING:
+      // I'm not sure why yet, still need to track down this bug, but after a websocket
+      // disconnects, future re-connections are not maintained and continually
+      // disconnect immediately after connect. So we will restart the micro-controller
+      // for the time being.
+      ESP.restart();
+      break;
+  }
+}
+
+/**
+ * SCHEDULER IDLE CALLBACK
+ * ----------------------------------------------
+ * This callback handler is called when no task
+ * is due; the loop yields to the WiFi stack until
+ * the next deadline so the ESP32 can save
+ * power (the radio modem-sleeps between beacons).
+ */
+void idleHandler(unsigned long milliseconds){
+  delay(milliseconds);
+}
+
+/**
+ * ------------------------------------------------------------------------
+ * GATEWAY DISCOVERY EVENT HANDLER
+ * ------------------------------------------------------------------------
+ */
+void discoveryHandler(const IPAddress& address, const uint16_t port){
+  Serial.print("Monocle Gateway discovered: ");
+  Serial.print(String(address[0])+"."+String(address[1])+"."+String(address[2])+"."+String(address[3]));
+  Serial.print(":");
+  Serial.println(port);
+
+  // a gateway that moved while connected is picked up by reconnecting
+  if (monocle != NULL) gatewayMoved = true;
+}
+
+
+/**
+ * ------------------------------------------------------------------------
+ * DIGITAL PAD PTZ CHANGE EVENT HANDLER
+ * ------------------------------------------------------------------------
+ */
+void padPTZChangeHandler(int pan, int tilt, int zoom){
+  // print the current PTZ action(s)
+  Serial.print("--> ");
+  if(pan > 0) Serial.print("PAN RIGHT; ");
+  if(pan < 0) Serial.print("PAN LEFT; ");
+  if(tilt > 0) Serial.print("TILT UP; ");
+  if(tilt < 0) Serial.print("TILT DOWN; ");
+  if(zoom > 0) Serial.print("ZOOM IN; ");
+  if(zoom < 0) Serial.print("ZOOM OUT; ");
+  if(pan == 0 && tilt == 0 && zoom == 0) Serial.print("STOP");
+  Serial.println();
+
+  // send PTZ to Monocle gateway (once the gateway endpoint is known)
+  if (monocle != NULL) monocle->ptz(pan, tilt, zoom);
+}
+
+/**
+ * ------------------------------------------------------------------------
+ * DIGITAL PAD DOUBLE-CLICK EVENT HANDLER
+ * ------------------------------------------------------------------------
+ */
+void padDoubleClickHandler(){
+  // a double-click on the fire button sends the camera to its home position
+  Serial.println("--> HOME");
+  if (monocle != NULL) monocle->home();
+}
+
+/**
+ * ------------------------------------------------------------------------
+ * PROGRAM MAINLINE (LOOP)
+ * ------------------------------------------------------------------------
+ */
+void loop() {
+  // the scheduler services the network connection, Monocle client,
+  // gateway discovery and digital pad tasks as they become due
+  scheduler.loop();
 }
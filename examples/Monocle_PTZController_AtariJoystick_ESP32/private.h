@@ -7,6 +7,7 @@
 
 /*
  * YOUR MONOCOLE GATEWAY LOCAL IP ADDRESS/HOSTNAME
+ * (ONLY USED WHEN NO GATEWAY IS DISCOVERED ON THE LOCAL NETWORK)
  */
  #define MONOCLE_GATEWAY_ADDRESS "10.1.1.20"
  #define MONOCLE_GATEWAY_PORT     8080
@@ -171,7 +171,7 @@
   *
   * - Bounce2
   *   https://github.com/thomasfredericks/Bounce2
-  *   (used for debouncing the joystick button)  *
+  *   (required to compile the Monocle library joystick module)
   */
 
 /**
@@ -187,12 +187,11 @@
 /* REQUIRED FOR MONOCLE GATEWAY CLIENT */
 #include <ArduinoHttpClient.h>
 #include <ArduinoJson.h>
-
-/* REQUIRED FOR JOYSTICK DIGITAL INPUTS */
-#include <Bounce2.h>
-
 /* MONOCLE IMPLEMENTATION MODULES */
 #include <MonocleGatewayClient.h>
+#include <MonocleDigitalPad.h>
+#include <MonocleScheduler.h>
+#include <MonoclePowerManager.h>
 
 /* YOUR PRIVATE INFORMATION */
 #include "private.h"
@@ -208,10 +207,28 @@
 #define PROGRAM_NAME    "Monocle PTZ Controller - AtariJoystick (ESP8622)"
 #define PROGRAM_VERSION "0.0.1"
 
-/* DEFINE PAN, TILT, ZOOM SPEEDS */
-#define PAN_SPEED   2 // 1=low, 2=medium; 3=high
-#define TILT_SPEED  2 // 1=low, 2=medium; 3=high
-#define ZOOM_SPEED  2 // 1=low, 2=medium; 3=high
+/* DEFINE PAN, TILT, ZOOM SPEED (WHEN NOT ACCELERATING) */
+#define PTZ_SPEED   2 // 1=low, 2=medium; 3=high
+
+/* HOLD-TO-ACCELERATE; HELD DIRECTIONS START SLOW AND SPEED UP (0 = DISABLED) */
+#define PTZ_ACCELERATE_MED_DELAY   750   // milliseconds until medium speed
+#define PTZ_ACCELERATE_HIGH_DELAY  2000  // milliseconds until high speed
+
+/* BATTERY POWER MANAGEMENT; SLOW DOWN SAMPLING AND LET THE RADIO SLEEP WHEN UNUSED */
+#define POWER_IDLE_TIMEOUT         30000   // milliseconds without input until idle
+#define POWER_SLEEP_TIMEOUT        300000  // milliseconds without input until sleep
+#define PAD_SAMPLE_INTERVAL_ACTIVE 4       // milliseconds
+#define PAD_SAMPLE_INTERVAL_IDLE   20      // milliseconds
+#define PAD_SAMPLE_INTERVAL_SLEEP  50      // milliseconds
+
+/* DEFINE THE NETWORK CONNECTION CHECK AND GATEWAY RECONNECT INTERVALS */
+#define LINK_CHECK_INTERVAL      500   // milliseconds
+#define GATEWAY_RECONNECT_DELAY  5000  // milliseconds
+
+/* NETWORK CONNECTION STATES */
+#define LINK_WIFI_CONNECTING     0
+#define LINK_GATEWAY_CONNECTING  1
+#define LINK_GATEWAY_CONNECTED   2
 
 
 /* BELOW IS THE PINOUT FOR A ATARI/COMMODORE JOYSTICK DB9 CONNECTOR */
@@ -248,22 +265,20 @@ WiFiClient wifi;
 // create Monocle Gateway Client instance
 MonocleGatewayClient monocle = MonocleGatewayClient(wifi, MONOCLE_GATEWAY_ADDRESS, MONOCLE_GATEWAY_PORT);
 
-// create an array of buttons
-const uint8_t JOYSTICK_PINS[] = {JOYSTICK_PIN_UP, JOYSTICK_PIN_DOWN, JOYSTICK_PIN_LEFT, JOYSTICK_PIN_RIGHT, JOYSTICK_PIN_FIRE};
-Bounce * debounce = new Bounce[sizeof(JOYSTICK_PINS)];
+// create Monocle digital pad instance (debounces all joystick switches)
+MonocleDigitalPad pad;
 
-// create PTZ instance values
-int pan  = 0;
-int tilt = 0;
-int zoom = 0;
+// cooperative scheduler; services all components from the main loop
+MonocleScheduler scheduler;
 
-// create PTZ last reported values
-int lastPan  = 0;
-int lastTilt = 0;
-int lastZoom = 0;
+// create Monocle power manager instance (idle detection for battery operation)
+MonoclePowerManager power;
 
-// double-click timer tracking variable
-unsigned long doubleClickTimer = 0;
+// scheduler task ids and the network connection state
+int gatewayTask;
+int padTask;
+int linkTask;
+int linkState = LINK_WIFI_CONNECTING;
 
 
 /**
@@ -278,22 +293,18 @@ void setup() {
   Serial.begin(115200);
 
   // configure joystick digital input pins
-  // we use a PULLUP to give these pins a HIGH (3.3VDC bias)
+  // the pad uses a PULLUP to give these pins a HIGH (3.3VDC bias)
   // when the joystick makes a contact closure, it will ground each pin
-  // so we need them to be "Pulled Up (to high)" by default
-  // we could use 4.7 - 10K resistors to pull up, but the embedded chip
-  // pull up in software is easier for this prototype
-  pinMode(JOYSTICK_PIN_UP,    INPUT_PULLUP);
-  pinMode(JOYSTICK_PIN_DOWN,  INPUT_PULLUP);
-  pinMode(JOYSTICK_PIN_LEFT,  INPUT_PULLUP);
-  pinMode(JOYSTICK_PIN_RIGHT, INPUT_PULLUP);
-  pinMode(JOYSTICK_PIN_FIRE,  INPUT_PULLUP);
-
-  // attach each joystick pin to the debounce instance
-  for (int i = 0; i < sizeof(JOYSTICK_PINS); i++) {
-    debounce[i].attach(JOYSTICK_PINS[i] , INPUT_PULLUP);
-    debounce[i].interval(10);   // interval in ms
-  }
+  pad.setupPins(JOYSTICK_PIN_UP, JOYSTICK_PIN_DOWN, JOYSTICK_PIN_LEFT, JOYSTICK_PIN_RIGHT, JOYSTICK_PIN_FIRE);
+  pad.setSampleInterval(PAD_SAMPLE_INTERVAL_ACTIVE);
+
+  // LEFT/RIGHT pan; UP/DOWN tilt; UP/DOWN zoom while the fire button is held
+  pad.setSpeed(PTZ_SPEED);
+  pad.setAcceleration(PTZ_ACCELERATE_MED_DELAY, PTZ_ACCELERATE_HIGH_DELAY);
+
+  // register pad event handlers
+  pad.onPTZ(&padPTZChangeHandler);
+  pad.onDoubleClick(&padDoubleClickHandler);
 
   Serial.println("================================================");
   Serial.print(" PROGRAM: ");
@@ -310,12 +321,36 @@ void setup() {
   // @see: https://www.arduino.cc/en/Reference/WiFiBegin
   WiFi.begin(ssid, password);
 
-  // wait until the wireless network connection has been established
-  while (WiFi.status() != WL_CONNECTED) {
-    delay(500);
-    Serial.print(".");  // print something the let the user know we are still working
-  }
+  // register the component service tasks; the gateway client is suspended
+  // until the gateway connection is established
+  gatewayTask = monocle.schedule(scheduler);
+  padTask = pad.schedule(scheduler);
+  scheduler.suspend(gatewayTask);
+
+  // the network connection task waits for the wireless network connection
+  // and (re)connects to the Monocle Gateway without blocking the main loop
+  linkTask = scheduler.every(LINK_CHECK_INTERVAL, &linkTaskHandler);
+
+  // enter idle/sleep when the joystick is not used; the pad task is run
+  // less often and the radio sleeps, and the fire button interrupt wakes
+  // the controller immediately
+  power.setTimeouts(POWER_IDLE_TIMEOUT, POWER_SLEEP_TIMEOUT);
+  power.onRadioSleep(&radioSleepHandler);
+  power.schedule(scheduler);
+  power.manage(padTask, PAD_SAMPLE_INTERVAL_ACTIVE, PAD_SAMPLE_INTERVAL_IDLE, PAD_SAMPLE_INTERVAL_SLEEP);
+  power.attachWakePin(JOYSTICK_PIN_FIRE);
+
+  // sleep the MCU between tasks
+  scheduler.onIdle(&idleHandler);
+}
 
+/**
+ * WIRELESS NETWORK CONNECTED
+ * ----------------------------------------------
+ * This method is called once the wireless
+ * network connection has been established.
+ */
+void wifiConnected(){
   // let the user know we have successfully connected to the network
   IPAddress myIP = WiFi.localIP();
   String ip_address = String(myIP[0])+"."+String(myIP[1])+"."+String(myIP[2])+"."+String(myIP[3]);
@@ -327,100 +362,146 @@ void setup() {
   Serial.println("================================================");
 }
 
-
 /**
- * ------------------------------------------------------------------------
- * PROGRAM MAINLINE (LOOP)
- * ------------------------------------------------------------------------
+ * CONNECT TO THE MONOCLE GATEWAY
+ * ----------------------------------------------
+ * This method attempts a connection to the
+ * Monocle Gateway and starts servicing the
+ * gateway client on success.
  */
-void loop() {
-
+void gatewayConnect(){
   // let the user know we are going to attempt a connection to the Monocle Gateway
   Serial.println("Connecting to Monocle Gateway");
 
   // attmept to connect to the Monocle Gateway now
   monocle.begin();
+  if (!monocle.connected()) {
+    gatewayDisconnected();
+    return;
+  }
 
   // let the user know we are connected to the Monocle Gateway
-  if (monocle.connected()) {
-    Serial.println("Successfully connected to Monocle Gateway.");
-  }
+  Serial.println("Successfully connected to Monocle Gateway.");
+  linkState = LINK_GATEWAY_CONNECTED;
 
-  // continuous loop while we are connected to the Monocle Gateway
-  while (monocle.connected()) {
-
-    // we must call the 'loop' function on the Monocle
-    // client to service communication and raise events
-    monocle.loop();
-
-    // iterate over all the joystick pins in the debounce instance and update them
-    for (int i = 0; i < sizeof(JOYSTICK_PINS); i++)  {
-      debounce[i].update();
-    }
-
-    // WATCH FOR DOUBLE CLICKS ON THE FIRE BUTTON (2 clicks within 250 ms)
-    // (if detected, send the camera to its home position)
-    if(debounce[4].fell()){
-      if(doubleClickTimer > 0 && millis() - doubleClickTimer < 250){
-        Serial.println("--> HOME");
-        monocle.home();
-        doubleClickTimer = 0;
-      }
-      else {
-        doubleClickTimer = millis();
-      }
-    }
-
-    // PROCESS PAN (X-AXIS)
-    if(debounce[2].read() == LOW)       // PA LEFT
-      pan = -PAN_SPEED;                 // (negative pan speed means 'left')
-    else if(debounce[3].read() == LOW)  // PA RIGHT
-      pan = PAN_SPEED;                  // (positive pan speed means 'right')
-    else                                //
-      pan = 0;                          // PAN STOP
-
-    // PROCESS TILT (Y-AXIS) <when fire button is not pressed>
-    if(debounce[4].read() == HIGH && debounce[0].read() == LOW)       // TILT UP
-      tilt = TILT_SPEED;                                              // (positive tilt speed means 'up')
-    else if(debounce[4].read() == HIGH && debounce[1].read() == LOW)  // TILT DOWN
-      tilt = -TILT_SPEED;                                             // (negative tilt speed means 'down')
-    else                                                              //
-      tilt = 0;                                                       // TILT STOP
-
-    // PROCESS ZOOM (Y-AXIS) <when fire button is pressed>
-    if(debounce[4].read() == LOW && debounce[0].read() == LOW)        // ZOOM IN
-      zoom = ZOOM_SPEED;                                              // (positive zoom speed means 'in')
-    else if(debounce[4].read() == LOW && debounce[1].read() == LOW)   // ZOOM OUT DOWN
-      zoom = -ZOOM_SPEED;                                             // (negative zoom speed means 'out')
-    else                                                              //
-      zoom = 0;                                                       // ZOOM STOP
-
-    // do we need to send a PTZ command to the Monocle gateway?
-    if(pan != lastPan || tilt != lastTilt || zoom != lastZoom){
-      // sycn last known PTZ states
-      lastPan  = pan;
-      lastTilt = tilt;
-      lastZoom = zoom;
-
-      // build a display string of the current  PTZ action(s)
-      String info = "--> ";
-      if(pan > 0) info+="PAN RIGHT; ";
-      if(pan < 0) info+="PAN LEFT; ";
-      if(tilt > 0) info+="TILT UP; ";
-      if(tilt < 0) info+="TILT DOWN; ";
-      if(zoom > 0) info+="ZOOM IN; ";
-      if(zoom < 0) info+="ZOOM OUT; ";
-      if(pan == 0 && tilt == 0 && zoom == 0) info+="STOP";
-      Serial.println(info);
-
-      // send PTZ to Monocle gateway
-      monocle.ptz(pan, tilt, zoom);
-    }
-    delay(10);
-  }
+  // start servicing the Monocle client
+  scheduler.resume(gatewayTask);
+}
+
+/**
+ * MONOCLE GATEWAY DISCONNECTED
+ * ----------------------------------------------
+ * This method is called when the gateway connection
+ * fails or is lost; a reconnect is scheduled.
+ */
+void gatewayDisconnected(){
+  // stop servicing the Monocle client
+  scheduler.suspend(gatewayTask);
 
   // let the user know that we are now disconnected from the Monocle Gateway
   Serial.println("Disconnected from Monocle Gateway.");
   Serial.println("We will attempt to reconnect to the Monocle Gateway in 5 seconds.");
-  delay(5000); // wait 5 seconds before attempting to reconnect
+
+  // wait 5 seconds before attempting to reconnect
+  linkState = LINK_GATEWAY_CONNECTING;
+  scheduler.reschedule(linkTask, GATEWAY_RECONNECT_DELAY);
+}
+
+/**
+ * NETWORK CONNECTION TASK
+ * ----------------------------------------------
+ * This scheduler task is called periodically to
+ * advance the network connection state machine.
+ */
+void linkTaskHandler(void* context){
+  switch(linkState){
+    case LINK_WIFI_CONNECTING:
+      // wait until the wireless network connection has been established
+      if(WiFi.status() != WL_CONNECTED){
+        Serial.print(".");  // print something the let the user know we are still working
+        return;
+      }
+      wifiConnected();
+      linkState = LINK_GATEWAY_CONNECTING;
+      break;
+    case LINK_GATEWAY_CONNECTING:
+      gatewayConnect();
+      break;
+    case LINK_GATEWAY_CONNECTED:
+      if(!monocle.connected()) gatewayDisconnected();
+      break;
+  }
+}
+
+/**
+ * SCHEDULER IDLE CALLBACK
+ * ----------------------------------------------
+ * This callback handler is called when no task
+ * is due; the MCU sleeps until the next interrupt
+ * (the millisecond system tick wakes it at the latest).
+ */
+void idleHandler(unsigned long milliseconds){
+  __WFI();
+}
+
+
+/**
+ * ------------------------------------------------------------------------
+ * DIGITAL PAD PTZ CHANGE EVENT HANDLER
+ * ------------------------------------------------------------------------
+ */
+void padPTZChangeHandler(int pan, int tilt, int zoom){
+  // joystick movement keeps the controller awake
+  power.activity(pan, tilt, zoom);
+
+  // print the current PTZ action(s)
+  Serial.print("--> ");
+  if(pan > 0) Serial.print("PAN RIGHT; ");
+  if(pan < 0) Serial.print("PAN LEFT; ");
+  if(tilt > 0) Serial.print("TILT UP; ");
+  if(tilt < 0) Serial.print("TILT DOWN; ");
+  if(zoom > 0) Serial.print("ZOOM IN; ");
+  if(zoom < 0) Serial.print("ZOOM OUT; ");
+  if(pan == 0 && tilt == 0 && zoom == 0) Serial.print("STOP");
+  Serial.println();
+
+  // send PTZ to Monocle gateway
+  monocle.ptz(pan, tilt, zoom);
+}
+
+/**
+ * ------------------------------------------------------------------------
+ * DIGITAL PAD DOUBLE-CLICK EVENT HANDLER
+ * ------------------------------------------------------------------------
+ */
+void padDoubleClickHandler(){
+  // fire button presses keep the controller awake
+  power.activity();
+
+  // a double-click on the fire button sends the camera to its home position
+  Serial.println("--> HOME");
+  monocle.home();
+}
+
+/**
+ * RADIO SLEEP CALLBACK
+ * ----------------------------------------------
+ * This callback handler is called to place the
+ * WiFi radio in or out of modem-sleep (the radio
+ * still wakes for each access point beacon).
+ */
+void radioSleepHandler(const bool sleep){
+  if(sleep) WiFi.lowPowerMode();
+  else WiFi.noLowPowerMode();
+}
+
+/**
+ * ------------------------------------------------------------------------
+ * PROGRAM MAINLINE (LOOP)
+ * ------------------------------------------------------------------------
+ */
+void loop() {
+  // the scheduler services the network connection, Monocle client,
+  // digital pad and power manager tasks as they become due
+  scheduler.loop();
 }
@@ -199,6 +199,7 @@
 #include <MonocleOLED.h>
 #include <MonocleMenu.h>
 #include <MonocleOLEDMenuRenderer.h>
+#include <MonocleScheduler.h>
 
 /* YOUR PRIVATE INFORMATION */
 #include "private.h"
@@ -236,6 +237,16 @@
 #define OLED_WIDTH  128
 #define OLED_HEIGHT 32
 
+/* DEFINE THE NETWORK CONNECTION CHECK AND GATEWAY RECONNECT INTERVALS */
+#define LINK_CHECK_INTERVAL      500   // milliseconds
+#define GATEWAY_RECONNECT_DELAY  5000  // milliseconds
+#define CAMERA_INFO_DELAY        1000  // milliseconds
+
+/* NETWORK CONNECTION STATES */
+#define LINK_WIFI_CONNECTING     0
+#define LINK_GATEWAY_CONNECTING  1
+#define LINK_GATEWAY_CONNECTED   2
+
 
 /**
  * ------------------------------------------------------------------------
@@ -276,6 +287,14 @@ MonocleOLED display = MonocleOLED(OLED_WIDTH, OLED_HEIGHT);
 MonocleOLEDMenuRenderer renderer = MonocleOLEDMenuRenderer(&display);
 MonocleMenu menu(renderer);
 
+// cooperative scheduler; services all components from the main loop
+MonocleScheduler scheduler;
+
+// scheduler task ids and the network connection state
+int gatewayTask;
+int linkTask;
+int linkState = LINK_WIFI_CONNECTING;
+
 /**
  * ------------------------------------------------------------------------
  * PROGRAM INITIALIZATION
@@ -355,6 +374,9 @@ void setup() {
   // register for active camera source changes
   monocle.onCameraChange(&cameraChangeHandler);
 
+  // register for the active camera's preset list
+  monocle.onPresets(&cameraPresetsHandler);
+
   // display connecting status on OLED
   display.clearText(false);
   display.printLine1("Connecting to WiFi ..", false);
@@ -368,12 +390,29 @@ void setup() {
   // @see: https://www.arduino.cc/en/Reference/WiFiBegin
   WiFi.begin(ssid, password);
 
-  // wait until the wireless network connection has been established
-  while (WiFi.status() != WL_CONNECTED) {
-    delay(500);
-    Serial.print(".");  // print something the let the user know we are still working
-  }
+  // register the component service tasks; the gateway client is suspended
+  // until the gateway connection is established while the joystick and menu
+  // are serviced right away (they do nothing until a camera is enabled)
+  gatewayTask = monocle.schedule(scheduler);
+  joystick.schedule(scheduler);
+  menu.schedule(scheduler);
+  scheduler.suspend(gatewayTask);
 
+  // the network connection task waits for the wireless network connection
+  // and (re)connects to the Monocle Gateway without blocking the main loop
+  linkTask = scheduler.every(LINK_CHECK_INTERVAL, &linkTaskHandler);
+
+  // sleep the MCU between tasks
+  scheduler.onIdle(&idleHandler);
+}
+
+/**
+ * WIRELESS NETWORK CONNECTED
+ * ----------------------------------------------
+ * This method is called once the wireless
+ * network connection has been established.
+ */
+void wifiConnected(){
   // let the user know we have successfully connected to the network
   IPAddress myIP = WiFi.localIP();
   String ip_address = String(myIP[0])+"."+String(myIP[1])+"."+String(myIP[2])+"."+String(myIP[3]);
@@ -388,6 +427,110 @@ void setup() {
   display.printText("WiFi Connected", ip_address, "" , "", true, true);
 }
 
+/**
+ * CONNECT TO THE MONOCLE GATEWAY
+ * ----------------------------------------------
+ * This method attempts a connection to the
+ * Monocle Gateway and starts servicing the
+ * gateway client on success.
+ */
+void gatewayConnect(){
+  // display connecting status on OLED
+  display.printText("Connecting to Gateway", MONOCLE_GATEWAY_ADDRESS, "", "", true, true);
+
+  // let the user know we are going to attempt a connection to the Monocle Gateway
+  Serial.println("Connecting to Monocle Gateway");
+
+  // attmept to connect to the Monocle Gateway now
+  monocle.begin();
+  if (!monocle.connected()) {
+    gatewayDisconnected();
+    return;
+  }
+
+  // let the user know we are connected to the Monocle Gateway
+  Serial.println("Successfully connected to Monocle Gateway.");
+  display.printLine3("Gateway Connected", true, true);
+  linkState = LINK_GATEWAY_CONNECTED;
+
+  // start servicing the Monocle client
+  scheduler.resume(gatewayTask);
+
+  // show the camera information once the connected message has been seen
+  scheduler.after(CAMERA_INFO_DELAY, &cameraInfoTaskHandler);
+}
+
+/**
+ * MONOCLE GATEWAY DISCONNECTED
+ * ----------------------------------------------
+ * This method is called when the gateway connection
+ * fails or is lost; a reconnect is scheduled.
+ */
+void gatewayDisconnected(){
+  // stop servicing the Monocle client
+  scheduler.suspend(gatewayTask);
+
+  // deactivate the menu (if it's active)
+  menu.deactivate();
+
+  // let the user know that we are now disconnected from the Monocle Gateway
+  Serial.println("Disconnected from Monocle Gateway.");
+  Serial.println("We will attempt to reconnect to the Monocle Gateway in 5 seconds.");
+  display.printText("Gateway Disconnected", "Reconnecting in 5 sec");
+
+  // wait 5 seconds before attempting to reconnect
+  linkState = LINK_GATEWAY_CONNECTING;
+  scheduler.reschedule(linkTask, GATEWAY_RECONNECT_DELAY);
+}
+
+/**
+ * NETWORK CONNECTION TASK
+ * ----------------------------------------------
+ * This scheduler task is called periodically to
+ * advance the network connection state machine.
+ */
+void linkTaskHandler(void* context){
+  switch(linkState){
+    case LINK_WIFI_CONNECTING:
+      // wait until the wireless network connection has been established
+      if(WiFi.status() != WL_CONNECTED){
+        Serial.print(".");  // print something the let the user know we are still working
+        return;
+      }
+      wifiConnected();
+      linkState = LINK_GATEWAY_CONNECTING;
+      break;
+    case LINK_GATEWAY_CONNECTING:
+      gatewayConnect();
+      break;
+    case LINK_GATEWAY_CONNECTED:
+      if(!monocle.connected()) gatewayDisconnected();
+      break;
+  }
+}
+
+/**
+ * CAMERA INFO TASK
+ * ----------------------------------------------
+ * This one-shot scheduler task restores the
+ * camera information after connecting.
+ */
+void cameraInfoTaskHandler(void* context){
+  if(linkState == LINK_GATEWAY_CONNECTED && !menu.isActive())
+    displayCameraInfo();
+}
+
+/**
+ * SCHEDULER IDLE CALLBACK
+ * ----------------------------------------------
+ * This callback handler is called when no task
+ * is due; the MCU sleeps until the next interrupt
+ * (the millisecond system tick wakes it at the latest).
+ */
+void idleHandler(unsigned long milliseconds){
+  __WFI();
+}
+
 /**
  * DISPLAY CAMERA INFO
  * ----------------------------------------------
@@ -457,18 +600,15 @@ void joystickPTZChangeHandler(int pan, int tilt, int zoom){
   // (we multiply each axis by two to send a request for mediam speed rather than low speed)
   monocle.ptz(pan*2, tilt*2, zoom*2);
 
-  // build a display string of the current  PTZ action(s)
-  String info = "";
-  if(pan > 0) info+="RIGHT ";
-  if(pan < 0) info+="LEFT ";
-  if(tilt > 0) info+="UP ";
-  if(tilt < 0) info+="DOWN ";
-  if(zoom > 0) info+="IN ";
-  if(zoom < 0) info+="OUT ";
-
-  if(info.length() <= 0)
-    info = "(click for menu)";
-  display.printLine4(info, true, true);
+  // display the current PTZ action(s); formatted directly into
+  // the display's fixed line buffer (no String allocations)
+  if(pan == 0 && tilt == 0 && zoom == 0)
+    display.printLine4("(click for menu)", true, true);
+  else
+    display.printLinef(3, true, true, "%s%s%s",
+                       (pan > 0) ? "RIGHT " : (pan < 0) ? "LEFT " : "",
+                       (tilt > 0) ? "UP " : (tilt < 0) ? "DOWN " : "",
+                       (zoom > 0) ? "IN " : (zoom < 0) ? "OUT " : "");
 
   // enable this debugging info if you need to calibrate your josystick thresholds
   //  Serial.print("PAN=");
@@ -562,7 +702,7 @@ void menuZoomHandler(){
  * MENU SYSTEM PRESET CALLBACK
  * ----------------------------------------------
  * This callback handler is called whenever
- * one of the (1-9) 'Preset' items is selected in
+ * one of the 'Preset' items is selected in
  * the menu system.
  */
 void menuPresetHandler(const int preset){
@@ -602,55 +742,35 @@ void cameraChangeHandler(CameraSource& camera){
   // deactivate the menu (if it's active)
   menu.deactivate();
 
+  // list generic presets until the gateway provides
+  // the preset list for this camera
+  menu.resetPresets();
+
   // update display
   displayCameraInfo();
 }
 
+/**
+ * ACTIVE CAMERA PRESET LIST CALLBACK
+ * ----------------------------------------------
+ * This callback handler is invoked whenever the
+ * gateway provides the preset list (including
+ * preset names) for the active camera source.
+ */
+void cameraPresetsHandler(CameraPreset* presets, const int count){
+  menu.clearPresets();
+  for(int index = 0; index < count; index++){
+    menu.addPreset(presets[index].name);
+  }
+}
+
 /**
  * ------------------------------------------------------------------------
  * PROGRAM MAINLINE (LOOP)
  * ------------------------------------------------------------------------
  */
 void loop() {
-  // display connecting status on OLED
-  display.printText("Connecting to Gateway", MONOCLE_GATEWAY_ADDRESS, "", "", true, true);
-
-  // let the user know we are going to attempt a connection to the Monocle Gateway
-  Serial.println("Connecting to Monocle Gateway");
-
-  // attmept to connect to the Monocle Gateway now
-  monocle.begin();
-
-  // let the user know we are connected to the Monocle Gateway
-  if (monocle.connected()) {
-    Serial.println("Successfully connected to Monocle Gateway.");
-    display.printLine3("Gateway Connected", true, true);
-    delay(1000);
-    displayCameraInfo();
-  }
-
-  // continuous loop while we are connected to the Monocle Gateway
-  while (monocle.connected()) {
-
-    // we must call the 'loop' function on the Monocle
-    // client to service communication and raise events
-    monocle.loop();
-
-    // we must call the 'loop' function on the joystick
-    // class to service inputs and raise events
-    joystick.loop();
-
-    // we must call the 'loop' function on the menu
-    // class to service the display and raise events
-    menu.loop();
-  }
-
-  // deactivate the menu (if it's active)
-  menu.deactivate();
-
-  // let the user know that we are now disconnected from the Monocle Gateway
-  Serial.println("Disconnected from Monocle Gateway.");
-  Serial.println("We will attempt to reconnect to the Monocle Gateway in 5 seconds.");
-  display.printText("Gateway Disconnected", "Reconnecting in 5 sec");
-  delay(5000); // wait 5 seconds before attempting to reconnect
+  // the scheduler services the network connection, Monocle client,
+  // joystick and menu tasks as they become due
+  scheduler.loop();
 }
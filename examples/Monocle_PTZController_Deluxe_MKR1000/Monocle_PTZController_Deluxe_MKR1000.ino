@@ -77,7 +77,7 @@
   * account on MonocleCam and configure your netowrk cameras to use this
   * service.
   *
-  * https://monoclecam.com | https://monocle.cam (not .com)
+  * https://monoclecam.com | https://monocle->cam (not .com)
   */
 
 /**
@@ -130,6 +130,9 @@
  *       http://amzn.to/2HqFFyT
  *       $7.99 USD  <AMAZON PRIME>
  *
+ *  1 @  Detented Rotary Encoder (e.g. KY-040 module)
+ *       (menu navigation and fine zoom dial; leave unconnected if not used)
+ *
  * (NOTE: prices listed are at the time of this writing: 2018-02-18)
  */
 
@@ -197,6 +200,15 @@
 #include <MonocleOLED.h>
 #include <MonocleMenu.h>
 #include <MonocleOLEDMenuRenderer.h>
+#include <MonocleScheduler.h>
+#include <MonoclePowerManager.h>
+#include <MonocleStorage.h>
+#include <MonocleSnapshot.h>
+#include <MonocleRotaryEncoder.h>
+#include <MonocleMotionPlanner.h>
+#include <MonocleConfig.h>
+#include <MonocleTelemetry.h>
+#include <MonocleMacro.h>
 
 /* YOUR PRIVATE INFORMATION */
 #include "private.h"
@@ -218,7 +230,17 @@
 #define PIN_ZOOM    A4  // analog input pin 4 (ZOOM) <Z-AXIS>
 #define PIN_BUTTON  0   // joystick center (select) button
 
+/* ROTARY ENCODER PINS (BOTH PINS MUST SUPPORT INTERRUPTS) */
+#define PIN_ENCODER_A  4   // encoder 'A' (CLK) pin
+#define PIN_ENCODER_B  5   // encoder 'B' (DT) pin
+
+/* ZOOM UNITS (SEE 'MonocleMotionPlanner') NUDGED PER ENCODER ZOOM STEP */
+#define ENCODER_ZOOM_STEP  0.05
+
 /* IF YOUR PTZ JOYSTICK IS WORKING BACKWARDS, YOU CAN INVERT EACH AXIS HERE */
+/* (THE AXIS INVERSION, THRESHOLDS AND 'private.h' SETTINGS ARE WRITTEN TO THE */
+/*  CONFIGURATION ON THE FIRST BOOT; AFTERWARDS CHANGE THEM WITHOUT REFLASHING */
+/*  FROM THE SERIAL MONITOR ('list', 'set thresholdLow 600', ...) OR GATEWAY) */
 #define INVERT_PAN_AXIS   true
 #define INVERT_TILT_AXIS  false
 #define INVERT_ZOOM_AXIS  true
@@ -238,6 +260,28 @@
 #define OLED_WIDTH  128
 #define OLED_HEIGHT 64
 
+/* DEFINE THE NETWORK CONNECTION TIMING */
+#define LINK_CHECK_INTERVAL      500   // milliseconds
+#define GATEWAY_RECONNECT_DELAY  5000  // milliseconds
+#define CAMERA_INFO_DELAY        1000  // milliseconds
+
+/* DEFINE THE JOYSTICK SAMPLE INTERVAL WHEN IDLE AND ASLEEP (BATTERY OPERATION) */
+#define JOYSTICK_IDLE_INTERVAL   50    // milliseconds
+#define JOYSTICK_SLEEP_INTERVAL  200   // milliseconds
+
+/* NUMBER OF PTZ MACROS IN THE "Run Macro" MENU (UP TO MONOCLE_MACRO_MAX_MACROS) */
+#define MACRO_COUNT 4
+
+/* FLASH STORAGE LAYOUT: BOOT SNAPSHOT, CONFIGURATION AND MACROS BACK TO BACK */
+#define CONFIG_STORAGE_ADDRESS  (sizeof(MonocleRecordHeader) + sizeof(MonocleSnapshotRecord))
+#define MACRO_STORAGE_ADDRESS   (CONFIG_STORAGE_ADDRESS + sizeof(MonocleRecordHeader) + sizeof(MonocleConfigRecord))
+#define STORAGE_END             (MACRO_STORAGE_ADDRESS + MONOCLE_MACRO_MAX_MACROS * (sizeof(MonocleRecordHeader) + sizeof(MonocleMacroRecord)))
+
+/* NETWORK CONNECTION STATES */
+#define LINK_WIFI_CONNECTING     0
+#define LINK_GATEWAY_CONNECTING  1
+#define LINK_GATEWAY_CONNECTED   2
+
 
 /**
  * ------------------------------------------------------------------------
@@ -254,6 +298,10 @@
 #error("Height incorrect, please fix Adafruit_SSD1306.h!");
 #endif
 
+/* VERIFY THAT THE SNAPSHOT, CONFIGURATION AND MACROS FIT THE RESERVED FLASH REGION */
+static_assert(STORAGE_END <= MONOCLE_STORAGE_FLASH_SIZE, "increase MONOCLE_STORAGE_FLASH_SIZE (or reduce the macros)");
+static_assert(MACRO_COUNT <= MONOCLE_MACRO_MAX_MACROS && MACRO_COUNT <= MONOCLE_MENU_MAX_MACROS, "too many macros");
+
 
 /**
  * ------------------------------------------------------------------------
@@ -261,20 +309,52 @@
  * ------------------------------------------------------------------------
  */
 
- /* WIRELESS NETWORK SSID AND PASSWORD ARE STORED IN 'private.h' */
-const char* ssid     = WIFI_SSID;
-const char* password = WIFI_PASS;
+ /* WIRELESS NETWORK SSID AND PASSWORD ARE READ FROM THE CONFIGURATION */
+const char* ssid     = NULL;
+const char* password = NULL;
 
 // wifi client; needed for Monocle Gateway Client
 WiFiClient wifi;
 
-// create Monocle Gateway Client, PTZ Joystick, OLED and Menu instances
-MonocleGatewayClient monocle = MonocleGatewayClient(wifi, MONOCLE_GATEWAY_ADDRESS, MONOCLE_GATEWAY_PORT);
+// Monocle Gateway Client; created in setup for the configured gateway endpoint
+MonocleGatewayClient* monocle = NULL;
+
+// create PTZ Joystick, OLED and Menu instances
 MonoclePTZJoystick joystick = MonoclePTZJoystick();
 MonocleOLED display = MonocleOLED(OLED_WIDTH, OLED_HEIGHT);
 MonocleOLEDMenuRenderer renderer = MonocleOLEDMenuRenderer(&display);
 MonocleMenu menu(renderer);
 
+// rotary encoder; turns the menu cursor or nudges the zoom (through the motion planner)
+MonocleRotaryEncoder encoder;
+MonocleMotionPlanner* planner = NULL;
+
+// cooperative scheduler; services all components from the main loop
+MonocleScheduler scheduler;
+
+// power manager; dims the OLED and slows down joystick sampling when unused
+MonoclePowerManager power;
+
+// boot snapshot in flash; restores the last camera and joystick calibration at power up
+MonocleFlashStorage storage;
+MonocleSnapshot snapshot(storage);
+
+// runtime configuration; stored in flash after the boot snapshot
+MonocleConfig config(storage, CONFIG_STORAGE_ADDRESS);
+
+// PTZ macros; stored in flash after the configuration, created in setup for the gateway client
+MonocleMacro* macros = NULL;
+
+// telemetry; task timing, connection and command counters sent to the gateway
+MonocleTelemetry telemetry;
+
+// scheduler task ids and the network connection state
+int gatewayTask;
+int joystickTask;
+int menuTask;
+int linkTask;
+int linkState = LINK_WIFI_CONNECTING;
+
 /**
  * ------------------------------------------------------------------------
  * PROGRAM INITIALIZATION
@@ -289,7 +369,6 @@ void setup() {
   display.begin(SSD1306_SWITCHCAPVCC, 0x3C);  // initialize with the I2C addr 0x3C (for the 128x64)
   display.init();
 
-  delay(2000); // <-- this is an artificial delay to see this data in the debug console when using Arduino IDE
   Serial.println("================================================");
   Serial.print(" PROGRAM: ");
   Serial.println(PROGRAM_NAME);
@@ -319,31 +398,102 @@ void setup() {
   // configure the joystick button and debounce interval
   joystick.setupButton(PIN_BUTTON, BUTTON_DEBOUNCE_INTERVAL);
 
-  // optionally configure axis inversion
-  joystick.invertPanAxis(INVERT_PAN_AXIS);
-  joystick.invertTiltAxis(INVERT_TILT_AXIS);
-  joystick.invertZoomAxis(INVERT_ZOOM_AXIS);
-
-  // configure joystick thresholds for LOW, MED and HIGH states
-  joystick.setAllThresholds(JOYSTICK_THRESHOLD_LOW, JOYSTICK_THRESHOLD_MED, JOYSTICK_THRESHOLD_HIGH);
+  // load the runtime configuration; on the first boot after an upload it
+  // is created from 'private.h' and the axis inversion and thresholds above
+  storage.begin();
+  if (!config.load()) {
+    config.setText(MONOCLE_CONFIG_WIFI_SSID, WIFI_SSID);
+    config.setText(MONOCLE_CONFIG_WIFI_PASS, WIFI_PASS);
+    config.setText(MONOCLE_CONFIG_GATEWAY_ADDRESS, MONOCLE_GATEWAY_ADDRESS);
+    config.setUInt(MONOCLE_CONFIG_GATEWAY_PORT, MONOCLE_GATEWAY_PORT);
+    config.setBool(MONOCLE_CONFIG_INVERT_PAN, INVERT_PAN_AXIS);
+    config.setBool(MONOCLE_CONFIG_INVERT_TILT, INVERT_TILT_AXIS);
+    config.setBool(MONOCLE_CONFIG_INVERT_ZOOM, INVERT_ZOOM_AXIS);
+    config.setInt(MONOCLE_CONFIG_THRESHOLD_LOW, JOYSTICK_THRESHOLD_LOW);
+    config.setInt(MONOCLE_CONFIG_THRESHOLD_MED, JOYSTICK_THRESHOLD_MED);
+    config.setInt(MONOCLE_CONFIG_THRESHOLD_HIGH, JOYSTICK_THRESHOLD_HIGH);
+    config.save();
+  }
+  ssid = config.getText(MONOCLE_CONFIG_WIFI_SSID);
+  password = config.getText(MONOCLE_CONFIG_WIFI_PASS);
+
+  // create the Monocle Gateway Client for the configured gateway endpoint
+  // (the address text is owned by the configuration) and the zoom planner
+  monocle = new MonocleGatewayClient(wifi, config.getText(MONOCLE_CONFIG_GATEWAY_ADDRESS), config.getUInt(MONOCLE_CONFIG_GATEWAY_PORT));
+  planner = new MonocleMotionPlanner(*monocle);
+  macros = new MonocleMacro(*monocle, storage, MACRO_STORAGE_ADDRESS);
+
+  // apply the axis inversion, thresholds and status filter now and whenever
+  // they are changed from the serial monitor or by the Monocle Gateway
+  config.attach(&joystick);
+  config.attach(monocle);
+  config.serve(&Serial);
+  config.onChange(&configChangeHandler);
+
+  // collect task timing and gateway traffic and send telemetry frames to the
+  // gateway at the configured interval ('set telemetryInterval 0' turns it off)
+  scheduler.reportTo(&telemetry);
+  monocle->reportTo(&telemetry);
+  config.attach(&telemetry);
+  telemetry.onSample(&telemetrySampleHandler);
 
   // register for PTZ event and button press event callbacks
   joystick.onPTZ(&joystickPTZChangeHandler);
   joystick.onButtonPress(&joystickButtonPressHandler);
 
+  // configure the rotary encoder; it moves the menu cursor while
+  // the menu is active and is a fine zoom dial otherwise
+  encoder.setupPins(PIN_ENCODER_A, PIN_ENCODER_B);
+  encoder.driveMenu(&menu);
+  encoder.onRotate(&encoderRotateHandler);
+  encoder.onZoom(&encoderZoomHandler);
+  planner->onComplete(&zoomCompleteHandler);
+
   // register for Menu event callbacks
   menu.onActivate(&menuActivateHandler);
   menu.onDeactivate(&menuDeactivateHandler);
   menu.onHome(&menuHomeHandler);
   menu.onPreset(&menuPresetHandler);
+  menu.onMacro(&menuMacroHandler);
+
+  // add the PTZ macros to the "Run Macro" menu; selecting an empty macro
+  // records the joystick moves until the joystick button is clicked
+  for (int index = 0; index < MACRO_COUNT; index++)
+    menu.addMacro(NULL);
+  macros->onComplete(&macroCompleteHandler);
 
   // register for active camera source changes
-  monocle.onCameraChange(&cameraChangeHandler);
+  monocle->onCameraChange(&cameraChangeHandler);
+
+  // register for the active camera's preset list
+  monocle->onPresets(&cameraPresetsHandler);
+
+  // register for gateway camera list changes; the menu's "Cameras" submenu
+  // requests the rows it shows and switches the active camera when selected
+  monocle->onCameraList(&cameraListHandler);
+  monocle->onCameraEntry(&cameraEntryHandler);
+  menu.onCameraRequest(&menuCameraRequestHandler);
+  menu.onCamera(&menuCameraHandler);
+  monocle->subscribeCameras();
+
+  // restore the boot snapshot so the display and joystick are live before
+  // the network is; on the first boot after an upload the joystick resting
+  // position is calibrated instead (don't touch the joystick while powering up)
+  if (snapshot.restore()) {
+    snapshot.restoreCalibration(joystick);
+    snapshot.restoreCamera(*monocle);
+  }
+  else {
+    joystick.calibrate();
+    snapshot.setCalibration(joystick);
+  }
 
-  // display connecting status on OLED
-  display.clearText(false);
-  display.printLine1("Connecting to WiFi ..", false);
-  display.printLine2(ssid, true, true);
+  // display connecting status on OLED (unless a restored camera is shown)
+  if (!snapshot.has(MONOCLE_SNAPSHOT_CAMERA)) {
+    display.clearText(false);
+    display.printLine1("Connecting to WiFi ..", false);
+    display.printLine2(ssid, true, true);
+  }
 
   // let the user know that we are attempting to connect to the wireless network
   Serial.print("Connecting to wireless network: ");
@@ -353,12 +503,44 @@ void setup() {
   // @see: https://www.arduino.cc/en/Reference/WiFiBegin
   WiFi.begin(ssid, password);
 
-  // wait until the wireless network connection has been established
-  while (WiFi.status() != WL_CONNECTED) {
-    delay(500);
-    Serial.print(".");  // print something the let the user know we are still working
-  }
+  // register the component service tasks; the gateway client is suspended
+  // until the gateway connection is established while the joystick and menu
+  // are live as soon as a camera is known (restored or received)
+  gatewayTask = monocle->schedule(scheduler);
+  joystickTask = joystick.schedule(scheduler);
+  menuTask = menu.schedule(scheduler);
+  encoder.schedule(scheduler);
+  planner->schedule(scheduler);
+  macros->schedule(scheduler);
+  scheduler.suspend(gatewayTask);
+
+  // save snapshot and configuration changes in the background
+  // (the configuration task also serves the serial monitor commands)
+  snapshot.schedule(scheduler);
+  config.schedule(scheduler);
+
+  // register the network connection task; it waits for the wireless network
+  // and (re)connects to the Monocle Gateway without blocking the main loop
+  linkTask = scheduler.every(LINK_CHECK_INTERVAL, &linkTaskHandler);
+
+  // dim/blank the display and slow down the joystick when it is not used;
+  // pressing the joystick button wakes the controller immediately
+  power.schedule(scheduler);
+  power.manage(joystickTask, JOYSTICK_TASK_INTERVAL, JOYSTICK_IDLE_INTERVAL, JOYSTICK_SLEEP_INTERVAL);
+  power.setDisplay(&display);
+  power.attachWakePin(PIN_BUTTON);
+
+  // sleep between tasks rather than busy-waiting
+  scheduler.onIdle(&idleHandler);
+}
 
+/**
+ * WIRELESS NETWORK CONNECTED
+ * ----------------------------------------------
+ * This method is called once the wireless
+ * network connection has been established.
+ */
+void wifiConnected(){
   // let the user know we have successfully connected to the network
   IPAddress myIP = WiFi.localIP();
   String ip_address = String(myIP[0])+"."+String(myIP[1])+"."+String(myIP[2])+"."+String(myIP[3]);
@@ -369,8 +551,116 @@ void setup() {
   Serial.println(ip_address);
   Serial.println("================================================");
 
-  // display connected status on OLED
-  display.printText("WiFi Connected", ip_address, "" , "", true, true);
+  // display connected status on OLED (unless a restored camera is shown)
+  if (!monocle->isCameraEnabled())
+    display.printText("WiFi Connected", ip_address, "" , "", true, true);
+}
+
+/**
+ * CONNECT TO THE MONOCLE GATEWAY
+ * ----------------------------------------------
+ * This method attempts a connection to the
+ * Monocle Gateway and starts servicing the
+ * gateway client, joystick and menu on success.
+ */
+void gatewayConnect(){
+  // display connecting status on OLED (unless a restored camera is shown)
+  if (!monocle->isCameraEnabled())
+    display.printText("Connecting to Gateway", config.getText(MONOCLE_CONFIG_GATEWAY_ADDRESS), "", "", true, true);
+
+  // let the user know we are going to attempt a connection to the Monocle Gateway
+  Serial.println("Connecting to Monocle Gateway");
+
+  // attmept to connect to the Monocle Gateway now
+  monocle->begin();
+  if (!monocle->connected()) {
+    gatewayDisconnected();
+    return;
+  }
+
+  // let the user know we are connected to the Monocle Gateway
+  Serial.println("Successfully connected to Monocle Gateway.");
+  display.printLine3("Gateway Connected", true, true);
+  linkState = LINK_GATEWAY_CONNECTED;
+
+  // start servicing the Monocle client
+  scheduler.resume(gatewayTask);
+
+  // show the camera information once the connected message has been seen
+  scheduler.after(CAMERA_INFO_DELAY, &cameraInfoTaskHandler);
+}
+
+/**
+ * MONOCLE GATEWAY DISCONNECTED
+ * ----------------------------------------------
+ * This method is called when the gateway connection
+ * fails or is lost; a reconnect is scheduled.
+ */
+void gatewayDisconnected(){
+  // stop servicing the Monocle client
+  scheduler.suspend(gatewayTask);
+
+  // deactivate the menu (if it's active); the camera list
+  // is sent again once the gateway is reconnected
+  menu.deactivate();
+  menu.clearCameras();
+
+  // let the user know that we are now disconnected from the Monocle Gateway
+  Serial.println("Disconnected from Monocle Gateway.");
+  Serial.println("We will attempt to reconnect to the Monocle Gateway in 5 seconds.");
+  display.printText("Gateway Disconnected", "Reconnecting in 5 sec");
+
+  // wait 5 seconds before attempting to reconnect
+  linkState = LINK_GATEWAY_CONNECTING;
+  scheduler.reschedule(linkTask, GATEWAY_RECONNECT_DELAY);
+}
+
+/**
+ * NETWORK CONNECTION TASK
+ * ----------------------------------------------
+ * This scheduler task is called periodically to
+ * advance the network connection state machine.
+ */
+void linkTaskHandler(void* context){
+  switch(linkState){
+    case LINK_WIFI_CONNECTING:
+      // wait until the wireless network connection has been established
+      if(WiFi.status() != WL_CONNECTED){
+        Serial.print(".");  // print something the let the user know we are still working
+        return;
+      }
+      wifiConnected();
+      linkState = LINK_GATEWAY_CONNECTING;
+      break;
+    case LINK_GATEWAY_CONNECTING:
+      gatewayConnect();
+      break;
+    case LINK_GATEWAY_CONNECTED:
+      if(!monocle->connected()) gatewayDisconnected();
+      break;
+  }
+}
+
+/**
+ * CAMERA INFO TASK
+ * ----------------------------------------------
+ * This one-shot scheduler task restores the
+ * camera information after connecting.
+ */
+void cameraInfoTaskHandler(void* context){
+  if(linkState == LINK_GATEWAY_CONNECTED && !menu.isActive())
+    displayCameraInfo();
+}
+
+/**
+ * SCHEDULER IDLE CALLBACK
+ * ----------------------------------------------
+ * This callback handler is called when no task
+ * is due; the MCU sleeps until the next interrupt
+ * (the millisecond system tick wakes it at the latest).
+ */
+void idleHandler(unsigned long milliseconds){
+  __WFI();
 }
 
 /**
@@ -399,8 +689,11 @@ void setup() {
  */
 void joystickPTZChangeHandler(int pan, int tilt, int zoom){
 
+  // joystick movement keeps the controller awake
+  power.activity(pan, tilt, zoom);
+
   // bail out if the active camera source is not enabled
-  if(!monocle.isCameraEnabled())
+  if(!monocle->isCameraEnabled())
     return;
 
   // use the joystick inputs to handle menu
@@ -414,21 +707,27 @@ void joystickPTZChangeHandler(int pan, int tilt, int zoom){
     return;
   }
 
-  // send instruction to the Monocle gateway client to perform the PTZ movement
-  monocle.ptz(pan, tilt, zoom);
+  // camera movements need the gateway connection
+  if(!monocle->connected()){
+    display.printLine4("(offline)", true, true);
+    return;
+  }
+
+  // record the movement if a macro is being recorded (stops a playing macro)
+  macros->input(pan, tilt, zoom);
 
-  // build a display string of the current  PTZ action(s)
-  String info = "";
-  if(pan > 0) info+="RIGHT ";
-  if(pan < 0) info+="LEFT ";
-  if(tilt > 0) info+="UP ";
-  if(tilt < 0) info+="DOWN ";
-  if(zoom > 0) info+="IN ";
-  if(zoom < 0) info+="OUT ";
+  // send instruction to the Monocle gateway client to perform the PTZ movement
+  monocle->ptz(pan, tilt, zoom);
 
-  if(info.length() <= 0)
-    info = "(click for menu)";
-  display.printLine4(info, true, true);
+  // display the current PTZ action(s); formatted directly into
+  // the display's fixed line buffer (no String allocations)
+  if(pan == 0 && tilt == 0 && zoom == 0)
+    display.printLine4("(click for menu)", true, true);
+  else
+    display.printLinef(3, true, true, "%s%s%s",
+                       (pan > 0) ? "RIGHT " : (pan < 0) ? "LEFT " : "",
+                       (tilt > 0) ? "UP " : (tilt < 0) ? "DOWN " : "",
+                       (zoom > 0) ? "IN " : (zoom < 0) ? "OUT " : "");
 
   // enable this debugging info if you need to calibrate your josystick thresholds
   //  Serial.print("PAN=");
@@ -445,6 +744,51 @@ void joystickPTZChangeHandler(int pan, int tilt, int zoom){
   //  Serial.println(joystick.zoomState());
 }
 
+/**
+ * ROTARY ENCODER ROTATE CALLBACK
+ * ----------------------------------------------
+ * This callback handler is called whenever
+ * the rotary encoder is turned (the encoder
+ * moves the menu cursor by itself).
+ */
+void encoderRotateHandler(const int detents){
+  // encoder turns keep the controller awake
+  power.activity();
+}
+
+/**
+ * ROTARY ENCODER ZOOM CALLBACK
+ * ----------------------------------------------
+ * This callback handler is called whenever
+ * the rotary encoder is turned while the menu
+ * is not active.  The 'steps' grow with the
+ * speed of the turn (positive is clockwise).
+ */
+void encoderZoomHandler(const int steps){
+  // bail out if the active camera source is not enabled
+  if(!monocle->isCameraEnabled())
+    return;
+
+  // nudge the zoom; the planner times the zoom movement
+  if(!planner->move(0, 0, steps * ENCODER_ZOOM_STEP)){
+    display.printLine4("(offline)", true, true);
+    return;
+  }
+  display.printLine4((steps > 0) ? "ZOOM IN" : "ZOOM OUT", true, true);
+}
+
+/**
+ * ZOOM COMPLETE CALLBACK
+ * ----------------------------------------------
+ * This callback handler is called when the
+ * motion planner finished (or aborted) an
+ * encoder zoom movement.
+ */
+void zoomCompleteHandler(const bool completed){
+  if(!menu.isActive())
+    display.printLine4("(click for menu)", true, true);
+}
+
 /**
  * DISPLAY CAMERA INFO
  * ----------------------------------------------
@@ -453,14 +797,14 @@ void joystickPTZChangeHandler(int pan, int tilt, int zoom){
  * OLED display.
  */
 void displayCameraInfo(){
-  if(monocle.activeCameraSource().error){
-    display.printText("CAMERA ERROR!", monocle.activeCameraSource().name, "", "(DISABLED)", true, true);
+  if(monocle->activeCameraSource().error){
+    display.printText("CAMERA ERROR!", monocle->activeCameraSource().name, "", "(DISABLED)", true, true);
   }
-  else if(!monocle.activeCameraSource().ptz) {
-    display.printText("PTZ NOT SUPPORTED!", monocle.activeCameraSource().name, "", "(DISABLED)", true, true);
+  else if(!monocle->activeCameraSource().ptz) {
+    display.printText("PTZ NOT SUPPORTED!", monocle->activeCameraSource().name, "", "(DISABLED)", true, true);
   }
   else {
-    display.printText("CAMERA READY!", monocle.activeCameraSource().name, "", "(click for menu)", true, true);
+    display.printText("CAMERA READY!", monocle->activeCameraSource().name, "", "(click for menu)", true, true);
   }
 }
 
@@ -471,10 +815,19 @@ void displayCameraInfo(){
  * the PTZ joystick button is pressed
  */
 void joystickButtonPressHandler(){
+  // joystick button presses keep the controller awake
+  power.activity();
+
   // bail out if the active camera source is not enabled
-  if(!monocle.isCameraEnabled())
+  if(!monocle->isCameraEnabled())
     return;
 
+  // a click ends a macro recording and saves the macro
+  if(macros->isRecording()){
+    display.printLine4(macros->finish() ? "(macro saved)" : "(macro too long)", true, true);
+    return;
+  }
+
   // if the menu is not currently active, then activate it
   if(!menu.isActive()){
     menu.activate();
@@ -532,20 +885,72 @@ void menuHomeHandler(){
   // send instruction to the Monocle gateway client
   // to perform the PTZ goto home position action.
   Serial.println("MENU HOME");
-  monocle.home();
+  monocle->home();
 }
 
 /**
  * MENU SYSTEM PRESET CALLBACK
  * ----------------------------------------------
  * This callback handler is called whenever
- * one of the (1-9) 'Preset' items is selected in
+ * one of the 'Preset' items is selected in
  * the menu system.
  */
 void menuPresetHandler(const int preset){
   // send instruction to the Monocle gateway client
   // to perform the PTZ preset recall action.
-  monocle.preset(preset);
+  monocle->preset(preset);
+}
+
+/**
+ * MENU SYSTEM MACRO CALLBACK
+ * ----------------------------------------------
+ * This callback handler is called whenever
+ * one of the 'Run Macro' items is selected in
+ * the menu system.  A stored macro is played;
+ * an empty one starts recording the joystick.
+ */
+void menuMacroHandler(const int macro){
+  if(macros->has(macro)){
+    if(!macros->play(macro)) display.printLine4("(macro failed)", true, true);
+  }
+  else if(macros->record(macro)){
+    display.printLinef(3, true, true, "REC MACRO %d (click)", macro);
+  }
+}
+
+/**
+ * MACRO PLAYBACK COMPLETE CALLBACK
+ * ----------------------------------------------
+ * This callback handler is called whenever a
+ * macro finishes playing or is interrupted by
+ * joystick input or a gateway disconnect.
+ */
+void macroCompleteHandler(const uint8_t macro, const bool completed){
+  display.printLine4(completed ? "(click for menu)" : "(macro stopped)", true, true);
+}
+
+/**
+ * MENU SYSTEM CAMERA CALLBACK
+ * ----------------------------------------------
+ * This callback handler is called whenever
+ * one of the 'Cameras' items is selected in
+ * the menu system.
+ */
+void menuCameraHandler(const char* uuid){
+  // send instruction to the Monocle gateway client to switch
+  // the active camera; the gateway answers with the new source
+  monocle->selectCamera(uuid);
+}
+
+/**
+ * MENU SYSTEM CAMERA ROWS REQUEST CALLBACK
+ * ----------------------------------------------
+ * This callback handler is called whenever the
+ * 'Cameras' menu needs camera list rows (it only
+ * holds the rows around the cursor).
+ */
+void menuCameraRequestHandler(const int offset, const int count){
+  monocle->requestCameras(offset, count);
 }
 
 /**
@@ -579,55 +984,87 @@ void cameraChangeHandler(CameraSource& camera){
   // deactivate the menu (if it's active)
   menu.deactivate();
 
+  // list generic presets until the gateway provides
+  // the preset list for this camera
+  menu.resetPresets();
+
   // update display
   displayCameraInfo();
+
+  // remember the camera for the next boot
+  snapshot.setCamera(camera);
 }
 
 /**
- * ------------------------------------------------------------------------
- * PROGRAM MAINLINE (LOOP)
- * ------------------------------------------------------------------------
+ * ACTIVE CAMERA PRESET LIST CALLBACK
+ * ----------------------------------------------
+ * This callback handler is invoked whenever the
+ * gateway provides the preset list (including
+ * preset names) for the active camera source.
  */
-void loop() {
-  // display connecting status on OLED
-  display.printText("Connecting to Gateway", MONOCLE_GATEWAY_ADDRESS, "", "", true, true);
-
-  // let the user know we are going to attempt a connection to the Monocle Gateway
-  Serial.println("Connecting to Monocle Gateway");
-
-  // attmept to connect to the Monocle Gateway now
-  monocle.begin();
-
-  // let the user know we are connected to the Monocle Gateway
-  if (monocle.connected()) {
-    Serial.println("Successfully connected to Monocle Gateway.");
-    display.printLine3("Gateway Connected", true, true);
-    delay(1000);
-    displayCameraInfo();
+void cameraPresetsHandler(CameraPreset* presets, const int count){
+  menu.clearPresets();
+  for(int index = 0; index < count; index++){
+    menu.addPreset(presets[index].name);
   }
+}
 
-  // continuous loop while we are connected to the Monocle Gateway
-  while (monocle.connected()) {
+/**
+ * CAMERA LIST CHANGED CALLBACK
+ * ----------------------------------------------
+ * This callback handler is invoked whenever the
+ * gateway camera list changes (cameras added,
+ * removed or renamed) and once after connecting.
+ */
+void cameraListHandler(const int count, const int from, const int to){
+  menu.updateCameras(count, from, to);
+}
 
-    // we must call the 'loop' function on the Monocle
-    // client to service communication and raise events
-    monocle.loop();
+/**
+ * CAMERA LIST ROW CALLBACK
+ * ----------------------------------------------
+ * This callback handler is invoked for each
+ * camera list row requested by the menu.
+ */
+void cameraEntryHandler(CameraListEntry& entry){
+  menu.setCamera(entry.index, entry.uuid, entry.name, entry.active);
+}
 
-    // we must call the 'loop' function on the joystick
-    // class to service inputs and raise events
-    joystick.loop();
+/**
+ * TELEMETRY SAMPLE CALLBACK
+ * ----------------------------------------------
+ * This callback handler is invoked before each
+ * telemetry frame is sent to add the values only
+ * the program knows (the Wi-Fi signal strength).
+ */
+void telemetrySampleHandler(){
+  telemetry.set(MONOCLE_TELEMETRY_RSSI, WiFi.RSSI());
+}
 
-    // we must call the 'loop' function on the menu
-    // class to service the display and raise events
-    menu.loop();
+/**
+ * CONFIGURATION CHANGED CALLBACK
+ * ----------------------------------------------
+ * This callback handler is invoked whenever a
+ * configuration field is changed from the serial
+ * monitor or by the gateway.  Joystick and gateway
+ * settings are already applied; the Wi-Fi and
+ * gateway endpoint are used after a restart.
+ */
+void configChangeHandler(const int id){
+  if(id >= 0 && MonocleConfig::fields[id].group == MONOCLE_CONFIG_BOOT){
+    Serial.print("Configuration '");
+    Serial.print(MonocleConfig::fields[id].name);
+    Serial.println("' is applied after a restart.");
   }
+}
 
-  // deactivate the menu (if it's active)
-  menu.deactivate();
-
-  // let the user know that we are now disconnected from the Monocle Gateway
-  Serial.println("Disconnected from Monocle Gateway.");
-  Serial.println("We will attempt to reconnect to the Monocle Gateway in 5 seconds.");
-  display.printText("Gateway Disconnected", "Reconnecting in 5 sec");
-  delay(5000); // wait 5 seconds before attempting to reconnect
-}
\ No newline at end of file
+/**
+ * ------------------------------------------------------------------------
+ * PROGRAM MAINLINE (LOOP)
+ * ------------------------------------------------------------------------
+ */
+void loop() {
+  // the scheduler services the network connection, Monocle client,
+  // joystick and menu tasks as they become due
+  scheduler.loop();
+}
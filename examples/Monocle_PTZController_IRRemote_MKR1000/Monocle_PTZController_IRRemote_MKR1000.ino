@@ -187,6 +187,9 @@
 
 /* MONOCLE IMPLEMENTATION MODULES */
 #include <MonocleGatewayClient.h>
+#include <MonocleIRRemote.h>
+#include <MonocleScheduler.h>
+#include <MonoclePowerManager.h>
 
 /* YOUR PRIVATE INFORMATION */
 #include "private.h"
@@ -227,10 +230,28 @@
 // when a button on this remote is held, this code is continually emitted
 #define REMOTE_REPEAT        0xFFFFFFFF
 
-// define the PAN, TILT, ZOOM speeds to use when pressing the remote buttons
-#define PAN_SPEED   2 // 1=low, 2=medium; 3=high
-#define TILT_SPEED  2 // 1=low, 2=medium; 3=high
-#define ZOOM_SPEED  2 // 1=low, 2=medium; 3=high
+// define the PAN, TILT, ZOOM speed to use when pressing the remote buttons (when not accelerating)
+#define PTZ_SPEED   2 // 1=low, 2=medium; 3=high
+
+// hold-to-accelerate; held buttons start slow and speed up (0 = disabled)
+#define PTZ_ACCELERATE_MED_DELAY   750   // milliseconds until medium speed
+#define PTZ_ACCELERATE_HIGH_DELAY  2000  // milliseconds until high speed
+
+// battery power management; poll the IR receiver less often and let the radio sleep when unused
+#define POWER_IDLE_TIMEOUT          30000   // milliseconds without input until idle
+#define POWER_SLEEP_TIMEOUT         300000  // milliseconds without input until sleep
+#define IR_RECEIVE_INTERVAL_ACTIVE  5       // milliseconds
+#define IR_RECEIVE_INTERVAL_IDLE    20      // milliseconds
+#define IR_RECEIVE_INTERVAL_SLEEP   50      // milliseconds
+
+// network connection check and gateway reconnect intervals
+#define LINK_CHECK_INTERVAL      500   // milliseconds
+#define GATEWAY_RECONNECT_DELAY  5000  // milliseconds
+
+// network connection states
+#define LINK_WIFI_CONNECTING     0
+#define LINK_GATEWAY_CONNECTING  1
+#define LINK_GATEWAY_CONNECTED   2
 
 /**
  * ------------------------------------------------------------------------
@@ -254,8 +275,41 @@ IRrecv irrecv(IR_REMOTE_RECEIVE_DATA_PIN);
 // variable holder for decoded IR signal data
 decode_results results;
 
-// time interval tracking variable
-unsigned long irTimeout = 0;
+// create Monocle IR remote command engine instance
+MonocleIRRemote remote;
+
+// cooperative scheduler; services all components from the main loop
+MonocleScheduler scheduler;
+
+// create Monocle power manager instance (idle detection for battery operation)
+MonoclePowerManager power;
+
+// scheduler task ids and the network connection state
+int gatewayTask;
+int receiveTask;
+int linkTask;
+int linkState = LINK_WIFI_CONNECTING;
+
+// map the IR codes of your remote control buttons to Monocle actions
+const MonocleIRCode REMOTE_CODES[] = {
+  { REMOTE_OK_BUTTON,    MONOCLE_IR_STOP,       0 },
+  { REMOTE_UP_BUTTON,    MONOCLE_IR_TILT_UP,    0 },
+  { REMOTE_DOWN_BUTTON,  MONOCLE_IR_TILT_DOWN,  0 },
+  { REMOTE_LEFT_BUTTON,  MONOCLE_IR_PAN_LEFT,   0 },
+  { REMOTE_RIGHT_BUTTON, MONOCLE_IR_PAN_RIGHT,  0 },
+  { REMOTE_STAR_BUTTON,  MONOCLE_IR_ZOOM_IN,    0 },
+  { REMOTE_HASH_BUTTON,  MONOCLE_IR_ZOOM_OUT,   0 },
+  { REMOTE_0_BUTTON,     MONOCLE_IR_HOME,       0 },
+  { REMOTE_1_BUTTON,     MONOCLE_IR_PRESET,     1 },
+  { REMOTE_2_BUTTON,     MONOCLE_IR_PRESET,     2 },
+  { REMOTE_3_BUTTON,     MONOCLE_IR_PRESET,     3 },
+  { REMOTE_4_BUTTON,     MONOCLE_IR_PRESET,     4 },
+  { REMOTE_5_BUTTON,     MONOCLE_IR_PRESET,     5 },
+  { REMOTE_6_BUTTON,     MONOCLE_IR_PRESET,     6 },
+  { REMOTE_7_BUTTON,     MONOCLE_IR_PRESET,     7 },
+  { REMOTE_8_BUTTON,     MONOCLE_IR_PRESET,     8 },
+  { REMOTE_9_BUTTON,     MONOCLE_IR_PRESET,     9 }
+};
 
 /**
  * ------------------------------------------------------------------------
@@ -283,12 +337,52 @@ void setup() {
   // @see: https://www.arduino.cc/en/Reference/WiFiBegin
   WiFi.begin(ssid, password);
 
-  // wait until the wireless network connection has been established
-  while (WiFi.status() != WL_CONNECTED) {
-    delay(500);
-    Serial.print(".");  // print something the let the user know we are still working
-  }
+  // start the IR receiver
+  // @see: https://github.com/z3t0/Arduino-IRremote
+  irrecv.enableIRIn();
 
+  // configure the IR remote command engine
+  remote.loadCodes(REMOTE_CODES, sizeof(REMOTE_CODES) / sizeof(REMOTE_CODES[0]));
+  remote.setRepeatCode(REMOTE_REPEAT);
+  remote.setSpeed(PTZ_SPEED);
+  remote.setAcceleration(PTZ_ACCELERATE_MED_DELAY, PTZ_ACCELERATE_HIGH_DELAY);
+
+  // register IR remote event handlers
+  remote.onPTZ(&remotePTZChangeHandler);
+  remote.onHome(&remoteHomeHandler);
+  remote.onPreset(&remotePresetHandler);
+
+  // register the component service tasks; the gateway client is suspended
+  // until the gateway connection is established
+  gatewayTask = monocle.schedule(scheduler);
+  receiveTask = scheduler.every(IR_RECEIVE_INTERVAL_ACTIVE, &irReceiveTaskHandler);
+  remote.schedule(scheduler);
+  scheduler.suspend(gatewayTask);
+
+  // the network connection task waits for the wireless network connection
+  // and (re)connects to the Monocle Gateway without blocking the main loop
+  linkTask = scheduler.every(LINK_CHECK_INTERVAL, &linkTaskHandler);
+
+  // enter idle/sleep when the remote is not used; the IR receiver is
+  // polled less often and the radio sleeps, and any IR signal on the
+  // receiver data pin wakes the controller immediately
+  power.setTimeouts(POWER_IDLE_TIMEOUT, POWER_SLEEP_TIMEOUT);
+  power.onRadioSleep(&radioSleepHandler);
+  power.schedule(scheduler);
+  power.manage(receiveTask, IR_RECEIVE_INTERVAL_ACTIVE, IR_RECEIVE_INTERVAL_IDLE, IR_RECEIVE_INTERVAL_SLEEP);
+  power.attachWakePin(IR_REMOTE_RECEIVE_DATA_PIN);
+
+  // sleep the MCU between tasks
+  scheduler.onIdle(&idleHandler);
+}
+
+/**
+ * WIRELESS NETWORK CONNECTED
+ * ----------------------------------------------
+ * This method is called once the wireless
+ * network connection has been established.
+ */
+void wifiConnected(){
   // let the user know we have successfully connected to the network
   IPAddress myIP = WiFi.localIP();
   String ip_address = String(myIP[0])+"."+String(myIP[1])+"."+String(myIP[2])+"."+String(myIP[3]);
@@ -298,167 +392,190 @@ void setup() {
   Serial.print(" - IP Address : ");
   Serial.println(ip_address);
   Serial.println("================================================");
-
-  // start the IR receiver
-  // @see: https://github.com/z3t0/Arduino-IRremote
-  irrecv.enableIRIn();
 }
 
-
 /**
- * ------------------------------------------------------------------------
- * PROGRAM MAINLINE (LOOP)
- * ------------------------------------------------------------------------
+ * CONNECT TO THE MONOCLE GATEWAY
+ * ----------------------------------------------
+ * This method attempts a connection to the
+ * Monocle Gateway and starts servicing the
+ * gateway client on success.
  */
-void loop() {
+void gatewayConnect(){
   // let the user know we are going to attempt a connection to the Monocle Gateway
   Serial.println("Connecting to Monocle Gateway");
 
   // attmept to connect to the Monocle Gateway now
   monocle.begin();
-
-  // let the user know we are connected to the Monocle Gateway
-  if (monocle.connected()) {
-    Serial.println("Successfully connected to Monocle Gateway.");
+  if (!monocle.connected()) {
+    gatewayDisconnected();
+    return;
   }
 
-  // continuous loop while we are connected to the Monocle Gateway
-  while (monocle.connected()) {
-
-    // we must call the 'loop' function on the Monocle
-    // client to service communication and raise events
-    monocle.loop();
-
-    // if the IR timeout is active, then check to see if 200 milliseconds
-    // have passed without any IR repeat signals before sending the
-    // PTZ stop command.
-    if(irTimeout > 0){
-      if((millis() - irTimeout) > 200){
-          irTimeout = 0; // reset timeout
-          Serial.println("--> STOP");
-          monocle.stop();
-      }
-    }
-
-    // listen for decoded IR input codes
-    if (irrecv.decode(&results)) {
-
-      // process the received IR code and try and match it to one of the known button codes
-      switch(results.value){
-
-        // if we receive the IR repeat signal, then continually reset the IR timeout timer
-        case REMOTE_REPEAT : {
-          if(irTimeout > 0) irTimeout = millis();
-          break;
-        }
-
-        // handle the functions for the specific IR remote control buttons
-        case REMOTE_OK_BUTTON: {
-          Serial.println("--> STOP");
-          monocle.stop();
-          break;
-        }
-        case REMOTE_LEFT_BUTTON: {
-          irTimeout = millis(); // reset IR timeout
-          Serial.println("--> PAN LEFT");
-          monocle.pan(-PAN_SPEED); // negative speed value means pan left
-          break;
-        }
-        case REMOTE_RIGHT_BUTTON: {
-          irTimeout = millis(); // reset IR timeout
-          Serial.println("--> PAN RIGHT");
-          monocle.pan(PAN_SPEED); // positive speed value means pan right
-          break;
-        }
-        case REMOTE_UP_BUTTON: {
-          irTimeout = millis(); // reset IR timeout
-          Serial.println("--> TILT UP");
-          monocle.tilt(TILT_SPEED); // positive speed value means tilt up
-          break;
-        }
-        case REMOTE_DOWN_BUTTON: {
-          irTimeout = millis(); // reset IR timeout
-          Serial.println("--> TILT DOWN");
-          monocle.tilt(-TILT_SPEED); // negative speed value means tilt down
-          break;
-        }
-        case REMOTE_STAR_BUTTON: {
-          irTimeout = millis(); // reset IR timeout
-          Serial.println("--> ZOOM IN");
-          monocle.zoom(ZOOM_SPEED); // positive speed value means zoom in
-          break;
-        }
-        case REMOTE_HASH_BUTTON: {
-          irTimeout = millis(); // reset IR timeout
-          Serial.println("--> ZOOM OUT");
-          monocle.zoom(-ZOOM_SPEED); // negative speed value means zoom out
-          break;
-        }
-        case REMOTE_0_BUTTON: {
-          Serial.println("--> HOME");
-          monocle.home();
-          break;
-        }
-        case REMOTE_1_BUTTON: {
-          Serial.println("--> PRESET #1");
-          monocle.preset(1);
-          break;
-        }
-        case REMOTE_2_BUTTON: {
-          Serial.println("--> PRESET #2");
-          monocle.preset(2);
-          break;
-        }
-        case REMOTE_3_BUTTON: {
-          Serial.println("--> PRESET #3");
-          monocle.preset(3);
-          break;
-        }
-        case REMOTE_4_BUTTON: {
-          Serial.println("--> PRESET #4");
-          monocle.preset(4);
-          break;
-        }
-        case REMOTE_5_BUTTON: {
-          Serial.println("--> PRESET #5");
-          monocle.preset(5);
-          break;
-        }
-        case REMOTE_6_BUTTON: {
-          Serial.println("--> PRESET #6");
-          monocle.preset(6);
-          break;
-        }
-        case REMOTE_7_BUTTON: {
-          Serial.println("--> PRESET #7");
-          monocle.preset(7);
-          break;
-        }
-        case REMOTE_8_BUTTON: {
-          Serial.println("--> PRESET #8");
-          monocle.preset(8);
-          break;
-        }
-        case REMOTE_9_BUTTON: {
-          Serial.println("--> PRESET #9");
-          monocle.preset(9);
-          break;
-        }
-      }
+  // let the user know we are connected to the Monocle Gateway
+  Serial.println("Successfully connected to Monocle Gateway.");
+  linkState = LINK_GATEWAY_CONNECTED;
 
-      // display the IR code to the user
-      // DEBUG - enable this if you need to see the raw decoded IR button values
-      //Serial.print("<< IR BUTTON RX: ");
-      //Serial.print(results.value, HEX);
-      //Serial.println(" >>");
+  // start servicing the Monocle client
+  scheduler.resume(gatewayTask);
+}
 
-      // resume processing IR input
-      irrecv.resume();
-    }
-  }
+/**
+ * MONOCLE GATEWAY DISCONNECTED
+ * ----------------------------------------------
+ * This method is called when the gateway connection
+ * fails or is lost; a reconnect is scheduled.
+ */
+void gatewayDisconnected(){
+  // stop servicing the Monocle client
+  scheduler.suspend(gatewayTask);
 
   // let the user know that we are now disconnected from the Monocle Gateway
   Serial.println("Disconnected from Monocle Gateway.");
   Serial.println("We will attempt to reconnect to the Monocle Gateway in 5 seconds.");
-  delay(5000); // wait 5 seconds before attempting to reconnect
+
+  // wait 5 seconds before attempting to reconnect
+  linkState = LINK_GATEWAY_CONNECTING;
+  scheduler.reschedule(linkTask, GATEWAY_RECONNECT_DELAY);
+}
+
+/**
+ * NETWORK CONNECTION TASK
+ * ----------------------------------------------
+ * This scheduler task is called periodically to
+ * advance the network connection state machine.
+ */
+void linkTaskHandler(void* context){
+  switch(linkState){
+    case LINK_WIFI_CONNECTING:
+      // wait until the wireless network connection has been established
+      if(WiFi.status() != WL_CONNECTED){
+        Serial.print(".");  // print something the let the user know we are still working
+        return;
+      }
+      wifiConnected();
+      linkState = LINK_GATEWAY_CONNECTING;
+      break;
+    case LINK_GATEWAY_CONNECTING:
+      gatewayConnect();
+      break;
+    case LINK_GATEWAY_CONNECTED:
+      if(!monocle.connected()) gatewayDisconnected();
+      break;
+  }
+}
+
+/**
+ * IR RECEIVE TASK
+ * ----------------------------------------------
+ * This scheduler task is called periodically to
+ * pass decoded IR input codes to the IR remote
+ * command engine.
+ */
+void irReceiveTaskHandler(void* context){
+  // listen for decoded IR input codes and process them
+  if (irrecv.decode(&results)) {
+    remote.process(results.value);
+
+    // display the IR code to the user
+    // DEBUG - enable this if you need to see the raw decoded IR button values
+    //Serial.print("<< IR BUTTON RX: ");
+    //Serial.print(results.value, HEX);
+    //Serial.println(" >>");
+
+    // resume processing IR input
+    irrecv.resume();
+  }
+}
+
+/**
+ * SCHEDULER IDLE CALLBACK
+ * ----------------------------------------------
+ * This callback handler is called when no task
+ * is due; the MCU sleeps until the next interrupt
+ * (the millisecond system tick wakes it at the latest).
+ */
+void idleHandler(unsigned long milliseconds){
+  __WFI();
+}
+
+/**
+ * RADIO SLEEP CALLBACK
+ * ----------------------------------------------
+ * This callback handler is called to place the
+ * WiFi radio in or out of modem-sleep (the radio
+ * still wakes for each access point beacon).
+ */
+void radioSleepHandler(const bool sleep){
+  if(sleep) WiFi.lowPowerMode();
+  else WiFi.noLowPowerMode();
+}
+
+
+/**
+ * ------------------------------------------------------------------------
+ * IR REMOTE PTZ CHANGE EVENT HANDLER
+ * ------------------------------------------------------------------------
+ */
+void remotePTZChangeHandler(int pan, int tilt, int zoom){
+  // a held button keeps the controller awake
+  power.activity(pan, tilt, zoom);
+
+  if(pan == 0 && tilt == 0 && zoom == 0){
+    Serial.println("--> STOP");
+    monocle.stop();
+    return;
+  }
+
+  // print the current PTZ action
+  if(pan > 0) Serial.print("--> PAN RIGHT");
+  if(pan < 0) Serial.print("--> PAN LEFT");
+  if(tilt > 0) Serial.print("--> TILT UP");
+  if(tilt < 0) Serial.print("--> TILT DOWN");
+  if(zoom > 0) Serial.print("--> ZOOM IN");
+  if(zoom < 0) Serial.print("--> ZOOM OUT");
+  Serial.print(" (SPEED ");
+  Serial.print(abs(pan + tilt + zoom));
+  Serial.println(")");
+
+  // send PTZ to Monocle gateway
+  monocle.ptz(pan, tilt, zoom);
+}
+
+/**
+ * ------------------------------------------------------------------------
+ * IR REMOTE HOME EVENT HANDLER
+ * ------------------------------------------------------------------------
+ */
+void remoteHomeHandler(){
+  // remote button presses keep the controller awake
+  power.activity();
+
+  Serial.println("--> HOME");
+  monocle.home();
+}
+
+/**
+ * ------------------------------------------------------------------------
+ * IR REMOTE PRESET EVENT HANDLER
+ * ------------------------------------------------------------------------
+ */
+void remotePresetHandler(const int preset){
+  // remote button presses keep the controller awake
+  power.activity();
+
+  Serial.print("--> PRESET #");
+  Serial.println(preset);
+  monocle.preset(preset);
+}
+
+/**
+ * ------------------------------------------------------------------------
+ * PROGRAM MAINLINE (LOOP)
+ * ------------------------------------------------------------------------
+ */
+void loop() {
+  // the scheduler services the network connection, Monocle client,
+  // IR receiver, IR remote and power manager tasks as they become due
+  scheduler.loop();
 }
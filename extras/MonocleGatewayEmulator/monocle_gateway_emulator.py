@@ -0,0 +1,735 @@
+#!/usr/bin/env python3
+#
+# **********************************************************************
+#             __  __  ___  _  _  ___   ___ _    ___
+#            |  \/  |/ _ \| \| |/ _ \ / __| |  | __|
+#            | |\/| | (_) | .` | (_) | (__| |__| _|
+#            |_|  |_|\___/|_|\_|\___/ \___|____|___|
+#
+# -------------------------------------------------------------------
+#                   MONOCLE GATEWAY EMULATOR (HOST)
+# -------------------------------------------------------------------
+#
+#  A local stand-in for the Monocle Gateway service used for
+#  integration and load testing of 'MonocleGatewayClient' without a
+#  real gateway or a MonocleCam account.  It speaks the same
+#  web-socket text protocol (PTZ:, PAN:, TILT:, ZOOM:, PRESET:#,
+#  HOME, STOP and '@<uuid>:' camera session commands), pushes the
+#  JSON 'source' message for the active camera, answers heartbeat
+#  pings and 'MonocleDiscovery' probes, and logs every command it
+#  receives.  Camera positions are simulated from the PTZ speeds and
+#  pushed as 'status' messages to controllers that send
+#  'SUBSCRIBE:STATUS:<ms>'.  Controllers that send 'SUBSCRIBE:CAMERAS'
+#  are told about camera list changes (count and changed rows), read
+#  the list in pages with 'CAMERAS:<offset>:<count>' and switch the
+#  active camera with 'CAMERA:<uuid>'.
+#
+#  Latency, jitter, command loss, disconnects and stalls can be
+#  injected from the command line, from a scenario file (camera list
+#  and timeline) or interactively from the console.
+#
+#  Standard library only (Python 3.7 or later).
+#
+#  Author:   Robert Savage
+#  Date:     2018-02-18
+#  Website:  http://monoclecam.com
+#
+# -------------------------------------------------------------------
+#        COPYRIGHT SHADEBLUE, LLC @ 2018, ALL RIGHTS RESERVED
+# -------------------------------------------------------------------
+#
+# **********************************************************************
+#
+import argparse
+import asyncio
+import json
+import random
+import re
+import sys
+import time
+
+import monocle_ws as ws
+
+DISCOVERY_PORT = 8089                # MONOCLE_DISCOVERY_PORT
+DISCOVERY_PROBE = b"MONOCLE-DISCOVER"
+DISCOVERY_RESPONSE = "MONOCLE-GATEWAY %d"
+
+DEFAULT_CAMERAS = [
+    {"uuid": "emulator-camera-1", "name": "Front Door", "manufacturer": "Emulator",
+     "model": "PTZ-1", "ptz": True, "presets": ["Driveway", "Porch", "Street"]},
+    {"uuid": "emulator-camera-2", "name": "Back Yard", "manufacturer": "Emulator",
+     "model": "PTZ-2", "ptz": True, "presets": ["Patio", "Garden"]},
+    {"uuid": "emulator-camera-3", "name": "Garage", "manufacturer": "Emulator",
+     "model": "FIXED-1", "ptz": False, "presets": []},
+]
+
+SPEED = r"(-?[0-3])"
+COMMANDS = [
+    ("PTZ",    re.compile(r"^PTZ:%s:%s:%s$" % (SPEED, SPEED, SPEED))),
+    ("PAN",    re.compile(r"^PAN:%s$" % SPEED)),
+    ("TILT",   re.compile(r"^TILT:%s$" % SPEED)),
+    ("ZOOM",   re.compile(r"^ZOOM:%s$" % SPEED)),
+    ("PRESET", re.compile(r"^PRESET:(#\d+|[^#].*)$")),
+    ("HOME",   re.compile(r"^HOME$")),
+    ("STOP",   re.compile(r"^STOP$")),
+    ("SUBSCRIBE",   re.compile(r"^SUBSCRIBE:STATUS:(\d+)$")),
+    ("UNSUBSCRIBE", re.compile(r"^UNSUBSCRIBE:STATUS$")),
+    ("SUBSCRIBE_CAMERAS",   re.compile(r"^SUBSCRIBE:CAMERAS$")),
+    ("UNSUBSCRIBE_CAMERAS", re.compile(r"^UNSUBSCRIBE:CAMERAS$")),
+    ("CAMERAS", re.compile(r"^CAMERAS:(\d+):(\d+)$")),
+    ("CAMERA",  re.compile(r"^CAMERA:(.+)$")),
+    ("CONFIG",  re.compile(r"^CONFIG:(OK|ERROR:.+)$")),
+    ("TELEMETRY", re.compile(r"^TELEMETRY:(seq=.+)$")),
+]
+CAMERA_LIST_COMMANDS = ("SUBSCRIBE_CAMERAS", "UNSUBSCRIBE_CAMERAS", "CAMERAS", "CAMERA")
+
+# simulated camera motion per speed level (degrees or zoom factor per second)
+PAN_TILT_RATES = {0: 0.0, 1: 5.0, 2: 15.0, 3: 45.0}
+ZOOM_RATES = {0: 0.0, 1: 0.25, 2: 0.5, 3: 1.0}
+PAN_LIMIT = 180.0
+TILT_LIMIT = 90.0
+ZOOM_LIMITS = (1.0, 20.0)
+MIN_STATUS_INTERVAL = 50             # milliseconds
+CAMERA_PAGE = 16                     # MONOCLE_GATEWAY_CAMERA_PAGE
+
+# 'MonocleTelemetry' frame fields: gauges, counters (since boot) and
+# log2 histograms ('/' separated buckets; bucket i holds values below 2^i)
+TELEMETRY_GAUGES = ("up", "heap", "rssi")
+TELEMETRY_COUNTERS = ("conn", "disc", "cmd", "msg", "ovr", "skip", "defer")
+TELEMETRY_HISTOGRAMS = (("task", "us"), ("late", "ms"), ("send", "us"), ("rtt", "ms"))
+
+
+def parse_command(text):
+    """PARSE A COMMAND; RETURNS (CAMERA UUID OR None, COMMAND, ARGUMENTS)
+    OR RAISES ValueError FOR A MALFORMED COMMAND"""
+    uuid = None
+    if text.startswith("@"):
+        uuid, sep, text = text[1:].partition(":")
+        if not sep or not uuid:
+            raise ValueError("malformed camera prefix")
+    for name, pattern in COMMANDS:
+        match = pattern.match(text)
+        if match:
+            # numeric arguments (including '#<index>' presets) are converted to integers
+            args = [int(g.lstrip("#")) if re.match(r"^#?-?\d+$", g) else g for g in match.groups()]
+            return uuid, name, args
+    raise ValueError("unknown command")
+
+
+def parse_telemetry(text):
+    """PARSE A TELEMETRY FRAME BODY ('seq=N,key=value,...,task=b0/b1/...')
+    INTO A DICTIONARY (HISTOGRAMS BECOME LISTS OF BUCKET COUNTS)"""
+    fields = {}
+    for item in text.split(","):
+        key, sep, value = item.partition("=")
+        if not sep:
+            raise ValueError("malformed telemetry field")
+        fields[key] = [int(count) for count in value.split("/")] if "/" in value or \
+            key in dict(TELEMETRY_HISTOGRAMS) else int(value)
+    return fields
+
+
+def bucket_percentile(buckets, p):
+    """UPPER BOUND OF THE LOG2 BUCKET HOLDING THE P'TH PERCENTILE (None WHEN EMPTY)"""
+    total = sum(buckets)
+    if not total:
+        return None
+    seen = 0
+    for index, count in enumerate(buckets):
+        seen += count
+        if seen >= total * p:
+            return (1 << index) - 1
+    return (1 << (len(buckets) - 1)) - 1
+
+
+def rate(table, speed):
+    return table[abs(speed)] * (1 if speed >= 0 else -1)
+
+
+class CameraMotion:
+    """SIMULATED POSITION OF ONE CAMERA (INTEGRATES THE COMMANDED SPEEDS)"""
+
+    def __init__(self, ptz=True):
+        self.ptz = ptz
+        self.pan = 0.0
+        self.tilt = 0.0
+        self.zoom = ZOOM_LIMITS[0]
+        self.speeds = [0, 0, 0]
+        self.updated = time.monotonic()
+
+    def advance(self):
+        now = time.monotonic()
+        elapsed = now - self.updated
+        self.updated = now
+        pan, tilt, zoom = self.speeds
+        self.pan = max(-PAN_LIMIT, min(PAN_LIMIT, self.pan + rate(PAN_TILT_RATES, pan) * elapsed))
+        self.tilt = max(-TILT_LIMIT, min(TILT_LIMIT, self.tilt + rate(PAN_TILT_RATES, tilt) * elapsed))
+        self.zoom = max(ZOOM_LIMITS[0], min(ZOOM_LIMITS[1], self.zoom + rate(ZOOM_RATES, zoom) * elapsed))
+
+    def apply(self, command, args):
+        if not self.ptz:
+            return
+        self.advance()
+        if command == "PTZ":
+            self.speeds = list(args)
+        elif command in ("PAN", "TILT", "ZOOM"):
+            self.speeds[("PAN", "TILT", "ZOOM").index(command)] = args[0]
+        elif command == "STOP":
+            self.speeds = [0, 0, 0]
+        elif command == "HOME":
+            self.speeds = [0, 0, 0]
+            self.pan, self.tilt, self.zoom = 0.0, 0.0, ZOOM_LIMITS[0]
+        elif command == "PRESET" and isinstance(args[0], int):
+            # each preset index recalls a fixed position
+            self.speeds = [0, 0, 0]
+            self.pan, self.tilt, self.zoom = 30.0 * args[0], -10.0, ZOOM_LIMITS[0] + args[0]
+
+    def status_message(self):
+        self.advance()
+        return json.dumps({"status": {"pan": round(self.pan, 2), "tilt": round(self.tilt, 2),
+                                      "zoom": round(self.zoom, 2), "moving": any(self.speeds)}},
+                          separators=(",", ":"))
+
+
+class Emulator:
+    """GATEWAY STATE SHARED BY ALL CONNECTIONS"""
+
+    def __init__(self, options, scenario):
+        self.options = options
+        self.cameras = list(scenario.get("cameras") or DEFAULT_CAMERAS)
+        for number in range(len(self.cameras) + 1, len(self.cameras) + 1 + options.cameras):
+            self.cameras.append({"uuid": "emulator-camera-%d" % number, "name": "Camera %d" % number,
+                                 "manufacturer": "Emulator", "model": "PTZ-1", "ptz": True, "presets": []})
+        self.added = len(self.cameras)
+        self.timeline = sorted(scenario.get("script", []), key=lambda step: step["at"])
+        self.repeat = scenario.get("loop", False)
+        self.active = 0
+        self.motion = dict((camera["uuid"], CameraMotion(camera.get("ptz", True))) for camera in self.cameras)
+        self.latency = options.latency
+        self.jitter = options.jitter
+        self.loss = options.loss
+        self.stalled_until = 0.0
+        self.connections = set()
+        self.next_id = 1
+        self.started = time.monotonic()
+        self.log_file = open(options.log, "a", buffering=1) if options.log else None   # line buffered
+        self.reset_stats()
+        self.totals = {"commands": 0, "lost": 0, "invalid": 0, "connections": 0, "disconnects": 0}
+        self.telemetry = {}
+        self.histograms = {}
+
+    # --- camera source -------------------------------------------------
+
+    def source_message(self):
+        camera = dict(self.cameras[self.active])
+        camera.setdefault("ptz", True)
+        camera.setdefault("presets", [])
+        return json.dumps({"source": camera})
+
+    def camera_uuids(self):
+        return set(camera["uuid"] for camera in self.cameras)
+
+    def active_motion(self):
+        return self.motion[self.cameras[self.active]["uuid"]]
+
+    async def select_camera(self, index):
+        previous = self.active
+        self.active = index % len(self.cameras)
+        self.note("active camera: %s" % self.cameras[self.active].get("name"))
+        message = self.source_message()
+        for connection in list(self.connections):
+            await connection.send_text(message)
+        # the 'active' flag of both rows changed
+        await self.camera_list_changed(previous, previous)
+        await self.camera_list_changed(self.active, self.active)
+
+    # --- camera list ---------------------------------------------------
+
+    def camera_entry_message(self, index):
+        camera = self.cameras[index]
+        return json.dumps({"camera": {"index": index, "uuid": camera["uuid"], "name": camera.get("name", ""),
+                                      "active": index == self.active}})
+
+    async def camera_list_changed(self, first, last):
+        """TELL SUBSCRIBED CONTROLLERS WHICH ROWS CHANGED (THEY REQUEST THE ROWS THEY SHOW)"""
+        message = json.dumps({"cameras": {"count": len(self.cameras), "from": first, "to": last}})
+        for connection in list(self.connections):
+            if connection.cameras_subscribed:
+                await connection.send_text(message)
+
+    async def add_camera(self, name):
+        self.added += 1
+        camera = {"uuid": "emulator-camera-%d" % self.added, "name": name,
+                  "manufacturer": "Emulator", "model": "PTZ-1", "ptz": True, "presets": []}
+        self.cameras.append(camera)
+        self.motion[camera["uuid"]] = CameraMotion()
+        self.note("added camera %d: %s" % (len(self.cameras) - 1, name))
+        await self.camera_list_changed(len(self.cameras) - 1, len(self.cameras) - 1)
+
+    async def remove_camera(self, index):
+        if len(self.cameras) < 2 or not 0 <= index < len(self.cameras):
+            raise ValueError("invalid camera")
+        camera = self.cameras.pop(index)
+        self.note("removed camera %d: %s" % (index, camera.get("name")))
+        # every following row moves up by one
+        await self.camera_list_changed(index, len(self.cameras) - 1)
+        if index < self.active:
+            self.active -= 1
+        elif index == self.active:
+            await self.select_camera(min(index, len(self.cameras) - 1))
+
+    async def rename_camera(self, index, name):
+        if not 0 <= index < len(self.cameras):
+            raise ValueError("invalid camera")
+        self.cameras[index]["name"] = name
+        self.note("renamed camera %d: %s" % (index, name))
+        await self.camera_list_changed(index, index)
+        if index == self.active:
+            message = self.source_message()
+            for connection in list(self.connections):
+                await connection.send_text(message)
+
+    async def configure(self, fields):
+        """SEND A RUNTIME CONFIGURATION UPDATE TO EVERY CONTROLLER ('MonocleConfig')"""
+        message = json.dumps({"config": fields})
+        self.note("configuring %s" % message)
+        for connection in list(self.connections):
+            await connection.send_text(message)
+
+    # --- fault injection -----------------------------------------------
+
+    def delay(self):
+        """DELAY (SECONDS) APPLIED TO EACH RECEIVED FRAME"""
+        jitter = random.uniform(-self.jitter, self.jitter) if self.jitter else 0
+        return max(0.0, self.latency + jitter) / 1000.0
+
+    def lose(self):
+        return self.loss > 0 and random.uniform(0, 100) < self.loss
+
+    def disconnect_all(self):
+        for connection in list(self.connections):
+            connection.close()
+
+    # --- telemetry -----------------------------------------------------
+
+    def collect_telemetry(self, connection, text):
+        """KEEP THE LATEST FRAME OF EACH CONTROLLER AND ADD ITS HISTOGRAMS
+        (RESET BY THE CONTROLLER AFTER EACH FRAME) TO THE FLEET TOTALS"""
+        fields = parse_telemetry(text)
+        entry = self.telemetry.setdefault(connection.name, {"frames": 0})
+        entry.update(fields=fields, time=time.monotonic())
+        entry["frames"] += 1
+        for key, _ in TELEMETRY_HISTOGRAMS:
+            buckets = fields.get(key)
+            if isinstance(buckets, list):
+                totals = self.histograms.setdefault(key, [])
+                totals.extend([0] * (len(buckets) - len(totals)))
+                for index, count in enumerate(buckets):
+                    totals[index] += count
+        if self.log_file:
+            self.log_file.write(json.dumps({
+                "time": round(time.monotonic() - self.started, 4), "client": connection.name,
+                "telemetry": fields}) + "\n")
+
+    def telemetry_report(self):
+        """ONE LINE PER CONTROLLER (LATEST FRAME) AND THE FLEET HISTOGRAM PERCENTILES"""
+        now = time.monotonic()
+        for name, entry in sorted(self.telemetry.items()):
+            fields = entry["fields"]
+            values = " ".join("%s=%s" % (key, fields[key]) for key in TELEMETRY_GAUGES + TELEMETRY_COUNTERS
+                              if key in fields)
+            print("[telemetry] %-22s frames=%d age=%.0fs %s"
+                  % (name, entry["frames"], now - entry["time"], values), flush=True)
+        for key, unit in TELEMETRY_HISTOGRAMS:
+            buckets = self.histograms.get(key)
+            if buckets and sum(buckets):
+                print("[telemetry] fleet %-4s samples=%d p50<=%d%s p95<=%d%s max<=%d%s"
+                      % (key, sum(buckets), bucket_percentile(buckets, 0.5), unit,
+                         bucket_percentile(buckets, 0.95), unit, bucket_percentile(buckets, 1.0), unit),
+                      flush=True)
+
+    # --- logging and statistics ----------------------------------------
+
+    def reset_stats(self):
+        self.stats = {"commands": 0, "lost": 0, "invalid": 0, "types": {}, "lags": []}
+        self.stats_time = time.monotonic()
+
+    def note(self, text):
+        if not self.options.quiet:
+            print("%9.3f  --  %s" % (time.monotonic() - self.started, text), flush=True)
+
+    def log(self, connection, raw, status, uuid=None, command=None, args=None, lag=0.0):
+        now = time.monotonic()
+        self.stats["commands" if status == "ok" else status] += 1
+        self.totals["commands" if status == "ok" else status] += 1
+        if status == "ok":
+            self.stats["types"][command] = self.stats["types"].get(command, 0) + 1
+            self.stats["lags"].append(lag)
+        if not self.options.quiet:
+            print("%9.3f  %-22s %-7s %s" % (now - self.started, connection.name, status.upper(), raw), flush=True)
+        if self.log_file:
+            self.log_file.write(json.dumps({
+                "time": round(now - self.started, 4), "client": connection.name, "raw": raw,
+                "status": status, "camera": uuid, "command": command, "args": args,
+                "latency_ms": round(lag * 1000, 2)}) + "\n")
+
+    def report(self):
+        elapsed = max(time.monotonic() - self.stats_time, 1e-6)
+        lags = sorted(self.stats["lags"])
+
+        def percentile(p):
+            return lags[min(len(lags) - 1, int(len(lags) * p))] * 1000 if lags else 0.0
+
+        types = " ".join("%s=%d" % item for item in sorted(self.stats["types"].items()))
+        print("[stats] clients=%d commands=%d (%.1f/s) lost=%d invalid=%d queue p50=%.1fms p99=%.1fms %s"
+              % (len(self.connections), self.stats["commands"], self.stats["commands"] / elapsed,
+                 self.stats["lost"], self.stats["invalid"], percentile(0.5), percentile(0.99), types),
+              flush=True)
+        self.telemetry_report()
+        self.reset_stats()
+
+
+class Connection:
+    """ONE CONNECTED CONTROLLER"""
+
+    def __init__(self, emulator, reader, writer):
+        self.emulator = emulator
+        self.reader = reader
+        self.writer = writer
+        self.id = emulator.next_id
+        emulator.next_id += 1
+        peer = writer.get_extra_info("peername") or ("?", 0)
+        self.name = "%s:%d#%d" % (peer[0], peer[1], self.id)
+        self.inbox = asyncio.Queue()
+        self.closed = False
+        self.status_task = None
+        self.cameras_subscribed = False
+
+    async def send_text(self, text):
+        await self.send(ws.OP_TEXT, text)
+
+    async def send(self, opcode, payload=b""):
+        if self.closed:
+            return
+        try:
+            self.writer.write(ws.encode_frame(opcode, payload))
+            await self.writer.drain()
+        except ConnectionError:
+            self.close()
+
+    def close(self):
+        if not self.closed:
+            self.closed = True
+            self.writer.close()
+
+    async def receive(self):
+        """READ FRAMES AS THEY ARRIVE; PROCESSING IS DELAYED BY THE INJECTED LATENCY"""
+        try:
+            while not self.closed:
+                opcode, payload = await ws.read_frame(self.reader)
+                self.inbox.put_nowait((time.monotonic(), time.monotonic() + self.emulator.delay(), opcode, payload))
+                if opcode == ws.OP_CLOSE:
+                    break
+        except ws.ConnectionClosed:
+            pass
+        self.inbox.put_nowait(None)
+
+    async def process(self):
+        """PROCESS RECEIVED FRAMES IN ORDER (A STALLED GATEWAY HOLDS THEM)"""
+        emulator = self.emulator
+        while True:
+            item = await self.inbox.get()
+            if item is None:
+                break
+            arrived, due, opcode, payload = item
+            while True:
+                wait = max(due - time.monotonic(), emulator.stalled_until - time.monotonic())
+                if wait <= 0:
+                    break
+                await asyncio.sleep(wait)
+            if self.closed:
+                break
+
+            if opcode == ws.OP_CLOSE:
+                await self.send(ws.OP_CLOSE, payload[:2])
+                break
+            if opcode == ws.OP_PING:
+                if not emulator.lose():
+                    await self.send(ws.OP_PONG, payload)
+                continue
+            if opcode != ws.OP_TEXT:
+                continue
+
+            raw = payload.decode("utf-8", "replace")
+            lag = time.monotonic() - arrived
+            if emulator.lose():
+                emulator.log(self, raw, "lost", lag=lag)
+                continue
+            try:
+                uuid, command, args = parse_command(raw)
+            except ValueError:
+                emulator.log(self, raw, "invalid", lag=lag)
+                continue
+            if uuid is not None and uuid not in emulator.camera_uuids():
+                emulator.log(self, raw, "invalid", uuid, command, args, lag)
+                continue
+            emulator.log(self, raw, "ok", uuid, command, args, lag)
+
+            if command == "SUBSCRIBE":
+                self.subscribe(args[0])
+            elif command == "UNSUBSCRIBE":
+                self.subscribe(0)
+            elif command in CAMERA_LIST_COMMANDS:
+                await self.camera_list(command, args)
+            elif command == "CONFIG":
+                emulator.note("configuration %s" % args[0].lower())
+            elif command == "TELEMETRY":
+                try:
+                    emulator.collect_telemetry(self, args[0])
+                except ValueError:
+                    emulator.note("malformed telemetry from %s" % self.name)
+            else:
+                emulator.motion[uuid or emulator.cameras[emulator.active]["uuid"]].apply(command, args)
+
+    async def camera_list(self, command, args):
+        emulator = self.emulator
+        if command == "SUBSCRIBE_CAMERAS":
+            # the whole list is new to the controller
+            self.cameras_subscribed = True
+            await self.send_text(json.dumps({"cameras": {"count": len(emulator.cameras),
+                                                         "from": 0, "to": len(emulator.cameras) - 1}}))
+        elif command == "UNSUBSCRIBE_CAMERAS":
+            self.cameras_subscribed = False
+        elif command == "CAMERAS":
+            offset, count = args
+            for index in range(offset, min(offset + min(count, CAMERA_PAGE), len(emulator.cameras))):
+                await self.send_text(emulator.camera_entry_message(index))
+        elif command == "CAMERA":
+            uuids = [camera["uuid"] for camera in emulator.cameras]
+            if str(args[0]) in uuids:
+                await emulator.select_camera(uuids.index(str(args[0])))
+
+    def subscribe(self, interval):
+        """START (OR STOP FOR 0) THE PERIODIC STATUS PUSH TO THIS CONTROLLER"""
+        if self.status_task is not None:
+            self.status_task.cancel()
+            self.status_task = None
+        if interval > 0:
+            self.status_task = asyncio.ensure_future(self.push_status(max(interval, MIN_STATUS_INTERVAL) / 1000.0))
+
+    async def push_status(self, interval):
+        """PUSH THE ACTIVE CAMERA STATUS (A STALLED GATEWAY PUSHES NOTHING)"""
+        while not self.closed:
+            if time.monotonic() >= self.emulator.stalled_until:
+                await self.send_text(self.emulator.active_motion().status_message())
+            await asyncio.sleep(interval)
+
+    async def run(self):
+        emulator = self.emulator
+        try:
+            await ws.server_handshake(self.reader, self.writer)
+        except ws.ConnectionClosed:
+            self.close()
+            return
+        emulator.connections.add(self)
+        emulator.totals["connections"] += 1
+        emulator.note("connected %s" % self.name)
+
+        # the gateway pushes the active camera source to each new controller
+        await self.send_text(emulator.source_message())
+
+        tasks = [asyncio.ensure_future(self.receive()), asyncio.ensure_future(self.process())]
+        if emulator.options.disconnect_every > 0:
+            tasks.append(asyncio.ensure_future(self.drop_after(emulator.options.disconnect_every)))
+        await tasks[1]
+        self.subscribe(0)
+        for task in tasks:
+            task.cancel()
+        self.close()
+        emulator.connections.discard(self)
+        emulator.totals["disconnects"] += 1
+        emulator.note("disconnected %s" % self.name)
+
+    async def drop_after(self, seconds):
+        await asyncio.sleep(random.uniform(0.5, 1.5) * seconds)
+        self.emulator.note("injected disconnect %s" % self.name)
+        self.close()
+        self.inbox.put_nowait(None)
+
+
+class DiscoveryResponder(asyncio.DatagramProtocol):
+    """ANSWERS 'MonocleDiscovery' PROBES WITH THE WEB-SOCKET PORT"""
+
+    def __init__(self, port):
+        self.port = port
+        self.transport = None
+
+    def connection_made(self, transport):
+        self.transport = transport
+
+    def datagram_received(self, data, address):
+        if data.strip() == DISCOVERY_PROBE:
+            self.transport.sendto((DISCOVERY_RESPONSE % self.port).encode("ascii"), address)
+
+
+async def run_timeline(emulator):
+    """APPLY THE SCENARIO TIMELINE ('at' IS SECONDS FROM START)"""
+    if not emulator.timeline:
+        return
+    length = emulator.timeline[-1]["at"]
+    while True:
+        start = time.monotonic()
+        for step in emulator.timeline:
+            await asyncio.sleep(max(0.0, start + step["at"] - time.monotonic()))
+            await apply_step(emulator, step)
+        if not emulator.repeat:
+            return
+        await asyncio.sleep(max(0.0, start + length + 1 - time.monotonic()))
+
+
+async def apply_step(emulator, step):
+    if "camera" in step:
+        await emulator.select_camera(step["camera"])
+    if "latency" in step:
+        emulator.latency = step["latency"]
+        emulator.note("latency %d ms" % emulator.latency)
+    if "jitter" in step:
+        emulator.jitter = step["jitter"]
+        emulator.note("jitter %d ms" % emulator.jitter)
+    if "loss" in step:
+        emulator.loss = step["loss"]
+        emulator.note("loss %.1f%%" % emulator.loss)
+    if "stall" in step:
+        emulator.stalled_until = time.monotonic() + step["stall"]
+        emulator.note("stalled for %.1f s" % step["stall"])
+    if "add" in step:
+        await emulator.add_camera(step["add"])
+    if "remove" in step:
+        await emulator.remove_camera(step["remove"])
+    if "rename" in step:
+        await emulator.rename_camera(step["rename"][0], step["rename"][1])
+    if "config" in step:
+        await emulator.configure(step["config"])
+    if step.get("disconnect"):
+        emulator.note("disconnecting all controllers")
+        emulator.disconnect_all()
+
+
+async def run_console(emulator):
+    """INTERACTIVE COMMANDS: camera N, latency MS, jitter MS, loss PCT,
+    stall SECONDS, disconnect, add NAME, remove N, rename N NAME,
+    config NAME VALUE, stats, telemetry, cameras, quit"""
+    loop = asyncio.get_event_loop()
+    while True:
+        line = await loop.run_in_executor(None, sys.stdin.readline)
+        if not line:
+            return
+        words = line.split()
+        if not words:
+            continue
+        name, args = words[0].lower(), words[1:]
+        try:
+            if name == "quit":
+                raise KeyboardInterrupt()
+            elif name == "stats":
+                emulator.report()
+            elif name == "telemetry":
+                emulator.telemetry_report()
+            elif name == "cameras":
+                for index, camera in enumerate(emulator.cameras):
+                    print("%s %d: %s (%s)" % ("*" if index == emulator.active else " ", index,
+                                              camera.get("name"), camera.get("uuid")))
+            elif name == "disconnect":
+                await apply_step(emulator, {"disconnect": True})
+            elif name == "add" and args:
+                await apply_step(emulator, {"add": " ".join(args)})
+            elif name == "remove" and args:
+                await apply_step(emulator, {"remove": int(args[0])})
+            elif name == "rename" and len(args) > 1:
+                await apply_step(emulator, {"rename": [int(args[0]), " ".join(args[1:])]})
+            elif name == "config" and len(args) > 1:
+                # numbers and true/false are sent as JSON values, anything else as text
+                value = " ".join(args[1:])
+                if re.match(r"^-?\d+$", value):
+                    value = int(value)
+                elif value in ("true", "false"):
+                    value = (value == "true")
+                await apply_step(emulator, {"config": {args[0]: value}})
+            elif name in ("camera", "latency", "jitter", "loss", "stall") and args:
+                value = float(args[0]) if name in ("loss", "stall") else int(args[0])
+                await apply_step(emulator, {name: value})
+            else:
+                print("commands: camera N | latency MS | jitter MS | loss PCT | stall SECONDS | "
+                      "disconnect | add NAME | remove N | rename N NAME | config NAME VALUE | cameras | stats | telemetry | quit")
+        except ValueError:
+            print("invalid value: %s" % line.strip())
+
+
+async def run_stats(emulator):
+    while True:
+        await asyncio.sleep(emulator.options.stats)
+        emulator.report()
+
+
+async def main(options):
+    scenario = {}
+    if options.scenario:
+        with open(options.scenario) as source:
+            scenario = json.load(source)
+    emulator = Emulator(options, scenario)
+
+    server = await asyncio.start_server(
+        lambda reader, writer: Connection(emulator, reader, writer).run(),
+        options.host, options.port, backlog=1024)
+    emulator.note("gateway emulator listening on %s:%d" % (options.host, options.port))
+
+    loop = asyncio.get_event_loop()
+    if not options.no_discovery:
+        await loop.create_datagram_endpoint(lambda: DiscoveryResponder(options.port),
+                                            local_addr=(options.host, options.discovery_port))
+        emulator.note("answering discovery probes on udp port %d" % options.discovery_port)
+
+    tasks = [asyncio.ensure_future(run_timeline(emulator))]
+    if options.stats > 0:
+        tasks.append(asyncio.ensure_future(run_stats(emulator)))
+    if sys.stdin.isatty():
+        tasks.append(asyncio.ensure_future(run_console(emulator)))
+    try:
+        if options.duration > 0:
+            await asyncio.sleep(options.duration)
+        else:
+            await asyncio.Event().wait()
+    finally:
+        for task in tasks:
+            task.cancel()
+        server.close()
+        emulator.report()
+        print("[totals] %s" % " ".join("%s=%d" % item for item in sorted(emulator.totals.items())), flush=True)
+
+
+def arguments(argv=None):
+    parser = argparse.ArgumentParser(description="Local Monocle Gateway emulator")
+    parser.add_argument("--host", default="0.0.0.0", help="listen address (default: all interfaces)")
+    parser.add_argument("--port", type=int, default=8080, help="web-socket port (default: 8080)")
+    parser.add_argument("--scenario", help="JSON file with a camera list and fault injection timeline")
+    parser.add_argument("--cameras", type=int, default=0, help="add N generated cameras to the camera list")
+    parser.add_argument("--latency", type=int, default=0, help="processing delay of each received frame (ms)")
+    parser.add_argument("--jitter", type=int, default=0, help="random +/- variation of the latency (ms)")
+    parser.add_argument("--loss", type=float, default=0.0, help="percentage of commands and pings dropped")
+    parser.add_argument("--disconnect-every", type=float, default=0.0,
+                        help="drop each connection after about this many seconds")
+    parser.add_argument("--log", help="append every received command to this file (JSON lines)")
+    parser.add_argument("--stats", type=float, default=0.0, help="print statistics every N seconds")
+    parser.add_argument("--duration", type=float, default=0.0, help="exit after N seconds")
+    parser.add_argument("--discovery-port", type=int, default=DISCOVERY_PORT,
+                        help="udp port of the discovery responder (default: %d)" % DISCOVERY_PORT)
+    parser.add_argument("--no-discovery", action="store_true", help="do not answer discovery probes")
+    parser.add_argument("--quiet", action="store_true", help="do not print each command")
+    return parser.parse_args(argv)
+
+
+if __name__ == "__main__":
+    try:
+        asyncio.run(main(arguments()))
+    except KeyboardInterrupt:
+        pass
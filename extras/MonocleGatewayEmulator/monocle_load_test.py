@@ -0,0 +1,211 @@
+#!/usr/bin/env python3
+#
+# **********************************************************************
+#             __  __  ___  _  _  ___   ___ _    ___
+#            |  \/  |/ _ \| \| |/ _ \ / __| |  | __|
+#            | |\/| | (_) | .` | (_) | (__| |__| _|
+#            |_|  |_|\___/|_|\_|\___/ \___|____|___|
+#
+# -------------------------------------------------------------------
+#                   MONOCLE GATEWAY LOAD TEST (HOST)
+# -------------------------------------------------------------------
+#
+#  Simulates many PTZ controllers against a Monocle Gateway (or the
+#  gateway emulator).  Each simulated controller connects the way
+#  'MonocleGatewayClient' does, waits for the 'source' message, then
+#  sends joystick-like PTZ/STOP bursts and occasional PRESET/HOME
+#  commands while measuring heartbeat (ping/pong) round trip times
+#  the way 'MonocleGatewayPool' does.  Dropped connections are
+#  reconnected after the pool's reconnect interval.  With --telemetry
+#  each controller also sends 'MonocleTelemetry' frames.
+#
+#  Standard library only (Python 3.7 or later).
+#
+#  Author:   Robert Savage
+#  Date:     2018-02-18
+#  Website:  http://monoclecam.com
+#
+# -------------------------------------------------------------------
+#        COPYRIGHT SHADEBLUE, LLC @ 2018, ALL RIGHTS RESERVED
+# -------------------------------------------------------------------
+#
+# **********************************************************************
+#
+import argparse
+import asyncio
+import json
+import random
+import struct
+import time
+
+import monocle_ws as ws
+
+TELEMETRY_QUIET_TIME = 0.25          # MONOCLE_TELEMETRY_QUIET_TIME (seconds)
+
+
+class Totals:
+    def __init__(self):
+        self.connected = 0
+        self.failed = 0
+        self.dropped = 0
+        self.sent = 0
+        self.pongs = 0
+        self.missed = 0
+        self.sources = 0
+        self.frames = 0
+        self.rtts = []
+
+
+async def controller(index, options, totals, stop_time):
+    """ONE SIMULATED CONTROLLER (RECONNECTS UNTIL THE TEST ENDS)"""
+    rng = random.Random(options.seed + index)
+    start_time = time.monotonic()
+    counters = {"conn": 0, "disc": 0, "cmd": 0, "seq": 0}
+    await asyncio.sleep(rng.uniform(0, options.ramp))
+    while time.monotonic() < stop_time:
+        try:
+            reader, writer = await asyncio.wait_for(
+                asyncio.open_connection(options.host, options.port), options.reconnect / 1000.0)
+            await asyncio.wait_for(
+                ws.client_handshake(reader, writer, "%s:%d" % (options.host, options.port)), 5)
+        except (OSError, asyncio.TimeoutError, ws.ConnectionClosed):
+            totals.failed += 1
+            await asyncio.sleep(options.reconnect / 1000.0)
+            continue
+
+        totals.connected += 1
+        counters["conn"] += 1
+        pings = {}
+        source = {}
+        rtt_buckets = []
+        last_command = [0.0]
+
+        async def receive():
+            while True:
+                opcode, payload = await ws.read_frame(reader)
+                if opcode == ws.OP_PONG and payload in pings:
+                    rtt = time.monotonic() - pings.pop(payload)
+                    totals.rtts.append(rtt)
+                    totals.pongs += 1
+                    rtt_buckets.append(int(rtt * 1000).bit_length())
+                elif opcode == ws.OP_TEXT:
+                    message = json.loads(payload.decode("utf-8"))
+                    if "source" in message:
+                        source.update(message["source"])
+                        totals.sources += 1
+                elif opcode == ws.OP_CLOSE:
+                    raise ws.ConnectionClosed()
+
+        async def send(text):
+            writer.write(ws.encode_frame(ws.OP_TEXT, text, mask=True))
+            await writer.drain()
+            totals.sent += 1
+            counters["cmd"] += 1
+            last_command[0] = time.monotonic()
+
+        async def heartbeat():
+            sequence = 0
+            while True:
+                await asyncio.sleep(options.heartbeat / 1000.0)
+                now = time.monotonic()
+                for payload, sent in list(pings.items()):
+                    if now - sent > options.heartbeat_timeout / 1000.0:
+                        del pings[payload]
+                        totals.missed += 1
+                payload = struct.pack("!II", index, sequence)
+                sequence += 1
+                pings[payload] = now
+                writer.write(ws.encode_frame(ws.OP_PING, payload, mask=True))
+                await writer.drain()
+
+        async def operate():
+            # joystick-like use: a movement burst of PTZ changes ending with a stop
+            while True:
+                await asyncio.sleep(rng.expovariate(options.rate))
+                prefix = "@%s:" % source["uuid"] if options.sessions and "uuid" in source else ""
+                roll = rng.random()
+                if roll < 0.05:
+                    await send(prefix + "PRESET:#%d" % rng.randint(0, 3))
+                elif roll < 0.08:
+                    await send(prefix + "HOME")
+                else:
+                    for _ in range(rng.randint(1, 4)):
+                        await send(prefix + "PTZ:%d:%d:%d" % (rng.randint(-3, 3), rng.randint(-3, 3), 0))
+                        await asyncio.sleep(options.event_delay / 1000.0)
+                    await send(prefix + "STOP")
+
+        async def telemetry():
+            # a frame per interval, held back while a movement burst is in progress
+            while True:
+                await asyncio.sleep(options.telemetry / 1000.0)
+                while time.monotonic() - last_command[0] < TELEMETRY_QUIET_TIME:
+                    await asyncio.sleep(TELEMETRY_QUIET_TIME)
+                rtt = [rtt_buckets.count(bucket) for bucket in range(max(rtt_buckets, default=0) + 1)]
+                del rtt_buckets[:]
+                writer.write(ws.encode_frame(ws.OP_TEXT, "TELEMETRY:seq=%d,up=%d,conn=%d,disc=%d,cmd=%d,rtt=%s" % (
+                    counters["seq"], (time.monotonic() - start_time) * 1000, counters["conn"], counters["disc"],
+                    counters["cmd"], "/".join(str(count) for count in rtt)), mask=True))
+                await writer.drain()
+                counters["seq"] += 1
+                totals.frames += 1
+
+        tasks = [asyncio.ensure_future(task()) for task in (receive, heartbeat, operate)]
+        if options.telemetry > 0:
+            tasks.append(asyncio.ensure_future(telemetry()))
+        remaining = stop_time - time.monotonic()
+        done, pending = await asyncio.wait(tasks, timeout=max(0.0, remaining),
+                                           return_when=asyncio.FIRST_EXCEPTION)
+        for task in pending:
+            task.cancel()
+        writer.close()
+        if done:
+            totals.dropped += 1
+            counters["disc"] += 1
+            await asyncio.sleep(options.reconnect / 1000.0)
+
+
+def percentile(values, p):
+    return values[min(len(values) - 1, int(len(values) * p))] * 1000 if values else 0.0
+
+
+async def main(options):
+    totals = Totals()
+    start = time.monotonic()
+    stop_time = start + options.duration
+    await asyncio.gather(*[controller(index, options, totals, stop_time) for index in range(options.clients)])
+    elapsed = time.monotonic() - start
+    rtts = sorted(totals.rtts)
+    print("controllers=%d connections=%d failed=%d dropped=%d sources=%d"
+          % (options.clients, totals.connected, totals.failed, totals.dropped, totals.sources))
+    print("commands sent=%d (%.1f/s)  heartbeats answered=%d missed=%d  telemetry frames=%d"
+          % (totals.sent, totals.sent / elapsed, totals.pongs, totals.missed, totals.frames))
+    print("heartbeat rtt p50=%.1fms p95=%.1fms p99=%.1fms max=%.1fms"
+          % (percentile(rtts, 0.5), percentile(rtts, 0.95), percentile(rtts, 0.99),
+             rtts[-1] * 1000 if rtts else 0.0))
+
+
+def arguments(argv=None):
+    parser = argparse.ArgumentParser(description="Monocle Gateway load test")
+    parser.add_argument("--host", default="127.0.0.1", help="gateway address")
+    parser.add_argument("--port", type=int, default=8080, help="gateway web-socket port")
+    parser.add_argument("--clients", type=int, default=100, help="number of simulated controllers")
+    parser.add_argument("--duration", type=float, default=30.0, help="test length (seconds)")
+    parser.add_argument("--ramp", type=float, default=5.0, help="spread the connections over N seconds")
+    parser.add_argument("--rate", type=float, default=1.0, help="movement bursts per second per controller")
+    parser.add_argument("--event-delay", type=int, default=100,
+                        help="delay between PTZ changes in a burst (ms; joystick PTZ event delay)")
+    parser.add_argument("--sessions", action="store_true", help="address the camera by uuid ('@<uuid>:')")
+    parser.add_argument("--heartbeat", type=int, default=200, help="heartbeat interval (ms)")
+    parser.add_argument("--heartbeat-timeout", type=int, default=400, help="heartbeat timeout (ms)")
+    parser.add_argument("--reconnect", type=int, default=5000, help="reconnect interval (ms)")
+    parser.add_argument("--telemetry", type=int, default=0,
+                        help="send a telemetry frame every N ms from each controller (0 = off)")
+    parser.add_argument("--seed", type=int, default=1, help="random seed (runs are repeatable)")
+    return parser.parse_args(argv)
+
+
+if __name__ == "__main__":
+    try:
+        asyncio.run(main(arguments()))
+    except KeyboardInterrupt:
+        pass
@@ -0,0 +1,152 @@
+#
+# **********************************************************************
+#             __  __  ___  _  _  ___   ___ _    ___
+#            |  \/  |/ _ \| \| |/ _ \ / __| |  | __|
+#            | |\/| | (_) | .` | (_) | (__| |__| _|
+#            |_|  |_|\___/|_|\_|\___/ \___|____|___|
+#
+# -------------------------------------------------------------------
+#                 MONOCLE WEB-SOCKET FRAMING (HOST)
+# -------------------------------------------------------------------
+#
+#  Minimal RFC 6455 web-socket framing shared by the Monocle Gateway
+#  emulator and the load test client.  Only what the Monocle Gateway
+#  protocol uses is implemented: text, ping, pong and close frames
+#  (with continuation frames reassembled).  Standard library only.
+#
+#  Author:   Robert Savage
+#  Date:     2018-02-18
+#  Website:  http://monoclecam.com
+#
+# -------------------------------------------------------------------
+#        COPYRIGHT SHADEBLUE, LLC @ 2018, ALL RIGHTS RESERVED
+# -------------------------------------------------------------------
+#
+# **********************************************************************
+#
+import asyncio
+import base64
+import hashlib
+import os
+import struct
+
+GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+
+OP_CONTINUATION = 0x0
+OP_TEXT = 0x1
+OP_BINARY = 0x2
+OP_CLOSE = 0x8
+OP_PING = 0x9
+OP_PONG = 0xA
+
+
+class ConnectionClosed(Exception):
+    pass
+
+
+def accept_key(key):
+    """WEB-SOCKET ACCEPT KEY FOR A CLIENT'S 'Sec-WebSocket-Key'"""
+    digest = hashlib.sha1((key + GUID).encode("ascii")).digest()
+    return base64.b64encode(digest).decode("ascii")
+
+
+async def read_http_head(reader):
+    """READ AN HTTP REQUEST/RESPONSE HEAD; RETURNS (START LINE, HEADERS)"""
+    try:
+        data = await reader.readuntil(b"\r\n\r\n")
+    except (asyncio.IncompleteReadError, asyncio.LimitOverrunError):
+        raise ConnectionClosed()
+    lines = data.decode("latin-1").split("\r\n")
+    headers = {}
+    for line in lines[1:]:
+        if ":" in line:
+            name, value = line.split(":", 1)
+            headers[name.strip().lower()] = value.strip()
+    return lines[0], headers
+
+
+async def server_handshake(reader, writer):
+    """ACCEPT A WEB-SOCKET UPGRADE; RETURNS THE REQUESTED PATH"""
+    start, headers = await read_http_head(reader)
+    key = headers.get("sec-websocket-key")
+    if key is None:
+        writer.write(b"HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\n\r\n")
+        await writer.drain()
+        raise ConnectionClosed()
+    writer.write(("HTTP/1.1 101 Switching Protocols\r\n"
+                  "Upgrade: websocket\r\n"
+                  "Connection: Upgrade\r\n"
+                  "Sec-WebSocket-Accept: %s\r\n\r\n" % accept_key(key)).encode("ascii"))
+    await writer.drain()
+    parts = start.split(" ")
+    return parts[1] if len(parts) > 1 else "/"
+
+
+async def client_handshake(reader, writer, host, path="/"):
+    """REQUEST A WEB-SOCKET UPGRADE (AS 'ArduinoHttpClient' DOES)"""
+    key = base64.b64encode(os.urandom(16)).decode("ascii")
+    writer.write(("GET %s HTTP/1.1\r\n"
+                  "Host: %s\r\n"
+                  "Upgrade: websocket\r\n"
+                  "Connection: Upgrade\r\n"
+                  "Sec-WebSocket-Key: %s\r\n"
+                  "Sec-WebSocket-Version: 13\r\n\r\n" % (path, host, key)).encode("ascii"))
+    await writer.drain()
+    start, headers = await read_http_head(reader)
+    if " 101 " not in start + " " or headers.get("sec-websocket-accept") != accept_key(key):
+        raise ConnectionClosed()
+
+
+def encode_frame(opcode, payload=b"", mask=False):
+    """ENCODE A SINGLE (FINAL) FRAME; CLIENT FRAMES MUST BE MASKED"""
+    if isinstance(payload, str):
+        payload = payload.encode("utf-8")
+    head = bytearray([0x80 | opcode])
+    length = len(payload)
+    mask_bit = 0x80 if mask else 0
+    if length < 126:
+        head.append(mask_bit | length)
+    elif length < 65536:
+        head.append(mask_bit | 126)
+        head += struct.pack("!H", length)
+    else:
+        head.append(mask_bit | 127)
+        head += struct.pack("!Q", length)
+    if mask:
+        key = os.urandom(4)
+        head += key
+        payload = bytes(b ^ key[i & 3] for i, b in enumerate(payload))
+    return bytes(head) + payload
+
+
+async def read_frame(reader):
+    """READ ONE MESSAGE; RETURNS (OPCODE, PAYLOAD BYTES).
+    CONTINUATION FRAMES ARE REASSEMBLED; CONTROL FRAMES ARE RETURNED AS-IS"""
+    message_opcode = None
+    message = b""
+    while True:
+        try:
+            b1, b2 = await reader.readexactly(2)
+            length = b2 & 0x7F
+            if length == 126:
+                length = struct.unpack("!H", await reader.readexactly(2))[0]
+            elif length == 127:
+                length = struct.unpack("!Q", await reader.readexactly(8))[0]
+            key = await reader.readexactly(4) if b2 & 0x80 else None
+            payload = await reader.readexactly(length)
+        except (asyncio.IncompleteReadError, ConnectionError):
+            raise ConnectionClosed()
+        if key is not None:
+            payload = bytes(b ^ key[i & 3] for i, b in enumerate(payload))
+
+        opcode = b1 & 0x0F
+        final = (b1 & 0x80) != 0
+        if opcode >= OP_CLOSE:
+            return opcode, payload
+        if opcode != OP_CONTINUATION:
+            message_opcode = opcode
+            message = payload
+        else:
+            message += payload
+        if final:
+            return message_opcode, message
@@ -0,0 +1,2 @@
+/* Host stand-in: see 'Adafruit_SSD1306.h'. */
+#include <Adafruit_SSD1306.h>
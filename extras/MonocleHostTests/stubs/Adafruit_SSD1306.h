@@ -0,0 +1,73 @@
+/*
+ * Host stand-in for the Adafruit SSD1306 / GFX display driver.  Text
+ * drawn with the 6x8 font is kept in a character grid ('text(row)')
+ * so tests can check what is on the screen; frame pushes, dimming and
+ * display on/off commands are counted.
+ */
+#ifndef HOST_ADAFRUIT_SSD1306_H
+#define HOST_ADAFRUIT_SSD1306_H
+
+#include <Arduino.h>
+
+#define SSD1306_SWITCHCAPVCC 0x02
+#define SSD1306_DISPLAYOFF 0xAE
+#define SSD1306_DISPLAYON 0xAF
+#define SSD1306_LCDHEIGHT 64
+
+#define HOST_DISPLAY_ROWS 8
+#define HOST_DISPLAY_COLUMNS 21
+
+class Adafruit_GFX : public Print {
+  protected:
+    char grid[HOST_DISPLAY_ROWS][HOST_DISPLAY_COLUMNS + 1];
+    int16_t cursor_x = 0, cursor_y = 0;
+  public:
+    Adafruit_GFX() { clearGrid(); }
+    void clearGrid() { for(int r = 0; r < HOST_DISPLAY_ROWS; r++){ memset(grid[r], ' ', HOST_DISPLAY_COLUMNS); grid[r][HOST_DISPLAY_COLUMNS] = '\0'; } }
+    void setCursor(int16_t x, int16_t y) { cursor_x = x; cursor_y = y; }
+    void setTextColor(uint16_t) {}
+    void setTextColor(uint16_t, uint16_t) {}
+    void setTextSize(uint8_t) {}
+    void setTextWrap(bool) {}
+    void writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t) {
+      for(int r = 0; r < HOST_DISPLAY_ROWS; r++){
+        if(r * 8 < y || r * 8 >= y + h) continue;
+        for(int c = 0; c < HOST_DISPLAY_COLUMNS; c++) if(c * 6 >= x && c * 6 < x + w) grid[r][c] = ' ';
+      }
+    }
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) { writeFillRect(x, y, w, h, color); }
+    void writeLine(int16_t, int16_t, int16_t, int16_t, uint16_t) {}
+    void drawFastVLine(int16_t, int16_t, int16_t, uint16_t) {}
+    void drawFastHLine(int16_t, int16_t, int16_t, uint16_t) {}
+    void drawPixel(int16_t, int16_t, uint16_t) {}
+    void drawBitmap(int16_t, int16_t, const uint8_t*, int16_t, int16_t, uint16_t) {}
+    int16_t width() const { return 128; }
+    int16_t height() const { return 64; }
+    size_t write(uint8_t c) {
+      int r = cursor_y / 8, col = cursor_x / 6;
+      if(c == '\n'){ cursor_x = 0; cursor_y += 8; return 1; }
+      if(r >= 0 && r < HOST_DISPLAY_ROWS && col >= 0 && col < HOST_DISPLAY_COLUMNS) grid[r][col] = (char)c;
+      cursor_x += 6;
+      return 1;
+    }
+    using Print::write;
+
+    /* TEXT SHOWN ON A CHARACTER ROW (0..7) */
+    const char* text(int row) const { return grid[row]; }
+};
+
+class Adafruit_SSD1306 : public Adafruit_GFX {
+  public:
+    unsigned long frames = 0;
+    bool dimmed = false;
+    bool on = true;
+    Adafruit_SSD1306(int8_t reset = -1) {}
+    bool begin(uint8_t = 0, uint8_t = 0, bool = true) { return true; }
+    void display() { frames++; }
+    void clearDisplay() { clearGrid(); }
+    void dim(bool dim) { dimmed = dim; }
+    void invertDisplay(bool) {}
+    void ssd1306_command(uint8_t command) { if(command == SSD1306_DISPLAYOFF) on = false; if(command == SSD1306_DISPLAYON) on = true; }
+};
+
+#endif
@@ -0,0 +1,179 @@
+/*
+ * Host (Linux) stand-in for the subset of the Arduino core used by the
+ * Monocle library; see 'HostArduino.h' for the simulated clock, pins,
+ * interrupts and serial port the host tests drive.
+ */
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <math.h>
+#include <string>
+#include <deque>
+
+#define PROGMEM
+#define F(text) (text)
+#define PGM_P const char*
+#define memcpy_P memcpy
+#define strncpy_P strncpy
+#define strlen_P strlen
+#define pgm_read_byte(address) (*(const uint8_t*)(address))
+#define pgm_read_word(address) (*(const uint16_t*)(address))
+#define pgm_read_dword(address) (*(const uint32_t*)(address))
+#define pgm_read_ptr(address) (*(void* const*)(address))
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define CHANGE 1
+#define FALLING 2
+#define RISING 3
+#define NOT_AN_INTERRUPT -1
+#define DEC 10
+#define HEX 16
+#define WHITE 1
+#define BLACK 0
+
+/* HOST PINS: 0..31 ARE READ AS BITS OF ONE INPUT PORT REGISTER */
+#define HOST_PINS 32
+#define digitalPinToInterrupt(pin) ((pin) < HOST_PINS ? (pin) : NOT_AN_INTERRUPT)
+#define digitalPinToPort(pin) (0)
+#define digitalPinToBitMask(pin) (1UL << (pin))
+#define portInputRegister(port) (&hostPortRegister)
+extern volatile uint32_t hostPortRegister;
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+void pinMode(int pin, int mode);
+int digitalRead(int pin);
+void digitalWrite(int pin, int value);
+int analogRead(int pin);
+void attachInterrupt(int interrupt, void (*handler)(void), int mode);
+void detachInterrupt(int interrupt);
+void noInterrupts();
+void interrupts();
+
+template<class T> T min(T a, T b) { return (a < b) ? a : b; }
+template<class T> T max(T a, T b) { return (a > b) ? a : b; }
+template<class T, class L, class H> T constrain(T x, L low, H high) { return (x < low) ? low : ((x > high) ? high : x); }
+
+class String {
+  public:
+    std::string s;
+    String(const char* text = "") : s(text ? text : "") {}
+    String(const std::string& text) : s(text) {}
+    String(int value) : s(std::to_string(value)) {}
+    String(unsigned int value) : s(std::to_string(value)) {}
+    String(long value) : s(std::to_string(value)) {}
+    String(unsigned long value) : s(std::to_string(value)) {}
+    const char* c_str() const { return s.c_str(); }
+    unsigned int length() const { return s.size(); }
+    char charAt(unsigned int index) const { return index < s.size() ? s[index] : 0; }
+    int indexOf(char c) const { size_t at = s.find(c); return at == std::string::npos ? -1 : (int)at; }
+    String substring(unsigned int from) const { return String(s.substr(from < s.size() ? from : s.size())); }
+    String substring(unsigned int from, unsigned int to) const { return String(s.substr(from, to - from)); }
+    long toInt() const { return atol(s.c_str()); }
+    void trim() { size_t a = s.find_first_not_of(" \t\r\n"); size_t b = s.find_last_not_of(" \t\r\n"); s = (a == std::string::npos) ? "" : s.substr(a, b - a + 1); }
+    String& operator+=(const String& other) { s += other.s; return *this; }
+    String& operator+=(const char* other) { s += other; return *this; }
+    String& operator+=(char other) { s += other; return *this; }
+    String& operator+=(int other) { s += std::to_string(other); return *this; }
+    friend String operator+(const String& a, const String& b) { return String(a.s + b.s); }
+    friend String operator+(const String& a, const char* b) { return String(a.s + b); }
+    friend String operator+(const char* a, const String& b) { return String(a + b.s); }
+    friend String operator+(const String& a, int b) { return String(a.s + std::to_string(b)); }
+    bool operator==(const char* other) const { return s == other; }
+    bool operator==(const String& other) const { return s == other.s; }
+};
+
+class Print {
+  public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size) { for(size_t i = 0; i < size; i++) write(buffer[i]); return size; }
+    size_t write(const char* text) { return write((const uint8_t*)text, strlen(text)); }
+    size_t print(const char* text) { return write(text); }
+    size_t print(const String& text) { return write(text.c_str()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(long value, int base = DEC) { char t[24]; snprintf(t, sizeof(t), base == HEX ? "%lX" : "%ld", value); return write(t); }
+    size_t print(unsigned long value, int base = DEC) { char t[24]; snprintf(t, sizeof(t), base == HEX ? "%lX" : "%lu", value); return write(t); }
+    size_t print(int value, int base = DEC) { return print((long)value, base); }
+    size_t print(unsigned int value, int base = DEC) { return print((unsigned long)value, base); }
+    size_t print(unsigned char value, int base = DEC) { return print((unsigned long)value, base); }
+    size_t print(double value, int digits = 2) { char t[32]; snprintf(t, sizeof(t), "%.*f", digits, value); return write(t); }
+    size_t println() { return write("\r\n"); }
+    template<class T> size_t println(T value) { size_t n = print(value); return n + println(); }
+    template<class T> size_t println(T value, int format) { size_t n = print(value, format); return n + println(); }
+    int printf(const char* format, ...) { char t[256]; va_list args; va_start(args, format); int n = vsnprintf(t, sizeof(t), format, args); va_end(args); write(t); return n; }
+};
+
+class Stream : public Print {
+  protected:
+    unsigned long _timeout = 1000;
+  public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    virtual void flush() {}
+    void setTimeout(unsigned long timeout) { _timeout = timeout; }
+    size_t readBytes(char* buffer, size_t length) { size_t n = 0; while(n < length){ int c = read(); if(c < 0) break; buffer[n++] = (char)c; } return n; }
+    size_t readBytes(uint8_t* buffer, size_t length) { return readBytes((char*)buffer, length); }
+    String readString() { std::string text; int c; while((c = read()) >= 0) text += (char)c; return String(text); }
+};
+
+/* SERIAL PORT: OUTPUT IS COLLECTED, INPUT IS QUEUED BY THE TEST */
+class HardwareSerial : public Stream {
+  public:
+    std::string output;
+    std::deque<char> input;
+    void begin(unsigned long) {}
+    void end() {}
+    operator bool() { return true; }
+    size_t write(uint8_t c) { output += (char)c; return 1; }
+    using Print::write;
+    int available() { return (int)input.size(); }
+    int read() { if(input.empty()) return -1; char c = input.front(); input.pop_front(); return (unsigned char)c; }
+    int peek() { return input.empty() ? -1 : (unsigned char)input.front(); }
+    void feed(const char* text) { while(*text) input.push_back(*text++); }
+};
+extern HardwareSerial Serial;
+
+class IPAddress {
+  public:
+    uint8_t b[4];
+    IPAddress() { memset(b, 0, 4); }
+    IPAddress(uint8_t a, uint8_t c, uint8_t d, uint8_t e) { b[0] = a; b[1] = c; b[2] = d; b[3] = e; }
+    IPAddress(uint32_t value) { memcpy(b, &value, 4); }
+    operator uint32_t() const { uint32_t value; memcpy(&value, b, 4); return value; }
+    uint8_t operator[](int index) const { return b[index]; }
+    uint8_t& operator[](int index) { return b[index]; }
+    bool operator==(const IPAddress& other) const { return memcmp(b, other.b, 4) == 0; }
+    bool operator!=(const IPAddress& other) const { return !(*this == other); }
+    bool fromString(const char* text) { unsigned v[4]; if(sscanf(text, "%u.%u.%u.%u", &v[0], &v[1], &v[2], &v[3]) != 4) return false; for(int i = 0; i < 4; i++) b[i] = (uint8_t)v[i]; return true; }
+};
+
+class Client : public Stream {
+  public:
+    virtual int connect(IPAddress ip, uint16_t port) = 0;
+    virtual int connect(const char* host, uint16_t port) = 0;
+    virtual uint8_t connected() = 0;
+    virtual void stop() = 0;
+    virtual int read(uint8_t* buffer, size_t size) { size_t n = 0; while(n < size){ int c = read(); if(c < 0) break; buffer[n++] = (uint8_t)c; } return (int)n; }
+    using Stream::read;
+    operator bool() { return connected(); }
+};
+
+#endif
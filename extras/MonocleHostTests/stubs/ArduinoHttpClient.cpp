@@ -0,0 +1,120 @@
+/*
+ * Host implementation of the 'WebSocketClient' stand-in.
+ */
+#include "ArduinoHttpClient.h"
+#include <chrono>
+#include <thread>
+
+static unsigned long realMillis() {
+  return (unsigned long)std::chrono::duration_cast<std::chrono::milliseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+WebSocketClient::WebSocketClient(Client& client, const char* host, uint16_t port)
+  : client(client), host(host), byAddress(false), port(port) {}
+WebSocketClient::WebSocketClient(Client& client, const String& host, uint16_t port)
+  : client(client), host(host.c_str()), byAddress(false), port(port) {}
+WebSocketClient::WebSocketClient(Client& client, const IPAddress& address, uint16_t port)
+  : client(client), address(address), byAddress(true), port(port) {}
+
+/* CONNECT AND UPGRADE; THE RESPONSE WAIT IS BOUNDED BY THE HTTP RESPONSE TIMEOUT */
+int WebSocketClient::begin(const char* path) {
+  message.clear();
+  position = 0;
+  if(!(byAddress ? client.connect(address, port) : client.connect(host.c_str(), port))) return HTTP_ERROR_CONNECTION_FAILED;
+  char request[256];
+  snprintf(request, sizeof(request),
+           "GET %s HTTP/1.1\r\nHost: %s:%u\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+           "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n",
+           path, host.c_str(), port);
+  client.write((const uint8_t*)request, strlen(request));
+
+  std::string head;
+  unsigned long start = realMillis();
+  while(head.size() < 4 || head.compare(head.size() - 4, 4, "\r\n\r\n") != 0){
+    int c = client.read();
+    if(c >= 0){ head += (char)c; continue; }
+    if(!client.connected()) return HTTP_ERROR_CONNECTION_FAILED;
+    if(realMillis() - start >= responseTimeout){ client.stop(); return HTTP_ERROR_TIMED_OUT; }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  if(head.compare(0, 12, "HTTP/1.1 101") != 0){ client.stop(); return HTTP_ERROR_INVALID_RESPONSE; }
+  return HTTP_SUCCESS;
+}
+
+void WebSocketClient::sendFrame(int opcode, const std::string& payload) {
+  std::string frame;
+  frame += (char)(0x80 | opcode);
+  if(payload.size() < 126) frame += (char)(0x80 | payload.size());
+  else { frame += (char)(0x80 | 126); frame += (char)(payload.size() >> 8); frame += (char)(payload.size() & 0xFF); }
+  const uint8_t mask[4] = { 0x12, 0x34, 0x56, 0x78 };
+  frame.append((const char*)mask, 4);
+  for(size_t i = 0; i < payload.size(); i++) frame += (char)(payload[i] ^ mask[i & 3]);
+  client.write((const uint8_t*)frame.data(), frame.size());
+}
+
+int WebSocketClient::beginMessage(int type) {
+  outgoingType = type;
+  outgoing.clear();
+  return 0;
+}
+int WebSocketClient::endMessage() {
+  if(outgoingType < 0) return -1;
+  sendFrame(outgoingType, outgoing);
+  outgoingType = -1;
+  return 0;
+}
+size_t WebSocketClient::write(uint8_t c) {
+  if(outgoingType < 0) return 0;
+  outgoing += (char)c;
+  return 1;
+}
+size_t WebSocketClient::write(const uint8_t* buffer, size_t size) {
+  if(outgoingType < 0) return 0;
+  outgoing.append((const char*)buffer, size);
+  return size;
+}
+int WebSocketClient::ping() {
+  if(!client.connected()) return -1;
+  // like ArduinoHttpClient, a ping carries 16 bytes the pong echoes
+  sendFrame(TYPE_PING, std::string("monocle-host-png", 16));
+  return 0;
+}
+int WebSocketClient::read(uint8_t* buffer, size_t size) {
+  size_t n = 0;
+  while(n < size && position < message.size()) buffer[n++] = (uint8_t)message[position++];
+  return (int)n;
+}
+
+bool WebSocketClient::readExactly(uint8_t* buffer, size_t length) {
+  size_t n = 0;
+  unsigned long start = realMillis();
+  while(n < length){
+    int c = client.read();
+    if(c >= 0){ buffer[n++] = (uint8_t)c; continue; }
+    if(!client.connected() || realMillis() - start >= responseTimeout) return false;
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+  return true;
+}
+
+/* READ THE NEXT MESSAGE (0 IF NONE); PINGS ARE ANSWERED, A CLOSE DROPS THE CONNECTION */
+int WebSocketClient::parseMessage() {
+  message.clear();
+  position = 0;
+  if(!client.connected() || client.available() < 2) return 0;
+  uint8_t head[2];
+  if(!readExactly(head, 2)){ client.stop(); return 0; }
+  uint64_t length = head[1] & 0x7F;
+  if(length == 126){ uint8_t b[2]; if(!readExactly(b, 2)) return 0; length = (b[0] << 8) | b[1]; }
+  else if(length == 127){ uint8_t b[8]; if(!readExactly(b, 8)) return 0; length = 0; for(int i = 0; i < 8; i++) length = (length << 8) | b[i]; }
+  uint8_t mask[4] = { 0, 0, 0, 0 };
+  if((head[1] & 0x80) && !readExactly(mask, 4)) return 0;
+  message.resize((size_t)length);
+  if(length > 0 && !readExactly((uint8_t*)&message[0], (size_t)length)){ client.stop(); return 0; }
+  for(size_t i = 0; i < message.size(); i++) message[i] ^= mask[i & 3];
+  type = head[0] & 0x0F;
+  if(type == TYPE_PING) sendFrame(TYPE_PONG, message);
+  if(type == TYPE_CONNECTION_CLOSE) client.stop();
+  return (int)message.size();
+}
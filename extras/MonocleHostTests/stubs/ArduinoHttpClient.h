@@ -0,0 +1,69 @@
+/*
+ * Host stand-in for the ArduinoHttpClient 'WebSocketClient': the same
+ * API, speaking real RFC 6455 framing (masked client frames, ping/pong,
+ * close) over any 'Client' - a TCP socket ('HostTcpClient') or the
+ * in-memory gateway ('HostLoopbackGateway').
+ */
+#ifndef HOST_ARDUINO_HTTP_CLIENT_H
+#define HOST_ARDUINO_HTTP_CLIENT_H
+
+#include <Arduino.h>
+#include <string>
+
+#define HTTP_SUCCESS 0
+#define HTTP_ERROR_CONNECTION_FAILED -1
+#define HTTP_ERROR_TIMED_OUT -3
+#define HTTP_ERROR_INVALID_RESPONSE -4
+
+#define TYPE_CONTINUATION     0x0
+#define TYPE_TEXT             0x1
+#define TYPE_BINARY           0x2
+#define TYPE_CONNECTION_CLOSE 0x8
+#define TYPE_PING             0x9
+#define TYPE_PONG             0xa
+
+class WebSocketClient : public Client {
+    Client& client;
+    std::string host;
+    IPAddress address;
+    bool byAddress;
+    uint16_t port;
+    uint32_t responseTimeout = 30000;
+    int type = 0;
+    std::string message;
+    size_t position = 0;
+    int outgoingType = -1;
+    std::string outgoing;
+    bool readExactly(uint8_t* buffer, size_t length);
+    void sendFrame(int opcode, const std::string& payload);
+  public:
+    WebSocketClient(Client& client, const char* host, uint16_t port);
+    WebSocketClient(Client& client, const String& host, uint16_t port);
+    WebSocketClient(Client& client, const IPAddress& address, uint16_t port);
+
+    int begin(const char* path = "/");
+    int begin(const String& path) { return begin(path.c_str()); }
+    void setHttpResponseTimeout(uint32_t timeout) { responseTimeout = timeout; }
+
+    int beginMessage(int type);
+    int endMessage();
+    int ping();
+    int parseMessage();
+    int messageType() { return type; }
+    bool isFinal() { return true; }
+
+    size_t write(uint8_t c);
+    size_t write(const uint8_t* buffer, size_t size);
+    using Print::write;
+    int available() { return (int)(message.size() - position); }
+    int read() { return position < message.size() ? (uint8_t)message[position++] : -1; }
+    int read(uint8_t* buffer, size_t size);
+    int peek() { return position < message.size() ? (uint8_t)message[position] : -1; }
+
+    int connect(IPAddress ip, uint16_t port) { return client.connect(ip, port); }
+    int connect(const char* host, uint16_t port) { return client.connect(host, port); }
+    uint8_t connected() { return client.connected(); }
+    void stop() { client.stop(); }
+};
+
+#endif
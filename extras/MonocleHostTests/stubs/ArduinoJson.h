@@ -0,0 +1,158 @@
+/*
+ * Host stand-in for the ArduinoJson 5 API used by the Monocle library:
+ * a small recursive parser with JsonObject / JsonArray / JsonVariant
+ * access, 'is<T>()', 'as<T>()' and object iteration.
+ */
+#ifndef HOST_ARDUINO_JSON_H
+#define HOST_ARDUINO_JSON_H
+
+#include <Arduino.h>
+#include <string>
+#include <vector>
+
+struct JsonNode {
+  enum Kind { NUL, NUMBER, TEXT, BOOLEAN, OBJECT, ARRAY };
+  Kind kind = NUL;
+  double number = 0;
+  std::string text;
+  bool boolean = false;
+  std::vector<std::pair<std::string, JsonNode*> > members;
+  std::vector<JsonNode*> items;
+  const JsonNode* find(const char* key) const {
+    for(size_t i = 0; i < members.size(); i++) if(members[i].first == key) return members[i].second;
+    return NULL;
+  }
+};
+
+class JsonObject;
+class JsonArray;
+
+template<class T> inline T jsonValue(const JsonNode* node) {
+  if(node == NULL) return T();
+  return (node->kind == JsonNode::BOOLEAN) ? (T)node->boolean : (T)node->number;
+}
+template<> inline const char* jsonValue<const char*>(const JsonNode* node) {
+  return (node != NULL && node->kind == JsonNode::TEXT) ? node->text.c_str() : NULL;
+}
+
+class JsonVariant {
+  public:
+    const JsonNode* node;
+    JsonVariant(const JsonNode* node = NULL) : node(node) {}
+    operator JsonObject&() const;
+    operator JsonArray&() const;
+    operator const char*() const { return jsonValue<const char*>(node); }
+    operator int() const { return jsonValue<int>(node); }
+    operator long() const { return jsonValue<long>(node); }
+    operator bool() const { return jsonValue<bool>(node); }
+    operator float() const { return jsonValue<float>(node); }
+    template<class T> T as() const { return jsonValue<T>(node); }
+    template<class T> bool is() const;
+    JsonVariant operator[](const char* key) const { return JsonVariant(node ? node->find(key) : NULL); }
+    JsonVariant operator[](int index) const { return JsonVariant(node && index < (int)node->items.size() ? node->items[index] : NULL); }
+    bool success() const { return node != NULL; }
+};
+template<> inline bool JsonVariant::is<const char*>() const { return node && node->kind == JsonNode::TEXT; }
+template<> inline bool JsonVariant::is<bool>() const { return node && node->kind == JsonNode::BOOLEAN; }
+template<> inline bool JsonVariant::is<int>() const { return node && node->kind == JsonNode::NUMBER; }
+template<> inline bool JsonVariant::is<long>() const { return node && node->kind == JsonNode::NUMBER; }
+template<> inline bool JsonVariant::is<float>() const { return node && node->kind == JsonNode::NUMBER; }
+template<> inline bool JsonVariant::is<JsonObject>() const { return node && node->kind == JsonNode::OBJECT; }
+template<> inline bool JsonVariant::is<JsonArray>() const { return node && node->kind == JsonNode::ARRAY; }
+
+struct JsonPair {
+  const char* key;
+  JsonVariant value;
+};
+
+class JsonObject : public JsonNode {
+  public:
+    class iterator {
+        const JsonNode* object;
+        size_t index;
+        JsonPair pair;
+      public:
+        iterator(const JsonNode* object, size_t index) : object(object), index(index) {}
+        JsonPair* operator->() { pair.key = object->members[index].first.c_str(); pair.value = JsonVariant(object->members[index].second); return &pair; }
+        JsonPair& operator*() { return *operator->(); }
+        iterator& operator++() { index++; return *this; }
+        bool operator!=(const iterator& other) const { return index != other.index; }
+    };
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, members.size()); }
+    bool success() const { return kind == OBJECT; }
+    bool containsKey(const char* key) const { return find(key) != NULL; }
+    JsonVariant operator[](const char* key) const { return JsonVariant(find(key)); }
+    template<class T> T get(const char* key) const { return jsonValue<T>(find(key)); }
+    template<class T> bool is(const char* key) const { return JsonVariant(find(key)).is<T>(); }
+};
+
+class JsonArray : public JsonNode {
+  public:
+    size_t size() const { return items.size(); }
+    JsonVariant operator[](size_t index) const { return JsonVariant(index < items.size() ? items[index] : NULL); }
+    bool success() const { return kind == ARRAY; }
+    template<class T> T get(size_t index) const { return jsonValue<T>(index < items.size() ? items[index] : NULL); }
+};
+
+extern JsonNode hostJsonInvalid;
+inline JsonVariant::operator JsonObject&() const { return *(JsonObject*)(node ? node : &hostJsonInvalid); }
+inline JsonVariant::operator JsonArray&() const { return *(JsonArray*)(node ? node : &hostJsonInvalid); }
+
+class DynamicJsonBuffer {
+    std::vector<JsonNode*> nodes;
+    const char* p;
+    JsonNode* node() { nodes.push_back(new JsonNode()); return nodes.back(); }
+    void space() { while(*p == ' ' || *p == '\n' || *p == '\t' || *p == '\r') p++; }
+    std::string text() {
+      std::string result;
+      p++;
+      while(*p && *p != '"'){ if(*p == '\\' && p[1]) p++; result += *p++; }
+      if(*p) p++;
+      return result;
+    }
+    JsonNode* value() {
+      space();
+      JsonNode* n = node();
+      if(*p == '{'){
+        p++; space();
+        if(*p == '}'){ p++; n->kind = JsonNode::OBJECT; return n; }
+        while(*p == '"'){
+          std::string key = text(); space();
+          if(*p++ != ':') return n;
+          JsonNode* member = value();
+          n->members.push_back(std::make_pair(key, member));
+          space();
+          if(*p == ','){ p++; space(); continue; }
+          if(*p == '}'){ p++; n->kind = JsonNode::OBJECT; }
+          break;
+        }
+      }
+      else if(*p == '['){
+        p++; space();
+        if(*p == ']'){ p++; n->kind = JsonNode::ARRAY; return n; }
+        while(*p){
+          n->items.push_back(value()); space();
+          if(*p == ','){ p++; continue; }
+          if(*p == ']'){ p++; n->kind = JsonNode::ARRAY; }
+          break;
+        }
+      }
+      else if(*p == '"'){ n->kind = JsonNode::TEXT; n->text = text(); }
+      else if(strncmp(p, "true", 4) == 0){ n->kind = JsonNode::BOOLEAN; n->boolean = true; p += 4; }
+      else if(strncmp(p, "false", 5) == 0){ n->kind = JsonNode::BOOLEAN; p += 5; }
+      else if(strncmp(p, "null", 4) == 0){ p += 4; }
+      else { char* end; n->number = strtod(p, &end); if(end != p) n->kind = JsonNode::NUMBER; p = end; }
+      return n;
+    }
+  public:
+    DynamicJsonBuffer(size_t = 0) {}
+    ~DynamicJsonBuffer() { for(size_t i = 0; i < nodes.size(); i++) delete nodes[i]; }
+    JsonObject& parseObject(const char* json) { p = json; return *(JsonObject*)value(); }
+    JsonObject& parseObject(char* json) { return parseObject((const char*)json); }
+    JsonObject& parseObject(const String& json) { return parseObject(json.c_str()); }
+};
+
+template<size_t CAPACITY> class StaticJsonBuffer : public DynamicJsonBuffer {};
+
+#endif
@@ -0,0 +1,23 @@
+/*
+ * Host stand-in for the Bounce2 debouncer (reads the host pin directly).
+ */
+#ifndef HOST_BOUNCE2_H
+#define HOST_BOUNCE2_H
+
+#include <Arduino.h>
+
+class Bounce {
+    int pin = -1;
+    int state = HIGH;
+    int previous = HIGH;
+  public:
+    void attach(int pin) { this->pin = pin; state = previous = digitalRead(pin); }
+    void attach(int pin, int mode) { pinMode(pin, mode); attach(pin); }
+    void interval(uint16_t) {}
+    bool update() { previous = state; state = digitalRead(pin); return state != previous; }
+    int read() { return state; }
+    bool fell() { return previous == HIGH && state == LOW; }
+    bool rose() { return previous == LOW && state == HIGH; }
+};
+
+#endif
@@ -0,0 +1,18 @@
+/* Host stand-in for the EEPROM library (RAM backed). */
+#ifndef HOST_EEPROM_H
+#define HOST_EEPROM_H
+
+#include <Arduino.h>
+
+struct EEPROMClass {
+  uint8_t memory[4096];
+  void begin(size_t) {}
+  size_t length() { return sizeof(memory); }
+  uint8_t read(int address) { return memory[address]; }
+  void write(int address, uint8_t value) { memory[address] = value; }
+  void update(int address, uint8_t value) { memory[address] = value; }
+  bool commit() { return true; }
+};
+extern EEPROMClass EEPROM;
+
+#endif
@@ -0,0 +1,98 @@
+/*
+ * Host (Linux) implementation of the simulated Arduino core.
+ */
+#include "HostArduino.h"
+#include <ArduinoJson.h>
+#include <EEPROM.h>
+#include <chrono>
+#include <thread>
+
+HardwareSerial Serial;
+EEPROMClass EEPROM;
+JsonNode hostJsonInvalid;
+volatile uint32_t hostPortRegister = 0xFFFFFFFF;
+
+static bool realTime = false;
+static unsigned long long simulatedMicros = 0;
+static const std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+
+static int modes[HOST_PINS];
+static int written[HOST_PINS];
+static int analogValues[HOST_PINS];
+static void (*handlers[HOST_PINS])(void);
+static int handlerModes[HOST_PINS];
+static int interruptsDisabled = 0;
+
+void hostUseRealTime(bool real) { realTime = real; }
+void hostSetTime(unsigned long ms) { simulatedMicros = (unsigned long long)ms * 1000; }
+void hostAdvance(unsigned long ms) { simulatedMicros += (unsigned long long)ms * 1000; }
+void hostAdvanceMicros(unsigned long us) { simulatedMicros += us; }
+
+unsigned long micros() {
+  if(realTime){
+    return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started).count();
+  }
+  return (unsigned long)simulatedMicros;
+}
+unsigned long millis() {
+  if(realTime){
+    return (unsigned long)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started).count();
+  }
+  return (unsigned long)(simulatedMicros / 1000);
+}
+void delay(unsigned long ms) {
+  if(realTime) std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+  else hostAdvance(ms);
+}
+void delayMicroseconds(unsigned int us) {
+  if(realTime) std::this_thread::sleep_for(std::chrono::microseconds(us));
+  else hostAdvanceMicros(us);
+}
+void yield() {}
+
+void pinMode(int pin, int mode) {
+  if(pin >= 0 && pin < HOST_PINS) modes[pin] = mode;
+}
+int hostPinMode(int pin) {
+  return (pin >= 0 && pin < HOST_PINS) ? modes[pin] : -1;
+}
+int digitalRead(int pin) {
+  if(pin < 0 || pin >= HOST_PINS) return LOW;
+  return (hostPortRegister >> pin) & 1;
+}
+void digitalWrite(int pin, int value) {
+  if(pin >= 0 && pin < HOST_PINS) written[pin] = value;
+}
+int hostPinWritten(int pin) {
+  return (pin >= 0 && pin < HOST_PINS) ? written[pin] : -1;
+}
+int analogRead(int pin) {
+  return (pin >= 0 && pin < HOST_PINS) ? analogValues[pin] : 0;
+}
+void hostSetAnalog(int pin, int value) {
+  if(pin >= 0 && pin < HOST_PINS) analogValues[pin] = value;
+}
+
+void attachInterrupt(int interrupt, void (*handler)(void), int mode) {
+  if(interrupt < 0 || interrupt >= HOST_PINS) return;
+  handlers[interrupt] = handler;
+  handlerModes[interrupt] = mode;
+}
+void detachInterrupt(int interrupt) {
+  if(interrupt >= 0 && interrupt < HOST_PINS) handlers[interrupt] = NULL;
+}
+bool hostInterruptAttached(int pin) {
+  return pin >= 0 && pin < HOST_PINS && handlers[pin] != NULL;
+}
+void noInterrupts() { interruptsDisabled++; }
+void interrupts() { if(interruptsDisabled > 0) interruptsDisabled--; }
+
+void hostSetPin(int pin, int level) {
+  if(pin < 0 || pin >= HOST_PINS) return;
+  int previous = digitalRead(pin);
+  if(level) hostPortRegister |= (1UL << pin);
+  else hostPortRegister &= ~(1UL << pin);
+  if(previous == level || handlers[pin] == NULL || interruptsDisabled) return;
+  int mode = handlerModes[pin];
+  if(mode == CHANGE || (mode == RISING && level) || (mode == FALLING && !level)) handlers[pin]();
+}
@@ -0,0 +1,31 @@
+/*
+ * Host test controls for the simulated Arduino core in 'Arduino.h'.
+ *
+ * Time is simulated by default: 'millis()' / 'micros()' only move when
+ * a test calls 'hostAdvance()' (or the code under test calls
+ * 'delay()').  Tests talking to real sockets switch to the real clock
+ * with 'hostUseRealTime(true)'.
+ *
+ * Pins 0..31 are bits of one simulated input port register; setting a
+ * pin level fires the interrupt handler attached to it (if interrupts
+ * are enabled and the edge matches the interrupt mode).
+ */
+#ifndef HOST_ARDUINO_CONTROL_H
+#define HOST_ARDUINO_CONTROL_H
+
+#include <Arduino.h>
+
+/* CLOCK */
+void hostUseRealTime(bool real);
+void hostSetTime(unsigned long ms);
+void hostAdvance(unsigned long ms);
+void hostAdvanceMicros(unsigned long us);
+
+/* PINS (INPUT_PULLUP PINS READ HIGH UNTIL SET) */
+void hostSetPin(int pin, int level);
+void hostSetAnalog(int pin, int value);
+int hostPinMode(int pin);
+int hostPinWritten(int pin);
+bool hostInterruptAttached(int pin);
+
+#endif
@@ -0,0 +1,97 @@
+/*
+ * Gateway emulator child process for the host tests.
+ */
+#include "HostEmulator.h"
+#include <ArduinoJson.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <fstream>
+#include <chrono>
+#include <thread>
+
+#ifndef HOST_EMULATOR_SCRIPT
+#define HOST_EMULATOR_SCRIPT "../MonocleGatewayEmulator/monocle_gateway_emulator.py"
+#endif
+
+uint16_t HostEmulator::freePort(bool udp) {
+  int fd = socket(AF_INET, udp ? SOCK_DGRAM : SOCK_STREAM, 0);
+  struct sockaddr_in address;
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  bind(fd, (struct sockaddr*)&address, sizeof(address));
+  socklen_t length = sizeof(address);
+  getsockname(fd, (struct sockaddr*)&address, &length);
+  close(fd);
+  return ntohs(address.sin_port);
+}
+
+bool HostEmulator::start(const std::vector<std::string>& arguments) {
+  port = freePort();
+  char name[64];
+  snprintf(name, sizeof(name), "/tmp/monocle-host-emulator-%d-%u.jsonl", (int)getpid(), port);
+  log = name;
+  unlink(log.c_str());
+
+  std::vector<std::string> args = { "python3", HOST_EMULATOR_SCRIPT, "--host", "127.0.0.1",
+                                    "--port", std::to_string(port), "--log", log, "--quiet" };
+  args.insert(args.end(), arguments.begin(), arguments.end());
+  pid = fork();
+  if(pid == 0){
+    std::vector<char*> argv;
+    for(size_t i = 0; i < args.size(); i++) argv.push_back((char*)args[i].c_str());
+    argv.push_back(NULL);
+    freopen("/dev/null", "w", stdout);
+    execvp("python3", argv.data());
+    _exit(127);
+  }
+
+  // wait (up to 5 seconds) until the web-socket port accepts connections
+  for(int attempt = 0; attempt < 500; attempt++){
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    bool up = ::connect(fd, (struct sockaddr*)&address, sizeof(address)) == 0;
+    close(fd);
+    if(up) return true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  kill();
+  return false;
+}
+
+void HostEmulator::kill() {
+  if(pid <= 0) return;
+  ::kill(pid, SIGKILL);
+  waitpid(pid, NULL, 0);
+  pid = -1;
+}
+
+std::vector<HostEmulatorCommand> HostEmulator::commands(bool all) const {
+  std::vector<HostEmulatorCommand> result;
+  std::ifstream file(log.c_str());
+  std::string line;
+  while(std::getline(file, line)){
+    DynamicJsonBuffer buffer;
+    JsonObject& entry = buffer.parseObject(line.c_str());
+    if(!entry.success() || !entry.containsKey("raw")) continue;
+    HostEmulatorCommand command;
+    command.time = entry.get<double>("time");
+    command.client = entry["client"].as<const char*>();
+    command.raw = entry["raw"].as<const char*>();
+    command.status = entry["status"].as<const char*>();
+    const char* camera = entry["camera"].as<const char*>();
+    command.camera = camera ? camera : "";
+    const char* name = entry["command"].as<const char*>();
+    command.command = name ? name : "";
+    if(all || command.status == "ok") result.push_back(command);
+  }
+  return result;
+}
@@ -0,0 +1,41 @@
+/*
+ * Runs the Monocle Gateway emulator ('extras/MonocleGatewayEmulator')
+ * as a child process on a free local port and reads back the commands
+ * it logged (one JSON line per received command).
+ */
+#ifndef HOST_EMULATOR_H
+#define HOST_EMULATOR_H
+
+#include <string>
+#include <vector>
+
+struct HostEmulatorCommand {
+  double time;             // seconds since the emulator started
+  std::string client;      // connection name
+  std::string raw;         // text as received
+  std::string status;      // "ok", "lost" or "invalid"
+  std::string camera;      // '@<uuid>:' prefix (empty for the active camera)
+  std::string command;     // parsed command name
+};
+
+class HostEmulator {
+    int pid = -1;
+    std::string log;
+  public:
+    uint16_t port = 0;
+    ~HostEmulator() { kill(); }
+
+    /* START THE EMULATOR WITH EXTRA COMMAND LINE ARGUMENTS; WAITS UNTIL IT ACCEPTS CONNECTIONS */
+    bool start(const std::vector<std::string>& arguments = std::vector<std::string>());
+
+    /* STOP THE EMULATOR ABRUPTLY (SIGKILL: CONNECTIONS ARE RESET, NOTHING IS FLUSHED) */
+    void kill();
+
+    /* COMMANDS LOGGED SO FAR (ONLY 'ok' ENTRIES UNLESS 'all') */
+    std::vector<HostEmulatorCommand> commands(bool all = false) const;
+
+    /* A FREE LOCAL TCP/UDP PORT */
+    static uint16_t freePort(bool udp = false);
+};
+
+#endif
@@ -0,0 +1,250 @@
+/*
+ * Host network clients (POSIX sockets and the in-memory gateway).
+ */
+#include "HostNetwork.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/* --- TCP ------------------------------------------------------------ */
+
+int HostTcpClient::connect(IPAddress ip, uint16_t port) {
+  char host[16];
+  snprintf(host, sizeof(host), "%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+  return connect(host, port);
+}
+
+int HostTcpClient::connect(const char* host, uint16_t port) {
+  stop();
+  connects++;
+  struct addrinfo hints, *result;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  char service[8];
+  snprintf(service, sizeof(service), "%u", port);
+  if(getaddrinfo(host, service, &hints, &result) != 0) return 0;
+  fd = socket(AF_INET, SOCK_STREAM, 0);
+  fcntl(fd, F_SETFL, O_NONBLOCK);
+  int on = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+  int rc = ::connect(fd, result->ai_addr, result->ai_addrlen);
+  freeaddrinfo(result);
+  if(rc != 0 && errno == EINPROGRESS){
+    struct pollfd p = { fd, POLLOUT, 0 };
+    int error = 0;
+    socklen_t length = sizeof(error);
+    if(poll(&p, 1, (int)connectTimeout) == 1 && getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length) == 0 && error == 0) rc = 0;
+  }
+  if(rc != 0){ stop(); return 0; }
+  return 1;
+}
+
+void HostTcpClient::fill() {
+  if(fd < 0) return;
+  char data[2048];
+  ssize_t n;
+  while((n = recv(fd, data, sizeof(data), MSG_DONTWAIT)) > 0) buffer.append(data, n);
+  if(n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)){ close(fd); fd = -1; }
+}
+
+uint8_t HostTcpClient::connected() {
+  fill();
+  return fd >= 0 || !buffer.empty();
+}
+
+void HostTcpClient::stop() {
+  if(fd >= 0) close(fd);
+  fd = -1;
+  buffer.clear();
+}
+
+size_t HostTcpClient::write(const uint8_t* data, size_t size) {
+  size_t sent = 0;
+  while(fd >= 0 && sent < size){
+    ssize_t n = send(fd, data + sent, size - sent, MSG_NOSIGNAL);
+    if(n > 0) { sent += n; continue; }
+    if(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)){ struct pollfd p = { fd, POLLOUT, 0 }; poll(&p, 1, 100); continue; }
+    close(fd);
+    fd = -1;
+  }
+  return sent;
+}
+
+int HostTcpClient::available() {
+  fill();
+  return (int)buffer.size();
+}
+
+int HostTcpClient::read() {
+  if(buffer.empty()) fill();
+  if(buffer.empty()) return -1;
+  uint8_t c = (uint8_t)buffer[0];
+  buffer.erase(0, 1);
+  return c;
+}
+
+int HostTcpClient::peek() {
+  if(buffer.empty()) fill();
+  return buffer.empty() ? -1 : (uint8_t)buffer[0];
+}
+
+/* --- UDP ------------------------------------------------------------ */
+
+uint8_t HostUdp::begin(uint16_t port) {
+  stop();
+  fd = socket(AF_INET, SOCK_DGRAM, 0);
+  int on = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  setsockopt(fd, SOL_SOCKET, SO_BROADCAST, &on, sizeof(on));
+  struct sockaddr_in local;
+  memset(&local, 0, sizeof(local));
+  local.sin_family = AF_INET;
+  local.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  local.sin_port = htons(port);
+  if(bind(fd, (struct sockaddr*)&local, sizeof(local)) != 0){ stop(); return 0; }
+  fcntl(fd, F_SETFL, O_NONBLOCK);
+  return 1;
+}
+
+void HostUdp::stop() {
+  if(fd >= 0) close(fd);
+  fd = -1;
+}
+
+int HostUdp::beginPacket(IPAddress ip, uint16_t port) {
+  // broadcasts stay on the loopback interface
+  destination = (ip == IPAddress(255, 255, 255, 255)) ? IPAddress(127, 0, 0, 1) : ip;
+  destinationPort = (port == redirectFrom && redirectTo != 0) ? redirectTo : port;
+  outgoing.clear();
+  return 1;
+}
+
+int HostUdp::beginPacket(const char* host, uint16_t port) {
+  IPAddress ip;
+  if(!ip.fromString(host)) ip = IPAddress(127, 0, 0, 1);
+  return beginPacket(ip, port);
+}
+
+int HostUdp::endPacket() {
+  if(fd < 0) return 0;
+  struct sockaddr_in remote;
+  memset(&remote, 0, sizeof(remote));
+  remote.sin_family = AF_INET;
+  memcpy(&remote.sin_addr.s_addr, destination.b, 4);
+  remote.sin_port = htons(destinationPort);
+  return sendto(fd, outgoing.data(), outgoing.size(), 0, (struct sockaddr*)&remote, sizeof(remote)) >= 0;
+}
+
+int HostUdp::parsePacket() {
+  if(fd < 0) return 0;
+  char data[512];
+  struct sockaddr_in remote;
+  socklen_t length = sizeof(remote);
+  ssize_t n = recvfrom(fd, data, sizeof(data), MSG_DONTWAIT, (struct sockaddr*)&remote, &length);
+  if(n <= 0) return 0;
+  incoming.assign(data, n);
+  position = 0;
+  memcpy(source.b, &remote.sin_addr.s_addr, 4);
+  sourcePort = ntohs(remote.sin_port);
+  return (int)n;
+}
+
+int HostUdp::read(unsigned char* data, size_t length) {
+  size_t n = 0;
+  while(n < length && position < incoming.size()) data[n++] = (uint8_t)incoming[position++];
+  return (int)n;
+}
+
+/* --- IN-MEMORY GATEWAY ---------------------------------------------- */
+
+int HostLoopbackGateway::connect(const char*, uint16_t) {
+  connects++;
+  if(!reachable) return 0;
+  open = true;
+  upgraded = false;
+  received.clear();
+  queue.clear();
+  deliverable.clear();
+  return 1;
+}
+
+void HostLoopbackGateway::drop() {
+  open = false;
+  queue.clear();
+  deliverable.clear();
+}
+
+void HostLoopbackGateway::frame(int opcode, const std::string& payload, unsigned long delay) {
+  std::string bytes;
+  bytes += (char)(0x80 | opcode);
+  if(payload.size() < 126) bytes += (char)payload.size();
+  else { bytes += (char)126; bytes += (char)(payload.size() >> 8); bytes += (char)(payload.size() & 0xFF); }
+  bytes += payload;
+  queue.push_back(std::make_pair(millis() + delay, bytes));
+}
+
+void HostLoopbackGateway::push(const std::string& text) {
+  if(open) frame(0x1, text, latency);
+}
+
+size_t HostLoopbackGateway::write(const uint8_t* data, size_t size) {
+  if(!open) return 0;
+  received.append((const char*)data, size);
+  parse();
+  return size;
+}
+
+/* UPGRADE THE CONNECTION, THEN DECODE THE (MASKED) CLIENT FRAMES */
+void HostLoopbackGateway::parse() {
+  if(!upgraded){
+    size_t end = received.find("\r\n\r\n");
+    if(end == std::string::npos) return;
+    received.erase(0, end + 4);
+    upgraded = true;
+    queue.push_back(std::make_pair(millis(), std::string("HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n\r\n")));
+  }
+  while(received.size() >= 6){
+    size_t length = (uint8_t)received[1] & 0x7F;
+    size_t offset = 2;
+    if(length == 126){ if(received.size() < 8) return; length = ((uint8_t)received[2] << 8) | (uint8_t)received[3]; offset = 4; }
+    if(received.size() < offset + 4 + length) return;
+    std::string payload = received.substr(offset + 4, length);
+    for(size_t i = 0; i < payload.size(); i++) payload[i] ^= received[offset + (i & 3)];
+    int opcode = (uint8_t)received[0] & 0x0F;
+    received.erase(0, offset + 4 + length);
+    if(opcode == 0x1){ commands.push_back(payload); commandTimes.push_back(millis()); }
+    else if(opcode == 0x9){ pings++; if(answerPings) frame(0xA, payload, latency); }
+    else if(opcode == 0x8){ open = false; }
+  }
+}
+
+void HostLoopbackGateway::deliver() {
+  while(!queue.empty() && (long)(millis() - queue.front().first) >= 0){
+    deliverable += queue.front().second;
+    queue.pop_front();
+  }
+}
+
+int HostLoopbackGateway::available() {
+  if(!open) return 0;
+  deliver();
+  return (int)deliverable.size();
+}
+
+int HostLoopbackGateway::read() {
+  if(available() == 0) return -1;
+  uint8_t c = (uint8_t)deliverable[0];
+  deliverable.erase(0, 1);
+  return c;
+}
+
+int HostLoopbackGateway::peek() {
+  return available() ? (uint8_t)deliverable[0] : -1;
+}
@@ -0,0 +1,108 @@
+/*
+ * Host network clients for the host tests:
+ *
+ *  'HostTcpClient'       - Arduino 'Client' over a POSIX TCP socket
+ *                          (talks to the gateway emulator)
+ *  'HostUdp'             - Arduino 'UDP' over a POSIX UDP socket;
+ *                          broadcasts go to the loopback interface and
+ *                          destination ports can be redirected
+ *  'HostLoopbackGateway' - Arduino 'Client' connected to an in-memory
+ *                          gateway that records the text commands it
+ *                          receives, answers pings after a configurable
+ *                          (simulated) latency and pushes messages
+ */
+#ifndef HOST_NETWORK_H
+#define HOST_NETWORK_H
+
+#include <Arduino.h>
+#include <Udp.h>
+#include <string>
+#include <vector>
+#include <deque>
+
+class HostTcpClient : public Client {
+    int fd = -1;
+    std::string buffer;
+    void fill();
+  public:
+    unsigned long connectTimeout = 1000;   // milliseconds
+    unsigned long connects = 0;            // connection attempts
+    ~HostTcpClient() { stop(); }
+    int connect(IPAddress ip, uint16_t port);
+    int connect(const char* host, uint16_t port);
+    uint8_t connected();
+    void stop();
+    size_t write(uint8_t c) { return write(&c, 1); }
+    size_t write(const uint8_t* data, size_t size);
+    using Print::write;
+    int available();
+    int read();
+    int peek();
+    using Client::read;
+};
+
+class HostUdp : public UDP {
+    int fd = -1;
+    std::string outgoing;
+    std::string incoming;
+    size_t position = 0;
+    IPAddress destination;
+    uint16_t destinationPort = 0;
+    IPAddress source;
+    uint16_t sourcePort = 0;
+  public:
+    uint16_t redirectFrom = 0, redirectTo = 0;   // destination port redirection
+    ~HostUdp() { stop(); }
+    uint8_t begin(uint16_t port);
+    void stop();
+    int beginPacket(IPAddress ip, uint16_t port);
+    int beginPacket(const char* host, uint16_t port);
+    int endPacket();
+    size_t write(uint8_t c) { outgoing += (char)c; return 1; }
+    size_t write(const uint8_t* data, size_t size) { outgoing.append((const char*)data, size); return size; }
+    using Print::write;
+    int parsePacket();
+    int available() { return (int)(incoming.size() - position); }
+    int read() { return position < incoming.size() ? (uint8_t)incoming[position++] : -1; }
+    int read(unsigned char* data, size_t length);
+    int peek() { return position < incoming.size() ? (uint8_t)incoming[position] : -1; }
+    using UDP::read;
+    IPAddress remoteIP() { return source; }
+    uint16_t remotePort() { return sourcePort; }
+};
+
+class HostLoopbackGateway : public Client {
+    bool open = false;
+    bool upgraded = false;
+    std::string received;                                     // bytes from the client
+    std::deque<std::pair<unsigned long, std::string> > queue; // (due time, bytes) to the client
+    std::string deliverable;
+    void deliver();
+    void frame(int opcode, const std::string& payload, unsigned long delay);
+    void parse();
+  public:
+    bool reachable = true;          // connection attempts succeed
+    bool answerPings = true;        // pongs are sent (a stalled gateway does not answer)
+    unsigned long latency = 0;      // milliseconds before a pong or pushed message arrives
+    unsigned long connects = 0;
+    std::vector<std::string> commands;       // text messages received
+    std::vector<unsigned long> commandTimes; // 'millis()' when each was received
+    unsigned long pings = 0;
+
+    void push(const std::string& text);      // send a text message to the client
+    void drop();                             // the connection is lost
+
+    int connect(IPAddress, uint16_t) { return connect("", 0); }
+    int connect(const char*, uint16_t);
+    uint8_t connected() { return open; }
+    void stop() { open = false; }
+    size_t write(uint8_t c) { return write(&c, 1); }
+    size_t write(const uint8_t* data, size_t size);
+    using Print::write;
+    int available();
+    int read();
+    int peek();
+    using Client::read;
+};
+
+#endif
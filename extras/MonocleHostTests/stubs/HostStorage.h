@@ -0,0 +1,33 @@
+/*
+ * RAM backed 'MonocleStorage' for the host tests; counts the writes
+ * and commits (each commit of the flash storage rewrites the region).
+ */
+#ifndef HOST_STORAGE_H
+#define HOST_STORAGE_H
+
+#include "MonocleStorage.h"
+
+class HostStorage : public MonocleStorage {
+    uint8_t memory[4096];
+    size_t capacity;
+  public:
+    unsigned long writes = 0;
+    unsigned long commits = 0;
+    HostStorage(size_t capacity = 512) : capacity(capacity < sizeof(memory) ? capacity : sizeof(memory)) { memset(memory, 0xFF, sizeof(memory)); }
+    size_t size() { return capacity; }
+    bool read(size_t address, void* data, size_t length) {
+      if(address + length > capacity) return false;
+      memcpy(data, memory + address, length);
+      return true;
+    }
+    bool write(size_t address, const void* data, size_t length) {
+      if(address + length > capacity) return false;
+      memcpy(memory + address, data, length);
+      writes++;
+      return true;
+    }
+    bool commit() { commits++; return true; }
+    void wipe() { memset(memory, 0xFF, sizeof(memory)); }
+};
+
+#endif
@@ -0,0 +1,4 @@
+#include "HostTest.h"
+
+int hostChecks = 0;
+int hostFailures = 0;
@@ -0,0 +1,39 @@
+/*
+ * Minimal checks for the host tests: each failed check is printed with
+ * its location; 'hostTestResult()' prints a summary line and returns
+ * the process exit code.
+ */
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <stdio.h>
+
+extern int hostChecks;
+extern int hostFailures;
+
+#define CHECK(condition) hostCheck((condition), #condition, __FILE__, __LINE__)
+#define CHECK_EQ(actual, expected) hostCheckEqual((long)(actual), (long)(expected), #actual, __FILE__, __LINE__)
+#define CHECK_RANGE(actual, low, high) hostCheckRange((long)(actual), (long)(low), (long)(high), #actual, __FILE__, __LINE__)
+
+inline bool hostCheck(bool passed, const char* text, const char* file, int line) {
+  hostChecks++;
+  if(!passed){ hostFailures++; printf("%s:%d: FAILED: %s\n", file, line, text); }
+  return passed;
+}
+inline bool hostCheckEqual(long actual, long expected, const char* text, const char* file, int line) {
+  hostChecks++;
+  if(actual != expected){ hostFailures++; printf("%s:%d: FAILED: %s == %ld (expected %ld)\n", file, line, text, actual, expected); }
+  return actual == expected;
+}
+inline bool hostCheckRange(long actual, long low, long high, const char* text, const char* file, int line) {
+  hostChecks++;
+  bool passed = actual >= low && actual <= high;
+  if(!passed){ hostFailures++; printf("%s:%d: FAILED: %s == %ld (expected %ld..%ld)\n", file, line, text, actual, low, high); }
+  return passed;
+}
+inline int hostTestResult(const char* name) {
+  printf("%-24s %s (%d checks, %d failed)\n", name, hostFailures ? "FAIL" : "ok", hostChecks, hostFailures);
+  return hostFailures ? 1 : 0;
+}
+
+#endif
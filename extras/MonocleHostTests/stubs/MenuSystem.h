@@ -0,0 +1,121 @@
+/*
+ * Host stand-in for the arduino-menusystem library (the navigation
+ * subset used by MonocleMenu: current item, next/prev, select into a
+ * sub-menu and back).
+ */
+#ifndef HOST_MENU_SYSTEM_H
+#define HOST_MENU_SYSTEM_H
+
+#include <Arduino.h>
+
+class Menu;
+class MenuItem;
+class BackMenuItem;
+class NumericMenuItem;
+class MenuSystem;
+
+class MenuComponentRenderer {
+  public:
+    virtual void render(Menu const& menu) const = 0;
+    virtual void render_menu_item(MenuItem const& menu_item) const = 0;
+    virtual void render_back_menu_item(BackMenuItem const& menu_item) const = 0;
+    virtual void render_numeric_menu_item(NumericMenuItem const& menu_item) const = 0;
+    virtual void render_menu(Menu const& menu) const = 0;
+};
+
+class MenuComponent {
+    friend class MenuSystem;
+    friend class Menu;
+  public:
+    typedef void (*SelectFnPtr)(MenuComponent* menu_component);
+    MenuComponent(const char* name, SelectFnPtr select_fn) : _name(name), _select_fn(select_fn) {}
+    virtual ~MenuComponent() {}
+    virtual void render(MenuComponentRenderer const& renderer) const = 0;
+    const char* get_name() const { return _name; }
+    void set_name(const char* name) { _name = name; }
+    bool is_current() const { return _is_current; }
+    virtual bool is_menu() const = 0;
+  protected:
+    virtual Menu* select() = 0;
+    const char* _name;
+    bool _is_current = false;
+    SelectFnPtr _select_fn;
+};
+
+class MenuItem : public MenuComponent {
+  public:
+    MenuItem(const char* name, SelectFnPtr select_fn) : MenuComponent(name, select_fn) {}
+    virtual void render(MenuComponentRenderer const& renderer) const { renderer.render_menu_item(*this); }
+    virtual bool is_menu() const { return false; }
+  protected:
+    virtual Menu* select() { if(_select_fn) _select_fn(this); return NULL; }
+};
+
+class BackMenuItem : public MenuItem {
+  public:
+    BackMenuItem(const char* name, SelectFnPtr select_fn, MenuSystem* menu_system) : MenuItem(name, select_fn), menu_system(menu_system) {}
+  protected:
+    virtual Menu* select();
+    MenuSystem* menu_system;
+};
+
+class NumericMenuItem : public MenuItem {
+  public:
+    NumericMenuItem(const char* name, SelectFnPtr select_fn) : MenuItem(name, select_fn) {}
+};
+
+class Menu : public MenuComponent {
+    friend class MenuSystem;
+  public:
+    Menu(const char* name, SelectFnPtr select_fn = NULL) : MenuComponent(name, select_fn) {}
+    void add_item(MenuItem* item) { add_component(item); }
+    void add_menu(Menu* menu) { add_component(menu); menu->_parent = this; }
+    MenuComponent const* get_current_component() const { return _components ? _components[_current] : NULL; }
+    MenuComponent const* get_menu_component(uint8_t index) const { return _components[index]; }
+    uint8_t get_num_components() const { return _count; }
+    uint8_t get_current_component_num() const { return _current; }
+    void render(MenuComponentRenderer const& renderer) const { renderer.render_menu(*this); }
+    virtual bool is_menu() const { return true; }
+  protected:
+    void add_component(MenuComponent* component) {
+      _components = (MenuComponent**)realloc(_components, (_count + 1) * sizeof(MenuComponent*));
+      _components[_count++] = component;
+      if(_count == 1) component->_is_current = true;
+    }
+    bool next() { if(_current + 1 >= _count) return false; move(_current + 1); return true; }
+    bool prev() { if(_current == 0) return false; move(_current - 1); return true; }
+    void reset() { if(_count) move(0); }
+    void move(uint8_t index) { _components[_current]->_is_current = false; _current = index; _components[_current]->_is_current = true; }
+    virtual Menu* select() { return this; }
+    Menu* _parent = NULL;
+  private:
+    MenuComponent** _components = NULL;
+    uint8_t _count = 0;
+    uint8_t _current = 0;
+};
+
+class MenuSystem {
+  public:
+    MenuSystem(MenuComponentRenderer const& renderer) : _renderer(renderer), _root("", NULL) { _current = &_root; }
+    void display() const { _renderer.render(*_current); }
+    bool next(bool = false) { return _current->next(); }
+    bool prev(bool = false) { return _current->prev(); }
+    void reset() { _current = &_root; _root.reset(); }
+    void select(bool = false) {
+      MenuComponent* component = (MenuComponent*)_current->get_current_component();
+      if(component == NULL) return;
+      Menu* menu = component->select();
+      if(menu != NULL && component->is_menu()){ menu->reset(); _current = menu; }
+    }
+    bool back() { if(_current->_parent == NULL) return false; _current = _current->_parent; return true; }
+    Menu& get_root_menu() const { return const_cast<Menu&>(_root); }
+    Menu const* get_current_menu() const { return _current; }
+  private:
+    MenuComponentRenderer const& _renderer;
+    Menu _root;
+    Menu* _current;
+};
+
+inline Menu* BackMenuItem::select() { menu_system->back(); return NULL; }
+
+#endif
@@ -0,0 +1,25 @@
+/*
+ * Host stand-in for the Arduino 'UDP' interface ('HostUdp' in
+ * 'HostNetwork.h' implements it with POSIX sockets).
+ */
+#ifndef HOST_UDP_H
+#define HOST_UDP_H
+
+#include <Arduino.h>
+
+class UDP : public Stream {
+  public:
+    virtual uint8_t begin(uint16_t port) = 0;
+    virtual void stop() = 0;
+    virtual int beginPacket(IPAddress ip, uint16_t port) = 0;
+    virtual int beginPacket(const char* host, uint16_t port) = 0;
+    virtual int endPacket() = 0;
+    virtual int parsePacket() = 0;
+    virtual int read(unsigned char* buffer, size_t length) = 0;
+    virtual int read(char* buffer, size_t length) { return read((unsigned char*)buffer, length); }
+    virtual IPAddress remoteIP() = 0;
+    virtual uint16_t remotePort() = 0;
+    using Stream::read;
+};
+
+#endif
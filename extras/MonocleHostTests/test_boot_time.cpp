@@ -0,0 +1,109 @@
+/*
+ * MonocleSnapshot boot benchmark: time from power-up to the first usable
+ * input (the joystick is deflected during boot and its PTZ event reaches
+ * a known, PTZ capable camera).  A first boot calibrates the joystick
+ * and waits for the Wi-Fi join, the gateway connection and the first
+ * 'source' message; a boot with a saved snapshot restores the camera
+ * and calibration and is usable at once while the network comes up.
+ * The Wi-Fi join time is an assumed figure for a WPA2 join, the gateway
+ * is the in-process loopback gateway on the simulated clock.
+ */
+#include <HostArduino.h>
+#include <HostTest.h>
+#include <HostNetwork.h>
+#include <HostStorage.h>
+#include <chrono>
+#include "MonocleSnapshot.h"
+
+#define PIN_PAN  1
+#define PIN_TILT 2
+#define PIN_ZOOM 3
+
+#define WIFI_JOIN_TIME  2500   // milliseconds (assumed)
+#define GATEWAY_LATENCY 30     // milliseconds
+#define SOURCE "{\"source\":{\"uuid\":\"camera-1\",\"name\":\"Lobby\",\"manufacturer\":\"Acme\",\"model\":\"PTZ-1\",\"ptz\":true}}"
+
+static unsigned long ptzTime = 0;
+
+static void onPTZ(int pan, int tilt, int zoom) {
+  if(ptzTime == 0 && pan != 0) ptzTime = millis();
+}
+
+/*
+ * BOOT THE CONTROLLER THE WAY THE DELUXE MKR1000 EXAMPLE DOES AND RETURN THE
+ * TIME TO THE FIRST USABLE INPUT; 'restoreTime' RECEIVES THE CPU TIME OF THE
+ * SNAPSHOT RESTORE OR CALIBRATION (MICROSECONDS)
+ */
+static unsigned long boot(HostStorage& storage, bool* restored, double* restoreTime) {
+  hostSetAnalog(PIN_PAN, 2048);
+  hostSetAnalog(PIN_TILT, 2010);
+  hostSetAnalog(PIN_ZOOM, 2090);
+  unsigned long start = millis();
+  unsigned long usableTime = 0;
+  ptzTime = 0;
+
+  HostLoopbackGateway gateway;
+  gateway.latency = GATEWAY_LATENCY;
+  MonocleGatewayClient monocle(gateway, "127.0.0.1", 8080);
+  MonoclePTZJoystick joystick;
+  joystick.setupPan(PIN_PAN, 12);
+  joystick.setupTilt(PIN_TILT, 12);
+  joystick.setupZoom(PIN_ZOOM, 12);
+  joystick.onPTZ(onPTZ);
+
+  MonocleSnapshot snapshot(storage);
+  std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+  *restored = snapshot.restore();
+  if(*restored){
+    snapshot.restoreCalibration(joystick);
+    snapshot.restoreCamera(monocle);
+  }
+  else {
+    joystick.calibrate();
+    snapshot.setCalibration(joystick);
+  }
+  *restoreTime = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+
+  // the user pushes the joystick right away; the network comes up in the background
+  hostSetAnalog(PIN_PAN, 4095);
+  bool connected = false;
+  while(usableTime == 0 && millis() - start < 10000){
+    if(!connected && millis() - start >= WIFI_JOIN_TIME){
+      monocle.begin();
+      connected = monocle.connected();
+      gateway.push(SOURCE);
+    }
+    if(connected) monocle.loop();
+    joystick.loop();
+    if(ptzTime != 0 && monocle.isCameraEnabled()) usableTime = millis();
+    else hostAdvance(1);
+  }
+
+  // persist the snapshot for the next boot
+  snapshot.setCamera(monocle.activeCameraSource());
+  snapshot.save();
+  return usableTime - start;
+}
+
+int main() {
+  hostSetTime(1000);
+  HostStorage storage;
+
+  // first boot after an upload: no snapshot
+  bool restored;
+  double coldCpu, warmCpu;
+  unsigned long cold = boot(storage, &restored, &coldCpu);
+  CHECK(!restored);
+  CHECK_RANGE(cold, WIFI_JOIN_TIME, WIFI_JOIN_TIME + GATEWAY_LATENCY + 2 * JOYSTICK_DEFAULT_PTZ_EVENT_DELAY);
+
+  // every later boot restores the snapshot and is usable before the network is up
+  unsigned long warm = boot(storage, &restored, &warmCpu);
+  CHECK(restored);
+  CHECK_RANGE(warm, 0, 2 * JOYSTICK_DEFAULT_PTZ_EVENT_DELAY);
+  CHECK(warm < cold);
+  CHECK_EQ(storage.commits, 1);   // the second boot saved nothing new
+
+  printf("boot_time: first usable input %lu ms without a snapshot (calibration %.1f us), %lu ms with one (restore %.1f us)\n",
+         cold, coldCpu, warm, warmCpu);
+  return hostTestResult("boot_time");
+}
@@ -0,0 +1,177 @@
+/*
+ * MonocleDigitalPad: bounce-laden pin traces (contact chatter on press
+ * and release, short glitches) produce exactly one PTZ or gesture event
+ * per real transition, within the debounce latency, and the hold-to-
+ * accelerate ramp and fire button gestures follow the configured times.
+ */
+#include <HostArduino.h>
+#include <HostTest.h>
+#include "MonocleDigitalPad.h"
+
+#define PIN_UP    2
+#define PIN_DOWN  3
+#define PIN_LEFT  4
+#define PIN_RIGHT 5
+#define PIN_FIRE  6
+
+/* ONE PIN LEVEL CHANGE OF A TRACE (ACTIVE LOW; 0 = CONTACT CLOSED) */
+struct Edge {
+  unsigned long time;
+  int pin;
+  int level;
+};
+
+struct PTZRecord {
+  unsigned long time;
+  int pan, tilt, zoom;
+};
+
+static PTZRecord ptz[64];
+static int ptzCount = 0;
+static unsigned long presses = 0, doubleClicks = 0, longPresses = 0;
+static unsigned long pressTime = 0, longPressTime = 0;
+
+static void onPTZ(int pan, int tilt, int zoom) {
+  if(ptzCount < 64){ PTZRecord record = { millis(), pan, tilt, zoom }; ptz[ptzCount++] = record; }
+}
+static void onPress() { presses++; pressTime = millis(); }
+static void onDoubleClick() { doubleClicks++; }
+static void onLongPress() { longPresses++; longPressTime = millis(); }
+
+/* DETERMINISTIC CONTACT CHATTER: 'toggles' LEVEL CHANGES 1..2 MS APART ENDING AT 'level' */
+static unsigned long seed = 12345;
+static int bounce(Edge* trace, int count, unsigned long time, int pin, int level, int toggles) {
+  for(int i = 0; i < toggles; i++){
+    seed = seed * 1103515245UL + 12345UL;
+    Edge edge = { time, pin, (i % 2 == 0) ? level : !level };
+    trace[count++] = edge;
+    time += 1 + ((seed >> 16) & 1);
+  }
+  Edge settled = { time, pin, level };
+  trace[count++] = settled;
+  return count;
+}
+
+/* REPLAY A TRACE ON THE SIMULATED CLOCK CALLING 'loop()' EVERY MILLISECOND */
+static void replay(MonocleDigitalPad& pad, const Edge* trace, int count, unsigned long duration) {
+  int next = 0;
+  for(unsigned long elapsed = 0; elapsed <= duration; elapsed++){
+    while(next < count && trace[next].time <= elapsed){
+      hostSetPin(trace[next].pin, trace[next].level);
+      next++;
+    }
+    pad.loop();
+    hostAdvance(1);
+  }
+}
+
+static void reset() {
+  ptzCount = 0;
+  presses = doubleClicks = longPresses = 0;
+}
+
+int main() {
+  hostSetTime(1000);
+  MonocleDigitalPad pad;
+  pad.setupPins(PIN_UP, PIN_DOWN, PIN_LEFT, PIN_RIGHT, PIN_FIRE);
+  pad.onPTZ(onPTZ);
+  pad.onButtonPress(onPress);
+  pad.onDoubleClick(onDoubleClick);
+  pad.onLongPress(onLongPress);
+  CHECK_EQ(hostPinMode(PIN_FIRE), INPUT_PULLUP);
+
+  // a direction pressed and released with 7 toggles of chatter on each edge:
+  // one start and one stop event, each within chatter + 4 samples + 1 sample
+  {
+    Edge trace[32];
+    int count = bounce(trace, 0, 10, PIN_RIGHT, LOW, 7);
+    count = bounce(trace, count, 300, PIN_RIGHT, HIGH, 7);
+    unsigned long start = millis();
+    replay(pad, trace, count, 400);
+    CHECK_EQ(ptzCount, 2);
+    CHECK_EQ(ptz[0].pan, MONOCLE_PAD_DEFAULT_SPEED);
+    CHECK_EQ(ptz[1].pan, 0);
+    unsigned long settle = 12;   // 7 toggles at most 2 ms apart
+    unsigned long bound = settle + 5 * MONOCLE_PAD_DEFAULT_SAMPLE_INTERVAL;
+    CHECK_RANGE(ptz[0].time - (start + 10), 0, bound);
+    CHECK_RANGE(ptz[1].time - (start + 300), 0, bound);
+    printf("digital_pad: press latency %lu ms, release latency %lu ms (bound %lu ms)\n",
+           ptz[0].time - (start + 10), ptz[1].time - (start + 300), bound);
+  }
+
+  // short glitches (a contact touched for 1..3 ms) are rejected
+  {
+    reset();
+    Edge trace[] = {
+      { 10, PIN_LEFT, LOW }, { 11, PIN_LEFT, HIGH },
+      { 50, PIN_UP, LOW }, { 53, PIN_UP, HIGH },
+      { 90, PIN_FIRE, LOW }, { 92, PIN_FIRE, HIGH },
+    };
+    replay(pad, trace, sizeof(trace) / sizeof(trace[0]), 200);
+    CHECK_EQ(ptzCount, 0);
+    CHECK_EQ(presses, 0);
+    CHECK_EQ(pad.buttons(), 0);
+  }
+
+  // two chattering fire clicks 150 ms apart: two presses, one double-click
+  {
+    reset();
+    Edge trace[64];
+    int count = bounce(trace, 0, 10, PIN_FIRE, LOW, 5);
+    count = bounce(trace, count, 60, PIN_FIRE, HIGH, 5);
+    count = bounce(trace, count, 160, PIN_FIRE, LOW, 5);
+    count = bounce(trace, count, 210, PIN_FIRE, HIGH, 5);
+    replay(pad, trace, count, 600);
+    CHECK_EQ(presses, 2);
+    CHECK_EQ(doubleClicks, 1);
+    CHECK_EQ(longPresses, 0);
+  }
+
+  // a chattering hold of the fire button: one press and one long-press
+  {
+    reset();
+    Edge trace[32];
+    int count = bounce(trace, 0, 10, PIN_FIRE, LOW, 9);
+    count = bounce(trace, count, 1500, PIN_FIRE, HIGH, 9);
+    replay(pad, trace, count, 1600);
+    CHECK_EQ(presses, 1);
+    CHECK_EQ(longPresses, 1);
+    CHECK_RANGE(longPressTime - pressTime, MONOCLE_PAD_DEFAULT_LONG_PRESS, MONOCLE_PAD_DEFAULT_LONG_PRESS + MONOCLE_PAD_DEFAULT_SAMPLE_INTERVAL);
+    hostAdvance(MONOCLE_PAD_DEFAULT_DOUBLE_CLICK);
+  }
+
+  // zoom modifier: UP while fire is held zooms instead of tilting (no long-press)
+  {
+    reset();
+    Edge trace[32];
+    int count = bounce(trace, 0, 10, PIN_FIRE, LOW, 3);
+    count = bounce(trace, count, 100, PIN_UP, LOW, 3);
+    count = bounce(trace, count, 1400, PIN_UP, HIGH, 3);
+    count = bounce(trace, count, 1500, PIN_FIRE, HIGH, 3);
+    replay(pad, trace, count, 1600);
+    CHECK_EQ(ptzCount, 2);
+    CHECK_EQ(ptz[0].tilt, 0);
+    CHECK_EQ(ptz[0].zoom, MONOCLE_PAD_DEFAULT_SPEED);
+    CHECK_EQ(ptz[1].zoom, 0);
+    CHECK_EQ(longPresses, 0);
+  }
+
+  // hold-to-accelerate: LOW, then MEDIUM after 300 ms, then HIGH after 800 ms
+  {
+    reset();
+    pad.setAcceleration(300, 800);
+    Edge trace[32];
+    int count = bounce(trace, 0, 10, PIN_LEFT, LOW, 7);
+    count = bounce(trace, count, 1200, PIN_LEFT, HIGH, 7);
+    replay(pad, trace, count, 1300);
+    CHECK_EQ(ptzCount, 4);
+    CHECK_EQ(ptz[0].pan, -MONOCLE_PAD_SPEED_LOW);
+    CHECK_EQ(ptz[1].pan, -MONOCLE_PAD_SPEED_MED);
+    CHECK_EQ(ptz[2].pan, -MONOCLE_PAD_SPEED_HIGH);
+    CHECK_EQ(ptz[3].pan, 0);
+    CHECK_RANGE(ptz[1].time - ptz[0].time, 300, 300 + MONOCLE_PAD_DEFAULT_SAMPLE_INTERVAL);
+    CHECK_RANGE(ptz[2].time - ptz[0].time, 800, 800 + MONOCLE_PAD_DEFAULT_SAMPLE_INTERVAL);
+  }
+
+  return hostTestResult("digital_pad");
+}
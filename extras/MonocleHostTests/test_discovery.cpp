@@ -0,0 +1,94 @@
+/*
+ * MonocleDiscovery against the gateway emulator's UDP responder (on a
+ * free port; the probes are redirected to it): a cached endpoint that no
+ * longer answers is dropped after MONOCLE_DISCOVERY_MAX_MISSES probe
+ * rounds, its storage record is erased, and probes fall back from the
+ * directed probe address (which never answers) to broadcast discovery,
+ * which finds the emulator and caches it.
+ */
+#include <HostArduino.h>
+#include <HostTest.h>
+#include <HostNetwork.h>
+#include <HostEmulator.h>
+#include <HostStorage.h>
+#include "MonocleDiscovery.h"
+
+static int discoveries = 0;
+static unsigned long forgottenTime = 0;
+
+static void onDiscovered(const IPAddress& address, const uint16_t port) {
+  discoveries++;
+}
+
+int main() {
+  hostUseRealTime(true);
+  uint16_t responder = HostEmulator::freePort(true);
+  HostEmulator emulator;
+  if(!CHECK(emulator.start({ "--cameras", "1", "--discovery-port", std::to_string(responder) })))
+    return hostTestResult("discovery");
+
+  // a stale gateway endpoint cached by an earlier run
+  HostStorage storage;
+  MonocleDiscoveryRecord stale = { { 127, 0, 0, 1 }, 1 };
+  CHECK(storage.save(0, MONOCLE_DISCOVERY_RECORD_VERSION, &stale, sizeof(stale)));
+
+  HostUdp udp;
+  udp.redirectFrom = MONOCLE_DISCOVERY_PORT;
+  udp.redirectTo = responder;
+  MonocleDiscovery discovery(udp);
+  discovery.setStorage(&storage, 0);
+  discovery.setProbeAddress(IPAddress(127, 0, 0, 2));   // nothing answers there
+  discovery.onDiscovered(onDiscovered);
+  discovery.begin();
+  CHECK(discovery.cached());
+  CHECK_EQ(discovery.port(), 1);
+
+  // run until the emulator is found (or 10 seconds)
+  unsigned long start = millis();
+  while(millis() - start < 10000 && !(discovery.found() && discovery.port() == emulator.port)){
+    discovery.loop();
+    if(forgottenTime == 0 && !discovery.found()){
+      forgottenTime = millis();
+      MonocleDiscoveryRecord record;
+      CHECK(!storage.load(0, MONOCLE_DISCOVERY_RECORD_VERSION, &record, sizeof(record)));
+      CHECK_EQ(discovery.probes(), MONOCLE_DISCOVERY_MAX_MISSES);
+      CHECK_EQ(discovery.responses(), 0);
+    }
+    delay(5);
+  }
+  unsigned long foundTime = millis();
+
+  // the cached endpoint missed its rounds (probed at the probe interval, not the
+  // revalidate interval), then the first broadcast probe found the emulator
+  CHECK(forgottenTime != 0);
+  CHECK_RANGE(forgottenTime - start,
+              (MONOCLE_DISCOVERY_MAX_MISSES - 1) * MONOCLE_DISCOVERY_PROBE_INTERVAL + MONOCLE_DISCOVERY_RESPONSE_TIMEOUT,
+              (MONOCLE_DISCOVERY_MAX_MISSES - 1) * MONOCLE_DISCOVERY_PROBE_INTERVAL + MONOCLE_DISCOVERY_RESPONSE_TIMEOUT + 200);
+  CHECK(discovery.found());
+  CHECK(!discovery.cached());
+  CHECK(discovery.address() == IPAddress(127, 0, 0, 1));
+  CHECK_EQ(discovery.port(), emulator.port);
+  CHECK_EQ(discovery.probes(), MONOCLE_DISCOVERY_MAX_MISSES + 1);
+  CHECK_EQ(discovery.unanswered(), 0);
+  CHECK_EQ(discoveries, 1);
+
+  // the discovered endpoint replaced the stale record
+  MonocleDiscoveryRecord record;
+  CHECK(storage.load(0, MONOCLE_DISCOVERY_RECORD_VERSION, &record, sizeof(record)));
+  CHECK_EQ(record.port, emulator.port);
+  printf("discovery: stale endpoint dropped after %lu ms, gateway found %lu ms later\n",
+         forgottenTime - start, foundTime - forgottenTime);
+
+  // answered revalidation probes keep the endpoint
+  discovery.probe();
+  delay(MONOCLE_DISCOVERY_RESPONSE_TIMEOUT + 50);
+  discovery.loop();
+  delay(MONOCLE_DISCOVERY_RESPONSE_TIMEOUT + 50);
+  discovery.loop();
+  CHECK(discovery.found());
+  CHECK_EQ(discovery.unanswered(), 0);
+  CHECK_EQ(discovery.responses(), 2);
+
+  emulator.kill();
+  return hostTestResult("discovery");
+}
@@ -0,0 +1,157 @@
+/*
+ * MonocleRotaryEncoder quadrature edge stream with contact bounce: a
+ * full cycle encoder is turned clockwise and counter-clockwise at slow
+ * and fast speeds while every edge bounces a few times, the contacts
+ * jitter at a detent and the shaft is rocked half a detent and back.
+ * Decoded from the pin interrupts (also when the interrupt misses the
+ * settling edge of a bounce) and from 'loop()' with forced polling,
+ * every detent is counted once in its direction and the jitter and
+ * the rocking count nothing.  Pins without an interrupt are polled.
+ */
+#include <HostArduino.h>
+#include <HostTest.h>
+#include <vector>
+#include "MonocleRotaryEncoder.h"
+
+#define PIN_A        4
+#define PIN_B        5
+#define PIN_POLLED_A 6
+#define PIN_POLLED_B 7
+#define TICK         25     // microseconds per simulation step
+#define POLL         1000   // microseconds between 'loop()' calls
+
+/* ONE PIN LEVEL CHANGE OF THE EDGE STREAM */
+struct Edge {
+  unsigned long time;   // microseconds from the start of the stream
+  int pin;              // 0 = A, 1 = B
+  int level;
+  bool lost;            // the interrupt of this change is missed
+};
+
+static unsigned long seed = 2718;
+static int clockwise = 0, counterClockwise = 0;
+
+static void onRotate(const int detents) {
+  if(detents > 0) clockwise += detents;
+  else counterClockwise -= detents;
+}
+
+static unsigned long noise(unsigned long low, unsigned long high) {
+  seed = seed * 1103515245UL + 12345UL;
+  return low + (seed >> 16) % (high - low + 1);
+}
+
+/*
+ * CHANGE ONE PIN AT 'time' WITH 0..4 BOUNCES (30..150 US APART) BEFORE IT
+ * SETTLES; 'loseSettle' MISSES THE INTERRUPT OF THE SETTLING CHANGE
+ */
+static void edge(std::vector<Edge>& stream, int* levels, unsigned long time, int pin, bool loseSettle = false) {
+  int bounces = (int)noise(0, 4);
+  int level = !levels[pin];
+  for(int bounce = 0; bounce < bounces; bounce++){
+    stream.push_back({ time, pin, level, false });
+    stream.push_back({ time + noise(30, 150), pin, !level, false });
+    time = stream.back().time + noise(30, 150);
+  }
+  stream.push_back({ time, pin, level, loseSettle && bounces > 0 });
+  levels[pin] = level;
+}
+
+/*
+ * TURN 'detents' DETENTS (POSITIVE = CLOCKWISE: A LEADS B) OF 'period'
+ * US EACH STARTING AT 'time'; RETURNS THE END TIME
+ */
+static unsigned long turn(std::vector<Edge>& stream, int* levels, unsigned long time, int detents,
+                          unsigned long period, bool loseSettle = false) {
+  int first = (detents > 0) ? 0 : 1;
+  for(int detent = 0; detent < abs(detents); detent++){
+    for(int quarter = 0; quarter < 4; quarter++){
+      edge(stream, levels, time, (quarter % 2 == 0) ? first : !first, loseSettle && quarter == 1);
+      time += period / 4;
+    }
+  }
+  return time;
+}
+
+/* THE TEST STREAM; RETURNS THE EXPECTED CLOCKWISE AND COUNTER-CLOCKWISE DETENTS */
+static std::vector<Edge> stream(int& expectedClockwise, int& expectedCounterClockwise) {
+  std::vector<Edge> stream;
+  int levels[2] = { HIGH, HIGH };
+  unsigned long time = 5000;
+  time = turn(stream, levels, time, 20, 40000);        // slow clockwise
+  for(int jitter = 0; jitter < 6; jitter++){           // contact jitter at the detent
+    edge(stream, levels, time, 0);
+    edge(stream, levels, time + 1500, 0);
+    time += 5000;
+  }
+  time = turn(stream, levels, time, -15, 8000);        // fast counter-clockwise
+  edge(stream, levels, time, 0);                       // rock half a detent and back
+  edge(stream, levels, time + 3000, 1);
+  edge(stream, levels, time + 6000, 1);
+  edge(stream, levels, time + 9000, 0);
+  time += 20000;
+  time = turn(stream, levels, time, 5, 20000, true);   // clockwise, missing settling interrupts
+  expectedClockwise = 25;
+  expectedCounterClockwise = 15;
+  return stream;
+}
+
+/* PLAY THE STREAM ON THE PINS, CALLING 'loop()' EVERY POLL INTERVAL */
+static void play(MonocleRotaryEncoder& encoder, const std::vector<Edge>& stream, int pinA, int pinB) {
+  size_t next = 0;
+  unsigned long end = stream.back().time + 10 * POLL;
+  for(unsigned long time = 0; time <= end; time += TICK){
+    for(; next < stream.size() && stream[next].time <= time; next++){
+      const Edge& change = stream[next];
+      if(change.lost) noInterrupts();
+      hostSetPin(change.pin == 0 ? pinA : pinB, change.level);
+      if(change.lost) interrupts();
+    }
+    if(time % POLL == 0) encoder.loop();
+    hostAdvanceMicros(TICK);
+  }
+}
+
+static uint8_t restingPins() { return 0x03; }
+
+int main() {
+  hostSetTime(1000);
+  int expectedClockwise, expectedCounterClockwise;
+  std::vector<Edge> edges = stream(expectedClockwise, expectedCounterClockwise);
+
+  // decoded in the pin interrupts
+  MonocleRotaryEncoder encoder;
+  encoder.onRotate(onRotate);
+  encoder.setupPins(PIN_A, PIN_B);
+  CHECK(!encoder.isPolled());
+  CHECK(hostInterruptAttached(PIN_A) && hostInterruptAttached(PIN_B));
+  play(encoder, edges, PIN_A, PIN_B);
+  CHECK_EQ(clockwise, expectedClockwise);
+  CHECK_EQ(counterClockwise, expectedCounterClockwise);
+  CHECK_EQ(encoder.detentPosition(), expectedClockwise - expectedCounterClockwise);
+  printf("encoder_bounce: %u edges, interrupts: %d clockwise, %d counter-clockwise detents\n",
+         (unsigned)edges.size(), clockwise, counterClockwise);
+
+  // sampled by 'loop()' with forced polling (no interrupts attached)
+  clockwise = counterClockwise = 0;
+  MonocleRotaryEncoder polled;
+  polled.onRotate(onRotate);
+  polled.forcePolling(true);
+  polled.setupPins(PIN_POLLED_A, PIN_POLLED_B);
+  CHECK(polled.isPolled());
+  CHECK(!hostInterruptAttached(PIN_POLLED_A) && !hostInterruptAttached(PIN_POLLED_B));
+  play(polled, edges, PIN_POLLED_A, PIN_POLLED_B);
+  CHECK_EQ(clockwise, expectedClockwise);
+  CHECK_EQ(counterClockwise, expectedCounterClockwise);
+  CHECK_EQ(polled.detentPosition(), expectedClockwise - expectedCounterClockwise);
+  printf("encoder_bounce: polled every %d us: %d clockwise, %d counter-clockwise detents\n",
+         POLL, clockwise, counterClockwise);
+
+  // a pin without an interrupt falls back to polling
+  MonocleRotaryEncoder fallback;
+  fallback.setPinReader(restingPins);
+  fallback.setupPins(PIN_A, HOST_PINS + 8);
+  CHECK(fallback.isPolled());
+
+  return hostTestResult("encoder_bounce");
+}
@@ -0,0 +1,157 @@
+/*
+ * MonocleEventBus: events are delivered in publish order to the
+ * subscribers of their type, a full queue drops (and counts) new
+ * events, re-published events wait for the next 'loop()', a handler
+ * unsubscribing during dispatch does not skip the next subscriber, and a
+ * benchmark reports the sustained publish + dispatch rate.
+ */
+#include <HostArduino.h>
+#include <HostTest.h>
+#include <chrono>
+#include "MonocleEventBus.h"
+
+static int16_t received[64];
+static int receivedCount = 0;
+static unsigned long ptzCount = 0;
+static unsigned long anyCount = 0;
+static long checksum = 0;
+
+static void onButton(const MonocleEvent& event, void* context) {
+  if(receivedCount < 64) received[receivedCount++] = event.value;
+}
+static void onPTZ(const MonocleEvent& event, void* context) {
+  ptzCount++;
+  checksum += event.pan + event.tilt + event.zoom;
+}
+static void onAny(const MonocleEvent& event, void* context) {
+  anyCount++;
+}
+static void onRepublish(const MonocleEvent& event, void* context) {
+  // every button event queues another one (must not starve the loop)
+  ((MonocleEventBus*)context)->publishButton(event.value + 1);
+}
+
+static MonocleEventBus* unsubscribeBus = NULL;
+static int onceCount = 0;
+static void onOnce(const MonocleEvent& event, void* context) {
+  // the first button event unsubscribes this handler from inside the dispatch
+  onceCount++;
+  unsubscribeBus->unsubscribe(onOnce);
+}
+
+int main() {
+  // ordering and per-type delivery
+  {
+    MonocleEventBus bus;
+    CHECK(bus.subscribe(MONOCLE_EVENT_BUTTON, onButton));
+    CHECK(bus.subscribe(MONOCLE_EVENT_ANY, onAny));
+    for(int i = 0; i < 10; i++) bus.publishButton(i);
+    bus.publishLink(true);
+    CHECK_EQ(bus.pending(), 11);
+    bus.loop();
+    CHECK_EQ(bus.pending(), 0);
+    CHECK_EQ(receivedCount, 10);
+    bool ordered = true;
+    for(int i = 0; i < receivedCount; i++) ordered &= received[i] == i;
+    CHECK(ordered);
+    CHECK_EQ(anyCount, 11);
+    CHECK_EQ(bus.dispatched(), 11);
+
+    // events without a subscriber never occupy a slot
+    MonocleEventBus quiet;
+    CHECK(quiet.publishPTZ(10, 0, 0));
+    CHECK_EQ(quiet.pending(), 0);
+  }
+
+  // overflow: the queue holds MONOCLE_EVENT_QUEUE_SIZE events, the rest are counted
+  {
+    MonocleEventBus bus;
+    receivedCount = 0;
+    bus.subscribe(MONOCLE_EVENT_BUTTON, onButton);
+    int accepted = 0;
+    for(int i = 0; i < MONOCLE_EVENT_QUEUE_SIZE + 5; i++)
+      if(bus.publishButton(i)) accepted++;
+    CHECK_EQ(accepted, MONOCLE_EVENT_QUEUE_SIZE);
+    CHECK_EQ(bus.overflows(), 5);
+    bus.loop();
+    CHECK_EQ(receivedCount, MONOCLE_EVENT_QUEUE_SIZE);
+    CHECK_EQ(received[MONOCLE_EVENT_QUEUE_SIZE - 1], MONOCLE_EVENT_QUEUE_SIZE - 1);
+    bus.resetStatistics();
+    CHECK_EQ(bus.overflows(), 0);
+  }
+
+  // a subscriber publishing during dispatch is delivered on the next call
+  {
+    MonocleEventBus bus;
+    receivedCount = 0;
+    bus.subscribe(MONOCLE_EVENT_BUTTON, onButton);
+    bus.subscribe(MONOCLE_EVENT_BUTTON, onRepublish, &bus);
+    bus.publishButton(0);
+    bus.loop();
+    CHECK_EQ(receivedCount, 1);
+    CHECK_EQ(bus.pending(), 1);
+    bus.loop();
+    CHECK_EQ(receivedCount, 2);
+    CHECK_EQ(received[1], 1);
+    bus.unsubscribe(onRepublish, &bus);
+    bus.loop();
+    CHECK_EQ(bus.pending(), 0);
+  }
+
+  // a handler unsubscribing itself during dispatch: the subscriber after
+  // it still receives that event and every later one
+  {
+    MonocleEventBus bus;
+    unsubscribeBus = &bus;
+    receivedCount = 0;
+    anyCount = 0;
+    CHECK(bus.subscribe(MONOCLE_EVENT_BUTTON, onOnce));
+    CHECK(bus.subscribe(MONOCLE_EVENT_BUTTON, onButton));
+    CHECK(bus.subscribe(MONOCLE_EVENT_ANY, onAny));
+    bus.publishButton(1);
+    bus.publishButton(2);
+    bus.publishButton(3);
+    bus.loop();
+    CHECK_EQ(onceCount, 1);
+    CHECK_EQ(receivedCount, 3);
+    CHECK_EQ(received[0], 1);
+    CHECK_EQ(anyCount, 3);
+    bus.publishButton(4);
+    bus.loop();
+    CHECK_EQ(onceCount, 1);
+    CHECK_EQ(receivedCount, 4);
+    bus.unsubscribe(onButton);
+    bus.unsubscribe(onAny);
+    CHECK(bus.publishButton(5));
+    CHECK_EQ(bus.pending(), 0);   // nobody is listening any more
+  }
+
+  // benchmark: bursts of PTZ events (a full queue) published and
+  // dispatched to four subscribers, timed on the real clock
+  {
+    MonocleEventBus bus;
+    bus.subscribe(MONOCLE_EVENT_PTZ, onPTZ);
+    bus.subscribe(MONOCLE_EVENT_PTZ, onPTZ);
+    bus.subscribe(MONOCLE_EVENT_ANY, onAny);
+    bus.subscribe(MONOCLE_EVENT_BUTTON, onButton);
+    const unsigned long rounds = 200000;
+    ptzCount = 0;
+    checksum = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for(unsigned long round = 0; round < rounds; round++){
+      for(int i = 0; i < MONOCLE_EVENT_QUEUE_SIZE; i++)
+        bus.publishPTZ(i, -i, round & 1);
+      bus.loop();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    unsigned long events = rounds * MONOCLE_EVENT_QUEUE_SIZE;
+    CHECK_EQ(bus.dispatched(), events);
+    CHECK_EQ(bus.overflows(), 0);
+    CHECK_EQ(ptzCount, events * 2);
+    printf("event_bus: %lu events in %.3f s = %.0f events/s (%.1f ns/event, %d subscribers)\n",
+           events, seconds, events / seconds, seconds * 1e9 / events, 4);
+    if(checksum == 42) printf("\n");   // keep the handlers from being optimised away
+  }
+
+  return hostTestResult("event_bus");
+}
@@ -0,0 +1,136 @@
+/*
+ * MonocleGatewayPool against two gateway emulators: the active gateway
+ * is killed during a PTZ burst.  The pool fails over within a second,
+ * the commands queued on the dead endpoint (a camera STOP queued right
+ * after the kill) reach the backup gateway, and the reconnect attempts
+ * to the dead endpoint (which then accepts connections but never answers
+ * the upgrade) never stall a loop pass beyond the connect timeout.
+ */
+#include <HostArduino.h>
+#include <HostTest.h>
+#include <HostNetwork.h>
+#include <HostEmulator.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include "MonocleGatewayPool.h"
+
+#define CAMERA "emulator-camera-1"
+
+static unsigned long worstPass = 0;
+
+/* RUN THE POOL FOR 'duration' MS (A PASS EVERY 5 MS), TRACKING THE LONGEST PASS */
+static void run(MonocleGatewayPool& pool, unsigned long duration) {
+  unsigned long start = millis();
+  while(millis() - start < duration){
+    unsigned long pass = millis();
+    pool.loop();
+    if(millis() - pass > worstPass) worstPass = millis() - pass;
+    delay(5);
+  }
+}
+
+/* A LOCAL LISTENER THAT NEVER ANSWERS (CONNECTS SUCCEED, THE UPGRADE TIMES OUT) */
+static int stall(uint16_t port) {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  int yes = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  address.sin_addr.s_addr = inet_addr("127.0.0.1");
+  if(bind(fd, (sockaddr*)&address, sizeof(address)) != 0 || listen(fd, 4) != 0){ close(fd); return -1; }
+  return fd;
+}
+
+/* THE RAW COMMANDS A GATEWAY LOGGED AFTER THE FIRST 'skip' */
+static std::vector<std::string> raw(HostEmulator& emulator, size_t skip = 0) {
+  std::vector<HostEmulatorCommand> commands = emulator.commands(true);
+  std::vector<std::string> result;
+  for(size_t i = skip; i < commands.size(); i++) result.push_back(commands[i].raw);
+  return result;
+}
+
+static bool contains(const std::vector<std::string>& commands, const std::string& command) {
+  for(size_t i = 0; i < commands.size(); i++) if(commands[i] == command) return true;
+  return false;
+}
+
+int main() {
+  hostUseRealTime(true);
+  HostEmulator emulators[2];
+  for(int i = 0; i < 2; i++)
+    if(!CHECK(emulators[i].start({ "--cameras", "1", "--no-discovery" }))) return hostTestResult("failover");
+
+  HostTcpClient tcp[2];
+  MonocleGatewayClient primary(tcp[0], "127.0.0.1", emulators[0].port);
+  MonocleGatewayClient backup(tcp[1], "127.0.0.1", emulators[1].port);
+  MonocleGatewayPool pool;
+  CHECK(pool.add(primary));
+  CHECK(pool.add(backup));
+  pool.begin();
+  run(pool, 500);
+  CHECK(pool.connected());
+  CHECK(pool.isHealthy(0) && pool.isHealthy(1));
+  int active = pool.activeGateway();
+  if(!CHECK(active == 0 || active == 1)) return hostTestResult("failover");
+  HostEmulator& dead = emulators[active];
+  HostEmulator& survivor = emulators[1 - active];
+  size_t before = emulators[1 - active].commands(true).size();
+
+  // a PTZ burst for the active camera and a camera session; the active
+  // gateway is killed half way through and the STOPs are queued at once
+  for(int update = 0; update < 20; update++){
+    pool.ptz((update % 3) + 1, 0, 0);
+    pool.ptz(CAMERA, -((update % 3) + 1), 1, 0);
+    run(pool, 10);
+  }
+  pool.ptz(3, 0, 0);
+  pool.ptz(CAMERA, -3, 1, 0);
+  dead.kill();
+  unsigned long killTime = millis(), failoverTime = 0;
+  pool.stop(CAMERA);
+  pool.stop();
+  while(failoverTime == 0 && millis() - killTime < 2000){
+    run(pool, 5);
+    if(pool.activeGateway() != active) failoverTime = millis();
+  }
+  CHECK(failoverTime != 0);
+  CHECK_RANGE(failoverTime - killTime, 0, 1000);
+  CHECK_EQ(pool.failovers(), 1);
+  run(pool, 300);
+
+  // the backup gateway stopped both cameras (whatever the dead socket swallowed)
+  std::vector<std::string> received = raw(survivor, before);
+  CHECK(contains(received, "@" CAMERA ":STOP"));
+  CHECK(contains(received, "STOP"));
+  CHECK_EQ(backup.pending() + primary.pending(), 0);
+
+  // the dead endpoint now accepts connections but never upgrades them;
+  // the reconnect attempts are bounded by the connect timeout and run in
+  // passes of their own while the backup keeps receiving commands
+  int listener = stall(dead.port);
+  CHECK(listener >= 0);
+  unsigned long connects = tcp[active].connects;
+  worstPass = 0;
+  unsigned long start = millis();
+  int sent = 0;
+  while(millis() - start < MONOCLE_POOL_RECONNECT_INTERVAL * 2 + 500){
+    pool.home(CAMERA);
+    sent++;
+    run(pool, 50);
+  }
+  CHECK_RANGE(tcp[active].connects - connects, 1, 3);
+  CHECK_RANGE(worstPass, MONOCLE_POOL_CONNECT_TIMEOUT - 10, MONOCLE_POOL_CONNECT_TIMEOUT + 100);
+  CHECK(!pool.isHealthy(active));
+  CHECK_EQ(pool.activeGateway(), 1 - active);
+  run(pool, 200);
+  CHECK_EQ(raw(survivor, before).size() - received.size(), sent);
+  printf("failover: failover %lu ms after the kill, longest pass %lu ms during reconnects (connect timeout %d ms)\n",
+         failoverTime - killTime, worstPass, MONOCLE_POOL_CONNECT_TIMEOUT);
+
+  if(listener >= 0) close(listener);
+  emulators[1 - active].kill();
+  return hostTestResult("failover");
+}
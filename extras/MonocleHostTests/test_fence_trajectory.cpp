@@ -0,0 +1,175 @@
+/*
+ * MonocleFence scripted trajectories: a simulated camera moves at the
+ * speed levels the loopback gateway receives (motion planner default
+ * rates) and pushes its position every status interval with a network
+ * latency.  An operator holds scripted PTZ vectors against a privacy
+ * box (pan 20..40, tilt -10..10) and soft limits (pan -90..90, zoom
+ * 0..3).  No trajectory may enter the privacy box or leave the limits,
+ * every blocked move must come to rest within the look-ahead margin of
+ * the fence, and moves clear of the zones (above the box, back inward
+ * from a limit) must pass unchanged.
+ */
+#include <HostArduino.h>
+#include <HostTest.h>
+#include <HostNetwork.h>
+#include <string>
+#include "MonocleFence.h"
+
+#define STATUS_INTERVAL 200   // milliseconds between status pushes
+#define LATENCY         30    // milliseconds
+
+static const float rates[MONOCLE_AXES][4] = {
+  { 0, 5.0, 15.0, 45.0 }, { 0, 5.0, 15.0, 45.0 }, { 0, 0.25, 0.5, 1.0 }
+};
+
+/* THE SIMULATED CAMERA */
+struct Camera {
+  float position[MONOCLE_AXES];
+  int level[MONOCLE_AXES];
+  size_t received;              // link commands applied so far
+  unsigned long statusTime;
+  bool enteredPrivacy;
+  bool leftLimits;
+};
+
+static bool inPrivacy(const float* position) {
+  return position[MONOCLE_AXIS_PAN] > 20 && position[MONOCLE_AXIS_PAN] < 40 &&
+         position[MONOCLE_AXIS_TILT] > -10 && position[MONOCLE_AXIS_TILT] < 10;
+}
+
+static bool inLimits(const float* position) {
+  return position[MONOCLE_AXIS_PAN] >= -90 && position[MONOCLE_AXIS_PAN] <= 90 &&
+         position[MONOCLE_AXIS_ZOOM] >= 0 && position[MONOCLE_AXIS_ZOOM] <= 3;
+}
+
+/* PUSH THE CAMERA POSITION TO THE CLIENT */
+static void push(HostLoopbackGateway& link, Camera& camera) {
+  char text[128];
+  snprintf(text, sizeof(text), "{\"status\":{\"pan\":%.3f,\"tilt\":%.3f,\"zoom\":%.3f,\"moving\":%s}}",
+           camera.position[0], camera.position[1], camera.position[2],
+           (camera.level[0] || camera.level[1] || camera.level[2]) ? "true" : "false");
+  link.push(text);
+  camera.statusTime = millis();
+}
+
+/*
+ * HOLD A PTZ VECTOR FOR 'duration' MS (THE OPERATOR SENDS IT ONCE, AS
+ * THE JOYSTICK DOES) WHILE THE CAMERA MOVES, THE STATUS IS PUSHED AND
+ * THE FENCE RE-CHECKS THE HELD MOVEMENT
+ */
+static void hold(MonocleGatewayClient& client, MonocleFence& fence, HostLoopbackGateway& link, Camera& camera,
+                 int pan, int tilt, int zoom, unsigned long duration) {
+  client.ptz(pan, tilt, zoom);
+  for(unsigned long elapsed = 0; elapsed < duration; elapsed++){
+    client.loop();
+    fence.loop();
+    for(; camera.received < link.commands.size(); camera.received++){
+      const std::string& command = link.commands[camera.received];
+      if(command == "STOP") camera.level[0] = camera.level[1] = camera.level[2] = 0;
+      else sscanf(command.c_str(), "PTZ:%d:%d:%d", &camera.level[0], &camera.level[1], &camera.level[2]);
+    }
+    for(int axis = 0; axis < MONOCLE_AXES; axis++){
+      int level = camera.level[axis];
+      camera.position[axis] += (level < 0 ? -rates[axis][-level] : rates[axis][level]) / 1000.0f;
+    }
+    camera.enteredPrivacy |= inPrivacy(camera.position);
+    camera.leftLimits |= !inLimits(camera.position);
+    if(millis() - camera.statusTime >= STATUS_INTERVAL) push(link, camera);
+    hostAdvance(1);
+  }
+  client.stop();
+  client.loop();
+  camera.level[0] = camera.level[1] = camera.level[2] = 0;
+  camera.received = link.commands.size();
+}
+
+/* PLACE THE CAMERA AND LET THE CLIENT RECEIVE THE POSITION (AND ANY PUSHES IN FLIGHT) */
+static void place(MonocleGatewayClient& client, HostLoopbackGateway& link, Camera& camera, float pan, float tilt, float zoom) {
+  camera.position[MONOCLE_AXIS_PAN] = pan;
+  camera.position[MONOCLE_AXIS_TILT] = tilt;
+  camera.position[MONOCLE_AXIS_ZOOM] = zoom;
+  camera.enteredPrivacy = camera.leftLimits = false;
+  push(link, camera);
+  for(int elapsed = 0; elapsed <= LATENCY; elapsed++){
+    client.loop();
+    hostAdvance(1);
+  }
+  client.loop();
+}
+
+int main() {
+  hostSetTime(1000);
+  HostLoopbackGateway link;
+  link.latency = LATENCY;
+  MonocleGatewayClient client(link, "127.0.0.1", 8080);
+  client.begin();
+  client.loop();
+  client.subscribeStatus(STATUS_INTERVAL);
+  MonocleFence fence(client);
+  int privacy = fence.addExclusion(20, 40, -10, 10);
+  int limits = fence.addLimit(-90, 90, -MONOCLE_FENCE_UNBOUNDED, MONOCLE_FENCE_UNBOUNDED, 0, 3);
+  fence.begin();
+
+  // the stopping margin: the fence stops a move once its travel within the
+  // look-ahead time would cross the boundary (at most one look-ahead at the
+  // fastest speed short of it), plus the travel during the status latency
+  const float margin = rates[0][3] * (MONOCLE_FENCE_LOOKAHEAD + LATENCY) / 1000.0f;
+  const float zoomMargin = rates[2][3] * (MONOCLE_FENCE_LOOKAHEAD + LATENCY) / 1000.0f;
+  Camera camera = {};
+
+  // pan fast into the privacy box: stops short of its left edge
+  place(client, link, camera, 0, 0, 1);
+  hold(client, fence, link, camera, 3, 0, 0, 3000);
+  CHECK(!camera.enteredPrivacy);
+  CHECK_RANGE(camera.position[MONOCLE_AXIS_PAN], 20 - margin, 20);
+  CHECK(fence.violations(privacy) > 0);
+  printf("fence_trajectory: pan into privacy box: stopped at pan %.2f (edge 20, margin %.1f)\n",
+         camera.position[MONOCLE_AXIS_PAN], margin);
+
+  // pan fast above the box: passes unfenced
+  fence.resetViolations();
+  place(client, link, camera, 0, 15, 1);
+  hold(client, fence, link, camera, 3, 0, 0, 1500);
+  CHECK(!camera.enteredPrivacy);
+  CHECK_RANGE(camera.position[MONOCLE_AXIS_PAN], 67, 68);
+  CHECK_EQ(fence.violations(), 0);
+
+  // keep panning into the soft limit: stops short of it
+  hold(client, fence, link, camera, 3, 0, 0, 2000);
+  CHECK(!camera.leftLimits);
+  CHECK_RANGE(camera.position[MONOCLE_AXIS_PAN], 90 - margin, 90);
+  CHECK(fence.violations(limits) > 0);
+  printf("fence_trajectory: pan into soft limit: stopped at pan %.2f (limit 90)\n", camera.position[MONOCLE_AXIS_PAN]);
+
+  // moving back inward from the limit is never fenced
+  fence.resetViolations();
+  float start = camera.position[MONOCLE_AXIS_PAN];
+  hold(client, fence, link, camera, -3, 0, 0, 500);
+  CHECK_RANGE(camera.position[MONOCLE_AXIS_PAN], start - 23, start - 22);
+  CHECK_EQ(fence.violations(), 0);
+
+  // tilt down onto the box from above: stops short of its top edge
+  place(client, link, camera, 30, 20, 1);
+  hold(client, fence, link, camera, 0, -2, 0, 3000);
+  CHECK(!camera.enteredPrivacy);
+  CHECK_RANGE(camera.position[MONOCLE_AXIS_TILT], 10, 10 + margin);
+  CHECK(fence.violations(privacy) > 0);
+  printf("fence_trajectory: tilt onto privacy box: stopped at tilt %.2f (edge 10)\n", camera.position[MONOCLE_AXIS_TILT]);
+
+  // zoom in past the maximum usable zoom: stops short of it
+  fence.resetViolations();
+  place(client, link, camera, 0, 0, 0);
+  hold(client, fence, link, camera, 0, 0, 3, 6000);
+  CHECK(!camera.leftLimits);
+  CHECK_RANGE(camera.position[MONOCLE_AXIS_ZOOM], 3 - zoomMargin, 3);
+  CHECK(fence.violations(limits) > 0);
+  printf("fence_trajectory: zoom past limit: stopped at zoom %.2f (limit 3)\n", camera.position[MONOCLE_AXIS_ZOOM]);
+
+  // a diagonal move into the box: whatever the axes do, the box is never entered
+  place(client, link, camera, 5, -25, 1);
+  hold(client, fence, link, camera, 2, 2, 0, 4000);
+  CHECK(!camera.enteredPrivacy);
+  CHECK(!camera.leftLimits);
+
+  return hostTestResult("fence_trajectory");
+}
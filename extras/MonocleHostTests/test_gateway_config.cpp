@@ -0,0 +1,119 @@
+/*
+ * MonocleConfig updates from the gateway: a 'config' message changes
+ * the MONOCLE_CONFIG_REMOTE fields (joystick thresholds, IR codes and
+ * the like), but an update naming the WiFi credentials or the gateway
+ * endpoint, or holding any value that does not fit its field, is
+ * rejected as a whole (no field of it is changed or applied); the
+ * console still sets the credentials and the endpoint.  Configured IR
+ * codes replace the remote's own code table until the last one is set
+ * back to 0, which restores the table.
+ */
+#include <HostArduino.h>
+#include <HostTest.h>
+#include <HostNetwork.h>
+#include <HostStorage.h>
+#include <string>
+#include "MonocleConfig.h"
+#include "MonocleGatewayClient.h"
+#include "MonocleIRRemote.h"
+
+static const MonocleIRCode sketchCodes[] = {
+  { 0x00FF629D, MONOCLE_IR_TILT_UP, 0 }, { 0x00FFA857, MONOCLE_IR_TILT_DOWN, 0 },
+  { 0x00FF30CF, MONOCLE_IR_PRESET, 1 },
+};
+#define SKETCH_CODES (sizeof(sketchCodes) / sizeof(sketchCodes[0]))
+
+static int changes = 0;
+static void onChange(const int id) { changes++; }
+
+/* PUSH A MESSAGE AND LET THE CLIENT PROCESS IT; RETURNS THE REPLY */
+static std::string deliver(MonocleGatewayClient& client, HostLoopbackGateway& link, const char* text) {
+  size_t sent = link.commands.size();
+  link.push(text);
+  for(int elapsed = 0; elapsed < 1200 && link.commands.size() == sent; elapsed += 10){
+    client.loop();
+    hostAdvance(10);
+  }
+  return (link.commands.size() > sent) ? link.commands.back() : "";
+}
+
+int main() {
+  hostSetTime(1000);
+  HostLoopbackGateway link;
+  MonocleGatewayClient client(link, "127.0.0.1", 8080);
+  client.begin();
+  client.loop();
+  HostStorage storage(MONOCLE_STORAGE_FLASH_SIZE);
+  MonocleConfig config(storage);
+  config.attach(&client);
+  CHECK(config.set("wifiSsid", "home"));
+  CHECK(config.set("wifiPass", "secret"));
+  CHECK(config.set("gatewayAddress", "192.168.1.20"));
+  config.onChange(onChange);
+
+  // only remote fields may be set by the gateway
+  CHECK(!MonocleConfig::isRemote(MONOCLE_CONFIG_WIFI_SSID));
+  CHECK(!MonocleConfig::isRemote(MONOCLE_CONFIG_WIFI_PASS));
+  CHECK(!MonocleConfig::isRemote(MONOCLE_CONFIG_GATEWAY_ADDRESS));
+  CHECK(!MonocleConfig::isRemote(MONOCLE_CONFIG_GATEWAY_PORT));
+  CHECK(MonocleConfig::isRemote(MONOCLE_CONFIG_THRESHOLD_LOW));
+  CHECK(!MonocleConfig::isRemote(-1));
+
+  // a remote field update is applied
+  CHECK(deliver(client, link, "{\"config\":{\"thresholdLow\":600,\"invertPan\":true}}") == "CONFIG:OK");
+  CHECK_EQ(config.getInt(MONOCLE_CONFIG_THRESHOLD_LOW), 600);
+  CHECK(config.getBool(MONOCLE_CONFIG_INVERT_PAN));
+
+  // credentials and the endpoint are refused, also next to remote fields
+  CHECK(deliver(client, link, "{\"config\":{\"thresholdLow\":700,\"wifiPass\":\"evil\"}}") == "CONFIG:ERROR:wifiPass");
+  CHECK(strcmp(config.getText(MONOCLE_CONFIG_WIFI_PASS), "secret") == 0);
+  CHECK_EQ(config.getInt(MONOCLE_CONFIG_THRESHOLD_LOW), 600);
+  CHECK(deliver(client, link, "{\"config\":{\"gatewayAddress\":\"10.0.0.66\"}}") == "CONFIG:ERROR:gatewayAddress");
+  CHECK(deliver(client, link, "{\"config\":{\"gatewayPort\":9999}}") == "CONFIG:ERROR:gatewayPort");
+  CHECK(deliver(client, link, "{\"config\":{\"wifiSsid\":\"open\"}}") == "CONFIG:ERROR:wifiSsid");
+  CHECK(strcmp(config.getText(MONOCLE_CONFIG_GATEWAY_ADDRESS), "192.168.1.20") == 0);
+  CHECK_EQ(config.getUInt(MONOCLE_CONFIG_GATEWAY_PORT), 8080);
+  CHECK(strcmp(config.getText(MONOCLE_CONFIG_WIFI_SSID), "home") == 0);
+
+  // an invalid value anywhere in the update changes no field
+  CHECK(deliver(client, link, "{\"config\":{\"thresholdLow\":800,\"invertTilt\":true,\"thresholdMed\":70000}}") == "CONFIG:ERROR:thresholdMed");
+  CHECK(deliver(client, link, "{\"config\":{\"thresholdLow\":800,\"statusDelta\":-5}}") == "CONFIG:ERROR:statusDelta");
+  CHECK(deliver(client, link, "{\"config\":{\"thresholdLow\":800,\"invertTilt\":\"maybe\"}}") == "CONFIG:ERROR:invertTilt");
+  CHECK_EQ(config.getInt(MONOCLE_CONFIG_THRESHOLD_LOW), 600);
+  CHECK(!config.getBool(MONOCLE_CONFIG_INVERT_TILT));
+  CHECK_EQ(config.getInt(MONOCLE_CONFIG_THRESHOLD_MED), 1300);
+  CHECK_EQ(config.getUInt(MONOCLE_CONFIG_STATUS_DELTA), 50);
+  CHECK_EQ(changes, 2);
+
+  // unknown fields are refused the same way
+  CHECK(deliver(client, link, "{\"config\":{\"unknown\":1}}") == "CONFIG:ERROR:unknown");
+
+  // configured IR codes replace the remote's table; clearing the last one restores it
+  MonocleIRRemote remote;
+  CHECK(remote.loadCodes(sketchCodes, SKETCH_CODES));
+  config.attach(&remote);
+  CHECK_EQ(remote.codeCount(), SKETCH_CODES);
+  CHECK(deliver(client, link, "{\"config\":{\"irUp\":\"0x20DF02FD\",\"irStop\":\"0x20DF22DD\"}}") == "CONFIG:OK");
+  CHECK_EQ(remote.codeCount(), 2);
+  CHECK(deliver(client, link, "{\"config\":{\"irUp\":0}}") == "CONFIG:OK");
+  CHECK_EQ(remote.codeCount(), 1);
+  CHECK_EQ(remote.codeAt(0).code, 0x20DF22DD);
+  CHECK(deliver(client, link, "{\"config\":{\"irStop\":0}}") == "CONFIG:OK");
+  CHECK_EQ(remote.codeCount(), SKETCH_CODES);
+  bool restored = true;
+  for(size_t index = 0; index < SKETCH_CODES; index++){
+    bool found = false;
+    for(int code = 0; code < remote.codeCount(); code++)
+      found |= remote.codeAt(code).code == sketchCodes[index].code && remote.codeAt(code).action == sketchCodes[index].action &&
+               remote.codeAt(code).value == sketchCodes[index].value;
+    restored &= found;
+  }
+  CHECK(restored);
+  CHECK_EQ(remote.codeAt(SKETCH_CODES).action, MONOCLE_IR_NONE);
+
+  // the console (and the program) still sets them
+  CHECK(config.set("gatewayPort", "9090"));
+  CHECK_EQ(config.getUInt(MONOCLE_CONFIG_GATEWAY_PORT), 9090);
+
+  return hostTestResult("gateway_config");
+}
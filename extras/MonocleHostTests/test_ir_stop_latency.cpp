@@ -0,0 +1,159 @@
+/*
+ * MonocleIRRemote: replays recorded-style IR timing traces (NEC code +
+ * repeat frames, and a protocol resending the full code while held)
+ * with receiver jitter, and measures the stop latency: the time from
+ * the first missing repeat (the button was released) to the STOP.
+ * The old sketches stopped on a fixed 200 ms 'irTimeout' after the
+ * last repeat; the latency of that rule is printed for comparison.
+ */
+#include <HostArduino.h>
+#include <HostTest.h>
+#include "MonocleIRRemote.h"
+
+#define CODE_LEFT  0x00FF22DDUL
+#define CODE_RIGHT 0x00FFC23DUL
+#define CODE_UP    0x00FF629DUL
+#define CODE_OK    0x00FF02FDUL
+#define LEGACY_TIMEOUT 200
+
+/* ONE DECODED FRAME OF A TRACE */
+struct Frame {
+  unsigned long time;
+  uint32_t code;
+};
+
+static unsigned long stopTime = 0;
+static int moves = 0, stops = 0;
+
+static void onPTZ(int pan, int tilt, int zoom) {
+  if(pan == 0 && tilt == 0 && zoom == 0){ stops++; stopTime = millis(); }
+  else moves++;
+}
+
+/* DETERMINISTIC RECEIVER JITTER OF +/- 'range' MS */
+static unsigned long seed = 4242;
+static long jitter(int range) {
+  seed = seed * 1103515245UL + 12345UL;
+  return (long)((seed >> 16) % (2 * range + 1)) - range;
+}
+
+/*
+ * BUILD A TRACE FOR ONE BUTTON HELD FOR 'held' MS: THE CODE AT 'start',
+ * THEN (NEC) A REPEAT 'first' MS LATER AND EVERY 'period' MS, OR
+ * (RESEND) THE FULL CODE EVERY 'period' MS. RETURNS THE FRAME COUNT;
+ * 'missed' RECEIVES THE NOMINAL TIME OF THE FIRST MISSING FRAME.
+ */
+static int hold(Frame* trace, int count, unsigned long start, uint32_t code, bool nec,
+                unsigned long first, unsigned long period, unsigned long held, unsigned long* missed) {
+  Frame frame = { start, code };
+  trace[count++] = frame;
+  unsigned long nominal = start + (nec ? first : period);
+  while(nominal <= start + held){
+    Frame repeat = { (unsigned long)(nominal + jitter(3)), nec ? MONOCLE_IR_NEC_REPEAT : code };
+    trace[count++] = repeat;
+    nominal += period;
+  }
+  *missed = nominal;
+  return count;
+}
+
+/* REPLAY A TRACE; 'loop()' RUNS EVERY MONOCLE_IR_TASK_INTERVAL AS WHEN SCHEDULED */
+static void replay(MonocleIRRemote& remote, const Frame* trace, int count, unsigned long duration) {
+  unsigned long start = millis();
+  int next = 0;
+  for(unsigned long elapsed = 0; elapsed <= duration; elapsed++){
+    while(next < count && trace[next].time + start <= millis()){
+      remote.process(trace[next].code);
+      next++;
+    }
+    if(elapsed % MONOCLE_IR_TASK_INTERVAL == 0) remote.loop();
+    hostAdvance(1);
+  }
+}
+
+/* REPLAY ONE HOLD AND RETURN THE STOP LATENCY (MS AFTER THE FIRST MISSING FRAME) */
+static long stopLatency(MonocleIRRemote& remote, bool nec, unsigned long first, unsigned long period,
+                        unsigned long held, long* legacy) {
+  Frame trace[128];
+  unsigned long missed;
+  int count = hold(trace, 0, 20, CODE_LEFT, nec, first, period, held, &missed);
+  unsigned long start = millis();
+  stops = moves = 0;
+  replay(remote, trace, count, held + 600);
+  CHECK_EQ(moves, 1);
+  CHECK_EQ(stops, 1);
+  *legacy = (long)(trace[count - 1].time + LEGACY_TIMEOUT) - (long)missed;
+  return (long)(stopTime - start) - (long)missed;
+}
+
+int main() {
+  hostSetTime(1000);
+  MonocleIRRemote remote;
+  MonocleIRCode codes[] = {
+    { CODE_UP, MONOCLE_IR_TILT_UP, 0 },
+    { CODE_RIGHT, MONOCLE_IR_PAN_RIGHT, 0 },
+    { CODE_LEFT, MONOCLE_IR_PAN_LEFT, 0 },
+    { CODE_OK, MONOCLE_IR_STOP, 0 },
+  };
+  CHECK(remote.loadCodes(codes, 4));
+  CHECK_EQ(remote.codeCount(), 4);
+  remote.onPTZ(onPTZ);
+
+  // NEC remote: repeat frames 40 ms after the code, then every 108 ms;
+  // stop latency stays within the repeat tolerance plus one task interval
+  long legacy;
+  long worst = 0, worstLegacy = 0;
+  unsigned long helds[] = { 150, 480, 1000, 2300 };
+  for(int i = 0; i < 4; i++){
+    long latency = stopLatency(remote, true, 40, 108, helds[i], &legacy);
+    CHECK_RANGE(latency, 0, 108 * MONOCLE_IR_DEFAULT_REPEAT_TOLERANCE / 100 + 3 + MONOCLE_IR_TASK_INTERVAL);
+    if(latency > worst) worst = latency;
+    if(legacy > worstLegacy) worstLegacy = legacy;
+  }
+  CHECK_RANGE(remote.repeatInterval(), 105, 111);
+  printf("ir_stop_latency: NEC 108 ms repeats: worst stop latency %ld ms (fixed %d ms timeout: %ld ms)\n",
+         worst, LEGACY_TIMEOUT, worstLegacy);
+
+  // a fast remote resending the full code every 45 ms: the measured interval
+  // follows the remote, so the stop is not delayed by the 110 ms default
+  MonocleIRRemote fast;
+  fast.loadCodes(codes, 4);
+  fast.onPTZ(onPTZ);
+  worst = 0; worstLegacy = 0;
+  for(int i = 0; i < 4; i++){
+    long latency = stopLatency(fast, false, 0, 45, helds[i], &legacy);
+    // (the first hold starts from the 110 ms default and converges while held)
+    if(i > 0) CHECK_RANGE(latency, 0, 45 * MONOCLE_IR_DEFAULT_REPEAT_TOLERANCE / 100 + 3 + MONOCLE_IR_TASK_INTERVAL);
+    if(latency > worst) worst = latency;
+    if(legacy > worstLegacy) worstLegacy = legacy;
+  }
+  CHECK_RANGE(fast.repeatInterval(), 42, 50);
+  printf("ir_stop_latency: resend 45 ms: worst stop latency %ld ms (fixed %d ms timeout: %ld ms)\n",
+         worst, LEGACY_TIMEOUT, worstLegacy);
+
+  // an explicit STOP code ends the movement at once
+  {
+    Frame trace[] = { { 10, CODE_UP }, { 50, MONOCLE_IR_NEC_REPEAT }, { 80, CODE_OK } };
+    stops = moves = 0;
+    unsigned long start = millis();
+    replay(remote, trace, 3, 200);
+    CHECK_EQ(moves, 1);
+    CHECK_EQ(stops, 1);
+    CHECK_EQ(stopTime - start, 80);
+  }
+
+  // hold-to-accelerate: held duration maps to LOW, MEDIUM and HIGH
+  {
+    remote.setAcceleration(300, 800);
+    Frame trace[128];
+    unsigned long missed;
+    int count = hold(trace, 0, 10, CODE_RIGHT, true, 40, 108, 1200, &missed);
+    stops = moves = 0;
+    replay(remote, trace, count, 1600);
+    CHECK_EQ(moves, 3);
+    CHECK_EQ(stops, 1);
+    CHECK(!remote.isHolding());
+  }
+
+  return hostTestResult("ir_stop_latency");
+}
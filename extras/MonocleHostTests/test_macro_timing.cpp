@@ -0,0 +1,138 @@
+/*
+ * MonocleMacro playback timing: a joystick sweep (zoom out, pan across
+ * at two speeds while tilting, zoom back in, then a 20 second hold) is
+ * recorded into a flash sized storage behind the boot snapshot and the
+ * configuration (the Deluxe MKR1000 layout) and played back from a
+ * scheduler through the loopback gateway while the main loop takes
+ * 1..3 ms per pass.  Every command must reach the gateway within a few
+ * milliseconds of its recorded time, also after a stalled pass (late
+ * entries are not carried over), and each save or erase commits the
+ * storage exactly once.
+ */
+#include <HostArduino.h>
+#include <HostTest.h>
+#include <HostNetwork.h>
+#include <HostStorage.h>
+#include <string>
+#include "MonocleMacro.h"
+#include "MonocleSnapshot.h"
+#include "MonocleConfig.h"
+
+#define MAX_ERROR 3   // milliseconds
+
+/* ONE RECORDED JOYSTICK CHANGE */
+struct Move {
+  unsigned long time;   // milliseconds after the start of the recording
+  int pan, tilt, zoom;
+};
+
+static const Move sweep[] = {
+  { 50, 0, 0, -2 }, { 600, 0, 0, 0 }, { 650, 2, 0, 0 }, { 900, 3, 0, 0 }, { 1400, 3, 1, 0 },
+  { 2500, 0, 0, 0 }, { 2550, 0, 0, 2 }, { 3100, 0, 0, 0 }, { 3300, -1, 0, 0 }, { 23300, 0, 0, 0 },
+};
+#define SWEEP_MOVES  (sizeof(sweep) / sizeof(sweep[0]))
+#define SWEEP_LENGTH 23400
+
+static unsigned long seed = 4321;
+static int completions = 0;
+static void onComplete(const uint8_t macro, const bool completed) { if(completed) completions++; }
+
+/*
+ * PLAY MACRO 1 FROM A SCHEDULER (OPTIONALLY STALLING ONE PASS FOR
+ * 'stall' MS AT 'stallTime') AND RETURN THE WORST TIMING ERROR OF
+ * THE COMMANDS (-1 IF A COMMAND IS MISSING OR DIFFERENT)
+ */
+static long play(MonocleMacro& macro, MonocleGatewayClient& client, HostLoopbackGateway& link,
+                 unsigned long stallTime, unsigned long stall) {
+  MonocleScheduler scheduler;
+  macro.schedule(scheduler);
+  size_t from = link.commands.size();
+  unsigned long start = millis();
+  bool stalled = false;
+  if(!macro.play(1)) return -1;
+  while(macro.isPlaying() && millis() - start < SWEEP_LENGTH + 1000){
+    scheduler.loop();
+    client.loop();
+    if(!stalled && stall > 0 && millis() - start >= stallTime){
+      stalled = true;
+      hostAdvance(stall);
+    }
+    else {
+      seed = seed * 1103515245UL + 12345UL;
+      hostAdvance(1 + (seed >> 16) % 3);
+    }
+  }
+
+  // compare the commands with the recording; the commands due during
+  // the stall are coalesced into one and timed from the end of the stall
+  long worst = 0;
+  size_t index = from;
+  for(size_t move = 0; move < SWEEP_MOVES; move++){
+    unsigned long due = sweep[move].time;
+    if(stall > 0 && due >= stallTime && due < stallTime + stall){
+      if(move + 1 < SWEEP_MOVES && sweep[move + 1].time < stallTime + stall) continue;
+      due = stallTime + stall;
+    }
+    if(index >= link.commands.size()) return -1;
+    char expected[32];
+    snprintf(expected, sizeof(expected), "PTZ:%d:%d:%d", sweep[move].pan, sweep[move].tilt, sweep[move].zoom);
+    if(link.commands[index] != expected) return -1;
+    long error = (long)(link.commandTimes[index] - start) - (long)due;
+    if(error < 0) return -1;   // never early
+    if(error > worst) worst = error;
+    index++;
+  }
+  return (index == link.commands.size()) ? worst : -1;
+}
+
+int main() {
+  hostSetTime(1000);
+  HostLoopbackGateway link;
+  MonocleGatewayClient client(link, "127.0.0.1", 8080);
+  client.begin();
+  client.loop();
+
+  // the snapshot, the configuration and all macros fit the flash region
+  HostStorage storage(MONOCLE_STORAGE_FLASH_SIZE);
+  size_t address = MonocleStorage::footprint(sizeof(MonocleSnapshotRecord)) + MonocleStorage::footprint(sizeof(MonocleConfigRecord));
+  CHECK(address + MONOCLE_MACRO_MAX_MACROS * MonocleStorage::footprint(sizeof(MonocleMacroRecord)) <= storage.size());
+  MonocleMacro macro(client, storage, address);
+  macro.onComplete(onComplete);
+
+  // record the sweep; the save commits once
+  CHECK(macro.record(1));
+  unsigned long start = millis();
+  for(size_t move = 0; move < SWEEP_MOVES; move++){
+    hostSetTime(start + sweep[move].time);
+    macro.input(sweep[move].pan, sweep[move].tilt, sweep[move].zoom);
+  }
+  hostSetTime(start + SWEEP_LENGTH);
+  CHECK(macro.finish());
+  CHECK_EQ(storage.commits, 1);
+  unsigned int length = macro.length();
+  CHECK(macro.record(MONOCLE_MACRO_MAX_MACROS));
+  macro.input(1, 0, 0);
+  CHECK(macro.finish());   // the last slot still fits
+  CHECK_EQ(storage.commits, 2);
+
+  // playback: every command within a few milliseconds of its recorded time
+  long worst = play(macro, client, link, 0, 0);
+  CHECK_RANGE(worst, 0, MAX_ERROR);
+  CHECK_EQ(completions, 1);
+  printf("macro_timing: %u moves in %u bytes over %.1f s, worst playback error %ld ms\n",
+         (unsigned)SWEEP_MOVES, length, SWEEP_LENGTH / 1000.0, worst);
+
+  // a 120 ms stall delays (and coalesces) the entries due during it, but not the later ones
+  worst = play(macro, client, link, 1350, 120);
+  CHECK_RANGE(worst, 0, MAX_ERROR);
+  CHECK_EQ(completions, 2);
+  printf("macro_timing: after a 120 ms stall, worst playback error %ld ms\n", worst);
+
+  // erasing commits once
+  CHECK(macro.erase(1));
+  CHECK_EQ(storage.commits, 3);
+  CHECK(!macro.has(1));
+  CHECK(macro.has(MONOCLE_MACRO_MAX_MACROS));
+
+  return hostTestResult("macro_timing");
+}
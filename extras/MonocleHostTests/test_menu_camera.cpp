@@ -0,0 +1,81 @@
+/*
+ * MonocleMenu "Cameras" submenu over the event bus: selecting a camera
+ * publishes a MENU CAMERA event carrying the camera uuid (not its list
+ * position), and the gateway client subscribed to the bus switches the
+ * active camera to it, also when the gateway list changed between the
+ * selection and the dispatch of the event.
+ */
+#include <HostArduino.h>
+#include <HostTest.h>
+#include <HostNetwork.h>
+#include <string>
+#include "MonocleOLEDMenuRenderer.h"
+#include "MonocleMenu.h"
+#include "MonocleEventBus.h"
+#include "MonocleGatewayClient.h"
+
+static std::string published;
+static int publishedValue = -1;
+
+static void onMenu(const MonocleEvent& event, void* context) {
+  if(event.action != MONOCLE_MENU_EVENT_CAMERA) return;
+  published = (event.uuid != NULL) ? event.uuid : "";
+  publishedValue = event.value;
+}
+
+/* OPEN THE MENU AND SELECT THE 'row'-TH CAMERA OF THE "Cameras" SUBMENU */
+static void selectCamera(MonocleMenu& menu, MonocleOLED& oled, int row) {
+  menu.activate();
+  menu.loop();
+  for(int step = 0; step < 12 && strstr(oled.text(3), "Cameras") == NULL; step++){ menu.next(); menu.loop(); }
+  menu.select();
+  menu.loop();
+  for(int step = 0; step < row; step++){ menu.next(); menu.loop(); }
+  menu.select();
+}
+
+int main() {
+  hostSetTime(1000);
+  HostLoopbackGateway link;
+  MonocleGatewayClient client(link, "127.0.0.1", 8080);
+  client.begin();
+  client.loop();
+
+  MonocleOLED oled(128, 64);
+  oled.init();
+  MonocleOLEDMenuRenderer renderer(&oled);
+  MonocleMenu menu(renderer);
+  MonocleEventBus bus;
+  menu.publishTo(&bus);
+  CHECK(client.subscribeTo(&bus));
+  CHECK(bus.subscribe(MONOCLE_EVENT_MENU, onMenu));
+
+  // three cameras in the gateway list
+  menu.updateCameras(3, 0, 2);
+  CHECK(menu.setCamera(0, "camera-front", "Front Door", true));
+  CHECK(menu.setCamera(1, "camera-drive", "Driveway", false));
+  CHECK(menu.setCamera(2, "camera-porch", "Porch", false));
+
+  // the event carries the uuid; the client selects that camera
+  selectCamera(menu, oled, 2);
+  menu.loop();
+  bus.loop();
+  CHECK(published == "camera-drive");
+  CHECK_EQ(publishedValue, 0);
+  CHECK(!link.commands.empty() && link.commands.back() == "CAMERA:camera-drive");
+
+  // the first camera is removed before the event is dispatched: the
+  // selection still names the camera the user picked
+  size_t sent = link.commands.size();
+  selectCamera(menu, oled, 3);
+  menu.loop();
+  menu.updateCameras(2, 0, 1);
+  menu.setCamera(0, "camera-drive", "Driveway", true);
+  menu.setCamera(1, "camera-porch", "Porch", false);
+  bus.loop();
+  CHECK(published == "camera-porch");
+  CHECK_EQ(link.commands.size(), sent + 1);
+  CHECK(link.commands.back() == "CAMERA:camera-porch");
+
+  return hostTestResult("menu_camera");
+}
@@ -0,0 +1,162 @@
+/*
+ * MonocleMotionPlanner: the PTZ command timeline received by a loopback
+ * gateway is integrated independently (per-level rates between the
+ * receive times) and checked against the requested motion: final
+ * positions of absolute, relative and retargeted (reversing) moves,
+ * at most one speed level change per command, no stream gaps longer
+ * than the stream interval, and a safe STOP when the link drops or the
+ * planner stops being serviced.
+ */
+#include <HostArduino.h>
+#include <HostTest.h>
+#include <HostNetwork.h>
+#include <string>
+#include "MonocleMotionPlanner.h"
+
+static const float rates[MONOCLE_AXES][4] = {
+  { 0, 5.0, 15.0, 45.0 }, { 0, 5.0, 15.0, 45.0 }, { 0, 0.25, 0.5, 1.0 }
+};
+
+static int completions = 0, aborts = 0;
+static void onComplete(const bool completed) {
+  if(completed) completions++;
+  else aborts++;
+}
+
+/* RESULT OF INTEGRATING A COMMAND TIMELINE */
+struct Timeline {
+  float position[MONOCLE_AXES];
+  int commands;
+  int maxStep;                  // largest speed level change between commands
+  unsigned long maxGap;         // longest time between commands while moving
+  bool stopped;                 // the last command is a STOP
+};
+
+/* PARSE A COMMAND INTO SPEED LEVELS; RETURNS 'false' FOR NON-MOVEMENT COMMANDS */
+static bool levels(const std::string& command, int* level) {
+  if(command == "STOP"){ level[0] = level[1] = level[2] = 0; return true; }
+  return sscanf(command.c_str(), "PTZ:%d:%d:%d", &level[0], &level[1], &level[2]) == 3;
+}
+
+/* INTEGRATE THE MOVEMENT COMMANDS RECEIVED SINCE 'from' STARTING AT 'start' */
+static Timeline integrate(HostLoopbackGateway& link, size_t from, const float* start) {
+  Timeline timeline = { { start[0], start[1], start[2] }, 0, 0, 0, false };
+  int current[MONOCLE_AXES] = { 0, 0, 0 };
+  unsigned long time = 0;
+  for(size_t index = from; index < link.commands.size(); index++){
+    int next[MONOCLE_AXES];
+    if(!levels(link.commands[index], next)) continue;
+    unsigned long now = link.commandTimes[index];
+    bool moving = current[0] != 0 || current[1] != 0 || current[2] != 0;
+    if(timeline.commands > 0 && moving){
+      for(int axis = 0; axis < MONOCLE_AXES; axis++){
+        float rate = rates[axis][abs(current[axis])];
+        timeline.position[axis] += (current[axis] < 0 ? -rate : rate) * (now - time) / 1000.0f;
+      }
+      if(now - time > timeline.maxGap) timeline.maxGap = now - time;
+    }
+    for(int axis = 0; axis < MONOCLE_AXES; axis++){
+      // (a reversal between the two slow speeds counts as one step)
+      int step = abs(next[axis] - current[axis]) - (next[axis] * current[axis] < 0 ? 1 : 0);
+      if(step > timeline.maxStep) timeline.maxStep = step;
+      current[axis] = next[axis];
+    }
+    time = now;
+    timeline.commands++;
+    timeline.stopped = link.commands[index] == "STOP";
+  }
+  return timeline;
+}
+
+/* SERVICE THE PLANNER EVERY TASK INTERVAL UNTIL THE MOVE ENDS (OR 'limit' MS) */
+static void run(MonocleMotionPlanner& planner, MonocleGatewayClient& client, unsigned long limit) {
+  unsigned long start = millis();
+  while(planner.isMoving() && millis() - start < limit){
+    planner.loop();
+    client.loop();
+    hostAdvance(MONOCLE_MOTION_TASK_INTERVAL);
+  }
+  planner.loop();
+}
+
+/* CHECK AN INTEGRATED TIMELINE AGAINST THE EXPECTED FINAL POSITION */
+static void expect(const Timeline& timeline, float pan, float tilt, float zoom) {
+  CHECK_RANGE(timeline.position[MONOCLE_AXIS_PAN], pan - 0.05f, pan + 0.05f);
+  CHECK_RANGE(timeline.position[MONOCLE_AXIS_TILT], tilt - 0.05f, tilt + 0.05f);
+  CHECK_RANGE(timeline.position[MONOCLE_AXIS_ZOOM], zoom - 0.01f, zoom + 0.01f);
+  CHECK_EQ(timeline.maxStep, 1);
+  CHECK_RANGE(timeline.maxGap, 1, MONOCLE_MOTION_STREAM_INTERVAL + MONOCLE_MOTION_TASK_INTERVAL);
+  CHECK(timeline.stopped);
+}
+
+int main() {
+  hostSetTime(1000);
+  HostLoopbackGateway link;
+  MonocleGatewayClient client(link, "127.0.0.1", 8080);
+  client.begin();
+  client.loop();
+  MonocleMotionPlanner planner(client);
+  planner.onComplete(onComplete);
+
+  // absolute move after homing: trapezoidal on pan and tilt, slow on zoom
+  planner.home();
+  size_t from = link.commands.size();
+  CHECK(planner.moveTo(30, -10, 2));
+  run(planner, client, 10000);
+  float origin[MONOCLE_AXES] = { 0, 0, 0 };
+  Timeline timeline = integrate(link, from, origin);
+  expect(timeline, 30, -10, 2);
+  CHECK_RANGE(planner.position(MONOCLE_AXIS_PAN), 29.95f, 30.05f);
+  CHECK_EQ(completions, 1);
+  printf("motion_timeline: moveTo(30, -10, 2): %d commands, reached %.3f, %.3f, %.3f\n", timeline.commands,
+         timeline.position[0], timeline.position[1], timeline.position[2]);
+
+  // a nudge shorter than one slow interval
+  from = link.commands.size();
+  CHECK(planner.move(0.3f, 0, 0));
+  run(planner, client, 2000);
+  float start[MONOCLE_AXES] = { 30, -10, 2 };
+  timeline = integrate(link, from, start);
+  expect(timeline, 30.3f, -10, 2);
+  CHECK_EQ(timeline.commands, 2);   // one slow PTZ, then the STOP
+
+  // retarget into a reversal half way through a long pan
+  from = link.commands.size();
+  CHECK(planner.move(60, 0, 0));
+  run(planner, client, 700);
+  CHECK(planner.isMoving());
+  CHECK(planner.moveTo(0, 0, 0));
+  run(planner, client, 10000);
+  start[MONOCLE_AXIS_PAN] = 30.3f;
+  timeline = integrate(link, from, start);
+  expect(timeline, 0, 0, 0);
+  CHECK_EQ(completions, 3);
+  printf("motion_timeline: reversing retarget: %d commands, reached %.3f, %.3f, %.3f\n", timeline.commands,
+         timeline.position[0], timeline.position[1], timeline.position[2]);
+
+  // the link drops: the move is aborted and the STOP follows the reconnect
+  from = link.commands.size();
+  CHECK(planner.move(40, 0, 0));
+  run(planner, client, 300);
+  link.drop();
+  planner.loop();
+  CHECK(!planner.isMoving());
+  CHECK(!planner.isReferenced());
+  CHECK_EQ(aborts, 1);
+  CHECK(link.commands.back() != "STOP");
+  client.begin();
+  planner.loop();
+  CHECK(link.commands.back() == "STOP");
+
+  // a stalled main loop: the next service aborts the move with a STOP
+  planner.setPosition(0, 0, 0);
+  CHECK(planner.move(40, 0, 0));
+  run(planner, client, 300);
+  hostAdvance(MONOCLE_MOTION_TIMEOUT + 100);
+  planner.loop();
+  CHECK(!planner.isMoving());
+  CHECK_EQ(aborts, 2);
+  CHECK(link.commands.back() == "STOP");
+
+  return hostTestResult("motion_timeline");
+}
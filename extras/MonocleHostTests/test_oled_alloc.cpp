@@ -0,0 +1,99 @@
+/*
+ * MonocleOLED / MonocleOLEDMenuRenderer: a menu redraw (runtime and
+ * flash menus) and the 'const char*' / printf-style text API perform
+ * no heap allocation.  Allocations are counted by replacing the global
+ * 'operator new' (and 'malloc' / 'realloc' on glibc).
+ */
+#include <HostArduino.h>
+#include <HostTest.h>
+#include <new>
+#include "MonocleOLED.h"
+#include "MonocleOLEDMenuRenderer.h"
+#include "MonocleMenu.h"
+#include "MonocleFlashMenu.h"
+
+static bool counting = false;
+static unsigned long allocations = 0;
+
+void* operator new(size_t size) {
+  if(counting) allocations++;
+  void* memory = malloc(size ? size : 1);
+  if(memory == NULL) throw std::bad_alloc();
+  return memory;
+}
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* memory) noexcept { free(memory); }
+void operator delete[](void* memory) noexcept { free(memory); }
+void operator delete(void* memory, size_t) noexcept { free(memory); }
+void operator delete[](void* memory, size_t) noexcept { free(memory); }
+
+#if defined(__GLIBC__)
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_realloc(void* memory, size_t size);
+extern "C" void* __libc_calloc(size_t count, size_t size);
+extern "C" void __libc_free(void* memory);
+extern "C" void* malloc(size_t size) { if(counting) allocations++; return __libc_malloc(size); }
+extern "C" void* realloc(void* memory, size_t size) { if(counting) allocations++; return __libc_realloc(memory, size); }
+extern "C" void* calloc(size_t count, size_t size) { if(counting) allocations++; return __libc_calloc(count, size); }
+extern "C" void free(void* memory) { __libc_free(memory); }
+#endif
+
+static void begin() { allocations = 0; counting = true; }
+static unsigned long end() { counting = false; return allocations; }
+
+int main() {
+  MonocleOLED oled(128, 64);
+  MonocleOLEDMenuRenderer renderer(&oled);
+  MonocleMenu menu(renderer);
+  oled.init();
+
+  // the counter itself works: the 'String' API allocates
+  begin();
+  oled.printText(String("PAN SPEED LEVEL ") + String(3), String("TILT"), "", "", false, true);
+  CHECK(end() > 0);
+
+  // the 'const char*' and printf-style API does not
+  begin();
+  oled.printText("PAN", "TILT", "ZOOM", "", false, true);
+  oled.printLine(1, "Front Door", false, true);
+  oled.printLinef(3, false, false, "%s %d/%d", "Preset", 3, 9);
+  oled.printLine3("centered", true, true);
+  CHECK_EQ(end(), 0);
+  // text rows start below the logo (row 3 is line 0)
+  CHECK(strncmp(oled.text(4), "      Front Door", 16) == 0);
+  CHECK(strncmp(oled.text(5), "       centered ", 16) == 0);
+  CHECK(strncmp(oled.text(6), "Preset 3/9", 10) == 0);
+
+  // runtime menu: open, scroll through every item and back
+  menu.activate();
+  menu.loop();
+  begin();
+  for(int step = 0; step < 12; step++){ menu.next(); menu.loop(); }
+  for(int step = 0; step < 12; step++){ menu.prev(); menu.loop(); }
+  menu.refresh();
+  menu.loop();
+  CHECK_EQ(end(), 0);
+  CHECK(strncmp(oled.text(3), "> [EXIT]", 8) == 0);
+
+  // the preset list rebuilt by the gateway reuses the preallocated pool
+  begin();
+  menu.clearPresets();
+  menu.addPreset("Driveway");
+  menu.addPreset("Porch");
+  menu.next(); menu.next(); menu.select(); menu.loop();
+  menu.next(); menu.loop();
+  CHECK_EQ(end(), 0);
+  menu.deactivate();
+
+  // flash menu
+  MonocleFlashMenu flash(MONOCLE_DEFAULT_MENU, MONOCLE_DEFAULT_MENU_SIZE, renderer);
+  flash.activate();
+  flash.loop();
+  begin();
+  flash.next(); flash.next(); flash.select(); flash.loop();
+  for(int step = 0; step < 10; step++){ flash.next(); flash.loop(); }
+  flash.back(); flash.loop();
+  CHECK_EQ(end(), 0);
+
+  return hostTestResult("oled_alloc");
+}
@@ -0,0 +1,149 @@
+/*
+ * MonoclePowerManager: a simulated 24 hour day of a battery powered
+ * D-pad controller (four usage sessions, the rest untouched).  The pad,
+ * event bus and power manager run as scheduler tasks; between deadlines
+ * the simulation sleeps until the next deadline (or pin change) the way
+ * the scheduler idle callback lets the MCU sleep.  Reports the active
+ * duty cycle, scheduler wake-ups and the estimated average current,
+ * against an always-awake controller (active current all day).
+ */
+#include <HostArduino.h>
+#include <HostTest.h>
+#include "MonoclePowerManager.h"
+#include "MonocleDigitalPad.h"
+#include "MonocleEventBus.h"
+#include "MonocleScheduler.h"
+#include "MonocleOLED.h"
+
+#define PIN_UP    2
+#define PIN_DOWN  3
+#define PIN_LEFT  4
+#define PIN_RIGHT 5
+#define PIN_FIRE  6
+
+#define HOUR   3600000UL
+#define MINUTE 60000UL
+#define DAY    (24 * HOUR)
+
+/* ONE PIN LEVEL CHANGE OF THE USAGE TRACE */
+struct Edge {
+  unsigned long time;
+  int pin;
+  int level;
+};
+
+static Edge trace[2048];
+static int traceCount = 0;
+static unsigned long radioSleepTime = 0, radioSleepStart = 0;
+static bool radioAsleep = false;
+static unsigned long wakeLatency = 0;
+
+static void add(unsigned long time, int pin, int level) {
+  Edge edge = { time, pin, level };
+  if(traceCount < 2048) trace[traceCount++] = edge;
+}
+
+/* A USAGE SESSION: A FIRE CLICK, THEN A DIRECTION HELD 1..5 S EVERY 20..40 S */
+static unsigned long seed = 2018;
+static void session(unsigned long start, unsigned long length) {
+  add(start, PIN_FIRE, LOW);
+  add(start + 150, PIN_FIRE, HIGH);
+  for(unsigned long time = start + 2000; time < start + length; ){
+    seed = seed * 1103515245UL + 12345UL;
+    int pin = PIN_UP + (seed >> 16) % 4;
+    unsigned long held = 1000 + (seed >> 8) % 4000;
+    add(time, pin, LOW);
+    add(time + held, pin, HIGH);
+    time += held + 20000 + (seed >> 4) % 20000;
+  }
+}
+
+static void onRadioSleep(const bool sleep) {
+  if(sleep && !radioAsleep) radioSleepStart = millis();
+  if(!sleep && radioAsleep) radioSleepTime += millis() - radioSleepStart;
+  radioAsleep = sleep;
+}
+
+int main() {
+  hostSetTime(0);
+  MonocleScheduler scheduler;
+  MonocleEventBus bus;
+  MonocleDigitalPad pad;
+  MonoclePowerManager power;
+  MonocleOLED oled(128, 64);
+  oled.init();
+
+  pad.setupPins(PIN_UP, PIN_DOWN, PIN_LEFT, PIN_RIGHT, PIN_FIRE);
+  pad.publishTo(&bus);
+  bus.schedule(scheduler);
+  int padTask = pad.schedule(scheduler);
+  power.schedule(scheduler);
+  power.subscribeTo(&bus);
+  power.setDisplay(&oled);
+  power.onRadioSleep(onRadioSleep);
+  power.attachWakePin(PIN_FIRE);
+  CHECK(power.manage(padTask, MONOCLE_PAD_DEFAULT_SAMPLE_INTERVAL, 20, 100));
+
+  // morning, lunch, evening and late night sessions
+  session(7 * HOUR + 30 * MINUTE, 10 * MINUTE);
+  session(12 * HOUR + 15 * MINUTE, 5 * MINUTE);
+  session(19 * HOUR, 45 * MINUTE);
+  session(22 * HOUR, 2 * MINUTE);
+  CHECK(traceCount < 2048);
+
+  // run the day: apply due pin changes, dispatch the scheduler, then
+  // sleep until the next deadline or the next pin change
+  unsigned long wakeups[MONOCLE_POWER_STATES] = { 0, 0, 0 };
+  int next = 0;
+  unsigned long pressTime = 0;
+  bool blankSeen = false, dimSeen = false;
+  while(millis() < DAY){
+    while(next < traceCount && trace[next].time <= millis()){
+      if(trace[next].pin == PIN_FIRE && trace[next].level == LOW && power.state() == MONOCLE_POWER_SLEEP)
+        pressTime = millis();
+      hostSetPin(trace[next].pin, trace[next].level);
+      next++;
+    }
+    wakeups[power.state()]++;
+    scheduler.loop();
+    if(pressTime != 0 && power.state() == MONOCLE_POWER_ACTIVE){
+      if(millis() - pressTime > wakeLatency) wakeLatency = millis() - pressTime;
+      pressTime = 0;
+    }
+    blankSeen |= !oled.on;
+    dimSeen |= oled.dimmed;
+
+    unsigned long sleep = scheduler.idleTime();
+    if(next < traceCount && trace[next].time - millis() < sleep) sleep = trace[next].time - millis();
+    if(millis() + sleep > DAY) sleep = DAY - millis();
+    if(sleep > 0) hostAdvance(sleep);
+  }
+  if(radioAsleep) radioSleepTime += millis() - radioSleepStart;
+
+  unsigned long total = power.timeIn(MONOCLE_POWER_ACTIVE) + power.timeIn(MONOCLE_POWER_IDLE) + power.timeIn(MONOCLE_POWER_SLEEP);
+  CHECK_EQ(total, DAY);
+  CHECK_RANGE(power.wakes(), 4, 100);   // every session wakes it; pauses over 30 s idle it
+  CHECK_RANGE(wakeLatency, 0, 1);       // the wake pin interrupt triggers the power task
+  CHECK(blankSeen && dimSeen);
+  CHECK(power.dutyCycle() < 5.0);
+  CHECK(power.averageCurrent() < 30.0);
+
+  // a sleeping controller wakes about twenty times per second (the 100 ms
+  // pad and power tasks are out of phase) instead of 100+ times while active
+  float sleepRate = wakeups[MONOCLE_POWER_SLEEP] / (power.timeIn(MONOCLE_POWER_SLEEP) / 1000.0);
+  float activeRate = wakeups[MONOCLE_POWER_ACTIVE] / (power.timeIn(MONOCLE_POWER_ACTIVE) / 1000.0);
+  CHECK(sleepRate < 25.0);
+  CHECK(activeRate > 200.0);
+
+  printf("power_day: active %.1f min, idle %.1f min, sleep %.1f h; duty cycle %.2f %%\n",
+         power.timeIn(MONOCLE_POWER_ACTIVE) / 60000.0, power.timeIn(MONOCLE_POWER_IDLE) / 60000.0,
+         power.timeIn(MONOCLE_POWER_SLEEP) / 3600000.0, power.dutyCycle());
+  printf("power_day: scheduler wake-ups/s active %.0f, idle %.0f, sleep %.1f; radio modem-sleep %.1f h\n",
+         activeRate, wakeups[MONOCLE_POWER_IDLE] / (power.timeIn(MONOCLE_POWER_IDLE) / 1000.0), sleepRate,
+         radioSleepTime / 3600000.0);
+  printf("power_day: average current %.1f mA (%.0f mAh/day) vs %.1f mA always awake (%.0f mAh/day)\n",
+         power.averageCurrent(), power.averageCurrent() * 24, MONOCLE_POWER_DEFAULT_ACTIVE_CURRENT,
+         MONOCLE_POWER_DEFAULT_ACTIVE_CURRENT * 24);
+
+  return hostTestResult("power_day");
+}
@@ -0,0 +1,149 @@
+/*
+ * MonocleRecorder / MonocleReplayer harness: a control session (joystick
+ * sweeps, D-pad presses and a fire click driving a gateway client) is
+ * recorded, dumped and loaded back, then replayed through fresh
+ * components.  The replayed command stream must equal the recorded one
+ * on the wire and in the recording, with no input-to-command latency
+ * difference; a build with a slower joystick event delay shows up as a
+ * latency difference and, once movements coalesce, as a mismatch.
+ */
+#include <HostArduino.h>
+#include <HostTest.h>
+#include <HostNetwork.h>
+#include <string>
+#include "MonocleRecorder.h"
+#include "MonoclePTZJoystick.h"
+#include "MonocleDigitalPad.h"
+#include "MonocleGatewayClient.h"
+
+#define PIN_PAN   20
+#define PIN_TILT  21
+#define PIN_UP    2
+#define PIN_DOWN  3
+#define PIN_LEFT  4
+#define PIN_RIGHT 5
+#define PIN_FIRE  6
+
+#define SESSION_LENGTH 3000   // milliseconds
+
+/* DUMP TARGET */
+struct Buffer : public Print {
+  std::string data;
+  size_t write(uint8_t c) { data += (char)c; return 1; }
+  using Print::write;
+};
+
+/* ONE INPUT CHANGE OF THE LIVE SESSION (ANALOG PIN VALUE OR PAD PIN LEVEL) */
+struct Input {
+  unsigned long time;
+  int pin;
+  int value;
+};
+
+static const Input session[] = {
+  { 100, PIN_PAN, 4095 }, { 450, PIN_PAN, 3300 }, { 800, PIN_PAN, 2048 },
+  { 1000, PIN_TILT, 0 }, { 1400, PIN_TILT, 2048 },
+  { 1600, PIN_RIGHT, LOW }, { 1900, PIN_RIGHT, HIGH },
+  { 2100, PIN_UP, LOW }, { 2350, PIN_UP, HIGH },
+  { 2600, PIN_FIRE, LOW }, { 2700, PIN_FIRE, HIGH },
+};
+
+static MonocleGatewayClient* client = NULL;
+static void onPTZ(int pan, int tilt, int zoom) { client->ptz(pan, tilt, zoom); }
+static void onPress() { client->home(); }
+
+/*
+ * RUN A SESSION: LIVE INPUTS (NO REPLAYER) OR A REPLAYED RECORDING;
+ * EVERYTHING IS RECORDED TO 'recorder' AND THE WIRE COMMANDS RETURNED
+ */
+static std::vector<std::string> run(MonocleRecorder& recorder, MonocleRecorder* replay, unsigned int eventDelay) {
+  hostSetAnalog(PIN_PAN, 2048);
+  hostSetAnalog(PIN_TILT, 2048);
+  HostLoopbackGateway link;
+  MonocleGatewayClient gateway(link, "127.0.0.1", 8080);
+  client = &gateway;
+  gateway.begin();
+  gateway.loop();
+
+  MonoclePTZJoystick joystick;
+  joystick.setupPan(PIN_PAN, 12);
+  joystick.setupTilt(PIN_TILT, 12);
+  joystick.setPTZEventDelay(eventDelay);
+  joystick.onPTZ(onPTZ);
+  MonocleDigitalPad pad;
+  pad.setupPins(PIN_UP, PIN_DOWN, PIN_LEFT, PIN_RIGHT, PIN_FIRE);
+  pad.onPTZ(onPTZ);
+  pad.onButtonPress(onPress);
+
+  recorder.clear();
+  joystick.recordTo(&recorder);
+  pad.recordTo(&recorder);
+  gateway.recordTo(&recorder);
+
+  MonocleReplayer replayer(replay != NULL ? *replay : recorder);
+  if(replay != NULL){
+    replayer.attach(joystick);
+    replayer.attach(pad);
+    replayer.begin();
+  }
+
+  size_t next = 0;
+  for(unsigned long elapsed = 0; elapsed < SESSION_LENGTH; elapsed++){
+    while(replay == NULL && next < sizeof(session) / sizeof(session[0]) && session[next].time <= elapsed){
+      if(session[next].pin == PIN_PAN || session[next].pin == PIN_TILT) hostSetAnalog(session[next].pin, session[next].value);
+      else hostSetPin(session[next].pin, session[next].value);
+      next++;
+    }
+    if(replay != NULL) replayer.loop();
+    joystick.loop();
+    pad.loop();
+    gateway.loop();
+    hostAdvance(1);
+  }
+  replayer.end();
+  client = NULL;
+  return link.commands;
+}
+
+int main() {
+  hostSetTime(1000);
+
+  // record the live session and round-trip it through the dump format
+  MonocleRecorder live;
+  std::vector<std::string> wire = run(live, NULL, JOYSTICK_DEFAULT_PTZ_EVENT_DELAY);
+  CHECK_EQ(live.dropped(), 0);
+  CHECK(wire.size() >= 8);
+  Buffer dump;
+  live.dump(dump);
+  MonocleRecorder loaded;
+  CHECK(loaded.load((const uint8_t*)dump.data.data(), dump.data.size()));
+  CHECK_EQ(loaded.size(), live.size());
+
+  // the replay reproduces the command stream with the same latencies
+  MonocleRecorder replayed;
+  std::vector<std::string> replayWire = run(replayed, &loaded, JOYSTICK_DEFAULT_PTZ_EVENT_DELAY);
+  CHECK(replayWire == wire);
+  MonocleReplayResult result;
+  CHECK(MonocleRecorder::compare(loaded, replayed, result));
+  CHECK_EQ(result.expected, wire.size());
+  CHECK_EQ(result.matched, result.expected);
+  CHECK_EQ(result.maxLatencyDelta, 0);
+  printf("replay: %d entries (%u bytes dumped), %u commands matched, max latency delta %lu ms\n",
+         live.size(), (unsigned)dump.data.size(), result.matched, result.maxLatencyDelta);
+
+  // a build with a 150 ms joystick event delay: same commands, joystick ones 50 ms later
+  std::vector<std::string> slowWire = run(replayed, &loaded, 150);
+  CHECK(slowWire == wire);
+  CHECK(MonocleRecorder::compare(loaded, replayed, result));
+  CHECK_RANGE(result.maxLatencyDelta, 50, 51);
+  printf("replay: 150 ms event delay: %u commands matched, max latency delta %lu ms\n",
+         result.matched, result.maxLatencyDelta);
+
+  // a 400 ms delay (restarted by every change) swallows the 400 ms tilt movement: reported as a mismatch
+  run(replayed, &loaded, 400);
+  CHECK(!MonocleRecorder::compare(loaded, replayed, result));
+  CHECK_RANGE(result.firstMismatch, 0, result.expected - 1);
+  printf("replay: 400 ms event delay: first mismatch at command %d of %u\n", result.firstMismatch, result.expected);
+
+  return hostTestResult("replay");
+}
@@ -0,0 +1,176 @@
+/*
+ * MonocleScheduler: due tasks run in deadline order (min-heap, checked
+ * with shuffled and rescheduled deadlines), periodic tasks keep their
+ * phase without drift, and the per-task statistics count budget
+ * overruns, skipped deadlines and lateness.  Triggered tasks, one-shot
+ * release, suspend / resume and the idle callback are covered too, and
+ * a periodic task overrunning its own period runs once per 'loop()'.
+ */
+#include <HostArduino.h>
+#include <HostTest.h>
+#include "MonocleScheduler.h"
+
+static int order[64];
+static int orderCount = 0;
+static unsigned long runTimes[256];
+static int runCount = 0;
+static unsigned long idleGiven = 0;
+
+static void record(void* context) {
+  if(orderCount < 64) order[orderCount++] = (int)(intptr_t)context;
+}
+static void periodic(void* context) {
+  if(runCount < 256) runTimes[runCount++] = millis();
+}
+static void busy(void* context) {
+  // every third run takes 800 us (the budget is 500 us)
+  static int runs = 0;
+  hostAdvanceMicros((++runs % 3 == 0) ? 800 : 100);
+}
+static void selfCancel(void* context) {
+  ((MonocleScheduler*)context)->cancel(0);
+}
+static int overrunRuns = 0;
+static void overrun(void* context) {
+  // takes three of its 10 ms periods
+  overrunRuns++;
+  hostAdvance(30);
+}
+static void onIdle(unsigned long milliseconds) {
+  idleGiven = milliseconds;
+}
+
+int main() {
+  hostSetTime(1000);
+
+  // deadline order: one-shots created in shuffled order all run in deadline order
+  {
+    MonocleScheduler scheduler;
+    unsigned long delays[MONOCLE_SCHEDULER_MAX_TASKS];
+    unsigned long seed = 99;
+    for(int i = 0; i < MONOCLE_SCHEDULER_MAX_TASKS; i++){
+      // unique delays 0..(MAX*13) in a pseudo random order
+      seed = seed * 1103515245UL + 12345UL;
+      delays[i] = i * 13;
+      int j = (seed >> 16) % (i + 1);
+      unsigned long swap = delays[i]; delays[i] = delays[j]; delays[j] = swap;
+    }
+    for(int i = 0; i < MONOCLE_SCHEDULER_MAX_TASKS; i++)
+      CHECK_EQ(scheduler.after(delays[i], record, (void*)(intptr_t)i), i);
+    CHECK_EQ(scheduler.after(5, record), MONOCLE_TASK_INVALID);   // table full
+
+    // move two deadlines; the heap must reorder them
+    scheduler.reschedule(0, 500);
+    scheduler.reschedule(MONOCLE_SCHEDULER_MAX_TASKS - 1, 1);
+    delays[0] = 500;
+    delays[MONOCLE_SCHEDULER_MAX_TASKS - 1] = 1;
+
+    hostAdvance(1000);
+    orderCount = 0;
+    scheduler.loop();
+    CHECK_EQ(orderCount, MONOCLE_SCHEDULER_MAX_TASKS);
+    bool ordered = true;
+    for(int i = 1; i < orderCount; i++) ordered &= delays[order[i - 1]] < delays[order[i]];
+    CHECK(ordered);
+    CHECK_EQ(scheduler.taskCount(), 0);   // one-shots are released after they run
+  }
+
+  // periodic tasks: drift free deadlines although 'loop()' runs every 3 ms
+  {
+    MonocleScheduler scheduler;
+    int task = scheduler.every(10, periodic);
+    runCount = 0;
+    unsigned long start = millis();
+    for(int elapsed = 0; elapsed < 1000; elapsed += 3){
+      scheduler.loop();
+      hostAdvance(3);
+    }
+    CHECK_EQ(runCount, 100);
+    CHECK(runTimes[99] - start >= 990 && runTimes[99] - start <= 992);
+    const MonocleTaskStats* stats = scheduler.stats(task);
+    CHECK_EQ(stats->runs, 100);
+    CHECK_RANGE(stats->maxLateness, 0, 2);
+    CHECK_EQ(stats->skipped, 0);
+
+    // a 55 ms stall skips five deadlines and keeps the phase
+    hostAdvance(55 - (millis() - start) % 10);
+    scheduler.loop();
+    CHECK_EQ(stats->skipped, 5);
+    CHECK_EQ(scheduler.idleTime(), 10 - (millis() - start) % 10);
+  }
+
+  // budget overruns: one in three runs exceeds the 500 us budget
+  {
+    MonocleScheduler scheduler;
+    int task = scheduler.every(5, busy, NULL, 500);
+    for(int i = 0; i < 300; i++){
+      scheduler.loop();
+      hostAdvance(5);
+    }
+    const MonocleTaskStats* stats = scheduler.stats(task);
+    // (the simulated execution time moves the clock, adding a few runs)
+    CHECK_RANGE(stats->runs, 300, 330);
+    CHECK_EQ(stats->overruns, stats->runs / 3);
+    CHECK_EQ(stats->maxDuration, 800);
+    scheduler.resetStats();
+    CHECK_EQ(stats->runs, 0);
+  }
+
+  // triggered tasks run once per loop, before due tasks, from any context
+  {
+    MonocleScheduler scheduler;
+    int due = scheduler.after(0, record, (void*)1);
+    int event = scheduler.triggered(record, (void*)2);
+    orderCount = 0;
+    scheduler.trigger(event);
+    scheduler.triggerFromISR(event);
+    scheduler.loop();
+    CHECK_EQ(orderCount, 2);
+    CHECK_EQ(order[0], 2);
+    CHECK_EQ(order[1], 1);
+    scheduler.loop();
+    CHECK_EQ(orderCount, 2);
+    CHECK(scheduler.stats(due) == NULL);
+  }
+
+  // suspend, resume, cancel from the callback and the idle callback
+  {
+    MonocleScheduler scheduler;
+    scheduler.onIdle(onIdle);
+    int cancelled = scheduler.every(20, selfCancel, &scheduler);
+    int task = scheduler.every(50, record, (void*)3);
+    CHECK_EQ(cancelled, 0);
+    orderCount = 0;
+    scheduler.loop();
+    CHECK_EQ(orderCount, 1);
+    CHECK_EQ(scheduler.taskCount(), 1);
+    CHECK_EQ(idleGiven, 50);
+    scheduler.suspend(task);
+    hostAdvance(200);
+    scheduler.loop();
+    CHECK_EQ(orderCount, 1);
+    CHECK_EQ(idleGiven, MONOCLE_SCHEDULER_MAX_IDLE);
+    scheduler.resume(task);
+    scheduler.loop();
+    CHECK_EQ(orderCount, 2);
+    CHECK(scheduler.setPeriod(task, 30));
+    hostAdvance(50);
+    scheduler.loop();
+    CHECK_EQ(idleGiven, 30);
+  }
+
+  // a periodic task overrunning its own period runs once per loop,
+  // the deadlines it missed are skipped
+  {
+    MonocleScheduler scheduler;
+    int task = scheduler.every(10, overrun);
+    hostAdvance(10);
+    for(int pass = 1; pass <= 5; pass++){
+      scheduler.loop();
+      CHECK_EQ(overrunRuns, pass);
+    }
+    CHECK(scheduler.stats(task)->skipped >= 8);
+  }
+
+  return hostTestResult("scheduler");
+}
@@ -0,0 +1,123 @@
+/*
+ * MonocleGatewayClient camera sessions against the gateway emulator
+ * (a stand-in gateway with four cameras that logs every command with
+ * its camera): each camera receives its commands in the order they
+ * were queued, sessions are flushed round-robin (the n-th command of
+ * any camera is never sent before every camera with at least n queued
+ * commands has been sent its (n-1)-th), and a burst of PTZ updates for
+ * one camera collapses to the latest vector without delaying the rest.
+ */
+#include <HostArduino.h>
+#include <HostTest.h>
+#include <HostNetwork.h>
+#include <HostEmulator.h>
+#include <map>
+#include "MonocleGatewayClient.h"
+
+static const char* cameras[] = { "emulator-camera-1", "emulator-camera-2", "emulator-camera-3", "emulator-camera-4" };
+
+/* SERVICE THE CLIENT UNTIL THE EMULATOR HAS LOGGED 'count' COMMANDS (OR 3 SECONDS) */
+static std::vector<HostEmulatorCommand> drain(MonocleGatewayClient& client, HostEmulator& emulator, size_t count) {
+  std::vector<HostEmulatorCommand> commands;
+  unsigned long start = millis();
+  while(millis() - start < 3000){
+    client.loop();
+    commands = emulator.commands();
+    if(commands.size() >= count && client.pending() == 0) break;
+    delay(5);
+  }
+  return commands;
+}
+
+int main() {
+  hostUseRealTime(true);
+  HostEmulator emulator;
+  if(!CHECK(emulator.start({ "--cameras", "1", "--no-discovery" }))) return hostTestResult("sessions");
+
+  HostTcpClient tcp;
+  MonocleGatewayClient client(tcp, "127.0.0.1", emulator.port);
+  client.begin();
+  unsigned long start = millis();
+  while(!client.connected() && millis() - start < 2000) delay(5);
+  CHECK(client.connected());
+  client.loop();
+
+  // queue different length sequences for four cameras without servicing
+  // the client: camera 1 gets 8 commands, camera 2 six, camera 3 three and
+  // camera 4 one (presets and homes are never coalesced)
+  int lengths[] = { 8, 6, 3, 1 };
+  std::map<std::string, std::vector<std::string> > expected;
+  for(int round = 0; round < 8; round++){
+    for(int camera = 0; camera < 4; camera++){
+      if(round >= lengths[camera]) continue;
+      std::string prefix = std::string("@") + cameras[camera] + ":";
+      if(round % 3 == 2){
+        CHECK(client.home(cameras[camera]));
+        expected[cameras[camera]].push_back(prefix + "HOME");
+      }
+      else {
+        CHECK(client.preset(cameras[camera], round + 1));
+        expected[cameras[camera]].push_back(prefix + "PRESET:#" + std::to_string(round));
+      }
+    }
+  }
+  CHECK_EQ(client.pending(), 18);
+
+  std::vector<HostEmulatorCommand> received = drain(client, emulator, 18);
+  CHECK_EQ(received.size(), 18);
+
+  // per-camera order is the queued order
+  std::map<std::string, std::vector<std::string> > actual;
+  for(size_t i = 0; i < received.size(); i++) actual[received[i].camera].push_back(received[i].raw);
+  for(int camera = 0; camera < 4; camera++)
+    CHECK(actual[cameras[camera]] == expected[cameras[camera]]);
+
+  // round-robin: the per-camera sequence number never decreases across the stream
+  std::map<std::string, int> sequence;
+  int previous = 0;
+  bool fair = true;
+  for(size_t i = 0; i < received.size(); i++){
+    int number = ++sequence[received[i].camera];
+    fair &= number >= previous;
+    previous = number;
+  }
+  CHECK(fair);
+  if(received.size() >= 4){
+    // the first round reaches all four cameras
+    CHECK(received[0].camera != received[1].camera && received[1].camera != received[2].camera &&
+          received[2].camera != received[3].camera && received[0].camera != received[3].camera);
+  }
+
+  // a PTZ burst for camera 1 (50 updates between two flushes) collapses to the
+  // latest vector, camera 2's preset still goes out, and the STOP follows
+  size_t before = received.size();
+  for(int update = 0; update < 50; update++)
+    client.ptz(cameras[0], (update % 3) + 1, -((update % 2) + 1), 0);
+  client.preset(cameras[1], 2);
+  received = drain(client, emulator, before + 2);
+  client.stop(cameras[0]);
+  received = drain(client, emulator, before + 3);
+  CHECK_EQ(received.size() - before, 3);
+  if(received.size() == before + 3){
+    actual.clear();
+    for(size_t i = before; i < received.size(); i++) actual[received[i].camera].push_back(received[i].raw);
+    std::string prefix = std::string("@") + cameras[0] + ":";
+    CHECK(actual[cameras[0]] == std::vector<std::string>({ prefix + "PTZ:2:-2:0", prefix + "STOP" }));
+    CHECK(actual[cameras[1]] == std::vector<std::string>({ std::string("@") + cameras[1] + ":PRESET:#1" }));
+  }
+  const MonocleCameraSession* session = client.session(cameras[0]);
+  CHECK(session != NULL && session->coalesced == 49 && session->pan == 0);
+
+  // all sessions are in use until one is released; commands for a camera
+  // the gateway does not know are rejected by the gateway
+  CHECK(!client.home("emulator-camera-9"));
+  client.closeSession(cameras[3]);
+  CHECK(client.home("emulator-camera-9"));
+  drain(client, emulator, 0);
+  delay(100);
+  std::vector<HostEmulatorCommand> all = emulator.commands(true);
+  CHECK(!all.empty() && all.back().status == "invalid");
+
+  emulator.kill();
+  return hostTestResult("sessions");
+}
@@ -0,0 +1,168 @@
+/*
+ * MonocleTelemetry frames sent by MonocleGatewayClient to a loopback
+ * gateway on the simulated clock: frames have the documented format
+ * and arrive once per interval while the controller is unused; a PTZ
+ * burst is never delayed (every command arrives when it is sent),
+ * the frame due during the burst is held back and counted as deferred
+ * once, and no frame arrives within the quiet time after a camera
+ * command.  Frames are not counted as commands, an interval of 0 stops
+ * them and the interval and field mask set by a gateway 'config'
+ * message are applied, saved and restored with the configuration.
+ */
+#include <HostArduino.h>
+#include <HostTest.h>
+#include <HostNetwork.h>
+#include <HostStorage.h>
+#include <string>
+#include "MonocleGatewayClient.h"
+#include "MonocleTelemetry.h"
+#include "MonocleConfig.h"
+
+#define STEP          1      // milliseconds between 'loop()' calls
+#define BURST_PERIOD  100    // milliseconds between PTZ commands of a burst
+
+static bool isFrame(const std::string& text) {
+  return text.compare(0, 10, "TELEMETRY:") == 0;
+}
+
+/* SERVICE THE CLIENT FOR 'milliseconds' */
+static void run(MonocleGatewayClient& client, unsigned long milliseconds) {
+  for(unsigned long elapsed = 0; elapsed < milliseconds; elapsed += STEP){
+    client.loop();
+    hostAdvance(STEP);
+  }
+}
+
+/*
+ * SEND A PTZ COMMAND EVERY BURST PERIOD FOR 'milliseconds'; RETURNS THE
+ * NUMBER OF COMMANDS THAT DID NOT ARRIVE AT THE TIME THEY WERE SENT
+ */
+static int burst(MonocleGatewayClient& client, HostLoopbackGateway& link, unsigned long milliseconds) {
+  int delayed = 0;
+  for(unsigned long elapsed = 0; elapsed < milliseconds; elapsed += BURST_PERIOD){
+    unsigned long sent = millis();
+    size_t received = link.commands.size();
+    client.ptz((elapsed / BURST_PERIOD) % 2 ? 1 : -1, 0, 0);
+    if(link.commands.size() != received + 1 || link.commandTimes.back() != sent) delayed++;
+    run(client, BURST_PERIOD);
+  }
+  client.stop();
+  return delayed;
+}
+
+/* NUMBER OF FRAMES RECEIVED SINCE 'from' */
+static int frames(HostLoopbackGateway& link, size_t from = 0) {
+  int count = 0;
+  for(size_t index = from; index < link.commands.size(); index++)
+    if(isFrame(link.commands[index])) count++;
+  return count;
+}
+
+/* NUMBER OF COMMANDS (NOT FRAMES) RECEIVED */
+static unsigned long commands(HostLoopbackGateway& link) {
+  return link.commands.size() - frames(link);
+}
+
+/* SHORTEST TIME BETWEEN A CAMERA COMMAND AND THE NEXT FRAME */
+static unsigned long quietGap(HostLoopbackGateway& link) {
+  unsigned long shortest = (unsigned long)-1;
+  bool command = false;
+  unsigned long commandTime = 0;
+  for(size_t index = 0; index < link.commands.size(); index++){
+    if(!isFrame(link.commands[index])){
+      command = true;
+      commandTime = link.commandTimes[index];
+    }
+    else if(command && link.commandTimes[index] - commandTime < shortest){
+      shortest = link.commandTimes[index] - commandTime;
+    }
+  }
+  return shortest;
+}
+
+/* PUSH A MESSAGE AND LET THE CLIENT PROCESS IT; RETURNS THE REPLY */
+static std::string deliver(MonocleGatewayClient& client, HostLoopbackGateway& link, const char* text) {
+  size_t sent = commands(link);
+  link.push(text);
+  for(int elapsed = 0; elapsed < 1200 && commands(link) == sent; elapsed += 10) run(client, 10);
+  for(size_t index = link.commands.size(); index > 0; index--)
+    if(!isFrame(link.commands[index - 1])) return link.commands[index - 1];
+  return "";
+}
+
+int main() {
+  hostSetTime(1000);
+  HostLoopbackGateway link;
+  MonocleGatewayClient client(link, "127.0.0.1", 8080);
+  MonocleTelemetry telemetry;
+  telemetry.setInterval(MONOCLE_TELEMETRY_MIN_INTERVAL);
+  client.reportTo(&telemetry);
+  client.begin();
+  CHECK(client.connected());
+
+  // an unused controller sends one frame per interval (the first right away)
+  run(client, 3500);
+  CHECK_EQ(frames(link), 4);
+  const std::string& first = link.commands[link.commands.size() - 4];
+  CHECK(first.compare(0, 21, "TELEMETRY:seq=0,up=1,") == 0);
+  CHECK(first.find(",conn=1,disc=0,") != std::string::npos);
+  CHECK(first.find(",defer=0,task=") != std::string::npos);
+  CHECK(link.commands.back().compare(0, 16, "TELEMETRY:seq=3,") == 0);
+
+  // a frame due during a PTZ burst waits; the burst is not delayed
+  telemetry.setFields((1 << MONOCLE_TELEMETRY_COMMANDS) | (1 << MONOCLE_TELEMETRY_DEFERRED));
+  size_t start = link.commands.size();
+  CHECK_EQ(burst(client, link, 2000), 0);
+  CHECK_EQ(frames(link, start), 0);
+  CHECK_EQ(telemetry.counter(MONOCLE_TELEMETRY_DEFERRED), 1);
+  run(client, 3000);
+  CHECK_EQ(frames(link, start), 3);
+  CHECK_EQ(burst(client, link, 1500), 0);
+  run(client, 1000);
+  CHECK_EQ(frames(link, start), 4);
+  CHECK_EQ(telemetry.counter(MONOCLE_TELEMETRY_DEFERRED), 2);
+  CHECK_RANGE(quietGap(link), MONOCLE_TELEMETRY_QUIET_TIME, 1000);
+  printf("telemetry: %d frames, %lu deferred, %lu ms shortest gap after a command\n",
+         frames(link), (unsigned long)telemetry.counter(MONOCLE_TELEMETRY_DEFERRED), quietGap(link));
+
+  // frames are not counted as commands
+  CHECK_EQ(telemetry.counter(MONOCLE_TELEMETRY_COMMANDS), commands(link));
+  char expected[48];
+  snprintf(expected, sizeof(expected), "TELEMETRY:seq=%d,cmd=%lu,defer=2", frames(link) - 1, commands(link));
+  CHECK(link.commands.back() == expected);
+
+  // an interval of 0 stops the frames; short intervals are raised to the minimum
+  telemetry.setInterval(0);
+  size_t stopped = link.commands.size();
+  run(client, 5000);
+  CHECK_EQ(frames(link, stopped), 0);
+  telemetry.setInterval(10);
+  CHECK_EQ(telemetry.interval(), MONOCLE_TELEMETRY_MIN_INTERVAL);
+
+  // the gateway sets the interval and fields; they are saved and restored
+  HostStorage storage(MONOCLE_STORAGE_FLASH_SIZE);
+  MonocleConfig config(storage);
+  config.attach(&client);
+  config.attach(&telemetry);
+  CHECK_EQ(telemetry.interval(), MONOCLE_TELEMETRY_DEFAULT_INTERVAL);
+  CHECK_EQ(telemetry.fields(), MONOCLE_TELEMETRY_ALL_FIELDS);
+  CHECK(deliver(client, link, "{\"config\":{\"telemetryInterval\":2000,\"telemetryFields\":8}}") == "CONFIG:OK");
+  CHECK_EQ(telemetry.interval(), 2000);
+  CHECK_EQ(telemetry.fields(), 1 << MONOCLE_TELEMETRY_CONNECTS);
+  size_t configured = link.commands.size();
+  run(client, 6500);
+  CHECK_EQ(frames(link, configured), 4);   // the overdue frame after the reply's quiet time, then every 2 s
+  CHECK_RANGE(quietGap(link), MONOCLE_TELEMETRY_QUIET_TIME, 1000);
+  CHECK(link.commands.back().find(",conn=1") != std::string::npos && link.commands.back().find(",cmd=") == std::string::npos);
+  CHECK(config.save());
+  MonocleConfig restored(storage);
+  CHECK(restored.load());
+  MonocleTelemetry rebooted;
+  restored.attach(&rebooted);
+  CHECK_EQ(rebooted.interval(), 2000);
+  CHECK_EQ(rebooted.fields(), 1 << MONOCLE_TELEMETRY_CONNECTS);
+  CHECK(deliver(client, link, "{\"config\":{\"telemetryInterval\":0}}") == "CONFIG:OK");
+  CHECK_EQ(telemetry.interval(), 0);
+
+  return hostTestResult("telemetry");
+}
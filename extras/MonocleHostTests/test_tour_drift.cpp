@@ -0,0 +1,116 @@
+/*
+ * MonoclePresetTour timing drift: a five preset tour with a 30 second
+ * dwell runs from a scheduler for eight simulated hours while the main
+ * loop takes an irregular 1..37 ms per pass and stalls for 400 ms every
+ * few minutes.  Every recall must reach the gateway within one task
+ * interval plus one stall of its nominal time (timed from the first
+ * recall), up to the last one: loop latency never accumulates.  A
+ * pause by manual input resumes at the interrupted step and the tour
+ * keeps the same bounds from the resume time on.
+ */
+#include <HostArduino.h>
+#include <HostTest.h>
+#include <HostNetwork.h>
+#include <string>
+#include "MonoclePresetTour.h"
+
+#define DWELL      30000UL              // milliseconds
+#define DURATION   (8UL * 3600000UL)    // milliseconds
+#define MAX_PASS   37                   // milliseconds
+#define STALL      400                  // milliseconds
+#define STALL_EVERY 200000UL            // milliseconds
+
+static unsigned long seed = 12345;
+
+/* DETERMINISTIC MAIN LOOP PASS TIME (1..MAX_PASS MS) */
+static unsigned long pass() {
+  seed = seed * 1103515245UL + 12345UL;
+  return 1 + (seed >> 16) % MAX_PASS;
+}
+
+/* RUN THE MAIN LOOP FOR 'duration' MS */
+static void run(MonocleScheduler& scheduler, MonocleGatewayClient& client, unsigned long duration) {
+  unsigned long start = millis(), stall = millis();
+  while(millis() - start < duration){
+    scheduler.loop();
+    client.loop();
+    if(millis() - stall >= STALL_EVERY){
+      stall = millis();
+      hostAdvance(STALL);
+    }
+    else hostAdvance(pass());
+  }
+}
+
+/* THE PRESET RECALLS RECEIVED SINCE 'from' (COMMAND TIMES) */
+static std::vector<unsigned long> recalls(HostLoopbackGateway& link, size_t from) {
+  std::vector<unsigned long> times;
+  for(size_t index = from; index < link.commands.size(); index++)
+    if(link.commands[index].compare(0, 8, "PRESET:#") == 0) times.push_back(link.commandTimes[index]);
+  return times;
+}
+
+/* LATENESS OF EACH RECALL AGAINST THE NOMINAL TIMES FROM THE FIRST ONE */
+static void lateness(const std::vector<unsigned long>& times, unsigned long& worst, long& drift) {
+  worst = 0;
+  drift = 0;
+  if(times.empty()) return;
+  unsigned long nominal = times[0];
+  for(size_t step = 0; step < times.size(); step++){
+    unsigned long late = times[step] - (nominal + step * DWELL);
+    if(late > worst) worst = late;
+  }
+  drift = (long)(times.back() - (nominal + (times.size() - 1) * DWELL));
+}
+
+int main() {
+  hostSetTime(1000);
+  HostLoopbackGateway link;
+  MonocleGatewayClient client(link, "127.0.0.1", 8080);
+  client.begin();
+  client.loop();
+  MonocleScheduler scheduler;
+  MonoclePresetTour tour(client);
+  CHECK(tour.cycle(1, 5, DWELL));
+  CHECK(tour.schedule(scheduler) != MONOCLE_TASK_INVALID);
+
+  // eight hours of patrol: bounded lateness, no accumulated drift
+  const unsigned long bound = MONOCLE_TOUR_TASK_INTERVAL + STALL;
+  size_t from = link.commands.size();
+  tour.start();
+  run(scheduler, client, DURATION);
+  std::vector<unsigned long> times = recalls(link, from);
+  CHECK_RANGE(times.size(), DURATION / DWELL, DURATION / DWELL + 1);
+  unsigned long worst;
+  long drift;
+  lateness(times, worst, drift);
+  CHECK_RANGE(worst, 0, bound);
+  CHECK_RANGE(drift, 0, bound);
+  CHECK(link.commands[from + 5] == "PRESET:#0");   // the tour wrapped around
+  printf("tour_drift: %u recalls in %lu h, worst lateness %lu ms, drift after the last %ld ms\n",
+         (unsigned)times.size(), DURATION / 3600000UL, worst, drift);
+
+  // manual input pauses the tour; it resumes at the interrupted step
+  uint8_t interrupted = tour.step();
+  tour.activity(2, 0, 0);
+  CHECK(tour.isPaused());
+  from = link.commands.size();
+  run(scheduler, client, MONOCLE_TOUR_DEFAULT_RESUME_TIMEOUT);
+  CHECK_EQ(recalls(link, from).size(), 0);        // a held vector keeps it paused
+  tour.activity(0, 0, 0);
+  run(scheduler, client, MONOCLE_TOUR_DEFAULT_RESUME_TIMEOUT + 1000);
+  CHECK(!tour.isPaused());
+  CHECK_EQ(tour.step(), interrupted);
+  CHECK(link.commands[from] == std::string("PRESET:#") + std::to_string(interrupted));
+
+  // and keeps the same bounds from the resume time on
+  run(scheduler, client, DURATION / 8);
+  times = recalls(link, from);
+  lateness(times, worst, drift);
+  CHECK_RANGE(worst, 0, bound);
+  CHECK_RANGE(drift, 0, bound);
+  printf("tour_drift: resumed at step %u, %u recalls in the next hour, worst lateness %lu ms\n",
+         interrupted, (unsigned)times.size(), worst);
+
+  return hostTestResult("tour_drift");
+}
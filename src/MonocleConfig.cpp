@@ -0,0 +1,584 @@
+/*
+ **********************************************************************
+ *             __  __  ___  _  _  ___   ___ _    ___
+ *            |  \/  |/ _ \| \| |/ _ \ / __| |  | __|
+ *            | |\/| | (_) | .` | (_) | (__| |__| _|
+ *            |_|  |_|\___/|_|\_|\___/ \___|____|___|
+ *
+ * -------------------------------------------------------------------
+ *                     MONOCLE CONFIGURATION
+ * -------------------------------------------------------------------
+ *
+ *  This library provides a typed runtime configuration store for
+ *  the settings that are otherwise compile-time constants: Wi-Fi
+ *  credentials, the gateway endpoint, joystick thresholds and axis
+ *  inversion, gateway status filtering and IR remote codes.
+ *
+ *  The fields are declared once in the MONOCLE_CONFIG_SCHEMA list;
+ *  the field ids, the packed binary record and the field offsets are
+ *  generated from it, so a field is read or written in constant time.
+ *  The record is kept as one versioned, CRC-protected record in
+ *  'MonocleStorage'.  Fields can be changed from a serial console or
+ *  by a 'config' message from the Monocle Gateway (except the WiFi
+ *  credentials and the gateway endpoint, which are set from the
+ *  console only) and changes are applied live to the attached
+ *  joystick, gateway client and IR remote, then saved after a short
+ *  delay.
+ *
+ *  Author:   Robert Savage
+ *  Date:     2018-02-18
+ *  Website:  http://monoclecam.com
+ *
+ * -------------------------------------------------------------------
+ *        COPYRIGHT SHADEBLUE, LLC @ 2018, ALL RIGHTS RESERVED
+ * -------------------------------------------------------------------
+ *
+ **********************************************************************
+ */
+
+#include "Arduino.h"
+#include "MonocleConfig.h"
+#include "MonoclePTZJoystick.h"
+#include "MonocleGatewayClient.h"
+#include "MonocleIRRemote.h"
+#include "MonocleTelemetry.h"
+#include <stddef.h>
+
+/**
+ * FIELD DESCRIPTORS (GENERATED FROM THE SCHEMA; INDEXED BY FIELD ID)
+ */
+#define MONOCLE_CONFIG_FIELD_DESCRIPTOR(id, name, type, size, group, access, value) \
+  { #name, type, group, access, offsetof(MonocleConfigRecord, name), size, value },
+const MonocleConfigField MonocleConfig::fields[MONOCLE_CONFIG_FIELDS] = {
+  MONOCLE_CONFIG_SCHEMA(MONOCLE_CONFIG_FIELD_DESCRIPTOR)
+};
+#undef MONOCLE_CONFIG_FIELD_DESCRIPTOR
+
+/**
+ * IR REMOTE ACTION FOR EACH CONFIGURED IR CODE FIELD
+ */
+static const uint8_t MONOCLE_CONFIG_IR_ACTIONS[][2] = {
+  { MONOCLE_CONFIG_IR_UP,       MONOCLE_IR_TILT_UP   },
+  { MONOCLE_CONFIG_IR_DOWN,     MONOCLE_IR_TILT_DOWN },
+  { MONOCLE_CONFIG_IR_LEFT,     MONOCLE_IR_PAN_LEFT  },
+  { MONOCLE_CONFIG_IR_RIGHT,    MONOCLE_IR_PAN_RIGHT },
+  { MONOCLE_CONFIG_IR_ZOOM_IN,  MONOCLE_IR_ZOOM_IN   },
+  { MONOCLE_CONFIG_IR_ZOOM_OUT, MONOCLE_IR_ZOOM_OUT  },
+  { MONOCLE_CONFIG_IR_STOP,     MONOCLE_IR_STOP      },
+  { MONOCLE_CONFIG_IR_HOME,     MONOCLE_IR_HOME      }
+};
+
+/**
+ * DETERMINE IF A FIELD ID IS VALID
+ */
+static bool validConfigId(const int id){
+  return id >= 0 && id < MONOCLE_CONFIG_FIELDS;
+}
+
+/**
+ * DETERMINE IF A FIELD HOLDS TEXT
+ */
+static bool isConfigText(const MonocleConfigField& field){
+  return field.type == MONOCLE_CONFIG_TEXT || field.type == MONOCLE_CONFIG_SECRET;
+}
+
+/**
+ * Default Constructor
+ */
+MonocleConfig::MonocleConfig(MonocleStorage& storage, size_t address) : storage(storage), address(address) {
+  this->changeCallback = NULL;
+  defaults();
+}
+
+/**
+ * RESTORE EVERY FIELD TO ITS DEFAULT (WITHOUT APPLYING OR SAVING)
+ */
+void MonocleConfig::defaults(){
+  // text fields are compared and saved byte for byte; clear the padding
+  memset(&record, 0, sizeof(record));
+  for(int id = 0; id < MONOCLE_CONFIG_FIELDS; id++){
+    uint32_t value = 0;
+    if(isConfigText(fields[id])) storeText(id, fields[id].value);
+    else if(parse(id, fields[id].value, value)) storeNumber(id, value);
+  }
+}
+
+/**
+ * LOAD THE CONFIGURATION FROM STORAGE AND APPLY IT TO THE ATTACHED
+ * COMPONENTS.  RETURNS 'false' IF NO VALID CONFIGURATION IS STORED
+ * (THE DEFAULTS REMAIN IN PLACE)
+ */
+bool MonocleConfig::load(){
+  MonocleConfigRecord stored;
+  if(!storage.load(address, MONOCLE_CONFIG_VERSION, &stored, sizeof(stored))) return false;
+  record = stored;
+  dirty = false;
+  apply();
+  return true;
+}
+
+/**
+ * SAVE PENDING CHANGES NOW (CHANGES ARE OTHERWISE SAVED AFTER
+ * THE SAVE DELAY); RETURNS 'false' ON A STORAGE FAILURE
+ */
+bool MonocleConfig::save(){
+  if(!dirty) return true;
+  if(!storage.save(address, MONOCLE_CONFIG_VERSION, &record, sizeof(record))) return false;
+  dirty = false;
+  return true;
+}
+
+/**
+ * RESTORE ALL FIELDS TO THEIR DEFAULTS
+ */
+void MonocleConfig::reset(){
+  defaults();
+  dirty = true;
+  changeTime = millis();
+  apply();
+  if(changeCallback != NULL) changeCallback(-1);
+}
+
+/**
+ * FIND A FIELD ID BY NAME; RETURNS -1 IF THERE IS NO SUCH FIELD
+ */
+int MonocleConfig::find(const char* name){
+  if(name == NULL) return -1;
+  for(int id = 0; id < MONOCLE_CONFIG_FIELDS; id++){
+    if(strcmp(fields[id].name, name) == 0) return id;
+  }
+  return -1;
+}
+
+/**
+ * RETURNS TRUE IF A FIELD MAY BE SET BY THE GATEWAY (MONOCLE_CONFIG_REMOTE)
+ */
+bool MonocleConfig::isRemote(const int id){
+  return validConfigId(id) && fields[id].access == MONOCLE_CONFIG_REMOTE;
+}
+
+/**
+ * READ A NUMERIC FIELD (LITTLE ENDIAN, ZERO EXTENDED)
+ */
+uint32_t MonocleConfig::readNumber(const int id){
+  const uint8_t* data = ((const uint8_t*)&record) + fields[id].offset;
+  uint32_t value = 0;
+  for(int index = fields[id].size - 1; index >= 0; index--) value = (value << 8) | data[index];
+  return value;
+}
+
+/**
+ * WRITE A NUMERIC FIELD (LITTLE ENDIAN); RETURNS 'true' IF IT CHANGED
+ */
+bool MonocleConfig::storeNumber(const int id, uint32_t value){
+  uint8_t* data = ((uint8_t*)&record) + fields[id].offset;
+  bool change = false;
+  for(int index = 0; index < fields[id].size; index++){
+    uint8_t next = (uint8_t)(value & 0xFF);
+    if(data[index] != next) change = true;
+    data[index] = next;
+    value >>= 8;
+  }
+  return change;
+}
+
+/**
+ * WRITE A TEXT FIELD (ZERO PADDED); RETURNS 'true' IF IT CHANGED
+ */
+bool MonocleConfig::storeText(const int id, const char* value){
+  char* data = ((char*)&record) + fields[id].offset;
+  if(strcmp(data, value) == 0) return false;
+  memset(data, 0, fields[id].size);
+  strcpy(data, value);
+  return true;
+}
+
+/**
+ * PARSE A NUMERIC OR BOOLEAN FIELD VALUE FROM TEXT;
+ * RETURNS 'false' IF THE TEXT IS NOT A VALUE THAT FITS THE FIELD
+ */
+bool MonocleConfig::parse(const int id, const char* text, uint32_t& value){
+  const MonocleConfigField& field = fields[id];
+  if(text == NULL || *text == '\0') return false;
+  char* end = NULL;
+
+  if(field.type == MONOCLE_CONFIG_BOOL){
+    if(strcmp(text, "1") == 0 || strcmp(text, "true") == 0 || strcmp(text, "on") == 0) value = 1;
+    else if(strcmp(text, "0") == 0 || strcmp(text, "false") == 0 || strcmp(text, "off") == 0) value = 0;
+    else return false;
+    return true;
+  }
+  if(field.type == MONOCLE_CONFIG_INT){
+    long number = strtol(text, &end, 0);
+    if(*end != '\0') return false;
+    if(field.size < sizeof(long)){
+      long limit = 1L << (field.size * 8 - 1);
+      if(number < -limit || number >= limit) return false;
+    }
+    value = (uint32_t)number;
+    return true;
+  }
+  if(field.type == MONOCLE_CONFIG_UINT){
+    if(*text == '-') return false;
+    unsigned long number = strtoul(text, &end, 0);
+    if(*end != '\0') return false;
+    if(field.size < 4 && number >= (1UL << (field.size * 8))) return false;
+    if(number > 0xFFFFFFFFUL) return false;
+    value = (uint32_t)number;
+    return true;
+  }
+  return false;
+}
+
+/**
+ * GET A NUMERIC OR BOOLEAN FIELD
+ */
+long MonocleConfig::getInt(const int id){
+  if(!validConfigId(id) || isConfigText(fields[id])) return 0;
+  uint32_t value = readNumber(id);
+
+  // sign extend signed fields narrower than 32 bits
+  uint8_t bits = fields[id].size * 8;
+  if(fields[id].type == MONOCLE_CONFIG_INT && bits < 32 && (value & (1UL << (bits - 1))))
+    value |= (uint32_t)(0xFFFFFFFFUL << bits);
+  return (long)(int32_t)value;
+}
+uint32_t MonocleConfig::getUInt(const int id){
+  if(!validConfigId(id) || isConfigText(fields[id])) return 0;
+  return (uint32_t)readNumber(id);
+}
+bool MonocleConfig::getBool(const int id){
+  return getInt(id) != 0;
+}
+
+/**
+ * GET A TEXT FIELD (OWNED BY THIS CONFIGURATION; EMPTY FOR OTHER TYPES)
+ */
+const char* MonocleConfig::getText(const int id){
+  if(!validConfigId(id) || !isConfigText(fields[id])) return "";
+  return ((const char*)&record) + fields[id].offset;
+}
+
+/**
+ * SET A NUMERIC OR BOOLEAN FIELD; RETURNS 'false' IF THE VALUE
+ * DOES NOT FIT THE FIELD
+ */
+bool MonocleConfig::setInt(const int id, long value){
+  if(!validConfigId(id)) return false;
+  const MonocleConfigField& field = fields[id];
+  if(isConfigText(field)) return false;
+  if(field.type != MONOCLE_CONFIG_INT){
+    if(value < 0) return false;
+    return setUInt(id, (uint32_t)value);
+  }
+  if(field.size < sizeof(long)){
+    long limit = 1L << (field.size * 8 - 1);
+    if(value < -limit || value >= limit) return false;
+  }
+  if(storeNumber(id, (uint32_t)value)) changed(id);
+  return true;
+}
+bool MonocleConfig::setUInt(const int id, uint32_t value){
+  if(!validConfigId(id)) return false;
+  const MonocleConfigField& field = fields[id];
+  if(isConfigText(field)) return false;
+  if(field.type == MONOCLE_CONFIG_INT) {
+    if(value > 0x7FFFFFFFUL) return false;
+    return setInt(id, (long)value);
+  }
+  if(field.type == MONOCLE_CONFIG_BOOL && value > 1) return false;
+  if(field.size < 4 && value >= (1UL << (field.size * 8))) return false;
+  if(storeNumber(id, value)) changed(id);
+  return true;
+}
+bool MonocleConfig::setBool(const int id, bool value){
+  return setUInt(id, value ? 1 : 0);
+}
+
+/**
+ * SET A TEXT FIELD; RETURNS 'false' IF THE TEXT DOES NOT FIT
+ */
+bool MonocleConfig::setText(const int id, const char* value){
+  if(!validConfigId(id) || !isConfigText(fields[id])) return false;
+  if(value == NULL) value = "";
+  if(strlen(value) >= fields[id].size) return false;
+  if(storeText(id, value)) changed(id);
+  return true;
+}
+
+/**
+ * SET ANY FIELD FROM TEXT (AS TAKEN BY THE CONSOLE 'set' COMMAND);
+ * RETURNS 'false' IF THE VALUE IS INVALID FOR THE FIELD
+ */
+bool MonocleConfig::set(const int id, const char* value){
+  if(!validConfigId(id)) return false;
+  if(isConfigText(fields[id])) return setText(id, value);
+
+  uint32_t number = 0;
+  if(!parse(id, value, number)) return false;
+  if(storeNumber(id, number)) changed(id);
+  return true;
+}
+bool MonocleConfig::set(const char* name, const char* value){
+  return set(find(name), value);
+}
+
+/**
+ * RETURNS TRUE IF 'set()' WOULD ACCEPT A VALUE (THE FIELD IS NOT CHANGED)
+ */
+bool MonocleConfig::check(const int id, const char* value){
+  if(!validConfigId(id)) return false;
+  if(isConfigText(fields[id])) return value == NULL || strlen(value) < fields[id].size;
+
+  uint32_t number = 0;
+  return parse(id, value, number);
+}
+
+/**
+ * PRINT A FIELD VALUE AS TEXT (SECRETS ARE MASKED)
+ */
+void MonocleConfig::print(Print& out, const int id){
+  if(!validConfigId(id)) return;
+  switch(fields[id].type){
+    case MONOCLE_CONFIG_SECRET:
+      if(strlen(getText(id)) > 0) out.print("********");
+      break;
+    case MONOCLE_CONFIG_TEXT:
+      out.print(getText(id));
+      break;
+    case MONOCLE_CONFIG_UINT:
+      // IR codes are easier to compare in hex
+      if(fields[id].group == MONOCLE_CONFIG_IR && getUInt(id) != 0){
+        out.print("0x");
+        out.print((unsigned long)getUInt(id), HEX);
+      }
+      else out.print((unsigned long)getUInt(id));
+      break;
+    default:
+      out.print(getInt(id));
+      break;
+  }
+}
+
+/**
+ * PRINT ALL FIELDS AS "name=value" LINES
+ */
+void MonocleConfig::list(Print& out){
+  for(int id = 0; id < MONOCLE_CONFIG_FIELDS; id++){
+    out.print(fields[id].name);
+    out.print("=");
+    print(out, id);
+    out.println();
+  }
+}
+
+/**
+ * MARK A FIELD CHANGED; IT IS APPLIED NOW AND SAVED AFTER THE SAVE DELAY
+ */
+void MonocleConfig::changed(const int id){
+  dirty = true;
+  changeTime = millis();
+  applyGroup(fields[id].group);
+  if(changeCallback != NULL) changeCallback(id);
+}
+
+/**
+ * APPLY THE FIELDS OF ONE GROUP TO ITS ATTACHED COMPONENT
+ */
+void MonocleConfig::applyGroup(const uint8_t group){
+  if(group == MONOCLE_CONFIG_JOYSTICK && joystick != NULL){
+    joystick->setAllThresholds(getInt(MONOCLE_CONFIG_THRESHOLD_LOW),
+                               getInt(MONOCLE_CONFIG_THRESHOLD_MED),
+                               getInt(MONOCLE_CONFIG_THRESHOLD_HIGH));
+    joystick->setPanBuffer(getInt(MONOCLE_CONFIG_JOYSTICK_BUFFER));
+    joystick->setTiltBuffer(getInt(MONOCLE_CONFIG_JOYSTICK_BUFFER));
+    joystick->setZoomBuffer(getInt(MONOCLE_CONFIG_JOYSTICK_BUFFER));
+    joystick->invertPanAxis(getBool(MONOCLE_CONFIG_INVERT_PAN));
+    joystick->invertTiltAxis(getBool(MONOCLE_CONFIG_INVERT_TILT));
+    joystick->invertZoomAxis(getBool(MONOCLE_CONFIG_INVERT_ZOOM));
+    joystick->setPTZEventDelay(getUInt(MONOCLE_CONFIG_PTZ_EVENT_DELAY));
+  }
+  else if(group == MONOCLE_CONFIG_GATEWAY && gateway != NULL){
+    gateway->setStatusFilter(getUInt(MONOCLE_CONFIG_STATUS_DELTA) / 100.0f, getUInt(MONOCLE_CONFIG_STATUS_MIN_INTERVAL));
+    if(getUInt(MONOCLE_CONFIG_STATUS_INTERVAL) > 0)
+      gateway->subscribeStatus(getUInt(MONOCLE_CONFIG_STATUS_INTERVAL));
+    else
+      gateway->unsubscribeStatus();
+  }
+  else if(group == MONOCLE_CONFIG_IR && remote != NULL){
+    // the sketch's own code table stays in place until an IR code is
+    // configured; it is kept aside and restored once none remains
+    const int count = sizeof(MONOCLE_CONFIG_IR_ACTIONS) / sizeof(MONOCLE_CONFIG_IR_ACTIONS[0]);
+    bool configured = false;
+    for(int index = 0; index < count; index++){
+      if(getUInt(MONOCLE_CONFIG_IR_ACTIONS[index][0]) != 0) configured = true;
+    }
+    if(!configured){
+      if(remoteConfigured) remote->loadCodes(remoteCodes, remoteCodeCount);
+      remoteConfigured = false;
+      return;
+    }
+    if(!remoteConfigured){
+      remoteCodeCount = remote->codeCount();
+      for(int index = 0; index < remoteCodeCount; index++) remoteCodes[index] = remote->codeAt(index);
+      remoteConfigured = true;
+    }
+    remote->clearCodes();
+    for(int index = 0; index < count; index++){
+      uint32_t code = getUInt(MONOCLE_CONFIG_IR_ACTIONS[index][0]);
+      if(code != 0) remote->addCode(code, MONOCLE_CONFIG_IR_ACTIONS[index][1]);
+    }
+  }
+  else if(group == MONOCLE_CONFIG_TELEMETRY && telemetry != NULL){
+    telemetry->setInterval(getUInt(MONOCLE_CONFIG_TELEMETRY_INTERVAL));
+    telemetry->setFields(getUInt(MONOCLE_CONFIG_TELEMETRY_FIELDS));
+  }
+}
+
+/**
+ * APPLY ALL FIELDS TO THE ATTACHED COMPONENTS
+ */
+void MonocleConfig::apply(){
+  applyGroup(MONOCLE_CONFIG_JOYSTICK);
+  applyGroup(MONOCLE_CONFIG_GATEWAY);
+  applyGroup(MONOCLE_CONFIG_IR);
+  applyGroup(MONOCLE_CONFIG_TELEMETRY);
+}
+
+/**
+ * APPLY CHANGED FIELDS TO A JOYSTICK (THRESHOLDS, BUFFER,
+ * AXIS INVERSION AND EVENT DELAY); ALSO APPLIED NOW
+ */
+void MonocleConfig::attach(MonoclePTZJoystick* joystick){
+  this->joystick = joystick;
+  applyGroup(MONOCLE_CONFIG_JOYSTICK);
+}
+
+/**
+ * APPLY CHANGED FIELDS TO A GATEWAY CLIENT (STATUS SUBSCRIPTION
+ * AND FILTER) AND ACCEPT ITS 'config' MESSAGES (MONOCLE_CONFIG_REMOTE
+ * FIELDS ONLY); ALSO APPLIED NOW
+ */
+void MonocleConfig::attach(MonocleGatewayClient* gateway){
+  this->gateway = gateway;
+  if(gateway == NULL) return;
+  gateway->configureWith(this);
+  applyGroup(MONOCLE_CONFIG_GATEWAY);
+}
+
+/**
+ * APPLY CHANGED FIELDS TO AN IR REMOTE (ONCE ANY IR CODE IS
+ * CONFIGURED, THE CONFIGURED CODES REPLACE ITS CODE TABLE UNTIL NONE
+ * REMAINS); ALSO APPLIED NOW
+ */
+void MonocleConfig::attach(MonocleIRRemote* remote){
+  this->remote = remote;
+  remoteConfigured = false;
+  applyGroup(MONOCLE_CONFIG_IR);
+}
+
+/**
+ * APPLY CHANGED FIELDS TO A TELEMETRY COLLECTOR (FRAME INTERVAL
+ * AND FIELD SET); ALSO APPLIED NOW
+ */
+void MonocleConfig::attach(MonocleTelemetry* telemetry){
+  this->telemetry = telemetry;
+  applyGroup(MONOCLE_CONFIG_TELEMETRY);
+}
+
+/**
+ * ACCEPT CONSOLE COMMANDS FROM A STREAM (E.G. 'Serial'):
+ *   list | get <name> | set <name> <value> | save | reset
+ */
+void MonocleConfig::serve(Stream* console){
+  this->console = console;
+  lineLength = 0;
+  lineOverflow = false;
+}
+
+/**
+ * EXECUTE ONE CONSOLE COMMAND LINE (THE SET VALUE IS THE REST OF
+ * THE LINE SO TEXT VALUES MAY CONTAIN SPACES)
+ */
+void MonocleConfig::command(char* text){
+  char* name = strchr(text, ' ');
+  char* value = NULL;
+  if(name != NULL){
+    *name++ = '\0';
+    value = strchr(name, ' ');
+    if(value != NULL) *value++ = '\0';
+  }
+
+  bool success = false;
+  if(strcmp(text, "list") == 0){
+    list(*console);
+    success = true;
+  }
+  else if(strcmp(text, "get") == 0 && find(name) >= 0){
+    console->print(name);
+    console->print("=");
+    print(*console, find(name));
+    console->println();
+    success = true;
+  }
+  else if(strcmp(text, "set") == 0){
+    success = set(name, (value == NULL) ? "" : value);
+  }
+  else if(strcmp(text, "save") == 0){
+    success = save();
+  }
+  else if(strcmp(text, "reset") == 0){
+    reset();
+    success = true;
+  }
+  console->println(success ? "OK" : "ERROR");
+}
+
+/**
+ * REGISTERS A CALLBACK FUNCTION POINTER FOR FIELD CHANGES
+ * (E.G. TO RESTART WHEN A MONOCLE_CONFIG_BOOT FIELD CHANGES;
+ * THE ID IS -1 AFTER A RESET)
+ */
+void MonocleConfig::onChange(void (*changeCallback)(const int id)){
+  this->changeCallback = changeCallback;
+}
+
+/**
+ * SCHEDULER TASK ENTRY POINT
+ */
+void MonocleConfig::internal_config_task(void* context){
+  ((MonocleConfig*)context)->loop();
+}
+
+/**
+ * REGISTER THIS CONFIGURATION AS A TASK OF A SCHEDULER (REPLACES
+ * CALLING 'loop()' FROM THE PROGRAM MAIN LOOP).
+ * RETURNS THE TASK ID OR MONOCLE_TASK_INVALID
+ */
+int MonocleConfig::schedule(MonocleScheduler& scheduler){
+  return scheduler.every(MONOCLE_CONFIG_TASK_INTERVAL, internal_config_task, this, MONOCLE_CONFIG_TASK_BUDGET);
+}
+
+/**
+ * THIS METHOD MUST BE CALLED IN THE PROGRAM MAIN LOOP TO
+ * SERVICE THE CONSOLE AND SAVE CHANGES AFTER THE SAVE DELAY
+ */
+void MonocleConfig::loop(){
+  // read whatever console input is waiting; a command runs once its line ends
+  while(console != NULL && console->available() > 0){
+    char next = (char)console->read();
+    if(next == '\r' || next == '\n'){
+      if(lineOverflow) console->println("ERROR");
+      else if(lineLength > 0){
+        line[lineLength] = '\0';
+        command(line);
+      }
+      lineLength = 0;
+      lineOverflow = false;
+    }
+    else if(lineLength < MONOCLE_CONFIG_LINE_LENGTH) line[lineLength++] = next;
+    else lineOverflow = true;
+  }
+
+  if(dirty && (millis() - changeTime) >= MONOCLE_CONFIG_SAVE_DELAY) save();
+}
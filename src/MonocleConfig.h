@@ -0,0 +1,343 @@
+/*
+ **********************************************************************
+ *             __  __  ___  _  _  ___   ___ _    ___
+ *            |  \/  |/ _ \| \| |/ _ \ / __| |  | __|
+ *            | |\/| | (_) | .` | (_) | (__| |__| _|
+ *            |_|  |_|\___/|_|\_|\___/ \___|____|___|
+ *
+ * -------------------------------------------------------------------
+ *                     MONOCLE CONFIGURATION
+ * -------------------------------------------------------------------
+ *
+ *  This library provides a typed runtime configuration store for
+ *  the settings that are otherwise compile-time constants: Wi-Fi
+ *  credentials, the gateway endpoint, joystick thresholds and axis
+ *  inversion, gateway status filtering and IR remote codes.
+ *
+ *  The fields are declared once in the MONOCLE_CONFIG_SCHEMA list;
+ *  the field ids, the packed binary record and the field offsets are
+ *  generated from it, so a field is read or written in constant time.
+ *  The record is kept as one versioned, CRC-protected record in
+ *  'MonocleStorage'.  Fields can be changed from a serial console or
+ *  by a 'config' message from the Monocle Gateway (except the WiFi
+ *  credentials and the gateway endpoint, which are set from the
+ *  console only) and changes are applied live to the attached
+ *  joystick, gateway client and IR remote, then saved after a short
+ *  delay.
+ *
+ *  Author:   Robert Savage
+ *  Date:     2018-02-18
+ *  Website:  http://monoclecam.com
+ *
+ * -------------------------------------------------------------------
+ *        COPYRIGHT SHADEBLUE, LLC @ 2018, ALL RIGHTS RESERVED
+ * -------------------------------------------------------------------
+ *
+ **********************************************************************
+ */
+#ifndef MONOCLE_CONFIG_H
+#define MONOCLE_CONFIG_H
+
+#include <Arduino.h>
+#include "MonocleStorage.h"
+#include "MonocleScheduler.h"
+#include "MonocleIRRemote.h"
+
+class MonoclePTZJoystick;
+class MonocleGatewayClient;
+class MonocleTelemetry;
+
+/* VERSION OF THE CONFIGURATION RECORD (INCREMENT WHEN THE SCHEMA CHANGES) */
+#define MONOCLE_CONFIG_VERSION 2
+
+/* DELAY BEFORE CHANGES ARE WRITTEN TO STORAGE */
+#ifndef MONOCLE_CONFIG_SAVE_DELAY
+#define MONOCLE_CONFIG_SAVE_DELAY 5000   // milliseconds
+#endif
+
+/* LONGEST CONSOLE COMMAND LINE ("set <name> <value>") */
+#ifndef MONOCLE_CONFIG_LINE_LENGTH
+#define MONOCLE_CONFIG_LINE_LENGTH 100
+#endif
+
+/* SCHEDULER TASK INTERVAL AND EXECUTION BUDGET */
+#ifndef MONOCLE_CONFIG_TASK_INTERVAL
+#define MONOCLE_CONFIG_TASK_INTERVAL 50     // milliseconds
+#endif
+#ifndef MONOCLE_CONFIG_TASK_BUDGET
+#define MONOCLE_CONFIG_TASK_BUDGET   1000   // microseconds (excluding storage writes)
+#endif
+
+/* FIELD TYPES */
+#define MONOCLE_CONFIG_BOOL   0   // 1 byte; "0"/"1" or "false"/"true"
+#define MONOCLE_CONFIG_INT    1   // signed, little endian (1, 2 or 4 bytes)
+#define MONOCLE_CONFIG_UINT   2   // unsigned, little endian (1, 2 or 4 bytes; "0x" for hex)
+#define MONOCLE_CONFIG_TEXT   3   // zero terminated (the size includes the terminator)
+#define MONOCLE_CONFIG_SECRET 4   // text that is never printed
+
+/* FIELD GROUPS; THE COMPONENT A CHANGED FIELD IS APPLIED TO */
+#define MONOCLE_CONFIG_BOOT      0   // read by the program at startup (applies after a restart)
+#define MONOCLE_CONFIG_JOYSTICK  1   // applied to the attached 'MonoclePTZJoystick'
+#define MONOCLE_CONFIG_GATEWAY   2   // applied to the attached 'MonocleGatewayClient'
+#define MONOCLE_CONFIG_IR        3   // applied to the attached 'MonocleIRRemote'
+#define MONOCLE_CONFIG_TELEMETRY 4   // applied to the attached 'MonocleTelemetry'
+
+/* FIELD ACCESS; ONLY REMOTE FIELDS MAY BE SET BY A GATEWAY 'config' MESSAGE
+   (THE CREDENTIALS AND THE GATEWAY ENDPOINT ARE SET FROM THE CONSOLE ONLY) */
+#define MONOCLE_CONFIG_LOCAL     0   // console and program only
+#define MONOCLE_CONFIG_REMOTE    1   // also the gateway
+
+/**
+ * CONFIGURATION SCHEMA: X(ID, name, type, size, group, access, default)
+ * THE 'name' IS THE RECORD MEMBER AND THE KEY USED BY THE CONSOLE AND
+ * GATEWAY; DEFAULTS ARE TEXT IN THE SAME FORMAT A CONSOLE 'set' TAKES.
+ * (INCREMENT MONOCLE_CONFIG_VERSION WHEN A FIELD IS ADDED OR RESIZED)
+ */
+#define MONOCLE_CONFIG_SCHEMA(X) \
+  X(WIFI_SSID,           wifiSsid,          MONOCLE_CONFIG_TEXT,   33, MONOCLE_CONFIG_BOOT,      MONOCLE_CONFIG_LOCAL,  "")       \
+  X(WIFI_PASS,           wifiPass,          MONOCLE_CONFIG_SECRET, 64, MONOCLE_CONFIG_BOOT,      MONOCLE_CONFIG_LOCAL,  "")       \
+  X(GATEWAY_ADDRESS,     gatewayAddress,    MONOCLE_CONFIG_TEXT,   41, MONOCLE_CONFIG_BOOT,      MONOCLE_CONFIG_LOCAL,  "")       \
+  X(GATEWAY_PORT,        gatewayPort,       MONOCLE_CONFIG_UINT,    2, MONOCLE_CONFIG_BOOT,      MONOCLE_CONFIG_LOCAL,  "8080")   \
+  X(STATUS_INTERVAL,     statusInterval,    MONOCLE_CONFIG_UINT,    2, MONOCLE_CONFIG_GATEWAY,   MONOCLE_CONFIG_REMOTE, "0")      \
+  X(STATUS_MIN_INTERVAL, statusMinInterval, MONOCLE_CONFIG_UINT,    2, MONOCLE_CONFIG_GATEWAY,   MONOCLE_CONFIG_REMOTE, "100")    \
+  X(STATUS_DELTA,        statusDelta,       MONOCLE_CONFIG_UINT,    2, MONOCLE_CONFIG_GATEWAY,   MONOCLE_CONFIG_REMOTE, "50")     \
+  X(THRESHOLD_LOW,       thresholdLow,      MONOCLE_CONFIG_INT,     2, MONOCLE_CONFIG_JOYSTICK,  MONOCLE_CONFIG_REMOTE, "500")    \
+  X(THRESHOLD_MED,       thresholdMed,      MONOCLE_CONFIG_INT,     2, MONOCLE_CONFIG_JOYSTICK,  MONOCLE_CONFIG_REMOTE, "1300")   \
+  X(THRESHOLD_HIGH,      thresholdHigh,     MONOCLE_CONFIG_INT,     2, MONOCLE_CONFIG_JOYSTICK,  MONOCLE_CONFIG_REMOTE, "1900")   \
+  X(JOYSTICK_BUFFER,     joystickBuffer,    MONOCLE_CONFIG_INT,     2, MONOCLE_CONFIG_JOYSTICK,  MONOCLE_CONFIG_REMOTE, "100")    \
+  X(INVERT_PAN,          invertPan,         MONOCLE_CONFIG_BOOL,    1, MONOCLE_CONFIG_JOYSTICK,  MONOCLE_CONFIG_REMOTE, "0")      \
+  X(INVERT_TILT,         invertTilt,        MONOCLE_CONFIG_BOOL,    1, MONOCLE_CONFIG_JOYSTICK,  MONOCLE_CONFIG_REMOTE, "0")      \
+  X(INVERT_ZOOM,         invertZoom,        MONOCLE_CONFIG_BOOL,    1, MONOCLE_CONFIG_JOYSTICK,  MONOCLE_CONFIG_REMOTE, "0")      \
+  X(PTZ_EVENT_DELAY,     ptzEventDelay,     MONOCLE_CONFIG_UINT,    2, MONOCLE_CONFIG_JOYSTICK,  MONOCLE_CONFIG_REMOTE, "100")    \
+  X(IR_UP,               irUp,              MONOCLE_CONFIG_UINT,    4, MONOCLE_CONFIG_IR,        MONOCLE_CONFIG_REMOTE, "0")      \
+  X(IR_DOWN,             irDown,            MONOCLE_CONFIG_UINT,    4, MONOCLE_CONFIG_IR,        MONOCLE_CONFIG_REMOTE, "0")      \
+  X(IR_LEFT,             irLeft,            MONOCLE_CONFIG_UINT,    4, MONOCLE_CONFIG_IR,        MONOCLE_CONFIG_REMOTE, "0")      \
+  X(IR_RIGHT,            irRight,           MONOCLE_CONFIG_UINT,    4, MONOCLE_CONFIG_IR,        MONOCLE_CONFIG_REMOTE, "0")      \
+  X(IR_ZOOM_IN,          irZoomIn,          MONOCLE_CONFIG_UINT,    4, MONOCLE_CONFIG_IR,        MONOCLE_CONFIG_REMOTE, "0")      \
+  X(IR_ZOOM_OUT,         irZoomOut,         MONOCLE_CONFIG_UINT,    4, MONOCLE_CONFIG_IR,        MONOCLE_CONFIG_REMOTE, "0")      \
+  X(IR_STOP,             irStop,            MONOCLE_CONFIG_UINT,    4, MONOCLE_CONFIG_IR,        MONOCLE_CONFIG_REMOTE, "0")      \
+  X(IR_HOME,             irHome,            MONOCLE_CONFIG_UINT,    4, MONOCLE_CONFIG_IR,        MONOCLE_CONFIG_REMOTE, "0")      \
+  X(TELEMETRY_INTERVAL,  telemetryInterval, MONOCLE_CONFIG_UINT,    4, MONOCLE_CONFIG_TELEMETRY, MONOCLE_CONFIG_REMOTE, "60000")  \
+  X(TELEMETRY_FIELDS,    telemetryFields,   MONOCLE_CONFIG_UINT,    2, MONOCLE_CONFIG_TELEMETRY, MONOCLE_CONFIG_REMOTE, "0x3FFF")
+
+/* FIELD IDS (MONOCLE_CONFIG_<ID>) */
+#define MONOCLE_CONFIG_FIELD_ID(id, name, type, size, group, access, value) MONOCLE_CONFIG_##id,
+enum MonocleConfigId {
+  MONOCLE_CONFIG_SCHEMA(MONOCLE_CONFIG_FIELD_ID)
+  MONOCLE_CONFIG_FIELDS
+};
+#undef MONOCLE_CONFIG_FIELD_ID
+
+/**
+ * PERSISTED CONFIGURATION RECORD; EVERY FIELD IS A BYTE ARRAY SO THE
+ * RECORD IS PACKED AND ITS LAYOUT IS THE SAME ON EVERY BOARD
+ */
+#define MONOCLE_CONFIG_FIELD_MEMBER(id, name, type, size, group, access, value) uint8_t name[size];
+struct MonocleConfigRecord {
+  MONOCLE_CONFIG_SCHEMA(MONOCLE_CONFIG_FIELD_MEMBER)
+};
+#undef MONOCLE_CONFIG_FIELD_MEMBER
+
+/**
+ * FIELD DESCRIPTOR (GENERATED FROM THE SCHEMA)
+ */
+struct MonocleConfigField {
+  const char* name;
+  uint8_t type;         // MONOCLE_CONFIG_BOOL .. MONOCLE_CONFIG_SECRET
+  uint8_t group;        // MONOCLE_CONFIG_BOOT .. MONOCLE_CONFIG_TELEMETRY
+  uint8_t access;       // MONOCLE_CONFIG_LOCAL OR MONOCLE_CONFIG_REMOTE
+  uint16_t offset;      // byte offset in 'MonocleConfigRecord'
+  uint8_t size;         // bytes
+  const char* value;    // default value (text)
+};
+
+class MonocleConfig
+{
+   private:
+     MonocleStorage& storage;
+     size_t address;
+
+     /* CONFIGURATION STATE */
+     MonocleConfigRecord record;
+     bool dirty = false;
+     unsigned long changeTime = 0;
+
+     /* ATTACHED COMPONENTS (CHANGES ARE APPLIED LIVE) */
+     MonoclePTZJoystick* joystick = NULL;
+     MonocleGatewayClient* gateway = NULL;
+     MonocleIRRemote* remote = NULL;
+     MonocleTelemetry* telemetry = NULL;
+
+     /* THE IR REMOTE'S OWN CODE TABLE, KEPT WHILE CONFIGURED CODES REPLACE IT */
+     MonocleIRCode remoteCodes[MONOCLE_IR_MAX_CODES];
+     uint8_t remoteCodeCount = 0;
+     bool remoteConfigured = false;
+
+     /* SERIAL CONSOLE */
+     Stream* console = NULL;
+     char line[MONOCLE_CONFIG_LINE_LENGTH + 1];
+     uint8_t lineLength = 0;
+     bool lineOverflow = false;
+
+     /* USER CALLBACKS */
+     void (*changeCallback)(const int id);
+
+     /* INTERNAL PROCESSING */
+     uint32_t readNumber(const int id);
+     bool storeNumber(const int id, uint32_t value);
+     bool storeText(const int id, const char* value);
+     bool parse(const int id, const char* text, uint32_t& value);
+     void defaults();
+     void changed(const int id);
+     void applyGroup(const uint8_t group);
+     void command(char* text);
+
+     /* SCHEDULER TASK ENTRY POINT */
+     static void internal_config_task(void* context);
+
+   public:
+     /* FIELD DESCRIPTORS INDEXED BY FIELD ID */
+     static const MonocleConfigField fields[MONOCLE_CONFIG_FIELDS];
+
+    /**
+     * Default Constructor; the record occupies
+     * 'MonocleStorage::footprint(sizeof(MonocleConfigRecord))'
+     * bytes of storage at the given address.  All fields start
+     * at their defaults.
+     */
+     MonocleConfig(MonocleStorage& storage, size_t address = 0);
+
+     /**
+      * LOAD THE CONFIGURATION FROM STORAGE AND APPLY IT TO THE ATTACHED
+      * COMPONENTS.  RETURNS 'false' IF NO VALID CONFIGURATION IS STORED
+      * (THE DEFAULTS REMAIN IN PLACE)
+      */
+     bool load();
+
+     /**
+      * SAVE PENDING CHANGES NOW (CHANGES ARE OTHERWISE SAVED AFTER
+      * THE SAVE DELAY); RETURNS 'false' ON A STORAGE FAILURE
+      */
+     bool save();
+
+     /**
+      * RESTORE ALL FIELDS TO THEIR DEFAULTS
+      */
+     void reset();
+
+     /**
+      * FIND A FIELD ID BY NAME; RETURNS -1 IF THERE IS NO SUCH FIELD
+      */
+     static int find(const char* name);
+
+     /**
+      * RETURNS TRUE IF A FIELD MAY BE SET BY THE GATEWAY (MONOCLE_CONFIG_REMOTE)
+      */
+     static bool isRemote(const int id);
+
+     /**
+      * GET A NUMERIC OR BOOLEAN FIELD
+      */
+     long getInt(const int id);
+     uint32_t getUInt(const int id);
+     bool getBool(const int id);
+
+     /**
+      * GET A TEXT FIELD (OWNED BY THIS CONFIGURATION; EMPTY FOR OTHER TYPES)
+      */
+     const char* getText(const int id);
+
+     /**
+      * SET A NUMERIC OR BOOLEAN FIELD; RETURNS 'false' IF THE VALUE
+      * DOES NOT FIT THE FIELD
+      */
+     bool setInt(const int id, long value);
+     bool setUInt(const int id, uint32_t value);
+     bool setBool(const int id, bool value);
+
+     /**
+      * SET A TEXT FIELD; RETURNS 'false' IF THE TEXT DOES NOT FIT
+      */
+     bool setText(const int id, const char* value);
+
+     /**
+      * SET ANY FIELD FROM TEXT (AS TAKEN BY THE CONSOLE 'set' COMMAND);
+      * RETURNS 'false' IF THE VALUE IS INVALID FOR THE FIELD
+      */
+     bool set(const int id, const char* value);
+     bool set(const char* name, const char* value);
+
+     /**
+      * RETURNS TRUE IF 'set()' WOULD ACCEPT A VALUE (THE FIELD IS NOT CHANGED)
+      */
+     bool check(const int id, const char* value);
+
+     /**
+      * PRINT A FIELD VALUE AS TEXT (SECRETS ARE MASKED)
+      */
+     void print(Print& out, const int id);
+
+     /**
+      * PRINT ALL FIELDS AS "name=value" LINES
+      */
+     void list(Print& out);
+
+     /**
+      * APPLY CHANGED FIELDS TO A JOYSTICK (THRESHOLDS, BUFFER,
+      * AXIS INVERSION AND EVENT DELAY); ALSO APPLIED NOW
+      */
+     void attach(MonoclePTZJoystick* joystick);
+
+     /**
+      * APPLY CHANGED FIELDS TO A GATEWAY CLIENT (STATUS SUBSCRIPTION
+      * AND FILTER) AND ACCEPT ITS 'config' MESSAGES (MONOCLE_CONFIG_REMOTE
+      * FIELDS ONLY); ALSO APPLIED NOW
+      */
+     void attach(MonocleGatewayClient* gateway);
+
+     /**
+      * APPLY CHANGED FIELDS TO AN IR REMOTE (ONCE ANY IR CODE IS
+      * CONFIGURED, THE CONFIGURED CODES REPLACE ITS CODE TABLE UNTIL NONE
+      * REMAINS); ALSO APPLIED NOW
+      */
+     void attach(MonocleIRRemote* remote);
+
+     /**
+      * APPLY CHANGED FIELDS TO A TELEMETRY COLLECTOR (FRAME INTERVAL
+      * AND FIELD SET); ALSO APPLIED NOW
+      */
+     void attach(MonocleTelemetry* telemetry);
+
+     /**
+      * APPLY ALL FIELDS TO THE ATTACHED COMPONENTS
+      */
+     void apply();
+
+     /**
+      * ACCEPT CONSOLE COMMANDS FROM A STREAM (E.G. 'Serial'):
+      *   list | get <name> | set <name> <value> | save | reset
+      */
+     void serve(Stream* console);
+
+     /**
+      * REGISTERS A CALLBACK FUNCTION POINTER FOR FIELD CHANGES
+      * (E.G. TO RESTART WHEN A MONOCLE_CONFIG_BOOT FIELD CHANGES;
+      * THE ID IS -1 AFTER A RESET)
+      */
+     void onChange(void (*changeCallback)(const int id));
+
+     /**
+      * REGISTER THIS CONFIGURATION AS A TASK OF A SCHEDULER (REPLACES
+      * CALLING 'loop()' FROM THE PROGRAM MAIN LOOP).
+      * RETURNS THE TASK ID OR MONOCLE_TASK_INVALID
+      */
+     int schedule(MonocleScheduler& scheduler);
+
+     /**
+      * THIS METHOD MUST BE CALLED IN THE PROGRAM MAIN LOOP TO
+      * SERVICE THE CONSOLE AND SAVE CHANGES AFTER THE SAVE DELAY
+      */
+     void loop();
+};
+
+#endif //MONOCLE_CONFIG_H
@@ -0,0 +1,396 @@
+/*
+ **********************************************************************
+ *             __  __  ___  _  _  ___   ___ _    ___
+ *            |  \/  |/ _ \| \| |/ _ \ / __| |  | __|
+ *            | |\/| | (_) | .` | (_) | (__| |__| _|
+ *            |_|  |_|\___/|_|\_|\___/ \___|____|___|
+ *
+ * -------------------------------------------------------------------
+ *                     MONOCLE DIGITAL PAD
+ * -------------------------------------------------------------------
+ *
+ *  This library provides logic for a digital (switch based) D-pad
+ *  such as an Atari/Commodore joystick with four direction switches
+ *  and a fire button.  All pins are sampled together (using a single
+ *  port register read per port where the MCU allows it), debounced
+ *  with a bit-parallel vertical counter and mapped to the same PTZ
+ *  vector events raised by the 'MonoclePTZJoystick' class.
+ *
+ *  Author:   Robert Savage
+ *  Date:     2018-02-18
+ *  Website:  http://monoclecam.com
+ *
+ * -------------------------------------------------------------------
+ *        COPYRIGHT SHADEBLUE, LLC @ 2018, ALL RIGHTS RESERVED
+ * -------------------------------------------------------------------
+ *
+ **********************************************************************
+ */
+
+#include "Arduino.h"
+#include "MonocleDigitalPad.h"
+#include "MonocleRecorder.h"
+
+#define PAD_DIRECTION_MASK ((1 << MONOCLE_PAD_UP) | (1 << MONOCLE_PAD_DOWN) | (1 << MONOCLE_PAD_LEFT) | (1 << MONOCLE_PAD_RIGHT))
+#define PAD_NO_PORT 0xFF
+
+/**
+ * Default Constructor
+ */
+MonocleDigitalPad::MonocleDigitalPad() {
+  // no pins configured
+  for(int index = 0; index < MONOCLE_PAD_BUTTONS; index++)
+    pins[index] = -1;
+
+  // initialize callbacks
+  ptzCallback = NULL;
+  buttonCallback = NULL;
+  doubleClickCallback = NULL;
+  longPressCallback = NULL;
+}
+
+/**
+ * CONFIGURE THE PAD DIGITAL INPUT PINS; ALL PINS ARE CONFIGURED
+ * AS 'INPUT_PULLUP' AND ARE ACTIVE LOW (CONTACT CLOSURE TO GROUND).
+ * USE -1 FOR ANY PIN THAT IS NOT CONNECTED.
+ */
+void MonocleDigitalPad::setupPins(const int up, const int down, const int left, const int right, const int fire){
+  pins[MONOCLE_PAD_UP]    = up;
+  pins[MONOCLE_PAD_DOWN]  = down;
+  pins[MONOCLE_PAD_LEFT]  = left;
+  pins[MONOCLE_PAD_RIGHT] = right;
+  pins[MONOCLE_PAD_FIRE]  = fire;
+
+#ifdef MONOCLE_PAD_PORT_READ
+  portCount = 0;
+#endif
+
+  for(int index = 0; index < MONOCLE_PAD_BUTTONS; index++){
+    if(pins[index] < 0) continue;
+
+    // we use a PULLUP to give these pins a HIGH bias; the pad
+    // switches ground each pin when a contact closure is made
+    pinMode(pins[index], INPUT_PULLUP);
+
+#ifdef MONOCLE_PAD_PORT_READ
+    // group the pins by port so each port register is read once per sample
+    pinPort[index] = PAD_NO_PORT;
+#if defined(ESP8266)
+    if(pins[index] >= 16) continue;  // GPIO16 is not part of the GPI register
+#endif
+    MonoclePadPortRegister* port = portInputRegister(digitalPinToPort(pins[index]));
+    uint8_t portIndex = 0;
+    while(portIndex < portCount && ports[portIndex] != port) portIndex++;
+    if(portIndex == portCount) ports[portCount++] = port;
+    pinPort[index] = portIndex;
+    pinMask[index] = digitalPinToBitMask(pins[index]);
+#endif
+  }
+
+  // start from the current (unfiltered) pin state so that switches
+  // already closed at startup do not raise events
+  state = readPins();
+  count0 = count1 = 0;
+}
+
+/**
+ * DEFINE THE SAMPLE INTERVAL (MILLISECONDS); A CHANGE MUST BE
+ * STABLE FOR FOUR CONSECUTIVE SAMPLES TO BE ACCEPTED
+ */
+void MonocleDigitalPad::setSampleInterval(unsigned int milliseconds){
+  sampleInterval = milliseconds;
+}
+
+/**
+ * DEFINE THE PTZ SPEED (1=LOW, 2=MEDIUM, 3=HIGH) USED WHEN
+ * HOLD-TO-ACCELERATE IS DISABLED
+ */
+void MonocleDigitalPad::setSpeed(int speed){
+  this->speed = constrain(speed, MONOCLE_PAD_SPEED_LOW, MONOCLE_PAD_SPEED_HIGH);
+}
+
+/**
+ * ENABLE HOLD-TO-ACCELERATE; A HELD DIRECTION STARTS AT LOW SPEED,
+ * MOVES TO MEDIUM AFTER 'medDelay' AND HIGH AFTER 'highDelay'
+ * MILLISECONDS. SET BOTH DELAYS TO ZERO TO DISABLE.
+ */
+void MonocleDigitalPad::setAcceleration(unsigned int medDelay, unsigned int highDelay){
+  accelerateMedDelay = medDelay;
+  accelerateHighDelay = highDelay;
+}
+
+/**
+ * ENABLE OR DISABLE THE FIRE BUTTON AS ZOOM MODIFIER
+ * (WHEN ENABLED, UP/DOWN CONTROL ZOOM WHILE FIRE IS HELD)
+ */
+void MonocleDigitalPad::setZoomModifier(bool enabled){
+  zoomModifier = enabled;
+}
+
+/**
+ * DEFINE THE MAXIMUM INTERVAL BETWEEN TWO CLICKS OF A DOUBLE-CLICK
+ */
+void MonocleDigitalPad::setDoubleClickInterval(unsigned int milliseconds){
+  doubleClickInterval = milliseconds;
+}
+
+/**
+ * DEFINE THE HOLD TIME OF THE FIRE BUTTON FOR A LONG-PRESS
+ */
+void MonocleDigitalPad::setLongPressInterval(unsigned int milliseconds){
+  longPressInterval = milliseconds;
+}
+
+/**
+ * REGISTERS A CALLBACK FUNCTION POINTER FOR PAD PTZ STATE CHANGE EVENTS
+ */
+void MonocleDigitalPad::onPTZ(void (*ptzCallback)(int, int, int)){
+  this->ptzCallback = ptzCallback;
+}
+
+/**
+ * REGISTERS A CALLBACK FUNCTION POINTER FOR FIRE BUTTON PRESS EVENTS
+ */
+void MonocleDigitalPad::onButtonPress(void (*buttonCallback)(void)){
+  this->buttonCallback = buttonCallback;
+}
+
+/**
+ * REGISTERS A CALLBACK FUNCTION POINTER FOR FIRE BUTTON DOUBLE-CLICK EVENTS
+ */
+void MonocleDigitalPad::onDoubleClick(void (*doubleClickCallback)(void)){
+  this->doubleClickCallback = doubleClickCallback;
+}
+
+/**
+ * REGISTERS A CALLBACK FUNCTION POINTER FOR FIRE BUTTON LONG-PRESS EVENTS
+ * (NOT RAISED IF A DIRECTION IS USED WHILE THE FIRE BUTTON IS HELD)
+ */
+void MonocleDigitalPad::onLongPress(void (*longPressCallback)(void)){
+  this->longPressCallback = longPressCallback;
+}
+
+/**
+ * PUBLISH PTZ AND BUTTON EVENTS TO AN EVENT BUS; THE BUTTON EVENT
+ * VALUE CARRIES THE MONOCLE_BUTTON_* GESTURE
+ */
+void MonocleDigitalPad::publishTo(MonocleEventBus* bus){
+  this->bus = bus;
+}
+
+/**
+ * REPLACE THE PIN READS WITH A FUNCTION RETURNING THE PRESSED
+ * BITMASK INDEXED BY MONOCLE_PAD_* (E.G. TO REPLAY A RECORDED
+ * SESSION); NULL RESTORES THE PIN READS
+ */
+void MonocleDigitalPad::setPinReader(uint8_t (*pinReader)(void)){
+  this->pinReader = pinReader;
+}
+
+/**
+ * RECORD CHANGES OF THE RAW (UNFILTERED) PIN STATE TO A SESSION RECORDER
+ */
+void MonocleDigitalPad::recordTo(MonocleRecorder* recorder){
+  this->recorder = recorder;
+  recordedPins = 0;
+}
+
+/**
+ * GET THE DEBOUNCED STATE OF ALL BUTTONS (BIT SET = PRESSED)
+ */
+uint8_t MonocleDigitalPad::buttons(){
+  return state;
+}
+
+/**
+ * GET THE DEBOUNCED STATE OF A SINGLE BUTTON (MONOCLE_PAD_*)
+ */
+bool MonocleDigitalPad::isPressed(const int button){
+  if(button < 0 || button >= MONOCLE_PAD_BUTTONS) return false;
+  return (state & (1 << button)) != 0;
+}
+
+/**
+ * GET THE LAST EVALUATED PAN STATE
+ */
+int MonocleDigitalPad::pan(){
+  return panState;
+}
+
+/**
+ * GET THE LAST EVALUATED TILT STATE
+ */
+int MonocleDigitalPad::tilt(){
+  return tiltState;
+}
+
+/**
+ * GET THE LAST EVALUATED ZOOM STATE
+ */
+int MonocleDigitalPad::zoom(){
+  return zoomState;
+}
+
+/**
+ * SAMPLE ALL PAD PINS; RETURNS A BITMASK OF THE
+ * PRESSED (LOW) PINS INDEXED BY MONOCLE_PAD_*
+ */
+uint8_t MonocleDigitalPad::readPins(){
+  uint8_t pressed = 0;
+
+#ifdef MONOCLE_PAD_PORT_READ
+  // read each distinct port register once for all pins
+  for(uint8_t index = 0; index < portCount; index++)
+    portValues[index] = *ports[index];
+#endif
+
+  for(int index = 0; index < MONOCLE_PAD_BUTTONS; index++){
+    if(pins[index] < 0) continue;
+#ifdef MONOCLE_PAD_PORT_READ
+    if(pinPort[index] != PAD_NO_PORT){
+      if((portValues[pinPort[index]] & pinMask[index]) == 0) pressed |= (1 << index);
+      continue;
+    }
+#endif
+    if(digitalRead(pins[index]) == LOW) pressed |= (1 << index);
+  }
+  return pressed;
+}
+
+/**
+ * GET THE SPEED FOR A DIRECTION HELD SINCE 'holdTime'
+ */
+int MonocleDigitalPad::rampSpeed(unsigned long holdTime, unsigned long now){
+  if(accelerateMedDelay == 0 && accelerateHighDelay == 0) return speed;
+
+  unsigned long held = now - holdTime;
+  if(accelerateHighDelay > 0 && held >= accelerateHighDelay) return MONOCLE_PAD_SPEED_HIGH;
+  if(accelerateMedDelay > 0 && held >= accelerateMedDelay) return MONOCLE_PAD_SPEED_MED;
+  return MONOCLE_PAD_SPEED_LOW;
+}
+
+/**
+ * RAISE A FIRE BUTTON GESTURE TO CALLBACK AND EVENT BUS
+ */
+void MonocleDigitalPad::raiseButton(const int gesture){
+  if(gesture == MONOCLE_BUTTON_PRESS && buttonCallback != NULL) buttonCallback();
+  if(gesture == MONOCLE_BUTTON_DOUBLE_CLICK && doubleClickCallback != NULL) doubleClickCallback();
+  if(gesture == MONOCLE_BUTTON_LONG_PRESS && longPressCallback != NULL) longPressCallback();
+  if(bus != NULL) bus->publishButton(gesture);
+}
+
+/**
+ * EVALUATE FIRE BUTTON PRESS, DOUBLE-CLICK AND LONG-PRESS GESTURES
+ */
+void MonocleDigitalPad::processGestures(uint8_t pressed, uint8_t released, unsigned long now){
+  const uint8_t fire = (1 << MONOCLE_PAD_FIRE);
+
+  if(pressed & fire){
+    raiseButton(MONOCLE_BUTTON_PRESS);
+
+    // a second click within the double-click interval completes a double-click
+    if(lastClickTime > 0 && now - lastClickTime < doubleClickInterval){
+      raiseButton(MONOCLE_BUTTON_DOUBLE_CLICK);
+      lastClickTime = 0;
+    }
+    else {
+      lastClickTime = now;
+    }
+    pressTime = now;
+    longPressPending = true;
+  }
+  else if(released & fire){
+    longPressPending = false;
+  }
+  else if(longPressPending){
+    // using a direction while fire is held (zoom) cancels the long-press
+    if(state & PAD_DIRECTION_MASK){
+      longPressPending = false;
+    }
+    else if(now - pressTime >= longPressInterval){
+      raiseButton(MONOCLE_BUTTON_LONG_PRESS);
+      longPressPending = false;
+      lastClickTime = 0;  // a long-press never starts a double-click
+    }
+  }
+}
+
+/**
+ * EVALUATE THE PTZ VECTOR FROM THE DEBOUNCED PAD STATE
+ * AND RAISE A PTZ EVENT IF ANY AXIS STATE CHANGED
+ */
+void MonocleDigitalPad::processPTZ(unsigned long now){
+  int panDirection = 0;
+  int verticalDirection = 0;
+  if(isPressed(MONOCLE_PAD_LEFT))  panDirection--;
+  if(isPressed(MONOCLE_PAD_RIGHT)) panDirection++;
+  if(isPressed(MONOCLE_PAD_UP))    verticalDirection++;
+  if(isPressed(MONOCLE_PAD_DOWN))  verticalDirection--;
+
+  // UP/DOWN control zoom while the fire button is held (if enabled); otherwise tilt
+  bool zooming = zoomModifier && isPressed(MONOCLE_PAD_FIRE);
+  int tiltDirection = zooming ? 0 : verticalDirection;
+  int zoomDirection = zooming ? verticalDirection : 0;
+
+  // restart the hold timer for each axis when its direction changes
+  if(panDirection != (panState > 0) - (panState < 0)) panHoldTime = now;
+  if(tiltDirection != (tiltState > 0) - (tiltState < 0)) tiltHoldTime = now;
+  if(zoomDirection != (zoomState > 0) - (zoomState < 0)) zoomHoldTime = now;
+
+  int newPan  = panDirection  * rampSpeed(panHoldTime, now);
+  int newTilt = tiltDirection * rampSpeed(tiltHoldTime, now);
+  int newZoom = zoomDirection * rampSpeed(zoomHoldTime, now);
+
+  if(newPan == panState && newTilt == tiltState && newZoom == zoomState) return;
+  panState = newPan;
+  tiltState = newTilt;
+  zoomState = newZoom;
+
+  if(ptzCallback != NULL) ptzCallback(panState, tiltState, zoomState);
+  if(bus != NULL) bus->publishPTZ(panState, tiltState, zoomState);
+}
+
+/**
+ * SCHEDULER TASK ENTRY POINT
+ */
+void MonocleDigitalPad::internal_pad_task(void* context){
+  ((MonocleDigitalPad*)context)->loop();
+}
+
+/**
+ * REGISTER THIS PAD AS A TASK OF A SCHEDULER RUNNING ONCE PER
+ * SAMPLE INTERVAL (REPLACES
+ * CALLING 'loop()' FROM THE PROGRAM MAIN LOOP).
+ * RETURNS THE TASK ID OR MONOCLE_TASK_INVALID
+ */
+int MonocleDigitalPad::schedule(MonocleScheduler& scheduler){
+  return scheduler.every(sampleInterval, internal_pad_task, this, MONOCLE_PAD_TASK_BUDGET);
+}
+
+/**
+ * THIS METHOD MUST BE CALLED IN THE PROGRAM MAIN LOOP
+ * TO SERVICE THIS CLASS; PINS ARE ONLY SAMPLED ONCE
+ * PER SAMPLE INTERVAL SO NO DELAY IS REQUIRED
+ */
+void MonocleDigitalPad::loop(){
+  unsigned long now = millis();
+  if(now - sampleTime < sampleInterval) return;
+  sampleTime = now;
+
+  // bit-parallel debounce (vertical counter); each bit has a two bit
+  // counter which advances while the raw input differs from the debounced
+  // state and the state only toggles after four consecutive differing samples
+  uint8_t pressed = (pinReader != NULL) ? pinReader() : readPins();
+  if(recorder != NULL && pressed != recordedPins){
+    recordedPins = pressed;
+    recorder->record(MONOCLE_RECORD_PAD, 0, pressed);
+  }
+  uint8_t delta = pressed ^ state;
+  count1 = (count1 ^ count0) & delta;
+  count0 = ~count0 & delta;
+  uint8_t toggle = delta & ~(count0 | count1);
+  state ^= toggle;
+
+  processGestures(toggle & state, toggle & ~state, now);
+  processPTZ(now);
+}
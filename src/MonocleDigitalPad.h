@@ -0,0 +1,269 @@
+/*
+ **********************************************************************
+ *             __  __  ___  _  _  ___   ___ _    ___
+ *            |  \/  |/ _ \| \| |/ _ \ / __| |  | __|
+ *            | |\/| | (_) | .` | (_) | (__| |__| _|
+ *            |_|  |_|\___/|_|\_|\___/ \___|____|___|
+ *
+ * -------------------------------------------------------------------
+ *                     MONOCLE DIGITAL PAD
+ * -------------------------------------------------------------------
+ *
+ *  This library provides logic for a digital (switch based) D-pad
+ *  such as an Atari/Commodore joystick with four direction switches
+ *  and a fire button.  All pins are sampled together (using a single
+ *  port register read per port where the MCU allows it), debounced
+ *  with a bit-parallel vertical counter and mapped to the same PTZ
+ *  vector events raised by the 'MonoclePTZJoystick' class.
+ *
+ *  LEFT/RIGHT control panning, UP/DOWN control tilting and while
+ *  the fire button is held UP/DOWN control zooming.  Holding a
+ *  direction ramps the speed from LOW to MEDIUM to HIGH over time.
+ *
+ *  Author:   Robert Savage
+ *  Date:     2018-02-18
+ *  Website:  http://monoclecam.com
+ *
+ * -------------------------------------------------------------------
+ *        COPYRIGHT SHADEBLUE, LLC @ 2018, ALL RIGHTS RESERVED
+ * -------------------------------------------------------------------
+ *
+ **********************************************************************
+ */
+#ifndef MONOCLE_DIGITAL_PAD_H
+#define MONOCLE_DIGITAL_PAD_H
+
+#include <Arduino.h>
+#include "MonocleEventBus.h"
+#include "MonocleScheduler.h"
+
+class MonocleRecorder;
+
+/* PAD BUTTON INDEXES (BIT POSITIONS IN THE PAD STATE) */
+#define MONOCLE_PAD_UP      0
+#define MONOCLE_PAD_DOWN    1
+#define MONOCLE_PAD_LEFT    2
+#define MONOCLE_PAD_RIGHT   3
+#define MONOCLE_PAD_FIRE    4
+#define MONOCLE_PAD_BUTTONS 5
+
+/* PTZ SPEED LEVELS */
+#define MONOCLE_PAD_SPEED_LOW  1
+#define MONOCLE_PAD_SPEED_MED  2
+#define MONOCLE_PAD_SPEED_HIGH 3
+
+#define MONOCLE_PAD_DEFAULT_SAMPLE_INTERVAL  4     // milliseconds (4 stable samples required)
+#define MONOCLE_PAD_DEFAULT_SPEED            MONOCLE_PAD_SPEED_MED
+#define MONOCLE_PAD_DEFAULT_DOUBLE_CLICK     250   // milliseconds
+#define MONOCLE_PAD_DEFAULT_LONG_PRESS       1000  // milliseconds
+
+/* SCHEDULER TASK EXECUTION BUDGET (THE TASK RUNS EVERY SAMPLE INTERVAL) */
+#ifndef MONOCLE_PAD_TASK_BUDGET
+#define MONOCLE_PAD_TASK_BUDGET 500   // microseconds
+#endif
+
+/* USE PORT REGISTER BATCH READS WHEN THE CORE PROVIDES THE PORT MACROS */
+#if defined(portInputRegister) && defined(digitalPinToPort) && defined(digitalPinToBitMask)
+#define MONOCLE_PAD_PORT_READ 1
+#if defined(__AVR__)
+typedef volatile uint8_t MonoclePadPortRegister;
+#else
+typedef volatile uint32_t MonoclePadPortRegister;
+#endif
+#endif
+
+class MonocleDigitalPad
+{
+   private:
+    /* PIN CONFIGURATION */
+    int pins[MONOCLE_PAD_BUTTONS];
+#ifdef MONOCLE_PAD_PORT_READ
+    MonoclePadPortRegister* ports[MONOCLE_PAD_BUTTONS];   // distinct port registers
+    uint32_t portValues[MONOCLE_PAD_BUTTONS];             // last value read per port
+    uint8_t portCount = 0;
+    uint8_t pinPort[MONOCLE_PAD_BUTTONS];                 // port index for each pin
+    uint32_t pinMask[MONOCLE_PAD_BUTTONS];                // bit mask for each pin
+#endif
+
+    /* VERTICAL COUNTER DEBOUNCE STATE (ONE BIT PER BUTTON) */
+    uint8_t count0 = 0;
+    uint8_t count1 = 0;
+    uint8_t state = 0;      // debounced state; bit set = pressed
+    unsigned long sampleTime = 0;
+    unsigned int sampleInterval = MONOCLE_PAD_DEFAULT_SAMPLE_INTERVAL;
+
+    /* PTZ STATE */
+    int panState = 0;
+    int tiltState = 0;
+    int zoomState = 0;
+    int speed = MONOCLE_PAD_DEFAULT_SPEED;
+    bool zoomModifier = true;
+
+    /* HOLD-TO-ACCELERATE RAMP (DISABLED WHEN BOTH DELAYS ARE ZERO) */
+    unsigned int accelerateMedDelay = 0;
+    unsigned int accelerateHighDelay = 0;
+    unsigned long panHoldTime = 0;
+    unsigned long tiltHoldTime = 0;
+    unsigned long zoomHoldTime = 0;
+
+    /* FIRE BUTTON GESTURES */
+    unsigned int doubleClickInterval = MONOCLE_PAD_DEFAULT_DOUBLE_CLICK;
+    unsigned int longPressInterval = MONOCLE_PAD_DEFAULT_LONG_PRESS;
+    unsigned long pressTime = 0;        // time the fire button was last pressed
+    unsigned long lastClickTime = 0;    // time of the first click in a double-click
+    bool longPressPending = false;
+
+    /* CALLBACKS */
+    void (*ptzCallback)(int pan, int tilt, int zoom);
+    void (*buttonCallback)(void);
+    void (*doubleClickCallback)(void);
+    void (*longPressCallback)(void);
+
+    /* OPTIONAL EVENT BUS (PTZ AND BUTTON EVENTS) */
+    MonocleEventBus* bus = NULL;
+
+    /* PIN READER (NULL = READ THE PINS) AND OPTIONAL SESSION RECORDER */
+    uint8_t (*pinReader)(void) = NULL;
+    MonocleRecorder* recorder = NULL;
+    uint8_t recordedPins = 0;   // last raw pin state recorded
+
+    /* INTERNAL PROCESSING */
+    uint8_t readPins();
+    int rampSpeed(unsigned long holdTime, unsigned long now);
+    void processGestures(uint8_t pressed, uint8_t released, unsigned long now);
+    void raiseButton(const int gesture);
+    void processPTZ(unsigned long now);
+
+    /* SCHEDULER TASK ENTRY POINT */
+    static void internal_pad_task(void* context);
+
+   public:
+
+    /*
+     * Default Constructor
+     */
+     MonocleDigitalPad();
+
+     /**
+      * CONFIGURE THE PAD DIGITAL INPUT PINS; ALL PINS ARE CONFIGURED
+      * AS 'INPUT_PULLUP' AND ARE ACTIVE LOW (CONTACT CLOSURE TO GROUND).
+      * USE -1 FOR ANY PIN THAT IS NOT CONNECTED.
+      */
+     void setupPins(const int up, const int down, const int left, const int right, const int fire);
+
+     /**
+      * DEFINE THE SAMPLE INTERVAL (MILLISECONDS); A CHANGE MUST BE
+      * STABLE FOR FOUR CONSECUTIVE SAMPLES TO BE ACCEPTED
+      */
+     void setSampleInterval(unsigned int milliseconds);
+
+     /**
+      * DEFINE THE PTZ SPEED (1=LOW, 2=MEDIUM, 3=HIGH) USED WHEN
+      * HOLD-TO-ACCELERATE IS DISABLED
+      */
+     void setSpeed(int speed);
+
+     /**
+      * ENABLE HOLD-TO-ACCELERATE; A HELD DIRECTION STARTS AT LOW SPEED,
+      * MOVES TO MEDIUM AFTER 'medDelay' AND HIGH AFTER 'highDelay'
+      * MILLISECONDS. SET BOTH DELAYS TO ZERO TO DISABLE.
+      */
+     void setAcceleration(unsigned int medDelay, unsigned int highDelay);
+
+     /**
+      * ENABLE OR DISABLE THE FIRE BUTTON AS ZOOM MODIFIER
+      * (WHEN ENABLED, UP/DOWN CONTROL ZOOM WHILE FIRE IS HELD)
+      */
+     void setZoomModifier(bool enabled);
+
+     /**
+      * DEFINE THE MAXIMUM INTERVAL BETWEEN TWO CLICKS OF A DOUBLE-CLICK
+      */
+     void setDoubleClickInterval(unsigned int milliseconds);
+
+     /**
+      * DEFINE THE HOLD TIME OF THE FIRE BUTTON FOR A LONG-PRESS
+      */
+     void setLongPressInterval(unsigned int milliseconds);
+
+     /**
+      * REGISTERS A CALLBACK FUNCTION POINTER FOR PAD PTZ STATE CHANGE EVENTS
+      */
+     void onPTZ(void (*ptzCallback)(int, int, int));
+
+     /**
+      * REGISTERS A CALLBACK FUNCTION POINTER FOR FIRE BUTTON PRESS EVENTS
+      */
+     void onButtonPress(void (*buttonCallback)(void));
+
+     /**
+      * REGISTERS A CALLBACK FUNCTION POINTER FOR FIRE BUTTON DOUBLE-CLICK EVENTS
+      */
+     void onDoubleClick(void (*doubleClickCallback)(void));
+
+     /**
+      * REGISTERS A CALLBACK FUNCTION POINTER FOR FIRE BUTTON LONG-PRESS EVENTS
+      * (NOT RAISED IF A DIRECTION IS USED WHILE THE FIRE BUTTON IS HELD)
+      */
+     void onLongPress(void (*longPressCallback)(void));
+
+     /**
+      * PUBLISH PTZ AND BUTTON EVENTS TO AN EVENT BUS; THE BUTTON EVENT
+      * VALUE CARRIES THE MONOCLE_BUTTON_* GESTURE
+      */
+     void publishTo(MonocleEventBus* bus);
+
+     /**
+      * REPLACE THE PIN READS WITH A FUNCTION RETURNING THE PRESSED
+      * BITMASK INDEXED BY MONOCLE_PAD_* (E.G. TO REPLAY A RECORDED
+      * SESSION); NULL RESTORES THE PIN READS
+      */
+     void setPinReader(uint8_t (*pinReader)(void));
+
+     /**
+      * RECORD CHANGES OF THE RAW (UNFILTERED) PIN STATE TO A SESSION RECORDER
+      */
+     void recordTo(MonocleRecorder* recorder);
+
+     /**
+      * GET THE DEBOUNCED STATE OF ALL BUTTONS (BIT SET = PRESSED)
+      */
+     uint8_t buttons();
+
+     /**
+      * GET THE DEBOUNCED STATE OF A SINGLE BUTTON (MONOCLE_PAD_*)
+      */
+     bool isPressed(const int button);
+
+     /**
+      * GET THE LAST EVALUATED PAN STATE
+      */
+     int pan();
+
+     /**
+      * GET THE LAST EVALUATED TILT STATE
+      */
+     int tilt();
+
+     /**
+      * GET THE LAST EVALUATED ZOOM STATE
+      */
+     int zoom();
+
+     /**
+      * REGISTER THIS PAD AS A TASK OF A SCHEDULER RUNNING ONCE PER
+      * SAMPLE INTERVAL (REPLACES
+      * CALLING 'loop()' FROM THE PROGRAM MAIN LOOP).
+      * RETURNS THE TASK ID OR MONOCLE_TASK_INVALID
+      */
+     int schedule(MonocleScheduler& scheduler);
+
+     /**
+      * THIS METHOD MUST BE CALLED IN THE PROGRAM MAIN LOOP
+      * TO SERVICE THIS CLASS; PINS ARE ONLY SAMPLED ONCE
+      * PER SAMPLE INTERVAL SO NO DELAY IS REQUIRED
+      */
+     void loop();
+};
+
+#endif //MONOCLE_DIGITAL_PAD_H
@@ -0,0 +1,269 @@
+/*
+ **********************************************************************
+ *             __  __  ___  _  _  ___   ___ _    ___
+ *            |  \/  |/ _ \| \| |/ _ \ / __| |  | __|
+ *            | |\/| | (_) | .` | (_) | (__| |__| _|
+ *            |_|  |_|\___/|_|\_|\___/ \___|____|___|
+ *
+ * -------------------------------------------------------------------
+ *                     MONOCLE GATEWAY DISCOVERY
+ * -------------------------------------------------------------------
+ *
+ *  This library discovers Monocle Gateway services on the local
+ *  subnet so controllers do not need a hard-coded gateway address.
+ *  A small UDP probe is broadcast and each gateway (or a responder
+ *  running next to it) answers with its web-socket port:
+ *
+ *     probe    (to port 8089)   : "MONOCLE-DISCOVER"
+ *     response (to the sender)  : "MONOCLE-GATEWAY <port>"
+ *
+ *  The last answering endpoint is cached in persistent storage so
+ *  the controller connects immediately at startup; the endpoint is
+ *  revalidated in the background and replaced when the cached
+ *  gateway stops answering and another gateway responds.  After
+ *  several unanswered probe rounds the cached record is erased and
+ *  probes fall back to the broadcast address.
+ *
+ *  Author:   Robert Savage
+ *  Date:     2018-02-18
+ *  Website:  http://monoclecam.com
+ *
+ * -------------------------------------------------------------------
+ *        COPYRIGHT SHADEBLUE, LLC @ 2018, ALL RIGHTS RESERVED
+ * -------------------------------------------------------------------
+ *
+ **********************************************************************
+ */
+
+#include "Arduino.h"
+#include "MonocleDiscovery.h"
+
+/**
+ * Default Constructor
+ */
+MonocleDiscovery::MonocleDiscovery(UDP& udp) : udp(udp), probeAddress(255, 255, 255, 255) {
+  // initialize callbacks
+  discoveredCallback = NULL;
+}
+
+/**
+ * CACHE THE LAST ANSWERING ENDPOINT IN PERSISTENT STORAGE
+ */
+void MonocleDiscovery::setStorage(MonocleStorage* storage, size_t address){
+  this->storage = storage;
+  this->storageAddress = address;
+}
+
+/**
+ * DEFINE THE ADDRESS PROBES ARE SENT TO (BROADCAST AFTER
+ * MONOCLE_DISCOVERY_MAX_MISSES UNANSWERED ROUNDS, UNTIL SET AGAIN)
+ */
+void MonocleDiscovery::setProbeAddress(const IPAddress& address){
+  this->probeAddress = address;
+  this->broadcast = false;
+}
+
+/**
+ * RESTORE THE CACHED ENDPOINT, OPEN THE UDP SOCKET AND SEND THE
+ * FIRST PROBE (THE NETWORK MUST BE CONNECTED)
+ */
+void MonocleDiscovery::begin(){
+  MonocleDiscoveryRecord record;
+  if(storage != NULL && storage->load(storageAddress, MONOCLE_DISCOVERY_RECORD_VERSION, &record, sizeof(record))){
+    gatewayAddress = IPAddress(record.address[0], record.address[1], record.address[2], record.address[3]);
+    gatewayPort = record.port;
+    known = true;
+    restored = true;
+  }
+
+  udp.begin(MONOCLE_DISCOVERY_LOCAL_PORT);
+
+  // a cached endpoint is used right away and revalidated by this first probe
+  probe();
+}
+
+/**
+ * DETERMINE IF A GATEWAY ENDPOINT IS KNOWN (CACHED OR DISCOVERED)
+ */
+bool MonocleDiscovery::found(){
+  return known;
+}
+
+/**
+ * DETERMINE IF THE CURRENT ENDPOINT WAS RESTORED FROM STORAGE
+ * AND HAS NOT ANSWERED A PROBE YET
+ */
+bool MonocleDiscovery::cached(){
+  return known && restored;
+}
+
+/**
+ * GET THE CURRENT GATEWAY ENDPOINT ADDRESS AND WEB-SOCKET PORT
+ */
+IPAddress MonocleDiscovery::address(){
+  return gatewayAddress;
+}
+uint16_t MonocleDiscovery::port(){
+  return gatewayPort;
+}
+
+/**
+ * GET THE NUMBER OF PROBES SENT AND RESPONSES RECEIVED
+ */
+unsigned long MonocleDiscovery::probes(){
+  return probeCount;
+}
+unsigned long MonocleDiscovery::responses(){
+  return responseCount;
+}
+
+/**
+ * GET THE NUMBER OF CONSECUTIVE PROBE ROUNDS WITHOUT AN ANSWER
+ */
+uint8_t MonocleDiscovery::unanswered(){
+  return misses;
+}
+
+/**
+ * REGISTERS A CALLBACK FUNCTION POINTER FOR A NEWLY DISCOVERED
+ * OR CHANGED GATEWAY ENDPOINT
+ */
+void MonocleDiscovery::onDiscovered(void (*discoveredCallback)(const IPAddress& address, const uint16_t port)){
+  this->discoveredCallback = discoveredCallback;
+}
+
+/**
+ * BROADCAST A PROBE NOW
+ */
+void MonocleDiscovery::probe(){
+  // a directed probe address that stayed silent falls back to broadcast
+  if(broadcast) udp.beginPacket(IPAddress(255, 255, 255, 255), MONOCLE_DISCOVERY_PORT);
+  else udp.beginPacket(probeAddress, MONOCLE_DISCOVERY_PORT);
+  udp.write((const uint8_t*)MONOCLE_DISCOVERY_PROBE, strlen(MONOCLE_DISCOVERY_PROBE));
+  udp.endPacket();
+
+  probeTime = millis();
+  probing = true;
+  answered = false;
+  candidatePort = 0;
+  probeCount++;
+}
+
+/**
+ * FORGET THE CURRENT ENDPOINT (E.G. AFTER A FAILED CONNECTION),
+ * ERASE THE CACHED RECORD AND PROBE AGAIN
+ */
+void MonocleDiscovery::invalidate(){
+  forget();
+  probe();
+}
+
+/**
+ * DROP THE CURRENT ENDPOINT AND ERASE ITS CACHED RECORD
+ */
+void MonocleDiscovery::forget(){
+  known = false;
+  restored = false;
+  gatewayPort = 0;
+  if(storage != NULL) storage->erase(storageAddress);
+}
+
+/**
+ * MAKE AN ANSWERING ENDPOINT CURRENT AND CACHE IT
+ */
+void MonocleDiscovery::adopt(const IPAddress& address, const uint16_t port){
+  bool changed = !known || !(gatewayAddress == address) || gatewayPort != port;
+  gatewayAddress = address;
+  gatewayPort = port;
+  known = true;
+  restored = false;
+  answered = true;
+  misses = 0;
+  if(!changed) return;
+
+  // cache the endpoint (the storage skips unchanged records)
+  if(storage != NULL){
+    MonocleDiscoveryRecord record;
+    for(int index = 0; index < 4; index++) record.address[index] = address[index];
+    record.port = port;
+    storage->save(storageAddress, MONOCLE_DISCOVERY_RECORD_VERSION, &record, sizeof(record));
+  }
+
+  // notify discovery listener
+  if(discoveredCallback != NULL) discoveredCallback(gatewayAddress, gatewayPort);
+}
+
+/**
+ * RECEIVE ALL PENDING PROBE RESPONSES
+ */
+void MonocleDiscovery::receive(){
+  const size_t prefix = strlen(MONOCLE_DISCOVERY_RESPONSE);
+  char buffer[32];
+  int size;
+  while((size = udp.parsePacket()) > 0){
+    int length = udp.read(buffer, sizeof(buffer) - 1);
+    if(length <= 0) continue;
+    buffer[length] = 0;
+
+    // ignore anything that is not a gateway response (e.g. our own broadcast probe)
+    if(strncmp(buffer, MONOCLE_DISCOVERY_RESPONSE, prefix) != 0) continue;
+    long port = atol(buffer + prefix);
+    if(port <= 0 || port > 0xFFFF) continue;
+    responseCount++;
+
+    IPAddress address = udp.remoteIP();
+    if(!known || (gatewayAddress == address && gatewayPort == port)){
+      // first gateway found or the current gateway confirmed
+      adopt(address, (uint16_t)port);
+    }
+    else if(probing && candidatePort == 0){
+      // another gateway; only used if the current one does not answer
+      candidateAddress = address;
+      candidatePort = (uint16_t)port;
+    }
+  }
+}
+
+/**
+ * SCHEDULER TASK ENTRY POINT
+ */
+void MonocleDiscovery::internal_discovery_task(void* context){
+  ((MonocleDiscovery*)context)->loop();
+}
+
+/**
+ * REGISTER THIS DISCOVERY AS A TASK OF A SCHEDULER (REPLACES
+ * CALLING 'loop()' FROM THE PROGRAM MAIN LOOP).
+ * RETURNS THE TASK ID OR MONOCLE_TASK_INVALID
+ */
+int MonocleDiscovery::schedule(MonocleScheduler& scheduler){
+  return scheduler.every(MONOCLE_DISCOVERY_TASK_INTERVAL, internal_discovery_task, this, MONOCLE_DISCOVERY_TASK_BUDGET);
+}
+
+/**
+ * THIS METHOD MUST BE CALLED IN THE PROGRAM MAIN LOOP
+ * TO RECEIVE RESPONSES AND PROBE PERIODICALLY
+ */
+void MonocleDiscovery::loop(){
+  receive();
+
+  unsigned long elapsed = millis() - probeTime;
+
+  // end of a probe round; move to another gateway if the current one stayed
+  // silent and drop a (cached) gateway that missed too many rounds
+  if(probing && elapsed >= MONOCLE_DISCOVERY_RESPONSE_TIMEOUT){
+    probing = false;
+    if(known && !answered && candidatePort != 0){
+      adopt(candidateAddress, candidatePort);
+    }
+    else if(!answered && misses < 0xFF && ++misses >= MONOCLE_DISCOVERY_MAX_MISSES){
+      broadcast = true;
+      if(known) forget();
+    }
+  }
+
+  // probe often while no gateway is known or the current one missed a
+  // round (so it is dropped within a few seconds) and revalidate slowly otherwise
+  unsigned long interval = (known && misses == 0) ? MONOCLE_DISCOVERY_REVALIDATE_INTERVAL : MONOCLE_DISCOVERY_PROBE_INTERVAL;
+  if(elapsed >= interval) probe();
+}
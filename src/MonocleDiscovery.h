@@ -0,0 +1,218 @@
+/*
+ **********************************************************************
+ *             __  __  ___  _  _  ___   ___ _    ___
+ *            |  \/  |/ _ \| \| |/ _ \ / __| |  | __|
+ *            | |\/| | (_) | .` | (_) | (__| |__| _|
+ *            |_|  |_|\___/|_|\_|\___/ \___|____|___|
+ *
+ * -------------------------------------------------------------------
+ *                     MONOCLE GATEWAY DISCOVERY
+ * -------------------------------------------------------------------
+ *
+ *  This library discovers Monocle Gateway services on the local
+ *  subnet so controllers do not need a hard-coded gateway address.
+ *  A small UDP probe is broadcast and each gateway (or a responder
+ *  running next to it) answers with its web-socket port:
+ *
+ *     probe    (to port 8089)   : "MONOCLE-DISCOVER"
+ *     response (to the sender)  : "MONOCLE-GATEWAY <port>"
+ *
+ *  The last answering endpoint is cached in persistent storage so
+ *  the controller connects immediately at startup; the endpoint is
+ *  revalidated in the background and replaced when the cached
+ *  gateway stops answering and another gateway responds.  After
+ *  several unanswered probe rounds the cached record is erased and
+ *  probes fall back to the broadcast address.
+ *
+ *  Author:   Robert Savage
+ *  Date:     2018-02-18
+ *  Website:  http://monoclecam.com
+ *
+ * -------------------------------------------------------------------
+ *        COPYRIGHT SHADEBLUE, LLC @ 2018, ALL RIGHTS RESERVED
+ * -------------------------------------------------------------------
+ *
+ **********************************************************************
+ */
+#ifndef MONOCLE_DISCOVERY_H
+#define MONOCLE_DISCOVERY_H
+
+#include <Arduino.h>
+#include <Udp.h>
+#include "MonocleStorage.h"
+#include "MonocleScheduler.h"
+
+/* UDP PORTS OF THE GATEWAY RESPONDER AND OF THE LOCAL SOCKET RECEIVING RESPONSES */
+#ifndef MONOCLE_DISCOVERY_PORT
+#define MONOCLE_DISCOVERY_PORT       8089
+#endif
+#ifndef MONOCLE_DISCOVERY_LOCAL_PORT
+#define MONOCLE_DISCOVERY_LOCAL_PORT 8090
+#endif
+
+/* PROBE TIMING */
+#ifndef MONOCLE_DISCOVERY_PROBE_INTERVAL
+#define MONOCLE_DISCOVERY_PROBE_INTERVAL      1000    // milliseconds (while no gateway is known)
+#endif
+#ifndef MONOCLE_DISCOVERY_REVALIDATE_INTERVAL
+#define MONOCLE_DISCOVERY_REVALIDATE_INTERVAL 60000   // milliseconds (while a gateway is known)
+#endif
+#ifndef MONOCLE_DISCOVERY_RESPONSE_TIMEOUT
+#define MONOCLE_DISCOVERY_RESPONSE_TIMEOUT    500     // milliseconds
+#endif
+
+/* UNANSWERED PROBE ROUNDS (REPEATED AT THE PROBE INTERVAL) BEFORE THE CURRENT
+   ENDPOINT AND ITS CACHED RECORD ARE DROPPED AND PROBES ARE BROADCAST */
+#ifndef MONOCLE_DISCOVERY_MAX_MISSES
+#define MONOCLE_DISCOVERY_MAX_MISSES          3
+#endif
+
+/* SCHEDULER TASK INTERVAL AND EXECUTION BUDGET */
+#ifndef MONOCLE_DISCOVERY_TASK_INTERVAL
+#define MONOCLE_DISCOVERY_TASK_INTERVAL 20     // milliseconds
+#endif
+#ifndef MONOCLE_DISCOVERY_TASK_BUDGET
+#define MONOCLE_DISCOVERY_TASK_BUDGET   2000   // microseconds (excluding storage writes)
+#endif
+
+/* PROBE AND RESPONSE MESSAGES */
+#define MONOCLE_DISCOVERY_PROBE    "MONOCLE-DISCOVER"
+#define MONOCLE_DISCOVERY_RESPONSE "MONOCLE-GATEWAY "
+
+/* VERSION OF THE CACHED ENDPOINT RECORD */
+#define MONOCLE_DISCOVERY_RECORD_VERSION 1
+
+/**
+ * CACHED GATEWAY ENDPOINT RECORD
+ */
+struct MonocleDiscoveryRecord {
+  uint8_t address[4];
+  uint16_t port;
+};
+
+class MonocleDiscovery
+{
+   private:
+     UDP& udp;
+
+     /* PERSISTENT STORAGE OF THE LAST ANSWERING ENDPOINT */
+     MonocleStorage* storage = NULL;
+     size_t storageAddress = 0;
+
+     /* CURRENT GATEWAY ENDPOINT */
+     IPAddress gatewayAddress;
+     uint16_t gatewayPort = 0;
+     bool known = false;
+     bool restored = false;
+
+     /* PROBE STATE */
+     IPAddress probeAddress;
+     unsigned long probeTime = 0;
+     bool probing = false;
+     bool answered = false;            // the current endpoint answered the last probe
+     IPAddress candidateAddress;       // another endpoint that answered the last probe
+     uint16_t candidatePort = 0;
+     uint8_t misses = 0;               // consecutive probe rounds without an answer
+     bool broadcast = false;           // the probe address stayed silent; probes are broadcast
+
+     /* STATISTICS */
+     unsigned long probeCount = 0;
+     unsigned long responseCount = 0;
+
+     /* CALLBACKS */
+     void (*discoveredCallback)(const IPAddress& address, const uint16_t port);
+
+     /* INTERNAL PROCESSING */
+     void receive();
+     void adopt(const IPAddress& address, const uint16_t port);
+     void forget();
+
+     /* SCHEDULER TASK ENTRY POINT */
+     static void internal_discovery_task(void* context);
+
+   public:
+    /**
+     * Default Constructor
+     */
+     MonocleDiscovery(UDP& udp);
+
+     /**
+      * CACHE THE LAST ANSWERING ENDPOINT IN PERSISTENT STORAGE;
+      * THE RECORD OCCUPIES 'MonocleStorage::footprint(sizeof(MonocleDiscoveryRecord))'
+      * BYTES AT THE GIVEN ADDRESS
+      */
+     void setStorage(MonocleStorage* storage, size_t address = 0);
+
+     /**
+      * DEFINE THE ADDRESS PROBES ARE SENT TO (DEFAULT: THE LIMITED
+      * BROADCAST ADDRESS 255.255.255.255); PROBES ARE BROADCAST AFTER
+      * MONOCLE_DISCOVERY_MAX_MISSES UNANSWERED ROUNDS (UNTIL SET AGAIN)
+      */
+     void setProbeAddress(const IPAddress& address);
+
+     /**
+      * RESTORE THE CACHED ENDPOINT, OPEN THE UDP SOCKET AND SEND THE
+      * FIRST PROBE (THE NETWORK MUST BE CONNECTED)
+      */
+     void begin();
+
+     /**
+      * DETERMINE IF A GATEWAY ENDPOINT IS KNOWN (CACHED OR DISCOVERED)
+      */
+     bool found();
+
+     /**
+      * DETERMINE IF THE CURRENT ENDPOINT WAS RESTORED FROM STORAGE
+      * AND HAS NOT ANSWERED A PROBE YET
+      */
+     bool cached();
+
+     /**
+      * GET THE CURRENT GATEWAY ENDPOINT ADDRESS AND WEB-SOCKET PORT
+      */
+     IPAddress address();
+     uint16_t port();
+
+     /**
+      * BROADCAST A PROBE NOW
+      */
+     void probe();
+
+     /**
+      * FORGET THE CURRENT ENDPOINT (E.G. AFTER A FAILED CONNECTION),
+      * ERASE THE CACHED RECORD AND PROBE AGAIN
+      */
+     void invalidate();
+
+     /**
+      * GET THE NUMBER OF PROBES SENT AND RESPONSES RECEIVED
+      */
+     unsigned long probes();
+     unsigned long responses();
+
+     /**
+      * GET THE NUMBER OF CONSECUTIVE PROBE ROUNDS WITHOUT AN ANSWER
+      */
+     uint8_t unanswered();
+
+     /**
+      * REGISTERS A CALLBACK FUNCTION POINTER FOR A NEWLY DISCOVERED
+      * OR CHANGED GATEWAY ENDPOINT
+      */
+     void onDiscovered(void (*discoveredCallback)(const IPAddress& address, const uint16_t port));
+
+     /**
+      * REGISTER THIS DISCOVERY AS A TASK OF A SCHEDULER (REPLACES
+      * CALLING 'loop()' FROM THE PROGRAM MAIN LOOP).
+      * RETURNS THE TASK ID OR MONOCLE_TASK_INVALID
+      */
+     int schedule(MonocleScheduler& scheduler);
+
+     /**
+      * THIS METHOD MUST BE CALLED IN THE PROGRAM MAIN LOOP
+      * TO RECEIVE RESPONSES AND PROBE PERIODICALLY
+      */
+     void loop();
+};
+
+#endif //MONOCLE_DISCOVERY_H
@@ -0,0 +1,225 @@
+/*
+ **********************************************************************
+ *             __  __  ___  _  _  ___   ___ _    ___
+ *            |  \/  |/ _ \| \| |/ _ \ / __| |  | __|
+ *            | |\/| | (_) | .` | (_) | (__| |__| _|
+ *            |_|  |_|\___/|_|\_|\___/ \___|____|___|
+ *
+ * -------------------------------------------------------------------
+ *                       MONOCLE EVENT BUS
+ * -------------------------------------------------------------------
+ *
+ *  This library provides a small fixed capacity event bus used to
+ *  connect the Monocle components (joystick, menu, display and
+ *  gateway client) without per-sketch callback glue.  Events are
+ *  queued in a bounded ring buffer (no dynamic allocation) and
+ *  delivered in order to all subscribers from the 'loop()' method.
+ *
+ *  Author:   Robert Savage
+ *  Date:     2018-02-18
+ *  Website:  http://monoclecam.com
+ *
+ * -------------------------------------------------------------------
+ *        COPYRIGHT SHADEBLUE, LLC @ 2018, ALL RIGHTS RESERVED
+ * -------------------------------------------------------------------
+ *
+ **********************************************************************
+ */
+
+#include "MonocleEventBus.h"
+
+/**
+ * Default Constructor
+ */
+MonocleEventBus::MonocleEventBus(){
+}
+
+/**
+ * REGISTER A SUBSCRIBER FOR AN EVENT TYPE (OR MONOCLE_EVENT_ANY);
+ * SUBSCRIBERS ARE CALLED IN REGISTRATION ORDER.
+ * RETURNS 'false' IF THE SUBSCRIBER TABLE IS FULL
+ */
+bool MonocleEventBus::subscribe(const uint8_t type, MonocleEventHandler handler, void* context){
+  if(handler == NULL) return false;
+  if(type >= MONOCLE_EVENT_TYPES && type != MONOCLE_EVENT_ANY) return false;
+  if(subscriberCount >= MONOCLE_EVENT_MAX_SUBSCRIBERS) return false;
+
+  subscribers[subscriberCount].type = type;
+  subscribers[subscriberCount].handler = handler;
+  subscribers[subscriberCount].context = context;
+  subscriberCount++;
+
+  // track which event types have at least one subscriber
+  subscribedTypes |= (type == MONOCLE_EVENT_ANY) ? 0xFF : (1 << type);
+  return true;
+}
+
+/**
+ * REMOVE ALL REGISTRATIONS OF A SUBSCRIBER (HANDLER AND CONTEXT);
+ * A HANDLER MAY UNSUBSCRIBE (ITSELF OR OTHERS) DURING DISPATCH
+ */
+void MonocleEventBus::unsubscribe(MonocleEventHandler handler, void* context){
+  if(handler == NULL) return;
+  for(uint8_t i = 0; i < subscriberCount; i++){
+    if(subscribers[i].handler == handler && subscribers[i].context == context){
+      subscribers[i].handler = NULL;
+      removed = true;
+    }
+  }
+
+  // the dispatch loop indexes the table; it compacts after the batch
+  if(!dispatching) compact();
+}
+
+/**
+ * DROP THE UNSUBSCRIBED ENTRIES PRESERVING THE REGISTRATION ORDER
+ */
+void MonocleEventBus::compact(){
+  if(!removed) return;
+  removed = false;
+  uint8_t index = 0;
+  subscribedTypes = 0;
+  for(uint8_t i = 0; i < subscriberCount; i++){
+    if(subscribers[i].handler == NULL) continue;
+    subscribers[index] = subscribers[i];
+    subscribedTypes |= (subscribers[index].type == MONOCLE_EVENT_ANY) ? 0xFF : (1 << subscribers[index].type);
+    index++;
+  }
+  subscriberCount = index;
+}
+
+/**
+ * QUEUE AN EVENT FOR DISPATCH; EVENTS WITHOUT ANY SUBSCRIBER
+ * ARE DISCARDED. RETURNS 'false' IF THE QUEUE IS FULL (THE
+ * EVENT IS DROPPED AND THE OVERFLOW COUNTER IS INCREMENTED)
+ */
+bool MonocleEventBus::publish(const MonocleEvent& event){
+  if(event.type >= MONOCLE_EVENT_TYPES) return false;
+
+  // nobody is listening; no need to occupy a queue slot
+  if((subscribedTypes & (1 << event.type)) == 0) return true;
+
+  if(count >= MONOCLE_EVENT_QUEUE_SIZE){
+    overflowCount++;
+    return false;
+  }
+
+  queue[tail] = event;
+  tail = (tail + 1) & (MONOCLE_EVENT_QUEUE_SIZE - 1);
+  count++;
+
+  // wake the dispatch task
+  if(scheduler != NULL) scheduler->trigger(task);
+  return true;
+}
+
+/**
+ * CONVENIENCE PUBLISHERS FOR EACH EVENT TYPE
+ */
+bool MonocleEventBus::publishPTZ(const int pan, const int tilt, const int zoom){
+  MonocleEvent event = { MONOCLE_EVENT_PTZ, 0, (int8_t)pan, (int8_t)tilt, (int8_t)zoom, 0, NULL, NULL };
+  return publish(event);
+}
+bool MonocleEventBus::publishButton(const int button){
+  MonocleEvent event = { MONOCLE_EVENT_BUTTON, 0, 0, 0, 0, (int16_t)button, NULL, NULL };
+  return publish(event);
+}
+bool MonocleEventBus::publishCamera(const CameraSource* camera){
+  MonocleEvent event = { MONOCLE_EVENT_CAMERA, 0, 0, 0, 0, 0, camera, NULL };
+  return publish(event);
+}
+bool MonocleEventBus::publishMenu(const uint8_t action, const int value, const char* uuid){
+  MonocleEvent event = { MONOCLE_EVENT_MENU, action, 0, 0, 0, (int16_t)value, NULL, uuid };
+  return publish(event);
+}
+bool MonocleEventBus::publishLink(const bool connected){
+  MonocleEvent event = { MONOCLE_EVENT_LINK, 0, 0, 0, 0, (int16_t)(connected ? 1 : 0), NULL, NULL };
+  return publish(event);
+}
+
+/**
+ * GET THE NUMBER OF EVENTS WAITING FOR DISPATCH
+ */
+int MonocleEventBus::pending(){
+  return count;
+}
+
+/**
+ * GET THE NUMBER OF EVENTS DROPPED BECAUSE THE QUEUE WAS FULL
+ */
+unsigned long MonocleEventBus::overflows(){
+  return overflowCount;
+}
+
+/**
+ * GET THE NUMBER OF EVENTS DISPATCHED SINCE THE LAST RESET
+ */
+unsigned long MonocleEventBus::dispatched(){
+  return dispatchCount;
+}
+
+/**
+ * RESET THE OVERFLOW AND DISPATCH COUNTERS
+ */
+void MonocleEventBus::resetStatistics(){
+  overflowCount = 0;
+  dispatchCount = 0;
+}
+
+/**
+ * DISCARD ALL QUEUED EVENTS
+ */
+void MonocleEventBus::clear(){
+  head = tail = count = 0;
+}
+
+/**
+ * SCHEDULER TASK ENTRY POINT
+ */
+void MonocleEventBus::internal_event_bus_task(void* context){
+  ((MonocleEventBus*)context)->loop();
+}
+
+/**
+ * REGISTER THIS BUS AS AN EVENT TRIGGERED TASK OF A SCHEDULER;
+ * PUBLISHING AN EVENT TRIGGERS DISPATCH ON THE NEXT SCHEDULER
+ * 'loop()' (REPLACES CALLING 'loop()' FROM THE PROGRAM MAIN LOOP).
+ * RETURNS THE TASK ID OR MONOCLE_TASK_INVALID
+ */
+int MonocleEventBus::schedule(MonocleScheduler& scheduler){
+  task = scheduler.triggered(internal_event_bus_task, this, MONOCLE_EVENT_TASK_BUDGET);
+  if(task == MONOCLE_TASK_INVALID) return task;
+  this->scheduler = &scheduler;
+
+  // events queued before scheduling still need a dispatch
+  if(count > 0) scheduler.trigger(task);
+  return task;
+}
+
+/**
+ * THIS METHOD MUST BE CALLED IN THE PROGRAM MAIN LOOP
+ * TO DISPATCH QUEUED EVENTS; EVENTS PUBLISHED BY SUBSCRIBERS
+ * DURING DISPATCH ARE DELIVERED ON THE NEXT CALL
+ */
+void MonocleEventBus::loop(){
+  // only dispatch the events queued before this call so that a
+  // subscriber re-publishing events cannot starve the main loop
+  uint8_t batch = count;
+  dispatching = true;
+  while(batch-- > 0 && count > 0){
+    // copy the event out of the queue and release the slot before
+    // dispatch so subscribers are free to publish new events
+    MonocleEvent event = queue[head];
+    head = (head + 1) & (MONOCLE_EVENT_QUEUE_SIZE - 1);
+    count--;
+
+    for(uint8_t i = 0; i < subscriberCount; i++){
+      if(subscribers[i].handler == NULL) continue;   // unsubscribed during this batch
+      if(subscribers[i].type == event.type || subscribers[i].type == MONOCLE_EVENT_ANY)
+        subscribers[i].handler(event, subscribers[i].context);
+    }
+    dispatchCount++;
+  }
+  dispatching = false;
+  compact();
+}
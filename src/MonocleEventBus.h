@@ -0,0 +1,208 @@
+/*
+ **********************************************************************
+ *             __  __  ___  _  _  ___   ___ _    ___
+ *            |  \/  |/ _ \| \| |/ _ \ / __| |  | __|
+ *            | |\/| | (_) | .` | (_) | (__| |__| _|
+ *            |_|  |_|\___/|_|\_|\___/ \___|____|___|
+ *
+ * -------------------------------------------------------------------
+ *                       MONOCLE EVENT BUS
+ * -------------------------------------------------------------------
+ *
+ *  This library provides a small fixed capacity event bus used to
+ *  connect the Monocle components (joystick, menu, display and
+ *  gateway client) without per-sketch callback glue.  Events are
+ *  queued in a bounded ring buffer (no dynamic allocation) and
+ *  delivered in order to all subscribers from the 'loop()' method.
+ *
+ *  Author:   Robert Savage
+ *  Date:     2018-02-18
+ *  Website:  http://monoclecam.com
+ *
+ * -------------------------------------------------------------------
+ *        COPYRIGHT SHADEBLUE, LLC @ 2018, ALL RIGHTS RESERVED
+ * -------------------------------------------------------------------
+ *
+ **********************************************************************
+ */
+#ifndef MONOCLE_EVENT_BUS_H
+#define MONOCLE_EVENT_BUS_H
+
+#include <Arduino.h>
+#include "MonocleScheduler.h"
+
+/* MAXIMUM NUMBER OF QUEUED EVENTS (MUST BE A POWER OF TWO) */
+#ifndef MONOCLE_EVENT_QUEUE_SIZE
+#define MONOCLE_EVENT_QUEUE_SIZE 16
+#endif
+
+/* MAXIMUM NUMBER OF REGISTERED SUBSCRIBERS */
+#ifndef MONOCLE_EVENT_MAX_SUBSCRIBERS
+#define MONOCLE_EVENT_MAX_SUBSCRIBERS 16
+#endif
+
+#if (MONOCLE_EVENT_QUEUE_SIZE & (MONOCLE_EVENT_QUEUE_SIZE - 1)) != 0 || MONOCLE_EVENT_QUEUE_SIZE > 128
+#error("MONOCLE_EVENT_QUEUE_SIZE must be a power of two no larger than 128")
+#endif
+
+/* SCHEDULER TASK EXECUTION BUDGET (ONE BATCH OF EVENTS) */
+#ifndef MONOCLE_EVENT_TASK_BUDGET
+#define MONOCLE_EVENT_TASK_BUDGET 5000   // microseconds
+#endif
+
+/* EVENT TYPES */
+#define MONOCLE_EVENT_PTZ     0   // joystick/pad PTZ vector changed
+#define MONOCLE_EVENT_BUTTON  1   // button pressed
+#define MONOCLE_EVENT_CAMERA  2   // active camera source changed
+#define MONOCLE_EVENT_MENU    3   // menu action (MONOCLE_MENU_EVENT_*)
+#define MONOCLE_EVENT_LINK    4   // gateway connection state changed
+#define MONOCLE_EVENT_TYPES   5
+#define MONOCLE_EVENT_ANY     0xFF
+
+/* MENU EVENT FLAGS; ALSO USED AS THE 'action' OF MENU EVENTS */
+#define MONOCLE_MENU_EVENT_NONE       0x00
+#define MONOCLE_MENU_EVENT_ACTIVATE   0x01
+#define MONOCLE_MENU_EVENT_DEACTIVATE 0x02
+#define MONOCLE_MENU_EVENT_HOME       0x04
+#define MONOCLE_MENU_EVENT_ZOOM       0x08
+#define MONOCLE_MENU_EVENT_PRESET     0x10
+#define MONOCLE_MENU_EVENT_MACRO      0x20
+#define MONOCLE_MENU_EVENT_CAMERA     0x40
+
+/* BUTTON EVENT VALUES (GESTURES) */
+#define MONOCLE_BUTTON_PRESS        0
+#define MONOCLE_BUTTON_DOUBLE_CLICK 1
+#define MONOCLE_BUTTON_LONG_PRESS   2
+
+struct CameraSource;
+
+/**
+ * EVENT PAYLOAD; A SMALL FIXED SIZE VALUE COPIED INTO THE QUEUE
+ */
+struct MonocleEvent {
+  uint8_t type;                 // MONOCLE_EVENT_*
+  uint8_t action;               // MENU: MONOCLE_MENU_EVENT_* flag
+  int8_t  pan;                  // PTZ: pan speed/direction
+  int8_t  tilt;                 // PTZ: tilt speed/direction
+  int8_t  zoom;                 // PTZ: zoom speed/direction
+  int16_t value;                // BUTTON: MONOCLE_BUTTON_*; MENU: preset or macro; LINK: 1=connected
+  const CameraSource* camera;   // CAMERA: active camera source (owned by the client)
+  const char* uuid;             // MENU CAMERA: selected camera uuid (owned by the menu until the next selection)
+};
+
+/* SUBSCRIBER CALLBACK; THE CONTEXT POINTER IS PASSED BACK AS REGISTERED */
+typedef void (*MonocleEventHandler)(const MonocleEvent& event, void* context);
+
+class MonocleEventBus
+{
+   private:
+     struct Subscriber {
+       uint8_t type;
+       MonocleEventHandler handler;
+       void* context;
+     };
+
+     /* SUBSCRIBER TABLE */
+     Subscriber subscribers[MONOCLE_EVENT_MAX_SUBSCRIBERS];
+     uint8_t subscriberCount = 0;
+     uint8_t subscribedTypes = 0;   // bitmask of event types with subscribers
+     bool dispatching = false;      // removals are deferred until the batch is done
+     bool removed = false;          // unsubscribed entries (NULL handler) to compact
+
+     /* EVENT RING QUEUE */
+     MonocleEvent queue[MONOCLE_EVENT_QUEUE_SIZE];
+     uint8_t head = 0;    // next event to dispatch
+     uint8_t tail = 0;    // next free slot
+     uint8_t count = 0;
+
+     /* STATISTICS */
+     unsigned long overflowCount = 0;
+     unsigned long dispatchCount = 0;
+
+     /* OPTIONAL SCHEDULER (DISPATCH IS TRIGGERED BY PUBLISHING) */
+     MonocleScheduler* scheduler = NULL;
+     int task = MONOCLE_TASK_INVALID;
+
+     /* INTERNAL PROCESSING */
+     void compact();
+
+     /* SCHEDULER TASK ENTRY POINT */
+     static void internal_event_bus_task(void* context);
+
+   public:
+    /**
+     * Default Constructor
+     */
+     MonocleEventBus();
+
+     /**
+      * REGISTER A SUBSCRIBER FOR AN EVENT TYPE (OR MONOCLE_EVENT_ANY);
+      * SUBSCRIBERS ARE CALLED IN REGISTRATION ORDER.
+      * RETURNS 'false' IF THE SUBSCRIBER TABLE IS FULL
+      */
+     bool subscribe(const uint8_t type, MonocleEventHandler handler, void* context = NULL);
+
+     /**
+      * REMOVE ALL REGISTRATIONS OF A SUBSCRIBER (HANDLER AND CONTEXT);
+      * A HANDLER MAY UNSUBSCRIBE (ITSELF OR OTHERS) DURING DISPATCH
+      */
+     void unsubscribe(MonocleEventHandler handler, void* context = NULL);
+
+     /**
+      * QUEUE AN EVENT FOR DISPATCH; EVENTS WITHOUT ANY SUBSCRIBER
+      * ARE DISCARDED. RETURNS 'false' IF THE QUEUE IS FULL (THE
+      * EVENT IS DROPPED AND THE OVERFLOW COUNTER IS INCREMENTED)
+      */
+     bool publish(const MonocleEvent& event);
+
+     /**
+      * CONVENIENCE PUBLISHERS FOR EACH EVENT TYPE
+      */
+     bool publishPTZ(const int pan, const int tilt, const int zoom);
+     bool publishButton(const int button = MONOCLE_BUTTON_PRESS);
+     bool publishCamera(const CameraSource* camera);
+     bool publishMenu(const uint8_t action, const int value = 0, const char* uuid = NULL);
+     bool publishLink(const bool connected);
+
+     /**
+      * GET THE NUMBER OF EVENTS WAITING FOR DISPATCH
+      */
+     int pending();
+
+     /**
+      * GET THE NUMBER OF EVENTS DROPPED BECAUSE THE QUEUE WAS FULL
+      */
+     unsigned long overflows();
+
+     /**
+      * GET THE NUMBER OF EVENTS DISPATCHED SINCE THE LAST RESET
+      */
+     unsigned long dispatched();
+
+     /**
+      * RESET THE OVERFLOW AND DISPATCH COUNTERS
+      */
+     void resetStatistics();
+
+     /**
+      * DISCARD ALL QUEUED EVENTS
+      */
+     void clear();
+
+     /**
+      * REGISTER THIS BUS AS AN EVENT TRIGGERED TASK OF A SCHEDULER;
+      * PUBLISHING AN EVENT TRIGGERS DISPATCH ON THE NEXT SCHEDULER
+      * 'loop()' (REPLACES CALLING 'loop()' FROM THE PROGRAM MAIN LOOP).
+      * RETURNS THE TASK ID OR MONOCLE_TASK_INVALID
+      */
+     int schedule(MonocleScheduler& scheduler);
+
+     /**
+      * THIS METHOD MUST BE CALLED IN THE PROGRAM MAIN LOOP
+      * TO DISPATCH QUEUED EVENTS; EVENTS PUBLISHED BY SUBSCRIBERS
+      * DURING DISPATCH ARE DELIVERED ON THE NEXT CALL
+      */
+     void loop();
+};
+
+#endif //MONOCLE_EVENT_BUS_H
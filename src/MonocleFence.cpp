@@ -0,0 +1,332 @@
+/*
+ **********************************************************************
+ *             __  __  ___  _  _  ___   ___ _    ___
+ *            |  \/  |/ _ \| \| |/ _ \ / __| |  | __|
+ *            | |\/| | (_) | .` | (_) | (__| |__| _|
+ *            |_|  |_|\___/|_|\_|\___/ \___|____|___|
+ *
+ * -------------------------------------------------------------------
+ *                     MONOCLE PTZ FENCE
+ * -------------------------------------------------------------------
+ *
+ *  This library enforces soft limits and virtual fences on the
+ *  controller before PTZ commands are sent to the Monocle Gateway.
+ *  Up to MONOCLE_FENCE_MAX_ZONES pan/tilt/zoom boxes are configured:
+ *
+ *    LIMIT   : the camera must stay inside the box (soft limits,
+ *              e.g. a maximum usable zoom)
+ *    EXCLUDE : the camera must stay out of the box (privacy zones)
+ *
+ *  Each outbound PTZ vector is evaluated against the last known
+ *  position (the gateway status mirror, extrapolated by the last
+ *  allowed speeds) and the distance the commanded speeds cover in
+ *  the look-ahead time.  An axis that would leave a LIMIT box or
+ *  enter an EXCLUDE box is slowed to the fastest speed that stays
+ *  clear, or stopped; every blocked command is counted.  The cost
+ *  is bounded by the (fixed) number of zones.
+ *
+ *  Only commands for the active camera are fenced; the fence also
+ *  re-checks a held movement in 'loop()' as new positions arrive.
+ *
+ *
+ *  Author:   Robert Savage
+ *  Date:     2018-02-18
+ *  Website:  http://monoclecam.com
+ *
+ * -------------------------------------------------------------------
+ *        COPYRIGHT SHADEBLUE, LLC @ 2018, ALL RIGHTS RESERVED
+ * -------------------------------------------------------------------
+ *
+ **********************************************************************
+ */
+
+#include "Arduino.h"
+#include "MonocleFence.h"
+
+/**
+ * Default Constructor
+ */
+MonocleFence::MonocleFence(MonocleGatewayClient& gateway) : gateway(gateway) {
+  memset(zones, 0, sizeof(zones));
+  memset(levels, 0, sizeof(levels));
+  setRates(MONOCLE_AXIS_PAN, MONOCLE_MOTION_DEFAULT_PAN_RATES);
+  setRates(MONOCLE_AXIS_TILT, MONOCLE_MOTION_DEFAULT_TILT_RATES);
+  setRates(MONOCLE_AXIS_ZOOM, MONOCLE_MOTION_DEFAULT_ZOOM_RATES);
+}
+
+/**
+ * ATTACH THIS FENCE TO THE GATEWAY CLIENT (ALL ACTIVE CAMERA PTZ,
+ * PAN, TILT AND ZOOM COMMANDS ARE FILTERED FROM THEN ON)
+ */
+void MonocleFence::begin(){
+  gateway.fenceWith(this);
+}
+
+/**
+ * ADD A ZONE (SHARED BY 'addLimit()' AND 'addExclusion()')
+ */
+int MonocleFence::addZone(uint8_t type, float minPan, float maxPan, float minTilt, float maxTilt, float minZoom, float maxZoom){
+  if(zoneCount >= MONOCLE_FENCE_MAX_ZONES) return MONOCLE_FENCE_INVALID;
+  MonocleFenceZone& zone = zones[zoneCount];
+  zone.type = type;
+  zone.enabled = true;
+  zone.minimum[MONOCLE_AXIS_PAN] = min(minPan, maxPan);
+  zone.maximum[MONOCLE_AXIS_PAN] = max(minPan, maxPan);
+  zone.minimum[MONOCLE_AXIS_TILT] = min(minTilt, maxTilt);
+  zone.maximum[MONOCLE_AXIS_TILT] = max(minTilt, maxTilt);
+  zone.minimum[MONOCLE_AXIS_ZOOM] = min(minZoom, maxZoom);
+  zone.maximum[MONOCLE_AXIS_ZOOM] = max(minZoom, maxZoom);
+  zone.violations = 0;
+  return zoneCount++;
+}
+
+/**
+ * ADD A ZONE THE CAMERA MUST STAY INSIDE (SOFT LIMITS; USE
+ * MONOCLE_FENCE_UNBOUNDED FOR AN UNLIMITED AXIS).
+ * RETURNS THE ZONE INDEX OR MONOCLE_FENCE_INVALID
+ */
+int MonocleFence::addLimit(float minPan, float maxPan, float minTilt, float maxTilt, float minZoom, float maxZoom){
+  return addZone(MONOCLE_FENCE_LIMIT, minPan, maxPan, minTilt, maxTilt, minZoom, maxZoom);
+}
+
+/**
+ * ADD A ZONE THE CAMERA MUST STAY OUT OF (PRIVACY ZONE; BY DEFAULT
+ * AT ANY ZOOM). RETURNS THE ZONE INDEX OR MONOCLE_FENCE_INVALID
+ */
+int MonocleFence::addExclusion(float minPan, float maxPan, float minTilt, float maxTilt, float minZoom, float maxZoom){
+  return addZone(MONOCLE_FENCE_EXCLUDE, minPan, maxPan, minTilt, maxTilt, minZoom, maxZoom);
+}
+
+/**
+ * ENABLE OR DISABLE A ZONE
+ */
+void MonocleFence::enable(const int zone, bool enabled){
+  if(zone < 0 || zone >= zoneCount) return;
+  zones[zone].enabled = enabled;
+}
+
+/**
+ * REMOVE ALL ZONES
+ */
+void MonocleFence::clear(){
+  zoneCount = 0;
+}
+
+/**
+ * DEFINE THE RATE (UNITS PER SECOND) OF THE SLOW, MEDIUM AND FAST
+ * SPEEDS OF AN AXIS (MONOCLE_AXIS_*); USE THE MOTION PLANNER RATES
+ */
+void MonocleFence::setRates(const uint8_t axis, float slow, float med, float fast){
+  if(axis >= MONOCLE_AXES) return;
+  rates[axis][0] = 0;
+  rates[axis][1] = slow;
+  rates[axis][2] = med;
+  rates[axis][3] = fast;
+}
+
+/**
+ * DEFINE THE TIME (MILLISECONDS) A COMMANDED SPEED IS ASSUMED TO BE HELD
+ */
+void MonocleFence::setLookahead(unsigned int milliseconds){
+  lookahead = milliseconds;
+}
+
+/**
+ * BLOCK ALL MOVEMENT WHILE NO CAMERA STATUS HAS BEEN RECEIVED
+ * (BY DEFAULT COMMANDS PASS UNFENCED UNTIL THE POSITION IS KNOWN)
+ */
+void MonocleFence::setFailSafe(bool enabled){
+  failSafe = enabled;
+}
+
+/**
+ * SIGNED DISTANCE AN AXIS TRAVELS AT A SPEED LEVEL IN ONE SECOND
+ */
+float MonocleFence::travel(const uint8_t axis, const int level){
+  return (level < 0) ? -rates[axis][-level] : rates[axis][level];
+}
+
+/**
+ * ESTIMATE THE CURRENT POSITION FROM THE LAST CAMERA STATUS MOVED ON
+ * BY THE LAST ALLOWED SPEEDS. RETURNS 'false' IF THE POSITION IS UNKNOWN
+ */
+bool MonocleFence::estimate(float* position){
+  const MonocleCameraStatus& status = gateway.status();
+  if(status.updated == 0) return false;
+
+  unsigned long age = millis() - status.updated;
+  if(age > MONOCLE_FENCE_MAX_EXTRAPOLATION) age = MONOCLE_FENCE_MAX_EXTRAPOLATION;
+  position[MONOCLE_AXIS_PAN] = status.pan + travel(MONOCLE_AXIS_PAN, levels[MONOCLE_AXIS_PAN]) * age / 1000.0;
+  position[MONOCLE_AXIS_TILT] = status.tilt + travel(MONOCLE_AXIS_TILT, levels[MONOCLE_AXIS_TILT]) * age / 1000.0;
+  position[MONOCLE_AXIS_ZOOM] = status.zoom + travel(MONOCLE_AXIS_ZOOM, levels[MONOCLE_AXIS_ZOOM]) * age / 1000.0;
+  return true;
+}
+
+/**
+ * ENFORCE ONE ZONE ON A PTZ VECTOR; EACH OFFENDING AXIS IS SLOWED ONE
+ * LEVEL AT A TIME UNTIL IT STAYS CLEAR WITHIN THE LOOK-AHEAD TIME.
+ * RETURNS A BIT MASK OF THE CHANGED AXES
+ */
+uint8_t MonocleFence::enforce(MonocleFenceZone& zone, const float* position, int* level){
+  float seconds = lookahead / 1000.0;
+  uint8_t changed = 0;
+
+  if(zone.type == MONOCLE_FENCE_LIMIT){
+    // an axis may always move back towards the inside of the box
+    for(int axis = 0; axis < MONOCLE_AXES; axis++){
+      int speed = level[axis];
+      while(speed != 0){
+        float target = position[axis] + travel(axis, speed) * seconds;
+        if(speed > 0 ? target <= zone.maximum[axis] : target >= zone.minimum[axis]) break;
+        speed += (speed > 0) ? -1 : 1;
+      }
+      if(speed != level[axis]){
+        level[axis] = speed;
+        changed |= (1 << axis);
+      }
+    }
+    return changed;
+  }
+
+  // a camera already inside an exclusion box may move out in any direction
+  bool inside = true;
+  for(int axis = 0; axis < MONOCLE_AXES; axis++){
+    if(position[axis] < zone.minimum[axis] || position[axis] > zone.maximum[axis]) inside = false;
+  }
+  if(inside) return 0;
+
+  // the move enters the box only if its path overlaps the box on every axis
+  for(int axis = 0; axis < MONOCLE_AXES; axis++){
+    float target = position[axis] + travel(axis, level[axis]) * seconds;
+    if(max(position[axis], target) < zone.minimum[axis] || min(position[axis], target) > zone.maximum[axis]) return 0;
+  }
+
+  // slow each axis approaching the box from outside until it stops short
+  for(int axis = 0; axis < MONOCLE_AXES; axis++){
+    if(position[axis] >= zone.minimum[axis] && position[axis] <= zone.maximum[axis]) continue;
+    int speed = level[axis];
+    while(speed != 0){
+      float target = position[axis] + travel(axis, speed) * seconds;
+      if(target < zone.minimum[axis] || target > zone.maximum[axis]) break;
+      speed += (speed > 0) ? -1 : 1;
+    }
+    if(speed != level[axis]){
+      level[axis] = speed;
+      changed |= (1 << axis);
+    }
+  }
+  return changed;
+}
+
+/**
+ * EVALUATE A PTZ VECTOR AGAINST ALL ENABLED ZONES (OPTIONALLY COUNTING
+ * THE VIOLATIONS). RETURNS A BIT MASK OF THE CHANGED AXES
+ */
+uint8_t MonocleFence::evaluate(int* level, bool count){
+  uint8_t changed = 0;
+  float position[MONOCLE_AXES];
+
+  if(!estimate(position)){
+    if(!failSafe || zoneCount == 0) return 0;
+    for(int axis = 0; axis < MONOCLE_AXES; axis++){
+      if(level[axis] != 0) changed |= (1 << axis);
+      level[axis] = 0;
+    }
+  }
+  else {
+    for(int index = 0; index < zoneCount; index++){
+      if(!zones[index].enabled) continue;
+      uint8_t zoneChanged = enforce(zones[index], position, level);
+      if(zoneChanged && count) zones[index].violations++;
+      changed |= zoneChanged;
+    }
+  }
+
+  if(changed && count) violationCount++;
+  return changed;
+}
+
+/**
+ * FILTER A PTZ VECTOR (SPEED LEVELS -3..3); OFFENDING AXES ARE
+ * SLOWED OR STOPPED. RETURNS 'true' IF THE VECTOR WAS CHANGED
+ */
+bool MonocleFence::filter(int& pan, int& tilt, int& zoom){
+  int level[MONOCLE_AXES] = { constrain(pan, -3, 3), constrain(tilt, -3, 3), constrain(zoom, -3, 3) };
+  bool changed = evaluate(level, true) != 0;
+
+  pan = level[MONOCLE_AXIS_PAN];
+  tilt = level[MONOCLE_AXIS_TILT];
+  zoom = level[MONOCLE_AXIS_ZOOM];
+  for(int axis = 0; axis < MONOCLE_AXES; axis++)
+    levels[axis] = level[axis];
+  return changed;
+}
+
+/**
+ * NOTE THAT ALL MOVEMENT OF THE ACTIVE CAMERA WAS STOPPED
+ */
+void MonocleFence::stopped(){
+  memset(levels, 0, sizeof(levels));
+}
+
+/**
+ * GET THE LAST ALLOWED SPEED LEVEL OF AN AXIS (MONOCLE_AXIS_*)
+ */
+int MonocleFence::level(const uint8_t axis){
+  if(axis >= MONOCLE_AXES) return 0;
+  return levels[axis];
+}
+
+/**
+ * GET THE NUMBER OF FENCED COMMANDS (ALL ZONES OR ONE ZONE)
+ */
+unsigned long MonocleFence::violations(){
+  return violationCount;
+}
+unsigned long MonocleFence::violations(const int zone){
+  if(zone < 0 || zone >= zoneCount) return 0;
+  return zones[zone].violations;
+}
+
+/**
+ * RESET THE VIOLATION COUNTERS
+ */
+void MonocleFence::resetViolations(){
+  violationCount = 0;
+  for(int index = 0; index < MONOCLE_FENCE_MAX_ZONES; index++)
+    zones[index].violations = 0;
+}
+
+/**
+ * SCHEDULER TASK ENTRY POINT
+ */
+void MonocleFence::internal_fence_task(void* context){
+  ((MonocleFence*)context)->loop();
+}
+
+/**
+ * REGISTER THIS FENCE AS A TASK OF A SCHEDULER (REPLACES
+ * CALLING 'loop()' FROM THE PROGRAM MAIN LOOP).
+ * RETURNS THE TASK ID OR MONOCLE_TASK_INVALID
+ */
+int MonocleFence::schedule(MonocleScheduler& scheduler){
+  return scheduler.every(MONOCLE_FENCE_TASK_INTERVAL, internal_fence_task, this, MONOCLE_FENCE_TASK_BUDGET);
+}
+
+/**
+ * THIS METHOD MUST BE CALLED IN THE PROGRAM MAIN LOOP
+ * TO RE-CHECK A HELD MOVEMENT AGAINST NEW POSITIONS
+ */
+void MonocleFence::loop(){
+  unsigned long now = millis();
+  if(now - checkTime < MONOCLE_FENCE_CHECK_INTERVAL) return;
+  checkTime = now;
+
+  if(levels[MONOCLE_AXIS_PAN] == 0 && levels[MONOCLE_AXIS_TILT] == 0 && levels[MONOCLE_AXIS_ZOOM] == 0) return;
+  if(!gateway.connected()) return;
+
+  // the held movement now runs into a zone; resend it through the fence
+  int level[MONOCLE_AXES] = { levels[MONOCLE_AXIS_PAN], levels[MONOCLE_AXIS_TILT], levels[MONOCLE_AXIS_ZOOM] };
+  if(evaluate(level, false) == 0) return;
+  gateway.ptz(levels[MONOCLE_AXIS_PAN], levels[MONOCLE_AXIS_TILT], levels[MONOCLE_AXIS_ZOOM]);
+}
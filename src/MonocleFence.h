@@ -0,0 +1,219 @@
+/*
+ **********************************************************************
+ *             __  __  ___  _  _  ___   ___ _    ___
+ *            |  \/  |/ _ \| \| |/ _ \ / __| |  | __|
+ *            | |\/| | (_) | .` | (_) | (__| |__| _|
+ *            |_|  |_|\___/|_|\_|\___/ \___|____|___|
+ *
+ * -------------------------------------------------------------------
+ *                     MONOCLE PTZ FENCE
+ * -------------------------------------------------------------------
+ *
+ *  This library enforces soft limits and virtual fences on the
+ *  controller before PTZ commands are sent to the Monocle Gateway.
+ *  Up to MONOCLE_FENCE_MAX_ZONES pan/tilt/zoom boxes are configured:
+ *
+ *    LIMIT   : the camera must stay inside the box (soft limits,
+ *              e.g. a maximum usable zoom)
+ *    EXCLUDE : the camera must stay out of the box (privacy zones)
+ *
+ *  Each outbound PTZ vector is evaluated against the last known
+ *  position (the gateway status mirror, extrapolated by the last
+ *  allowed speeds) and the distance the commanded speeds cover in
+ *  the look-ahead time.  An axis that would leave a LIMIT box or
+ *  enter an EXCLUDE box is slowed to the fastest speed that stays
+ *  clear, or stopped; every blocked command is counted.  The cost
+ *  is bounded by the (fixed) number of zones.
+ *
+ *  Only commands for the active camera are fenced; the fence also
+ *  re-checks a held movement in 'loop()' as new positions arrive.
+ *
+ *
+ *  Author:   Robert Savage
+ *  Date:     2018-02-18
+ *  Website:  http://monoclecam.com
+ *
+ * -------------------------------------------------------------------
+ *        COPYRIGHT SHADEBLUE, LLC @ 2018, ALL RIGHTS RESERVED
+ * -------------------------------------------------------------------
+ *
+ **********************************************************************
+ */
+#ifndef MONOCLE_FENCE_H
+#define MONOCLE_FENCE_H
+
+#include <Arduino.h>
+#include "MonocleGatewayClient.h"
+#include "MonocleMotionPlanner.h"
+#include "MonocleScheduler.h"
+
+/* MAXIMUM NUMBER OF CONFIGURED ZONES */
+#ifndef MONOCLE_FENCE_MAX_ZONES
+#define MONOCLE_FENCE_MAX_ZONES 4
+#endif
+
+/* TIME (MILLISECONDS) A COMMANDED SPEED IS ASSUMED TO BE HELD (STATUS INTERVAL PLUS LATENCY) */
+#ifndef MONOCLE_FENCE_LOOKAHEAD
+#define MONOCLE_FENCE_LOOKAHEAD 300
+#endif
+
+/* MAXIMUM TIME (MILLISECONDS) THE LAST STATUS IS EXTRAPOLATED BY THE ALLOWED SPEEDS */
+#ifndef MONOCLE_FENCE_MAX_EXTRAPOLATION
+#define MONOCLE_FENCE_MAX_EXTRAPOLATION 1000
+#endif
+
+/* INTERVAL (MILLISECONDS) BETWEEN RE-CHECKS OF A HELD MOVEMENT */
+#ifndef MONOCLE_FENCE_CHECK_INTERVAL
+#define MONOCLE_FENCE_CHECK_INTERVAL 50
+#endif
+
+/* SCHEDULER TASK INTERVAL AND EXECUTION BUDGET */
+#ifndef MONOCLE_FENCE_TASK_INTERVAL
+#define MONOCLE_FENCE_TASK_INTERVAL 20       // milliseconds
+#endif
+#ifndef MONOCLE_FENCE_TASK_BUDGET
+#define MONOCLE_FENCE_TASK_BUDGET   1000     // microseconds
+#endif
+
+/* ZONE TYPES */
+#define MONOCLE_FENCE_LIMIT     0   // keep the camera inside the box
+#define MONOCLE_FENCE_EXCLUDE   1   // keep the camera out of the box
+
+/* AN AXIS RANGE WITHOUT A BOUND */
+#define MONOCLE_FENCE_UNBOUNDED 1.0e9
+
+/* INVALID ZONE INDEX */
+#define MONOCLE_FENCE_INVALID   -1
+
+/**
+ * A FENCE ZONE (PAN/TILT/ZOOM BOX, INDEXED BY MONOCLE_AXIS_*)
+ */
+struct MonocleFenceZone {
+  uint8_t type;
+  bool enabled;
+  float minimum[MONOCLE_AXES];
+  float maximum[MONOCLE_AXES];
+  unsigned long violations;
+};
+
+class MonocleFence
+{
+   private:
+     MonocleGatewayClient& gateway;
+     MonocleFenceZone zones[MONOCLE_FENCE_MAX_ZONES];
+     uint8_t zoneCount = 0;
+     float rates[MONOCLE_AXES][4];                // units per second of each speed level
+     unsigned int lookahead = MONOCLE_FENCE_LOOKAHEAD;
+     bool failSafe = false;                       // block movement while the position is unknown
+
+     /* LAST ALLOWED SPEED LEVELS (ACTIVE CAMERA) */
+     int8_t levels[MONOCLE_AXES];
+     unsigned long checkTime = 0;
+     unsigned long violationCount = 0;
+
+     /* INTERNAL PROCESSING */
+     bool estimate(float* position);
+     float travel(const uint8_t axis, const int level);
+     uint8_t enforce(MonocleFenceZone& zone, const float* position, int* level);
+     uint8_t evaluate(int* level, bool count);
+     int addZone(uint8_t type, float minPan, float maxPan, float minTilt, float maxTilt, float minZoom, float maxZoom);
+
+     /* SCHEDULER TASK ENTRY POINT */
+     static void internal_fence_task(void* context);
+
+   public:
+    /**
+     * Default Constructor
+     */
+     MonocleFence(MonocleGatewayClient& gateway);
+
+     /**
+      * ATTACH THIS FENCE TO THE GATEWAY CLIENT (ALL ACTIVE CAMERA PTZ,
+      * PAN, TILT AND ZOOM COMMANDS ARE FILTERED FROM THEN ON)
+      */
+     void begin();
+
+     /**
+      * ADD A ZONE THE CAMERA MUST STAY INSIDE (SOFT LIMITS; USE
+      * MONOCLE_FENCE_UNBOUNDED FOR AN UNLIMITED AXIS).
+      * RETURNS THE ZONE INDEX OR MONOCLE_FENCE_INVALID
+      */
+     int addLimit(float minPan, float maxPan, float minTilt, float maxTilt,
+                  float minZoom = -MONOCLE_FENCE_UNBOUNDED, float maxZoom = MONOCLE_FENCE_UNBOUNDED);
+
+     /**
+      * ADD A ZONE THE CAMERA MUST STAY OUT OF (PRIVACY ZONE; BY DEFAULT
+      * AT ANY ZOOM). RETURNS THE ZONE INDEX OR MONOCLE_FENCE_INVALID
+      */
+     int addExclusion(float minPan, float maxPan, float minTilt, float maxTilt,
+                      float minZoom = -MONOCLE_FENCE_UNBOUNDED, float maxZoom = MONOCLE_FENCE_UNBOUNDED);
+
+     /**
+      * ENABLE OR DISABLE A ZONE
+      */
+     void enable(const int zone, bool enabled);
+
+     /**
+      * REMOVE ALL ZONES
+      */
+     void clear();
+
+     /**
+      * DEFINE THE RATE (UNITS PER SECOND) OF THE SLOW, MEDIUM AND FAST
+      * SPEEDS OF AN AXIS (MONOCLE_AXIS_*); USE THE MOTION PLANNER RATES
+      */
+     void setRates(const uint8_t axis, float slow, float med, float fast);
+
+     /**
+      * DEFINE THE TIME (MILLISECONDS) A COMMANDED SPEED IS ASSUMED TO BE HELD
+      */
+     void setLookahead(unsigned int milliseconds);
+
+     /**
+      * BLOCK ALL MOVEMENT WHILE NO CAMERA STATUS HAS BEEN RECEIVED
+      * (BY DEFAULT COMMANDS PASS UNFENCED UNTIL THE POSITION IS KNOWN)
+      */
+     void setFailSafe(bool enabled);
+
+     /**
+      * FILTER A PTZ VECTOR (SPEED LEVELS -3..3); OFFENDING AXES ARE
+      * SLOWED OR STOPPED. RETURNS 'true' IF THE VECTOR WAS CHANGED
+      */
+     bool filter(int& pan, int& tilt, int& zoom);
+
+     /**
+      * NOTE THAT ALL MOVEMENT OF THE ACTIVE CAMERA WAS STOPPED
+      */
+     void stopped();
+
+     /**
+      * GET THE LAST ALLOWED SPEED LEVEL OF AN AXIS (MONOCLE_AXIS_*)
+      */
+     int level(const uint8_t axis);
+
+     /**
+      * GET THE NUMBER OF FENCED COMMANDS (ALL ZONES OR ONE ZONE)
+      */
+     unsigned long violations();
+     unsigned long violations(const int zone);
+
+     /**
+      * RESET THE VIOLATION COUNTERS
+      */
+     void resetViolations();
+
+     /**
+      * REGISTER THIS FENCE AS A TASK OF A SCHEDULER (REPLACES
+      * CALLING 'loop()' FROM THE PROGRAM MAIN LOOP).
+      * RETURNS THE TASK ID OR MONOCLE_TASK_INVALID
+      */
+     int schedule(MonocleScheduler& scheduler);
+
+     /**
+      * THIS METHOD MUST BE CALLED IN THE PROGRAM MAIN LOOP
+      * TO RE-CHECK A HELD MOVEMENT AGAINST NEW POSITIONS
+      */
+     void loop();
+};
+
+#endif //MONOCLE_FENCE_H
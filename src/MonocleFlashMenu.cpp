@@ -0,0 +1,395 @@
+/*
+ **********************************************************************
+ *             __  __  ___  _  _  ___   ___ _    ___
+ *            |  \/  |/ _ \| \| |/ _ \ / __| |  | __|
+ *            | |\/| | (_) | .` | (_) | (__| |__| _|
+ *            |_|  |_|\___/|_|\_|\___/ \___|____|___|
+ *
+ * -------------------------------------------------------------------
+ *                     MONOCLE FLASH MENU
+ * -------------------------------------------------------------------
+ *
+ *  This library provides a menu implementation whose menu tree is
+ *  declared at compile time as a constant node table placed in
+ *  flash (PROGMEM).  Navigation works by index arithmetic over the
+ *  table, so no menu component objects, name strings or heap
+ *  allocations are held in RAM.
+ *
+ *  Author:   Robert Savage
+ *  Date:     2018-02-18
+ *  Website:  http://monoclecam.com
+ *
+ * -------------------------------------------------------------------
+ *        COPYRIGHT SHADEBLUE, LLC @ 2018, ALL RIGHTS RESERVED
+ * -------------------------------------------------------------------
+ *
+ **********************************************************************
+ */
+
+#include <Arduino.h>
+#include <stddef.h>
+#include "MonocleFlashMenu.h"
+
+// the runtime menu is only included for the memory report
+#include "MonocleMenu.h"
+
+/**
+ * THE DEFAULT MENU TREE; THE SAME ITEMS 'MonocleMenu' BUILDS AT RUNTIME
+ * BEFORE THE GATEWAY PROVIDES A PRESET LIST
+ */
+constexpr MonocleMenuNode MONOCLE_DEFAULT_MENU[] PROGMEM = {
+  MONOCLE_MENU_ROOT(1, 3),                                        // 0
+  MONOCLE_MENU_ITEM("[EXIT]", MONOCLE_MENU_EVENT_NONE, 0),        // 1
+  MONOCLE_MENU_ITEM("Recall Home", MONOCLE_MENU_EVENT_HOME, 0),   // 2
+  MONOCLE_MENU_SUBMENU("Recall Preset", 4, 10),                   // 3
+  MONOCLE_MENU_BACK("[BACK]"),                                    // 4
+  MONOCLE_MENU_ITEM("Preset 1", MONOCLE_MENU_EVENT_PRESET, 1),    // 5
+  MONOCLE_MENU_ITEM("Preset 2", MONOCLE_MENU_EVENT_PRESET, 2),
+  MONOCLE_MENU_ITEM("Preset 3", MONOCLE_MENU_EVENT_PRESET, 3),
+  MONOCLE_MENU_ITEM("Preset 4", MONOCLE_MENU_EVENT_PRESET, 4),
+  MONOCLE_MENU_ITEM("Preset 5", MONOCLE_MENU_EVENT_PRESET, 5),
+  MONOCLE_MENU_ITEM("Preset 6", MONOCLE_MENU_EVENT_PRESET, 6),
+  MONOCLE_MENU_ITEM("Preset 7", MONOCLE_MENU_EVENT_PRESET, 7),
+  MONOCLE_MENU_ITEM("Preset 8", MONOCLE_MENU_EVENT_PRESET, 8),
+  MONOCLE_MENU_ITEM("Preset 9", MONOCLE_MENU_EVENT_PRESET, 9)     // 13
+};
+MONOCLE_MENU_ASSERT(MONOCLE_DEFAULT_MENU);
+const uint8_t MONOCLE_DEFAULT_MENU_SIZE = sizeof(MONOCLE_DEFAULT_MENU) / sizeof(MONOCLE_DEFAULT_MENU[0]);
+
+/**
+ * Default Constructor
+ */
+MonocleFlashMenu::MonocleFlashMenu(const MonocleMenuNode* nodes, uint8_t size, MonocleFlashMenuRenderer const& renderer) :
+    renderer(renderer)
+{
+  this->nodes = nodes;
+  this->size = size;
+
+  // initialize callbacks
+  this->activateCallback = NULL;
+  this->deactivateCallback = NULL;
+  this->homeCallback = NULL;
+  this->zoomCallback = NULL;
+  this->presetCallback = NULL;
+  this->macroCallback = NULL;
+
+  open(0, 0);
+}
+
+/**
+ * READ ONE BYTE OF A NODE FROM FLASH
+ */
+uint8_t MonocleFlashMenu::nodeByte(uint8_t index, size_t offset) const {
+  return pgm_read_byte((const uint8_t*)&nodes[index] + offset);
+}
+
+/**
+ * DISPLAY A (SUB)MENU WITH THE CURSOR ON ONE OF ITS ITEMS
+ */
+void MonocleFlashMenu::open(uint8_t menu, uint8_t current){
+  this->menu = menu;
+  this->first = nodeByte(menu, offsetof(MonocleMenuNode, first));
+  this->count = nodeByte(menu, offsetof(MonocleMenuNode, count));
+  this->current = current;
+}
+
+/**
+ * FORCE A REFRESH OF THE MENU
+ */
+void MonocleFlashMenu::refresh() {
+  renderer.render(*this);
+}
+
+/**
+ * SCHEDULER TASK ENTRY POINT
+ */
+void MonocleFlashMenu::internal_menu_task(void* context){
+  ((MonocleFlashMenu*)context)->loop();
+}
+
+/**
+ * REGISTER THIS MENU AS A TASK OF A SCHEDULER (REPLACES
+ * CALLING 'loop()' FROM THE PROGRAM MAIN LOOP).
+ * RETURNS THE TASK ID OR MONOCLE_TASK_INVALID
+ */
+int MonocleFlashMenu::schedule(MonocleScheduler& scheduler){
+  return scheduler.every(MONOCLE_FLASH_MENU_TASK_INTERVAL, internal_menu_task, this, MONOCLE_FLASH_MENU_TASK_BUDGET);
+}
+
+/**
+ * THIS FUNTION MUST BE CALLED IN THE PROGRAM
+ * MAIN LOOP TO SERVICE THE MENU SYSTEM AND EVENTS
+ */
+void MonocleFlashMenu::loop() {
+  // if the menu is active and we have reached out update timer, then refresh the display on the menu
+  if(active && updateTimer > 0 && millis() - updateTimer > MONOCLE_FLASH_MENU_DISPLAY_INTERVAL) {
+    renderer.render(*this);
+    updateTimer = 0;
+  }
+
+  // nothing more to do unless a menu event is pending
+  if(pendingEvents == MONOCLE_MENU_EVENT_NONE) return;
+
+  // take a snapshot of the pending events; any events raised
+  // from within the user callbacks are processed on the next loop
+  uint8_t events = pendingEvents;
+  int preset = pendingPreset;
+  int macro = pendingMacro;
+  pendingEvents = MONOCLE_MENU_EVENT_NONE;
+  pendingPreset = 0;
+  pendingMacro = 0;
+
+  if((events & MONOCLE_MENU_EVENT_ACTIVATE) && activateCallback != NULL)
+    activateCallback();
+  if((events & MONOCLE_MENU_EVENT_HOME) && homeCallback != NULL)
+    homeCallback();
+  if((events & MONOCLE_MENU_EVENT_PRESET) && presetCallback != NULL)
+    presetCallback(preset);
+  if((events & MONOCLE_MENU_EVENT_MACRO) && macroCallback != NULL)
+    macroCallback(macro);
+  if((events & MONOCLE_MENU_EVENT_DEACTIVATE) && deactivateCallback != NULL)
+    deactivateCallback();
+  if((events & MONOCLE_MENU_EVENT_ZOOM) && zoomCallback != NULL)
+    zoomCallback();
+
+  // publish the same events (in the same order) to the event bus
+  if(bus != NULL){
+    if(events & MONOCLE_MENU_EVENT_ACTIVATE)   bus->publishMenu(MONOCLE_MENU_EVENT_ACTIVATE);
+    if(events & MONOCLE_MENU_EVENT_HOME)       bus->publishMenu(MONOCLE_MENU_EVENT_HOME);
+    if(events & MONOCLE_MENU_EVENT_PRESET)     bus->publishMenu(MONOCLE_MENU_EVENT_PRESET, preset);
+    if(events & MONOCLE_MENU_EVENT_MACRO)      bus->publishMenu(MONOCLE_MENU_EVENT_MACRO, macro);
+    if(events & MONOCLE_MENU_EVENT_DEACTIVATE) bus->publishMenu(MONOCLE_MENU_EVENT_DEACTIVATE);
+    if(events & MONOCLE_MENU_EVENT_ZOOM)       bus->publishMenu(MONOCLE_MENU_EVENT_ZOOM);
+  }
+}
+
+/**
+ * ACTIVATE THE MENU SYSTEM
+ */
+void MonocleFlashMenu::activate(){
+  active = true;  // update active state flag
+  open(0, 0);     // reset the menu system
+  updateTimer = millis(); // set a timer to update the display
+  pendingEvents |= MONOCLE_MENU_EVENT_ACTIVATE;
+}
+
+/**
+ * DEACTIVATE THE MENU SYSTEM
+ */
+void MonocleFlashMenu::deactivate(){
+  active = false;  // update active state flag
+  updateTimer = 0;
+  pendingEvents |= MONOCLE_MENU_EVENT_DEACTIVATE;
+}
+
+/**
+ * RETURNS TRUE OF THE MENU SYSTEM IS ACTIVE
+ */
+bool MonocleFlashMenu::isActive(){
+  return active;
+}
+
+/**
+ * SELECT THE CURRENT FOCUSED MENU ITEM
+ */
+void MonocleFlashMenu::select(){
+  updateTimer = millis();
+  uint8_t index = first + current;
+  uint8_t type = nodeByte(index, offsetof(MonocleMenuNode, type));
+
+  if(type == MONOCLE_MENU_NODE_MENU){
+    open(index, 0);
+  }
+  else if(type == MONOCLE_MENU_NODE_BACK){
+    back();
+  }
+  else {
+    uint8_t event = nodeByte(index, offsetof(MonocleMenuNode, event));
+    uint8_t value = nodeByte(index, offsetof(MonocleMenuNode, value));
+    if(event == MONOCLE_MENU_EVENT_PRESET) pendingPreset = value;
+    if(event == MONOCLE_MENU_EVENT_MACRO) pendingMacro = value;
+    pendingEvents |= event;
+    deactivate();
+  }
+}
+
+/**
+ * RESET THE MENU SYSTEM TO THE FIRST ITEM OF THE ROOT MENU
+ */
+void MonocleFlashMenu::reset(){
+  open(0, 0);
+  updateTimer = millis();
+}
+
+/**
+ * MOVE CURSOR TO THE NEXT MENU ITEM IN THE LIST
+ */
+bool MonocleFlashMenu::next(){
+  updateTimer = millis();
+  if(current + 1 >= count) return false;
+  current++;
+  return true;
+}
+
+/**
+ * MOVE CURSOR TO THE PREVIOUS MENU ITEM IN THE LIST
+ */
+bool MonocleFlashMenu::prev(){
+  updateTimer = millis();
+  if(current == 0) return false;
+  current--;
+  return true;
+}
+
+/**
+ * MOVE CURSOR BACK TO THE PARENT MENU OF THE CURRENT SUB-MENU
+ */
+bool MonocleFlashMenu::back(){
+  updateTimer = millis();
+  if(menu == 0) return false;
+
+  // the parent is the menu whose item range holds this menu's node;
+  // the cursor returns to the submenu item that was selected
+  for(uint8_t index = 0; index < size; index++){
+    if(nodeByte(index, offsetof(MonocleMenuNode, type)) != MONOCLE_MENU_NODE_MENU) continue;
+    uint8_t from = nodeByte(index, offsetof(MonocleMenuNode, first));
+    uint8_t items = nodeByte(index, offsetof(MonocleMenuNode, count));
+    if(menu >= from && menu < from + items){
+      open(index, menu - from);
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * GET THE DISPLAYED (SUB)MENU NODE; IDENTIFIES THE MENU TO RENDERERS
+ */
+const MonocleMenuNode* MonocleFlashMenu::currentMenu() const {
+  return &nodes[menu];
+}
+
+/**
+ * GET THE NUMBER OF ITEMS OF THE DISPLAYED MENU
+ */
+int MonocleFlashMenu::itemCount() const {
+  return count;
+}
+
+/**
+ * GET THE POSITION OF THE CURSOR WITHIN THE DISPLAYED MENU
+ */
+int MonocleFlashMenu::position() const {
+  return current;
+}
+
+/**
+ * COPY THE NAME OF AN ITEM OF THE DISPLAYED MENU OUT OF
+ * FLASH; RETURNS 'buffer' (AT LEAST MONOCLE_FLASH_MENU_NAME_LENGTH + 1)
+ */
+const char* MonocleFlashMenu::itemName(int position, char* buffer) const {
+  buffer[0] = '\0';
+  if(position >= 0 && position < count){
+    strncpy_P(buffer, nodes[first + position].name, MONOCLE_FLASH_MENU_NAME_LENGTH);
+    buffer[MONOCLE_FLASH_MENU_NAME_LENGTH] = '\0';
+  }
+  return buffer;
+}
+
+/**
+ * GET THE FLASH (NODE TABLE) SIZE OF THIS MENU TREE IN BYTES
+ */
+size_t MonocleFlashMenu::flashSize() const {
+  return size * sizeof(MonocleMenuNode);
+}
+
+/**
+ * PRINT A MEMORY REPORT COMPARING THE RAM AND FLASH USE OF THIS
+ * MENU TREE WITH THE RUNTIME ('MonocleMenu') MENU TREE
+ */
+void MonocleFlashMenu::report(Print& out) const {
+  // the runtime menu also allocates a component pointer list for each
+  // (sub)menu from the heap as its items are added: the main menu items
+  // and each pool with its [BACK] item
+  size_t lists = (MONOCLE_MENU_ROOT_ITEMS + (1 + MONOCLE_MENU_MAX_PRESETS) + (1 + MONOCLE_MENU_MAX_MACROS) +
+                  (1 + MONOCLE_MENU_CAMERA_ROWS)) * sizeof(MenuComponent*);
+
+  out.println(F("MENU MEMORY REPORT (BYTES)"));
+  out.print(F("  flash menu   : ram "));
+  out.print(sizeof(MonocleFlashMenu));
+  out.print(F(", flash "));
+  out.print(flashSize());
+  out.print(F(" ("));
+  out.print(size);
+  out.println(F(" nodes)"));
+  out.print(F("  runtime menu : ram "));
+  out.print(sizeof(MonocleMenu));
+  out.print(F(" + heap "));
+  out.print(lists);
+  out.println(F(" (component lists)"));
+  out.print(F("  ram saved    : "));
+  out.println(sizeof(MonocleMenu) + lists - sizeof(MonocleFlashMenu));
+}
+
+/**
+ * REGISTER CALLBACK FUNCTION POINTER FOR
+ * NOTIFICATION CALLBACKS WHEN THE MENU SYSTEM
+ * BECOMES ACTIVE
+ */
+void MonocleFlashMenu::onActivate(void (*activateCallback)(void)){
+  this->activateCallback = activateCallback;
+}
+
+/**
+ * REGISTER CALLBACK FUNCTION POINTER FOR
+ * NOTIFICATION CALLBACKS WHEN THE MENU SYSTEM
+ * BECOMES INACTIVE
+ */
+void MonocleFlashMenu::onDeactivate(void (*deactivateCallback)(void)){
+  this->deactivateCallback = deactivateCallback;
+}
+
+/**
+ * REGISTER CALLBACK FUNCTION POINTER FOR
+ * NOTIFICATION CALLBACKS WHEN A 'HOME'
+ * MENU ITEM IS SELECTED
+ */
+void MonocleFlashMenu::onHome(void (*homeCallback)(void)){
+  this->homeCallback = homeCallback;
+}
+
+/**
+ * REGISTER CALLBACK FUNCTION POINTER FOR
+ * NOTIFICATION CALLBACKS WHEN A 'ZOOM'
+ * MENU ITEM IS SELECTED
+ */
+void MonocleFlashMenu::onZoom(void (*zoomCallback)(void)){
+  this->zoomCallback = zoomCallback;
+}
+
+/**
+ * REGISTER CALLBACK FUNCTION POINTER FOR
+ * NOTIFICATION CALLBACKS WHEN A 'PRESET'
+ * MENU ITEM IS SELECTED (WITH THE ITEM VALUE)
+ */
+void MonocleFlashMenu::onPreset(void (*presetCallback)(const int)){
+  this->presetCallback = presetCallback;
+}
+
+/**
+ * REGISTER CALLBACK FUNCTION POINTER FOR
+ * NOTIFICATION CALLBACKS WHEN A 'MACRO'
+ * MENU ITEM IS SELECTED (WITH THE ITEM VALUE)
+ */
+void MonocleFlashMenu::onMacro(void (*macroCallback)(const int)){
+  this->macroCallback = macroCallback;
+}
+
+/**
+ * PUBLISH MENU EVENTS (ACTIVATE, DEACTIVATE, HOME, ZOOM, PRESET
+ * AND MACRO) TO AN EVENT BUS; THE EVENT 'action' FIELD CARRIES
+ * THE MONOCLE_MENU_EVENT_* FLAG AND 'value' THE ITEM VALUE
+ */
+void MonocleFlashMenu::publishTo(MonocleEventBus* bus){
+  this->bus = bus;
+}
@@ -0,0 +1,306 @@
+/*
+ **********************************************************************
+ *             __  __  ___  _  _  ___   ___ _    ___
+ *            |  \/  |/ _ \| \| |/ _ \ / __| |  | __|
+ *            | |\/| | (_) | .` | (_) | (__| |__| _|
+ *            |_|  |_|\___/|_|\_|\___/ \___|____|___|
+ *
+ * -------------------------------------------------------------------
+ *                     MONOCLE FLASH MENU
+ * -------------------------------------------------------------------
+ *
+ *  This library provides a menu implementation whose menu tree is
+ *  declared at compile time as a constant node table placed in
+ *  flash (PROGMEM).  Navigation works by index arithmetic over the
+ *  table, so no menu component objects, name strings or heap
+ *  allocations are held in RAM.
+ *
+ *  Author:   Robert Savage
+ *  Date:     2018-02-18
+ *  Website:  http://monoclecam.com
+ *
+ * -------------------------------------------------------------------
+ *        COPYRIGHT SHADEBLUE, LLC @ 2018, ALL RIGHTS RESERVED
+ * -------------------------------------------------------------------
+ *
+ **********************************************************************
+ */
+
+#ifndef MONOCLE_FLASH_MENU_H
+#define MONOCLE_FLASH_MENU_H
+
+#include <Arduino.h>
+#include "MonocleEventBus.h"
+#include "MonocleScheduler.h"
+
+/* MINIMUM TIME (MILLISECONDS) BETWEEN A MENU CHANGE AND THE DISPLAY REFRESH */
+#ifndef MONOCLE_FLASH_MENU_DISPLAY_INTERVAL
+#define MONOCLE_FLASH_MENU_DISPLAY_INTERVAL 50   // milliseconds
+#endif
+
+/* SCHEDULER TASK INTERVAL AND EXECUTION BUDGET (A DISPLAY REFRESH IS THE LONGEST STEP) */
+#ifndef MONOCLE_FLASH_MENU_TASK_INTERVAL
+#define MONOCLE_FLASH_MENU_TASK_INTERVAL 10      // milliseconds
+#endif
+#ifndef MONOCLE_FLASH_MENU_TASK_BUDGET
+#define MONOCLE_FLASH_MENU_TASK_BUDGET   30000   // microseconds
+#endif
+
+/* MAXIMUM MENU NODE NAME LENGTH (21 CHARS PER LINE LESS THE "> " PREFIX) */
+#ifndef MONOCLE_FLASH_MENU_NAME_LENGTH
+#define MONOCLE_FLASH_MENU_NAME_LENGTH 19
+#endif
+
+/* MENU NODE TYPES */
+#define MONOCLE_MENU_NODE_ITEM 0   // raises its event (and value) when selected
+#define MONOCLE_MENU_NODE_MENU 1   // (sub)menu; its items are the nodes 'first' .. 'first + count - 1'
+#define MONOCLE_MENU_NODE_BACK 2   // returns to the parent menu when selected
+
+/**
+ * A MENU TREE NODE AS STORED IN FLASH.  NODE 0 IS THE ROOT MENU AND
+ * THE ITEMS OF EVERY (SUB)MENU ARE CONSECUTIVE NODES OF THE TABLE.
+ */
+struct MonocleMenuNode {
+  uint8_t type;    // MONOCLE_MENU_NODE_*
+  uint8_t event;   // MONOCLE_MENU_EVENT_* raised when an item is selected
+  uint8_t value;   // preset or macro number passed to the callback (items)
+  uint8_t first;   // index of the first item (menus)
+  uint8_t count;   // number of items (menus)
+  char name[MONOCLE_FLASH_MENU_NAME_LENGTH + 1];
+};
+
+/* MENU NODE DECLARATIONS FOR BUILDING A NODE TABLE */
+#define MONOCLE_MENU_ROOT(first, count)          { MONOCLE_MENU_NODE_MENU, MONOCLE_MENU_EVENT_NONE, 0, (first), (count), "" }
+#define MONOCLE_MENU_SUBMENU(name, first, count) { MONOCLE_MENU_NODE_MENU, MONOCLE_MENU_EVENT_NONE, 0, (first), (count), name }
+#define MONOCLE_MENU_ITEM(name, event, value)    { MONOCLE_MENU_NODE_ITEM, (event), (value), 0, 0, name }
+#define MONOCLE_MENU_BACK(name)                  { MONOCLE_MENU_NODE_BACK, MONOCLE_MENU_EVENT_NONE, 0, 0, 0, name }
+
+/**
+ * RETURNS TRUE IF A NODE TABLE IS A VALID MENU TREE: NODE 0 IS A MENU
+ * AND EVERY MENU LISTS A NON-EMPTY RANGE OF ITEMS FOLLOWING THE MENU
+ * NODE ITSELF (EVALUATED AT COMPILE TIME; SEE MONOCLE_MENU_ASSERT)
+ */
+constexpr bool monocleMenuValid(const MonocleMenuNode* nodes, unsigned int size, unsigned int index = 0){
+  return (index >= size) ? (size > 0 && size <= 255 && nodes[0].type == MONOCLE_MENU_NODE_MENU) :
+         ((nodes[index].type != MONOCLE_MENU_NODE_MENU ||
+           (nodes[index].first > index && nodes[index].count > 0 &&
+            nodes[index].first + nodes[index].count <= size)) &&
+          monocleMenuValid(nodes, size, index + 1));
+}
+
+/* REJECT AN INVALID (CONSTEXPR) NODE TABLE AT COMPILE TIME */
+#define MONOCLE_MENU_ASSERT(nodes) \
+  static_assert(monocleMenuValid(nodes, sizeof(nodes) / sizeof(nodes[0])), "invalid Monocle menu node table")
+
+/**
+ * THE DEFAULT MENU TREE; THE SAME ITEMS 'MonocleMenu' BUILDS AT RUNTIME
+ * BEFORE THE GATEWAY PROVIDES A PRESET LIST ("[EXIT]", "Recall Home" AND
+ * "Recall Preset" WITH "Preset 1" .. "Preset 9"; THE OPTIONAL "Zoom"
+ * ITEM IS NOT INCLUDED, ADD A MONOCLE_MENU_EVENT_ZOOM ITEM TO A TABLE)
+ */
+extern const MonocleMenuNode MONOCLE_DEFAULT_MENU[] PROGMEM;
+extern const uint8_t MONOCLE_DEFAULT_MENU_SIZE;
+
+class MonocleFlashMenu;
+
+/**
+ * RENDERER INTERFACE FOR FLASH MENUS (SEE 'MonocleOLEDMenuRenderer')
+ */
+class MonocleFlashMenuRenderer
+{
+   public:
+     virtual void render(MonocleFlashMenu const& menu) const = 0;
+};
+
+class MonocleFlashMenu
+{
+   private:
+      /* MENU TREE (FLASH) AND THE NAVIGATION STATE (INDEXES INTO THE TREE) */
+      const MonocleMenuNode* nodes;
+      const MonocleFlashMenuRenderer& renderer;
+      uint8_t size;
+      uint8_t menu = 0;      // node index of the displayed (sub)menu
+      uint8_t current = 0;   // position of the cursor within the displayed menu
+      uint8_t first = 0;     // node index of the first item of the displayed menu
+      uint8_t count = 0;     // number of items of the displayed menu
+
+      /* MENU STATE (OWNED BY EACH INSTANCE) */
+      bool active = false;
+      unsigned long updateTimer = 0;
+      uint8_t pendingEvents = MONOCLE_MENU_EVENT_NONE;
+      uint8_t pendingPreset = 0;
+      uint8_t pendingMacro = 0;
+
+      /* NODE TABLE ACCESS */
+      uint8_t nodeByte(uint8_t index, size_t offset) const;
+      void open(uint8_t menu, uint8_t current);
+
+      /* USER CALLBACKS */
+      void (*activateCallback)(void);
+      void (*deactivateCallback)(void);
+      void (*homeCallback)(void);
+      void (*zoomCallback)(void);
+      void (*presetCallback)(const int preset);
+      void (*macroCallback)(const int macro);
+
+      /* OPTIONAL EVENT BUS (MENU EVENTS) */
+      MonocleEventBus* bus = NULL;
+
+      /* SCHEDULER TASK ENTRY POINT */
+      static void internal_menu_task(void* context);
+
+   public:
+    /**
+     * Default Constructor; 'nodes' is a node table in flash
+     * (see MONOCLE_DEFAULT_MENU and MONOCLE_MENU_ASSERT)
+     */
+     MonocleFlashMenu(const MonocleMenuNode* nodes, uint8_t size, MonocleFlashMenuRenderer const& renderer);
+
+    /**
+     * Constructor taking the size from a node table array
+     */
+     template <size_t N>
+     MonocleFlashMenu(const MonocleMenuNode (&nodes)[N], MonocleFlashMenuRenderer const& renderer) :
+         MonocleFlashMenu(nodes, (uint8_t)N, renderer) {}
+
+     /**
+      * FORCE A REFRESH OF THE MENU
+      */
+     void refresh();
+
+     /**
+      * THIS FUNTION MUST BE CALLED IN THE PROGRAM
+      * MAIN LOOP TO SERVICE THE MENU SYSTEM AND EVENTS
+      */
+     void loop();
+
+     /**
+      * REGISTER THIS MENU AS A TASK OF A SCHEDULER (REPLACES
+      * CALLING 'loop()' FROM THE PROGRAM MAIN LOOP).
+      * RETURNS THE TASK ID OR MONOCLE_TASK_INVALID
+      */
+     int schedule(MonocleScheduler& scheduler);
+
+     /**
+      * ACTIVATE THE MENU SYSTEM
+      */
+     void activate();
+
+     /**
+      * DEACTIVATE THE MENU SYSTEM
+      */
+     void deactivate();
+
+     /**
+      * RETURNS TRUE OF THE MENU SYSTEM IS ACTIVE
+      */
+     bool isActive();
+
+     /**
+      * SELECT THE CURRENT FOCUSED MENU ITEM
+      */
+     void select();
+
+     /**
+      * RESET THE MENU SYSTEM TO THE FIRST ITEM OF THE ROOT MENU
+      */
+     void reset();
+
+     /**
+      * MOVE CURSOR TO THE NEXT MENU ITEM IN THE LIST
+      */
+     bool next();
+
+     /**
+      * MOVE CURSOR TO THE PREVIOUS MENU ITEM IN THE LIST
+      */
+     bool prev();
+
+     /**
+      * MOVE CURSOR BACK TO THE PARENT MENU OF THE CURRENT SUB-MENU
+      */
+     bool back();
+
+     /**
+      * GET THE DISPLAYED (SUB)MENU NODE; IDENTIFIES THE MENU TO RENDERERS
+      */
+     const MonocleMenuNode* currentMenu() const;
+
+     /**
+      * GET THE NUMBER OF ITEMS OF THE DISPLAYED MENU
+      */
+     int itemCount() const;
+
+     /**
+      * GET THE POSITION OF THE CURSOR WITHIN THE DISPLAYED MENU
+      */
+     int position() const;
+
+     /**
+      * COPY THE NAME OF AN ITEM OF THE DISPLAYED MENU OUT OF
+      * FLASH; RETURNS 'buffer' (AT LEAST MONOCLE_FLASH_MENU_NAME_LENGTH + 1)
+      */
+     const char* itemName(int position, char* buffer) const;
+
+     /**
+      * GET THE FLASH (NODE TABLE) SIZE OF THIS MENU TREE IN BYTES
+      */
+     size_t flashSize() const;
+
+     /**
+      * PRINT A MEMORY REPORT COMPARING THE RAM AND FLASH USE OF THIS
+      * MENU TREE WITH THE RUNTIME ('MonocleMenu') MENU TREE
+      */
+     void report(Print& out) const;
+
+     /**
+      * REGISTER CALLBACK FUNCTION POINTER FOR
+      * NOTIFICATION CALLBACKS WHEN THE MENU SYSTEM
+      * BECOMES ACTIVE
+      */
+     void onActivate(void (*activateCallback)(void));
+
+     /**
+      * REGISTER CALLBACK FUNCTION POINTER FOR
+      * NOTIFICATION CALLBACKS WHEN THE MENU SYSTEM
+      * BECOMES INACTIVE
+      */
+     void onDeactivate(void (*deactivateCallback)(void));
+
+     /**
+      * REGISTER CALLBACK FUNCTION POINTER FOR
+      * NOTIFICATION CALLBACKS WHEN A 'HOME'
+      * MENU ITEM IS SELECTED
+      */
+     void onHome(void (*homeCallback)(void));
+
+     /**
+      * REGISTER CALLBACK FUNCTION POINTER FOR
+      * NOTIFICATION CALLBACKS WHEN A 'ZOOM'
+      * MENU ITEM IS SELECTED
+      */
+     void onZoom(void (*zoomCallback)(void));
+
+     /**
+      * REGISTER CALLBACK FUNCTION POINTER FOR
+      * NOTIFICATION CALLBACKS WHEN A 'PRESET'
+      * MENU ITEM IS SELECTED (WITH THE ITEM VALUE)
+      */
+     void onPreset(void (*presetCallback)(const int));
+
+     /**
+      * REGISTER CALLBACK FUNCTION POINTER FOR
+      * NOTIFICATION CALLBACKS WHEN A 'MACRO'
+      * MENU ITEM IS SELECTED (WITH THE ITEM VALUE)
+      */
+     void onMacro(void (*macroCallback)(const int));
+
+     /**
+      * PUBLISH MENU EVENTS (ACTIVATE, DEACTIVATE, HOME, ZOOM, PRESET
+      * AND MACRO) TO AN EVENT BUS; THE EVENT 'action' FIELD CARRIES
+      * THE MONOCLE_MENU_EVENT_* FLAG AND 'value' THE ITEM VALUE
+      */
+     void publishTo(MonocleEventBus* bus);
+};
+
+#endif //MONOCLE_FLASH_MENU_H
@@ -24,47 +24,105 @@
  */
 
 #include "MonocleGatewayClient.h"
+#include "MonocleRecorder.h"
+#include "MonocleFence.h"
+#include "MonocleConfig.h"
+#include "MonocleTelemetry.h"
 #include <ArduinoHttpClient.h>
 #include <ArduinoJson.h>
 
+/**
+ * PRESET LIST SCRATCH BUFFER (KEPT OFF THE STACK OF THE MESSAGE PARSER)
+ */
+CameraPreset MonocleGatewayClient::_presets[MONOCLE_GATEWAY_MAX_PRESETS];
+
 /**
  * Constructors
  */
 MonocleGatewayClient::MonocleGatewayClient(Client& client, const char* address, uint16_t port) : _ws(client, address, port) {
-  // initialize active camera attributes
-  _camera.uuid = "";
-  _camera.name = "";
-  _camera.manufacturer = "";
-  _camera.model = "";
-  _camera.error = "";
-  _camera.ptz = false;
+  // initialize active camera attributes and camera sessions
+  resetCamera();
+  resetStatus();
+  clearSessions();
+  for(int index = 0; index < MONOCLE_GATEWAY_MAX_SESSIONS; index++)
+    _sessions[index].uuid[0] = '\0';
 
   // initialize callbacks
   cameraCallback = NULL;
+  presetsCallback = NULL;
+  statusCallback = NULL;
+  cameraListCallback = NULL;
+  cameraEntryCallback = NULL;
 }
 MonocleGatewayClient::MonocleGatewayClient(Client& client, const String& address, uint16_t port) : _ws(client, address, port) {
-  // initialize active camera attributes
-  _camera.uuid = "";
-  _camera.name = "";
-  _camera.manufacturer = "";
-  _camera.model = "";
-  _camera.error = "";
-  _camera.ptz = false;
+  // initialize active camera attributes and camera sessions
+  resetCamera();
+  resetStatus();
+  clearSessions();
+  for(int index = 0; index < MONOCLE_GATEWAY_MAX_SESSIONS; index++)
+    _sessions[index].uuid[0] = '\0';
 
   // initialize callbacks
   cameraCallback = NULL;
+  presetsCallback = NULL;
+  statusCallback = NULL;
+  cameraListCallback = NULL;
+  cameraEntryCallback = NULL;
 }
 MonocleGatewayClient::MonocleGatewayClient(Client& client, const IPAddress& address, uint16_t port) : _ws(client, address, port) {
-  // initialize active camera attributes
-  _camera.uuid = "";
-  _camera.name = "";
-  _camera.manufacturer = "";
-  _camera.model = "";
-  _camera.error = "";
-  _camera.ptz = false;
+  // initialize active camera attributes and camera sessions
+  resetCamera();
+  resetStatus();
+  clearSessions();
+  for(int index = 0; index < MONOCLE_GATEWAY_MAX_SESSIONS; index++)
+    _sessions[index].uuid[0] = '\0';
 
   // initialize callbacks
   cameraCallback = NULL;
+  presetsCallback = NULL;
+  statusCallback = NULL;
+  cameraListCallback = NULL;
+  cameraEntryCallback = NULL;
+}
+
+/**
+ * RESET ALL ACTIVE CAMERA ATTRIBUTES
+ */
+void MonocleGatewayClient::resetCamera() {
+  _cameraUuid[0] = '\0';
+  _cameraName[0] = '\0';
+  _cameraManufacturer[0] = '\0';
+  _cameraModel[0] = '\0';
+  _cameraError[0] = '\0';
+  _camera.uuid = _cameraUuid;
+  _camera.name = _cameraName;
+  _camera.manufacturer = _cameraManufacturer;
+  _camera.model = _cameraModel;
+  _camera.ptz = false;
+  _camera.error = false;
+  _camera.errorMessage = _cameraError;
+}
+
+/**
+ * RESET THE ACTIVE CAMERA STATUS MIRROR (NO STATUS RECEIVED)
+ */
+void MonocleGatewayClient::resetStatus() {
+  _status.pan = 0;
+  _status.tilt = 0;
+  _status.zoom = 0;
+  _status.moving = false;
+  _status.updated = 0;
+  _reportedStatus = _status;
+  _statusChanged = false;
+}
+
+/**
+ * COPY A (POSSIBLY NULL) JSON TEXT VALUE INTO AN OWNED BUFFER
+ */
+static void copyCameraText(char* target, const char* value){
+  if(value == NULL) value = "";
+  strncpy(target, value, MONOCLE_GATEWAY_CAMERA_TEXT_LENGTH);
+  target[MONOCLE_GATEWAY_CAMERA_TEXT_LENGTH] = '\0';
 }
 
 /**
@@ -75,6 +133,15 @@ void MonocleGatewayClient::begin() {
   _ws.begin();
 }
 
+/**
+ * BOUND THE TIME 'begin()' WAITS FOR THE GATEWAY TO ANSWER THE
+ * WEB-SOCKET UPGRADE (MILLISECONDS); THE TCP CONNECT ITSELF IS
+ * BOUNDED BY THE NETWORK LIBRARY OF THE BOARD
+ */
+void MonocleGatewayClient::setConnectTimeout(const unsigned long milliseconds) {
+  _ws.setHttpResponseTimeout(milliseconds);
+}
+
 /**
  * DETEMINE THE CONNECTION STATE
  * RETURNS 'true' IF CURRENTLY CONNECTED
@@ -90,6 +157,8 @@ bool MonocleGatewayClient::connected() {
  * PRECONFIGURED HOME POSITION
  */
 void MonocleGatewayClient::home() {
+  if(_fence != NULL) _fence->stopped();
+  if(_recorder != NULL) _recorder->record(MONOCLE_RECORD_COMMAND, MONOCLE_COMMAND_HOME, 0);
   send("HOME");
 }
 
@@ -126,10 +195,15 @@ void MonocleGatewayClient::home() {
  *    3 : ZOOM IN FAST
  */
  void MonocleGatewayClient::ptz(const int pan, const int tilt, const int zoom) {
+  // slow or stop axes running into a fence zone
+  int fencedPan = pan, fencedTilt = tilt, fencedZoom = zoom;
+  if(_fence != NULL) _fence->filter(fencedPan, fencedTilt, fencedZoom);
+
   String data = "PTZ:";
-  data = data + pan;
-  data = data + ":" + tilt;
-  data = data + ":" + zoom;
+  data = data + fencedPan;
+  data = data + ":" + fencedTilt;
+  data = data + ":" + fencedZoom;
+  if(_recorder != NULL) _recorder->record(MONOCLE_RECORD_COMMAND, MONOCLE_COMMAND_PTZ, MonocleRecorder::packPTZ(fencedPan, fencedTilt, fencedZoom));
   send(data);
 }
 
@@ -138,6 +212,8 @@ void MonocleGatewayClient::home() {
  * ACTIVE CAMERA TO STOP ALL MOVEMENT IMMEDIATELY
  */
 void MonocleGatewayClient::stop() {
+  if(_fence != NULL) _fence->stopped();
+  if(_recorder != NULL) _recorder->record(MONOCLE_RECORD_COMMAND, MONOCLE_COMMAND_STOP, 0);
   send("STOP");
 }
 
@@ -156,6 +232,10 @@ void MonocleGatewayClient::stop() {
  *    3 : PAN RIGHT FAST
  */
 void MonocleGatewayClient::pan(const int pan) {
+  if(_fence != NULL){
+    ptz(pan, _fence->level(MONOCLE_AXIS_TILT), _fence->level(MONOCLE_AXIS_ZOOM));
+    return;
+  }
   String data = "PAN:";
   data+= pan;
   send(data);
@@ -176,6 +256,10 @@ void MonocleGatewayClient::pan(const int pan) {
  *    3 : TILE UP FAST
  */
 void MonocleGatewayClient::tilt(const int tilt) {
+  if(_fence != NULL){
+    ptz(_fence->level(MONOCLE_AXIS_PAN), tilt, _fence->level(MONOCLE_AXIS_ZOOM));
+    return;
+  }
   String data = "TILT:";
   data+= tilt;
   send(data);
@@ -196,6 +280,10 @@ void MonocleGatewayClient::tilt(const int tilt) {
  *    3 : ZOOM IN FAST
  */
 void MonocleGatewayClient::zoom(const int zoom) {
+  if(_fence != NULL){
+    ptz(_fence->level(MONOCLE_AXIS_PAN), _fence->level(MONOCLE_AXIS_TILT), zoom);
+    return;
+  }
   String data = "ZOOM:";
   data+= zoom;
   send(data);
@@ -206,9 +294,468 @@ void MonocleGatewayClient::zoom(const int zoom) {
  * ACTIVE CAMERA TO MOVE TO THE REQUESTED PRESET
  */
 void MonocleGatewayClient::preset(const int preset) {
+  if(_fence != NULL) _fence->stopped();
   String data = "PRESET:#";
   data+= (preset-1);  // presets by index are zero based
+  if(_recorder != NULL) _recorder->record(MONOCLE_RECORD_COMMAND, MONOCLE_COMMAND_PRESET, preset);
+  send(data);
+}
+
+/**
+ * FIND THE SESSION OF A CAMERA; OPTIONALLY CLAIM A FREE SESSION.
+ * RETURNS NULL IF NOT FOUND (OR NO SESSION IS AVAILABLE)
+ */
+MonocleCameraSession* MonocleGatewayClient::findSession(const char* uuid, bool create){
+  if(uuid == NULL || uuid[0] == '\0') return NULL;
+
+  MonocleCameraSession* available = NULL;
+  for(int index = 0; index < MONOCLE_GATEWAY_MAX_SESSIONS; index++){
+    MonocleCameraSession& session = _sessions[index];
+    if(session.uuid[0] == '\0'){
+      if(available == NULL) available = &session;
+    }
+    else if(strncmp(session.uuid, uuid, MONOCLE_GATEWAY_CAMERA_TEXT_LENGTH) == 0){
+      return &session;
+    }
+  }
+  if(!create || available == NULL) return NULL;
+
+  // claim the free session for this camera
+  memset(available, 0, sizeof(MonocleCameraSession));
+  copyCameraText(available->uuid, uuid);
+  return available;
+}
+
+/**
+ * QUEUE A COMMAND FOR A CAMERA SESSION
+ */
+bool MonocleGatewayClient::enqueue(const char* uuid, const MonocleCameraCommand& command){
+  MonocleCameraSession* session = findSession(uuid, true);
+  if(session == NULL) return false;
+
+  bool movement = (command.type == MONOCLE_COMMAND_PTZ || command.type == MONOCLE_COMMAND_STOP);
+
+  // a movement that has not been sent yet is superseded by the newer movement
+  if(movement && session->count > 0){
+    MonocleCameraCommand& last = session->queue[(session->head + session->count - 1) & (MONOCLE_GATEWAY_SESSION_QUEUE_SIZE - 1)];
+    if(last.type == MONOCLE_COMMAND_PTZ || last.type == MONOCLE_COMMAND_STOP){
+      last = command;
+      session->coalesced++;
+      return true;
+    }
+  }
+
+  if(session->count >= MONOCLE_GATEWAY_SESSION_QUEUE_SIZE){
+    // a stop must always reach the camera; discard the backlog instead
+    if(command.type != MONOCLE_COMMAND_STOP){
+      session->dropped++;
+      return false;
+    }
+    session->dropped += session->count;
+    session->count = 0;
+  }
+
+  session->queue[(session->head + session->count) & (MONOCLE_GATEWAY_SESSION_QUEUE_SIZE - 1)] = command;
+  session->count++;
+  return true;
+}
+
+/**
+ * SEND A QUEUED COMMAND; COMMANDS FOR A SPECIFIC CAMERA ARE
+ * PREFIXED WITH '@<uuid>:' (E.G. "@<uuid>:PTZ:1:0:0")
+ */
+void MonocleGatewayClient::sendCommand(MonocleCameraSession& session, const MonocleCameraCommand& command){
+  char data[MONOCLE_GATEWAY_CAMERA_TEXT_LENGTH + 24];
+  switch(command.type){
+    case MONOCLE_COMMAND_PTZ:
+      snprintf(data, sizeof(data), "@%s:PTZ:%d:%d:%d", session.uuid, command.pan, command.tilt, command.zoom);
+      session.pan = command.pan;
+      session.tilt = command.tilt;
+      session.zoom = command.zoom;
+      session.moved = true;
+      break;
+    case MONOCLE_COMMAND_STOP:
+      snprintf(data, sizeof(data), "@%s:STOP", session.uuid);
+      session.pan = session.tilt = session.zoom = 0;
+      session.moved = true;
+      break;
+    case MONOCLE_COMMAND_HOME:
+      snprintf(data, sizeof(data), "@%s:HOME", session.uuid);
+      session.preset = 0;
+      break;
+    case MONOCLE_COMMAND_PRESET:
+      snprintf(data, sizeof(data), "@%s:PRESET:#%d", session.uuid, command.preset - 1);  // presets by index are zero based
+      session.preset = command.preset;
+      break;
+    default:
+      return;
+  }
+  if(_recorder != NULL){
+    // the session index is carried in the high byte of the recorded value
+    int32_t value = 0;
+    if(command.type == MONOCLE_COMMAND_PTZ) value = MonocleRecorder::packPTZ(command.pan, command.tilt, command.zoom);
+    if(command.type == MONOCLE_COMMAND_PRESET) value = command.preset;
+    value |= (int32_t)(&session - _sessions) << 24;
+    _recorder->record(MONOCLE_RECORD_COMMAND, MONOCLE_RECORD_SESSION | command.type, value);
+  }
   send(data);
+  session.sent++;
+}
+
+/**
+ * SEND QUEUED SESSION COMMANDS; SESSIONS ARE SERVED ONE COMMAND AT A
+ * TIME IN ROUND-ROBIN ORDER SO A BUSY CAMERA CANNOT STARVE THE OTHERS
+ */
+void MonocleGatewayClient::flushSessions(){
+  uint8_t sent = 0;
+  uint8_t empty = 0;   // consecutive sessions without queued commands
+  while(sent < MONOCLE_GATEWAY_FLUSH_LIMIT && empty < MONOCLE_GATEWAY_MAX_SESSIONS){
+    MonocleCameraSession& session = _sessions[_nextSession];
+    _nextSession = (_nextSession + 1) % MONOCLE_GATEWAY_MAX_SESSIONS;
+    if(session.count == 0){
+      empty++;
+      continue;
+    }
+    empty = 0;
+
+    MonocleCameraCommand command = session.queue[session.head];
+    session.head = (session.head + 1) & (MONOCLE_GATEWAY_SESSION_QUEUE_SIZE - 1);
+    session.count--;
+    sendCommand(session, command);
+    sent++;
+  }
+}
+
+/**
+ * DISCARD THE QUEUED COMMANDS OF ALL SESSIONS
+ */
+void MonocleGatewayClient::clearSessions(){
+  for(int index = 0; index < MONOCLE_GATEWAY_MAX_SESSIONS; index++){
+    _sessions[index].head = 0;
+    _sessions[index].count = 0;
+  }
+}
+
+/**
+ * QUEUE A PTZ MOVEMENT FOR A SPECIFIC CAMERA (BY UUID); A MOVEMENT
+ * THAT HAS NOT BEEN SENT YET IS REPLACED BY THE NEWER MOVEMENT.
+ * RETURNS 'false' IF THE COMMAND COULD NOT BE QUEUED
+ */
+bool MonocleGatewayClient::ptz(const char* uuid, const int pan, const int tilt, const int zoom){
+  MonocleCameraCommand command = { MONOCLE_COMMAND_PTZ, (int8_t)pan, (int8_t)tilt, (int8_t)zoom, 0 };
+  return enqueue(uuid, command);
+}
+
+/**
+ * QUEUE A STOP FOR A SPECIFIC CAMERA (BY UUID); A STOP IS
+ * NEVER DROPPED, IT REPLACES ANY QUEUED COMMANDS INSTEAD.
+ * RETURNS 'false' IF THE COMMAND COULD NOT BE QUEUED
+ */
+bool MonocleGatewayClient::stop(const char* uuid){
+  MonocleCameraCommand command = { MONOCLE_COMMAND_STOP, 0, 0, 0, 0 };
+  return enqueue(uuid, command);
+}
+
+/**
+ * QUEUE A HOME POSITION RECALL FOR A SPECIFIC CAMERA (BY UUID).
+ * RETURNS 'false' IF THE COMMAND COULD NOT BE QUEUED
+ */
+bool MonocleGatewayClient::home(const char* uuid){
+  MonocleCameraCommand command = { MONOCLE_COMMAND_HOME, 0, 0, 0, 0 };
+  return enqueue(uuid, command);
+}
+
+/**
+ * QUEUE A PRESET RECALL FOR A SPECIFIC CAMERA (BY UUID).
+ * RETURNS 'false' IF THE COMMAND COULD NOT BE QUEUED
+ */
+bool MonocleGatewayClient::preset(const char* uuid, const int preset){
+  if(preset < 1) return false;
+  MonocleCameraCommand command = { MONOCLE_COMMAND_PRESET, 0, 0, 0, (int16_t)preset };
+  return enqueue(uuid, command);
+}
+
+/**
+ * GET THE SESSION (QUEUE AND LAST KNOWN STATE) OF A CAMERA
+ * ADDRESSED BY UUID; RETURNS NULL IF THE CAMERA HAS NO SESSION
+ */
+const MonocleCameraSession* MonocleGatewayClient::session(const char* uuid){
+  return findSession(uuid, false);
+}
+
+/**
+ * RELEASE THE SESSION OF A CAMERA; QUEUED COMMANDS ARE DISCARDED
+ */
+void MonocleGatewayClient::closeSession(const char* uuid){
+  MonocleCameraSession* session = findSession(uuid, false);
+  if(session == NULL) return;
+  session->uuid[0] = '\0';
+  session->count = 0;
+}
+
+/**
+ * GET THE NUMBER OF QUEUED COMMANDS ACROSS ALL CAMERA SESSIONS
+ */
+int MonocleGatewayClient::pending(){
+  int count = 0;
+  for(int index = 0; index < MONOCLE_GATEWAY_MAX_SESSIONS; index++)
+    count += _sessions[index].count;
+  return count;
+}
+
+/**
+ * KEEP (true) OR DISCARD (false, DEFAULT) THE QUEUED SESSION COMMANDS
+ * WHEN THE CONNECTION IS LOST; A GATEWAY POOL HOLDS THEM UNTIL THEY
+ * ARE HANDED OVER TO ANOTHER ENDPOINT OR THE CONNECTION RETURNS
+ */
+void MonocleGatewayClient::holdSessions(const bool hold){
+  _holdSessions = hold;
+}
+
+/**
+ * MOVE ALL QUEUED SESSION COMMANDS TO ANOTHER GATEWAY CLIENT (FAILOVER);
+ * CAMERAS SENT A PTZ OR STOP ARE SENT A STOP BEFORE ANY HANDED OVER
+ * COMMAND (A STOP WRITTEN TO A FAILED CONNECTION MAY HAVE BEEN LOST).
+ * RETURNS THE NUMBER OF COMMANDS QUEUED ON THE TARGET
+ */
+int MonocleGatewayClient::handover(MonocleGatewayClient& target){
+  int count = 0;
+  for(int index = 0; index < MONOCLE_GATEWAY_MAX_SESSIONS; index++){
+    MonocleCameraSession& session = _sessions[index];
+    if(session.uuid[0] == '\0') continue;
+
+    // the camera may still be moving on the command of this gateway
+    if(session.moved){
+      if(target.stop(session.uuid)) count++;
+      session.pan = session.tilt = session.zoom = 0;
+      session.moved = false;
+    }
+
+    // queued commands keep their order (a newer movement still replaces the stop)
+    while(session.count > 0){
+      if(target.enqueue(session.uuid, session.queue[session.head])) count++;
+      session.head = (session.head + 1) & (MONOCLE_GATEWAY_SESSION_QUEUE_SIZE - 1);
+      session.count--;
+    }
+  }
+  return count;
+}
+
+/**
+ * SEND A HEARTBEAT (WEB-SOCKET PING) TO THE MONOCLE GATEWAY; THE
+ * ROUND TRIP TIME IS MEASURED WHEN THE PONG IS RECEIVED.
+ * RETURNS 'false' IF NOT CONNECTED
+ */
+bool MonocleGatewayClient::heartbeat(){
+  if(!_ws.connected()) return false;
+  _ws.ping();
+  _heartbeatTime = millis();
+  _heartbeatPending = true;
+  return true;
+}
+
+/**
+ * DETERMINE IF A HEARTBEAT IS WAITING FOR ITS PONG
+ */
+bool MonocleGatewayClient::heartbeatPending(){
+  return _heartbeatPending;
+}
+
+/**
+ * GET THE TIME (MILLISECONDS) SINCE THE LAST HEARTBEAT WAS SENT
+ */
+unsigned long MonocleGatewayClient::heartbeatAge(){
+  return millis() - _heartbeatTime;
+}
+
+/**
+ * GET THE LAST MEASURED HEARTBEAT ROUND TRIP TIME (MILLISECONDS)
+ */
+unsigned long MonocleGatewayClient::roundTripTime(){
+  return _roundTripTime;
+}
+
+/**
+ * SUBSCRIBE TO ACTIVE CAMERA STATUS PUSHES (POSITION AND MOVING FLAG)
+ * AT THE GIVEN INTERVAL; THE SUBSCRIPTION IS RENEWED ON RECONNECT.
+ * RETURNS 'false' IF NOT CONNECTED (THE SUBSCRIPTION IS SENT ON CONNECT)
+ */
+bool MonocleGatewayClient::subscribeStatus(unsigned int interval){
+  if(interval == 0) interval = MONOCLE_GATEWAY_STATUS_INTERVAL;
+  _statusInterval = interval;
+  if(!connected()) return false;
+
+  char command[32];
+  snprintf(command, sizeof(command), "SUBSCRIBE:STATUS:%u", interval);
+  send(command);
+  return true;
+}
+
+/**
+ * CANCEL THE CAMERA STATUS SUBSCRIPTION
+ */
+void MonocleGatewayClient::unsubscribeStatus(){
+  if(_statusInterval == 0) return;
+  _statusInterval = 0;
+  if(connected()) send("UNSUBSCRIBE:STATUS");
+}
+
+/**
+ * DEFINE THE POSITION CHANGE AND MINIMUM INTERVAL (MILLISECONDS)
+ * REQUIRED BEFORE A STATUS CHANGE CALLBACK IS RAISED (A CHANGE OF
+ * THE MOVING FLAG IS ALWAYS REPORTED, SUBJECT TO THE INTERVAL)
+ */
+void MonocleGatewayClient::setStatusFilter(float delta, unsigned int minInterval){
+  _statusDelta = (delta < 0) ? 0 : delta;
+  _statusMinInterval = minInterval;
+}
+
+/**
+ * GET THE LOCAL MIRROR OF THE ACTIVE CAMERA STATUS
+ */
+const MonocleCameraStatus& MonocleGatewayClient::status(){
+  return _status;
+}
+
+/**
+ * GET THE TIME (MILLISECONDS) SINCE THE LAST STATUS WAS RECEIVED
+ * (0xFFFFFFFF IF NO STATUS WAS RECEIVED FOR THE ACTIVE CAMERA)
+ */
+unsigned long MonocleGatewayClient::statusAge(){
+  if(_status.updated == 0) return 0xFFFFFFFF;
+  return millis() - _status.updated;
+}
+
+/**
+ * DETERMINE IF THE STATUS MIRROR IS OUT OF DATE (NO STATUS RECEIVED
+ * FOR MONOCLE_GATEWAY_STATUS_STALE_FACTOR SUBSCRIPTION INTERVALS)
+ */
+bool MonocleGatewayClient::isStatusStale(){
+  unsigned long interval = (_statusInterval > 0) ? _statusInterval : MONOCLE_GATEWAY_STATUS_INTERVAL;
+  return statusAge() > interval * MONOCLE_GATEWAY_STATUS_STALE_FACTOR;
+}
+
+/**
+ * UPDATE THE STATUS MIRROR; A CHANGE IS FLAGGED FOR THE CALLBACK ONLY
+ * WHEN AN AXIS MOVED BY THE FILTER DELTA OR THE MOVING FLAG CHANGED
+ */
+void MonocleGatewayClient::updateStatus(const MonocleCameraStatus& status){
+  _status = status;
+  _status.updated = millis();
+  if(_status.updated == 0) _status.updated = 1;
+
+  if(_reportedStatus.updated == 0 ||
+     _status.moving != _reportedStatus.moving ||
+     fabs(_status.pan - _reportedStatus.pan) >= _statusDelta ||
+     fabs(_status.tilt - _reportedStatus.tilt) >= _statusDelta ||
+     fabs(_status.zoom - _reportedStatus.zoom) >= _statusDelta){
+    _statusChanged = true;
+  }
+  raiseStatus();
+}
+
+/**
+ * RAISE THE STATUS CHANGE CALLBACK FOR A FLAGGED CHANGE (AT MOST ONCE
+ * PER MINIMUM INTERVAL; A HELD BACK CHANGE IS RAISED BY A LATER 'loop()')
+ */
+void MonocleGatewayClient::raiseStatus(){
+  if(!_statusChanged || statusCallback == NULL) return;
+  if(_statusCallbackTime != 0 && (millis() - _statusCallbackTime) < _statusMinInterval) return;
+  _statusCallbackTime = millis();
+  if(_statusCallbackTime == 0) _statusCallbackTime = 1;
+  _statusChanged = false;
+  _reportedStatus = _status;
+  statusCallback(_status);
+}
+
+/**
+ * FIND A NUMERIC VALUE FOR A '"key":' IN A STATUS MESSAGE
+ */
+static bool statusValue(const char* message, const char* key, float& value){
+  const char* found = strstr(message, key);
+  if(found == NULL) return false;
+  char* end;
+  float parsed = strtod(found + strlen(key), &end);
+  if(end == found + strlen(key)) return false;
+  value = parsed;
+  return true;
+}
+
+/**
+ * PARSE A STATUS PUSH ('{"status":{"pan":..,"tilt":..,"zoom":..,"moving":..}}')
+ * IN PLACE WITHOUT A JSON BUFFER; AXES MISSING FROM THE MESSAGE KEEP
+ * THEIR LAST VALUE. RETURNS 'false' IF NO STATUS VALUE WAS FOUND
+ */
+bool MonocleGatewayClient::parseStatus(const char* message){
+  MonocleCameraStatus status = _status;
+  bool found = statusValue(message, "\"pan\":", status.pan);
+  found = statusValue(message, "\"tilt\":", status.tilt) || found;
+  found = statusValue(message, "\"zoom\":", status.zoom) || found;
+
+  const char* moving = strstr(message, "\"moving\":");
+  if(moving != NULL){
+    moving += 9;
+    while(*moving == ' ') moving++;
+    status.moving = (*moving == 't' || *moving == '1');
+    found = true;
+  }
+
+  if(found) updateStatus(status);
+  return found;
+}
+
+/**
+ * SUBSCRIBE TO GATEWAY CAMERA LIST CHANGES; THE GATEWAY PUSHES THE
+ * CAMERA COUNT AND THE RANGE OF ROWS THAT CHANGED (ADDED, REMOVED OR
+ * RENAMED CAMERAS) AND THE ROWS OF INTEREST ARE THEN REQUESTED WITH
+ * 'requestCameras()'.  THE SUBSCRIPTION IS RENEWED ON RECONNECT.
+ * RETURNS 'false' IF NOT CONNECTED (THE SUBSCRIPTION IS SENT ON CONNECT)
+ */
+bool MonocleGatewayClient::subscribeCameras(){
+  _camerasSubscribed = true;
+  if(!connected()) return false;
+
+  // a new connection is subscribed by the next 'loop()' (link up)
+  if(_linked) send("SUBSCRIBE:CAMERAS");
+  return true;
+}
+
+/**
+ * CANCEL THE CAMERA LIST SUBSCRIPTION
+ */
+void MonocleGatewayClient::unsubscribeCameras(){
+  if(!_camerasSubscribed) return;
+  _camerasSubscribed = false;
+  if(connected()) send("UNSUBSCRIBE:CAMERAS");
+}
+
+/**
+ * REQUEST A PAGE OF CAMERA LIST ROWS (AT MOST MONOCLE_GATEWAY_CAMERA_PAGE);
+ * EACH ROW IS DELIVERED TO THE CAMERA ENTRY CALLBACK.
+ * RETURNS 'false' IF NOT CONNECTED
+ */
+bool MonocleGatewayClient::requestCameras(const int offset, const int count){
+  if(!connected() || offset < 0 || count <= 0) return false;
+
+  char command[32];
+  snprintf(command, sizeof(command), "CAMERAS:%d:%d", offset,
+           (count > MONOCLE_GATEWAY_CAMERA_PAGE) ? MONOCLE_GATEWAY_CAMERA_PAGE : count);
+  send(command);
+  return true;
+}
+
+/**
+ * SEND INSTRUCTION TO MONOCLE GATEWAY TO SWITCH THE ACTIVE CAMERA;
+ * THE GATEWAY ANSWERS WITH A NEW 'source' MESSAGE.
+ * RETURNS 'false' IF NOT CONNECTED
+ */
+bool MonocleGatewayClient::selectCamera(const char* uuid){
+  if(!connected() || uuid == NULL || uuid[0] == '\0') return false;
+
+  char command[MONOCLE_GATEWAY_CAMERA_TEXT_LENGTH + 8];
+  snprintf(command, sizeof(command), "CAMERA:%s", uuid);
+  send(command);
+  return true;
 }
 
 /**
@@ -222,9 +769,16 @@ void MonocleGatewayClient::send(const String& data) {
  * SEND RAW COMMAND (CHAR*) TO MONOCLE GATEWAY
  */
 void MonocleGatewayClient::send(const char* data) {
+  unsigned long start = micros();
   _ws.beginMessage(TYPE_TEXT);
   _ws.print(data);
   _ws.endMessage();
+  _commandTime = millis();
+
+  if(_telemetry != NULL){
+    _telemetry->count(MONOCLE_TELEMETRY_COMMANDS);
+    _telemetry->sample(MONOCLE_TELEMETRY_SEND_TIME, micros() - start);
+  }
 }
 
 /**
@@ -234,6 +788,218 @@ void MonocleGatewayClient::onCameraChange(void (*cameraCallback)(CameraSource& c
   this->cameraCallback = cameraCallback;
 }
 
+/**
+ * REGISTERS A CALLBACK FUNCTION POINTER FOR THE PRESET LIST
+ * PROVIDED BY THE GATEWAY FOR THE ACTIVE CAMERA
+ * (preset names are only valid for the duration of the callback)
+ */
+void MonocleGatewayClient::onPresets(void (*presetsCallback)(CameraPreset* presets, const int count)){
+  this->presetsCallback = presetsCallback;
+}
+
+/**
+ * REGISTERS A CALLBACK FUNCTION POINTER FOR ACTIVE CAMERA STATUS CHANGES
+ * (RATE LIMITED AND DELTA FILTERED; SEE 'setStatusFilter()')
+ */
+void MonocleGatewayClient::onStatus(void (*statusCallback)(const MonocleCameraStatus& status)){
+  this->statusCallback = statusCallback;
+}
+
+/**
+ * REGISTERS A CALLBACK FUNCTION POINTER FOR CAMERA LIST CHANGES
+ * (THE CAMERA COUNT AND THE RANGE OF CHANGED ROWS 'from' .. 'to')
+ */
+void MonocleGatewayClient::onCameraList(void (*cameraListCallback)(const int count, const int from, const int to)){
+  this->cameraListCallback = cameraListCallback;
+}
+
+/**
+ * REGISTERS A CALLBACK FUNCTION POINTER FOR REQUESTED CAMERA LIST ROWS
+ * (entry text is only valid for the duration of the callback)
+ */
+void MonocleGatewayClient::onCameraEntry(void (*cameraEntryCallback)(CameraListEntry& entry)){
+  this->cameraEntryCallback = cameraEntryCallback;
+}
+
+/**
+ * PUBLISH CAMERA CHANGE AND GATEWAY LINK STATE EVENTS TO AN EVENT BUS
+ * (the camera source in the event remains owned by this client)
+ */
+void MonocleGatewayClient::publishTo(MonocleEventBus* bus){
+  this->_bus = bus;
+}
+
+/**
+ * RECORD THE OUTBOUND PTZ, STOP, HOME AND PRESET COMMANDS
+ * (ACTIVE CAMERA AND CAMERA SESSIONS) TO A SESSION RECORDER
+ */
+void MonocleGatewayClient::recordTo(MonocleRecorder* recorder){
+  this->_recorder = recorder;
+}
+
+/**
+ * FILTER THE ACTIVE CAMERA PTZ, PAN, TILT AND ZOOM COMMANDS THROUGH
+ * A FENCE (SEE 'MonocleFence::begin()'); WITH A FENCE THE SINGLE
+ * AXIS COMMANDS ARE SENT AS FULL PTZ VECTORS
+ */
+void MonocleGatewayClient::fenceWith(MonocleFence* fence){
+  this->_fence = fence;
+}
+
+/**
+ * ACCEPT 'config' MESSAGES FROM THE GATEWAY ({"config":{"name":value,...}})
+ * AND APPLY THEM TO A RUNTIME CONFIGURATION; EACH MESSAGE IS ANSWERED
+ * WITH 'CONFIG:OK' OR 'CONFIG:ERROR:<name>' (FIELDS BEFORE THE FAILED
+ * ONE ARE APPLIED).  SET BY 'MonocleConfig::attach()'
+ */
+void MonocleGatewayClient::configureWith(MonocleConfig* config){
+  this->_config = config;
+}
+
+/**
+ * REPORT CONNECTIONS, COMMANDS SENT (AND THEIR SEND TIME), MESSAGES
+ * RECEIVED AND HEARTBEAT ROUND TRIP TIMES TO A TELEMETRY COLLECTOR
+ * AND SEND ITS FRAMES TO THE GATEWAY AT THE TELEMETRY INTERVAL
+ * (A FRAME WAITS WHILE CAMERA COMMANDS ARE QUEUED OR WERE JUST SENT)
+ */
+void MonocleGatewayClient::reportTo(MonocleTelemetry* telemetry){
+  this->_telemetry = telemetry;
+}
+
+/**
+ * SEND A TELEMETRY FRAME IF ONE IS DUE; THE FRAME IS HELD BACK WHILE
+ * CAMERA COMMANDS ARE QUEUED OR WERE SENT WITHIN THE QUIET TIME
+ */
+void MonocleGatewayClient::sendTelemetry(){
+  bool busy = (millis() - _commandTime) < MONOCLE_TELEMETRY_QUIET_TIME;
+  for(int index = 0; index < MONOCLE_GATEWAY_MAX_SESSIONS && !busy; index++){
+    if(_sessions[index].count > 0) busy = true;
+  }
+  if(!_telemetry->ready(busy)) return;
+
+  // the frame is not counted as a command
+  char frame[MONOCLE_TELEMETRY_FRAME_LENGTH + 1];
+  if(_telemetry->format(frame, sizeof(frame)) == 0) return;
+  _ws.beginMessage(TYPE_TEXT);
+  _ws.print(frame);
+  _ws.endMessage();
+}
+
+/**
+ * SUBSCRIBE TO PTZ AND MENU EVENTS ON AN EVENT BUS AND FORWARD
+ * THEM AS COMMANDS TO THE MONOCLE GATEWAY (PTZ, HOME AND PRESET)
+ */
+bool MonocleGatewayClient::subscribeTo(MonocleEventBus* bus){
+  if(bus == NULL) return false;
+  return bus->subscribe(MONOCLE_EVENT_PTZ, &MonocleGatewayClient::internal_gateway_event_handler, this) &&
+         bus->subscribe(MONOCLE_EVENT_MENU, &MonocleGatewayClient::internal_gateway_event_handler, this);
+}
+
+/**
+ * EVENT BUS SUBSCRIBER; FORWARDS PTZ AND MENU EVENTS TO THE GATEWAY
+ */
+void MonocleGatewayClient::internal_gateway_event_handler(const MonocleEvent& event, void* context){
+  MonocleGatewayClient* client = static_cast<MonocleGatewayClient*>(context);
+  if(!client->connected()) return;
+
+  if(event.type == MONOCLE_EVENT_PTZ){
+    client->ptz(event.pan, event.tilt, event.zoom);
+  }
+  else if(event.type == MONOCLE_EVENT_MENU){
+    if(event.action == MONOCLE_MENU_EVENT_HOME)
+      client->home();
+    else if(event.action == MONOCLE_MENU_EVENT_PRESET && event.value > 0)
+      client->preset(event.value);
+    else if(event.action == MONOCLE_MENU_EVENT_CAMERA && event.uuid != NULL)
+      client->selectCamera(event.uuid);
+  }
+}
+
+/**
+ * PROCESS A PRESET LIST RECEIVED FROM THE MONOCLE GATEWAY; EACH
+ * ENTRY MAY BE A PLAIN NAME STRING OR AN OBJECT WITH A 'name' KEY
+ */
+void MonocleGatewayClient::processPresets(JsonArray& list){
+  if (presetsCallback == NULL) return;
+
+  int count = 0;
+  for(size_t index = 0; index < list.size() && count < MONOCLE_GATEWAY_MAX_PRESETS; index++){
+    const char* name = list[index].as<const char*>();
+    if(name == NULL) name = list[index]["name"];
+    _presets[count].preset = count + 1;
+    _presets[count].name = (name != NULL) ? name : "";
+    count++;
+  }
+
+  // raise callback for the preset list
+  presetsCallback(_presets, count);
+}
+
+/**
+ * PROCESS A CAMERA LIST CHANGE ('{"cameras":{"count":130,"from":12,"to":129}}');
+ * A MISSING RANGE MEANS THE ENTIRE LIST MAY HAVE CHANGED
+ */
+void MonocleGatewayClient::processCameras(JsonObject& cameras){
+  if (cameraListCallback == NULL) return;
+
+  int count = cameras.get<int>("count");
+  int from = cameras.containsKey("from") ? cameras.get<int>("from") : 0;
+  int to = cameras.containsKey("to") ? cameras.get<int>("to") : count - 1;
+  cameraListCallback(count, from, to);
+}
+
+/**
+ * PROCESS A REQUESTED CAMERA LIST ROW
+ * ('{"camera":{"index":3,"uuid":"..","name":"..","active":false}}')
+ */
+void MonocleGatewayClient::processCameraEntry(JsonObject& camera){
+  if (cameraEntryCallback == NULL || !camera.containsKey("index")) return;
+
+  CameraListEntry entry;
+  entry.index = camera.get<int>("index");
+  entry.uuid = camera.containsKey("uuid") ? camera.get<const char*>("uuid") : "";
+  entry.name = camera.containsKey("name") ? camera.get<const char*>("name") : "";
+  entry.active = camera.containsKey("active") && camera.get<bool>("active");
+  cameraEntryCallback(entry);
+}
+
+/**
+ * A CONFIGURATION VALUE AS TEXT IN THE CONSOLE 'set' FORMAT
+ */
+static const char* configText(const JsonVariant& value, char* buffer, size_t size){
+  if (value.is<const char*>()) return value.as<const char*>();
+  if (value.is<bool>()) return value.as<bool>() ? "1" : "0";
+  snprintf(buffer, size, "%ld", value.as<long>());
+  return buffer;
+}
+
+/**
+ * PROCESS A CONFIGURATION UPDATE ('{"config":{"thresholdLow":600,"invertPan":true}}');
+ * VALUES MAY BE NUMBERS, BOOLEANS OR TEXT IN THE CONSOLE 'set' FORMAT.
+ * ONLY MONOCLE_CONFIG_REMOTE FIELDS ARE ACCEPTED; AN UPDATE NAMING ANY
+ * OTHER FIELD (E.G. THE WIFI CREDENTIALS OR THE GATEWAY ENDPOINT) OR
+ * HOLDING ANY INVALID VALUE IS REJECTED AS A WHOLE
+ */
+void MonocleGatewayClient::processConfig(JsonObject& config){
+  if (_config == NULL) return;
+  char number[24];
+
+  // check every field and value before changing any
+  for (JsonObject::iterator field = config.begin(); field != config.end(); ++field){
+    int id = MonocleConfig::find(field->key);
+    if (!MonocleConfig::isRemote(id) || !_config->check(id, configText(field->value, number, sizeof(number)))){
+      char reply[64];
+      snprintf(reply, sizeof(reply), "CONFIG:ERROR:%s", field->key);
+      send(reply);
+      return;
+    }
+  }
+
+  for (JsonObject::iterator field = config.begin(); field != config.end(); ++field)
+    _config->set(MonocleConfig::find(field->key), configText(field->value, number, sizeof(number)));
+  send("CONFIG:OK");
+}
+
 /**
  * GET THE ACTIVE CAMERA SOURCE
  */
@@ -241,6 +1007,27 @@ CameraSource MonocleGatewayClient::activeCameraSource(){
   return this->_camera;
 }
 
+/**
+ * RESTORE A PREVIOUSLY SAVED ACTIVE CAMERA SOURCE (E.G. AT BOOT
+ * BEFORE THE GATEWAY IS CONNECTED); THE TEXT VALUES ARE COPIED
+ * AND THE CAMERA CHANGE CALLBACK AND EVENT ARE RAISED.  THE
+ * GATEWAY'S NEXT 'source' MESSAGE REPLACES THE RESTORED CAMERA
+ */
+void MonocleGatewayClient::restoreCamera(const CameraSource& camera){
+  resetCamera();
+  copyCameraText(_cameraUuid, camera.uuid);
+  copyCameraText(_cameraName, camera.name);
+  copyCameraText(_cameraManufacturer, camera.manufacturer);
+  copyCameraText(_cameraModel, camera.model);
+  copyCameraText(_cameraError, camera.errorMessage);
+  _camera.ptz = camera.ptz;
+  _camera.error = camera.error;
+
+  // raise callback for camera change
+  if (cameraCallback != NULL) cameraCallback(_camera);
+  if (_bus != NULL) _bus->publishCamera(&_camera);
+}
+
 /**
  * GET THE ACTIVE CAMERA ENABLED STATE
  */
@@ -248,63 +1035,196 @@ bool MonocleGatewayClient::isCameraEnabled(){
   return (!this->_camera.error && this->_camera.ptz);
 }
 
+/**
+ * SCHEDULER TASK ENTRY POINT
+ */
+void MonocleGatewayClient::internal_gateway_task(void* context){
+  ((MonocleGatewayClient*)context)->loop();
+}
+
+/**
+ * REGISTER THIS CLIENT AS A TASK OF A SCHEDULER (REPLACES
+ * CALLING 'loop()' FROM THE PROGRAM MAIN LOOP).
+ * RETURNS THE TASK ID OR MONOCLE_TASK_INVALID
+ */
+int MonocleGatewayClient::schedule(MonocleScheduler& scheduler){
+  return scheduler.every(MONOCLE_GATEWAY_TASK_INTERVAL, internal_gateway_task, this, MONOCLE_GATEWAY_TASK_BUDGET);
+}
+
 /**
  * THIS FUNTION MUST BE CALLED IN THE PROGRAM
  * MAIN LOOP TO SERVICE THE MONOCLE GATEWAY CLIENT
  * AND DISPATCH ANY EVENTS
  */
 void MonocleGatewayClient::loop(){
+    // publish gateway link state changes to the event bus
+    bool linked = _ws.connected();
+    if(linked != _linked){
+      _linked = linked;
+      if (_bus != NULL) _bus->publishLink(linked);
+      if (_telemetry != NULL) _telemetry->count(linked ? MONOCLE_TELEMETRY_CONNECTS : MONOCLE_TELEMETRY_DISCONNECTS);
+
+      // queued movements are stale once the connection is lost
+      // (unless held for a pool to hand them over to another gateway)
+      if(!linked){
+        if(!_holdSessions) clearSessions();
+        _heartbeatPending = false;
+      }
+      // process the gateway's first 'source' message without waiting
+      // for a full processing interval after connecting
+      else {
+        _processingTimer = millis() - MONOCLE_GATEWAY_PROCESSING_INTERVAL;
+        _linkTime = millis();
+        _awaitingSource = true;
+
+        // renew the camera status and camera list subscriptions on the new connection
+        if(_statusInterval > 0) subscribeStatus(_statusInterval);
+        if(_camerasSubscribed) subscribeCameras();
+      }
+    }
+
     // no need to process anything if we are not connected
-    if(!_ws.connected()) return;
+    if(!linked) return;
+
+    // send queued camera session commands (not throttled by the processing interval)
+    flushSessions();
+
+    // raise a status change held back by the callback rate limit
+    raiseStatus();
+
+    // send a telemetry frame once due and the camera commands are quiet
+    if(_telemetry != NULL) sendTelemetry();
 
     // we don't need to process the message queue on every loop iteraction
     // so we use this timing logic to only process the queue once per second
-    if((millis() - _processingTimer) < MONOCLE_GATEWAY_PROCESSING_INTERVAL) return;
+    // (unless a heartbeat is waiting for its pong to measure the round trip,
+    // status pushes or camera list pages are subscribed, or the first 'source'
+    // message is due within the first processing interval after connecting)
+    bool streaming = (_statusInterval > 0 || _camerasSubscribed);
+    bool connecting = _awaitingSource && (millis() - _linkTime) < MONOCLE_GATEWAY_PROCESSING_INTERVAL;
+    if(!_heartbeatPending && !streaming && !connecting &&
+       (millis() - _processingTimer) < MONOCLE_GATEWAY_PROCESSING_INTERVAL) return;
     _processingTimer = millis();
 
-    // check if a message is available to be received
-    int messageSize = _ws.parseMessage();
-    if (messageSize > 0) {
-      String raw = _ws.readString();
+    // read one message per pass; while subscribed a bounded number of
+    // messages is drained so a chatty gateway cannot starve the loop
+    int limit = streaming ? MONOCLE_GATEWAY_MESSAGE_LIMIT : 1;
+    for(int count = 0; count < limit; count++){
+      // check if a message is available to be received
+      int messageSize = _ws.parseMessage();
+      if(messageSize <= 0) break;
+      processMessage(messageSize);
+    }
+}
+
+/**
+ * PROCESS A MESSAGE RECEIVED FROM THE MONOCLE GATEWAY
+ */
+void MonocleGatewayClient::processMessage(int messageSize){
+    // heartbeat response (echoes the ping payload); measure the round trip time
+    if (_ws.messageType() == TYPE_PONG) {
+      if(_heartbeatPending){
+        _roundTripTime = millis() - _heartbeatTime;
+        if(_telemetry != NULL) _telemetry->sample(MONOCLE_TELEMETRY_ROUND_TRIP, _roundTripTime);
+      }
+      _heartbeatPending = false;
+      return;
+    }
+    if (_telemetry != NULL) _telemetry->count(MONOCLE_TELEMETRY_MESSAGES);
+
+    // small messages (e.g. status pushes) are read into a stack buffer
+    if (messageSize <= MONOCLE_GATEWAY_MESSAGE_BUFFER) {
+      char buffer[MONOCLE_GATEWAY_MESSAGE_BUFFER + 1];
+      size_t length = _ws.readBytes(buffer, messageSize);
+      buffer[length] = '\0';
+
+      // status pushes are parsed in place without a JSON buffer
+      if(strncmp(buffer, "{\"status\"", 9) == 0 && parseStatus(buffer)) return;
 
       // parse JSON message received from MonocleGateway
       DynamicJsonBuffer jsonBuffer;
-      JsonObject& payload = jsonBuffer.parseObject(raw);
+      JsonObject& payload = jsonBuffer.parseObject(buffer);
+      processPayload(payload);
+      return;
+    }
 
-      // look for 'source' message (its the only one we currently care about)
+    String raw = _ws.readString();
+
+    // parse JSON message received from MonocleGateway
+    DynamicJsonBuffer jsonBuffer;
+    JsonObject& payload = jsonBuffer.parseObject(raw);
+    processPayload(payload);
+}
+
+/**
+ * PROCESS A PARSED JSON MESSAGE RECEIVED FROM THE MONOCLE GATEWAY
+ */
+void MonocleGatewayClient::processPayload(JsonObject& payload){
+      // look for 'source' message
       if(payload.containsKey("source")){
         JsonObject& source = payload["source"];
+        _awaitingSource = false;
 
         // we have received a new source, lets reset all active camera attributes
-        _camera.uuid = "";
-        _camera.name = "";
-        _camera.manufacturer = "";
-        _camera.model = "";
-        _camera.ptz = false;
-        _camera.error = false;
-        _camera.errorMessage = "";
-
-        // populate the active source attributes from the source object in the JSON message
+        // (the status mirror belongs to the previous camera)
+        resetCamera();
+        resetStatus();
+
+        // populate the active source attributes from the source object in the JSON message;
+        // text values are copied since the JSON buffer is released after this message
         if(source.containsKey("uuid"))
-          _camera.uuid = source["uuid"];
+          copyCameraText(_cameraUuid, source["uuid"]);
         if(source.containsKey("name"))
-          _camera.name = source["name"];
+          copyCameraText(_cameraName, source["name"]);
         if(source.containsKey("manufacturer"))
-          _camera.manufacturer = source["manufacturer"];
+          copyCameraText(_cameraManufacturer, source["manufacturer"]);
         if(source.containsKey("model"))
-          _camera.model = source["model"];
+          copyCameraText(_cameraModel, source["model"]);
         if(source.containsKey("ptz"))
           _camera.ptz = source.get<bool>("ptz");
         if(source.containsKey("error")){
-          _camera.errorMessage = source["error"];
-          _camera.error = (strlen(_camera.errorMessage) > 0);
+          copyCameraText(_cameraError, source["error"]);
+          _camera.error = (strlen(_cameraError) > 0);
         }
 
         // raise callback for camera change
         if (cameraCallback != NULL) cameraCallback(_camera);
+        if (_bus != NULL) _bus->publishCamera(&_camera);
+
+        // the source may include the preset list for the camera
+        if(source.containsKey("presets"))
+          processPresets(source["presets"]);
+      }
+      // look for a standalone 'presets' message for the active camera
+      else if(payload.containsKey("presets")){
+        processPresets(payload["presets"]);
+      }
+      // look for a (large or reformatted) 'status' message for the active camera
+      else if(payload.containsKey("status")){
+        JsonObject& values = payload["status"];
+        MonocleCameraStatus status = _status;
+        if(values.containsKey("pan"))
+          status.pan = values.get<float>("pan");
+        if(values.containsKey("tilt"))
+          status.tilt = values.get<float>("tilt");
+        if(values.containsKey("zoom"))
+          status.zoom = values.get<float>("zoom");
+        if(values.containsKey("moving"))
+          status.moving = values.get<bool>("moving");
+        updateStatus(status);
+      }
+      // look for a camera list row (requested page) or a camera list change
+      else if(payload.containsKey("camera")){
+        processCameraEntry(payload["camera"]);
+      }
+      else if(payload.containsKey("cameras")){
+        processCameras(payload["cameras"]);
+      }
+      // look for a runtime configuration update
+      else if(payload.containsKey("config")){
+        processConfig(payload["config"]);
       }
       else {
         Serial.println("NO SOURCE");
       }
-    }
 }
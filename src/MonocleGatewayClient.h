@@ -27,9 +27,89 @@
 
 #include <ArduinoHttpClient.h>
 #include <ArduinoJson.h>
+#include "MonocleEventBus.h"
+#include "MonocleScheduler.h"
+
+class MonocleRecorder;
+class MonocleFence;
+class MonocleConfig;
+class MonocleTelemetry;
 
 #define MONOCLE_GATEWAY_PROCESSING_INTERVAL 1000
 
+/* SCHEDULER TASK INTERVAL AND EXECUTION BUDGET */
+#ifndef MONOCLE_GATEWAY_TASK_INTERVAL
+#define MONOCLE_GATEWAY_TASK_INTERVAL 10      // milliseconds
+#endif
+#ifndef MONOCLE_GATEWAY_TASK_BUDGET
+#define MONOCLE_GATEWAY_TASK_BUDGET   20000   // microseconds
+#endif
+
+/* MAXIMUM NUMBER OF CAMERA PRESETS DELIVERED IN A SINGLE PRESET LIST
+   (STATICALLY ALLOCATED; 8 BYTES OF RAM PER PRESET ON 32-BIT BOARDS) */
+#ifndef MONOCLE_GATEWAY_MAX_PRESETS
+#define MONOCLE_GATEWAY_MAX_PRESETS 32
+#endif
+
+/* MAXIMUM LENGTH OF EACH CAMERA SOURCE TEXT ATTRIBUTE (COPIED FROM THE GATEWAY MESSAGE) */
+#ifndef MONOCLE_GATEWAY_CAMERA_TEXT_LENGTH
+#define MONOCLE_GATEWAY_CAMERA_TEXT_LENGTH 40
+#endif
+
+/* MAXIMUM NUMBER OF CAMERAS ADDRESSED BY UUID AT THE SAME TIME (SESSIONS) */
+#ifndef MONOCLE_GATEWAY_MAX_SESSIONS
+#define MONOCLE_GATEWAY_MAX_SESSIONS 4
+#endif
+
+/* OUTBOUND COMMAND QUEUE SIZE OF EACH CAMERA SESSION (MUST BE A POWER OF TWO) */
+#ifndef MONOCLE_GATEWAY_SESSION_QUEUE_SIZE
+#define MONOCLE_GATEWAY_SESSION_QUEUE_SIZE 8
+#endif
+
+/* MAXIMUM NUMBER OF QUEUED COMMANDS SENT PER 'loop()' ACROSS ALL SESSIONS */
+#ifndef MONOCLE_GATEWAY_FLUSH_LIMIT
+#define MONOCLE_GATEWAY_FLUSH_LIMIT 4
+#endif
+
+#if (MONOCLE_GATEWAY_SESSION_QUEUE_SIZE & (MONOCLE_GATEWAY_SESSION_QUEUE_SIZE - 1)) != 0 || MONOCLE_GATEWAY_SESSION_QUEUE_SIZE > 128
+#error("MONOCLE_GATEWAY_SESSION_QUEUE_SIZE must be a power of two no larger than 128")
+#endif
+
+/* CAMERA STATUS (POSITION FEEDBACK) SUBSCRIPTION */
+#ifndef MONOCLE_GATEWAY_STATUS_INTERVAL
+#define MONOCLE_GATEWAY_STATUS_INTERVAL     200   // milliseconds between gateway status pushes (requested)
+#endif
+#ifndef MONOCLE_GATEWAY_STATUS_MIN_INTERVAL
+#define MONOCLE_GATEWAY_STATUS_MIN_INTERVAL 100   // milliseconds between status change callbacks
+#endif
+#ifndef MONOCLE_GATEWAY_STATUS_DELTA
+#define MONOCLE_GATEWAY_STATUS_DELTA        0.5   // position change raising a status change callback
+#endif
+#ifndef MONOCLE_GATEWAY_STATUS_STALE_FACTOR
+#define MONOCLE_GATEWAY_STATUS_STALE_FACTOR 3     // status is stale after this many missed pushes
+#endif
+
+/* MAXIMUM NUMBER OF GATEWAY MESSAGES READ PER 'loop()' WHILE SUBSCRIBED TO STATUS */
+#ifndef MONOCLE_GATEWAY_MESSAGE_LIMIT
+#define MONOCLE_GATEWAY_MESSAGE_LIMIT 4
+#endif
+
+/* SMALL MESSAGES (E.G. STATUS PUSHES) ARE READ INTO A STACK BUFFER INSTEAD OF A STRING */
+#ifndef MONOCLE_GATEWAY_MESSAGE_BUFFER
+#define MONOCLE_GATEWAY_MESSAGE_BUFFER 128
+#endif
+
+/* MAXIMUM NUMBER OF CAMERA LIST ROWS REQUESTED IN A SINGLE PAGE */
+#ifndef MONOCLE_GATEWAY_CAMERA_PAGE
+#define MONOCLE_GATEWAY_CAMERA_PAGE 16
+#endif
+
+/* CAMERA SESSION COMMAND TYPES */
+#define MONOCLE_COMMAND_PTZ    0
+#define MONOCLE_COMMAND_STOP   1
+#define MONOCLE_COMMAND_HOME   2
+#define MONOCLE_COMMAND_PRESET 3
+
 struct CameraSource {
   const char* uuid;
   const char* name;
@@ -40,12 +120,148 @@ struct CameraSource {
   const char* errorMessage;
 };
 
+struct CameraPreset {
+  int preset;           // one based preset number (as used by 'preset()')
+  const char* name;
+};
+
+/**
+ * ONE ROW OF THE GATEWAY CAMERA LIST; ROWS ARE REQUESTED IN PAGES
+ * ('{"camera":{"index":3,"uuid":"..","name":"..","active":false}}')
+ * SO THE LIST IS NEVER HELD IN FULL BY THE CONTROLLER
+ */
+struct CameraListEntry {
+  int index;            // zero based position in the gateway camera list
+  const char* uuid;
+  const char* name;
+  bool active;          // this is the active camera
+};
+
+/**
+ * LOCAL MIRROR OF THE ACTIVE CAMERA STATUS PUSHED BY THE GATEWAY
+ * ('{"status":{"pan":12.5,"tilt":-3,"zoom":1,"moving":false}}')
+ */
+struct MonocleCameraStatus {
+  float pan;
+  float tilt;
+  float zoom;
+  bool moving;
+  unsigned long updated;     // time the last status was received (0 = never)
+};
+
+/**
+ * A QUEUED COMMAND FOR A SPECIFIC CAMERA
+ */
+struct MonocleCameraCommand {
+  uint8_t type;      // MONOCLE_COMMAND_*
+  int8_t pan;
+  int8_t tilt;
+  int8_t zoom;
+  int16_t preset;    // one based preset number
+};
+
+/**
+ * OUTBOUND COMMAND QUEUE AND LAST KNOWN STATE OF A CAMERA
+ * ADDRESSED BY UUID (INDEPENDENT OF THE ACTIVE CAMERA);
+ * COMMANDS ARE SENT AS '@<uuid>:<command>'
+ */
+struct MonocleCameraSession {
+  char uuid[MONOCLE_GATEWAY_CAMERA_TEXT_LENGTH + 1];   // empty when unused
+  int8_t pan;                 // last PTZ vector sent
+  int8_t tilt;
+  int8_t zoom;
+  int preset;                 // last preset recalled (0 = none or home)
+  bool moved;                 // a PTZ or STOP was sent (a STOP is repeated on handover)
+  unsigned long sent;         // commands sent to the gateway
+  unsigned long coalesced;    // queued movements replaced by a newer movement
+  unsigned long dropped;      // commands dropped because the queue was full
+  MonocleCameraCommand queue[MONOCLE_GATEWAY_SESSION_QUEUE_SIZE];
+  uint8_t head;
+  uint8_t count;
+};
+
 class MonocleGatewayClient
 {
    private:
      WebSocketClient _ws;
      unsigned long _processingTimer;
      CameraSource _camera;
+     bool _linked = false;
+     unsigned long _linkTime = 0;   // 'millis()' when the connection was established
+     bool _awaitingSource = false;  // no 'source' message received since connecting
+     bool _holdSessions = false;   // keep queued session commands when the connection is lost
+
+     /* HEARTBEAT (WEB-SOCKET PING/PONG) ROUND TRIP MEASUREMENT */
+     unsigned long _heartbeatTime = 0;
+     bool _heartbeatPending = false;
+     unsigned long _roundTripTime = 0;
+
+     /* OWNED COPIES OF THE ACTIVE CAMERA TEXT ATTRIBUTES */
+     char _cameraUuid[MONOCLE_GATEWAY_CAMERA_TEXT_LENGTH + 1];
+     char _cameraName[MONOCLE_GATEWAY_CAMERA_TEXT_LENGTH + 1];
+     char _cameraManufacturer[MONOCLE_GATEWAY_CAMERA_TEXT_LENGTH + 1];
+     char _cameraModel[MONOCLE_GATEWAY_CAMERA_TEXT_LENGTH + 1];
+     char _cameraError[MONOCLE_GATEWAY_CAMERA_TEXT_LENGTH + 1];
+
+     /* OPTIONAL EVENT BUS (CAMERA AND LINK EVENTS) */
+     MonocleEventBus* _bus = NULL;
+
+     /* OPTIONAL SESSION RECORDER (OUTBOUND CAMERA COMMANDS) */
+     MonocleRecorder* _recorder = NULL;
+
+     /* OPTIONAL FENCE (SOFT LIMITS AND PRIVACY ZONES FOR THE ACTIVE CAMERA) */
+     MonocleFence* _fence = NULL;
+
+     /* OPTIONAL RUNTIME CONFIGURATION (UPDATED BY GATEWAY 'config' MESSAGES) */
+     MonocleConfig* _config = NULL;
+
+     /* OPTIONAL TELEMETRY (COLLECTED COUNTERS AND HISTOGRAMS SENT AS FRAMES) */
+     MonocleTelemetry* _telemetry = NULL;
+     unsigned long _commandTime = 0;          // last command sent (telemetry waits for quiet)
+
+     /* ACTIVE CAMERA STATUS MIRROR (RATE LIMITED, DELTA FILTERED CALLBACKS) */
+     MonocleCameraStatus _status;
+     MonocleCameraStatus _reportedStatus;     // status passed to the last callback
+     unsigned int _statusInterval = 0;        // requested push interval (0 = not subscribed)
+     unsigned int _statusMinInterval = MONOCLE_GATEWAY_STATUS_MIN_INTERVAL;
+     float _statusDelta = MONOCLE_GATEWAY_STATUS_DELTA;
+     unsigned long _statusCallbackTime = 0;
+     bool _statusChanged = false;
+
+     /* CAMERA LIST SUBSCRIPTION (COUNT AND CHANGED RANGE PUSHES; ROWS BY PAGE) */
+     bool _camerasSubscribed = false;
+
+     /* PER-CAMERA SESSIONS (ROUND-ROBIN FLUSHED OVER THE SINGLE WEB-SOCKET) */
+     MonocleCameraSession _sessions[MONOCLE_GATEWAY_MAX_SESSIONS];
+     uint8_t _nextSession = 0;
+
+     /* PRESET LIST SCRATCH BUFFER (SHARED; ONLY VALID DURING THE PRESETS CALLBACK) */
+     static CameraPreset _presets[MONOCLE_GATEWAY_MAX_PRESETS];
+
+     /* INTERNAL MESSAGE PROCESSING */
+     void resetCamera();
+     MonocleCameraSession* findSession(const char* uuid, bool create);
+     bool enqueue(const char* uuid, const MonocleCameraCommand& command);
+     void sendCommand(MonocleCameraSession& session, const MonocleCameraCommand& command);
+     void flushSessions();
+     void clearSessions();
+     void processPresets(JsonArray& list);
+     void processMessage(int messageSize);
+     void processPayload(JsonObject& payload);
+     bool parseStatus(const char* message);
+     void updateStatus(const MonocleCameraStatus& status);
+     void resetStatus();
+     void raiseStatus();
+     void processCameras(JsonObject& cameras);
+     void processCameraEntry(JsonObject& camera);
+     void processConfig(JsonObject& config);
+     void sendTelemetry();
+
+     /* EVENT BUS SUBSCRIBER (PTZ AND MENU EVENTS) */
+     static void internal_gateway_event_handler(const MonocleEvent& event, void* context);
+
+     /* SCHEDULER TASK ENTRY POINT */
+     static void internal_gateway_task(void* context);
 
    public:
      /*
@@ -57,6 +273,10 @@ class MonocleGatewayClient
 
      /* CALLBACKS */
      void (*cameraCallback)(CameraSource& camera);
+     void (*presetsCallback)(CameraPreset* presets, const int count);
+     void (*statusCallback)(const MonocleCameraStatus& status);
+     void (*cameraListCallback)(const int count, const int from, const int to);
+     void (*cameraEntryCallback)(CameraListEntry& entry);
 
     /**
      * START THE CONNECTION TO THE
@@ -71,6 +291,13 @@ class MonocleGatewayClient
      */
      bool connected();
 
+    /**
+     * BOUND THE TIME 'begin()' WAITS FOR THE GATEWAY TO ANSWER THE
+     * WEB-SOCKET UPGRADE (MILLISECONDS); THE TCP CONNECT ITSELF IS
+     * BOUNDED BY THE NETWORK LIBRARY OF THE BOARD
+     */
+     void setConnectTimeout(const unsigned long milliseconds);
+
      /**
       * SEND INSTRUCTION TO MONOCLE GATEWAY FOR THE
       * ACTIVE CAMERA TO STOP ALL MOVEMENT IMMEDIATELY
@@ -172,6 +399,149 @@ class MonocleGatewayClient
       */
      void zoom(const int zoom);
 
+     /**
+      * QUEUE A PTZ MOVEMENT FOR A SPECIFIC CAMERA (BY UUID); A MOVEMENT
+      * THAT HAS NOT BEEN SENT YET IS REPLACED BY THE NEWER MOVEMENT.
+      * RETURNS 'false' IF THE COMMAND COULD NOT BE QUEUED
+      */
+     bool ptz(const char* uuid, const int pan, const int tilt, const int zoom);
+
+     /**
+      * QUEUE A STOP FOR A SPECIFIC CAMERA (BY UUID); A STOP IS
+      * NEVER DROPPED, IT REPLACES ANY QUEUED COMMANDS INSTEAD.
+      * RETURNS 'false' IF THE COMMAND COULD NOT BE QUEUED
+      */
+     bool stop(const char* uuid);
+
+     /**
+      * QUEUE A HOME POSITION RECALL FOR A SPECIFIC CAMERA (BY UUID).
+      * RETURNS 'false' IF THE COMMAND COULD NOT BE QUEUED
+      */
+     bool home(const char* uuid);
+
+     /**
+      * QUEUE A PRESET RECALL FOR A SPECIFIC CAMERA (BY UUID).
+      * RETURNS 'false' IF THE COMMAND COULD NOT BE QUEUED
+      */
+     bool preset(const char* uuid, const int preset);
+
+     /**
+      * GET THE SESSION (QUEUE AND LAST KNOWN STATE) OF A CAMERA
+      * ADDRESSED BY UUID; RETURNS NULL IF THE CAMERA HAS NO SESSION
+      */
+     const MonocleCameraSession* session(const char* uuid);
+
+     /**
+      * RELEASE THE SESSION OF A CAMERA; QUEUED COMMANDS ARE DISCARDED
+      */
+     void closeSession(const char* uuid);
+
+     /**
+      * GET THE NUMBER OF QUEUED COMMANDS ACROSS ALL CAMERA SESSIONS
+      */
+     int pending();
+
+     /**
+      * KEEP (true) OR DISCARD (false, DEFAULT) THE QUEUED SESSION COMMANDS
+      * WHEN THE CONNECTION IS LOST; A GATEWAY POOL HOLDS THEM UNTIL THEY
+      * ARE HANDED OVER TO ANOTHER ENDPOINT OR THE CONNECTION RETURNS
+      */
+     void holdSessions(const bool hold);
+
+     /**
+      * MOVE ALL QUEUED SESSION COMMANDS TO ANOTHER GATEWAY CLIENT (FAILOVER);
+      * CAMERAS SENT A PTZ OR STOP ARE SENT A STOP BEFORE ANY HANDED OVER
+      * COMMAND (A STOP WRITTEN TO A FAILED CONNECTION MAY HAVE BEEN LOST).
+      * RETURNS THE NUMBER OF COMMANDS QUEUED ON THE TARGET
+      */
+     int handover(MonocleGatewayClient& target);
+
+     /**
+      * SEND A HEARTBEAT (WEB-SOCKET PING) TO THE MONOCLE GATEWAY; THE
+      * ROUND TRIP TIME IS MEASURED WHEN THE PONG IS RECEIVED.
+      * RETURNS 'false' IF NOT CONNECTED
+      */
+     bool heartbeat();
+
+     /**
+      * DETERMINE IF A HEARTBEAT IS WAITING FOR ITS PONG
+      */
+     bool heartbeatPending();
+
+     /**
+      * GET THE TIME (MILLISECONDS) SINCE THE LAST HEARTBEAT WAS SENT
+      */
+     unsigned long heartbeatAge();
+
+     /**
+      * GET THE LAST MEASURED HEARTBEAT ROUND TRIP TIME (MILLISECONDS)
+      */
+     unsigned long roundTripTime();
+
+     /**
+      * SUBSCRIBE TO ACTIVE CAMERA STATUS PUSHES (POSITION AND MOVING FLAG)
+      * AT THE GIVEN INTERVAL; THE SUBSCRIPTION IS RENEWED ON RECONNECT.
+      * RETURNS 'false' IF NOT CONNECTED (THE SUBSCRIPTION IS SENT ON CONNECT)
+      */
+     bool subscribeStatus(unsigned int interval = MONOCLE_GATEWAY_STATUS_INTERVAL);
+
+     /**
+      * CANCEL THE CAMERA STATUS SUBSCRIPTION
+      */
+     void unsubscribeStatus();
+
+     /**
+      * DEFINE THE POSITION CHANGE AND MINIMUM INTERVAL (MILLISECONDS)
+      * REQUIRED BEFORE A STATUS CHANGE CALLBACK IS RAISED (A CHANGE OF
+      * THE MOVING FLAG IS ALWAYS REPORTED, SUBJECT TO THE INTERVAL)
+      */
+     void setStatusFilter(float delta, unsigned int minInterval);
+
+     /**
+      * GET THE LOCAL MIRROR OF THE ACTIVE CAMERA STATUS
+      */
+     const MonocleCameraStatus& status();
+
+     /**
+      * GET THE TIME (MILLISECONDS) SINCE THE LAST STATUS WAS RECEIVED
+      * (0xFFFFFFFF IF NO STATUS WAS RECEIVED FOR THE ACTIVE CAMERA)
+      */
+     unsigned long statusAge();
+
+     /**
+      * DETERMINE IF THE STATUS MIRROR IS OUT OF DATE (NO STATUS RECEIVED
+      * FOR MONOCLE_GATEWAY_STATUS_STALE_FACTOR SUBSCRIPTION INTERVALS)
+      */
+     bool isStatusStale();
+
+     /**
+      * SUBSCRIBE TO GATEWAY CAMERA LIST CHANGES; THE GATEWAY PUSHES THE
+      * CAMERA COUNT AND THE RANGE OF ROWS THAT CHANGED (ADDED, REMOVED OR
+      * RENAMED CAMERAS) AND THE ROWS OF INTEREST ARE THEN REQUESTED WITH
+      * 'requestCameras()'.  THE SUBSCRIPTION IS RENEWED ON RECONNECT.
+      * RETURNS 'false' IF NOT CONNECTED (THE SUBSCRIPTION IS SENT ON CONNECT)
+      */
+     bool subscribeCameras();
+
+     /**
+      * CANCEL THE CAMERA LIST SUBSCRIPTION
+      */
+     void unsubscribeCameras();
+
+     /**
+      * REQUEST A PAGE OF CAMERA LIST ROWS (AT MOST MONOCLE_GATEWAY_CAMERA_PAGE);
+      * EACH ROW IS DELIVERED TO THE CAMERA ENTRY CALLBACK.
+      * RETURNS 'false' IF NOT CONNECTED
+      */
+     bool requestCameras(const int offset, const int count);
+
+     /**
+      * SEND INSTRUCTION TO MONOCLE GATEWAY TO SWITCH THE ACTIVE CAMERA;
+      * THE GATEWAY ANSWERS WITH A NEW 'source' MESSAGE.
+      * RETURNS 'false' IF NOT CONNECTED
+      */
+     bool selectCamera(const char* uuid);
+
      /**
       * SEND RAW COMMAND (STRING) TO MONOCLE GATEWAY
       */
@@ -189,16 +559,98 @@ class MonocleGatewayClient
       */
      void loop();
 
+     /**
+      * REGISTER THIS CLIENT AS A TASK OF A SCHEDULER (REPLACES
+      * CALLING 'loop()' FROM THE PROGRAM MAIN LOOP).
+      * RETURNS THE TASK ID OR MONOCLE_TASK_INVALID
+      */
+     int schedule(MonocleScheduler& scheduler);
+
      /**
       * REGISTERS A CALLBACK FUNCTION POINTER FOR CAMERA SOURCE CHANGES
       */
      void onCameraChange(void (*cameraCallback)(CameraSource& camera));
 
+     /**
+      * REGISTERS A CALLBACK FUNCTION POINTER FOR THE PRESET LIST
+      * PROVIDED BY THE GATEWAY FOR THE ACTIVE CAMERA
+      * (preset names are only valid for the duration of the callback)
+      */
+     void onPresets(void (*presetsCallback)(CameraPreset* presets, const int count));
+
+     /**
+      * REGISTERS A CALLBACK FUNCTION POINTER FOR ACTIVE CAMERA STATUS CHANGES
+      * (RATE LIMITED AND DELTA FILTERED; SEE 'setStatusFilter()')
+      */
+     void onStatus(void (*statusCallback)(const MonocleCameraStatus& status));
+
+     /**
+      * REGISTERS A CALLBACK FUNCTION POINTER FOR CAMERA LIST CHANGES
+      * (THE CAMERA COUNT AND THE RANGE OF CHANGED ROWS 'from' .. 'to')
+      */
+     void onCameraList(void (*cameraListCallback)(const int count, const int from, const int to));
+
+     /**
+      * REGISTERS A CALLBACK FUNCTION POINTER FOR REQUESTED CAMERA LIST ROWS
+      * (entry text is only valid for the duration of the callback)
+      */
+     void onCameraEntry(void (*cameraEntryCallback)(CameraListEntry& entry));
+
+     /**
+      * PUBLISH CAMERA CHANGE AND GATEWAY LINK STATE EVENTS TO AN EVENT BUS
+      * (the camera source in the event remains owned by this client)
+      */
+     void publishTo(MonocleEventBus* bus);
+
+     /**
+      * SUBSCRIBE TO PTZ AND MENU EVENTS ON AN EVENT BUS AND FORWARD
+      * THEM AS COMMANDS TO THE MONOCLE GATEWAY (PTZ, HOME, PRESET AND
+      * CAMERA SELECTION)
+      */
+     bool subscribeTo(MonocleEventBus* bus);
+
+     /**
+      * RECORD THE OUTBOUND PTZ, STOP, HOME AND PRESET COMMANDS
+      * (ACTIVE CAMERA AND CAMERA SESSIONS) TO A SESSION RECORDER
+      */
+     void recordTo(MonocleRecorder* recorder);
+
+     /**
+      * FILTER THE ACTIVE CAMERA PTZ, PAN, TILT AND ZOOM COMMANDS THROUGH
+      * A FENCE (SEE 'MonocleFence::begin()'); WITH A FENCE THE SINGLE
+      * AXIS COMMANDS ARE SENT AS FULL PTZ VECTORS
+      */
+     void fenceWith(MonocleFence* fence);
+
+     /**
+      * ACCEPT 'config' MESSAGES FROM THE GATEWAY ({"config":{"name":value,...}})
+      * AND APPLY THEM TO A RUNTIME CONFIGURATION; EACH MESSAGE IS ANSWERED
+      * WITH 'CONFIG:OK' OR 'CONFIG:ERROR:<name>' (FIELDS BEFORE THE FAILED
+      * ONE ARE APPLIED).  SET BY 'MonocleConfig::attach()'
+      */
+     void configureWith(MonocleConfig* config);
+
+     /**
+      * REPORT CONNECTIONS, COMMANDS SENT (AND THEIR SEND TIME), MESSAGES
+      * RECEIVED AND HEARTBEAT ROUND TRIP TIMES TO A TELEMETRY COLLECTOR
+      * AND SEND ITS FRAMES TO THE GATEWAY AT THE TELEMETRY INTERVAL
+      * (A FRAME WAITS WHILE CAMERA COMMANDS ARE QUEUED OR WERE JUST SENT)
+      */
+     void reportTo(MonocleTelemetry* telemetry);
+
      /**
       * GET THE ACTIVE CAMERA SOURCE
       */
      CameraSource activeCameraSource();
 
+     /**
+      * RESTORE A PREVIOUSLY SAVED ACTIVE CAMERA SOURCE (E.G. AT BOOT
+      * BEFORE THE GATEWAY IS CONNECTED); THE TEXT VALUES ARE COPIED
+      * AND THE CAMERA CHANGE CALLBACK AND EVENT ARE RAISED.  THE
+      * GATEWAY'S NEXT 'source' MESSAGE REPLACES THE RESTORED CAMERA
+      */
+     void restoreCamera(const CameraSource& camera);
+
      /**
       * GET THE ACTIVE CAMERA ENABLED STATE
       */
@@ -0,0 +1,399 @@
+/*
+ **********************************************************************
+ *             __  __  ___  _  _  ___   ___ _    ___
+ *            |  \/  |/ _ \| \| |/ _ \ / __| |  | __|
+ *            | |\/| | (_) | .` | (_) | (__| |__| _|
+ *            |_|  |_|\___/|_|\_|\___/ \___|____|___|
+ *
+ * -------------------------------------------------------------------
+ *                     MONOCLE GATEWAY POOL
+ * -------------------------------------------------------------------
+ *
+ *  This library provides failover between multiple Monocle Gateway
+ *  services.  Each gateway endpoint is a 'MonocleGatewayClient' with
+ *  its own network client.  The pool health checks every connected
+ *  endpoint with web-socket heartbeats, sends commands through the
+ *  healthy endpoint with the lowest round trip time and fails over
+ *  to the next best endpoint when the active one disconnects or
+ *  stops answering heartbeats.  Queued camera commands (including
+ *  pending STOP commands) are handed over to the new endpoint and
+ *  the active camera movement is restored on the new endpoint.
+ *
+ *  Author:   Robert Savage
+ *  Date:     2018-02-18
+ *  Website:  http://monoclecam.com
+ *
+ * -------------------------------------------------------------------
+ *        COPYRIGHT SHADEBLUE, LLC @ 2018, ALL RIGHTS RESERVED
+ * -------------------------------------------------------------------
+ *
+ **********************************************************************
+ */
+
+#include "Arduino.h"
+#include "MonocleGatewayPool.h"
+
+/**
+ * Default Constructor
+ */
+MonocleGatewayPool::MonocleGatewayPool() {
+  // initialize callbacks
+  failoverCallback = NULL;
+}
+
+/**
+ * ADD A GATEWAY ENDPOINT (EACH CLIENT NEEDS ITS OWN NETWORK CLIENT);
+ * THE CLIENT HOLDS ITS QUEUED COMMANDS ON DISCONNECT FOR THE HANDOVER.
+ * RETURNS 'false' IF THE POOL IS FULL
+ */
+bool MonocleGatewayPool::add(MonocleGatewayClient& gateway){
+  if(count >= MONOCLE_POOL_MAX_GATEWAYS) return false;
+  gateway.holdSessions(true);
+  gateway.setConnectTimeout(MONOCLE_POOL_CONNECT_TIMEOUT);
+  Endpoint& endpoint = endpoints[count++];
+  endpoint.client = &gateway;
+  endpoint.healthy = false;
+  endpoint.awaiting = false;
+  endpoint.rtt = 0;
+  endpoint.connectTime = millis();
+  return true;
+}
+
+/**
+ * START THE CONNECTIONS TO ALL GATEWAY ENDPOINTS
+ * AND SELECT THE ACTIVE ENDPOINT
+ */
+void MonocleGatewayPool::begin(){
+  unsigned long now = millis();
+  for(int index = 0; index < count; index++){
+    Endpoint& endpoint = endpoints[index];
+    endpoint.client->begin();
+    endpoint.connectTime = now;
+
+    // connected endpoints are healthy until a heartbeat proves otherwise;
+    // the first measured round trip replaces the unknown (worst) value
+    endpoint.healthy = endpoint.client->connected();
+    endpoint.awaiting = false;
+    endpoint.rtt = (unsigned long)-1;
+  }
+  heartbeatTimer = now - MONOCLE_POOL_HEARTBEAT_INTERVAL;
+  activate(selectEndpoint());
+}
+
+/**
+ * DETERMINE IF AN ACTIVE GATEWAY ENDPOINT IS CONNECTED
+ */
+bool MonocleGatewayPool::connected(){
+  return available() != NULL;
+}
+
+/**
+ * GET THE ACTIVE GATEWAY CLIENT (NULL IF NONE IS AVAILABLE)
+ */
+MonocleGatewayClient* MonocleGatewayPool::active(){
+  return available();
+}
+
+/**
+ * GET THE INDEX OF THE ACTIVE GATEWAY ENDPOINT (OR MONOCLE_POOL_NONE)
+ */
+int MonocleGatewayPool::activeGateway(){
+  return activeIndex;
+}
+
+/**
+ * DETERMINE IF A GATEWAY ENDPOINT PASSED ITS LAST HEALTH CHECK
+ */
+bool MonocleGatewayPool::isHealthy(const int index){
+  if(index < 0 || index >= count) return false;
+  return endpoints[index].healthy;
+}
+
+/**
+ * GET THE SMOOTHED HEARTBEAT ROUND TRIP TIME OF A GATEWAY ENDPOINT
+ */
+unsigned long MonocleGatewayPool::roundTripTime(const int index){
+  if(index < 0 || index >= count) return 0;
+  return endpoints[index].rtt;
+}
+
+/**
+ * GET THE NUMBER OF TIMES THE ACTIVE GATEWAY ENDPOINT CHANGED
+ */
+unsigned long MonocleGatewayPool::failovers(){
+  return failoverCount;
+}
+
+/**
+ * REGISTERS A CALLBACK FUNCTION POINTER FOR ACTIVE ENDPOINT CHANGES
+ * (THE PREVIOUS INDEX IS MONOCLE_POOL_NONE FOR THE FIRST SELECTION)
+ */
+void MonocleGatewayPool::onFailover(void (*failoverCallback)(const int from, const int to)){
+  this->failoverCallback = failoverCallback;
+}
+
+/**
+ * GET THE ACTIVE GATEWAY CLIENT IF IT IS CONNECTED
+ */
+MonocleGatewayClient* MonocleGatewayPool::available(){
+  if(activeIndex == MONOCLE_POOL_NONE) return NULL;
+  MonocleGatewayClient* client = endpoints[activeIndex].client;
+  if(!client->connected()) return NULL;
+  return client;
+}
+
+/**
+ * THE ACTIVE GATEWAY CLIENT WHETHER CONNECTED OR NOT; A DROPPED CLIENT
+ * HOLDS ITS CAMERA SESSIONS UNTIL THEY ARE HANDED OVER ON FAILOVER
+ */
+MonocleGatewayClient* MonocleGatewayPool::sessions(){
+  if(activeIndex == MONOCLE_POOL_NONE) return NULL;
+  return endpoints[activeIndex].client;
+}
+
+/**
+ * ACTIVE CAMERA COMMANDS SENT THROUGH THE ACTIVE GATEWAY ENDPOINT
+ * (A STOP ISSUED WHILE NO ENDPOINT IS AVAILABLE IS KEPT AND SENT
+ * AS SOON AS AN ENDPOINT BECOMES AVAILABLE).
+ * RETURN 'false' IF NO ENDPOINT IS AVAILABLE
+ */
+bool MonocleGatewayPool::ptz(const int pan, const int tilt, const int zoom){
+  if(pan == 0 && tilt == 0 && zoom == 0) return stop();
+  MonocleGatewayClient* client = available();
+  if(client == NULL) return false;
+  client->ptz(pan, tilt, zoom);
+  this->pan = pan;
+  this->tilt = tilt;
+  this->zoom = zoom;
+  moving = true;
+  stopPending = false;
+  return true;
+}
+bool MonocleGatewayPool::stop(){
+  MonocleGatewayClient* client = available();
+  moving = false;
+  if(client == NULL){
+    stopPending = true;
+    return false;
+  }
+  client->stop();
+
+  // a STOP sent through a stalled endpoint is repeated after the failover
+  stopPending = !endpoints[activeIndex].healthy;
+  return true;
+}
+bool MonocleGatewayPool::home(){
+  MonocleGatewayClient* client = available();
+  if(client == NULL) return false;
+  client->home();
+  return true;
+}
+bool MonocleGatewayPool::preset(const int preset){
+  MonocleGatewayClient* client = available();
+  if(client == NULL) return false;
+  client->preset(preset);
+  return true;
+}
+
+/**
+ * CAMERA COMMANDS ADDRESSED BY UUID; QUEUED ON THE ACTIVE ENDPOINT
+ * (EVEN WHILE IT IS DISCONNECTED) AND HANDED OVER ON FAILOVER.
+ * RETURN 'false' IF THE COMMAND COULD NOT BE QUEUED
+ */
+bool MonocleGatewayPool::ptz(const char* uuid, const int pan, const int tilt, const int zoom){
+  MonocleGatewayClient* client = sessions();
+  if(client == NULL) return false;
+  return client->ptz(uuid, pan, tilt, zoom);
+}
+bool MonocleGatewayPool::stop(const char* uuid){
+  MonocleGatewayClient* client = sessions();
+  if(client == NULL) return false;
+  return client->stop(uuid);
+}
+bool MonocleGatewayPool::home(const char* uuid){
+  MonocleGatewayClient* client = sessions();
+  if(client == NULL) return false;
+  return client->home(uuid);
+}
+bool MonocleGatewayPool::preset(const char* uuid, const int preset){
+  MonocleGatewayClient* client = sessions();
+  if(client == NULL) return false;
+  return client->preset(uuid, preset);
+}
+
+/**
+ * UPDATE THE HEALTH OF A GATEWAY ENDPOINT FROM ITS CONNECTION
+ * AND HEARTBEAT STATE (DISCONNECTED ENDPOINTS ARE RETRIED BY 'reconnect()')
+ */
+void MonocleGatewayPool::checkHealth(Endpoint& endpoint, unsigned long now){
+  MonocleGatewayClient* client = endpoint.client;
+
+  if(!client->connected()){
+    endpoint.healthy = false;
+    endpoint.awaiting = false;
+    return;
+  }
+
+  if(!endpoint.awaiting) return;
+
+  // pong received; smooth the round trip time (first sample replaces the unknown value)
+  if(!client->heartbeatPending()){
+    unsigned long sample = client->roundTripTime();
+    if(endpoint.rtt == (unsigned long)-1) endpoint.rtt = sample;
+    else endpoint.rtt = (endpoint.rtt * 3 + sample) / 4;
+    endpoint.healthy = true;
+    endpoint.awaiting = false;
+    return;
+  }
+
+  // no pong within the timeout; the endpoint is unhealthy (the heartbeat
+  // keeps being repeated so the endpoint recovers once it answers again)
+  if(client->heartbeatAge() > MONOCLE_POOL_HEARTBEAT_TIMEOUT){
+    endpoint.healthy = false;
+  }
+}
+
+/**
+ * DETERMINE IF A DISCONNECTED ENDPOINT IS DUE FOR A RECONNECT; A CONNECT
+ * ATTEMPT BLOCKS, SO NONE IS MADE WHILE THE ACTIVE ENDPOINT HAS COMMANDS WAITING
+ */
+bool MonocleGatewayPool::reconnectDue(unsigned long now){
+  MonocleGatewayClient* client = available();
+  if(stopPending || (client != NULL && client->pending() > 0)) return false;
+
+  for(int index = 0; index < count; index++){
+    Endpoint& endpoint = endpoints[index];
+    if(!endpoint.client->connected() && (now - endpoint.connectTime) >= MONOCLE_POOL_RECONNECT_INTERVAL) return true;
+  }
+  return false;
+}
+
+/**
+ * RECONNECT ONE DUE ENDPOINT (ROUND-ROBIN SO EVERY ENDPOINT GETS ITS TURN);
+ * THE WAIT FOR THE GATEWAY IS BOUNDED BY MONOCLE_POOL_CONNECT_TIMEOUT
+ */
+void MonocleGatewayPool::reconnect(unsigned long now){
+  for(int offset = 0; offset < count; offset++){
+    int index = (reconnectIndex + offset) % count;
+    Endpoint& endpoint = endpoints[index];
+    if(endpoint.client->connected() || (now - endpoint.connectTime) < MONOCLE_POOL_RECONNECT_INTERVAL) continue;
+
+    reconnectIndex = (index + 1) % count;
+    endpoint.client->begin();
+    endpoint.connectTime = millis();
+    if(endpoint.client->connected()) endpoint.rtt = (unsigned long)-1;
+    return;
+  }
+}
+
+/**
+ * SELECT THE HEALTHY ENDPOINT WITH THE LOWEST ROUND TRIP TIME; THE ACTIVE
+ * ENDPOINT IS KEPT UNLESS ANOTHER IS FASTER BY MORE THAN THE SWITCH MARGIN
+ */
+int MonocleGatewayPool::selectEndpoint(){
+  int best = MONOCLE_POOL_NONE;
+  for(int index = 0; index < count; index++){
+    if(!endpoints[index].healthy) continue;
+    if(best == MONOCLE_POOL_NONE || endpoints[index].rtt < endpoints[best].rtt) best = index;
+  }
+
+  if(activeIndex != MONOCLE_POOL_NONE && endpoints[activeIndex].healthy && best != MONOCLE_POOL_NONE){
+    unsigned long current = endpoints[activeIndex].rtt;
+    if(current == (unsigned long)-1 || endpoints[best].rtt + MONOCLE_POOL_SWITCH_MARGIN >= current){
+      return activeIndex;
+    }
+  }
+  return best;
+}
+
+/**
+ * MAKE A GATEWAY ENDPOINT ACTIVE; QUEUED CAMERA COMMANDS ARE HANDED
+ * OVER FROM THE PREVIOUS ENDPOINT AND THE ACTIVE CAMERA MOVEMENT IS RESTORED
+ */
+void MonocleGatewayPool::activate(const int index){
+  if(index == activeIndex || index == MONOCLE_POOL_NONE) return;
+  int previous = activeIndex;
+  MonocleGatewayClient* client = endpoints[index].client;
+
+  // continue a held movement on the new endpoint; a STOP that could not
+  // be sent (or may have been lost by a failed endpoint) is delivered again
+  bool failed = (previous != MONOCLE_POOL_NONE && !endpoints[previous].healthy);
+  if(moving){
+    client->ptz(pan, tilt, zoom);
+  }
+  else if(stopPending || failed){
+    client->stop();
+    stopPending = false;
+  }
+
+  if(previous != MONOCLE_POOL_NONE){
+    endpoints[previous].client->handover(*client);
+    failoverCount++;
+  }
+  activeIndex = index;
+
+  // notify failover listener
+  if(failoverCallback != NULL) failoverCallback(previous, index);
+}
+
+/**
+ * SCHEDULER TASK ENTRY POINT
+ */
+void MonocleGatewayPool::internal_pool_task(void* context){
+  ((MonocleGatewayPool*)context)->loop();
+}
+
+/**
+ * REGISTER THIS POOL AS A TASK OF A SCHEDULER (REPLACES CALLING
+ * 'loop()' FROM THE PROGRAM MAIN LOOP); THE POOL SERVICES ALL
+ * OF ITS GATEWAY CLIENTS SO THEY MUST NOT BE SCHEDULED THEMSELVES.
+ * RETURNS THE TASK ID OR MONOCLE_TASK_INVALID
+ */
+int MonocleGatewayPool::schedule(MonocleScheduler& scheduler){
+  return scheduler.every(MONOCLE_POOL_TASK_INTERVAL, internal_pool_task, this, MONOCLE_POOL_TASK_BUDGET);
+}
+
+/**
+ * THIS METHOD MUST BE CALLED IN THE PROGRAM MAIN LOOP TO SERVICE
+ * ALL GATEWAY CLIENTS, HEALTH CHECK THEM AND FAIL OVER
+ */
+void MonocleGatewayPool::loop(){
+  unsigned long now = millis();
+
+  // a reconnect runs in a pass of its own so the blocking connect
+  // attempt never sits between servicing the active endpoint's commands
+  if(reconnectPass){
+    reconnectPass = false;
+    reconnect(now);
+    return;
+  }
+
+  // a dropped active endpoint must hand over its queued commands before
+  // its own loop discards them, so fail over ahead of servicing the clients
+  if(activeIndex != MONOCLE_POOL_NONE && !endpoints[activeIndex].client->connected()){
+    endpoints[activeIndex].healthy = false;
+    activate(selectEndpoint());
+  }
+
+  // service every gateway client and evaluate its health
+  for(int index = 0; index < count; index++){
+    endpoints[index].client->loop();
+    checkHealth(endpoints[index], now);
+  }
+
+  // send heartbeats to all connected endpoints
+  if((now - heartbeatTimer) >= MONOCLE_POOL_HEARTBEAT_INTERVAL){
+    heartbeatTimer = now;
+    for(int index = 0; index < count; index++){
+      Endpoint& endpoint = endpoints[index];
+      if(endpoint.awaiting && endpoint.client->heartbeatAge() <= MONOCLE_POOL_HEARTBEAT_TIMEOUT) continue;
+      if(endpoint.client->heartbeat()) endpoint.awaiting = true;
+    }
+  }
+
+  // prefer the healthy endpoint with the lowest round trip time
+  activate(selectEndpoint());
+
+  // retry a disconnected endpoint on the next pass
+  reconnectPass = reconnectDue(now);
+}
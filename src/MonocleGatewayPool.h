@@ -0,0 +1,213 @@
+/*
+ **********************************************************************
+ *             __  __  ___  _  _  ___   ___ _    ___
+ *            |  \/  |/ _ \| \| |/ _ \ / __| |  | __|
+ *            | |\/| | (_) | .` | (_) | (__| |__| _|
+ *            |_|  |_|\___/|_|\_|\___/ \___|____|___|
+ *
+ * -------------------------------------------------------------------
+ *                     MONOCLE GATEWAY POOL
+ * -------------------------------------------------------------------
+ *
+ *  This library provides failover between multiple Monocle Gateway
+ *  services.  Each gateway endpoint is a 'MonocleGatewayClient' with
+ *  its own network client.  The pool health checks every connected
+ *  endpoint with web-socket heartbeats, sends commands through the
+ *  healthy endpoint with the lowest round trip time and fails over
+ *  to the next best endpoint when the active one disconnects or
+ *  stops answering heartbeats.  Queued camera commands (including
+ *  pending STOP commands) are handed over to the new endpoint and
+ *  the active camera movement is restored on the new endpoint.
+ *
+ *  Author:   Robert Savage
+ *  Date:     2018-02-18
+ *  Website:  http://monoclecam.com
+ *
+ * -------------------------------------------------------------------
+ *        COPYRIGHT SHADEBLUE, LLC @ 2018, ALL RIGHTS RESERVED
+ * -------------------------------------------------------------------
+ *
+ **********************************************************************
+ */
+#ifndef MONOCLE_GATEWAY_POOL_H
+#define MONOCLE_GATEWAY_POOL_H
+
+#include <Arduino.h>
+#include "MonocleGatewayClient.h"
+#include "MonocleScheduler.h"
+
+/* MAXIMUM NUMBER OF GATEWAY ENDPOINTS */
+#ifndef MONOCLE_POOL_MAX_GATEWAYS
+#define MONOCLE_POOL_MAX_GATEWAYS 3
+#endif
+
+/* HEALTH CHECK TIMING (HEARTBEAT INTERVAL + TIMEOUT BOUNDS THE FAILOVER TIME) */
+#ifndef MONOCLE_POOL_HEARTBEAT_INTERVAL
+#define MONOCLE_POOL_HEARTBEAT_INTERVAL 200    // milliseconds
+#endif
+#ifndef MONOCLE_POOL_HEARTBEAT_TIMEOUT
+#define MONOCLE_POOL_HEARTBEAT_TIMEOUT  400    // milliseconds without a pong
+#endif
+#ifndef MONOCLE_POOL_RECONNECT_INTERVAL
+#define MONOCLE_POOL_RECONNECT_INTERVAL 5000   // milliseconds
+#endif
+
+/* TIME A RECONNECT WAITS FOR THE WEB-SOCKET UPGRADE; RECONNECTS BLOCK THE
+   LOOP, SO ONLY ONE ENDPOINT IS RETRIED PER PASS AND NEVER IN A PASS THAT
+   SERVICES THE ACTIVE ENDPOINT OR WHILE IT HAS COMMANDS WAITING */
+#ifndef MONOCLE_POOL_CONNECT_TIMEOUT
+#define MONOCLE_POOL_CONNECT_TIMEOUT    250    // milliseconds
+#endif
+
+/* ROUND TRIP ADVANTAGE REQUIRED BEFORE MOVING TO A FASTER HEALTHY ENDPOINT */
+#ifndef MONOCLE_POOL_SWITCH_MARGIN
+#define MONOCLE_POOL_SWITCH_MARGIN 20          // milliseconds
+#endif
+
+/* SCHEDULER TASK INTERVAL AND EXECUTION BUDGET */
+#ifndef MONOCLE_POOL_TASK_INTERVAL
+#define MONOCLE_POOL_TASK_INTERVAL 10          // milliseconds
+#endif
+#ifndef MONOCLE_POOL_TASK_BUDGET
+#define MONOCLE_POOL_TASK_BUDGET   30000       // microseconds
+#endif
+
+/* NO ACTIVE GATEWAY ENDPOINT */
+#define MONOCLE_POOL_NONE -1
+
+class MonocleGatewayPool
+{
+   private:
+     struct Endpoint {
+       MonocleGatewayClient* client;
+       bool healthy;
+       bool awaiting;                // heartbeat sent; waiting for the pong
+       unsigned long rtt;            // smoothed round trip time (milliseconds)
+       unsigned long connectTime;    // last connection attempt
+     };
+
+     /* GATEWAY ENDPOINTS */
+     Endpoint endpoints[MONOCLE_POOL_MAX_GATEWAYS];
+     uint8_t count = 0;
+     int activeIndex = MONOCLE_POOL_NONE;
+     unsigned long heartbeatTimer = 0;
+
+     /* RECONNECT PASSES (ROUND-ROBIN OVER THE DISCONNECTED ENDPOINTS) */
+     bool reconnectPass = false;
+     uint8_t reconnectIndex = 0;
+
+     /* ACTIVE CAMERA MOVEMENT STATE (RESTORED ON THE NEW ENDPOINT AFTER A FAILOVER) */
+     bool moving = false;
+     bool stopPending = false;
+     int pan = 0, tilt = 0, zoom = 0;
+
+     /* STATISTICS */
+     unsigned long failoverCount = 0;
+
+     /* CALLBACKS */
+     void (*failoverCallback)(const int from, const int to);
+
+     /* INTERNAL PROCESSING */
+     void checkHealth(Endpoint& endpoint, unsigned long now);
+     bool reconnectDue(unsigned long now);
+     void reconnect(unsigned long now);
+     int selectEndpoint();
+     void activate(const int index);
+     MonocleGatewayClient* available();
+     MonocleGatewayClient* sessions();
+
+     /* SCHEDULER TASK ENTRY POINT */
+     static void internal_pool_task(void* context);
+
+   public:
+    /**
+     * Default Constructor
+     */
+     MonocleGatewayPool();
+
+     /**
+      * ADD A GATEWAY ENDPOINT (EACH CLIENT NEEDS ITS OWN NETWORK CLIENT);
+      * THE CLIENT HOLDS ITS QUEUED COMMANDS ON DISCONNECT FOR THE HANDOVER.
+      * RETURNS 'false' IF THE POOL IS FULL
+      */
+     bool add(MonocleGatewayClient& gateway);
+
+     /**
+      * START THE CONNECTIONS TO ALL GATEWAY ENDPOINTS
+      * AND SELECT THE ACTIVE ENDPOINT
+      */
+     void begin();
+
+     /**
+      * DETERMINE IF AN ACTIVE GATEWAY ENDPOINT IS CONNECTED
+      */
+     bool connected();
+
+     /**
+      * GET THE ACTIVE GATEWAY CLIENT (NULL IF NONE IS AVAILABLE)
+      */
+     MonocleGatewayClient* active();
+
+     /**
+      * GET THE INDEX OF THE ACTIVE GATEWAY ENDPOINT (OR MONOCLE_POOL_NONE)
+      */
+     int activeGateway();
+
+     /**
+      * DETERMINE IF A GATEWAY ENDPOINT PASSED ITS LAST HEALTH CHECK
+      */
+     bool isHealthy(const int index);
+
+     /**
+      * GET THE SMOOTHED HEARTBEAT ROUND TRIP TIME OF A GATEWAY ENDPOINT
+      */
+     unsigned long roundTripTime(const int index);
+
+     /**
+      * GET THE NUMBER OF TIMES THE ACTIVE GATEWAY ENDPOINT CHANGED
+      */
+     unsigned long failovers();
+
+     /**
+      * REGISTERS A CALLBACK FUNCTION POINTER FOR ACTIVE ENDPOINT CHANGES
+      * (THE PREVIOUS INDEX IS MONOCLE_POOL_NONE FOR THE FIRST SELECTION)
+      */
+     void onFailover(void (*failoverCallback)(const int from, const int to));
+
+     /**
+      * ACTIVE CAMERA COMMANDS SENT THROUGH THE ACTIVE GATEWAY ENDPOINT
+      * (A STOP ISSUED WHILE NO ENDPOINT IS AVAILABLE IS KEPT AND SENT
+      * AS SOON AS AN ENDPOINT BECOMES AVAILABLE).
+      * RETURN 'false' IF NO ENDPOINT IS AVAILABLE
+      */
+     bool ptz(const int pan, const int tilt, const int zoom);
+     bool stop();
+     bool home();
+     bool preset(const int preset);
+
+     /**
+      * CAMERA COMMANDS ADDRESSED BY UUID; QUEUED ON THE ACTIVE ENDPOINT
+      * (EVEN WHILE IT IS DISCONNECTED) AND HANDED OVER ON FAILOVER.
+      * RETURN 'false' IF THE COMMAND COULD NOT BE QUEUED
+      */
+     bool ptz(const char* uuid, const int pan, const int tilt, const int zoom);
+     bool stop(const char* uuid);
+     bool home(const char* uuid);
+     bool preset(const char* uuid, const int preset);
+
+     /**
+      * REGISTER THIS POOL AS A TASK OF A SCHEDULER (REPLACES CALLING
+      * 'loop()' FROM THE PROGRAM MAIN LOOP); THE POOL SERVICES ALL
+      * OF ITS GATEWAY CLIENTS SO THEY MUST NOT BE SCHEDULED THEMSELVES.
+      * RETURNS THE TASK ID OR MONOCLE_TASK_INVALID
+      */
+     int schedule(MonocleScheduler& scheduler);
+
+     /**
+      * THIS METHOD MUST BE CALLED IN THE PROGRAM MAIN LOOP TO SERVICE
+      * ALL GATEWAY CLIENTS, HEALTH CHECK THEM AND FAIL OVER
+      */
+     void loop();
+};
+
+#endif //MONOCLE_GATEWAY_POOL_H
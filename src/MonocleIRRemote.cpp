@@ -0,0 +1,369 @@
+/*
+ **********************************************************************
+ *             __  __  ___  _  _  ___   ___ _    ___
+ *            |  \/  |/ _ \| \| |/ _ \ / __| |  | __|
+ *            | |\/| | (_) | .` | (_) | (__| |__| _|
+ *            |_|  |_|\___/|_|\_|\___/ \___|____|___|
+ *
+ * -------------------------------------------------------------------
+ *                     MONOCLE IR REMOTE
+ * -------------------------------------------------------------------
+ *
+ *  This library provides a command engine for infrared remote
+ *  controls.  Decoded IR codes (from any IR receiver library) are
+ *  mapped to PTZ, home and preset actions using a compact sorted
+ *  lookup table that can be loaded at runtime.  While a movement
+ *  button is held, the remote's repeat interval is measured so that
+ *  movement stops on the first missed repeat, and the hold duration
+ *  ramps the speed from LOW to MEDIUM to HIGH.
+ *
+ *  Author:   Robert Savage
+ *  Date:     2018-02-18
+ *  Website:  http://monoclecam.com
+ *
+ * -------------------------------------------------------------------
+ *        COPYRIGHT SHADEBLUE, LLC @ 2018, ALL RIGHTS RESERVED
+ * -------------------------------------------------------------------
+ *
+ **********************************************************************
+ */
+
+#include "Arduino.h"
+#include "MonocleIRRemote.h"
+#include "MonocleRecorder.h"
+
+/**
+ * Default Constructor
+ */
+MonocleIRRemote::MonocleIRRemote() {
+  // initialize callbacks
+  ptzCallback = NULL;
+  homeCallback = NULL;
+  presetCallback = NULL;
+  macroCallback = NULL;
+}
+
+/**
+ * BINARY SEARCH THE SORTED LOOKUP TABLE FOR A CODE;
+ * RETURNS THE TABLE INDEX OR -1 IF NOT FOUND
+ */
+int MonocleIRRemote::find(const uint32_t code){
+  int low = 0;
+  int high = count - 1;
+  while(low <= high){
+    int mid = (low + high) / 2;
+    if(codes[mid].code == code) return mid;
+    if(codes[mid].code < code) low = mid + 1;
+    else high = mid - 1;
+  }
+  return -1;
+}
+
+/**
+ * ADD (OR REPLACE) A CODE IN THE LOOKUP TABLE; THE TABLE IS KEPT
+ * SORTED BY CODE. RETURNS 'false' IF THE TABLE IS FULL
+ */
+bool MonocleIRRemote::addCode(const uint32_t code, const uint8_t action, const uint8_t value){
+  int index = find(code);
+  if(index < 0){
+    if(count >= MONOCLE_IR_MAX_CODES) return false;
+
+    // shift larger codes up to make room (insertion sort)
+    index = count;
+    while(index > 0 && codes[index - 1].code > code){
+      codes[index] = codes[index - 1];
+      index--;
+    }
+    count++;
+  }
+  codes[index].code = code;
+  codes[index].action = action;
+  codes[index].value = value;
+  return true;
+}
+
+/**
+ * REPLACE THE LOOKUP TABLE WITH A LIST OF CODES (IN ANY ORDER).
+ * RETURNS 'false' IF NOT ALL CODES FIT IN THE TABLE
+ */
+bool MonocleIRRemote::loadCodes(const MonocleIRCode* codes, const int count){
+  bool success = true;
+  clearCodes();
+  for(int index = 0; index < count; index++)
+    success &= addCode(codes[index].code, codes[index].action, codes[index].value);
+  return success;
+}
+
+/**
+ * REMOVE ALL CODES FROM THE LOOKUP TABLE
+ */
+void MonocleIRRemote::clearCodes(){
+  count = 0;
+}
+
+/**
+ * GET THE NUMBER OF CODES IN THE LOOKUP TABLE
+ */
+int MonocleIRRemote::codeCount(){
+  return count;
+}
+
+/**
+ * GET A CODE OF THE LOOKUP TABLE BY INDEX (0 .. 'codeCount()' - 1;
+ * MONOCLE_IR_NONE OUT OF RANGE)
+ */
+MonocleIRCode MonocleIRRemote::codeAt(const int index){
+  if(index < 0 || index >= count){
+    MonocleIRCode none = { 0, MONOCLE_IR_NONE, 0 };
+    return none;
+  }
+  return codes[index];
+}
+
+/**
+ * DEFINE THE CODE EMITTED BY THE REMOTE WHILE A BUTTON IS HELD
+ * (DEFAULT IS THE NEC REPEAT CODE 0xFFFFFFFF)
+ */
+void MonocleIRRemote::setRepeatCode(const uint32_t code){
+  repeatCode = code;
+}
+
+/**
+ * DEFINE HOW LATE (PERCENT OF THE MEASURED REPEAT INTERVAL) A
+ * REPEAT MAY ARRIVE BEFORE THE BUTTON IS CONSIDERED RELEASED
+ */
+void MonocleIRRemote::setRepeatTolerance(const uint8_t percent){
+  tolerance = percent;
+}
+
+/**
+ * DEFINE THE PTZ SPEED (1=LOW, 2=MEDIUM, 3=HIGH) USED WHEN
+ * HOLD-TO-ACCELERATE IS DISABLED
+ */
+void MonocleIRRemote::setSpeed(int speed){
+  this->speed = constrain(speed, MONOCLE_IR_SPEED_LOW, MONOCLE_IR_SPEED_HIGH);
+}
+
+/**
+ * ENABLE HOLD-TO-ACCELERATE; A HELD BUTTON STARTS AT LOW SPEED,
+ * MOVES TO MEDIUM AFTER 'medDelay' AND HIGH AFTER 'highDelay'
+ * MILLISECONDS. SET BOTH DELAYS TO ZERO TO DISABLE.
+ */
+void MonocleIRRemote::setAcceleration(unsigned int medDelay, unsigned int highDelay){
+  accelerateMedDelay = medDelay;
+  accelerateHighDelay = highDelay;
+}
+
+/**
+ * REGISTERS A CALLBACK FUNCTION POINTER FOR PTZ STATE CHANGE EVENTS
+ * (A STOP IS RAISED AS A PTZ EVENT WITH ALL AXIS SET TO ZERO)
+ */
+void MonocleIRRemote::onPTZ(void (*ptzCallback)(int, int, int)){
+  this->ptzCallback = ptzCallback;
+}
+
+/**
+ * REGISTERS A CALLBACK FUNCTION POINTER FOR HOME COMMANDS
+ */
+void MonocleIRRemote::onHome(void (*homeCallback)(void)){
+  this->homeCallback = homeCallback;
+}
+
+/**
+ * REGISTERS A CALLBACK FUNCTION POINTER FOR PRESET COMMANDS
+ */
+void MonocleIRRemote::onPreset(void (*presetCallback)(const int)){
+  this->presetCallback = presetCallback;
+}
+
+/**
+ * REGISTERS A CALLBACK FUNCTION POINTER FOR MACRO COMMANDS
+ */
+void MonocleIRRemote::onMacro(void (*macroCallback)(const int)){
+  this->macroCallback = macroCallback;
+}
+
+/**
+ * PUBLISH PTZ EVENTS TO AN EVENT BUS; HOME, PRESET AND MACRO COMMANDS
+ * ARE PUBLISHED AS THE EQUIVALENT MENU ACTIONS
+ */
+void MonocleIRRemote::publishTo(MonocleEventBus* bus){
+  this->bus = bus;
+}
+
+/**
+ * RECORD EVERY CODE PASSED TO 'process()' TO A SESSION RECORDER
+ */
+void MonocleIRRemote::recordTo(MonocleRecorder* recorder){
+  this->recorder = recorder;
+}
+
+/**
+ * GET THE MEASURED REPEAT INTERVAL (MILLISECONDS)
+ */
+unsigned int MonocleIRRemote::repeatInterval(){
+  return interval;
+}
+
+/**
+ * DETERMINE IF A MOVEMENT BUTTON IS CURRENTLY HELD
+ */
+bool MonocleIRRemote::isHolding(){
+  return holdAction != MONOCLE_IR_NONE;
+}
+
+/**
+ * GET THE SPEED FOR THE HELD BUTTON
+ */
+int MonocleIRRemote::rampSpeed(unsigned long now){
+  if(accelerateMedDelay == 0 && accelerateHighDelay == 0) return speed;
+
+  unsigned long held = now - holdTime;
+  if(accelerateHighDelay > 0 && held >= accelerateHighDelay) return MONOCLE_IR_SPEED_HIGH;
+  if(accelerateMedDelay > 0 && held >= accelerateMedDelay) return MONOCLE_IR_SPEED_MED;
+  return MONOCLE_IR_SPEED_LOW;
+}
+
+/**
+ * RAISE THE PTZ VECTOR FOR A MOVEMENT ACTION (OR STOP)
+ */
+void MonocleIRRemote::raisePTZ(const uint8_t action, const int speed){
+  int pan = 0, tilt = 0, zoom = 0;
+  switch(action){
+    case MONOCLE_IR_PAN_LEFT:  pan  = -speed; break;  // negative speed value means pan left
+    case MONOCLE_IR_PAN_RIGHT: pan  =  speed; break;  // positive speed value means pan right
+    case MONOCLE_IR_TILT_UP:   tilt =  speed; break;  // positive speed value means tilt up
+    case MONOCLE_IR_TILT_DOWN: tilt = -speed; break;  // negative speed value means tilt down
+    case MONOCLE_IR_ZOOM_IN:   zoom =  speed; break;  // positive speed value means zoom in
+    case MONOCLE_IR_ZOOM_OUT:  zoom = -speed; break;  // negative speed value means zoom out
+  }
+  if(ptzCallback != NULL) ptzCallback(pan, tilt, zoom);
+  if(bus != NULL) bus->publishPTZ(pan, tilt, zoom);
+}
+
+/**
+ * SMOOTH THE MEASURED REPEAT INTERVAL (GAP SINCE THE LAST FRAME),
+ * BOUNDED BY THE MINIMUM AND MAXIMUM REPEAT INTERVALS
+ */
+void MonocleIRRemote::measureRepeat(unsigned long now){
+  unsigned int gap = now - frameTime;
+  unsigned int smoothed = (interval * 3 + gap) / 4;
+  if(smoothed < MONOCLE_IR_MIN_REPEAT_INTERVAL) smoothed = MONOCLE_IR_MIN_REPEAT_INTERVAL;
+  if(smoothed > MONOCLE_IR_MAX_REPEAT_INTERVAL) smoothed = MONOCLE_IR_MAX_REPEAT_INTERVAL;
+  interval = smoothed;
+}
+
+/**
+ * END THE HELD MOVEMENT
+ */
+void MonocleIRRemote::stopHold(){
+  holdAction = MONOCLE_IR_NONE;
+  holdSpeed = 0;
+  raisePTZ(MONOCLE_IR_STOP, 0);
+}
+
+/**
+ * PROCESS A DECODED IR CODE (CALL FOR EVERY CODE RECEIVED)
+ */
+void MonocleIRRemote::process(const uint32_t code){
+  unsigned long now = millis();
+  if(recorder != NULL) recorder->record(MONOCLE_RECORD_IR, 0, (int32_t)code);
+
+  // repeat frames keep the held movement alive; consecutive repeats
+  // measure the remote's actual repeat interval (smoothed)
+  if(code == repeatCode){
+    if(holdAction == MONOCLE_IR_NONE) return;
+    if(repeating) measureRepeat(now);
+    repeating = true;
+    frameTime = now;
+    return;
+  }
+
+  int index = find(code);
+  if(index < 0) return;
+  uint8_t action = codes[index].action;
+
+  switch(action){
+    case MONOCLE_IR_PAN_LEFT:
+    case MONOCLE_IR_PAN_RIGHT:
+    case MONOCLE_IR_TILT_UP:
+    case MONOCLE_IR_TILT_DOWN:
+    case MONOCLE_IR_ZOOM_IN:
+    case MONOCLE_IR_ZOOM_OUT: {
+      // protocols without a repeat code resend the full code while held
+      // (every resend, including the first, measures the repeat interval)
+      if(action == holdAction){
+        measureRepeat(now);
+        repeating = true;
+        frameTime = now;
+        return;
+      }
+      holdAction = action;
+      holdTime = now;
+      frameTime = now;
+      repeating = false;
+      holdSpeed = rampSpeed(now);
+      raisePTZ(holdAction, holdSpeed);
+      break;
+    }
+    case MONOCLE_IR_STOP: {
+      stopHold();
+      break;
+    }
+    case MONOCLE_IR_HOME: {
+      if(homeCallback != NULL) homeCallback();
+      if(bus != NULL) bus->publishMenu(MONOCLE_MENU_EVENT_HOME);
+      break;
+    }
+    case MONOCLE_IR_PRESET: {
+      if(presetCallback != NULL) presetCallback(codes[index].value);
+      if(bus != NULL) bus->publishMenu(MONOCLE_MENU_EVENT_PRESET, codes[index].value);
+      break;
+    }
+    case MONOCLE_IR_MACRO: {
+      if(macroCallback != NULL) macroCallback(codes[index].value);
+      if(bus != NULL) bus->publishMenu(MONOCLE_MENU_EVENT_MACRO, codes[index].value);
+      break;
+    }
+  }
+}
+
+/**
+ * SCHEDULER TASK ENTRY POINT
+ */
+void MonocleIRRemote::internal_ir_remote_task(void* context){
+  ((MonocleIRRemote*)context)->loop();
+}
+
+/**
+ * REGISTER THIS REMOTE AS A TASK OF A SCHEDULER (REPLACES
+ * CALLING 'loop()' FROM THE PROGRAM MAIN LOOP); DECODED CODES
+ * MUST STILL BE PASSED TO 'process()'.
+ * RETURNS THE TASK ID OR MONOCLE_TASK_INVALID
+ */
+int MonocleIRRemote::schedule(MonocleScheduler& scheduler){
+  return scheduler.every(MONOCLE_IR_TASK_INTERVAL, internal_ir_remote_task, this, MONOCLE_IR_TASK_BUDGET);
+}
+
+/**
+ * THIS METHOD MUST BE CALLED IN THE PROGRAM MAIN LOOP
+ * TO DETECT RELEASED BUTTONS AND RAMP HELD SPEEDS
+ */
+void MonocleIRRemote::loop(){
+  if(holdAction == MONOCLE_IR_NONE) return;
+  unsigned long now = millis();
+
+  // the button is released as soon as the next repeat is overdue
+  unsigned long timeout = interval + ((unsigned long)interval * tolerance) / 100;
+  if(now - frameTime > timeout){
+    stopHold();
+    return;
+  }
+
+  // ramp the speed while the button is held
+  int rampedSpeed = rampSpeed(now);
+  if(rampedSpeed != holdSpeed){
+    holdSpeed = rampedSpeed;
+    raisePTZ(holdAction, holdSpeed);
+  }
+}
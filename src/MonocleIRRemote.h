@@ -0,0 +1,252 @@
+/*
+ **********************************************************************
+ *             __  __  ___  _  _  ___   ___ _    ___
+ *            |  \/  |/ _ \| \| |/ _ \ / __| |  | __|
+ *            | |\/| | (_) | .` | (_) | (__| |__| _|
+ *            |_|  |_|\___/|_|\_|\___/ \___|____|___|
+ *
+ * -------------------------------------------------------------------
+ *                     MONOCLE IR REMOTE
+ * -------------------------------------------------------------------
+ *
+ *  This library provides a command engine for infrared remote
+ *  controls.  Decoded IR codes (from any IR receiver library) are
+ *  mapped to PTZ, home and preset actions using a compact sorted
+ *  lookup table that can be loaded at runtime.  While a movement
+ *  button is held, the remote's repeat interval is measured so that
+ *  movement stops on the first missed repeat, and the hold duration
+ *  ramps the speed from LOW to MEDIUM to HIGH.
+ *
+ *  Author:   Robert Savage
+ *  Date:     2018-02-18
+ *  Website:  http://monoclecam.com
+ *
+ * -------------------------------------------------------------------
+ *        COPYRIGHT SHADEBLUE, LLC @ 2018, ALL RIGHTS RESERVED
+ * -------------------------------------------------------------------
+ *
+ **********************************************************************
+ */
+#ifndef MONOCLE_IR_REMOTE_H
+#define MONOCLE_IR_REMOTE_H
+
+#include <Arduino.h>
+#include "MonocleEventBus.h"
+#include "MonocleScheduler.h"
+
+class MonocleRecorder;
+
+/* MAXIMUM NUMBER OF IR CODES IN THE LOOKUP TABLE */
+#ifndef MONOCLE_IR_MAX_CODES
+#define MONOCLE_IR_MAX_CODES 32
+#endif
+
+/* IR COMMAND ACTIONS */
+#define MONOCLE_IR_NONE       0
+#define MONOCLE_IR_STOP       1
+#define MONOCLE_IR_PAN_LEFT   2
+#define MONOCLE_IR_PAN_RIGHT  3
+#define MONOCLE_IR_TILT_UP    4
+#define MONOCLE_IR_TILT_DOWN  5
+#define MONOCLE_IR_ZOOM_IN    6
+#define MONOCLE_IR_ZOOM_OUT   7
+#define MONOCLE_IR_HOME       8
+#define MONOCLE_IR_PRESET     9   // code value carries the preset number
+#define MONOCLE_IR_MACRO      10  // code value carries the macro number
+
+/* PTZ SPEED LEVELS */
+#define MONOCLE_IR_SPEED_LOW  1
+#define MONOCLE_IR_SPEED_MED  2
+#define MONOCLE_IR_SPEED_HIGH 3
+
+#define MONOCLE_IR_NEC_REPEAT                0xFFFFFFFF
+#define MONOCLE_IR_DEFAULT_SPEED             MONOCLE_IR_SPEED_MED
+#define MONOCLE_IR_DEFAULT_REPEAT_INTERVAL   110   // milliseconds (NEC repeat frames)
+#define MONOCLE_IR_MIN_REPEAT_INTERVAL       40    // milliseconds
+#define MONOCLE_IR_MAX_REPEAT_INTERVAL       250   // milliseconds
+#define MONOCLE_IR_DEFAULT_REPEAT_TOLERANCE  25    // percent of the repeat interval
+
+/* SCHEDULER TASK INTERVAL AND EXECUTION BUDGET */
+#ifndef MONOCLE_IR_TASK_INTERVAL
+#define MONOCLE_IR_TASK_INTERVAL 5     // milliseconds
+#endif
+#ifndef MONOCLE_IR_TASK_BUDGET
+#define MONOCLE_IR_TASK_BUDGET   500   // microseconds
+#endif
+
+/**
+ * IR CODE LOOKUP TABLE ENTRY
+ */
+struct MonocleIRCode {
+  uint32_t code;    // decoded IR value
+  uint8_t action;   // MONOCLE_IR_*
+  uint8_t value;    // preset number for MONOCLE_IR_PRESET, macro number for MONOCLE_IR_MACRO
+};
+
+class MonocleIRRemote
+{
+   private:
+    /* SORTED CODE LOOKUP TABLE */
+    MonocleIRCode codes[MONOCLE_IR_MAX_CODES];
+    uint8_t count = 0;
+    uint32_t repeatCode = MONOCLE_IR_NEC_REPEAT;
+
+    /* HELD MOVEMENT STATE */
+    uint8_t holdAction = MONOCLE_IR_NONE;
+    unsigned long holdTime = 0;       // time the movement started
+    unsigned long frameTime = 0;      // time of the last code or repeat received
+    bool repeating = false;           // last frame received was a repeat
+    unsigned int interval = MONOCLE_IR_DEFAULT_REPEAT_INTERVAL;
+    uint8_t tolerance = MONOCLE_IR_DEFAULT_REPEAT_TOLERANCE;
+    int holdSpeed = 0;
+
+    /* SPEED CONFIGURATION (RAMP DISABLED WHEN BOTH DELAYS ARE ZERO) */
+    int speed = MONOCLE_IR_DEFAULT_SPEED;
+    unsigned int accelerateMedDelay = 0;
+    unsigned int accelerateHighDelay = 0;
+
+    /* CALLBACKS */
+    void (*ptzCallback)(int pan, int tilt, int zoom);
+    void (*homeCallback)(void);
+    void (*presetCallback)(const int preset);
+    void (*macroCallback)(const int macro);
+
+    /* OPTIONAL EVENT BUS */
+    MonocleEventBus* bus = NULL;
+
+    /* OPTIONAL SESSION RECORDER (RECEIVED CODES) */
+    MonocleRecorder* recorder = NULL;
+
+    /* INTERNAL PROCESSING */
+    int find(const uint32_t code);
+    int rampSpeed(unsigned long now);
+    void raisePTZ(const uint8_t action, const int speed);
+    void measureRepeat(unsigned long now);
+    void stopHold();
+
+    /* SCHEDULER TASK ENTRY POINT */
+    static void internal_ir_remote_task(void* context);
+
+   public:
+
+    /*
+     * Default Constructor
+     */
+     MonocleIRRemote();
+
+     /**
+      * ADD (OR REPLACE) A CODE IN THE LOOKUP TABLE; THE TABLE IS KEPT
+      * SORTED BY CODE. RETURNS 'false' IF THE TABLE IS FULL
+      */
+     bool addCode(const uint32_t code, const uint8_t action, const uint8_t value = 0);
+
+     /**
+      * REPLACE THE LOOKUP TABLE WITH A LIST OF CODES (IN ANY ORDER).
+      * RETURNS 'false' IF NOT ALL CODES FIT IN THE TABLE
+      */
+     bool loadCodes(const MonocleIRCode* codes, const int count);
+
+     /**
+      * REMOVE ALL CODES FROM THE LOOKUP TABLE
+      */
+     void clearCodes();
+
+     /**
+      * GET THE NUMBER OF CODES IN THE LOOKUP TABLE
+      */
+     int codeCount();
+
+     /**
+      * GET A CODE OF THE LOOKUP TABLE BY INDEX (0 .. 'codeCount()' - 1;
+      * MONOCLE_IR_NONE OUT OF RANGE)
+      */
+     MonocleIRCode codeAt(const int index);
+
+     /**
+      * DEFINE THE CODE EMITTED BY THE REMOTE WHILE A BUTTON IS HELD
+      * (DEFAULT IS THE NEC REPEAT CODE 0xFFFFFFFF)
+      */
+     void setRepeatCode(const uint32_t code);
+
+     /**
+      * DEFINE HOW LATE (PERCENT OF THE MEASURED REPEAT INTERVAL) A
+      * REPEAT MAY ARRIVE BEFORE THE BUTTON IS CONSIDERED RELEASED
+      */
+     void setRepeatTolerance(const uint8_t percent);
+
+     /**
+      * DEFINE THE PTZ SPEED (1=LOW, 2=MEDIUM, 3=HIGH) USED WHEN
+      * HOLD-TO-ACCELERATE IS DISABLED
+      */
+     void setSpeed(int speed);
+
+     /**
+      * ENABLE HOLD-TO-ACCELERATE; A HELD BUTTON STARTS AT LOW SPEED,
+      * MOVES TO MEDIUM AFTER 'medDelay' AND HIGH AFTER 'highDelay'
+      * MILLISECONDS. SET BOTH DELAYS TO ZERO TO DISABLE.
+      */
+     void setAcceleration(unsigned int medDelay, unsigned int highDelay);
+
+     /**
+      * REGISTERS A CALLBACK FUNCTION POINTER FOR PTZ STATE CHANGE EVENTS
+      * (A STOP IS RAISED AS A PTZ EVENT WITH ALL AXIS SET TO ZERO)
+      */
+     void onPTZ(void (*ptzCallback)(int, int, int));
+
+     /**
+      * REGISTERS A CALLBACK FUNCTION POINTER FOR HOME COMMANDS
+      */
+     void onHome(void (*homeCallback)(void));
+
+     /**
+      * REGISTERS A CALLBACK FUNCTION POINTER FOR PRESET COMMANDS
+      */
+     void onPreset(void (*presetCallback)(const int));
+
+     /**
+      * REGISTERS A CALLBACK FUNCTION POINTER FOR MACRO COMMANDS
+      */
+     void onMacro(void (*macroCallback)(const int));
+
+     /**
+      * PUBLISH PTZ EVENTS TO AN EVENT BUS; HOME, PRESET AND MACRO
+      * COMMANDS ARE PUBLISHED AS THE EQUIVALENT MENU ACTIONS
+      */
+     void publishTo(MonocleEventBus* bus);
+
+     /**
+      * RECORD EVERY CODE PASSED TO 'process()' TO A SESSION RECORDER
+      */
+     void recordTo(MonocleRecorder* recorder);
+
+     /**
+      * PROCESS A DECODED IR CODE (CALL FOR EVERY CODE RECEIVED)
+      */
+     void process(const uint32_t code);
+
+     /**
+      * GET THE MEASURED REPEAT INTERVAL (MILLISECONDS)
+      */
+     unsigned int repeatInterval();
+
+     /**
+      * DETERMINE IF A MOVEMENT BUTTON IS CURRENTLY HELD
+      */
+     bool isHolding();
+
+     /**
+      * REGISTER THIS REMOTE AS A TASK OF A SCHEDULER (REPLACES
+      * CALLING 'loop()' FROM THE PROGRAM MAIN LOOP); DECODED CODES
+      * MUST STILL BE PASSED TO 'process()'.
+      * RETURNS THE TASK ID OR MONOCLE_TASK_INVALID
+      */
+     int schedule(MonocleScheduler& scheduler);
+
+     /**
+      * THIS METHOD MUST BE CALLED IN THE PROGRAM MAIN LOOP
+      * TO DETECT RELEASED BUTTONS AND RAMP HELD SPEEDS
+      */
+     void loop();
+};
+
+#endif //MONOCLE_IR_REMOTE_H
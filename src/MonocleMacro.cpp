@@ -0,0 +1,374 @@
+/*
+ **********************************************************************
+ *             __  __  ___  _  _  ___   ___ _    ___
+ *            |  \/  |/ _ \| \| |/ _ \ / __| |  | __|
+ *            | |\/| | (_) | .` | (_) | (__| |__| _|
+ *            |_|  |_|\___/|_|\_|\___/ \___|____|___|
+ *
+ * -------------------------------------------------------------------
+ *                     MONOCLE PTZ MACRO
+ * -------------------------------------------------------------------
+ *
+ *  This library records timed PTZ moves (e.g. zoom out, pan across
+ *  the loading dock, zoom in) and plays them back through the
+ *  Monocle Gateway client.  The PTZ vectors emitted by the joystick
+ *  (passed to 'input()' or received from an event bus) are delta
+ *  encoded: each entry holds the time since the previous entry and
+ *  only the axes that changed, typically 2-3 bytes per change.
+ *
+ *    head  : bit 7     more delta bytes follow
+ *            bits 3-6  delta (milliseconds), low 4 bits
+ *            bits 0-2  changed axes (1=PAN, 2=TILT, 4=ZOOM);
+ *                      none marks the end of the macro
+ *    delta : further 7 bit groups of the delta, low group first
+ *            (bit 7 = more follow)
+ *    value : speed level + 3 of each changed axis in axis order,
+ *            3 bits each (bits 0-2 and 3-5; a third axis uses a
+ *            second value byte)
+ *
+ *  Up to MONOCLE_MACRO_MAX_MACROS macros are saved as records in
+ *  persistent storage (EEPROM or SAMD flash); only the macro being
+ *  recorded or played is held in RAM.  Playback is timed from the
+ *  scheduled time of the previous entry so loop latency does not
+ *  accumulate.  Macros are numbered from 1 and can be started from
+ *  menu items ('MonocleMenu::addMacro()') and IR buttons
+ *  (MONOCLE_IR_MACRO); manual PTZ input stops a playing macro.
+ *
+ *
+ *  Author:   Robert Savage
+ *  Date:     2018-02-18
+ *  Website:  http://monoclecam.com
+ *
+ * -------------------------------------------------------------------
+ *        COPYRIGHT SHADEBLUE, LLC @ 2018, ALL RIGHTS RESERVED
+ * -------------------------------------------------------------------
+ *
+ **********************************************************************
+ */
+
+#include "Arduino.h"
+#include "MonocleMacro.h"
+
+/* LARGEST END ENTRY (HEAD AND A 32 BIT DELTA); ALWAYS KEPT FREE WHILE RECORDING */
+#define MONOCLE_MACRO_END_RESERVE 5
+
+/**
+ * Default Constructor
+ */
+MonocleMacro::MonocleMacro(MonocleGatewayClient& gateway, MonocleStorage& storage, size_t address) :
+    gateway(gateway), storage(storage), address(address) {
+  memset(&buffer, 0, sizeof(buffer));
+  memset(levels, 0, sizeof(levels));
+  memset(nextLevels, 0, sizeof(nextLevels));
+
+  // initialize callbacks
+  completeCallback = NULL;
+}
+
+/**
+ * GET THE STORAGE ADDRESS OF A MACRO SLOT
+ */
+size_t MonocleMacro::slotAddress(const uint8_t macro){
+  return address + (macro - 1) * MonocleStorage::footprint(sizeof(MonocleMacroRecord));
+}
+
+/**
+ * START RECORDING A MACRO (1 .. MONOCLE_MACRO_MAX_MACROS); THE
+ * STORED MACRO IS REPLACED BY 'finish()'. RETURNS 'false' IF THE
+ * MACRO NUMBER IS INVALID OR A MACRO IS PLAYING
+ */
+bool MonocleMacro::record(const uint8_t macro){
+  if(macro < 1 || macro > MONOCLE_MACRO_MAX_MACROS) return false;
+  if(mode == MONOCLE_MACRO_PLAYING) return false;
+
+  // unused bytes are cleared so an unchanged macro is not rewritten
+  memset(&buffer, 0, sizeof(buffer));
+  memset(levels, 0, sizeof(levels));
+  this->macro = macro;
+  overflowed = false;
+  entryTime = millis();
+  mode = MONOCLE_MACRO_RECORDING;
+  return true;
+}
+
+/**
+ * ENCODE AN ENTRY FOR THE CHANGED AXES (NONE FOR THE END ENTRY).
+ * RETURNS 'false' IF THE ENTRY DOES NOT FIT
+ */
+bool MonocleMacro::append(const uint8_t axes, unsigned long delta){
+  uint8_t entry[8];
+  int size = 0;
+
+  entry[size++] = axes | ((delta & 0x0F) << 3) | ((delta > 0x0F) ? 0x80 : 0);
+  delta >>= 4;
+  while(delta > 0){
+    entry[size++] = (delta & 0x7F) | ((delta > 0x7F) ? 0x80 : 0);
+    delta >>= 7;
+  }
+
+  int count = 0;
+  uint8_t value = 0;
+  for(int axis = 0; axis < 3; axis++){
+    if(!(axes & (1 << axis))) continue;
+    if(count == 2){
+      entry[size++] = value;
+      value = 0;
+      count = 0;
+    }
+    value |= (levels[axis] + 3) << (3 * count);
+    count++;
+  }
+  if(count > 0) entry[size++] = value;
+
+  // a change must leave room for the end entry
+  size_t limit = MONOCLE_MACRO_SIZE - ((axes != 0) ? MONOCLE_MACRO_END_RESERVE : 0);
+  if((size_t)buffer.length + size > limit) return false;
+
+  memcpy(&buffer.data[buffer.length], entry, size);
+  buffer.length += size;
+  return true;
+}
+
+/**
+ * REPORT THE CURRENT PTZ VECTOR (E.G. FROM THE JOYSTICK PTZ
+ * CALLBACK); CHANGES ARE RECORDED WHILE RECORDING AND STOP A
+ * PLAYING MACRO
+ */
+void MonocleMacro::input(const int pan, const int tilt, const int zoom){
+  // manual movement takes over from a playing macro
+  if(mode == MONOCLE_MACRO_PLAYING){
+    if(pan != 0 || tilt != 0 || zoom != 0) stop();
+    return;
+  }
+  if(mode != MONOCLE_MACRO_RECORDING || overflowed) return;
+
+  int8_t vector[3] = { (int8_t)constrain(pan, -3, 3), (int8_t)constrain(tilt, -3, 3), (int8_t)constrain(zoom, -3, 3) };
+  uint8_t axes = 0;
+  for(int axis = 0; axis < 3; axis++){
+    if(vector[axis] != levels[axis]) axes |= (1 << axis);
+    levels[axis] = vector[axis];
+  }
+  if(axes == 0) return;
+
+  unsigned long now = millis();
+  if(!append(axes, now - entryTime)){
+    overflowed = true;
+    return;
+  }
+  entryTime = now;
+}
+
+/**
+ * FINISH RECORDING AND SAVE THE MACRO (THE TIME SINCE THE LAST
+ * CHANGE IS KEPT). RETURNS 'false' IF THE MACRO DID NOT FIT
+ * OR COULD NOT BE SAVED
+ */
+bool MonocleMacro::finish(){
+  if(mode != MONOCLE_MACRO_RECORDING) return false;
+  mode = MONOCLE_MACRO_IDLE;
+  if(overflowed) return false;
+
+  append(0, millis() - entryTime);
+  return storage.save(slotAddress(macro), MONOCLE_MACRO_VERSION, &buffer, sizeof(buffer));
+}
+
+/**
+ * DISCARD A RECORDING IN PROGRESS (THE STORED MACRO IS KEPT)
+ */
+void MonocleMacro::cancel(){
+  if(mode == MONOCLE_MACRO_RECORDING) mode = MONOCLE_MACRO_IDLE;
+}
+
+/**
+ * DECODE THE NEXT PLAYBACK ENTRY AND SCHEDULE IT.
+ * RETURNS 'false' IF THE MACRO IS TRUNCATED
+ */
+bool MonocleMacro::decode(){
+  if(position >= buffer.length) return false;
+
+  uint8_t head = buffer.data[position++];
+  nextAxes = head & 0x07;
+  unsigned long delta = (head >> 3) & 0x0F;
+  int shift = 4;
+  bool more = (head & 0x80) != 0;
+  while(more){
+    if(position >= buffer.length || shift > 25) return false;
+    uint8_t group = buffer.data[position++];
+    delta |= (unsigned long)(group & 0x7F) << shift;
+    shift += 7;
+    more = (group & 0x80) != 0;
+  }
+
+  int count = 0;
+  uint8_t value = 0;
+  for(int axis = 0; axis < 3; axis++){
+    if(!(nextAxes & (1 << axis))) continue;
+    if((count & 1) == 0){
+      if(position >= buffer.length) return false;
+      value = buffer.data[position++];
+    }
+    nextLevels[axis] = constrain(((value >> (3 * (count & 1))) & 0x07) - 3, -3, 3);
+    count++;
+  }
+
+  // entries are timed from the scheduled time of the previous entry
+  entryTime += delta;
+  return true;
+}
+
+/**
+ * PLAY A STORED MACRO. RETURNS 'false' IF NO VALID MACRO IS
+ * STORED, ANOTHER OPERATION IS IN PROGRESS OR THE GATEWAY IS
+ * NOT CONNECTED
+ */
+bool MonocleMacro::play(const uint8_t macro){
+  if(macro < 1 || macro > MONOCLE_MACRO_MAX_MACROS) return false;
+  if(mode != MONOCLE_MACRO_IDLE || !gateway.connected()) return false;
+  if(!storage.load(slotAddress(macro), MONOCLE_MACRO_VERSION, &buffer, sizeof(buffer))) return false;
+  if(buffer.length > MONOCLE_MACRO_SIZE) return false;
+
+  this->macro = macro;
+  memset(levels, 0, sizeof(levels));
+  position = 0;
+  entryTime = millis();
+  if(!decode()) return false;
+  mode = MONOCLE_MACRO_PLAYING;
+  return true;
+}
+
+/**
+ * END A PLAYBACK; THE CAMERA IS STOPPED IF IT IS STILL MOVING
+ */
+void MonocleMacro::finishPlayback(const bool completed){
+  if((levels[0] != 0 || levels[1] != 0 || levels[2] != 0) && gateway.connected()) gateway.stop();
+  memset(levels, 0, sizeof(levels));
+  mode = MONOCLE_MACRO_IDLE;
+  if(completeCallback != NULL) completeCallback(macro, completed);
+}
+
+/**
+ * STOP A PLAYING MACRO (THE CAMERA IS STOPPED IF MOVING)
+ */
+void MonocleMacro::stop(){
+  if(mode == MONOCLE_MACRO_PLAYING) finishPlayback(false);
+}
+
+/**
+ * DETERMINE IF A MACRO IS STORED
+ */
+bool MonocleMacro::has(const uint8_t macro){
+  if(macro < 1 || macro > MONOCLE_MACRO_MAX_MACROS) return false;
+  MonocleMacroRecord stored;
+  return storage.load(slotAddress(macro), MONOCLE_MACRO_VERSION, &stored, sizeof(stored));
+}
+
+/**
+ * ERASE A STORED MACRO
+ */
+bool MonocleMacro::erase(const uint8_t macro){
+  if(macro < 1 || macro > MONOCLE_MACRO_MAX_MACROS) return false;
+  return storage.erase(slotAddress(macro));
+}
+
+/**
+ * GET THE ENGINE STATE (MONOCLE_MACRO_*)
+ */
+uint8_t MonocleMacro::state(){
+  return mode;
+}
+bool MonocleMacro::isRecording(){
+  return mode == MONOCLE_MACRO_RECORDING;
+}
+bool MonocleMacro::isPlaying(){
+  return mode == MONOCLE_MACRO_PLAYING;
+}
+
+/**
+ * GET THE NUMBER OF ENCODED BYTES OF THE MACRO BEING RECORDED OR PLAYED
+ */
+uint16_t MonocleMacro::length(){
+  return buffer.length;
+}
+
+/**
+ * EVENT BUS SUBSCRIBER; RECORDS PTZ EVENTS AND PLAYS SELECTED MACROS
+ */
+void MonocleMacro::internal_macro_event_handler(const MonocleEvent& event, void* context){
+  MonocleMacro* engine = (MonocleMacro*)context;
+  if(event.type == MONOCLE_EVENT_PTZ){
+    engine->input(event.pan, event.tilt, event.zoom);
+  }
+  else if(event.type == MONOCLE_EVENT_MENU && event.action == MONOCLE_MENU_EVENT_MACRO){
+    engine->stop();
+    engine->play(event.value);
+  }
+}
+
+/**
+ * START MACROS SELECTED FROM THE MENU OR IR REMOTE AND RECORD
+ * PTZ EVENTS PUBLISHED ON AN EVENT BUS (RECORDING THROUGH
+ * 'input()' IS MORE ACCURATE AS IT IS NOT DELAYED BY DISPATCH)
+ */
+bool MonocleMacro::subscribeTo(MonocleEventBus* bus){
+  if(bus == NULL) return false;
+  return bus->subscribe(MONOCLE_EVENT_PTZ, internal_macro_event_handler, this) &&
+         bus->subscribe(MONOCLE_EVENT_MENU, internal_macro_event_handler, this);
+}
+
+/**
+ * REGISTERS A CALLBACK FUNCTION POINTER FOR THE END OF A PLAYBACK
+ * ('false' WHEN THE MACRO WAS STOPPED OR THE GATEWAY DISCONNECTED)
+ */
+void MonocleMacro::onComplete(void (*completeCallback)(const uint8_t macro, const bool completed)){
+  this->completeCallback = completeCallback;
+}
+
+/**
+ * SCHEDULER TASK ENTRY POINT
+ */
+void MonocleMacro::internal_macro_task(void* context){
+  ((MonocleMacro*)context)->loop();
+}
+
+/**
+ * REGISTER THIS ENGINE AS A TASK OF A SCHEDULER (REPLACES
+ * CALLING 'loop()' FROM THE PROGRAM MAIN LOOP).
+ * RETURNS THE TASK ID OR MONOCLE_TASK_INVALID
+ */
+int MonocleMacro::schedule(MonocleScheduler& scheduler){
+  return scheduler.every(MONOCLE_MACRO_TASK_INTERVAL, internal_macro_task, this, MONOCLE_MACRO_TASK_BUDGET);
+}
+
+/**
+ * THIS METHOD MUST BE CALLED IN THE PROGRAM MAIN LOOP
+ * (AT LEAST EVERY FEW MILLISECONDS WHILE PLAYING)
+ */
+void MonocleMacro::loop(){
+  if(mode != MONOCLE_MACRO_PLAYING) return;
+
+  // the camera keeps moving at the last speed without the gateway; abort
+  if(!gateway.connected()){
+    finishPlayback(false);
+    return;
+  }
+
+  // apply every entry that is due (late entries are coalesced into one command)
+  unsigned long now = millis();
+  bool changed = false;
+  while((long)(now - entryTime) >= 0){
+    if(nextAxes == 0){
+      if(changed) gateway.ptz(levels[0], levels[1], levels[2]);
+      finishPlayback(true);
+      return;
+    }
+    for(int axis = 0; axis < 3; axis++){
+      if(nextAxes & (1 << axis)) levels[axis] = nextLevels[axis];
+    }
+    changed = true;
+    if(!decode()){
+      finishPlayback(false);
+      return;
+    }
+  }
+  if(changed) gateway.ptz(levels[0], levels[1], levels[2]);
+}
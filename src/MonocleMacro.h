@@ -0,0 +1,219 @@
+/*
+ **********************************************************************
+ *             __  __  ___  _  _  ___   ___ _    ___
+ *            |  \/  |/ _ \| \| |/ _ \ / __| |  | __|
+ *            | |\/| | (_) | .` | (_) | (__| |__| _|
+ *            |_|  |_|\___/|_|\_|\___/ \___|____|___|
+ *
+ * -------------------------------------------------------------------
+ *                     MONOCLE PTZ MACRO
+ * -------------------------------------------------------------------
+ *
+ *  This library records timed PTZ moves (e.g. zoom out, pan across
+ *  the loading dock, zoom in) and plays them back through the
+ *  Monocle Gateway client.  The PTZ vectors emitted by the joystick
+ *  (passed to 'input()' or received from an event bus) are delta
+ *  encoded: each entry holds the time since the previous entry and
+ *  only the axes that changed, typically 2-3 bytes per change.
+ *
+ *    head  : bit 7     more delta bytes follow
+ *            bits 3-6  delta (milliseconds), low 4 bits
+ *            bits 0-2  changed axes (1=PAN, 2=TILT, 4=ZOOM);
+ *                      none marks the end of the macro
+ *    delta : further 7 bit groups of the delta, low group first
+ *            (bit 7 = more follow)
+ *    value : speed level + 3 of each changed axis in axis order,
+ *            3 bits each (bits 0-2 and 3-5; a third axis uses a
+ *            second value byte)
+ *
+ *  Up to MONOCLE_MACRO_MAX_MACROS macros are saved as records in
+ *  persistent storage (EEPROM or SAMD flash); only the macro being
+ *  recorded or played is held in RAM.  Playback is timed from the
+ *  scheduled time of the previous entry so loop latency does not
+ *  accumulate.  Macros are numbered from 1 and can be started from
+ *  menu items ('MonocleMenu::addMacro()') and IR buttons
+ *  (MONOCLE_IR_MACRO); manual PTZ input stops a playing macro.
+ *
+ *
+ *  Author:   Robert Savage
+ *  Date:     2018-02-18
+ *  Website:  http://monoclecam.com
+ *
+ * -------------------------------------------------------------------
+ *        COPYRIGHT SHADEBLUE, LLC @ 2018, ALL RIGHTS RESERVED
+ * -------------------------------------------------------------------
+ *
+ **********************************************************************
+ */
+#ifndef MONOCLE_MACRO_H
+#define MONOCLE_MACRO_H
+
+#include <Arduino.h>
+#include "MonocleGatewayClient.h"
+#include "MonocleStorage.h"
+#include "MonocleEventBus.h"
+#include "MonocleScheduler.h"
+
+/* NUMBER OF MACRO SLOTS IN STORAGE */
+#ifndef MONOCLE_MACRO_MAX_MACROS
+#define MONOCLE_MACRO_MAX_MACROS 4
+#endif
+
+/* ENCODED MOVE BYTES PER MACRO */
+#ifndef MONOCLE_MACRO_SIZE
+#define MONOCLE_MACRO_SIZE 64
+#endif
+
+/* STORAGE RECORD VERSION (CHANGE WHEN THE RECORD LAYOUT CHANGES) */
+#define MONOCLE_MACRO_VERSION 1
+
+/* SCHEDULER TASK INTERVAL AND EXECUTION BUDGET (THE TASK INTERVAL BOUNDS THE PLAYBACK TIMING ERROR) */
+#ifndef MONOCLE_MACRO_TASK_INTERVAL
+#define MONOCLE_MACRO_TASK_INTERVAL 2       // milliseconds
+#endif
+#ifndef MONOCLE_MACRO_TASK_BUDGET
+#define MONOCLE_MACRO_TASK_BUDGET   1000    // microseconds
+#endif
+
+/* MACRO ENGINE STATES */
+#define MONOCLE_MACRO_IDLE      0
+#define MONOCLE_MACRO_RECORDING 1
+#define MONOCLE_MACRO_PLAYING   2
+
+/**
+ * A MACRO AS STORED (ENCODED MOVES)
+ */
+struct MonocleMacroRecord {
+  uint16_t length;                      // encoded bytes (including the end entry)
+  uint8_t data[MONOCLE_MACRO_SIZE];
+};
+
+class MonocleMacro
+{
+   private:
+     MonocleGatewayClient& gateway;
+     MonocleStorage& storage;
+     size_t address;
+
+     /* MACRO BEING RECORDED OR PLAYED */
+     MonocleMacroRecord buffer;
+     uint8_t macro = 0;
+     uint8_t mode = MONOCLE_MACRO_IDLE;
+     bool overflowed = false;
+     uint16_t position = 0;             // next entry to decode (playback)
+     int8_t levels[3];                  // current PTZ vector
+     unsigned long entryTime = 0;       // time of the last entry (recording) or the next entry (playback)
+
+     /* NEXT PLAYBACK ENTRY */
+     uint8_t nextAxes = 0;
+     int8_t nextLevels[3];
+
+     /* CALLBACKS */
+     void (*completeCallback)(const uint8_t macro, const bool completed);
+
+     /* INTERNAL PROCESSING */
+     size_t slotAddress(const uint8_t macro);
+     bool append(const uint8_t axes, unsigned long delta);
+     bool decode();
+     void finishPlayback(const bool completed);
+
+     /* EVENT BUS SUBSCRIBER AND SCHEDULER TASK ENTRY POINT */
+     static void internal_macro_event_handler(const MonocleEvent& event, void* context);
+     static void internal_macro_task(void* context);
+
+   public:
+    /**
+     * Default Constructor; the macros occupy MONOCLE_MACRO_MAX_MACROS *
+     * 'MonocleStorage::footprint(sizeof(MonocleMacroRecord))'
+     * bytes of storage at the given address
+     */
+     MonocleMacro(MonocleGatewayClient& gateway, MonocleStorage& storage, size_t address = 0);
+
+     /**
+      * START RECORDING A MACRO (1 .. MONOCLE_MACRO_MAX_MACROS); THE
+      * STORED MACRO IS REPLACED BY 'finish()'. RETURNS 'false' IF THE
+      * MACRO NUMBER IS INVALID OR A MACRO IS PLAYING
+      */
+     bool record(const uint8_t macro);
+
+     /**
+      * REPORT THE CURRENT PTZ VECTOR (E.G. FROM THE JOYSTICK PTZ
+      * CALLBACK); CHANGES ARE RECORDED WHILE RECORDING AND STOP A
+      * PLAYING MACRO
+      */
+     void input(const int pan, const int tilt, const int zoom);
+
+     /**
+      * FINISH RECORDING AND SAVE THE MACRO (THE TIME SINCE THE LAST
+      * CHANGE IS KEPT). RETURNS 'false' IF THE MACRO DID NOT FIT
+      * OR COULD NOT BE SAVED
+      */
+     bool finish();
+
+     /**
+      * DISCARD A RECORDING IN PROGRESS (THE STORED MACRO IS KEPT)
+      */
+     void cancel();
+
+     /**
+      * PLAY A STORED MACRO. RETURNS 'false' IF NO VALID MACRO IS
+      * STORED, ANOTHER OPERATION IS IN PROGRESS OR THE GATEWAY IS
+      * NOT CONNECTED
+      */
+     bool play(const uint8_t macro);
+
+     /**
+      * STOP A PLAYING MACRO (THE CAMERA IS STOPPED IF MOVING)
+      */
+     void stop();
+
+     /**
+      * DETERMINE IF A MACRO IS STORED
+      */
+     bool has(const uint8_t macro);
+
+     /**
+      * ERASE A STORED MACRO
+      */
+     bool erase(const uint8_t macro);
+
+     /**
+      * GET THE ENGINE STATE (MONOCLE_MACRO_*)
+      */
+     uint8_t state();
+     bool isRecording();
+     bool isPlaying();
+
+     /**
+      * GET THE NUMBER OF ENCODED BYTES OF THE MACRO BEING RECORDED OR PLAYED
+      */
+     uint16_t length();
+
+     /**
+      * START MACROS SELECTED FROM THE MENU OR IR REMOTE AND RECORD
+      * PTZ EVENTS PUBLISHED ON AN EVENT BUS (RECORDING THROUGH
+      * 'input()' IS MORE ACCURATE AS IT IS NOT DELAYED BY DISPATCH)
+      */
+     bool subscribeTo(MonocleEventBus* bus);
+
+     /**
+      * REGISTERS A CALLBACK FUNCTION POINTER FOR THE END OF A PLAYBACK
+      * ('false' WHEN THE MACRO WAS STOPPED OR THE GATEWAY DISCONNECTED)
+      */
+     void onComplete(void (*completeCallback)(const uint8_t macro, const bool completed));
+
+     /**
+      * REGISTER THIS ENGINE AS A TASK OF A SCHEDULER (REPLACES
+      * CALLING 'loop()' FROM THE PROGRAM MAIN LOOP).
+      * RETURNS THE TASK ID OR MONOCLE_TASK_INVALID
+      */
+     int schedule(MonocleScheduler& scheduler);
+
+     /**
+      * THIS METHOD MUST BE CALLED IN THE PROGRAM MAIN LOOP
+      * (AT LEAST EVERY FEW MILLISECONDS WHILE PLAYING)
+      */
+     void loop();
+};
+
+#endif //MONOCLE_MACRO_H
@@ -29,41 +29,43 @@
 // @see https://github.com/jonblack/arduino-menusystem
 #include "MonocleMenu.h"
 
-static bool active = false;
-static int updateTimer = 0;
-static bool deactivateCallbackPending = false;
-static bool activateCallbackPending = false;
-static bool homeCallbackPending = false;
-static bool zoomCallbackPending = false;
-static int presetCallbackPending = 0;
+/**
+ * Menu Item Constructors
+ */
+MonocleMenuItem::MonocleMenuItem(const char* name, const uint8_t event) :
+    MenuItem(name, &MonocleMenu::internal_monocle_menu_dispatch)
+{
+  this->menu = NULL;
+  this->event = event;
+  this->index = 0;
+}
+MonoclePresetMenuItem::MonoclePresetMenuItem() :
+    MonocleMenuItem(name, MONOCLE_MENU_EVENT_PRESET)
+{
+  this->name[0] = '\0';
+}
+MonocleCameraMenuItem::MonocleCameraMenuItem() :
+    MonoclePresetMenuItem()
+{
+  this->event = MONOCLE_MENU_EVENT_CAMERA;
+  this->uuid[0] = '\0';
+  this->loaded = false;
+}
 
 /**
  * Default Constructor
  */
 MonocleMenu::MonocleMenu(MenuComponentRenderer const& renderer) :
     ms(renderer),
-    miExit("[EXIT]", (SelectFnPtr)&MonocleMenu::internal_monocle_menu_exit_callback),
-    miHome("Recall Home", (SelectFnPtr)&MonocleMenu::internal_monocle_menu_home_callback),
-    miZoom("Zoom", (SelectFnPtr)&MonocleMenu::internal_monocle_menu_zoom_callback),
-    mnuPresetsPage1("Recall Preset", (SelectFnPtr)&MonocleMenu::internal_monocle_menu_callback),
-    mnuPresetsPage2("[MORE] ...", (SelectFnPtr)&MonocleMenu::internal_monocle_menu_callback),
-    mnuPresetsPage3("[MORE] ...", (SelectFnPtr)&MonocleMenu::internal_monocle_menu_callback),
-    mnuPresetsPage4("[MORE] ...", (SelectFnPtr)&MonocleMenu::internal_monocle_menu_callback),
-    mnuPresetsPage5("[MORE] ...", (SelectFnPtr)&MonocleMenu::internal_monocle_menu_callback),
-    miPresetsBack1("[BACK]", (SelectFnPtr)&MonocleMenu::internal_monocle_menu_callback, &ms),
-    miPresetsBack2("[BACK]", (SelectFnPtr)&MonocleMenu::internal_monocle_menu_callback, &ms),
-    miPresetsBack3("[BACK]", (SelectFnPtr)&MonocleMenu::internal_monocle_menu_callback, &ms),
-    miPresetsBack4("[BACK]", (SelectFnPtr)&MonocleMenu::internal_monocle_menu_callback, &ms),
-    miPresetsBack5("[BACK]", (SelectFnPtr)&MonocleMenu::internal_monocle_menu_callback, &ms),
-    miPreset1("Preset 1", (SelectFnPtr)&MonocleMenu::internal_monocle_menu_preset1_callback),
-    miPreset2("Preset 2", (SelectFnPtr)&MonocleMenu::internal_monocle_menu_preset2_callback),
-    miPreset3("Preset 3", (SelectFnPtr)&MonocleMenu::internal_monocle_menu_preset3_callback),
-    miPreset4("Preset 4", (SelectFnPtr)&MonocleMenu::internal_monocle_menu_preset4_callback),
-    miPreset5("Preset 5", (SelectFnPtr)&MonocleMenu::internal_monocle_menu_preset5_callback),
-    miPreset6("Preset 6", (SelectFnPtr)&MonocleMenu::internal_monocle_menu_preset6_callback),
-    miPreset7("Preset 7", (SelectFnPtr)&MonocleMenu::internal_monocle_menu_preset7_callback),
-    miPreset8("Preset 8", (SelectFnPtr)&MonocleMenu::internal_monocle_menu_preset8_callback),
-    miPreset9("Preset 9", (SelectFnPtr)&MonocleMenu::internal_monocle_menu_preset9_callback)
+    miExit("[EXIT]", MONOCLE_MENU_EVENT_NONE),
+    miHome("Recall Home", MONOCLE_MENU_EVENT_HOME),
+    miZoom("Zoom", MONOCLE_MENU_EVENT_ZOOM),
+    mnuPresets("Recall Preset", NULL),
+    miPresetsBack("[BACK]", NULL, &ms),
+    mnuMacros("Run Macro", NULL),
+    miMacrosBack("[BACK]", NULL, &ms),
+    mnuCameras("Cameras", NULL),
+    miCamerasBack(camerasBackName, NULL, &ms)
 {
   // initialize callbacks
   this->activateCallback = NULL;
@@ -71,86 +73,79 @@ MonocleMenu::MonocleMenu(MenuComponentRenderer const& renderer) :
   this->homeCallback = NULL;
   this->zoomCallback = NULL;
   this->presetCallback = NULL;
+  this->macroCallback = NULL;
+  this->cameraCallback = NULL;
+  this->cameraRequestCallback = NULL;
+  this->pendingCameraUuid[0] = '\0';
+
+  // bind menu items to this menu instance
+  miExit.menu = this;
+  miHome.menu = this;
+  miZoom.menu = this;
 
   // build main menu
   ms.get_root_menu().add_item(&miExit);
   ms.get_root_menu().add_item(&miHome);
-  ms.get_root_menu().add_menu(&mnuPresetsPage1);
-
-  // build presets submenu (page 1)
-  mnuPresetsPage1.add_item(&miPresetsBack1);
-  mnuPresetsPage1.add_item(&miPreset1);
-  mnuPresetsPage1.add_item(&miPreset2);
-  mnuPresetsPage1.add_menu(&mnuPresetsPage2);
-
-  // build presets submenu (page 2)
-  mnuPresetsPage2.add_item(&miPresetsBack2);
-  mnuPresetsPage2.add_item(&miPreset3);
-  mnuPresetsPage2.add_item(&miPreset4);
-  mnuPresetsPage2.add_menu(&mnuPresetsPage3);
-
-  // build presets submenu (page 3)
-  mnuPresetsPage3.add_item(&miPresetsBack3);
-  mnuPresetsPage3.add_item(&miPreset5);
-  mnuPresetsPage3.add_item(&miPreset6);
-  mnuPresetsPage3.add_menu(&mnuPresetsPage4);
-
-  // build presets submenu (page 4)
-  mnuPresetsPage4.add_item(&miPresetsBack4);
-  mnuPresetsPage4.add_item(&miPreset6);
-  mnuPresetsPage4.add_item(&miPreset7);
-  mnuPresetsPage4.add_menu(&mnuPresetsPage5);
-
-  // build presets submenu (page 5)
-  mnuPresetsPage5.add_item(&miPresetsBack5);
-  mnuPresetsPage5.add_item(&miPreset8);
-  mnuPresetsPage5.add_item(&miPreset9);
+  ms.get_root_menu().add_menu(&mnuPresets);
+
+  // build presets submenu; the renderer scrolls long menus
+  // so all presets are listed in a single submenu.  The entire
+  // preset pool is attached here, once, so that populating the
+  // presets later never grows the heap; unused slots have an
+  // empty name and are skipped by navigation and rendering.
+  mnuPresets.add_item(&miPresetsBack);
+  for(int index = 0; index < MONOCLE_MENU_MAX_PRESETS; index++){
+    miPresets[index].menu = this;
+    miPresets[index].index = index;
+    mnuPresets.add_item(&miPresets[index]);
+  }
+  resetPresets();
+
+  // build the macros submenu the same way; it is only added to the
+  // main menu once the first macro item is added
+  mnuMacros.add_item(&miMacrosBack);
+  for(int index = 0; index < MONOCLE_MENU_MAX_MACROS; index++){
+    miMacros[index].menu = this;
+    miMacros[index].event = MONOCLE_MENU_EVENT_MACRO;
+    miMacros[index].index = index;
+    mnuMacros.add_item(&miMacros[index]);
+  }
+
+  // build the cameras submenu; its rows are a window onto the gateway
+  // camera list that scrolls along the list when the cursor passes the
+  // first or last row, so a list of any length uses the same rows.
+  // It is added to the main menu with the first camera list update.
+  updateCamerasBack();
+  mnuCameras.add_item(&miCamerasBack);
+  for(int index = 0; index < MONOCLE_MENU_CAMERA_ROWS; index++){
+    miCameras[index].menu = this;
+    miCameras[index].index = index;
+    mnuCameras.add_item(&miCameras[index]);
+  }
 }
 
 // INTERNAL CALLBACK HANDLERS
-void MonocleMenu::internal_monocle_menu_callback(MenuComponent* p_menu_component){
-  updateTimer = millis();
-}
-void MonocleMenu::internal_monocle_menu_exit_callback(MenuComponent* p_menu_component){
-  deactivate();
-}
-void MonocleMenu::internal_monocle_menu_home_callback(MenuComponent* p_menu_component){
-  homeCallbackPending = true;
-  deactivate();
-}
-void MonocleMenu::internal_monocle_menu_zoom_callback(MenuComponent* p_menu_component){
-  zoomCallbackPending = true;
-  deactivate();
+void MonocleMenu::internal_monocle_menu_dispatch(MenuComponent* p_menu_component){
+  // all monocle menu items share this callback; the item knows its owner, event and index
+  MonocleMenuItem* item = static_cast<MonocleMenuItem*>(p_menu_component);
+  if(item->menu != NULL)
+    item->menu->internal_monocle_menu_callback(item->event, item->index);
 }
-void MonocleMenu::internal_monocle_menu_preset1_callback(MenuComponent* p_menu_component){
-  internal_monocle_menu_preset_callback(p_menu_component, 1);
-}
-void MonocleMenu::internal_monocle_menu_preset2_callback(MenuComponent* p_menu_component){
-  internal_monocle_menu_preset_callback(p_menu_component, 2);
-}
-void MonocleMenu::internal_monocle_menu_preset3_callback(MenuComponent* p_menu_component){
-  internal_monocle_menu_preset_callback(p_menu_component, 3);
-}
-void MonocleMenu::internal_monocle_menu_preset4_callback(MenuComponent* p_menu_component){
-  internal_monocle_menu_preset_callback(p_menu_component, 4);
-}
-void MonocleMenu::internal_monocle_menu_preset5_callback(MenuComponent* p_menu_component){
-  internal_monocle_menu_preset_callback(p_menu_component, 5);
-}
-void MonocleMenu::internal_monocle_menu_preset6_callback(MenuComponent* p_menu_component){
-  internal_monocle_menu_preset_callback(p_menu_component, 6);
-}
-void MonocleMenu::internal_monocle_menu_preset7_callback(MenuComponent* p_menu_component){
-  internal_monocle_menu_preset_callback(p_menu_component, 7);
-}
-void MonocleMenu::internal_monocle_menu_preset8_callback(MenuComponent* p_menu_component){
-  internal_monocle_menu_preset_callback(p_menu_component, 8);
-}
-void MonocleMenu::internal_monocle_menu_preset9_callback(MenuComponent* p_menu_component){
-  internal_monocle_menu_preset_callback(p_menu_component, 9);
-}
-void MonocleMenu::internal_monocle_menu_preset_callback(MenuComponent* p_menu_component, const int preset){
-  presetCallbackPending = preset;
+void MonocleMenu::internal_monocle_menu_callback(const uint8_t event, const uint8_t index){
+  if(event == MONOCLE_MENU_EVENT_PRESET){
+    if(index >= presets) return;  // ignore unused preset slots
+    pendingPreset = index + 1;
+  }
+  else if(event == MONOCLE_MENU_EVENT_MACRO){
+    if(index >= macros) return;  // ignore unused macro slots
+    pendingMacro = index + 1;
+  }
+  else if(event == MONOCLE_MENU_EVENT_CAMERA){
+    // ignore unused rows and rows still waiting for the gateway
+    if(index >= cameraRows() || !miCameras[index].loaded) return;
+    strcpy(pendingCameraUuid, miCameras[index].uuid);
+  }
+  pendingEvents |= event;
   deactivate();
 }
 
@@ -161,6 +156,22 @@ void MonocleMenu::refresh() {
   ms.display();
 }
 
+/**
+ * SCHEDULER TASK ENTRY POINT
+ */
+void MonocleMenu::internal_menu_task(void* context){
+  ((MonocleMenu*)context)->loop();
+}
+
+/**
+ * REGISTER THIS MENU AS A TASK OF A SCHEDULER (REPLACES
+ * CALLING 'loop()' FROM THE PROGRAM MAIN LOOP).
+ * RETURNS THE TASK ID OR MONOCLE_TASK_INVALID
+ */
+int MonocleMenu::schedule(MonocleScheduler& scheduler){
+  return scheduler.every(MONOCLE_MENU_TASK_INTERVAL, internal_menu_task, this, MONOCLE_MENU_TASK_BUDGET);
+}
+
 /**
  * THIS FUNTION MUST BE CALLED IN THE PROGRAM 
  * MAIN LOOP TO SERVICE THE MENU SYSTEM AND EVENTS
@@ -172,25 +183,42 @@ void MonocleMenu::loop() {
     updateTimer = 0;
   }
 
-  if(activateCallbackPending){
-    if (activateCallback != NULL) activateCallback();
-    activateCallbackPending = false;
-  }
-  if(homeCallbackPending){
-    if (homeCallback != NULL) homeCallback();
-    homeCallbackPending = false;
-  }
-  if(presetCallbackPending > 0){
-    if (presetCallback != NULL) presetCallback(presetCallbackPending);
-    presetCallbackPending = 0;
-  }
-  if(deactivateCallbackPending){
-    if (deactivateCallback != NULL) deactivateCallback();
-    deactivateCallbackPending = false;
-  }
-  if(zoomCallbackPending){
-    if (zoomCallback != NULL) zoomCallback();
-    zoomCallbackPending = false;
+  // nothing more to do unless a menu event is pending
+  if(pendingEvents == MONOCLE_MENU_EVENT_NONE) return;
+
+  // take a snapshot of the pending events; any events raised
+  // from within the user callbacks are processed on the next loop
+  uint8_t events = pendingEvents;
+  int preset = pendingPreset;
+  int macro = pendingMacro;
+  pendingEvents = MONOCLE_MENU_EVENT_NONE;
+  pendingPreset = 0;
+  pendingMacro = 0;
+
+  if((events & MONOCLE_MENU_EVENT_ACTIVATE) && activateCallback != NULL)
+    activateCallback();
+  if((events & MONOCLE_MENU_EVENT_HOME) && homeCallback != NULL)
+    homeCallback();
+  if((events & MONOCLE_MENU_EVENT_PRESET) && presetCallback != NULL)
+    presetCallback(preset);
+  if((events & MONOCLE_MENU_EVENT_MACRO) && macroCallback != NULL)
+    macroCallback(macro);
+  if((events & MONOCLE_MENU_EVENT_CAMERA) && cameraCallback != NULL)
+    cameraCallback(pendingCameraUuid);
+  if((events & MONOCLE_MENU_EVENT_DEACTIVATE) && deactivateCallback != NULL)
+    deactivateCallback();
+  if((events & MONOCLE_MENU_EVENT_ZOOM) && zoomCallback != NULL)
+    zoomCallback();
+
+  // publish the same events (in the same order) to the event bus
+  if(bus != NULL){
+    if(events & MONOCLE_MENU_EVENT_ACTIVATE)   bus->publishMenu(MONOCLE_MENU_EVENT_ACTIVATE);
+    if(events & MONOCLE_MENU_EVENT_HOME)       bus->publishMenu(MONOCLE_MENU_EVENT_HOME);
+    if(events & MONOCLE_MENU_EVENT_PRESET)     bus->publishMenu(MONOCLE_MENU_EVENT_PRESET, preset);
+    if(events & MONOCLE_MENU_EVENT_MACRO)      bus->publishMenu(MONOCLE_MENU_EVENT_MACRO, macro);
+    if(events & MONOCLE_MENU_EVENT_CAMERA)     bus->publishMenu(MONOCLE_MENU_EVENT_CAMERA, 0, pendingCameraUuid);
+    if(events & MONOCLE_MENU_EVENT_DEACTIVATE) bus->publishMenu(MONOCLE_MENU_EVENT_DEACTIVATE);
+    if(events & MONOCLE_MENU_EVENT_ZOOM)       bus->publishMenu(MONOCLE_MENU_EVENT_ZOOM);
   }
 }
 
@@ -201,7 +229,7 @@ void MonocleMenu::activate(){
   active = true;  // update active state flag
   ms.reset();     // reset the menu system
   updateTimer = millis(); // set a timer to update the display
-  activateCallbackPending = true;
+  pendingEvents |= MONOCLE_MENU_EVENT_ACTIVATE;
 }
 
 /**
@@ -210,7 +238,7 @@ void MonocleMenu::activate(){
 void MonocleMenu::deactivate(){
   active = false;  // update active state flag
   updateTimer = 0;
-  deactivateCallbackPending = true;
+  pendingEvents |= MONOCLE_MENU_EVENT_DEACTIVATE;
 }
 
 /**
@@ -224,8 +252,15 @@ bool MonocleMenu::isActive(){
  * SELECT THE CURRENT FOCUSED MENU ITEM
  */
 void MonocleMenu::select(){
+  Menu const* menu = ms.get_current_menu();
   ms.select();
   updateTimer = millis();
+
+  // the cameras submenu always opens at the top of the camera list
+  if(menu != &mnuCameras && ms.get_current_menu() == &mnuCameras && cameraFirst > 0){
+    scrollCameras(0);
+    requestCameras();
+  }
 }
 
 /**
@@ -241,6 +276,28 @@ void MonocleMenu::reset(){
  */
 bool MonocleMenu::next(){
   updateTimer = millis();
+
+  // at the last camera row the window scrolls half a window down the list
+  Menu const* menu = ms.get_current_menu();
+  if(menu == &mnuCameras && menu->get_current_component_num() == MONOCLE_MENU_CAMERA_ROWS &&
+     cameraFirst + MONOCLE_MENU_CAMERA_ROWS < cameras){
+    int first = cameraFirst + MONOCLE_MENU_CAMERA_ROWS / 2;
+    if(first > cameras - MONOCLE_MENU_CAMERA_ROWS) first = cameras - MONOCLE_MENU_CAMERA_ROWS;
+    int shift = first - cameraFirst;
+    scrollCameras(first);
+
+    // the cursor follows its camera up the window, then advances by one
+    for(int step = 1; step < shift; step++) ms.prev();
+    requestCameras();
+    return true;
+  }
+
+  // do not advance onto an unused (unnamed) preset pool slot
+  int next = menu->get_current_component_num() + 1;
+  if(next < menu->get_num_components()){
+    const char* name = menu->get_menu_component(next)->get_name();
+    if(name == NULL || name[0] == '\0') return false;
+  }
   return ms.next();
 }
 
@@ -249,6 +306,20 @@ bool MonocleMenu::next(){
  */
 bool MonocleMenu::prev(){
   updateTimer = millis();
+
+  // at the first camera row the window scrolls half a window up the list
+  Menu const* menu = ms.get_current_menu();
+  if(menu == &mnuCameras && menu->get_current_component_num() == 1 && cameraFirst > 0){
+    int first = cameraFirst - MONOCLE_MENU_CAMERA_ROWS / 2;
+    if(first < 0) first = 0;
+    int shift = cameraFirst - first;
+    scrollCameras(first);
+
+    // the cursor follows its camera down the window, then moves back by one
+    for(int step = 1; step < shift; step++) ms.next();
+    requestCameras();
+    return true;
+  }
   return ms.prev();
 }
 
@@ -268,6 +339,279 @@ void MonocleMenu::addZoomMenu(){
   ms.get_root_menu().add_item(&miZoom);
 }
 
+/**
+ * REMOVE ALL PRESET MENU ITEMS
+ */
+void MonocleMenu::clearPresets(){
+  // leave the presets submenu if it is open; its cursor may sit on a slot being cleared
+  if(ms.get_current_menu() == &mnuPresets) ms.back();
+
+  for(int index = 0; index < presets; index++){
+    miPresets[index].name[0] = '\0';
+  }
+  presets = 0;
+  updateTimer = millis();
+}
+
+/**
+ * APPEND A NAMED PRESET MENU ITEM; RETURNS 'false' IF THE
+ * PREALLOCATED PRESET POOL IS FULL.  (names longer than
+ * MONOCLE_MENU_PRESET_NAME_LENGTH are truncated)
+ */
+bool MonocleMenu::addPreset(const char* name){
+  if(presets >= MONOCLE_MENU_MAX_PRESETS) return false;
+  MonoclePresetMenuItem& item = miPresets[presets];
+
+  // an empty name would mark the slot as unused, so fall back to a generic name
+  if(name == NULL || name[0] == '\0')
+    snprintf(item.name, sizeof(item.name), "Preset %d", presets + 1);
+  else
+    strncpy(item.name, name, MONOCLE_MENU_PRESET_NAME_LENGTH);
+  item.name[MONOCLE_MENU_PRESET_NAME_LENGTH] = '\0';
+
+  presets++;
+  updateTimer = millis();
+  return true;
+}
+
+/**
+ * RESTORE THE GENERIC "Preset 1" .. "Preset 9" MENU ITEMS
+ */
+void MonocleMenu::resetPresets(){
+  clearPresets();
+  for(int index = 0; index < MONOCLE_MENU_DEFAULT_PRESETS; index++){
+    addPreset(NULL);
+  }
+}
+
+/**
+ * GET THE NUMBER OF PRESET MENU ITEMS
+ */
+int MonocleMenu::presetCount(){
+  return presets;
+}
+
+/**
+ * REMOVE ALL MACRO MENU ITEMS
+ */
+void MonocleMenu::clearMacros(){
+  // leave the macros submenu if it is open; its cursor may sit on a slot being cleared
+  if(ms.get_current_menu() == &mnuMacros) ms.back();
+
+  for(int index = 0; index < macros; index++){
+    miMacros[index].name[0] = '\0';
+  }
+  macros = 0;
+  updateTimer = millis();
+}
+
+/**
+ * APPEND A NAMED MACRO MENU ITEM (THE FIRST ITEM ADDS THE
+ * "Run Macro" SUBMENU); RETURNS 'false' IF THE PREALLOCATED
+ * MACRO POOL IS FULL
+ */
+bool MonocleMenu::addMacro(const char* name){
+  if(macros >= MONOCLE_MENU_MAX_MACROS) return false;
+  if(!macroMenu){
+    ms.get_root_menu().add_menu(&mnuMacros);
+    macroMenu = true;
+  }
+  MonoclePresetMenuItem& item = miMacros[macros];
+
+  // an empty name would mark the slot as unused, so fall back to a generic name
+  if(name == NULL || name[0] == '\0')
+    snprintf(item.name, sizeof(item.name), "Macro %d", macros + 1);
+  else
+    strncpy(item.name, name, MONOCLE_MENU_PRESET_NAME_LENGTH);
+  item.name[MONOCLE_MENU_PRESET_NAME_LENGTH] = '\0';
+
+  macros++;
+  updateTimer = millis();
+  return true;
+}
+
+/**
+ * GET THE NUMBER OF MACRO MENU ITEMS
+ */
+int MonocleMenu::macroCount(){
+  return macros;
+}
+
+/**
+ * GET THE NUMBER OF CAMERA ROWS IN USE (THE WINDOW MAY PASS THE END OF THE LIST)
+ */
+int MonocleMenu::cameraRows(){
+  int rows = cameras - cameraFirst;
+  if(rows < 0) return 0;
+  return (rows > MONOCLE_MENU_CAMERA_ROWS) ? MONOCLE_MENU_CAMERA_ROWS : rows;
+}
+
+/**
+ * MOVE THE CAMERA WINDOW TO A NEW FIRST LIST INDEX; ROWS STILL INSIDE THE
+ * WINDOW KEEP THEIR CAMERA, THE OTHER ROWS WAIT FOR THE GATEWAY
+ */
+void MonocleMenu::scrollCameras(int first){
+  int shift = first - cameraFirst;
+  if(shift == 0) return;
+
+  for(int step = 0; step < MONOCLE_MENU_CAMERA_ROWS; step++){
+    // copy in the direction of the shift so no row is overwritten before it is moved
+    int row = (shift > 0) ? step : MONOCLE_MENU_CAMERA_ROWS - 1 - step;
+    int source = row + shift;
+    MonocleCameraMenuItem& item = miCameras[row];
+    if(source >= 0 && source < MONOCLE_MENU_CAMERA_ROWS){
+      memcpy(item.name, miCameras[source].name, sizeof(item.name));
+      memcpy(item.uuid, miCameras[source].uuid, sizeof(item.uuid));
+      item.loaded = miCameras[source].loaded;
+    }
+    else {
+      strcpy(item.name, "...");
+      item.uuid[0] = '\0';
+      item.loaded = false;
+    }
+  }
+  cameraFirst = first;
+  updateCamerasBack();
+}
+
+/**
+ * REQUEST THE CAMERA ROWS WAITING FOR THE GATEWAY (A SINGLE PAGE
+ * SPANNING THE FIRST TO THE LAST ROW THAT IS NOT LOADED)
+ */
+void MonocleMenu::requestCameras(){
+  int rows = cameraRows();
+  int from = -1;
+  int to = -1;
+  for(int row = 0; row < rows; row++){
+    if(miCameras[row].loaded) continue;
+    if(from < 0) from = row;
+    to = row;
+  }
+  if(from >= 0 && cameraRequestCallback != NULL)
+    cameraRequestCallback(cameraFirst + from, to - from + 1);
+}
+
+/**
+ * THE BACK ITEM OF A LONG CAMERA LIST SHOWS THE WINDOW POSITION ("[BACK] 9-16/130")
+ */
+void MonocleMenu::updateCamerasBack(){
+  if(cameras > MONOCLE_MENU_CAMERA_ROWS)
+    snprintf(camerasBackName, sizeof(camerasBackName), "[BACK] %d-%d/%d",
+             cameraFirst + 1, cameraFirst + cameraRows(), cameras);
+  else
+    strcpy(camerasBackName, "[BACK]");
+}
+
+/**
+ * THE GATEWAY CAMERA LIST CHANGED (SEE 'MonocleGatewayClient::onCameraList()');
+ * ROWS 'from' .. 'to' INSIDE THE WINDOW ARE REQUESTED AGAIN THROUGH THE
+ * CAMERA REQUEST CALLBACK.  THE FIRST CALL ADDS THE "Cameras" SUBMENU
+ */
+void MonocleMenu::updateCameras(const int count, const int from, const int to){
+  if(!cameraMenu){
+    ms.get_root_menu().add_menu(&mnuCameras);
+    cameraMenu = true;
+  }
+  int moved = ((count > 0) ? count : 0) - cameras;
+  cameras = (count > 0) ? count : 0;
+
+  // cameras added or removed above the window move every following row
+  // (the changed range runs to the end of the list); the window follows
+  // its cameras so none of its rows change
+  if(moved != 0 && to >= cameras - 1 && from < cameraFirst && cameraFirst + moved >= from){
+    cameraFirst += moved;
+  }
+  // changed rows keep showing their current name until the new row
+  // arrives, so rows that did not actually change are not redrawn
+  else {
+    for(int row = 0; row < MONOCLE_MENU_CAMERA_ROWS; row++){
+      int index = cameraFirst + row;
+      if(index >= from && index <= to) miCameras[row].loaded = false;
+    }
+  }
+
+  // keep the window inside a list that has become shorter
+  int first = cameras - MONOCLE_MENU_CAMERA_ROWS;
+  if(first < 0) first = 0;
+  if(first < cameraFirst) scrollCameras(first);
+
+  // rows past the end of the list are unused; rows added to the
+  // end of the list show a placeholder until they arrive
+  int rows = cameraRows();
+  for(int row = 0; row < MONOCLE_MENU_CAMERA_ROWS; row++){
+    MonocleCameraMenuItem& item = miCameras[row];
+    if(row >= rows){
+      item.name[0] = '\0';
+      item.uuid[0] = '\0';
+      item.loaded = false;
+    }
+    else if(item.name[0] == '\0'){
+      strcpy(item.name, "...");
+    }
+  }
+
+  // the cursor may sit on a row past the end of the list
+  if(ms.get_current_menu() == &mnuCameras){
+    while(ms.get_current_menu()->get_current_component_num() > rows && ms.prev());
+  }
+
+  updateCamerasBack();
+  requestCameras();
+  updateTimer = millis();
+}
+
+/**
+ * STORE A REQUESTED CAMERA LIST ROW (SEE 'MonocleGatewayClient::onCameraEntry()');
+ * RETURNS 'false' IF THE ROW IS OUTSIDE THE WINDOW (E.G. SCROLLED AWAY)
+ */
+bool MonocleMenu::setCamera(const int index, const char* uuid, const char* name, bool active){
+  int row = index - cameraFirst;
+  if(row < 0 || row >= cameraRows()) return false;
+  MonocleCameraMenuItem& item = miCameras[row];
+
+  // the active camera is marked with a '*'; an unnamed camera gets a generic name
+  char text[MONOCLE_MENU_PRESET_NAME_LENGTH + 1];
+  if(name == NULL || name[0] == '\0')
+    snprintf(text, sizeof(text), "%sCamera %d", active ? "*" : "", index + 1);
+  else
+    snprintf(text, sizeof(text), "%s%s", active ? "*" : "", name);
+
+  // only a row with a different name needs a display refresh
+  if(strcmp(item.name, text) != 0){
+    strcpy(item.name, text);
+    updateTimer = millis();
+  }
+  strncpy(item.uuid, (uuid != NULL) ? uuid : "", MONOCLE_MENU_CAMERA_UUID_LENGTH);
+  item.uuid[MONOCLE_MENU_CAMERA_UUID_LENGTH] = '\0';
+  item.loaded = true;
+  return true;
+}
+
+/**
+ * REMOVE ALL CAMERA MENU ITEMS (E.G. WHEN THE GATEWAY IS DISCONNECTED)
+ */
+void MonocleMenu::clearCameras(){
+  // leave the cameras submenu if it is open; its cursor may sit on a row being cleared
+  if(ms.get_current_menu() == &mnuCameras) ms.back();
+
+  for(int row = 0; row < MONOCLE_MENU_CAMERA_ROWS; row++){
+    miCameras[row].name[0] = '\0';
+    miCameras[row].uuid[0] = '\0';
+    miCameras[row].loaded = false;
+  }
+  cameras = 0;
+  cameraFirst = 0;
+  updateCamerasBack();
+  updateTimer = millis();
+}
+
+/**
+ * GET THE NUMBER OF CAMERAS IN THE GATEWAY CAMERA LIST
+ */
+int MonocleMenu::cameraCount(){
+  return cameras;
+}
+
 /**
  * REGISTER CALLBACK FUNCTION POINTER FOR 
  * NOTIFICATION CALLBACKS WHEN THE MENU SYSTEM
@@ -312,3 +656,38 @@ void MonocleMenu::onZoom(void (*callback)(void)) {
 void MonocleMenu::onPreset(void (*callback)(const int)) {
     this->presetCallback = callback;
 }
+
+/**
+ * REGISTER CALLBACK FUNCTION POINTER FOR 
+ * NOTIFICATION CALLBACKS WHEN ONE OF THE 'MACRO'
+ * MENU ITEMS IS SELECTED (MACROS ARE NUMBERED FROM 1)
+ */
+void MonocleMenu::onMacro(void (*callback)(const int)) {
+    this->macroCallback = callback;
+}
+
+/**
+ * REGISTER CALLBACK FUNCTION POINTER FOR 
+ * NOTIFICATION CALLBACKS WHEN ONE OF THE 'CAMERA'
+ * MENU ITEMS IS SELECTED (SEE 'MonocleGatewayClient::selectCamera()')
+ */
+void MonocleMenu::onCamera(void (*callback)(const char*)) {
+    this->cameraCallback = callback;
+}
+
+/**
+ * REGISTER CALLBACK FUNCTION POINTER FOR
+ * REQUESTS OF CAMERA LIST ROWS NEEDED BY THE 'CAMERA'
+ * WINDOW (SEE 'MonocleGatewayClient::requestCameras()')
+ */
+void MonocleMenu::onCameraRequest(void (*callback)(const int, const int)) {
+    this->cameraRequestCallback = callback;
+}
+
+/**
+ * PUBLISH MENU EVENTS (ACTIVATE, DEACTIVATE, HOME, ZOOM,
+ * PRESET, MACRO AND CAMERA) TO AN EVENT BUS
+ */
+void MonocleMenu::publishTo(MonocleEventBus* bus){
+  this->bus = bus;
+}
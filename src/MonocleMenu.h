@@ -28,53 +28,146 @@
 
 #define MONOCLE_MENU_DISPLAY_INTERVAL 50 // milliseconds
 
+/* SCHEDULER TASK INTERVAL AND EXECUTION BUDGET (A DISPLAY REFRESH IS THE LONGEST STEP) */
+#ifndef MONOCLE_MENU_TASK_INTERVAL
+#define MONOCLE_MENU_TASK_INTERVAL 10      // milliseconds
+#endif
+#ifndef MONOCLE_MENU_TASK_BUDGET
+#define MONOCLE_MENU_TASK_BUDGET   30000   // microseconds
+#endif
+
+/* MAXIMUM NUMBER OF PRESET MENU ITEMS (PREALLOCATED POOL; ABOUT 48 BYTES OF
+   RAM PER ITEM ON 32-BIT BOARDS INCLUDING THE MENU'S ITEM POINTER) */
+#ifndef MONOCLE_MENU_MAX_PRESETS
+#define MONOCLE_MENU_MAX_PRESETS 32
+#endif
+
+/* MAXIMUM PRESET NAME LENGTH (21 CHARS PER LINE LESS THE "> " PREFIX) */
+#ifndef MONOCLE_MENU_PRESET_NAME_LENGTH
+#define MONOCLE_MENU_PRESET_NAME_LENGTH 19
+#endif
+
+/* MAXIMUM NUMBER OF MACRO MENU ITEMS (PREALLOCATED; SEE "MonocleMacro.h") */
+#ifndef MONOCLE_MENU_MAX_MACROS
+#define MONOCLE_MENU_MAX_MACROS 4
+#endif
+
+/* NUMBER OF CAMERA ROWS HELD BY THE "Cameras" SUBMENU; THE GATEWAY CAMERA
+   LIST IS PAGED THROUGH THIS WINDOW SO A LONG LIST NEEDS NO MORE MEMORY */
+#ifndef MONOCLE_MENU_CAMERA_ROWS
+#define MONOCLE_MENU_CAMERA_ROWS 8
+#endif
+
+/* MAXIMUM CAMERA UUID LENGTH (SEE MONOCLE_GATEWAY_CAMERA_TEXT_LENGTH) */
+#ifndef MONOCLE_MENU_CAMERA_UUID_LENGTH
+#define MONOCLE_MENU_CAMERA_UUID_LENGTH 40
+#endif
+
+/* NUMBER OF GENERIC PRESETS LISTED UNTIL THE GATEWAY PROVIDES A PRESET LIST */
+#define MONOCLE_MENU_DEFAULT_PRESETS 9
+
+/* MAXIMUM NUMBER OF MAIN MENU ITEMS ([EXIT], "Recall Home", "Recall Preset",
+   "Zoom", "Run Macro" AND "Cameras") */
+#define MONOCLE_MENU_ROOT_ITEMS 6
+
+/* PENDING MENU EVENT FLAGS (MONOCLE_MENU_EVENT_*) ARE DEFINED IN "MonocleEventBus.h" */
+
+#if MONOCLE_MENU_MAX_PRESETS > 254
+#error("MONOCLE_MENU_MAX_PRESETS cannot exceed 254 menu items")
+#endif
+
+#if MONOCLE_MENU_CAMERA_ROWS < 2 || MONOCLE_MENU_CAMERA_ROWS > 254
+#error("MONOCLE_MENU_CAMERA_ROWS must be between 2 and 254 menu items")
+#endif
+
 // Arduino-MenuSystem Library
 // @see https://github.com/jonblack/arduino-menusystem
 #include <MenuSystem.h>
+#include "MonocleEventBus.h"
+#include "MonocleScheduler.h"
+
+class MonocleMenu;
+
+/**
+ * MONOCLE MENU ITEM; CARRIES THE CONTEXT NEEDED TO DISPATCH ITS
+ * SELECTION BACK TO THE OWNING MENU INSTANCE (NO STATIC STATE)
+ */
+class MonocleMenuItem : public MenuItem
+{
+   public:
+     MonocleMenuItem(const char* name, const uint8_t event);
+
+     MonocleMenu* menu;   // owning menu instance
+     uint8_t event;       // MONOCLE_MENU_EVENT_* raised when selected
+     uint8_t index;       // zero based index (for preset items)
+};
+
+/**
+ * PRESET MENU ITEM; A SLOT IN THE PREALLOCATED PRESET (OR MACRO) POOL.
+ * UNUSED SLOTS HAVE AN EMPTY NAME AND ARE NOT RENDERED.
+ */
+class MonoclePresetMenuItem : public MonocleMenuItem
+{
+   public:
+     MonoclePresetMenuItem();
+
+     char name[MONOCLE_MENU_PRESET_NAME_LENGTH + 1];
+};
+
+/**
+ * CAMERA MENU ITEM; A ROW OF THE "Cameras" WINDOW ONTO THE GATEWAY
+ * CAMERA LIST.  ROWS BEYOND THE END OF THE LIST HAVE AN EMPTY NAME.
+ */
+class MonocleCameraMenuItem : public MonoclePresetMenuItem
+{
+   public:
+     MonocleCameraMenuItem();
+
+     char uuid[MONOCLE_MENU_CAMERA_UUID_LENGTH + 1];
+     bool loaded;         // the row holds the camera at its list position
+};
 
 class MonocleMenu
 {
    private:
       /* INTERNAL DATA ITEMS FOR MENU SYSTEM */
       MenuSystem ms;
-      MenuItem miExit;
-      MenuItem miHome;
-      MenuItem miZoom;
-      Menu mnuPresetsPage1;
-      Menu mnuPresetsPage2;
-      Menu mnuPresetsPage3;
-      Menu mnuPresetsPage4;
-      Menu mnuPresetsPage5;
-      BackMenuItem miPresetsBack1;
-      BackMenuItem miPresetsBack2;
-      BackMenuItem miPresetsBack3;
-      BackMenuItem miPresetsBack4;
-      BackMenuItem miPresetsBack5;
-      MenuItem miPreset1;
-      MenuItem miPreset2;
-      MenuItem miPreset3;
-      MenuItem miPreset4;
-      MenuItem miPreset5;
-      MenuItem miPreset6;
-      MenuItem miPreset7;
-      MenuItem miPreset8;
-      MenuItem miPreset9;
+      MonocleMenuItem miExit;
+      MonocleMenuItem miHome;
+      MonocleMenuItem miZoom;
+      Menu mnuPresets;
+      BackMenuItem miPresetsBack;
+      MonoclePresetMenuItem miPresets[MONOCLE_MENU_MAX_PRESETS];
+      int presets = 0;
+      Menu mnuMacros;
+      BackMenuItem miMacrosBack;
+      MonoclePresetMenuItem miMacros[MONOCLE_MENU_MAX_MACROS];
+      int macros = 0;
+      bool macroMenu = false;   // macros submenu attached to the main menu
+      Menu mnuCameras;
+      BackMenuItem miCamerasBack;
+      MonocleCameraMenuItem miCameras[MONOCLE_MENU_CAMERA_ROWS];
+      char camerasBackName[22];  // "[BACK]" and the window position
+      int cameras = 0;           // number of cameras in the gateway list
+      int cameraFirst = 0;       // list index of the first camera row
+      bool cameraMenu = false;   // cameras submenu attached to the main menu
+
+      /* MENU STATE (OWNED BY EACH INSTANCE) */
+      bool active = false;
+      unsigned long updateTimer = 0;
+      uint8_t pendingEvents = MONOCLE_MENU_EVENT_NONE;
+      int pendingPreset = 0;
+      int pendingMacro = 0;
+      char pendingCameraUuid[MONOCLE_MENU_CAMERA_UUID_LENGTH + 1];   // also the uuid of bus CAMERA events
 
       /* INTERNAL CALLBACKS */
-      void internal_monocle_menu_callback(MenuComponent* p_menu_component);
-      void internal_monocle_menu_exit_callback(MenuComponent* p_menu_component);
-      void internal_monocle_menu_home_callback(MenuComponent* p_menu_component);
-      void internal_monocle_menu_zoom_callback(MenuComponent* p_menu_component);
-      void internal_monocle_menu_preset1_callback(MenuComponent* p_menu_component);
-      void internal_monocle_menu_preset2_callback(MenuComponent* p_menu_component);
-      void internal_monocle_menu_preset3_callback(MenuComponent* p_menu_component);
-      void internal_monocle_menu_preset4_callback(MenuComponent* p_menu_component);
-      void internal_monocle_menu_preset5_callback(MenuComponent* p_menu_component);
-      void internal_monocle_menu_preset6_callback(MenuComponent* p_menu_component);
-      void internal_monocle_menu_preset7_callback(MenuComponent* p_menu_component);
-      void internal_monocle_menu_preset8_callback(MenuComponent* p_menu_component);
-      void internal_monocle_menu_preset9_callback(MenuComponent* p_menu_component);
-      void internal_monocle_menu_preset_callback(MenuComponent* p_menu_component, const int preset);
+      void internal_monocle_menu_callback(const uint8_t event, const uint8_t index);
+
+      /* CAMERA WINDOW */
+      int cameraRows();
+      void scrollCameras(int first);
+      void requestCameras();
+      void updateCamerasBack();
 
       /* USER CALLBACKS */
       void (*activateCallback)(void);
@@ -82,8 +175,23 @@ class MonocleMenu
       void (*homeCallback)(void);
       void (*zoomCallback)(void);
       void (*presetCallback)(const int preset);
+      void (*macroCallback)(const int macro);
+      void (*cameraCallback)(const char* uuid);
+      void (*cameraRequestCallback)(const int offset, const int count);
+
+      /* OPTIONAL EVENT BUS (MENU EVENTS) */
+      MonocleEventBus* bus = NULL;
+
+      /* SCHEDULER TASK ENTRY POINT */
+      static void internal_menu_task(void* context);
 
    public:
+     /**
+      * GENERIC DISPATCH CALLBACK FOR ALL MONOCLE MENU ITEMS
+      * (the selected item carries its owning menu, event and index)
+      */
+     static void internal_monocle_menu_dispatch(MenuComponent* p_menu_component);
+
     /**
      * Default Constructor
      */
@@ -100,6 +208,13 @@ class MonocleMenu
       */
      void loop();
 
+     /**
+      * REGISTER THIS MENU AS A TASK OF A SCHEDULER (REPLACES
+      * CALLING 'loop()' FROM THE PROGRAM MAIN LOOP).
+      * RETURNS THE TASK ID OR MONOCLE_TASK_INVALID
+      */
+     int schedule(MonocleScheduler& scheduler);
+
      /**
       * ACTIVATE THE MENU SYSTEM
       */
@@ -146,6 +261,68 @@ class MonocleMenu
       */
      void addZoomMenu();
 
+     /**
+      * REMOVE ALL PRESET MENU ITEMS
+      */
+     void clearPresets();
+
+     /**
+      * APPEND A NAMED PRESET MENU ITEM; RETURNS 'false' IF THE
+      * PREALLOCATED PRESET POOL IS FULL.  (names longer than
+      * MONOCLE_MENU_PRESET_NAME_LENGTH are truncated)
+      */
+     bool addPreset(const char* name);
+
+     /**
+      * RESTORE THE GENERIC "Preset 1" .. "Preset 9" MENU ITEMS
+      */
+     void resetPresets();
+
+     /**
+      * GET THE NUMBER OF PRESET MENU ITEMS
+      */
+     int presetCount();
+
+     /**
+      * REMOVE ALL MACRO MENU ITEMS
+      */
+     void clearMacros();
+
+     /**
+      * APPEND A NAMED MACRO MENU ITEM (THE FIRST ITEM ADDS THE
+      * "Run Macro" SUBMENU); RETURNS 'false' IF THE PREALLOCATED
+      * MACRO POOL IS FULL
+      */
+     bool addMacro(const char* name);
+
+     /**
+      * GET THE NUMBER OF MACRO MENU ITEMS
+      */
+     int macroCount();
+
+     /**
+      * THE GATEWAY CAMERA LIST CHANGED (SEE 'MonocleGatewayClient::onCameraList()');
+      * ROWS 'from' .. 'to' INSIDE THE WINDOW ARE REQUESTED AGAIN THROUGH THE
+      * CAMERA REQUEST CALLBACK.  THE FIRST CALL ADDS THE "Cameras" SUBMENU
+      */
+     void updateCameras(const int count, const int from, const int to);
+
+     /**
+      * STORE A REQUESTED CAMERA LIST ROW (SEE 'MonocleGatewayClient::onCameraEntry()');
+      * RETURNS 'false' IF THE ROW IS OUTSIDE THE WINDOW (E.G. SCROLLED AWAY)
+      */
+     bool setCamera(const int index, const char* uuid, const char* name, bool active);
+
+     /**
+      * REMOVE ALL CAMERA MENU ITEMS (E.G. WHEN THE GATEWAY IS DISCONNECTED)
+      */
+     void clearCameras();
+
+     /**
+      * GET THE NUMBER OF CAMERAS IN THE GATEWAY CAMERA LIST
+      */
+     int cameraCount();
+
      /**
       * REGISTER CALLBACK FUNCTION POINTER FOR 
       * NOTIFICATION CALLBACKS WHEN THE MENU SYSTEM
@@ -181,8 +358,34 @@ class MonocleMenu
       */
      void onPreset(void (*presetCallback)(const int));
 
-     // using for casting internally
-     using SelectFnPtr = void (*)(MenuComponent* menu_component);
+     /**
+      * REGISTER CALLBACK FUNCTION POINTER FOR 
+      * NOTIFICATION CALLBACKS WHEN ONE OF THE 'MACRO'
+      * MENU ITEMS IS SELECTED (MACROS ARE NUMBERED FROM 1)
+      */
+     void onMacro(void (*macroCallback)(const int));
+
+     /**
+      * REGISTER CALLBACK FUNCTION POINTER FOR 
+      * NOTIFICATION CALLBACKS WHEN ONE OF THE 'CAMERA'
+      * MENU ITEMS IS SELECTED (SEE 'MonocleGatewayClient::selectCamera()')
+      */
+     void onCamera(void (*cameraCallback)(const char* uuid));
+
+     /**
+      * REGISTER CALLBACK FUNCTION POINTER FOR
+      * REQUESTS OF CAMERA LIST ROWS NEEDED BY THE 'CAMERA'
+      * WINDOW (SEE 'MonocleGatewayClient::requestCameras()')
+      */
+     void onCameraRequest(void (*cameraRequestCallback)(const int offset, const int count));
+
+     /**
+      * PUBLISH MENU EVENTS (ACTIVATE, DEACTIVATE, HOME, ZOOM,
+      * PRESET, MACRO AND CAMERA) TO AN EVENT BUS; THE EVENT 'action'
+      * FIELD CARRIES THE MONOCLE_MENU_EVENT_* FLAG AND 'value' THE
+      * PRESET, MACRO OR CAMERA (ONE BASED CAMERA LIST POSITION)
+      */
+     void publishTo(MonocleEventBus* bus);
 };
 
 #endif //MONOCLE_MENU_H
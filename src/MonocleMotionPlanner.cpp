@@ -0,0 +1,371 @@
+/*
+ **********************************************************************
+ *             __  __  ___  _  _  ___   ___ _    ___
+ *            |  \/  |/ _ \| \| |/ _ \ / __| |  | __|
+ *            | |\/| | (_) | .` | (_) | (__| |__| _|
+ *            |_|  |_|\___/|_|\_|\___/ \___|____|___|
+ *
+ * -------------------------------------------------------------------
+ *                     MONOCLE MOTION PLANNER
+ * -------------------------------------------------------------------
+ *
+ *  This library adds relative (nudge) and absolute positioning on top
+ *  of the Monocle Gateway's continuous PTZ speed commands.  A move is
+ *  executed as a trapezoidal velocity profile: each axis accelerates
+ *  one speed level per stream interval up to the maximum speed,
+ *  cruises and decelerates one level per interval so the target is
+ *  reached at the slowest speed; the final partial interval is timed
+ *  to the millisecond before the axis is stopped.  The PTZ vector is
+ *  streamed to the gateway at a fixed rate while moving.
+ *
+ *  The gateway does not report the camera position; positions are
+ *  dead reckoned from the commanded speeds using the calibrated rate
+ *  (units per second) of each speed level and are referenced by HOME
+ *  or 'setPosition()'.  Any other movement of the camera (e.g. the
+ *  joystick) invalidates the reference.
+ *
+ *  If the gateway link drops or the planner is not serviced within
+ *  the motion timeout the move is aborted, a STOP is sent (as soon as
+ *  the link is back) and the position reference is invalidated.
+ *
+ *  Author:   Robert Savage
+ *  Date:     2018-02-18
+ *  Website:  http://monoclecam.com
+ *
+ * -------------------------------------------------------------------
+ *        COPYRIGHT SHADEBLUE, LLC @ 2018, ALL RIGHTS RESERVED
+ * -------------------------------------------------------------------
+ *
+ **********************************************************************
+ */
+
+#include "Arduino.h"
+#include "MonocleMotionPlanner.h"
+
+/**
+ * Default Constructor
+ */
+MonocleMotionPlanner::MonocleMotionPlanner(MonocleGatewayClient& gateway) : gateway(gateway) {
+  memset(axes, 0, sizeof(axes));
+  setRates(MONOCLE_AXIS_PAN, MONOCLE_MOTION_DEFAULT_PAN_RATES);
+  setRates(MONOCLE_AXIS_TILT, MONOCLE_MOTION_DEFAULT_TILT_RATES);
+  setRates(MONOCLE_AXIS_ZOOM, MONOCLE_MOTION_DEFAULT_ZOOM_RATES);
+
+  // initialize callbacks
+  completeCallback = NULL;
+}
+
+/**
+ * DEFINE THE RATE (UNITS PER SECOND) OF THE SLOW, MEDIUM AND FAST
+ * SPEEDS OF AN AXIS (MONOCLE_AXIS_*); MEASURE THESE FOR THE CAMERA
+ */
+void MonocleMotionPlanner::setRates(const uint8_t axis, float slow, float med, float fast){
+  if(axis >= MONOCLE_AXES) return;
+  axes[axis].rate[0] = 0;
+  axes[axis].rate[1] = slow;
+  axes[axis].rate[2] = med;
+  axes[axis].rate[3] = fast;
+}
+
+/**
+ * LIMIT THE CRUISE SPEED OF MOVES (1=SLOW, 2=MEDIUM, 3=FAST)
+ */
+void MonocleMotionPlanner::setMaxSpeed(const uint8_t level){
+  maxLevel = constrain(level, 1, 3);
+}
+
+/**
+ * DEFINE THE INTERVAL BETWEEN STREAMED PTZ COMMANDS (MILLISECONDS)
+ */
+void MonocleMotionPlanner::setStreamInterval(unsigned int milliseconds){
+  if(milliseconds > 0) streamInterval = milliseconds;
+}
+
+/**
+ * ADVANCE THE DEAD RECKONED POSITIONS TO 'now' USING THE COMMANDED SPEEDS
+ */
+void MonocleMotionPlanner::integrate(unsigned long now){
+  float seconds = (now - updateTime) / 1000.0;
+  updateTime = now;
+  for(int index = 0; index < MONOCLE_AXES; index++){
+    MotionAxis& axis = axes[index];
+    if(axis.level > 0) axis.position += axis.rate[axis.level] * seconds;
+    if(axis.level < 0) axis.position -= axis.rate[-axis.level] * seconds;
+  }
+}
+
+/**
+ * CHOOSE THE SPEED LEVEL OF AN AXIS FOR THE NEXT STREAM INTERVAL;
+ * ACCELERATE ONE LEVEL PER INTERVAL AND ONLY AS FAST AS STILL ALLOWS
+ * DECELERATING ONE LEVEL PER INTERVAL BEFORE THE TARGET
+ */
+void MonocleMotionPlanner::plan(MotionAxis& axis, unsigned long now){
+  if(axis.finishing) return;
+
+  float remaining = axis.target - axis.position;
+  float distance = fabs(remaining);
+  int8_t direction = (remaining > 0) ? 1 : -1;
+  float interval = streamInterval / 1000.0;
+
+  // a reversal first decelerates through the speed levels and
+  // then changes direction at the slowest speed
+  if(axis.level != 0 && (axis.level > 0) != (direction > 0)){
+    if(abs(axis.level) > 1){
+      axis.level -= (axis.level > 0) ? 1 : -1;
+      return;
+    }
+    axis.level = 0;
+  }
+
+  // close enough (less than a millisecond at the slowest speed)
+  if(distance < axis.rate[1] / 1000.0){
+    axis.level = 0;
+    return;
+  }
+
+  int level = min(abs(axis.level) + 1, (int)maxLevel);
+  while(level > 1){
+    float braking = 0;
+    for(int lower = 1; lower < level; lower++) braking += axis.rate[lower] * interval;
+    if(axis.rate[level] * interval + braking <= distance) break;
+    level--;
+  }
+
+  // the last (partial) interval is timed to stop on the target
+  if(level == 1 && axis.rate[1] * interval >= distance){
+    axis.finishing = true;
+    axis.finishTime = now + (unsigned long)(distance / axis.rate[1] * 1000.0 + 0.5);
+  }
+  axis.level = direction * level;
+}
+
+/**
+ * STREAM THE CURRENT PTZ VECTOR; A ZERO VECTOR COMPLETES THE MOVE
+ */
+void MonocleMotionPlanner::send(){
+  int pan = axes[MONOCLE_AXIS_PAN].level;
+  int tilt = axes[MONOCLE_AXIS_TILT].level;
+  int zoom = axes[MONOCLE_AXIS_ZOOM].level;
+
+  if(pan == 0 && tilt == 0 && zoom == 0){
+    gateway.stop();
+    moving = false;
+    if (completeCallback != NULL) completeCallback(true);
+    return;
+  }
+  gateway.ptz(pan, tilt, zoom);
+}
+
+/**
+ * START (OR RETARGET) A MOVE AND STREAM THE FIRST INTERVAL IMMEDIATELY
+ */
+void MonocleMotionPlanner::start(){
+  unsigned long now = millis();
+  if(!moving){
+    moving = true;
+    updateTime = now;
+  }
+  serviceTime = now;
+  streamTime = now;
+  integrate(now);
+  for(int index = 0; index < MONOCLE_AXES; index++){
+    axes[index].finishing = false;
+    plan(axes[index], now);
+  }
+  send();
+}
+
+/**
+ * ABORT A MOVE (LINK LOST OR NOT SERVICED); THE CAMERA MAY HAVE
+ * KEPT MOVING SO THE POSITION IS NO LONGER KNOWN
+ */
+void MonocleMotionPlanner::abort(){
+  integrate(millis());
+  for(int index = 0; index < MONOCLE_AXES; index++){
+    axes[index].level = 0;
+    axes[index].finishing = false;
+    axes[index].target = axes[index].position;
+  }
+  moving = false;
+  referenced = false;
+
+  // the STOP is sent as soon as the gateway can receive it
+  if(gateway.connected()) gateway.stop();
+  else stopPending = true;
+
+  if (completeCallback != NULL) completeCallback(false);
+}
+
+/**
+ * MOVE BY A DELTA FROM THE CURRENT POSITION (NUDGE); A MOVE IN
+ * PROGRESS IS RETARGETED. RETURNS 'false' IF THE GATEWAY IS NOT CONNECTED
+ */
+bool MonocleMotionPlanner::move(float pan, float tilt, float zoom){
+  if(!gateway.connected()) return false;
+  axes[MONOCLE_AXIS_PAN].target += pan;
+  axes[MONOCLE_AXIS_TILT].target += tilt;
+  axes[MONOCLE_AXIS_ZOOM].target += zoom;
+  start();
+  return true;
+}
+
+/**
+ * MOVE TO AN ABSOLUTE POSITION (RELATIVE TO HOME).
+ * RETURNS 'false' IF THE POSITION IS NOT REFERENCED OR THE
+ * GATEWAY IS NOT CONNECTED
+ */
+bool MonocleMotionPlanner::moveTo(float pan, float tilt, float zoom){
+  if(!referenced || !gateway.connected()) return false;
+  axes[MONOCLE_AXIS_PAN].target = pan;
+  axes[MONOCLE_AXIS_TILT].target = tilt;
+  axes[MONOCLE_AXIS_ZOOM].target = zoom;
+  start();
+  return true;
+}
+
+/**
+ * SEND THE CAMERA HOME AND REFERENCE THE POSITION TO ZERO
+ */
+void MonocleMotionPlanner::home(){
+  if(moving) stop();
+  gateway.home();
+  setPosition(0, 0, 0);
+}
+
+/**
+ * DEFINE THE CURRENT POSITION (E.G. AFTER RECALLING A PRESET
+ * WITH A KNOWN POSITION) AND MARK IT AS REFERENCED
+ */
+void MonocleMotionPlanner::setPosition(float pan, float tilt, float zoom){
+  float positions[MONOCLE_AXES] = { pan, tilt, zoom };
+  for(int index = 0; index < MONOCLE_AXES; index++){
+    axes[index].position = positions[index];
+    axes[index].target = positions[index];
+  }
+  referenced = true;
+}
+
+/**
+ * MARK THE POSITION AS UNKNOWN (CALL WHEN THE CAMERA IS MOVED
+ * BY OTHER MEANS, E.G. THE JOYSTICK)
+ */
+void MonocleMotionPlanner::invalidate(){
+  referenced = false;
+}
+
+/**
+ * DETERMINE IF ABSOLUTE POSITIONS ARE AVAILABLE
+ */
+bool MonocleMotionPlanner::isReferenced(){
+  return referenced;
+}
+
+/**
+ * GET THE DEAD RECKONED POSITION OF AN AXIS (MONOCLE_AXIS_*)
+ */
+float MonocleMotionPlanner::position(const uint8_t axis){
+  if(axis >= MONOCLE_AXES) return 0;
+  if(moving) integrate(millis());
+  return axes[axis].position;
+}
+
+/**
+ * DETERMINE IF A MOVE IS IN PROGRESS
+ */
+bool MonocleMotionPlanner::isMoving(){
+  return moving;
+}
+
+/**
+ * STOP A MOVE IN PROGRESS IMMEDIATELY
+ */
+void MonocleMotionPlanner::stop(){
+  if(!moving) return;
+  integrate(millis());
+  for(int index = 0; index < MONOCLE_AXES; index++){
+    axes[index].level = 0;
+    axes[index].finishing = false;
+    axes[index].target = axes[index].position;
+  }
+  moving = false;
+  gateway.stop();
+  if (completeCallback != NULL) completeCallback(false);
+}
+
+/**
+ * REGISTERS A CALLBACK FUNCTION POINTER FOR THE END OF A MOVE
+ * ('false' WHEN THE MOVE WAS ABORTED OR STOPPED)
+ */
+void MonocleMotionPlanner::onComplete(void (*completeCallback)(const bool completed)){
+  this->completeCallback = completeCallback;
+}
+
+/**
+ * SCHEDULER TASK ENTRY POINT
+ */
+void MonocleMotionPlanner::internal_motion_task(void* context){
+  ((MonocleMotionPlanner*)context)->loop();
+}
+
+/**
+ * REGISTER THIS PLANNER AS A TASK OF A SCHEDULER (REPLACES
+ * CALLING 'loop()' FROM THE PROGRAM MAIN LOOP).
+ * RETURNS THE TASK ID OR MONOCLE_TASK_INVALID
+ */
+int MonocleMotionPlanner::schedule(MonocleScheduler& scheduler){
+  return scheduler.every(MONOCLE_MOTION_TASK_INTERVAL, internal_motion_task, this, MONOCLE_MOTION_TASK_BUDGET);
+}
+
+/**
+ * THIS METHOD MUST BE CALLED IN THE PROGRAM MAIN LOOP
+ * (AT LEAST EVERY FEW MILLISECONDS WHILE MOVING) TO
+ * STREAM THE VELOCITY PROFILE
+ */
+void MonocleMotionPlanner::loop(){
+  unsigned long now = millis();
+
+  // deliver the STOP of an aborted move once the link is back
+  if(stopPending && gateway.connected()){
+    gateway.stop();
+    stopPending = false;
+  }
+
+  if(!moving){
+    serviceTime = now;
+    return;
+  }
+
+  // abort safely when the link drops or this planner was not serviced
+  // in time (the camera would keep moving at the last streamed speed)
+  if(!gateway.connected() || now - serviceTime > MONOCLE_MOTION_TIMEOUT){
+    serviceTime = now;
+    abort();
+    return;
+  }
+  serviceTime = now;
+
+  // stop axes whose final partial interval has elapsed (on the target)
+  bool changed = false;
+  for(int index = 0; index < MONOCLE_AXES; index++){
+    MotionAxis& axis = axes[index];
+    if(axis.finishing && (long)(now - axis.finishTime) >= 0){
+      integrate(now);
+      axis.position = axis.target;
+      axis.level = 0;
+      axis.finishing = false;
+      changed = true;
+    }
+  }
+
+  // stream the next interval of the velocity profile at a fixed rate
+  if(now - streamTime >= streamInterval){
+    streamTime = now;
+    integrate(now);
+    for(int index = 0; index < MONOCLE_AXES; index++)
+      plan(axes[index], now);
+    send();
+  }
+  else if(changed){
+    send();
+  }
+}
@@ -0,0 +1,208 @@
+/*
+ **********************************************************************
+ *             __  __  ___  _  _  ___   ___ _    ___
+ *            |  \/  |/ _ \| \| |/ _ \ / __| |  | __|
+ *            | |\/| | (_) | .` | (_) | (__| |__| _|
+ *            |_|  |_|\___/|_|\_|\___/ \___|____|___|
+ *
+ * -------------------------------------------------------------------
+ *                     MONOCLE MOTION PLANNER
+ * -------------------------------------------------------------------
+ *
+ *  This library adds relative (nudge) and absolute positioning on top
+ *  of the Monocle Gateway's continuous PTZ speed commands.  A move is
+ *  executed as a trapezoidal velocity profile: each axis accelerates
+ *  one speed level per stream interval up to the maximum speed,
+ *  cruises and decelerates one level per interval so the target is
+ *  reached at the slowest speed; the final partial interval is timed
+ *  to the millisecond before the axis is stopped.  The PTZ vector is
+ *  streamed to the gateway at a fixed rate while moving.
+ *
+ *  The gateway does not report the camera position; positions are
+ *  dead reckoned from the commanded speeds using the calibrated rate
+ *  (units per second) of each speed level and are referenced by HOME
+ *  or 'setPosition()'.  Any other movement of the camera (e.g. the
+ *  joystick) invalidates the reference.
+ *
+ *  If the gateway link drops or the planner is not serviced within
+ *  the motion timeout the move is aborted, a STOP is sent (as soon as
+ *  the link is back) and the position reference is invalidated.
+ *
+ *  Author:   Robert Savage
+ *  Date:     2018-02-18
+ *  Website:  http://monoclecam.com
+ *
+ * -------------------------------------------------------------------
+ *        COPYRIGHT SHADEBLUE, LLC @ 2018, ALL RIGHTS RESERVED
+ * -------------------------------------------------------------------
+ *
+ **********************************************************************
+ */
+#ifndef MONOCLE_MOTION_PLANNER_H
+#define MONOCLE_MOTION_PLANNER_H
+
+#include <Arduino.h>
+#include "MonocleGatewayClient.h"
+#include "MonocleScheduler.h"
+
+/* INTERVAL BETWEEN STREAMED PTZ COMMANDS (ONE SPEED LEVEL CHANGE PER INTERVAL) */
+#ifndef MONOCLE_MOTION_STREAM_INTERVAL
+#define MONOCLE_MOTION_STREAM_INTERVAL 100   // milliseconds
+#endif
+
+/* ABORT A MOVE WHEN THE PLANNER IS NOT SERVICED FOR THIS LONG */
+#ifndef MONOCLE_MOTION_TIMEOUT
+#define MONOCLE_MOTION_TIMEOUT 500           // milliseconds
+#endif
+
+/* SCHEDULER TASK INTERVAL AND EXECUTION BUDGET (THE TASK INTERVAL BOUNDS THE STOP TIMING ERROR) */
+#ifndef MONOCLE_MOTION_TASK_INTERVAL
+#define MONOCLE_MOTION_TASK_INTERVAL 5       // milliseconds
+#endif
+#ifndef MONOCLE_MOTION_TASK_BUDGET
+#define MONOCLE_MOTION_TASK_BUDGET   2000    // microseconds
+#endif
+
+/* AXIS INDEXES */
+#define MONOCLE_AXIS_PAN   0
+#define MONOCLE_AXIS_TILT  1
+#define MONOCLE_AXIS_ZOOM  2
+#define MONOCLE_AXES       3
+
+/* DEFAULT RATE OF EACH SPEED LEVEL (SLOW, MEDIUM, FAST; UNITS PER SECOND) */
+#define MONOCLE_MOTION_DEFAULT_PAN_RATES   5.0, 15.0, 45.0    // degrees per second
+#define MONOCLE_MOTION_DEFAULT_TILT_RATES  5.0, 15.0, 45.0    // degrees per second
+#define MONOCLE_MOTION_DEFAULT_ZOOM_RATES  0.25, 0.5, 1.0     // zoom steps per second
+
+class MonocleMotionPlanner
+{
+   private:
+     struct MotionAxis {
+       float rate[4];              // units per second of each speed level (0 = stopped)
+       float position;             // dead reckoned position
+       float target;
+       int8_t level;               // commanded signed speed level
+       bool finishing;             // final partial interval at the slowest speed
+       unsigned long finishTime;
+     };
+
+     MonocleGatewayClient& gateway;
+     MotionAxis axes[MONOCLE_AXES];
+     uint8_t maxLevel = 3;
+     unsigned int streamInterval = MONOCLE_MOTION_STREAM_INTERVAL;
+
+     /* MOTION STATE */
+     bool moving = false;
+     bool referenced = false;
+     bool stopPending = false;          // a STOP must reach the gateway after an abort
+     unsigned long streamTime = 0;      // time of the last streamed PTZ command
+     unsigned long updateTime = 0;      // time the positions were last integrated
+     unsigned long serviceTime = 0;     // time of the last 'loop()' call
+
+     /* CALLBACKS */
+     void (*completeCallback)(const bool completed);
+
+     /* INTERNAL PROCESSING */
+     void integrate(unsigned long now);
+     void plan(MotionAxis& axis, unsigned long now);
+     void send();
+     void start();
+     void abort();
+
+     /* SCHEDULER TASK ENTRY POINT */
+     static void internal_motion_task(void* context);
+
+   public:
+    /**
+     * Default Constructor
+     */
+     MonocleMotionPlanner(MonocleGatewayClient& gateway);
+
+     /**
+      * DEFINE THE RATE (UNITS PER SECOND) OF THE SLOW, MEDIUM AND FAST
+      * SPEEDS OF AN AXIS (MONOCLE_AXIS_*); MEASURE THESE FOR THE CAMERA
+      */
+     void setRates(const uint8_t axis, float slow, float med, float fast);
+
+     /**
+      * LIMIT THE CRUISE SPEED OF MOVES (1=SLOW, 2=MEDIUM, 3=FAST)
+      */
+     void setMaxSpeed(const uint8_t level);
+
+     /**
+      * DEFINE THE INTERVAL BETWEEN STREAMED PTZ COMMANDS (MILLISECONDS)
+      */
+     void setStreamInterval(unsigned int milliseconds);
+
+     /**
+      * MOVE BY A DELTA FROM THE CURRENT POSITION (NUDGE); A MOVE IN
+      * PROGRESS IS RETARGETED. RETURNS 'false' IF THE GATEWAY IS NOT CONNECTED
+      */
+     bool move(float pan, float tilt, float zoom);
+
+     /**
+      * MOVE TO AN ABSOLUTE POSITION (RELATIVE TO HOME).
+      * RETURNS 'false' IF THE POSITION IS NOT REFERENCED OR THE
+      * GATEWAY IS NOT CONNECTED
+      */
+     bool moveTo(float pan, float tilt, float zoom);
+
+     /**
+      * SEND THE CAMERA HOME AND REFERENCE THE POSITION TO ZERO
+      */
+     void home();
+
+     /**
+      * DEFINE THE CURRENT POSITION (E.G. AFTER RECALLING A PRESET
+      * WITH A KNOWN POSITION) AND MARK IT AS REFERENCED
+      */
+     void setPosition(float pan, float tilt, float zoom);
+
+     /**
+      * MARK THE POSITION AS UNKNOWN (CALL WHEN THE CAMERA IS MOVED
+      * BY OTHER MEANS, E.G. THE JOYSTICK)
+      */
+     void invalidate();
+
+     /**
+      * DETERMINE IF ABSOLUTE POSITIONS ARE AVAILABLE
+      */
+     bool isReferenced();
+
+     /**
+      * GET THE DEAD RECKONED POSITION OF AN AXIS (MONOCLE_AXIS_*)
+      */
+     float position(const uint8_t axis);
+
+     /**
+      * DETERMINE IF A MOVE IS IN PROGRESS
+      */
+     bool isMoving();
+
+     /**
+      * STOP A MOVE IN PROGRESS IMMEDIATELY
+      */
+     void stop();
+
+     /**
+      * REGISTERS A CALLBACK FUNCTION POINTER FOR THE END OF A MOVE
+      * ('false' WHEN THE MOVE WAS ABORTED OR STOPPED)
+      */
+     void onComplete(void (*completeCallback)(const bool completed));
+
+     /**
+      * REGISTER THIS PLANNER AS A TASK OF A SCHEDULER (REPLACES
+      * CALLING 'loop()' FROM THE PROGRAM MAIN LOOP).
+      * RETURNS THE TASK ID OR MONOCLE_TASK_INVALID
+      */
+     int schedule(MonocleScheduler& scheduler);
+
+     /**
+      * THIS METHOD MUST BE CALLED IN THE PROGRAM MAIN LOOP
+      * (AT LEAST EVERY FEW MILLISECONDS WHILE MOVING) TO
+      * STREAM THE VELOCITY PROFILE
+      */
+     void loop();
+};
+
+#endif //MONOCLE_MOTION_PLANNER_H
@@ -23,6 +23,7 @@
  **********************************************************************
  */
 
+#include <stdarg.h>
 #include <SPI.h>
 #include <Wire.h>
 #include <Adafruit_GFX.h>
@@ -63,12 +64,14 @@ MonocleOLED::MonocleOLED(const int width, const int height) : Adafruit_SSD1306()
 MonocleOLED::MonocleOLED(const int width, const int height, const int reset) : Adafruit_SSD1306(reset) {
   this->width = width;
   this->height = height;
+  if(height >= 64) this->textLineStart = 24;
 }
 
 /**
  * INITIALIZE THE OLED DISPLAY
  */
 void MonocleOLED::init() {
+  this->revision++;
   this->clearDisplay();
   this->logo();
   this->setTextColor(WHITE, 0);
@@ -100,6 +103,7 @@ void MonocleOLED::logo(bool display){
  * CLEAR THE TEXT LINES REGION (lines 1-4)
  */
 void MonocleOLED::clearText(bool display){
+  this->revision++;
   this->writeFillRect(0, this->textLineStart, this->width, this->height, BLACK);
   if(display) this->display();
 }
@@ -108,6 +112,7 @@ void MonocleOLED::clearText(bool display){
  * CLEAR TEXT LINE 1
  */
 void MonocleOLED::clearLine1(bool display){
+  this->revision++;
   this->writeFillRect(0, this->textLineStart, this->width, 8, BLACK);
   if(display) this->display();
 }
@@ -116,6 +121,7 @@ void MonocleOLED::clearLine1(bool display){
  * CLEAR TEXT LINE 2
  */
 void MonocleOLED::clearLine2(bool display){
+  this->revision++;
   this->writeFillRect(0, this->textLineStart+this->textLineHeight, this->width, 8, BLACK);
   if(display) this->display();
 }
@@ -124,6 +130,7 @@ void MonocleOLED::clearLine2(bool display){
  * CLEAR TEXT LINE 3
  */
 void MonocleOLED::clearLine3(bool display){
+  this->revision++;
   this->writeFillRect(0, this->textLineStart+(this->textLineHeight * 2), this->width, 8, BLACK);
   if(display) this->display();
 }
@@ -132,35 +139,97 @@ void MonocleOLED::clearLine3(bool display){
  * CLEAR TEXT LINE 4
  */
 void MonocleOLED::clearLine4(bool display){
+  this->revision++;
   this->writeFillRect(0, this->textLineStart+(this->textLineHeight * 3), this->width, 8, BLACK);
   if(display) this->display();
 }
 
+/**
+ * GET THE NUMBER OF TEXT LINES AVAILABLE ON THIS DISPLAY
+ * (4 lines on a 128x32 display; 5 lines below the logo on 128x64)
+ */
+int MonocleOLED::textLineCount(){
+  return (this->height - this->textLineStart) / this->textLineHeight;
+}
+
+/**
+ * GET THE TEXT REGION REVISION; IT CHANGES WHENEVER THE TEXT LINES ARE
+ * CLEARED OR PRINTED SO A RENDERER CAN TELL IF ITS LAST FRAME IS STILL
+ * ON THE DISPLAY (DRAWING THROUGH 'Adafruit_SSD1306' IS NOT TRACKED)
+ */
+unsigned int MonocleOLED::textRevision(){
+  return this->revision;
+}
+
+/**
+ * DRAW A VERTICAL SCROLLBAR ALONG THE RIGHT EDGE OF THE TEXT REGION
+ * INDICATING THE VISIBLE WINDOW (first, visible) WITHIN A LIST OF
+ * 'total' ITEMS
+ */
+void MonocleOLED::scrollbar(const int first, const int visible, const int total, bool display){
+  this->revision++;
+  // the scrollbar occupies the two rightmost pixel columns; a full line
+  // of text at size 1 (21 chars * 6 pixels) never reaches this region
+  int top = this->textLineStart;
+  int trackHeight = this->textLineCount() * this->textLineHeight;
+  this->writeFillRect(this->width - 2, top, 2, trackHeight, BLACK);
+
+  if(total > visible && total > 0){
+    int thumbHeight = (trackHeight * visible) / total;
+    if(thumbHeight < 2) thumbHeight = 2;
+    int thumbTop = top + (trackHeight * first) / total;
+    if(thumbTop + thumbHeight > top + trackHeight) thumbTop = top + trackHeight - thumbHeight;
+    this->writeFillRect(this->width - 2, thumbTop, 2, thumbHeight, WHITE);
+  }
+  if(display) this->display();
+}
+
 /**
  * PRINT TEXT TO A SPECIFIC LINE NUMBER
  */
 void MonocleOLED::printLine(const int line, const String& data, bool display, bool center){
-  this->writeFillRect(0, (line*this->textLineHeight) + this->textLineStart, 128, 8, BLACK);
-  this->setCursor(0, (line*this->textLineHeight) + this->textLineStart);
+  this->printLine(line, data.c_str(), display, center);
+}
+void MonocleOLED::printLine(const int line, const char* data, bool display, bool center){
+  this->revision++;
+  int y = (line*this->textLineHeight) + this->textLineStart;
+  this->writeFillRect(0, y, this->width, this->textLineHeight, BLACK);
+
+  // copy into the fixed line buffer; anything beyond a single line is truncated
+  if(data != lineBuffer) strncpy(lineBuffer, data, LINE_CHARACTER_WIDTH_1);
+  lineBuffer[LINE_CHARACTER_WIDTH_1] = '\0';
 
-  // pad for text centering
+  // offset the cursor for text centering (rather than padding with spaces)
+  int x = 0;
   if(center){
-  int pad = LINE_CHARACTER_WIDTH_1 - data.length();
-    if(pad > 0){
-      for(int x = 0; x < pad; x = x+2){
-        this->print(" ");
-      }
-    }
+    int pad = LINE_CHARACTER_WIDTH_1 - (int)strlen(lineBuffer);
+    if(pad > 0) x = ((pad + 1) / 2) * LINE_CHARACTER_PIXELS_1;
   }
 
-  this->println(data);
+  this->setCursor(x, y);
+  this->print(lineBuffer);
   if(display) this->display();
 }
 
+/**
+ * PRINT FORMATTED (PRINTF-STYLE) TEXT TO A SPECIFIC LINE NUMBER
+ * (output is truncated to the width of a single text line)
+ */
+void MonocleOLED::printLinef(const int line, bool display, bool center, const char* format, ...){
+  va_list args;
+  va_start(args, format);
+  vsnprintf(lineBuffer, sizeof(lineBuffer), format, args);
+  va_end(args);
+  this->printLine(line, lineBuffer, display, center);
+}
+
 /**
  * PRINT TEXT TO LINE 1
  */
 void MonocleOLED::printLine1(const String& data, bool display, bool center){
+  this->printLine(0, data.c_str(), display, center);
+}
+void MonocleOLED::printLine1(const char* data, bool display, bool center){
   this->printLine(0, data, display, center);
 }
 
@@ -168,6 +237,9 @@ void MonocleOLED::printLine1(const String& data, bool display, bool center){
  * PRINT TEXT TO LINE 2
  */
 void MonocleOLED::printLine2(const String& data, bool display, bool center){
+  this->printLine(1, data.c_str(), display, center);
+}
+void MonocleOLED::printLine2(const char* data, bool display, bool center){
   this->printLine(1, data, display, center);
 }
 
@@ -175,6 +247,9 @@ void MonocleOLED::printLine2(const String& data, bool display, bool center){
  * PRINT TEXT TO LINE 3
  */
 void MonocleOLED::printLine3(const String& data, bool display, bool center){
+  this->printLine(2, data.c_str(), display, center);
+}
+void MonocleOLED::printLine3(const char* data, bool display, bool center){
   this->printLine(2, data, display, center);
 }
 
@@ -182,6 +257,9 @@ void MonocleOLED::printLine3(const String& data, bool display, bool center){
  * PRINT TEXT TO LINE 4
  */
 void MonocleOLED::printLine4(const String& data, bool display, bool center){
+  this->printLine(3, data.c_str(), display, center);
+}
+void MonocleOLED::printLine4(const char* data, bool display, bool center){
   this->printLine(3, data, display, center);
 }
 
@@ -190,6 +268,10 @@ void MonocleOLED::printLine4(const String& data, bool display, bool center){
  */
 void MonocleOLED::printText(const String& line1, const String& line2,
      const String& line3, const String& line4, bool display, bool center){
+  this->printText(line1.c_str(), line2.c_str(), line3.c_str(), line4.c_str(), display, center);
+}
+void MonocleOLED::printText(const char* line1, const char* line2,
+     const char* line3, const char* line4, bool display, bool center){
   this->printLine1(line1, false, center);
   this->printLine2(line2, false, center);
   this->printLine3(line3, false, center);
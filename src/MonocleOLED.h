@@ -30,6 +30,9 @@
 /* NUMBER OF TEXT CHARACTERS PER LINE AT TEXT SIZE 1 */
 #define LINE_CHARACTER_WIDTH_1  21
 
+/* NUMBER OF PIXELS PER TEXT CHARACTER AT TEXT SIZE 1 */
+#define LINE_CHARACTER_PIXELS_1  6
+
 class MonocleOLED : public Adafruit_SSD1306
 {
    private:
@@ -38,6 +41,12 @@ class MonocleOLED : public Adafruit_SSD1306
      int textLineStart = 0;
      int textLineHeight = 8;
 
+     /* FIXED TEXT LINE BUFFER; USED FOR FORMATTING WITHOUT HEAP ALLOCATIONS */
+     char lineBuffer[LINE_CHARACTER_WIDTH_1 + 1];
+
+     /* INCREMENTED BY EVERY TEXT REGION CHANGE (SEE 'textRevision()') */
+     unsigned int revision = 0;
+
    public:
     /*
      * Default Constructors
@@ -80,35 +89,68 @@ class MonocleOLED : public Adafruit_SSD1306
      */
      void clearLine4(bool display = true);
 
+     /**
+      * GET THE NUMBER OF TEXT LINES AVAILABLE ON THIS DISPLAY
+      * (4 lines on a 128x32 display; 5 lines below the logo on 128x64)
+      */
+     int textLineCount();
+
+     /**
+      * GET THE TEXT REGION REVISION; IT CHANGES WHENEVER THE TEXT LINES ARE
+      * CLEARED OR PRINTED SO A RENDERER CAN TELL IF ITS LAST FRAME IS STILL
+      * ON THE DISPLAY (DRAWING THROUGH 'Adafruit_SSD1306' IS NOT TRACKED)
+      */
+     unsigned int textRevision();
+
+     /**
+      * DRAW A VERTICAL SCROLLBAR ALONG THE RIGHT EDGE OF THE TEXT REGION
+      * INDICATING THE VISIBLE WINDOW (first, visible) WITHIN A LIST OF
+      * 'total' ITEMS
+      */
+     void scrollbar(const int first, const int visible, const int total, bool display = true);
+
      /**
       * PRINT TEXT TO MULTIPLE LINES
       */
      void printText(const String& line1 = "", const String& line2 = "", const String& line3 = "", const String& line4 = "", bool display = true, bool center = false);
+     void printText(const char* line1, const char* line2 = "", const char* line3 = "", const char* line4 = "", bool display = true, bool center = false);
 
      /**
       * PRINT TEXT TO A SPECIFIC LINE NUMBER
       */
      void printLine(const int line, const String& data, bool display = true, bool center = false);
+     void printLine(const int line, const char* data, bool display = true, bool center = false);
+
+     /**
+      * PRINT FORMATTED (PRINTF-STYLE) TEXT TO A SPECIFIC LINE NUMBER
+      * (output is truncated to the width of a single text line)
+      */
+     void printLinef(const int line, bool display, bool center, const char* format, ...)
+        __attribute__((format(printf, 5, 6)));
 
      /**
       * PRINT TEXT TO LINE 1
       */
      void printLine1(const String& data, bool display = true, bool center = false);
+     void printLine1(const char* data, bool display = true, bool center = false);
 
      /**
       * PRINT TEXT TO LINE 2
       */
      void printLine2(const String& data, bool display = true, bool center = false);
+     void printLine2(const char* data, bool display = true, bool center = false);
 
      /**
       * PRINT TEXT TO LINE 3
       */
      void printLine3(const String& data, bool display = true, bool center = false);
+     void printLine3(const char* data, bool display = true, bool center = false);
 
      /**
       * PRINT TEXT TO LINE 4
       */
      void printLine4(const String& data, bool display = true, bool center = false);
+     void printLine4(const char* data, bool display = true, bool center = false);
 };
 
 #endif //MONOCLE_OLED_H
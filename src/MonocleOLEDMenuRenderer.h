@@ -32,12 +32,168 @@
 // Monocle Libraries
 #include "MonocleOLED.h"
 #include "MonocleMenu.h"
+#include "MonocleFlashMenu.h"
 
-class MonocleOLEDMenuRenderer : public MenuComponentRenderer {
+/* MAXIMUM NUMBER OF TEXT ROWS TRACKED FOR ROW-BY-ROW (PARTIAL) REDRAWS */
+#ifndef MONOCLE_OLED_MENU_MAX_ROWS
+#define MONOCLE_OLED_MENU_MAX_ROWS 8
+#endif
+
+class MonocleOLEDMenuRenderer : public MenuComponentRenderer, public MonocleFlashMenuRenderer {
 
   private:
     MonocleOLED* display;
+
+    /* VIEWPORT STATE; THE FIRST VISIBLE ROW OF THE LAST RENDERED MENU */
+    mutable const void* viewportMenu;
+    mutable int viewportFirst;
+
+    /* LAST RENDERED FRAME; A HASH OF EACH ROW SO ONLY CHANGED ROWS ARE REDRAWN */
+    mutable uint32_t rowHash[MONOCLE_OLED_MENU_MAX_ROWS];
+    mutable int renderedFirst;
+    mutable int renderedCount;
+    mutable unsigned int renderedRevision;
+    mutable bool rendered;
+
+    /**
+     * FNV-1a hash of a row's text and its selection state; an
+     * empty row hashes to zero.
+     */
+    static uint32_t hashRow(bool current, const char* name) {
+        uint32_t hash = 2166136261UL;
+        hash = (hash ^ (current ? '>' : ' ')) * 16777619UL;
+        while (name != NULL && *name != '\0')
+            hash = (hash ^ (uint8_t)*name++) * 16777619UL;
+        return (hash == 0) ? 1 : hash;
+    }
   
+    /**
+     * Menus may carry a preallocated pool of items where the
+     * unused slots have an empty name.  Unused slots always trail
+     * the used items, so the number of visible components is
+     * found with a binary search rather than a full scan.
+     */
+    static int visibleComponents(Menu const& menu) {
+        int low = 0;
+        int high = menu.get_num_components();
+        while (low < high) {
+            int mid = (low + high) / 2;
+            const char* name = menu.get_menu_component(mid)->get_name();
+            if (name != NULL && name[0] != '\0')
+                low = mid + 1;
+            else
+                high = mid;
+        }
+        return low;
+    }
+
+    /**
+     * A flash menu and the buffer its item names are copied into
+     */
+    struct FlashItems {
+        MonocleFlashMenu const* menu;
+        char* buffer;
+    };
+
+    /**
+     * Name of a 'Menu' component for 'renderList()'
+     */
+    static const char* menuItemName(const void* menu, int index) {
+        return static_cast<Menu const*>(menu)->get_menu_component(index)->get_name();
+    }
+
+    /**
+     * Name of a 'MonocleFlashMenu' item for 'renderList()' (copied out of flash)
+     */
+    static const char* flashItemName(const void* items, int index) {
+        FlashItems const* flash = static_cast<FlashItems const*>(items);
+        return flash->menu->itemName(index, flash->buffer);
+    }
+
+    /**
+     * Render a list of 'count' items with the cursor on 'current';
+     * 'key' identifies the (sub)menu and 'name' gets an item's name.
+     * Only the rows inside the scroll window (viewport) are
+     * considered, so the cost of a frame is independent of the
+     * number of menu items, and of those only the rows whose text
+     * or selection changed since the last frame are redrawn.  An
+     * unchanged frame is not sent to the display at all.
+     */
+    void renderList(const void* key, int count, int current,
+                    const char* (*name)(const void*, int), const void* menu) const {
+
+        int rows = display->textLineCount();
+        if(rows > MONOCLE_OLED_MENU_MAX_ROWS) rows = MONOCLE_OLED_MENU_MAX_ROWS;
+
+        // redraw everything when a different (sub)menu is displayed or
+        // something else was drawn to the text region since the last frame
+        bool full = !rendered || display->textRevision() != renderedRevision;
+
+        // reset the viewport when a different (sub)menu is displayed
+        if(key != viewportMenu){
+            viewportMenu = key;
+            viewportFirst = 0;
+            full = true;
+        }
+
+        // keep the scroll window positioned around the current item
+        if(current < viewportFirst)
+            viewportFirst = current;
+        else if(current >= viewportFirst + rows)
+            viewportFirst = current - rows + 1;
+        if(viewportFirst > count - rows)
+            viewportFirst = (count > rows) ? count - rows : 0;
+
+        // clear the display first
+        if(full){
+            display->clearText(false);
+            for (int row = 0; row < rows; ++row) rowHash[row] = 0;
+        }
+
+        // next, iterate only the visible menu items; rows are redrawn
+        // only when their content differs from the last rendered frame
+        bool changed = full;
+        for (int row = 0; row < rows; ++row) {
+            const char* text = NULL;
+            bool selected = (viewportFirst + row) == current;
+            uint32_t hash = 0;
+            if((viewportFirst + row) < count){
+                // get the menu item name by index
+                text = name(menu, viewportFirst + row);
+                hash = hashRow(selected, text);
+            }
+            if(hash == rowHash[row]) continue;
+            rowHash[row] = hash;
+            changed = true;
+
+            // print the menu item name to the OLED display; prefix
+            // with a '>' indicator character if this is the current
+            // selected menu item. (formatted into the display's fixed
+            // line buffer so that no heap allocations are required)
+            if(text != NULL)
+                display->printLinef(row, false, false, "%c %s", selected ? '>' : ' ', text);
+            else
+                display->printLine(row, "", false);
+        }
+
+        // redraw the scrollbar indicator when the menu does not fit the display
+        // (a redrawn row clears its part of the scrollbar; a menu that now
+        // fits the display clears a scrollbar left by the last frame)
+        if(changed || viewportFirst != renderedFirst || count != renderedCount){
+            if(count > rows || renderedCount > rows)
+                display->scrollbar(viewportFirst, rows, count, false);
+            changed = true;
+        }
+        renderedFirst = viewportFirst;
+        renderedCount = count;
+
+        // send the frame to the display only when something was redrawn
+        if(changed)
+            display->display();
+        renderedRevision = display->textRevision();
+        rendered = true;
+    }
+
   public:
 
     /*
@@ -45,38 +201,39 @@ class MonocleOLEDMenuRenderer : public MenuComponentRenderer {
      */
     MonocleOLEDMenuRenderer(MonocleOLED* display){
       this->display = display;
+      this->viewportMenu = NULL;
+      this->viewportFirst = 0;
+      this->renderedFirst = 0;
+      this->renderedCount = 0;
+      this->renderedRevision = 0;
+      invalidate();
     }
 
     /**
-     * This method is invoked whenever we need to render the 
-     * current menu to the OLED display
+     * Force the next frame to redraw every row; only needed after
+     * drawing to the display through 'Adafruit_SSD1306' directly
+     * (drawing through 'MonocleOLED' is detected automatically).
      */
-    void render(Menu const& menu) const {
+    void invalidate() const {
+        rendered = false;
+    }
 
-        // clear the display first
-        display->clearText(false);
-
-        // next, iterate the available menu items
-        for (int i = 0; i < menu.get_num_components(); ++i) {
-            // get the menu item instance by index
-            MenuComponent const* cp_m_comp = menu.get_menu_component(i);
-
-            // build a string to diplay the menu item name; 
-            // prefix with a '>' indicator character if this 
-            // is the current selected menu item.
-            String name = "  ";
-            if (cp_m_comp->is_current())
-                name  = "> ";
-                
-            // append the menu item name
-            name += cp_m_comp->get_name();
-
-            // print the menu item string to the OLED display
-            display->printLine(i, name, false);            
-        }
+    /**
+     * This method is invoked whenever we need to render the
+     * current menu to the OLED display.
+     */
+    void render(Menu const& menu) const {
+        renderList(&menu, visibleComponents(menu), menu.get_current_component_num(), menuItemName, &menu);
+    }
 
-        // force the display to redraw now
-        display->display();                
+    /**
+     * This method is invoked whenever we need to render the
+     * current flash menu to the OLED display.
+     */
+    void render(MonocleFlashMenu const& menu) const {
+        char buffer[MONOCLE_FLASH_MENU_NAME_LENGTH + 1];
+        FlashItems items = { &menu, buffer };
+        renderList(menu.currentMenu(), menu.itemCount(), menu.position(), flashItemName, &items);
     }
 
     // the remainder of the interface are no-impl stubs.
@@ -28,14 +28,23 @@
 #include "Arduino.h"
 #include <Bounce2.h>
 #include "MonoclePTZJoystick.h"
+#include "MonocleRecorder.h"
 
-bool processRead(PinData &pin){
+bool processRead(PinData &pin, int (*reader)(uint8_t), MonocleRecorder* recorder){
 
   // abort for any pin that is not configured
   if(pin.pin < 0) return false;
 
-  // get immediate analog pin value
-  int value  = (pin.inverted) ? (analogRead(pin.pin) - pin.midpoint)*-1 : analogRead(pin.pin) - pin.midpoint;
+  // get immediate analog pin value (from the injected reader when replaying)
+  int sample = (reader != NULL) ? reader(pin.pin) : analogRead(pin.pin);
+
+  // record raw samples that moved beyond the recorder deadband
+  if(recorder != NULL && abs(sample - pin.sample) >= MONOCLE_RECORDER_ANALOG_DEADBAND){
+    pin.sample = sample;
+    recorder->record(MONOCLE_RECORD_ANALOG, pin.pin, sample);
+  }
+
+  int value  = (pin.inverted) ? (sample - pin.midpoint)*-1 : sample - pin.midpoint;
   // compare the immediate value with the last known value and the buffer delta
   if(abs(value - pin.value) > pin.buffer){
     pin.value = value;
@@ -161,6 +170,7 @@ void MonoclePTZJoystick::setupButton(const int digitalPin, const int debounceInt
   // configure the 'select' pin for DEBOUNCE
   // @see: https://www.arduino.cc/en/Tutorial/Debounce
   // @see: https://github.com/thomasfredericks/Bounce2
+  buttonPin = digitalPin;
   debouncer.attach(digitalPin);
   debouncer.interval(debounceInterval);   // interval in milliseconds
 }
@@ -343,6 +353,62 @@ void MonoclePTZJoystick::invertZoomAxis(bool invert){
   zoom.inverted = invert;
 }
 
+/**
+ * THIS INTERNAL FUNCTION AVERAGES ANALOG SAMPLES OF AN AXIS
+ * AT REST AND STORES THEM AS THE AXIS CENTER
+ */
+void calibrateAxis(PinData &pin){
+  if(pin.pin < 0) return;
+  long total = 0;
+  for(int sample = 0; sample < JOYSTICK_CALIBRATION_SAMPLES; sample++){
+    total += analogRead(pin.pin);
+  }
+  pin.midpoint = total / JOYSTICK_CALIBRATION_SAMPLES;
+  pin.value = 0;
+}
+
+/**
+ * SAMPLE THE RESTING POSITION OF EACH CONFIGURED AXIS AND USE IT
+ * AS THE AXIS CENTER (THE JOYSTICK MUST NOT BE TOUCHED)
+ */
+void MonoclePTZJoystick::calibrate(){
+  calibrateAxis(pan);
+  calibrateAxis(tilt);
+  calibrateAxis(zoom);
+}
+
+/**
+ * GET THE CURRENT AXIS CENTERS, THRESHOLDS, BUFFERS AND INVERSION
+ */
+void MonoclePTZJoystick::getCalibration(MonocleJoystickCalibration& calibration){
+  PinData* axes[3] = { &pan, &tilt, &zoom };
+  calibration.inverted = 0;
+  for(int index = 0; index < 3; index++){
+    calibration.midpoint[index] = axes[index]->midpoint;
+    calibration.low[index] = axes[index]->threshold.low;
+    calibration.med[index] = axes[index]->threshold.med;
+    calibration.high[index] = axes[index]->threshold.high;
+    calibration.buffer[index] = axes[index]->buffer;
+    if(axes[index]->inverted) calibration.inverted |= (1 << index);
+  }
+}
+
+/**
+ * APPLY PREVIOUSLY SAVED AXIS CENTERS, THRESHOLDS, BUFFERS AND INVERSION
+ */
+void MonoclePTZJoystick::setCalibration(const MonocleJoystickCalibration& calibration){
+  PinData* axes[3] = { &pan, &tilt, &zoom };
+  for(int index = 0; index < 3; index++){
+    axes[index]->midpoint = calibration.midpoint[index];
+    axes[index]->threshold.low = calibration.low[index];
+    axes[index]->threshold.med = calibration.med[index];
+    axes[index]->threshold.high = calibration.high[index];
+    axes[index]->buffer = calibration.buffer[index];
+    axes[index]->inverted = (calibration.inverted & (1 << index)) != 0;
+    axes[index]->value = 0;
+  }
+}
+
 /**
  * GET THE LAST REPORTED/PROCESSED PAN ANALOG VALUE
  */
@@ -392,6 +458,15 @@ void MonoclePTZJoystick::setPTZEventDelay(unsigned int milliseconds){
   ptzEventDelay = milliseconds;
 }
 
+/**
+ * DEFINE THE MINIMUM INTERVAL BETWEEN ANALOG AXIS SAMPLES
+ * (0 = SAMPLE ON EVERY LOOP); A LONGER INTERVAL REDUCES
+ * ADC ACTIVITY WHILE THE JOYSTICK IS IDLE
+ */
+void MonoclePTZJoystick::setSampleInterval(unsigned int milliseconds){
+  sampleInterval = milliseconds;
+}
+
 /**
  * ENABLE OR DISABLE MULTISTATE PTZ EVENTS
  * ---------------------------------------------
@@ -418,6 +493,65 @@ void MonoclePTZJoystick::onButtonPress(void (*buttonCallback)(void)){
   this->buttonCallback = buttonCallback;
 }
 
+/**
+ * PUBLISH PTZ AND BUTTON EVENTS TO AN EVENT BUS
+ * (in addition to any registered callbacks)
+ */
+void MonoclePTZJoystick::publishTo(MonocleEventBus* bus){
+  this->bus = bus;
+}
+
+/**
+ * REPLACE 'analogRead()' FOR THE AXIS SAMPLES (E.G. TO REPLAY
+ * A RECORDED SESSION); NULL RESTORES 'analogRead()'
+ */
+void MonoclePTZJoystick::setAnalogReader(int (*analogReader)(uint8_t pin)){
+  this->analogReader = analogReader;
+}
+
+/**
+ * RECORD THE RAW AXIS SAMPLES (CHANGES LARGER THAN
+ * MONOCLE_RECORDER_ANALOG_DEADBAND) AND BUTTON PRESSES
+ * AND RELEASES TO A SESSION RECORDER
+ */
+void MonoclePTZJoystick::recordTo(MonocleRecorder* recorder){
+  this->recorder = recorder;
+  pan.sample = tilt.sample = zoom.sample = -1;   // record the current samples
+}
+
+/**
+ * RAISE A BUTTON PRESS AS IF THE JOYSTICK BUTTON WAS PRESSED
+ */
+void MonoclePTZJoystick::pressButton(){
+  if (recorder != NULL) recorder->record(MONOCLE_RECORD_BUTTON, buttonPin, 1);
+  if (buttonCallback != NULL) buttonCallback();
+  if (bus != NULL) bus->publishButton();
+}
+
+/**
+ * RAISE THE PTZ STATE TO CALLBACK AND EVENT BUS
+ */
+void MonoclePTZJoystick::raisePTZ(){
+  if (ptzCallback != NULL) ptzCallback(pan.state, tilt.state, zoom.state);
+  if (bus != NULL) bus->publishPTZ(pan.state, tilt.state, zoom.state);
+}
+
+/**
+ * SCHEDULER TASK ENTRY POINT
+ */
+void MonoclePTZJoystick::internal_joystick_task(void* context){
+  ((MonoclePTZJoystick*)context)->loop();
+}
+
+/**
+ * REGISTER THIS JOYSTICK AS A TASK OF A SCHEDULER (REPLACES
+ * CALLING 'loop()' FROM THE PROGRAM MAIN LOOP).
+ * RETURNS THE TASK ID OR MONOCLE_TASK_INVALID
+ */
+int MonoclePTZJoystick::schedule(MonocleScheduler& scheduler){
+  return scheduler.every(JOYSTICK_TASK_INTERVAL, internal_joystick_task, this, JOYSTICK_TASK_BUDGET);
+}
+
 /**
  * THIS METHOD MUST BE CALLED IN THE PROGRAM MAIN LOOP
  * TO SERVICE THIS CLASS AND PROCESS THESHOLD EVALUATIONS
@@ -429,31 +563,38 @@ void MonoclePTZJoystick::loop() {
   bool zoomChanged = false;
 
   // read analog pin values and if a change is detected, then process the updated pin value against its threshold
-  if(processRead(pan))  panChanged = processThreshold(pan, multistateDisabled);
-  if(processRead(tilt)) tiltChanged = processThreshold(tilt, multistateDisabled);
-  if(processRead(zoom)) zoomChanged = processThreshold(zoom, multistateDisabled);
+  // (only once per sample interval when one is defined)
+  if(sampleInterval == 0 || millis() - sampleTime >= sampleInterval){
+    sampleTime = millis();
+    if(processRead(pan, analogReader, recorder))  panChanged = processThreshold(pan, multistateDisabled);
+    if(processRead(tilt, analogReader, recorder)) tiltChanged = processThreshold(tilt, multistateDisabled);
+    if(processRead(zoom, analogReader, recorder)) zoomChanged = processThreshold(zoom, multistateDisabled);
+  }
 
   // detemine if a state has changed and we need to event the PTZ change via callback
   if(panChanged || tiltChanged || zoomChanged) {
-    if (ptzCallback != NULL) {
+    if (ptzCallback != NULL || bus != NULL) {
       if(ptzEventDelay > 0)
         ptzEventTime = millis(); // set a timer for a buffer time between PTZ events
       else
-        ptzCallback(pan.state, tilt.state, zoom.state);
+        raisePTZ();
     }
   }
 
   // if there is a pending callback waiting, then send it after the elaspsed timer
   if(ptzEventTime > 0 && millis() - ptzEventTime > ptzEventDelay){
-    if (ptzCallback != NULL) ptzCallback(pan.state, tilt.state, zoom.state);
+    raisePTZ();
     ptzEventTime = 0; // reset timer
   }
 
   // update the bounce instance for the joystick button
   debouncer.update();
 
-  // determine if the button was pressed
+  // determine if the button was pressed (presses and releases are recorded)
   if(debouncer.fell()){
-    if (buttonCallback != NULL) buttonCallback();
+    pressButton();
+  }
+  else if(recorder != NULL && debouncer.rose()){
+    recorder->record(MONOCLE_RECORD_BUTTON, buttonPin, 0);
   }
 }
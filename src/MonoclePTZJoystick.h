@@ -28,6 +28,10 @@
 #define MONOCLE_PTZ_JOYSTICK_H
 
 #include <Bounce2.h>
+#include "MonocleEventBus.h"
+#include "MonocleScheduler.h"
+
+class MonocleRecorder;
 
 #define JOYSTICK_AXIS_HIGH 3
 #define JOYSTICK_AXIS_MED  2
@@ -38,9 +42,20 @@
 #define JOYSTICK_DEFAULT_LOW_THRESHOLD   1000
 #define JOYSTICK_DEFAULT_PTZ_EVENT_DELAY 100   // milliseconds
 
+/* NUMBER OF ANALOG SAMPLES AVERAGED TO FIND EACH AXIS CENTER */
+#define JOYSTICK_CALIBRATION_SAMPLES 16
+
+/* SCHEDULER TASK INTERVAL AND EXECUTION BUDGET */
+#ifndef JOYSTICK_TASK_INTERVAL
+#define JOYSTICK_TASK_INTERVAL 10     // milliseconds
+#endif
+#ifndef JOYSTICK_TASK_BUDGET
+#define JOYSTICK_TASK_BUDGET   2000   // microseconds (three analog reads)
+#endif
+
 struct PinThreshold {
-  int high;
-  int med;
+  int high = 0;   // 0 = disabled
+  int med = 0;    // 0 = disabled
   int low = JOYSTICK_DEFAULT_LOW_THRESHOLD;
 };
 
@@ -54,6 +69,20 @@ struct PinData {
   bool inverted = false;
   int state = JOYSTICK_AXIS_OFF;
   int buffer = JOYSTICK_DEFAULT_BUFFER;
+  int sample = -1;      // last raw sample recorded (session recorder)
+};
+
+/**
+ * JOYSTICK CALIBRATION FOR PERSISTING AND RESTORING
+ * (EACH ARRAY IS ORDERED PAN, TILT, ZOOM)
+ */
+struct MonocleJoystickCalibration {
+  int16_t midpoint[3];
+  int16_t low[3];
+  int16_t med[3];
+  int16_t high[3];
+  int16_t buffer[3];
+  uint8_t inverted;     // one bit per axis
 };
 
 class MonoclePTZJoystick
@@ -62,6 +91,7 @@ class MonoclePTZJoystick
     /* CREATE A BOUND INSTANCE */
     /* @see: https://github.com/thomasfredericks/Bounce2 */
     Bounce debouncer = Bounce();
+    int buttonPin = -1;
 
     /* DATA STRUCTURE FOR EACH AXIS */
     PinData pan;
@@ -72,9 +102,26 @@ class MonoclePTZJoystick
     void (*ptzCallback)(int pan, int tilt, int zoom);
     void (*buttonCallback)(void);
 
+    /* OPTIONAL EVENT BUS (PTZ AND BUTTON EVENTS) */
+    MonocleEventBus* bus = NULL;
+
+    /* ANALOG INPUT READER (NULL = 'analogRead') AND OPTIONAL SESSION RECORDER */
+    int (*analogReader)(uint8_t pin) = NULL;
+    MonocleRecorder* recorder = NULL;
+
+    /* RAISE THE PTZ STATE TO CALLBACK AND EVENT BUS */
+    void raisePTZ();
+
+    /* SCHEDULER TASK ENTRY POINT */
+    static void internal_joystick_task(void* context);
+
     /* event delay timer */
     unsigned int ptzEventTime = 0;
     unsigned int ptzEventDelay = JOYSTICK_DEFAULT_PTZ_EVENT_DELAY;
+
+    /* analog sample timer (0 = sample on every loop) */
+    unsigned long sampleTime = 0;
+    unsigned int sampleInterval = 0;
     bool multistateDisabled = false;
 
    public:
@@ -227,11 +274,34 @@ class MonoclePTZJoystick
       */     
      void invertZoomAxis(bool invert);
 
+     /**
+      * SAMPLE THE RESTING POSITION OF EACH CONFIGURED AXIS AND USE IT
+      * AS THE AXIS CENTER (THE JOYSTICK MUST NOT BE TOUCHED)
+      */
+     void calibrate();
+
+     /**
+      * GET THE CURRENT AXIS CENTERS, THRESHOLDS, BUFFERS AND INVERSION
+      */
+     void getCalibration(MonocleJoystickCalibration& calibration);
+
+     /**
+      * APPLY PREVIOUSLY SAVED AXIS CENTERS, THRESHOLDS, BUFFERS AND INVERSION
+      */
+     void setCalibration(const MonocleJoystickCalibration& calibration);
+
      /**
       * DEFINE AN EVENT DELAY FOR PTZ STATE CHANGE EVENTS
       */
      void setPTZEventDelay(unsigned int milliseconds);
 
+     /**
+      * DEFINE THE MINIMUM INTERVAL BETWEEN ANALOG AXIS SAMPLES
+      * (0 = SAMPLE ON EVERY LOOP); A LONGER INTERVAL REDUCES
+      * ADC ACTIVITY WHILE THE JOYSTICK IS IDLE
+      */
+     void setSampleInterval(unsigned int milliseconds);
+
      /**
       * REGISTERS A CALLBACK FUNCTION POINTER FOR JOYSTICK AXIS STATE CHANGE EVENTS
       */
@@ -242,6 +312,30 @@ class MonoclePTZJoystick
       */     
      void onButtonPress(void (*buttonCallback)(void));
 
+     /**
+      * PUBLISH PTZ AND BUTTON EVENTS TO AN EVENT BUS
+      * (in addition to any registered callbacks)
+      */
+     void publishTo(MonocleEventBus* bus);
+
+     /**
+      * REPLACE 'analogRead()' FOR THE AXIS SAMPLES (E.G. TO REPLAY
+      * A RECORDED SESSION); NULL RESTORES 'analogRead()'
+      */
+     void setAnalogReader(int (*analogReader)(uint8_t pin));
+
+     /**
+      * RECORD THE RAW AXIS SAMPLES (CHANGES LARGER THAN
+      * MONOCLE_RECORDER_ANALOG_DEADBAND) AND BUTTON PRESSES
+      * AND RELEASES TO A SESSION RECORDER
+      */
+     void recordTo(MonocleRecorder* recorder);
+
+     /**
+      * RAISE A BUTTON PRESS AS IF THE JOYSTICK BUTTON WAS PRESSED
+      */
+     void pressButton();
+
      /**
       * ENABLE OR DISABLE MULTISTATE PTZ EVENTS
       * ---------------------------------------------
@@ -282,6 +376,13 @@ class MonoclePTZJoystick
       */     
      int zoomState();
 
+     /**
+      * REGISTER THIS JOYSTICK AS A TASK OF A SCHEDULER (REPLACES
+      * CALLING 'loop()' FROM THE PROGRAM MAIN LOOP).
+      * RETURNS THE TASK ID OR MONOCLE_TASK_INVALID
+      */
+     int schedule(MonocleScheduler& scheduler);
+
      /**
       * THIS METHOD MUST BE CALLED IN THE PROGRAM MAIN LOOP
       * TO SERVICE THIS CLASS AND PROCESS THESHOLD EVALUATIONS
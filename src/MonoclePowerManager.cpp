@@ -0,0 +1,312 @@
+/*
+ **********************************************************************
+ *             __  __  ___  _  _  ___   ___ _    ___
+ *            |  \/  |/ _ \| \| |/ _ \ / __| |  | __|
+ *            | |\/| | (_) | .` | (_) | (__| |__| _|
+ *            |_|  |_|\___/|_|\_|\___/ \___|____|___|
+ *
+ * -------------------------------------------------------------------
+ *                     MONOCLE POWER MANAGER
+ * -------------------------------------------------------------------
+ *
+ *  This library provides idle-aware power management for battery
+ *  powered controllers.  Input activity (PTZ and button events from
+ *  the joystick or pad components) keeps the controller ACTIVE.
+ *  After a period without input the controller enters IDLE where
+ *  input sampling slows down and the OLED is dimmed, and later
+ *  SLEEP where the OLED is blanked and the Wi-Fi radio is placed in
+ *  modem-sleep.  Any input or a wake pin interrupt returns to ACTIVE.
+ *
+ *  Time spent in each state is accumulated to report the duty cycle
+ *  and an estimated average current draw.
+ *
+ *  Author:   Robert Savage
+ *  Date:     2018-02-18
+ *  Website:  http://monoclecam.com
+ *
+ * -------------------------------------------------------------------
+ *        COPYRIGHT SHADEBLUE, LLC @ 2018, ALL RIGHTS RESERVED
+ * -------------------------------------------------------------------
+ *
+ **********************************************************************
+ */
+
+#include "Arduino.h"
+#include "MonoclePowerManager.h"
+#include "MonocleOLED.h"
+
+/* INSTANCE NOTIFIED BY THE WAKE PIN INTERRUPT */
+MonoclePowerManager* MonoclePowerManager::wakeInstance = NULL;
+
+/**
+ * Default Constructor
+ */
+MonoclePowerManager::MonoclePowerManager() {
+  // initialize statistics and the default current profile
+  resetStatistics();
+  setCurrentProfile(MONOCLE_POWER_DEFAULT_ACTIVE_CURRENT,
+                    MONOCLE_POWER_DEFAULT_IDLE_CURRENT,
+                    MONOCLE_POWER_DEFAULT_SLEEP_CURRENT);
+
+  // initialize callbacks
+  stateCallback = NULL;
+  radioCallback = NULL;
+}
+
+/**
+ * DEFINE THE TIME WITHOUT INPUT BEFORE ENTERING IDLE AND SLEEP
+ * (MILLISECONDS; 0 DISABLES THE STATE)
+ */
+void MonoclePowerManager::setTimeouts(unsigned long idleTimeout, unsigned long sleepTimeout){
+  this->idleTimeout = idleTimeout;
+  this->sleepTimeout = sleepTimeout;
+}
+
+/**
+ * DEFINE THE CURRENT DRAW (MILLIAMPS) OF EACH POWER STATE
+ * USED TO ESTIMATE THE AVERAGE CURRENT
+ */
+void MonoclePowerManager::setCurrentProfile(float active, float idle, float sleep){
+  current[MONOCLE_POWER_ACTIVE] = active;
+  current[MONOCLE_POWER_IDLE] = idle;
+  current[MONOCLE_POWER_SLEEP] = sleep;
+}
+
+/**
+ * DIM THE DISPLAY WHILE IDLE AND BLANK IT WHILE ASLEEP
+ */
+void MonoclePowerManager::setDisplay(MonocleOLED* display){
+  this->display = display;
+}
+
+/**
+ * ADJUST THE INTERVAL OF A SCHEDULER TASK WITH THE POWER STATE
+ * (E.G. THE JOYSTICK OR PAD SAMPLE TASK). THE SCHEDULER MUST
+ * FIRST BE PROVIDED USING 'schedule()'.
+ * RETURNS 'false' IF NO MORE TASKS CAN BE MANAGED
+ */
+bool MonoclePowerManager::manage(const int task, unsigned long active, unsigned long idle, unsigned long sleep){
+  if(task == MONOCLE_TASK_INVALID || taskCount >= MONOCLE_POWER_MAX_TASKS) return false;
+  tasks[taskCount].task = task;
+  tasks[taskCount].interval[MONOCLE_POWER_ACTIVE] = active;
+  tasks[taskCount].interval[MONOCLE_POWER_IDLE] = idle;
+  tasks[taskCount].interval[MONOCLE_POWER_SLEEP] = sleep;
+  taskCount++;
+
+  // apply the interval of the current state
+  if(scheduler != NULL) scheduler->setPeriod(task, tasks[taskCount - 1].interval[powerState]);
+  return true;
+}
+
+/**
+ * WAKE PIN INTERRUPT SERVICE ROUTINE
+ */
+void MonoclePowerManager::internal_power_wake_isr(){
+  if(wakeInstance == NULL) return;
+  wakeInstance->wakeRequested = true;
+
+  // service the wake request on the next scheduler loop
+  if(wakeInstance->scheduler != NULL)
+    wakeInstance->scheduler->triggerFromISR(wakeInstance->task);
+}
+
+/**
+ * WAKE ON A PIN INTERRUPT (E.G. THE JOYSTICK BUTTON);
+ * ONLY ONE WAKE PIN IS SUPPORTED
+ */
+void MonoclePowerManager::attachWakePin(const int pin, const int mode){
+  wakeInstance = this;
+  attachInterrupt(digitalPinToInterrupt(pin), internal_power_wake_isr, mode);
+}
+
+/**
+ * REGISTERS A CALLBACK FUNCTION POINTER FOR POWER STATE CHANGES
+ * (USE TO SLOW DOWN INPUT SAMPLING WHEN NOT USING A SCHEDULER)
+ */
+void MonoclePowerManager::onStateChange(void (*stateCallback)(const uint8_t state)){
+  this->stateCallback = stateCallback;
+}
+
+/**
+ * REGISTERS A CALLBACK FUNCTION POINTER TO PLACE THE WI-FI RADIO
+ * IN (true) OR OUT OF (false) MODEM-SLEEP; THE RADIO WAKES FOR
+ * EACH ACCESS POINT BEACON SO THE GATEWAY CONNECTION IS KEPT
+ */
+void MonoclePowerManager::onRadioSleep(void (*radioCallback)(const bool sleep)){
+  this->radioCallback = radioCallback;
+}
+
+/**
+ * EVENT BUS HANDLER; INPUT EVENTS ARE TREATED AS ACTIVITY
+ */
+void MonoclePowerManager::internal_power_event_handler(const MonocleEvent& event, void* context){
+  MonoclePowerManager* manager = (MonoclePowerManager*)context;
+  if(event.type == MONOCLE_EVENT_PTZ)
+    manager->activity(event.pan, event.tilt, event.zoom);
+  else
+    manager->activity();
+}
+
+/**
+ * TREAT PTZ, BUTTON AND MENU EVENTS ON AN EVENT BUS AS INPUT ACTIVITY
+ */
+bool MonoclePowerManager::subscribeTo(MonocleEventBus* bus){
+  if(bus == NULL) return false;
+  bool success = bus->subscribe(MONOCLE_EVENT_PTZ, internal_power_event_handler, this);
+  success &= bus->subscribe(MONOCLE_EVENT_BUTTON, internal_power_event_handler, this);
+  success &= bus->subscribe(MONOCLE_EVENT_MENU, internal_power_event_handler, this);
+  return success;
+}
+
+/**
+ * REPORT INPUT ACTIVITY (WAKES THE CONTROLLER)
+ */
+void MonoclePowerManager::activity(){
+  unsigned long now = millis();
+  activityTime = now;
+  if(powerState != MONOCLE_POWER_ACTIVE) enter(MONOCLE_POWER_ACTIVE, now);
+}
+
+/**
+ * REPORT THE CURRENT PTZ VECTOR; A HELD NON-ZERO VECTOR
+ * KEEPS THE CONTROLLER ACTIVE
+ */
+void MonoclePowerManager::activity(const int pan, const int tilt, const int zoom){
+  moving = (pan != 0 || tilt != 0 || zoom != 0);
+  activity();
+}
+
+/**
+ * CHANGE THE POWER STATE AND APPLY ITS DISPLAY, RADIO AND
+ * SAMPLING SETTINGS
+ */
+void MonoclePowerManager::enter(const uint8_t state, unsigned long now){
+  uint8_t previous = powerState;
+  stateDuration[previous] += now - stateTime;
+  stateTime = now;
+  powerState = state;
+  if(state == MONOCLE_POWER_ACTIVE) wakeCount++;
+
+  // dim the display while idle; blank it while asleep
+  if(display != NULL){
+    if(previous == MONOCLE_POWER_SLEEP) display->ssd1306_command(SSD1306_DISPLAYON);
+    if(state == MONOCLE_POWER_SLEEP) display->ssd1306_command(SSD1306_DISPLAYOFF);
+    else display->dim(state == MONOCLE_POWER_IDLE);
+  }
+
+  // the radio only needs to stay fully awake while the controller is in use
+  if(radioCallback != NULL && (previous == MONOCLE_POWER_ACTIVE || state == MONOCLE_POWER_ACTIVE))
+    radioCallback(state != MONOCLE_POWER_ACTIVE);
+
+  // change the input sampling rate; sample immediately on wake
+  if(scheduler != NULL){
+    for(int index = 0; index < taskCount; index++){
+      scheduler->setPeriod(tasks[index].task, tasks[index].interval[state]);
+      if(state == MONOCLE_POWER_ACTIVE) scheduler->reschedule(tasks[index].task, 0);
+    }
+  }
+
+  if(stateCallback != NULL) stateCallback(state);
+}
+
+/**
+ * GET THE CURRENT POWER STATE (MONOCLE_POWER_*)
+ */
+uint8_t MonoclePowerManager::state(){
+  return powerState;
+}
+
+/**
+ * GET THE TIME SPENT IN A POWER STATE (MILLISECONDS)
+ */
+unsigned long MonoclePowerManager::timeIn(const uint8_t state){
+  if(state >= MONOCLE_POWER_STATES) return 0;
+  unsigned long duration = stateDuration[state];
+  if(state == powerState) duration += millis() - stateTime;
+  return duration;
+}
+
+/**
+ * GET THE NUMBER OF TRANSITIONS FROM IDLE OR SLEEP BACK TO ACTIVE
+ */
+unsigned long MonoclePowerManager::wakes(){
+  return wakeCount;
+}
+
+/**
+ * GET THE PERCENTAGE OF TIME SPENT ACTIVE
+ */
+float MonoclePowerManager::dutyCycle(){
+  float total = 0;
+  for(uint8_t index = 0; index < MONOCLE_POWER_STATES; index++) total += timeIn(index);
+  if(total == 0) return 100.0;
+  return 100.0 * timeIn(MONOCLE_POWER_ACTIVE) / total;
+}
+
+/**
+ * GET THE ESTIMATED AVERAGE CURRENT DRAW (MILLIAMPS)
+ */
+float MonoclePowerManager::averageCurrent(){
+  float total = 0;
+  float charge = 0;
+  for(uint8_t index = 0; index < MONOCLE_POWER_STATES; index++){
+    float duration = timeIn(index);
+    total += duration;
+    charge += duration * current[index];
+  }
+  if(total == 0) return current[powerState];
+  return charge / total;
+}
+
+/**
+ * RESET THE STATE DURATION AND WAKE STATISTICS
+ */
+void MonoclePowerManager::resetStatistics(){
+  for(uint8_t index = 0; index < MONOCLE_POWER_STATES; index++) stateDuration[index] = 0;
+  stateTime = millis();
+  wakeCount = 0;
+}
+
+/**
+ * SCHEDULER TASK ENTRY POINT
+ */
+void MonoclePowerManager::internal_power_task(void* context){
+  ((MonoclePowerManager*)context)->loop();
+}
+
+/**
+ * REGISTER THIS POWER MANAGER AS A TASK OF A SCHEDULER (REPLACES
+ * CALLING 'loop()' FROM THE PROGRAM MAIN LOOP); THE SCHEDULER IS
+ * ALSO USED TO ADJUST THE MANAGED TASK INTERVALS.
+ * RETURNS THE TASK ID OR MONOCLE_TASK_INVALID
+ */
+int MonoclePowerManager::schedule(MonocleScheduler& scheduler){
+  this->scheduler = &scheduler;
+  task = scheduler.every(MONOCLE_POWER_TASK_INTERVAL, internal_power_task, this, MONOCLE_POWER_TASK_BUDGET);
+  return task;
+}
+
+/**
+ * THIS METHOD MUST BE CALLED IN THE PROGRAM MAIN LOOP
+ * TO EVALUATE INPUT IDLENESS AND CHANGE POWER STATES
+ */
+void MonoclePowerManager::loop(){
+  // a wake pin interrupt counts as input activity
+  if(wakeRequested){
+    wakeRequested = false;
+    activity();
+    return;
+  }
+
+  unsigned long now = millis();
+
+  // a held joystick/pad position is continuous activity
+  if(moving) activityTime = now;
+
+  unsigned long idle = now - activityTime;
+  uint8_t target = MONOCLE_POWER_ACTIVE;
+  if(sleepTimeout > 0 && idle >= sleepTimeout) target = MONOCLE_POWER_SLEEP;
+  else if(idleTimeout > 0 && idle >= idleTimeout) target = MONOCLE_POWER_IDLE;
+
+  if(target != powerState) enter(target, now);
+}
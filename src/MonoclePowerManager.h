@@ -0,0 +1,228 @@
+/*
+ **********************************************************************
+ *             __  __  ___  _  _  ___   ___ _    ___
+ *            |  \/  |/ _ \| \| |/ _ \ / __| |  | __|
+ *            | |\/| | (_) | .` | (_) | (__| |__| _|
+ *            |_|  |_|\___/|_|\_|\___/ \___|____|___|
+ *
+ * -------------------------------------------------------------------
+ *                     MONOCLE POWER MANAGER
+ * -------------------------------------------------------------------
+ *
+ *  This library provides idle-aware power management for battery
+ *  powered controllers.  Input activity (PTZ and button events from
+ *  the joystick or pad components) keeps the controller ACTIVE.
+ *  After a period without input the controller enters IDLE where
+ *  input sampling slows down and the OLED is dimmed, and later
+ *  SLEEP where the OLED is blanked and the Wi-Fi radio is placed in
+ *  modem-sleep.  Any input or a wake pin interrupt returns to ACTIVE.
+ *
+ *  Time spent in each state is accumulated to report the duty cycle
+ *  and an estimated average current draw.
+ *
+ *  Author:   Robert Savage
+ *  Date:     2018-02-18
+ *  Website:  http://monoclecam.com
+ *
+ * -------------------------------------------------------------------
+ *        COPYRIGHT SHADEBLUE, LLC @ 2018, ALL RIGHTS RESERVED
+ * -------------------------------------------------------------------
+ *
+ **********************************************************************
+ */
+#ifndef MONOCLE_POWER_MANAGER_H
+#define MONOCLE_POWER_MANAGER_H
+
+#include <Arduino.h>
+#include "MonocleEventBus.h"
+#include "MonocleScheduler.h"
+
+class MonocleOLED;
+
+/* MAXIMUM NUMBER OF SCHEDULER TASKS WITH POWER STATE INTERVALS */
+#ifndef MONOCLE_POWER_MAX_TASKS
+#define MONOCLE_POWER_MAX_TASKS 4
+#endif
+
+/* SCHEDULER TASK INTERVAL AND EXECUTION BUDGET */
+#ifndef MONOCLE_POWER_TASK_INTERVAL
+#define MONOCLE_POWER_TASK_INTERVAL 100   // milliseconds
+#endif
+#ifndef MONOCLE_POWER_TASK_BUDGET
+#define MONOCLE_POWER_TASK_BUDGET   500   // microseconds (excluding display commands)
+#endif
+
+/* POWER STATES */
+#define MONOCLE_POWER_ACTIVE  0
+#define MONOCLE_POWER_IDLE    1
+#define MONOCLE_POWER_SLEEP   2
+#define MONOCLE_POWER_STATES  3
+
+#define MONOCLE_POWER_DEFAULT_IDLE_TIMEOUT   30000    // milliseconds without input
+#define MONOCLE_POWER_DEFAULT_SLEEP_TIMEOUT  300000   // milliseconds without input
+
+/* DEFAULT CURRENT PROFILE (MKR1000 WITH OLED, MILLIAMPS) */
+#define MONOCLE_POWER_DEFAULT_ACTIVE_CURRENT 120.0
+#define MONOCLE_POWER_DEFAULT_IDLE_CURRENT   80.0
+#define MONOCLE_POWER_DEFAULT_SLEEP_CURRENT  25.0
+
+class MonoclePowerManager
+{
+   private:
+     struct ManagedTask {
+       int task;
+       unsigned long interval[MONOCLE_POWER_STATES];
+     };
+
+     /* POWER STATE */
+     uint8_t powerState = MONOCLE_POWER_ACTIVE;
+     unsigned long activityTime = 0;   // time of the last input activity
+     unsigned long stateTime = 0;      // time the current state was entered
+     bool moving = false;              // a non-zero PTZ vector is being held
+     unsigned long idleTimeout = MONOCLE_POWER_DEFAULT_IDLE_TIMEOUT;
+     unsigned long sleepTimeout = MONOCLE_POWER_DEFAULT_SLEEP_TIMEOUT;
+
+     /* WAKE PIN INTERRUPT */
+     volatile bool wakeRequested = false;
+     static MonoclePowerManager* wakeInstance;
+     static void internal_power_wake_isr();
+
+     /* MANAGED SCHEDULER TASKS */
+     MonocleScheduler* scheduler = NULL;
+     int task = MONOCLE_TASK_INVALID;
+     ManagedTask tasks[MONOCLE_POWER_MAX_TASKS];
+     uint8_t taskCount = 0;
+
+     /* OPTIONAL DISPLAY TO DIM AND BLANK */
+     MonocleOLED* display = NULL;
+
+     /* STATISTICS */
+     unsigned long stateDuration[MONOCLE_POWER_STATES];   // accumulated milliseconds
+     unsigned long wakeCount = 0;
+     float current[MONOCLE_POWER_STATES];                 // milliamps
+
+     /* CALLBACKS */
+     void (*stateCallback)(const uint8_t state);
+     void (*radioCallback)(const bool sleep);
+
+     /* INTERNAL PROCESSING */
+     void enter(const uint8_t state, unsigned long now);
+
+     /* EVENT BUS SUBSCRIBER (PTZ, BUTTON AND MENU EVENTS) */
+     static void internal_power_event_handler(const MonocleEvent& event, void* context);
+
+     /* SCHEDULER TASK ENTRY POINT */
+     static void internal_power_task(void* context);
+
+   public:
+    /**
+     * Default Constructor
+     */
+     MonoclePowerManager();
+
+     /**
+      * DEFINE THE TIME WITHOUT INPUT BEFORE ENTERING IDLE AND SLEEP
+      * (MILLISECONDS; 0 DISABLES THE STATE)
+      */
+     void setTimeouts(unsigned long idleTimeout, unsigned long sleepTimeout);
+
+     /**
+      * DEFINE THE CURRENT DRAW (MILLIAMPS) OF EACH POWER STATE
+      * USED TO ESTIMATE THE AVERAGE CURRENT
+      */
+     void setCurrentProfile(float active, float idle, float sleep);
+
+     /**
+      * DIM THE DISPLAY WHILE IDLE AND BLANK IT WHILE ASLEEP
+      */
+     void setDisplay(MonocleOLED* display);
+
+     /**
+      * ADJUST THE INTERVAL OF A SCHEDULER TASK WITH THE POWER STATE
+      * (E.G. THE JOYSTICK OR PAD SAMPLE TASK). THE SCHEDULER MUST
+      * FIRST BE PROVIDED USING 'schedule()'.
+      * RETURNS 'false' IF NO MORE TASKS CAN BE MANAGED
+      */
+     bool manage(const int task, unsigned long active, unsigned long idle, unsigned long sleep);
+
+     /**
+      * WAKE ON A PIN INTERRUPT (E.G. THE JOYSTICK BUTTON);
+      * ONLY ONE WAKE PIN IS SUPPORTED
+      */
+     void attachWakePin(const int pin, const int mode = FALLING);
+
+     /**
+      * REGISTERS A CALLBACK FUNCTION POINTER FOR POWER STATE CHANGES
+      * (USE TO SLOW DOWN INPUT SAMPLING WHEN NOT USING A SCHEDULER)
+      */
+     void onStateChange(void (*stateCallback)(const uint8_t state));
+
+     /**
+      * REGISTERS A CALLBACK FUNCTION POINTER TO PLACE THE WI-FI RADIO
+      * IN (true) OR OUT OF (false) MODEM-SLEEP; THE RADIO WAKES FOR
+      * EACH ACCESS POINT BEACON SO THE GATEWAY CONNECTION IS KEPT
+      */
+     void onRadioSleep(void (*radioCallback)(const bool sleep));
+
+     /**
+      * TREAT PTZ, BUTTON AND MENU EVENTS ON AN EVENT BUS AS INPUT ACTIVITY
+      */
+     bool subscribeTo(MonocleEventBus* bus);
+
+     /**
+      * REPORT INPUT ACTIVITY (WAKES THE CONTROLLER)
+      */
+     void activity();
+
+     /**
+      * REPORT THE CURRENT PTZ VECTOR; A HELD NON-ZERO VECTOR
+      * KEEPS THE CONTROLLER ACTIVE
+      */
+     void activity(const int pan, const int tilt, const int zoom);
+
+     /**
+      * GET THE CURRENT POWER STATE (MONOCLE_POWER_*)
+      */
+     uint8_t state();
+
+     /**
+      * GET THE TIME SPENT IN A POWER STATE (MILLISECONDS)
+      */
+     unsigned long timeIn(const uint8_t state);
+
+     /**
+      * GET THE NUMBER OF TRANSITIONS FROM IDLE OR SLEEP BACK TO ACTIVE
+      */
+     unsigned long wakes();
+
+     /**
+      * GET THE PERCENTAGE OF TIME SPENT ACTIVE
+      */
+     float dutyCycle();
+
+     /**
+      * GET THE ESTIMATED AVERAGE CURRENT DRAW (MILLIAMPS)
+      */
+     float averageCurrent();
+
+     /**
+      * RESET THE STATE DURATION AND WAKE STATISTICS
+      */
+     void resetStatistics();
+
+     /**
+      * REGISTER THIS POWER MANAGER AS A TASK OF A SCHEDULER (REPLACES
+      * CALLING 'loop()' FROM THE PROGRAM MAIN LOOP); THE SCHEDULER IS
+      * ALSO USED TO ADJUST THE MANAGED TASK INTERVALS.
+      * RETURNS THE TASK ID OR MONOCLE_TASK_INVALID
+      */
+     int schedule(MonocleScheduler& scheduler);
+
+     /**
+      * THIS METHOD MUST BE CALLED IN THE PROGRAM MAIN LOOP
+      * TO EVALUATE INPUT IDLENESS AND CHANGE POWER STATES
+      */
+     void loop();
+};
+
+#endif //MONOCLE_POWER_MANAGER_H
@@ -0,0 +1,251 @@
+/*
+ **********************************************************************
+ *             __  __  ___  _  _  ___   ___ _    ___
+ *            |  \/  |/ _ \| \| |/ _ \ / __| |  | __|
+ *            | |\/| | (_) | .` | (_) | (__| |__| _|
+ *            |_|  |_|\___/|_|\_|\___/ \___|____|___|
+ *
+ * -------------------------------------------------------------------
+ *                     MONOCLE PRESET TOUR
+ * -------------------------------------------------------------------
+ *
+ *  This library runs a preset tour (patrol) on the controller, e.g.
+ *  "cycle presets 1-5 every 30 seconds" for a lobby camera.  A tour
+ *  is a preallocated list of up to MONOCLE_TOUR_MAX_STEPS steps,
+ *  each recalling a preset (or HOME) on the active camera and
+ *  dwelling there for a given time.  Steps are timed from the
+ *  scheduled time of the previous step (not from when 'loop()' got
+ *  to it) so the tour does not drift.
+ *
+ *  Manual input (PTZ, button and menu events, or 'activity()')
+ *  pauses the tour; it resumes at the interrupted step once the
+ *  input has been idle for the resume timeout.  A tour interrupted
+ *  by a gateway disconnect resumes at the same step on reconnect.
+ *
+ *
+ *  Author:   Robert Savage
+ *  Date:     2018-02-18
+ *  Website:  http://monoclecam.com
+ *
+ * -------------------------------------------------------------------
+ *        COPYRIGHT SHADEBLUE, LLC @ 2018, ALL RIGHTS RESERVED
+ * -------------------------------------------------------------------
+ *
+ **********************************************************************
+ */
+
+#include "Arduino.h"
+#include "MonoclePresetTour.h"
+
+/**
+ * Default Constructor
+ */
+MonoclePresetTour::MonoclePresetTour(MonocleGatewayClient& gateway) : gateway(gateway) {
+  memset(steps, 0, sizeof(steps));
+
+  // initialize callbacks
+  stepCallback = NULL;
+}
+
+/**
+ * APPEND A STEP RECALLING A PRESET (OR MONOCLE_TOUR_HOME) AND
+ * DWELLING THERE (MILLISECONDS). RETURNS 'false' IF THE TOUR IS FULL
+ */
+bool MonoclePresetTour::add(const uint8_t preset, unsigned long dwell){
+  if(stepCount >= MONOCLE_TOUR_MAX_STEPS) return false;
+  steps[stepCount].preset = preset;
+  steps[stepCount].dwell = (dwell > 0) ? dwell : 1;
+  stepCount++;
+  return true;
+}
+
+/**
+ * REPLACE THE TOUR WITH A CYCLE OF THE PRESETS 'first' TO 'last'
+ * WITH THE SAME DWELL TIME. RETURNS 'false' IF THE TOUR IS FULL
+ */
+bool MonoclePresetTour::cycle(const uint8_t first, const uint8_t last, unsigned long dwell){
+  clear();
+  for(int preset = first; preset <= last; preset++){
+    if(!add(preset, dwell)) return false;
+  }
+  return true;
+}
+
+/**
+ * REMOVE ALL STEPS (STOPS THE TOUR)
+ */
+void MonoclePresetTour::clear(){
+  stop();
+  stepCount = 0;
+}
+
+/**
+ * GET THE NUMBER OF STEPS
+ */
+uint8_t MonoclePresetTour::size(){
+  return stepCount;
+}
+
+/**
+ * START THE TOUR AT A STEP; THE STEP IS RECALLED ON THE NEXT 'loop()'
+ */
+void MonoclePresetTour::start(const uint8_t step){
+  if(stepCount == 0) return;
+  current = (step < stepCount) ? step : 0;
+  running = true;
+  paused = false;
+  held = false;
+  recall = true;
+}
+
+/**
+ * STOP THE TOUR
+ */
+void MonoclePresetTour::stop(){
+  running = false;
+  paused = false;
+  recall = false;
+}
+
+/**
+ * DETERMINE IF THE TOUR IS RUNNING (INCLUDING PAUSED)
+ */
+bool MonoclePresetTour::isRunning(){
+  return running;
+}
+
+/**
+ * DETERMINE IF THE TOUR IS PAUSED BY MANUAL INPUT
+ */
+bool MonoclePresetTour::isPaused(){
+  return paused;
+}
+
+/**
+ * GET THE CURRENT STEP INDEX
+ */
+uint8_t MonoclePresetTour::step(){
+  return current;
+}
+
+/**
+ * DEFINE THE IDLE TIME (MILLISECONDS) AFTER MANUAL INPUT BEFORE
+ * A PAUSED TOUR RESUMES
+ */
+void MonoclePresetTour::setResumeTimeout(unsigned long timeout){
+  resumeTimeout = timeout;
+}
+
+/**
+ * EVENT BUS SUBSCRIBER; PTZ, BUTTON AND MENU EVENTS ARE MANUAL INPUT
+ */
+void MonoclePresetTour::internal_tour_event_handler(const MonocleEvent& event, void* context){
+  MonoclePresetTour* tour = (MonoclePresetTour*)context;
+  if(event.type == MONOCLE_EVENT_PTZ)
+    tour->activity(event.pan, event.tilt, event.zoom);
+  else
+    tour->activity();
+}
+
+/**
+ * TREAT PTZ, BUTTON AND MENU EVENTS ON AN EVENT BUS AS MANUAL INPUT
+ */
+bool MonoclePresetTour::subscribeTo(MonocleEventBus* bus){
+  if(bus == NULL) return false;
+  bool success = bus->subscribe(MONOCLE_EVENT_PTZ, internal_tour_event_handler, this);
+  success &= bus->subscribe(MONOCLE_EVENT_BUTTON, internal_tour_event_handler, this);
+  success &= bus->subscribe(MONOCLE_EVENT_MENU, internal_tour_event_handler, this);
+  return success;
+}
+
+/**
+ * REPORT MANUAL INPUT (PAUSES A RUNNING TOUR)
+ */
+void MonoclePresetTour::activity(){
+  activityTime = millis();
+  if(running) paused = true;
+}
+
+/**
+ * REPORT THE CURRENT MANUAL PTZ VECTOR; A HELD NON-ZERO
+ * VECTOR KEEPS THE TOUR PAUSED
+ */
+void MonoclePresetTour::activity(const int pan, const int tilt, const int zoom){
+  held = (pan != 0 || tilt != 0 || zoom != 0);
+  activity();
+}
+
+/**
+ * REGISTERS A CALLBACK FUNCTION POINTER FOR EACH RECALLED STEP
+ */
+void MonoclePresetTour::onStep(void (*stepCallback)(const uint8_t step, const uint8_t preset)){
+  this->stepCallback = stepCallback;
+}
+
+/**
+ * RECALL THE CURRENT STEP
+ */
+void MonoclePresetTour::go(){
+  MonocleTourStep& next = steps[current];
+  if(next.preset == MONOCLE_TOUR_HOME)
+    gateway.home();
+  else
+    gateway.preset(next.preset);
+
+  if(stepCallback != NULL) stepCallback(current, next.preset);
+}
+
+/**
+ * SCHEDULER TASK ENTRY POINT
+ */
+void MonoclePresetTour::internal_tour_task(void* context){
+  ((MonoclePresetTour*)context)->loop();
+}
+
+/**
+ * REGISTER THIS TOUR AS A TASK OF A SCHEDULER (REPLACES
+ * CALLING 'loop()' FROM THE PROGRAM MAIN LOOP).
+ * RETURNS THE TASK ID OR MONOCLE_TASK_INVALID
+ */
+int MonoclePresetTour::schedule(MonocleScheduler& scheduler){
+  return scheduler.every(MONOCLE_TOUR_TASK_INTERVAL, internal_tour_task, this, MONOCLE_TOUR_TASK_BUDGET);
+}
+
+/**
+ * THIS METHOD MUST BE CALLED IN THE PROGRAM MAIN LOOP
+ * TO ADVANCE THE TOUR
+ */
+void MonoclePresetTour::loop(){
+  if(!running || stepCount == 0) return;
+  unsigned long now = millis();
+
+  // resume at the interrupted step once manual input has been idle
+  if(paused){
+    if(held || now - activityTime < resumeTimeout) return;
+    paused = false;
+    recall = true;
+  }
+
+  // the camera cannot be driven without the gateway; recall the
+  // interrupted step once the connection is back
+  if(!gateway.connected()){
+    recall = true;
+    return;
+  }
+
+  if(recall){
+    recall = false;
+    go();
+    dueTime = now + steps[current].dwell;
+    return;
+  }
+
+  if((long)(now - dueTime) < 0) return;
+
+  // the next step is timed from the scheduled time of this one so the
+  // loop latency does not accumulate (unless a whole dwell was missed)
+  current = (current + 1 < stepCount) ? current + 1 : 0;
+  go();
+  dueTime += steps[current].dwell;
+  if((long)(now - dueTime) >= 0) dueTime = now + steps[current].dwell;
+}
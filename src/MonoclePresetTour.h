@@ -0,0 +1,194 @@
+/*
+ **********************************************************************
+ *             __  __  ___  _  _  ___   ___ _    ___
+ *            |  \/  |/ _ \| \| |/ _ \ / __| |  | __|
+ *            | |\/| | (_) | .` | (_) | (__| |__| _|
+ *            |_|  |_|\___/|_|\_|\___/ \___|____|___|
+ *
+ * -------------------------------------------------------------------
+ *                     MONOCLE PRESET TOUR
+ * -------------------------------------------------------------------
+ *
+ *  This library runs a preset tour (patrol) on the controller, e.g.
+ *  "cycle presets 1-5 every 30 seconds" for a lobby camera.  A tour
+ *  is a preallocated list of up to MONOCLE_TOUR_MAX_STEPS steps,
+ *  each recalling a preset (or HOME) on the active camera and
+ *  dwelling there for a given time.  Steps are timed from the
+ *  scheduled time of the previous step (not from when 'loop()' got
+ *  to it) so the tour does not drift.
+ *
+ *  Manual input (PTZ, button and menu events, or 'activity()')
+ *  pauses the tour; it resumes at the interrupted step once the
+ *  input has been idle for the resume timeout.  A tour interrupted
+ *  by a gateway disconnect resumes at the same step on reconnect.
+ *
+ *
+ *  Author:   Robert Savage
+ *  Date:     2018-02-18
+ *  Website:  http://monoclecam.com
+ *
+ * -------------------------------------------------------------------
+ *        COPYRIGHT SHADEBLUE, LLC @ 2018, ALL RIGHTS RESERVED
+ * -------------------------------------------------------------------
+ *
+ **********************************************************************
+ */
+#ifndef MONOCLE_PRESET_TOUR_H
+#define MONOCLE_PRESET_TOUR_H
+
+#include <Arduino.h>
+#include "MonocleGatewayClient.h"
+#include "MonocleEventBus.h"
+#include "MonocleScheduler.h"
+
+/* MAXIMUM NUMBER OF TOUR STEPS */
+#ifndef MONOCLE_TOUR_MAX_STEPS
+#define MONOCLE_TOUR_MAX_STEPS 16
+#endif
+
+/* IDLE TIME AFTER MANUAL INPUT BEFORE A PAUSED TOUR RESUMES */
+#ifndef MONOCLE_TOUR_DEFAULT_RESUME_TIMEOUT
+#define MONOCLE_TOUR_DEFAULT_RESUME_TIMEOUT 60000   // milliseconds
+#endif
+
+/* SCHEDULER TASK INTERVAL AND EXECUTION BUDGET (THE TASK INTERVAL BOUNDS THE STEP TIMING ERROR) */
+#ifndef MONOCLE_TOUR_TASK_INTERVAL
+#define MONOCLE_TOUR_TASK_INTERVAL 50       // milliseconds
+#endif
+#ifndef MONOCLE_TOUR_TASK_BUDGET
+#define MONOCLE_TOUR_TASK_BUDGET   1000     // microseconds
+#endif
+
+/* STEP PRESET RECALLING THE CAMERA HOME POSITION */
+#define MONOCLE_TOUR_HOME 0
+
+/**
+ * A TOUR STEP (PRESET NUMBER OR MONOCLE_TOUR_HOME AND DWELL TIME)
+ */
+struct MonocleTourStep {
+  uint32_t dwell;     // milliseconds
+  uint8_t preset;
+};
+
+class MonoclePresetTour
+{
+   private:
+     MonocleGatewayClient& gateway;
+     MonocleTourStep steps[MONOCLE_TOUR_MAX_STEPS];
+     uint8_t stepCount = 0;
+     uint8_t current = 0;
+
+     /* TOUR STATE */
+     bool running = false;
+     bool paused = false;
+     bool held = false;                 // a manual PTZ vector is held
+     bool recall = false;               // the current step must be (re)sent
+     unsigned long dueTime = 0;         // scheduled time of the next step
+     unsigned long activityTime = 0;    // time of the last manual input
+     unsigned long resumeTimeout = MONOCLE_TOUR_DEFAULT_RESUME_TIMEOUT;
+
+     /* CALLBACKS */
+     void (*stepCallback)(const uint8_t step, const uint8_t preset);
+
+     /* INTERNAL PROCESSING */
+     void go();
+
+     /* EVENT BUS SUBSCRIBER AND SCHEDULER TASK ENTRY POINT */
+     static void internal_tour_event_handler(const MonocleEvent& event, void* context);
+     static void internal_tour_task(void* context);
+
+   public:
+    /**
+     * Default Constructor
+     */
+     MonoclePresetTour(MonocleGatewayClient& gateway);
+
+     /**
+      * APPEND A STEP RECALLING A PRESET (OR MONOCLE_TOUR_HOME) AND
+      * DWELLING THERE (MILLISECONDS). RETURNS 'false' IF THE TOUR IS FULL
+      */
+     bool add(const uint8_t preset, unsigned long dwell);
+
+     /**
+      * REPLACE THE TOUR WITH A CYCLE OF THE PRESETS 'first' TO 'last'
+      * WITH THE SAME DWELL TIME. RETURNS 'false' IF THE TOUR IS FULL
+      */
+     bool cycle(const uint8_t first, const uint8_t last, unsigned long dwell);
+
+     /**
+      * REMOVE ALL STEPS (STOPS THE TOUR)
+      */
+     void clear();
+
+     /**
+      * GET THE NUMBER OF STEPS
+      */
+     uint8_t size();
+
+     /**
+      * START THE TOUR AT A STEP; THE STEP IS RECALLED ON THE NEXT 'loop()'
+      */
+     void start(const uint8_t step = 0);
+
+     /**
+      * STOP THE TOUR
+      */
+     void stop();
+
+     /**
+      * DETERMINE IF THE TOUR IS RUNNING (INCLUDING PAUSED)
+      */
+     bool isRunning();
+
+     /**
+      * DETERMINE IF THE TOUR IS PAUSED BY MANUAL INPUT
+      */
+     bool isPaused();
+
+     /**
+      * GET THE CURRENT STEP INDEX
+      */
+     uint8_t step();
+
+     /**
+      * DEFINE THE IDLE TIME (MILLISECONDS) AFTER MANUAL INPUT BEFORE
+      * A PAUSED TOUR RESUMES
+      */
+     void setResumeTimeout(unsigned long timeout);
+
+     /**
+      * TREAT PTZ, BUTTON AND MENU EVENTS ON AN EVENT BUS AS MANUAL INPUT
+      */
+     bool subscribeTo(MonocleEventBus* bus);
+
+     /**
+      * REPORT MANUAL INPUT (PAUSES A RUNNING TOUR)
+      */
+     void activity();
+
+     /**
+      * REPORT THE CURRENT MANUAL PTZ VECTOR; A HELD NON-ZERO
+      * VECTOR KEEPS THE TOUR PAUSED
+      */
+     void activity(const int pan, const int tilt, const int zoom);
+
+     /**
+      * REGISTERS A CALLBACK FUNCTION POINTER FOR EACH RECALLED STEP
+      */
+     void onStep(void (*stepCallback)(const uint8_t step, const uint8_t preset));
+
+     /**
+      * REGISTER THIS TOUR AS A TASK OF A SCHEDULER (REPLACES
+      * CALLING 'loop()' FROM THE PROGRAM MAIN LOOP).
+      * RETURNS THE TASK ID OR MONOCLE_TASK_INVALID
+      */
+     int schedule(MonocleScheduler& scheduler);
+
+     /**
+      * THIS METHOD MUST BE CALLED IN THE PROGRAM MAIN LOOP
+      * TO ADVANCE THE TOUR
+      */
+     void loop();
+};
+
+#endif //MONOCLE_PRESET_TOUR_H
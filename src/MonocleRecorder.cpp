@@ -0,0 +1,473 @@
+/*
+ **********************************************************************
+ *             __  __  ___  _  _  ___   ___ _    ___
+ *            |  \/  |/ _ \| \| |/ _ \ / __| |  | __|
+ *            | |\/| | (_) | .` | (_) | (__| |__| _|
+ *            |_|  |_|\___/|_|\_|\___/ \___|____|___|
+ *
+ * -------------------------------------------------------------------
+ *                     MONOCLE SESSION RECORDER
+ * -------------------------------------------------------------------
+ *
+ *  This library records control sessions so field problems can be
+ *  reproduced.  'MonocleRecorder' logs timestamped raw inputs (ADC
+ *  samples, button and pad pin states, IR codes) and the outbound
+ *  gateway commands into a compact binary ring buffer in RAM; each
+ *  entry can also be streamed over Serial as it is recorded.
+ *
+ *  'MonocleReplayer' plays a recording back through the joystick,
+ *  digital pad and IR remote components (using their injectable
+ *  input readers) while a second recorder captures the commands the
+ *  program sends.  'MonocleRecorder::compare()' then compares the
+ *  two command streams and their input-to-command latencies, e.g.
+ *  between library versions.
+ *
+ *  Recording is not interrupt safe; record from the main loop only.
+ *
+ *  Author:   Robert Savage
+ *  Date:     2018-02-18
+ *  Website:  http://monoclecam.com
+ *
+ * -------------------------------------------------------------------
+ *        COPYRIGHT SHADEBLUE, LLC @ 2018, ALL RIGHTS RESERVED
+ * -------------------------------------------------------------------
+ *
+ **********************************************************************
+ */
+
+#include "Arduino.h"
+#include "MonocleRecorder.h"
+#include "MonoclePTZJoystick.h"
+#include "MonocleDigitalPad.h"
+#include "MonocleIRRemote.h"
+
+#define RECORDER_MASK       (MONOCLE_RECORDER_SIZE - 1)
+#define RECORDER_ENTRY_SIZE 8
+#define RECORDER_MAX_DELTA  0xFFFF
+
+/**
+ * THIS INTERNAL FUNCTION WRITES AN ENTRY (LITTLE ENDIAN)
+ */
+void writeEntry(Print& out, const MonocleRecordEntry& entry){
+  uint8_t data[RECORDER_ENTRY_SIZE];
+  data[0] = entry.delta & 0xFF;
+  data[1] = entry.delta >> 8;
+  data[2] = entry.type;
+  data[3] = entry.channel;
+  for(int index = 0; index < 4; index++)
+    data[4 + index] = ((uint32_t)entry.value >> (index * 8)) & 0xFF;
+  out.write(data, RECORDER_ENTRY_SIZE);
+}
+
+/**
+ * THIS INTERNAL FUNCTION WRITES THE STREAM/DUMP HEADER
+ */
+void writeHeader(Print& out){
+  out.write((const uint8_t*)MONOCLE_RECORDER_MAGIC, 4);
+  out.write((uint8_t)MONOCLE_RECORDER_FORMAT);
+  out.write((uint8_t)RECORDER_ENTRY_SIZE);
+}
+
+/**
+ * THIS INTERNAL FUNCTION DETERMINES IF AN ENTRY IS A RAW INPUT
+ */
+bool isInput(const MonocleRecordEntry& entry){
+  return entry.type == MONOCLE_RECORD_ANALOG || entry.type == MONOCLE_RECORD_BUTTON ||
+         entry.type == MONOCLE_RECORD_PAD || entry.type == MONOCLE_RECORD_IR;
+}
+
+/**
+ * Default Constructor
+ */
+MonocleRecorder::MonocleRecorder() {
+}
+
+/**
+ * GET THE TIME FROM THE PREVIOUS ENTRY TO AN ENTRY
+ */
+unsigned long MonocleRecorder::gap(const MonocleRecordEntry& entry){
+  if(entry.type == MONOCLE_RECORD_TIME) return entry.delta + (unsigned long)entry.value;
+  return entry.delta;
+}
+
+/**
+ * APPEND AN ENTRY; THE OLDEST ENTRY IS DROPPED WHEN THE BUFFER IS FULL
+ * AND THE START TIME MOVES TO THE TIME OF THE NEW OLDEST ENTRY
+ */
+void MonocleRecorder::append(const MonocleRecordEntry& entry){
+  if(count == MONOCLE_RECORDER_SIZE){
+    startTime += gap(entries[(head + 1) & RECORDER_MASK]);
+    droppedCount++;
+    count--;
+  }
+  entries[head] = entry;
+  head = (head + 1) & RECORDER_MASK;
+  count++;
+}
+
+/**
+ * RECORD AN ENTRY (MONOCLE_RECORD_*) AT THE CURRENT TIME;
+ * THE OLDEST ENTRY IS OVERWRITTEN WHEN THE BUFFER IS FULL
+ */
+void MonocleRecorder::record(const uint8_t type, const uint8_t channel, const int32_t value){
+  if(!recording) return;
+
+  unsigned long now = millis();
+  unsigned long elapsed = 0;
+  if(count == 0) startTime = now;
+  else elapsed = now - lastTime;
+  lastTime = now;
+
+  MonocleRecordEntry entry;
+
+  // gaps that do not fit the entry delta are carried by a time entry
+  if(elapsed > RECORDER_MAX_DELTA){
+    entry.delta = 0;
+    entry.type = MONOCLE_RECORD_TIME;
+    entry.channel = 0;
+    entry.value = elapsed;
+    append(entry);
+    if(stream != NULL) writeEntry(*stream, entry);
+    elapsed = 0;
+  }
+
+  entry.delta = elapsed;
+  entry.type = type;
+  entry.channel = channel;
+  entry.value = value;
+  append(entry);
+  if(stream != NULL) writeEntry(*stream, entry);
+}
+
+/**
+ * RECORD A USER DEFINED MARKER (E.G. "USER REPORTED A PROBLEM")
+ */
+void MonocleRecorder::mark(const int32_t value){
+  record(MONOCLE_RECORD_MARK, 0, value);
+}
+
+/**
+ * PAUSE OR RESUME RECORDING
+ */
+void MonocleRecorder::enable(bool enabled){
+  recording = enabled;
+}
+
+bool MonocleRecorder::isEnabled(){
+  return recording;
+}
+
+/**
+ * ALSO WRITE EACH ENTRY TO A STREAM (E.G. 'Serial') AS IT IS
+ * RECORDED; THE STREAM HEADER IS WRITTEN FIRST (NULL TO STOP)
+ */
+void MonocleRecorder::setStream(Print* stream){
+  this->stream = stream;
+  if(stream != NULL) writeHeader(*stream);
+}
+
+/**
+ * WRITE THE HEADER AND ALL ENTRIES (OLDEST FIRST) TO A STREAM
+ */
+void MonocleRecorder::dump(Print& out){
+  writeHeader(out);
+  uint16_t index = (head - count) & RECORDER_MASK;
+  for(uint16_t written = 0; written < count; written++){
+    writeEntry(out, entries[index]);
+    index = (index + 1) & RECORDER_MASK;
+  }
+}
+
+/**
+ * REPLACE THE ENTRIES WITH A RECORDING IN THE STREAM/DUMP FORMAT.
+ * RETURNS 'false' IF THE DATA IS NOT A RECORDING
+ */
+bool MonocleRecorder::load(const uint8_t* data, size_t length){
+  if(length < 6 || memcmp(data, MONOCLE_RECORDER_MAGIC, 4) != 0) return false;
+  if(data[4] != MONOCLE_RECORDER_FORMAT || data[5] != RECORDER_ENTRY_SIZE) return false;
+
+  clear();
+  for(size_t offset = 6; offset + RECORDER_ENTRY_SIZE <= length; offset += RECORDER_ENTRY_SIZE){
+    MonocleRecordEntry entry;
+    entry.delta = data[offset] | (data[offset + 1] << 8);
+    entry.type = data[offset + 2];
+    entry.channel = data[offset + 3];
+    entry.value = (int32_t)((uint32_t)data[offset + 4] | ((uint32_t)data[offset + 5] << 8) |
+                            ((uint32_t)data[offset + 6] << 16) | ((uint32_t)data[offset + 7] << 24));
+    if(count > 0) lastTime += gap(entry);   // the first entry starts the recording
+    append(entry);
+  }
+  return true;
+}
+
+/**
+ * DISCARD ALL ENTRIES
+ */
+void MonocleRecorder::clear(){
+  head = 0;
+  count = 0;
+  startTime = 0;
+  lastTime = 0;
+  droppedCount = 0;
+  rewind();
+}
+
+/**
+ * GET THE NUMBER OF ENTRIES AND THE NUMBER OF OVERWRITTEN ENTRIES
+ */
+int MonocleRecorder::size(){
+  return count;
+}
+
+unsigned long MonocleRecorder::dropped(){
+  return droppedCount;
+}
+
+/**
+ * ITERATE THE ENTRIES (OLDEST FIRST); 'time' IS THE TIME OF THE
+ * ENTRY RELATIVE TO THE OLDEST ENTRY (MILLISECONDS).
+ * 'next()' RETURNS 'false' AFTER THE LAST ENTRY
+ */
+void MonocleRecorder::rewind(){
+  cursor = 0;
+  cursorTime = 0;
+}
+
+bool MonocleRecorder::next(MonocleRecordEntry& entry, unsigned long& time){
+  while(cursor < count){
+    const MonocleRecordEntry& current = entries[(head - count + cursor) & RECORDER_MASK];
+    if(cursor > 0) cursorTime += gap(current);   // the oldest entry is the time origin
+    cursor++;
+    if(current.type == MONOCLE_RECORD_TIME) continue;
+    entry = current;
+    time = cursorTime;
+    return true;
+  }
+  return false;
+}
+
+/**
+ * PACK A PTZ VECTOR INTO A COMMAND ENTRY VALUE
+ */
+int32_t MonocleRecorder::packPTZ(const int pan, const int tilt, const int zoom){
+  return (uint8_t)pan | ((uint32_t)(uint8_t)tilt << 8) | ((uint32_t)(uint8_t)zoom << 16);
+}
+
+/**
+ * FIND THE NEXT COMMAND ENTRY AND ITS LATENCY (TIME SINCE THE
+ * LAST RAW INPUT ENTRY; 0 IF NO INPUT PRECEDES THE COMMAND)
+ */
+bool MonocleRecorder::nextCommand(MonocleRecorder& recorder, MonocleRecordEntry& entry, unsigned long& latency){
+  unsigned long time;
+  while(recorder.next(entry, time)){
+    if(isInput(entry)) recorder.inputTime = time;
+    if(entry.type != MONOCLE_RECORD_COMMAND) continue;
+    latency = time - recorder.inputTime;
+    return true;
+  }
+  return false;
+}
+
+/**
+ * COMPARE THE COMMAND STREAMS OF A REFERENCE RECORDING AND A
+ * REPLAYED RECORDING. RETURNS 'true' IF THE STREAMS ARE EQUAL
+ */
+bool MonocleRecorder::compare(MonocleRecorder& expected, MonocleRecorder& actual, MonocleReplayResult& result){
+  memset(&result, 0, sizeof(MonocleReplayResult));
+  result.firstMismatch = -1;
+  expected.rewind();
+  actual.rewind();
+  expected.inputTime = actual.inputTime = 0;
+
+  MonocleRecordEntry left, right;
+  unsigned long leftLatency, rightLatency;
+  bool hasLeft = nextCommand(expected, left, leftLatency);
+  bool hasRight = nextCommand(actual, right, rightLatency);
+
+  while(hasLeft || hasRight){
+    if(hasLeft && hasRight && result.firstMismatch < 0){
+      if(left.channel == right.channel && left.value == right.value){
+        unsigned long delta = (leftLatency > rightLatency) ? leftLatency - rightLatency : rightLatency - leftLatency;
+        if(delta > result.maxLatencyDelta) result.maxLatencyDelta = delta;
+        result.latencyDelta += delta;
+        result.matched++;
+      }
+      else{
+        result.firstMismatch = result.matched;
+      }
+    }
+    else if(result.firstMismatch < 0){
+      result.firstMismatch = result.matched;   // one stream ended early
+    }
+
+    if(hasLeft){
+      result.expected++;
+      hasLeft = nextCommand(expected, left, leftLatency);
+    }
+    if(hasRight){
+      result.actual++;
+      hasRight = nextCommand(actual, right, rightLatency);
+    }
+  }
+
+  expected.rewind();
+  actual.rewind();
+  return result.firstMismatch < 0;
+}
+
+/* ------------------------------------------------------------------- */
+
+MonocleReplayer* MonocleReplayer::instance = NULL;
+
+/**
+ * Default Constructor
+ */
+MonocleReplayer::MonocleReplayer(MonocleRecorder& recording) : recording(recording) {
+}
+
+/**
+ * INJECTED JOYSTICK ANALOG READER; RETURNS THE LAST REPLAYED SAMPLE
+ */
+int MonocleReplayer::internal_replay_analog_reader(uint8_t pin){
+  if(instance == NULL) return 0;
+  for(uint8_t index = 0; index < instance->pinCount; index++)
+    if(instance->pins[index] == pin) return instance->values[index];
+  return 0;
+}
+
+/**
+ * INJECTED PAD PIN READER; RETURNS THE LAST REPLAYED PIN STATE
+ */
+uint8_t MonocleReplayer::internal_replay_pad_reader(){
+  return (instance != NULL) ? instance->padPins : 0;
+}
+
+/**
+ * DRIVE A COMPONENT'S INPUTS FROM THE RECORDING
+ * (ONLY ONE REPLAYER CAN BE ACTIVE AT A TIME)
+ */
+void MonocleReplayer::attach(MonoclePTZJoystick& joystick){
+  this->joystick = &joystick;
+}
+
+void MonocleReplayer::attach(MonocleDigitalPad& pad){
+  this->pad = &pad;
+}
+
+void MonocleReplayer::attach(MonocleIRRemote& remote){
+  this->remote = &remote;
+}
+
+/**
+ * APPLY A RECORDED INPUT TO THE DRIVEN COMPONENTS
+ */
+void MonocleReplayer::apply(const MonocleRecordEntry& entry){
+  switch(entry.type){
+    case MONOCLE_RECORD_ANALOG: {
+      uint8_t index = 0;
+      while(index < pinCount && pins[index] != entry.channel) index++;
+      if(index == pinCount){
+        if(pinCount >= MONOCLE_REPLAY_MAX_PINS) return;
+        pins[pinCount++] = entry.channel;
+      }
+      values[index] = entry.value;
+      break;
+    }
+    case MONOCLE_RECORD_BUTTON:
+      if(joystick != NULL && entry.value != 0) joystick->pressButton();
+      break;
+    case MONOCLE_RECORD_PAD:
+      padPins = entry.value;
+      break;
+    case MONOCLE_RECORD_IR:
+      if(remote != NULL) remote->process((uint32_t)entry.value);
+      break;
+  }
+}
+
+/**
+ * START THE REPLAY FROM THE OLDEST ENTRY
+ */
+void MonocleReplayer::begin(){
+  if(instance != NULL && instance != this) instance->end();
+  instance = this;
+
+  // start each analog axis from its first recorded sample so the
+  // replayed components begin in the recorded resting state
+  pinCount = 0;
+  padPins = 0;
+  MonocleRecordEntry first;
+  unsigned long time;
+  recording.rewind();
+  while(recording.next(first, time)){
+    if(first.type != MONOCLE_RECORD_ANALOG) continue;
+    uint8_t index = 0;
+    while(index < pinCount && pins[index] != first.channel) index++;
+    if(index < pinCount || pinCount >= MONOCLE_REPLAY_MAX_PINS) continue;
+    pins[pinCount] = first.channel;
+    values[pinCount++] = first.value;
+  }
+  recording.rewind();
+
+  if(joystick != NULL) joystick->setAnalogReader(internal_replay_analog_reader);
+  if(pad != NULL) pad->setPinReader(internal_replay_pad_reader);
+
+  pending = false;
+  playing = true;
+  startTime = millis();
+}
+
+/**
+ * STOP THE REPLAY AND RESTORE THE COMPONENTS' OWN INPUT READERS
+ */
+void MonocleReplayer::end(){
+  if(joystick != NULL) joystick->setAnalogReader(NULL);
+  if(pad != NULL) pad->setPinReader(NULL);
+  if(instance == this) instance = NULL;
+  playing = false;
+}
+
+/**
+ * DETERMINE IF THE REPLAY IS STILL RUNNING
+ */
+bool MonocleReplayer::isPlaying(){
+  return playing;
+}
+
+/**
+ * SCHEDULER TASK ENTRY POINT
+ */
+void MonocleReplayer::internal_replay_task(void* context){
+  ((MonocleReplayer*)context)->loop();
+}
+
+/**
+ * REGISTER THIS REPLAYER AS A TASK OF A SCHEDULER (REPLACES
+ * CALLING 'loop()' FROM THE PROGRAM MAIN LOOP).
+ * RETURNS THE TASK ID OR MONOCLE_TASK_INVALID
+ */
+int MonocleReplayer::schedule(MonocleScheduler& scheduler){
+  return scheduler.every(MONOCLE_REPLAY_TASK_INTERVAL, internal_replay_task, this, MONOCLE_REPLAY_TASK_BUDGET);
+}
+
+/**
+ * THIS METHOD MUST BE CALLED IN THE PROGRAM MAIN LOOP
+ * (BEFORE THE DRIVEN COMPONENTS) TO APPLY DUE ENTRIES
+ */
+void MonocleReplayer::loop(){
+  if(!playing) return;
+
+  unsigned long elapsed = millis() - startTime;
+  while(true){
+    if(!pending){
+      if(!recording.next(entry, entryTime)){
+        end();
+        return;
+      }
+      pending = true;
+    }
+    if(entryTime > elapsed) return;
+    apply(entry);
+    pending = false;
+  }
+}
@@ -0,0 +1,286 @@
+/*
+ **********************************************************************
+ *             __  __  ___  _  _  ___   ___ _    ___
+ *            |  \/  |/ _ \| \| |/ _ \ / __| |  | __|
+ *            | |\/| | (_) | .` | (_) | (__| |__| _|
+ *            |_|  |_|\___/|_|\_|\___/ \___|____|___|
+ *
+ * -------------------------------------------------------------------
+ *                     MONOCLE SESSION RECORDER
+ * -------------------------------------------------------------------
+ *
+ *  This library records control sessions so field problems can be
+ *  reproduced.  'MonocleRecorder' logs timestamped raw inputs (ADC
+ *  samples, button and pad pin states, IR codes) and the outbound
+ *  gateway commands into a compact binary ring buffer in RAM; each
+ *  entry can also be streamed over Serial as it is recorded.
+ *
+ *  'MonocleReplayer' plays a recording back through the joystick,
+ *  digital pad and IR remote components (using their injectable
+ *  input readers) while a second recorder captures the commands the
+ *  program sends.  'MonocleRecorder::compare()' then compares the
+ *  two command streams and their input-to-command latencies, e.g.
+ *  between library versions.
+ *
+ *  Recording is not interrupt safe; record from the main loop only.
+ *
+ *  Author:   Robert Savage
+ *  Date:     2018-02-18
+ *  Website:  http://monoclecam.com
+ *
+ * -------------------------------------------------------------------
+ *        COPYRIGHT SHADEBLUE, LLC @ 2018, ALL RIGHTS RESERVED
+ * -------------------------------------------------------------------
+ *
+ **********************************************************************
+ */
+#ifndef MONOCLE_RECORDER_H
+#define MONOCLE_RECORDER_H
+
+#include <Arduino.h>
+#include "MonocleScheduler.h"
+
+class MonoclePTZJoystick;
+class MonocleDigitalPad;
+class MonocleIRRemote;
+
+/* NUMBER OF ENTRIES IN THE RING BUFFER (MUST BE A POWER OF TWO; 8 BYTES EACH) */
+#ifndef MONOCLE_RECORDER_SIZE
+#define MONOCLE_RECORDER_SIZE 256
+#endif
+
+#if (MONOCLE_RECORDER_SIZE & (MONOCLE_RECORDER_SIZE - 1)) != 0
+#error("MONOCLE_RECORDER_SIZE must be a power of two")
+#endif
+
+/* MINIMUM ADC CHANGE RECORDED FOR AN ANALOG AXIS (FILTERS ADC NOISE) */
+#ifndef MONOCLE_RECORDER_ANALOG_DEADBAND
+#define MONOCLE_RECORDER_ANALOG_DEADBAND 8
+#endif
+
+/* MAXIMUM NUMBER OF ANALOG PINS DRIVEN BY A REPLAY */
+#ifndef MONOCLE_REPLAY_MAX_PINS
+#define MONOCLE_REPLAY_MAX_PINS 4
+#endif
+
+/* SCHEDULER TASK INTERVAL AND EXECUTION BUDGET (REPLAY) */
+#ifndef MONOCLE_REPLAY_TASK_INTERVAL
+#define MONOCLE_REPLAY_TASK_INTERVAL 1      // milliseconds
+#endif
+#ifndef MONOCLE_REPLAY_TASK_BUDGET
+#define MONOCLE_REPLAY_TASK_BUDGET   1000   // microseconds
+#endif
+
+/* ENTRY TYPES */
+#define MONOCLE_RECORD_TIME     0   // time gap longer than 65535 ms; value: gap (ms)
+#define MONOCLE_RECORD_ANALOG   1   // channel: analog pin; value: raw ADC sample
+#define MONOCLE_RECORD_BUTTON   2   // channel: button pin; value: 1=pressed, 0=released
+#define MONOCLE_RECORD_PAD      3   // value: pressed pad pins (raw bitmask)
+#define MONOCLE_RECORD_IR       4   // value: received IR code
+#define MONOCLE_RECORD_COMMAND  5   // channel: MONOCLE_COMMAND_*; value: see below
+#define MONOCLE_RECORD_MARK     6   // value: user defined marker
+
+/* COMMAND ENTRIES: PAN, TILT AND ZOOM ARE PACKED IN THE LOW THREE BYTES
+ * (OR THE ONE BASED PRESET NUMBER); CAMERA SESSION COMMANDS SET THE
+ * SESSION FLAG IN THE CHANNEL AND CARRY THE SESSION INDEX IN THE HIGH BYTE */
+#define MONOCLE_RECORD_SESSION  0x80
+
+/* RECORDING STREAM/DUMP HEADER ("MREC", FORMAT VERSION, ENTRY SIZE) */
+#define MONOCLE_RECORDER_MAGIC   "MREC"
+#define MONOCLE_RECORDER_FORMAT  1
+
+/**
+ * RECORDED ENTRY (8 BYTES); TIME IS STORED AS THE DELTA
+ * TO THE PREVIOUS ENTRY
+ */
+struct MonocleRecordEntry {
+  uint16_t delta;     // milliseconds since the previous entry
+  uint8_t type;       // MONOCLE_RECORD_*
+  uint8_t channel;
+  int32_t value;
+};
+
+/**
+ * RESULT OF COMPARING THE COMMAND STREAMS OF TWO RECORDINGS
+ */
+struct MonocleReplayResult {
+  uint16_t expected;              // commands in the reference recording
+  uint16_t actual;                // commands in the replayed recording
+  uint16_t matched;               // commands equal in both (in order)
+  int16_t firstMismatch;          // index of the first differing command (-1 = none)
+  unsigned long maxLatencyDelta;  // largest input-to-command latency difference (ms)
+  unsigned long latencyDelta;     // sum of the latency differences of matched commands (ms)
+};
+
+class MonocleRecorder
+{
+   private:
+     /* RING BUFFER */
+     MonocleRecordEntry entries[MONOCLE_RECORDER_SIZE];
+     uint16_t head = 0;                // next entry to write
+     uint16_t count = 0;
+     unsigned long startTime = 0;      // time of the oldest entry
+     unsigned long lastTime = 0;       // time of the newest entry
+     unsigned long droppedCount = 0;
+     bool recording = true;
+
+     /* ITERATION CURSOR */
+     uint16_t cursor = 0;
+     unsigned long cursorTime = 0;
+     unsigned long inputTime = 0;      // time of the last raw input (compare)
+
+     /* OPTIONAL LIVE STREAM */
+     Print* stream = NULL;
+
+     /* INTERNAL PROCESSING */
+     void append(const MonocleRecordEntry& entry);
+     static unsigned long gap(const MonocleRecordEntry& entry);
+     static bool nextCommand(MonocleRecorder& recorder, MonocleRecordEntry& entry, unsigned long& latency);
+
+   public:
+    /**
+     * Default Constructor
+     */
+     MonocleRecorder();
+
+     /**
+      * RECORD AN ENTRY (MONOCLE_RECORD_*) AT THE CURRENT TIME;
+      * THE OLDEST ENTRY IS OVERWRITTEN WHEN THE BUFFER IS FULL
+      */
+     void record(const uint8_t type, const uint8_t channel, const int32_t value);
+
+     /**
+      * RECORD A USER DEFINED MARKER (E.G. "USER REPORTED A PROBLEM")
+      */
+     void mark(const int32_t value);
+
+     /**
+      * PAUSE OR RESUME RECORDING
+      */
+     void enable(bool enabled);
+     bool isEnabled();
+
+     /**
+      * ALSO WRITE EACH ENTRY TO A STREAM (E.G. 'Serial') AS IT IS
+      * RECORDED; THE STREAM HEADER IS WRITTEN FIRST (NULL TO STOP)
+      */
+     void setStream(Print* stream);
+
+     /**
+      * WRITE THE HEADER AND ALL ENTRIES (OLDEST FIRST) TO A STREAM
+      */
+     void dump(Print& out);
+
+     /**
+      * REPLACE THE ENTRIES WITH A RECORDING IN THE STREAM/DUMP FORMAT.
+      * RETURNS 'false' IF THE DATA IS NOT A RECORDING
+      */
+     bool load(const uint8_t* data, size_t length);
+
+     /**
+      * DISCARD ALL ENTRIES
+      */
+     void clear();
+
+     /**
+      * GET THE NUMBER OF ENTRIES AND THE NUMBER OF OVERWRITTEN ENTRIES
+      */
+     int size();
+     unsigned long dropped();
+
+     /**
+      * ITERATE THE ENTRIES (OLDEST FIRST); 'time' IS THE TIME OF THE
+      * ENTRY RELATIVE TO THE OLDEST ENTRY (MILLISECONDS).
+      * 'next()' RETURNS 'false' AFTER THE LAST ENTRY
+      */
+     void rewind();
+     bool next(MonocleRecordEntry& entry, unsigned long& time);
+
+     /**
+      * PACK A PTZ VECTOR INTO A COMMAND ENTRY VALUE
+      */
+     static int32_t packPTZ(const int pan, const int tilt, const int zoom);
+
+     /**
+      * COMPARE THE COMMAND STREAMS OF A REFERENCE RECORDING AND A
+      * REPLAYED RECORDING. RETURNS 'true' IF THE STREAMS ARE EQUAL
+      */
+     static bool compare(MonocleRecorder& expected, MonocleRecorder& actual, MonocleReplayResult& result);
+};
+
+class MonocleReplayer
+{
+   private:
+     MonocleRecorder& recording;
+     bool playing = false;
+     unsigned long startTime = 0;
+     bool pending = false;               // an entry has been read but is not yet due
+     MonocleRecordEntry entry;
+     unsigned long entryTime = 0;
+
+     /* REPLAYED INPUT STATE */
+     uint8_t pins[MONOCLE_REPLAY_MAX_PINS];
+     int values[MONOCLE_REPLAY_MAX_PINS];
+     uint8_t pinCount = 0;
+     uint8_t padPins = 0;
+
+     /* COMPONENTS DRIVEN BY THE REPLAY */
+     MonoclePTZJoystick* joystick = NULL;
+     MonocleDigitalPad* pad = NULL;
+     MonocleIRRemote* remote = NULL;
+
+     /* INSTANCE PROVIDING THE INJECTED INPUT READERS */
+     static MonocleReplayer* instance;
+     static int internal_replay_analog_reader(uint8_t pin);
+     static uint8_t internal_replay_pad_reader();
+
+     /* INTERNAL PROCESSING */
+     void apply(const MonocleRecordEntry& entry);
+
+     /* SCHEDULER TASK ENTRY POINT */
+     static void internal_replay_task(void* context);
+
+   public:
+    /**
+     * Default Constructor
+     */
+     MonocleReplayer(MonocleRecorder& recording);
+
+     /**
+      * DRIVE A COMPONENT'S INPUTS FROM THE RECORDING
+      * (ONLY ONE REPLAYER CAN BE ACTIVE AT A TIME)
+      */
+     void attach(MonoclePTZJoystick& joystick);
+     void attach(MonocleDigitalPad& pad);
+     void attach(MonocleIRRemote& remote);
+
+     /**
+      * START THE REPLAY FROM THE OLDEST ENTRY
+      */
+     void begin();
+
+     /**
+      * STOP THE REPLAY AND RESTORE THE COMPONENTS' OWN INPUT READERS
+      */
+     void end();
+
+     /**
+      * DETERMINE IF THE REPLAY IS STILL RUNNING
+      */
+     bool isPlaying();
+
+     /**
+      * REGISTER THIS REPLAYER AS A TASK OF A SCHEDULER (REPLACES
+      * CALLING 'loop()' FROM THE PROGRAM MAIN LOOP).
+      * RETURNS THE TASK ID OR MONOCLE_TASK_INVALID
+      */
+     int schedule(MonocleScheduler& scheduler);
+
+     /**
+      * THIS METHOD MUST BE CALLED IN THE PROGRAM MAIN LOOP
+      * (BEFORE THE DRIVEN COMPONENTS) TO APPLY DUE ENTRIES
+      */
+     void loop();
+};
+
+#endif //MONOCLE_RECORDER_H
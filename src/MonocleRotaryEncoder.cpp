@@ -0,0 +1,337 @@
+/*
+ **********************************************************************
+ *             __  __  ___  _  _  ___   ___ _    ___
+ *            |  \/  |/ _ \| \| |/ _ \ / __| |  | __|
+ *            | |\/| | (_) | .` | (_) | (__| |__| _|
+ *            |_|  |_|\___/|_|\_|\___/ \___|____|___|
+ *
+ * -------------------------------------------------------------------
+ *                     MONOCLE ROTARY ENCODER
+ * -------------------------------------------------------------------
+ *
+ *  This library provides an interrupt driven quadrature decoder for
+ *  a detented rotary encoder.  Each pin change is decoded through a
+ *  transition table (contact bounce cancels itself out) and a detent
+ *  is counted each time the encoder settles in its rest state.  The
+ *  interrupt is the only writer of the detent counter, so the main
+ *  loop consumes detents without disabling interrupts.
+ *
+ *  While a menu is active each detent moves the menu cursor; otherwise
+ *  detents are a fine zoom channel with velocity sensitive acceleration
+ *  (a quick spin zooms further per detent than a slow turn).
+ *
+ *  Author:   Robert Savage
+ *  Date:     2018-02-18
+ *  Website:  http://monoclecam.com
+ *
+ * -------------------------------------------------------------------
+ *        COPYRIGHT SHADEBLUE, LLC @ 2018, ALL RIGHTS RESERVED
+ * -------------------------------------------------------------------
+ *
+ **********************************************************************
+ */
+
+#include "MonocleRotaryEncoder.h"
+#include "MonocleMenu.h"
+#include "MonocleFlashMenu.h"
+#include "MonocleMotionPlanner.h"
+
+/**
+ * QUADRATURE TRANSITION TABLE INDEXED BY (LAST STATE << 2 | STATE)
+ * WHERE A STATE IS (A << 1 | B); +1 = ONE STEP CLOCKWISE, -1 = ONE
+ * STEP COUNTER-CLOCKWISE AND 0 = NO CHANGE OR AN INVALID TRANSITION
+ * (BOTH PINS CHANGED; AN EDGE WAS MISSED).  A BOUNCING CONTACT
+ * TOGGLES BETWEEN TWO ADJACENT STATES SO ITS STEPS CANCEL OUT.
+ */
+static const int8_t MONOCLE_ENCODER_TRANSITIONS[16] = {
+   0, -1,  1,  0,
+   1,  0,  0, -1,
+  -1,  0,  0,  1,
+   0,  1, -1,  0
+};
+
+MonocleRotaryEncoder* MonocleRotaryEncoder::isrInstance = NULL;
+
+/*
+ * Default Constructor
+ */
+MonocleRotaryEncoder::MonocleRotaryEncoder(){
+  this->rotateCallback = NULL;
+  this->zoomCallback = NULL;
+}
+
+/**
+ * CONFIGURE THE ENCODER PINS ('INPUT_PULLUP'; THE COMMON PIN TO
+ * GROUND) AND THE QUADRATURE STEPS PER DETENT (MONOCLE_ENCODER_*_CYCLE).
+ * BOTH PINS SHOULD SUPPORT INTERRUPTS; OTHERWISE THE PINS ARE SAMPLED
+ * BY 'loop()' AND FAST TURNS MAY BE MISSED.  ONLY ONE ENCODER IS SUPPORTED.
+ * THE ENCODER MUST REST AT A DETENT WHILE THIS IS CALLED
+ */
+void MonocleRotaryEncoder::setupPins(const int pinA, const int pinB, const uint8_t stepsPerDetent){
+  this->pinA = pinA;
+  this->pinB = pinB;
+  this->stepsPerDetent = stepsPerDetent;
+
+  // we use a PULLUP to give these pins a HIGH bias; the
+  // encoder contacts ground the pins as the shaft turns
+  pinMode(pinA, INPUT_PULLUP);
+  pinMode(pinB, INPUT_PULLUP);
+
+#ifdef MONOCLE_ENCODER_PORT_READ
+  // read the pins straight from their port registers in the interrupt
+  portA = portB = NULL;
+#if defined(ESP8266)
+  if(pinA < 16 && pinB < 16)  // GPIO16 is not part of the GPI register
+#endif
+  {
+    portA = portInputRegister(digitalPinToPort(pinA));
+    portB = portInputRegister(digitalPinToPort(pinB));
+    maskA = digitalPinToBitMask(pinA);
+    maskB = digitalPinToBitMask(pinB);
+  }
+#endif
+
+  // the resting position defines where a detent is counted
+  pinState = restState = readPins();
+  steps = 0;
+
+  // decode every pin change in the interrupt; pins without an
+  // interrupt are sampled from the main loop instead
+  polled = forcePolled || !hasInterrupt(pinA) || !hasInterrupt(pinB);
+#if defined(ARDUINO_ARCH_SAMD)
+  // pins sharing an external interrupt line cannot both be attached
+  if(!polled && g_APinDescription[pinA].ulExtInt == g_APinDescription[pinB].ulExtInt) polled = true;
+#endif
+  if(!polled){
+    isrInstance = this;
+    attachInterrupt(digitalPinToInterrupt(pinA), internal_encoder_isr, CHANGE);
+    attachInterrupt(digitalPinToInterrupt(pinB), internal_encoder_isr, CHANGE);
+  }
+}
+
+/**
+ * SAMPLE THE PINS FROM 'loop()' INSTEAD OF THE PIN INTERRUPTS, E.G.
+ * WHEN THE INTERRUPT LINES ARE NEEDED ELSEWHERE (CALL BEFORE 'setupPins()')
+ */
+void MonocleRotaryEncoder::forcePolling(bool enabled){
+  this->forcePolled = enabled;
+}
+
+/**
+ * RETURNS TRUE IF THE PINS ARE SAMPLED BY 'loop()' (NO PIN INTERRUPTS)
+ */
+bool MonocleRotaryEncoder::isPolled(){
+  return polled;
+}
+
+/**
+ * RETURNS TRUE IF A PIN CAN RAISE A PIN CHANGE INTERRUPT
+ */
+bool MonocleRotaryEncoder::hasInterrupt(const int pin){
+#if defined(ARDUINO_ARCH_SAMD)
+  // older SAMD cores map every pin to "its" interrupt number; the
+  // external interrupt line of a pin is in the pin description table
+  return g_APinDescription[pin].ulExtInt != NOT_AN_INTERRUPT;
+#elif defined(NOT_AN_INTERRUPT)
+  return digitalPinToInterrupt(pin) != NOT_AN_INTERRUPT;
+#else
+  return digitalPinToInterrupt(pin) >= 0;
+#endif
+}
+
+/**
+ * REVERSE THE DIRECTION OF ROTATION (SWAPS CLOCKWISE AND COUNTER-CLOCKWISE)
+ */
+void MonocleRotaryEncoder::reverse(bool reversed){
+  this->reversed = reversed;
+}
+
+/**
+ * DEFINE THE ZOOM ACCELERATION; A DETENT TURNED WITHIN 'fastInterval'
+ * MILLISECONDS OF THE LAST ONE IS 'maxSteps' ZOOM STEPS, ONE SLOWER
+ * THAN 'slowInterval' IS ONE STEP.  A 'maxSteps' OF 1 DISABLES IT
+ */
+void MonocleRotaryEncoder::setAcceleration(unsigned int slowInterval, unsigned int fastInterval, uint8_t maxSteps){
+  this->slowInterval = slowInterval;
+  this->fastInterval = (fastInterval < slowInterval) ? fastInterval : slowInterval;
+  this->maxSteps = (maxSteps < 1) ? 1 : maxSteps;
+}
+
+/**
+ * MOVE THE CURSOR OF A MENU WHILE IT IS ACTIVE (CLOCKWISE = NEXT)
+ */
+void MonocleRotaryEncoder::driveMenu(MonocleMenu* menu){
+  this->menu = menu;
+}
+void MonocleRotaryEncoder::driveMenu(MonocleFlashMenu* menu){
+  this->flashMenu = menu;
+}
+
+/**
+ * NUDGE THE ZOOM OF A MOTION PLANNER BY 'units' PER ZOOM STEP
+ * WHILE NO MENU IS ACTIVE (CLOCKWISE = ZOOM IN)
+ */
+void MonocleRotaryEncoder::driveZoom(MonocleMotionPlanner* planner, float units){
+  this->planner = planner;
+  this->zoomUnits = units;
+}
+
+/**
+ * REGISTERS A CALLBACK FUNCTION POINTER FOR ROTATION EVENTS
+ * (DETENTS TURNED SINCE THE LAST EVENT; CLOCKWISE IS POSITIVE)
+ */
+void MonocleRotaryEncoder::onRotate(void (*rotateCallback)(const int detents)){
+  this->rotateCallback = rotateCallback;
+}
+
+/**
+ * REGISTERS A CALLBACK FUNCTION POINTER FOR FINE ZOOM EVENTS
+ * (ACCELERATED ZOOM STEPS; RAISED WHILE NO MENU IS ACTIVE)
+ */
+void MonocleRotaryEncoder::onZoom(void (*zoomCallback)(const int steps)){
+  this->zoomCallback = zoomCallback;
+}
+
+/**
+ * REPLACE THE PIN READS WITH A FUNCTION RETURNING THE PIN
+ * STATE (BIT 1 = PIN A, BIT 0 = PIN B; SET = HIGH), E.G. TO
+ * SIMULATE AN ENCODER; NULL RESTORES THE PIN READS
+ */
+void MonocleRotaryEncoder::setPinReader(uint8_t (*pinReader)(void)){
+  this->pinReader = pinReader;
+}
+
+/**
+ * READ THE PIN STATE (A << 1 | B)
+ */
+MONOCLE_ENCODER_ISR_ATTR uint8_t MonocleRotaryEncoder::readPins(){
+  if(pinReader != NULL) return pinReader() & 0x03;
+#ifdef MONOCLE_ENCODER_PORT_READ
+  if(portA != NULL)
+    return (((*portA & maskA) != 0) << 1) | ((*portB & maskB) != 0);
+#endif
+  return (digitalRead(pinA) == HIGH ? 2 : 0) | (digitalRead(pinB) == HIGH ? 1 : 0);
+}
+
+/**
+ * RETURNS TRUE IF A PIN STATE IS A DETENT; A FULL CYCLE ENCODER RESTS
+ * IN ONE STATE, A HALF CYCLE ENCODER ALSO IN ITS COMPLEMENT AND A
+ * QUARTER CYCLE ENCODER RESTS IN EVERY STATE
+ */
+MONOCLE_ENCODER_ISR_ATTR bool MonocleRotaryEncoder::isRest(const uint8_t state){
+  if(stepsPerDetent == MONOCLE_ENCODER_QUARTER_CYCLE) return true;
+  if(stepsPerDetent == MONOCLE_ENCODER_HALF_CYCLE) return state == restState || state == (restState ^ 0x03);
+  return state == restState;
+}
+
+/**
+ * DECODE A PIN CHANGE; CALLED FROM THE PIN INTERRUPTS (OR
+ * 'loop()' FOR POLLED PINS).  SAFE TO CALL FROM AN INTERRUPT
+ */
+MONOCLE_ENCODER_ISR_ATTR void MonocleRotaryEncoder::update(){
+  uint8_t state = readPins();
+  if(state == pinState) return;
+  steps += MONOCLE_ENCODER_TRANSITIONS[(pinState << 2) | state];
+  pinState = state;
+
+  // a detent is counted when the encoder settles in a rest state having
+  // moved at least half a detent; bounce at a detent nets zero steps and
+  // a missed edge still completes the detent (the count resynchronizes)
+  if(isRest(state)){
+    int8_t half = (stepsPerDetent + 1) / 2;
+    if(steps >= half) detents = detents + 1;
+    else if(steps <= -half) detents = detents - 1;
+    steps = 0;
+  }
+}
+
+/**
+ * PIN INTERRUPT SERVICE ROUTINE
+ */
+MONOCLE_ENCODER_ISR_ATTR void MonocleRotaryEncoder::internal_encoder_isr(){
+  if(isrInstance != NULL) isrInstance->update();
+}
+
+/**
+ * ZOOM STEPS FOR A NUMBER OF DETENTS; THE STEPS PER DETENT GROW
+ * LINEARLY FROM ONE AT THE SLOW INTERVAL TO THE MAXIMUM AT THE
+ * FAST INTERVAL.  A CHANGE OF DIRECTION STARTS AGAIN AT ONE STEP
+ */
+int MonocleRotaryEncoder::accelerate(int detents, unsigned long now){
+  int direction = (detents > 0) ? 1 : -1;
+  int count = detents * direction;
+  unsigned long interval = (now - lastDetentTime) / count;
+  bool reversal = direction != lastDirection;
+  lastDetentTime = now;
+  lastDirection = direction;
+
+  if(maxSteps <= 1 || reversal || interval >= slowInterval) return detents;
+  if(interval <= fastInterval) return detents * maxSteps;
+  unsigned long span = slowInterval - fastInterval;
+  int multiplier = 1 + (int)(((unsigned long)(maxSteps - 1) * (slowInterval - interval) + span / 2) / span);
+  return detents * multiplier;
+}
+
+/**
+ * GET THE NUMBER OF DETENTS TURNED SINCE STARTUP (CLOCKWISE IS POSITIVE)
+ */
+long MonocleRotaryEncoder::detentPosition(){
+  return position;
+}
+
+/**
+ * SCHEDULER TASK ENTRY POINT
+ */
+void MonocleRotaryEncoder::internal_encoder_task(void* context){
+  ((MonocleRotaryEncoder*)context)->loop();
+}
+
+/**
+ * REGISTER THIS ENCODER AS A TASK OF A SCHEDULER (REPLACES
+ * CALLING 'loop()' FROM THE PROGRAM MAIN LOOP).
+ * RETURNS THE TASK ID OR MONOCLE_TASK_INVALID
+ */
+int MonocleRotaryEncoder::schedule(MonocleScheduler& scheduler){
+  return scheduler.every(MONOCLE_ENCODER_TASK_INTERVAL, internal_encoder_task, this, MONOCLE_ENCODER_TASK_BUDGET);
+}
+
+/**
+ * THIS METHOD MUST BE CALLED IN THE PROGRAM MAIN LOOP
+ * TO SERVICE THIS CLASS
+ */
+void MonocleRotaryEncoder::loop(){
+  if(polled) update();
+
+  // consume the detents counted by the interrupt since the last loop;
+  // the counter is only written by the interrupt and read atomically
+  MonocleEncoderCount count = detents;
+  int turned = (MonocleEncoderDelta)(count - consumed);
+  consumed = count;
+  if(turned == 0) return;
+  if(reversed) turned = -turned;
+  position += turned;
+
+  if(rotateCallback != NULL)
+    rotateCallback(turned);
+
+  // an active menu takes every detent as one cursor step
+  if(menu != NULL && menu->isActive()){
+    for(int step = 0; step < turned; step++) menu->next();
+    for(int step = 0; step > turned; step--) menu->prev();
+    lastDirection = 0;
+    return;
+  }
+  if(flashMenu != NULL && flashMenu->isActive()){
+    for(int step = 0; step < turned; step++) flashMenu->next();
+    for(int step = 0; step > turned; step--) flashMenu->prev();
+    lastDirection = 0;
+    return;
+  }
+
+  // otherwise the detents are accelerated fine zoom steps
+  int zoom = accelerate(turned, millis());
+  if(zoomCallback != NULL)
+    zoomCallback(zoom);
+  if(planner != NULL)
+    planner->move(0, 0, zoom * zoomUnits);
+}
@@ -0,0 +1,245 @@
+/*
+ **********************************************************************
+ *             __  __  ___  _  _  ___   ___ _    ___
+ *            |  \/  |/ _ \| \| |/ _ \ / __| |  | __|
+ *            | |\/| | (_) | .` | (_) | (__| |__| _|
+ *            |_|  |_|\___/|_|\_|\___/ \___|____|___|
+ *
+ * -------------------------------------------------------------------
+ *                     MONOCLE ROTARY ENCODER
+ * -------------------------------------------------------------------
+ *
+ *  This library provides an interrupt driven quadrature decoder for
+ *  a detented rotary encoder.  Each pin change is decoded through a
+ *  transition table (contact bounce cancels itself out) and a detent
+ *  is counted each time the encoder settles in its rest state.  The
+ *  interrupt is the only writer of the detent counter, so the main
+ *  loop consumes detents without disabling interrupts.
+ *
+ *  While a menu is active each detent moves the menu cursor; otherwise
+ *  detents are a fine zoom channel with velocity sensitive acceleration
+ *  (a quick spin zooms further per detent than a slow turn).
+ *
+ *  Author:   Robert Savage
+ *  Date:     2018-02-18
+ *  Website:  http://monoclecam.com
+ *
+ * -------------------------------------------------------------------
+ *        COPYRIGHT SHADEBLUE, LLC @ 2018, ALL RIGHTS RESERVED
+ * -------------------------------------------------------------------
+ *
+ **********************************************************************
+ */
+#ifndef MONOCLE_ROTARY_ENCODER_H
+#define MONOCLE_ROTARY_ENCODER_H
+
+#include <Arduino.h>
+#include "MonocleScheduler.h"
+
+class MonocleMenu;
+class MonocleFlashMenu;
+class MonocleMotionPlanner;
+
+/* QUADRATURE STEPS PER DETENT (FULL, HALF AND QUARTER CYCLE ENCODERS) */
+#define MONOCLE_ENCODER_FULL_CYCLE    4
+#define MONOCLE_ENCODER_HALF_CYCLE    2
+#define MONOCLE_ENCODER_QUARTER_CYCLE 1
+
+/* ZOOM ACCELERATION DEFAULTS; DETENTS SLOWER THAN THE SLOW INTERVAL ARE ONE
+   STEP, FASTER THAN THE FAST INTERVAL ARE THE MAXIMUM STEPS (LINEAR BETWEEN) */
+#define MONOCLE_ENCODER_DEFAULT_SLOW_INTERVAL 150   // milliseconds per detent
+#define MONOCLE_ENCODER_DEFAULT_FAST_INTERVAL 20    // milliseconds per detent
+#define MONOCLE_ENCODER_DEFAULT_MAX_STEPS     8     // zoom steps per detent
+
+/* SCHEDULER TASK INTERVAL AND EXECUTION BUDGET */
+#ifndef MONOCLE_ENCODER_TASK_INTERVAL
+#define MONOCLE_ENCODER_TASK_INTERVAL 5      // milliseconds
+#endif
+#ifndef MONOCLE_ENCODER_TASK_BUDGET
+#define MONOCLE_ENCODER_TASK_BUDGET   2000   // microseconds
+#endif
+
+/* USE PORT REGISTER READS IN THE INTERRUPT WHEN THE CORE PROVIDES THE PORT MACROS */
+#if defined(portInputRegister) && defined(digitalPinToPort) && defined(digitalPinToBitMask)
+#define MONOCLE_ENCODER_PORT_READ 1
+#if defined(__AVR__)
+typedef volatile uint8_t MonocleEncoderPortRegister;
+#else
+typedef volatile uint32_t MonocleEncoderPortRegister;
+#endif
+#endif
+
+/* INTERRUPT CODE MUST BE PLACED IN RAM ON THE ESP8266 AND ESP32 */
+#if defined(ESP8266) || defined(ESP32)
+#define MONOCLE_ENCODER_ISR_ATTR IRAM_ATTR
+#else
+#define MONOCLE_ENCODER_ISR_ATTR
+#endif
+
+/* DETENT COUNTER SHARED WITH THE INTERRUPT; A NATIVE WORD SO IT IS
+   READ ATOMICALLY (IT WRAPS; ONLY DIFFERENCES ARE USED) */
+#if defined(__AVR__)
+typedef uint8_t MonocleEncoderCount;
+typedef int8_t MonocleEncoderDelta;
+#else
+typedef uint32_t MonocleEncoderCount;
+typedef int32_t MonocleEncoderDelta;
+#endif
+
+class MonocleRotaryEncoder
+{
+   private:
+    /* PIN CONFIGURATION */
+    int pinA = -1;
+    int pinB = -1;
+#ifdef MONOCLE_ENCODER_PORT_READ
+    MonocleEncoderPortRegister* portA = NULL;
+    MonocleEncoderPortRegister* portB = NULL;
+    uint32_t maskA = 0;
+    uint32_t maskB = 0;
+#endif
+    bool polled = false;       // pins without interrupts are sampled by 'loop()'
+    bool forcePolled = false;  // sample the pins by 'loop()' even with interrupts
+    bool reversed = false;
+
+    /* DECODER STATE (WRITTEN BY THE INTERRUPT ONLY) */
+    uint8_t stepsPerDetent = MONOCLE_ENCODER_FULL_CYCLE;
+    uint8_t restState = 0;     // pin state (A << 1 | B) at a detent
+    uint8_t pinState = 0;      // last decoded pin state
+    int8_t steps = 0;          // quadrature steps since the last rest state
+    volatile MonocleEncoderCount detents = 0;
+
+    /* CONSUMER STATE (MAIN LOOP ONLY) */
+    MonocleEncoderCount consumed = 0;
+    long position = 0;
+    unsigned long lastDetentTime = 0;
+    int lastDirection = 0;
+
+    /* ZOOM ACCELERATION */
+    unsigned int slowInterval = MONOCLE_ENCODER_DEFAULT_SLOW_INTERVAL;
+    unsigned int fastInterval = MONOCLE_ENCODER_DEFAULT_FAST_INTERVAL;
+    uint8_t maxSteps = MONOCLE_ENCODER_DEFAULT_MAX_STEPS;
+
+    /* DRIVEN COMPONENTS */
+    MonocleMenu* menu = NULL;
+    MonocleFlashMenu* flashMenu = NULL;
+    MonocleMotionPlanner* planner = NULL;
+    float zoomUnits = 0;
+
+    /* CALLBACKS */
+    void (*rotateCallback)(const int detents);
+    void (*zoomCallback)(const int steps);
+
+    /* PIN READER (NULL = READ THE PINS) */
+    uint8_t (*pinReader)(void) = NULL;
+
+    /* INTERNAL PROCESSING */
+    uint8_t readPins();
+    bool isRest(const uint8_t state);
+    static bool hasInterrupt(const int pin);
+    int accelerate(int detents, unsigned long now);
+
+    /* INTERRUPT ENTRY POINT (ONE ENCODER PER PROGRAM) */
+    static MonocleRotaryEncoder* isrInstance;
+    static void internal_encoder_isr();
+
+    /* SCHEDULER TASK ENTRY POINT */
+    static void internal_encoder_task(void* context);
+
+   public:
+
+    /*
+     * Default Constructor
+     */
+     MonocleRotaryEncoder();
+
+     /**
+      * CONFIGURE THE ENCODER PINS ('INPUT_PULLUP'; THE COMMON PIN TO
+      * GROUND) AND THE QUADRATURE STEPS PER DETENT (MONOCLE_ENCODER_*_CYCLE).
+      * BOTH PINS SHOULD SUPPORT INTERRUPTS (ON SAMD BOARDS ON TWO DIFFERENT
+      * EXTERNAL INTERRUPT LINES); OTHERWISE THE PINS ARE SAMPLED BY 'loop()'
+      * AND FAST TURNS MAY BE MISSED.  ONLY ONE ENCODER IS SUPPORTED.
+      * THE ENCODER MUST REST AT A DETENT WHILE THIS IS CALLED
+      */
+     void setupPins(const int pinA, const int pinB, const uint8_t stepsPerDetent = MONOCLE_ENCODER_FULL_CYCLE);
+
+     /**
+      * SAMPLE THE PINS FROM 'loop()' INSTEAD OF THE PIN INTERRUPTS, E.G.
+      * WHEN THE INTERRUPT LINES ARE NEEDED ELSEWHERE (CALL BEFORE 'setupPins()')
+      */
+     void forcePolling(bool enabled);
+
+     /**
+      * RETURNS TRUE IF THE PINS ARE SAMPLED BY 'loop()' (NO PIN INTERRUPTS)
+      */
+     bool isPolled();
+
+     /**
+      * REVERSE THE DIRECTION OF ROTATION (SWAPS CLOCKWISE AND COUNTER-CLOCKWISE)
+      */
+     void reverse(bool reversed);
+
+     /**
+      * DEFINE THE ZOOM ACCELERATION; A DETENT TURNED WITHIN 'fastInterval'
+      * MILLISECONDS OF THE LAST ONE IS 'maxSteps' ZOOM STEPS, ONE SLOWER
+      * THAN 'slowInterval' IS ONE STEP.  A 'maxSteps' OF 1 DISABLES IT
+      */
+     void setAcceleration(unsigned int slowInterval, unsigned int fastInterval, uint8_t maxSteps);
+
+     /**
+      * MOVE THE CURSOR OF A MENU WHILE IT IS ACTIVE (CLOCKWISE = NEXT)
+      */
+     void driveMenu(MonocleMenu* menu);
+     void driveMenu(MonocleFlashMenu* menu);
+
+     /**
+      * NUDGE THE ZOOM OF A MOTION PLANNER BY 'units' PER ZOOM STEP
+      * WHILE NO MENU IS ACTIVE (CLOCKWISE = ZOOM IN)
+      */
+     void driveZoom(MonocleMotionPlanner* planner, float units);
+
+     /**
+      * REGISTERS A CALLBACK FUNCTION POINTER FOR ROTATION EVENTS
+      * (DETENTS TURNED SINCE THE LAST EVENT; CLOCKWISE IS POSITIVE)
+      */
+     void onRotate(void (*rotateCallback)(const int detents));
+
+     /**
+      * REGISTERS A CALLBACK FUNCTION POINTER FOR FINE ZOOM EVENTS
+      * (ACCELERATED ZOOM STEPS; RAISED WHILE NO MENU IS ACTIVE)
+      */
+     void onZoom(void (*zoomCallback)(const int steps));
+
+     /**
+      * REPLACE THE PIN READS WITH A FUNCTION RETURNING THE PIN
+      * STATE (BIT 1 = PIN A, BIT 0 = PIN B; SET = HIGH), E.G. TO
+      * SIMULATE AN ENCODER; NULL RESTORES THE PIN READS
+      */
+     void setPinReader(uint8_t (*pinReader)(void));
+
+     /**
+      * DECODE A PIN CHANGE; CALLED FROM THE PIN INTERRUPTS (OR
+      * 'loop()' FOR POLLED PINS).  SAFE TO CALL FROM AN INTERRUPT
+      */
+     void update();
+
+     /**
+      * GET THE NUMBER OF DETENTS TURNED SINCE STARTUP (CLOCKWISE IS POSITIVE)
+      */
+     long detentPosition();
+
+     /**
+      * REGISTER THIS ENCODER AS A TASK OF A SCHEDULER (REPLACES
+      * CALLING 'loop()' FROM THE PROGRAM MAIN LOOP).
+      * RETURNS THE TASK ID OR MONOCLE_TASK_INVALID
+      */
+     int schedule(MonocleScheduler& scheduler);
+
+     /**
+      * THIS METHOD MUST BE CALLED IN THE PROGRAM MAIN LOOP
+      * TO SERVICE THIS CLASS
+      */
+     void loop();
+};
+
+#endif //MONOCLE_ROTARY_ENCODER_H
@@ -0,0 +1,407 @@
+/*
+ **********************************************************************
+ *             __  __  ___  _  _  ___   ___ _    ___
+ *            |  \/  |/ _ \| \| |/ _ \ / __| |  | __|
+ *            | |\/| | (_) | .` | (_) | (__| |__| _|
+ *            |_|  |_|\___/|_|\_|\___/ \___|____|___|
+ *
+ * -------------------------------------------------------------------
+ *                     MONOCLE SCHEDULER
+ * -------------------------------------------------------------------
+ *
+ *  This library provides a tiny fixed capacity cooperative task
+ *  scheduler.  Periodic, one-shot and event triggered tasks are
+ *  dispatched in deadline order (min-heap) from the 'loop()' method,
+ *  each task may be given a time budget and per-task overrun
+ *  statistics are collected.  When no task is due, an optional idle
+ *  callback is provided the time until the next deadline so the MCU
+ *  can sleep instead of busy-waiting.
+ *
+ *  Author:   Robert Savage
+ *  Date:     2018-02-18
+ *  Website:  http://monoclecam.com
+ *
+ * -------------------------------------------------------------------
+ *        COPYRIGHT SHADEBLUE, LLC @ 2018, ALL RIGHTS RESERVED
+ * -------------------------------------------------------------------
+ *
+ **********************************************************************
+ */
+
+#include "Arduino.h"
+#include "MonocleScheduler.h"
+#include "MonocleTelemetry.h"
+
+/* HEAP POSITION OF A TASK THAT IS NOT SCHEDULED */
+#define MONOCLE_SCHEDULER_NOT_QUEUED 0xFF
+
+/**
+ * Default Constructor
+ */
+MonocleScheduler::MonocleScheduler() {
+  for(int index = 0; index < MONOCLE_SCHEDULER_MAX_TASKS; index++){
+    tasks[index].type = MONOCLE_TASK_NONE;
+    position[index] = MONOCLE_SCHEDULER_NOT_QUEUED;
+  }
+
+  // initialize callbacks
+  idleCallback = NULL;
+}
+
+/**
+ * DETERMINE IF A TASK ID REFERS TO AN ACTIVE TASK
+ */
+bool MonocleScheduler::valid(const int task){
+  return task >= 0 && task < MONOCLE_SCHEDULER_MAX_TASKS && tasks[task].type != MONOCLE_TASK_NONE;
+}
+
+/**
+ * COMPARE THE DEADLINES OF TWO TASKS (SAFE ACROSS 'millis()' ROLLOVER)
+ */
+bool MonocleScheduler::earlier(const uint8_t a, const uint8_t b){
+  return (long)(tasks[a].due - tasks[b].due) < 0;
+}
+
+/**
+ * SWAP TWO HEAP ENTRIES AND UPDATE THEIR POSITIONS
+ */
+void MonocleScheduler::swap(const uint8_t a, const uint8_t b){
+  uint8_t task = heap[a];
+  heap[a] = heap[b];
+  heap[b] = task;
+  position[heap[a]] = a;
+  position[heap[b]] = b;
+}
+
+/**
+ * MOVE A HEAP ENTRY UP UNTIL ITS PARENT IS DUE EARLIER
+ */
+void MonocleScheduler::siftUp(uint8_t index){
+  while(index > 0){
+    uint8_t parent = (index - 1) / 2;
+    if(!earlier(heap[index], heap[parent])) break;
+    swap(index, parent);
+    index = parent;
+  }
+}
+
+/**
+ * MOVE A HEAP ENTRY DOWN UNTIL BOTH CHILDREN ARE DUE LATER
+ */
+void MonocleScheduler::siftDown(uint8_t index){
+  for(;;){
+    uint8_t left = index * 2 + 1;
+    uint8_t right = left + 1;
+    uint8_t smallest = index;
+    if(left < heapSize && earlier(heap[left], heap[smallest])) smallest = left;
+    if(right < heapSize && earlier(heap[right], heap[smallest])) smallest = right;
+    if(smallest == index) break;
+    swap(index, smallest);
+    index = smallest;
+  }
+}
+
+/**
+ * ADD A TASK TO THE DEADLINE HEAP (OR REPOSITION IT IF ALREADY QUEUED)
+ */
+void MonocleScheduler::push(const uint8_t task){
+  if(position[task] != MONOCLE_SCHEDULER_NOT_QUEUED){
+    siftUp(position[task]);
+    siftDown(position[task]);
+    return;
+  }
+  heap[heapSize] = task;
+  position[task] = heapSize;
+  heapSize++;
+  siftUp(heapSize - 1);
+}
+
+/**
+ * REMOVE A TASK FROM THE DEADLINE HEAP
+ */
+void MonocleScheduler::remove(const uint8_t task){
+  uint8_t index = position[task];
+  if(index == MONOCLE_SCHEDULER_NOT_QUEUED) return;
+
+  heapSize--;
+  if(index != heapSize){
+    // move the last entry into the gap and restore the heap order
+    uint8_t moved = heap[heapSize];
+    swap(index, heapSize);
+    siftUp(index);
+    siftDown(position[moved]);
+  }
+  position[task] = MONOCLE_SCHEDULER_NOT_QUEUED;
+}
+
+/**
+ * ALLOCATE A TASK SLOT AND SCHEDULE THE TASK
+ */
+int MonocleScheduler::create(const uint8_t type, unsigned long delay, unsigned long period,
+                             MonocleTaskCallback callback, void* context, unsigned long budget){
+  if(callback == NULL) return MONOCLE_TASK_INVALID;
+
+  for(int index = 0; index < MONOCLE_SCHEDULER_MAX_TASKS; index++){
+    if(tasks[index].type != MONOCLE_TASK_NONE) continue;
+
+    Task& task = tasks[index];
+    task.callback = callback;
+    task.context = context;
+    task.due = millis() + delay;
+    task.period = period;
+    task.budget = budget;
+    task.type = type;
+    task.suspended = false;
+    memset(&task.stats, 0, sizeof(task.stats));
+
+    // triggered tasks have no deadline
+    if(type != MONOCLE_TASK_TRIGGERED) push(index);
+    return index;
+  }
+  return MONOCLE_TASK_INVALID;
+}
+
+/**
+ * CREATE A PERIODIC TASK; THE FIRST RUN IS DUE IMMEDIATELY AND
+ * LATER DEADLINES ARE SPACED BY 'period' WITHOUT DRIFT.
+ * RETURNS THE TASK ID OR MONOCLE_TASK_INVALID IF THE TABLE IS FULL
+ */
+int MonocleScheduler::every(unsigned long period, MonocleTaskCallback callback, void* context, unsigned long budget){
+  if(period == 0) period = 1;
+  return create(MONOCLE_TASK_PERIODIC, 0, period, callback, context, budget);
+}
+
+/**
+ * CREATE A ONE-SHOT TASK DUE AFTER 'delay' MILLISECONDS; THE TASK
+ * IS REMOVED AFTER IT RUNS.
+ * RETURNS THE TASK ID OR MONOCLE_TASK_INVALID IF THE TABLE IS FULL
+ */
+int MonocleScheduler::after(unsigned long delay, MonocleTaskCallback callback, void* context, unsigned long budget){
+  return create(MONOCLE_TASK_ONESHOT, delay, 0, callback, context, budget);
+}
+
+/**
+ * CREATE AN EVENT TRIGGERED TASK; THE TASK ONLY RUNS
+ * (ONCE PER 'loop()') AFTER 'trigger()' IS CALLED.
+ * RETURNS THE TASK ID OR MONOCLE_TASK_INVALID IF THE TABLE IS FULL
+ */
+int MonocleScheduler::triggered(MonocleTaskCallback callback, void* context, unsigned long budget){
+  return create(MONOCLE_TASK_TRIGGERED, 0, 0, callback, context, budget);
+}
+
+/**
+ * REQUEST A TASK TO RUN ON THE NEXT 'loop()' (ANY TASK TYPE)
+ */
+void MonocleScheduler::trigger(const int task){
+  if(task < 0 || task >= MONOCLE_SCHEDULER_MAX_TASKS) return;
+  noInterrupts();
+  triggers |= (1UL << task);
+  interrupts();
+}
+
+/**
+ * REQUEST A TASK TO RUN ON THE NEXT 'loop()'; SAFE TO CALL
+ * FROM AN INTERRUPT SERVICE ROUTINE
+ */
+void MonocleScheduler::triggerFromISR(const int task){
+  if(task < 0 || task >= MONOCLE_SCHEDULER_MAX_TASKS) return;
+  triggers |= (1UL << task);
+}
+
+/**
+ * MOVE THE NEXT DEADLINE OF A PERIODIC OR ONE-SHOT TASK
+ * TO 'delay' MILLISECONDS FROM NOW
+ */
+bool MonocleScheduler::reschedule(const int task, unsigned long delay){
+  if(!valid(task) || tasks[task].type == MONOCLE_TASK_TRIGGERED) return false;
+  tasks[task].due = millis() + delay;
+  if(!tasks[task].suspended) push(task);
+  return true;
+}
+
+/**
+ * CHANGE THE INTERVAL OF A PERIODIC TASK
+ */
+bool MonocleScheduler::setPeriod(const int task, unsigned long period){
+  if(!valid(task) || tasks[task].type != MONOCLE_TASK_PERIODIC) return false;
+  tasks[task].period = (period == 0) ? 1 : period;
+  return true;
+}
+
+/**
+ * SUSPEND A TASK; IT KEEPS ITS ID BUT DOES NOT RUN UNTIL RESUMED
+ */
+void MonocleScheduler::suspend(const int task){
+  if(!valid(task)) return;
+  tasks[task].suspended = true;
+  remove(task);
+}
+
+/**
+ * RESUME A SUSPENDED TASK; IT IS DUE IMMEDIATELY
+ */
+void MonocleScheduler::resume(const int task){
+  if(!valid(task) || !tasks[task].suspended) return;
+  tasks[task].suspended = false;
+  if(tasks[task].type == MONOCLE_TASK_TRIGGERED) return;
+  tasks[task].due = millis();
+  push(task);
+}
+
+/**
+ * REMOVE A TASK AND RELEASE ITS ID
+ */
+void MonocleScheduler::cancel(const int task){
+  if(!valid(task)) return;
+  remove(task);
+  tasks[task].type = MONOCLE_TASK_NONE;
+  noInterrupts();
+  triggers &= ~(1UL << task);
+  interrupts();
+}
+
+/**
+ * GET THE EXECUTION STATISTICS OF A TASK (NULL IF INVALID)
+ */
+const MonocleTaskStats* MonocleScheduler::stats(const int task){
+  if(!valid(task)) return NULL;
+  return &tasks[task].stats;
+}
+
+/**
+ * RESET THE EXECUTION STATISTICS OF ALL TASKS
+ */
+void MonocleScheduler::resetStats(){
+  for(int index = 0; index < MONOCLE_SCHEDULER_MAX_TASKS; index++)
+    memset(&tasks[index].stats, 0, sizeof(tasks[index].stats));
+}
+
+/**
+ * GET THE NUMBER OF ACTIVE TASKS
+ */
+int MonocleScheduler::taskCount(){
+  int count = 0;
+  for(int index = 0; index < MONOCLE_SCHEDULER_MAX_TASKS; index++)
+    if(tasks[index].type != MONOCLE_TASK_NONE) count++;
+  return count;
+}
+
+/**
+ * GET THE TIME (MILLISECONDS) UNTIL THE NEXT DEADLINE
+ * (0 IF A TASK IS DUE OR TRIGGERED)
+ */
+unsigned long MonocleScheduler::idleTime(){
+  if(triggers != 0) return 0;
+  if(heapSize == 0) return MONOCLE_SCHEDULER_MAX_IDLE;
+
+  long remaining = (long)(tasks[heap[0]].due - millis());
+  if(remaining <= 0) return 0;
+  if(remaining > MONOCLE_SCHEDULER_MAX_IDLE) return MONOCLE_SCHEDULER_MAX_IDLE;
+  return remaining;
+}
+
+/**
+ * REGISTERS A CALLBACK FUNCTION POINTER CALLED WHEN NO TASK IS DUE;
+ * THE CALLBACK RECEIVES THE TIME UNTIL THE NEXT DEADLINE AND MAY
+ * SLEEP THE MCU FOR UP TO THAT LONG (OR UNTIL AN INTERRUPT)
+ */
+void MonocleScheduler::onIdle(void (*idleCallback)(unsigned long milliseconds)){
+  this->idleCallback = idleCallback;
+}
+
+/**
+ * REPORT TASK EXECUTION TIMES, LATENESS, BUDGET OVERRUNS AND
+ * SKIPPED DEADLINES TO A TELEMETRY COLLECTOR
+ */
+void MonocleScheduler::reportTo(MonocleTelemetry* telemetry){
+  this->telemetry = telemetry;
+}
+
+/**
+ * EXECUTE A TASK AND UPDATE ITS STATISTICS
+ */
+void MonocleScheduler::run(const uint8_t task){
+  Task& entry = tasks[task];
+
+  unsigned long start = micros();
+  entry.callback(entry.context);
+  unsigned long duration = micros() - start;
+
+  // the callback may have cancelled its own task
+  if(entry.type == MONOCLE_TASK_NONE) return;
+
+  entry.stats.runs++;
+  if(duration > entry.stats.maxDuration) entry.stats.maxDuration = duration;
+  if(entry.budget > 0 && duration > entry.budget){
+    entry.stats.overruns++;
+    if(telemetry != NULL) telemetry->count(MONOCLE_TELEMETRY_OVERRUNS);
+  }
+  if(telemetry != NULL) telemetry->sample(MONOCLE_TELEMETRY_TASK_TIME, duration);
+}
+
+/**
+ * THIS METHOD MUST BE CALLED IN THE PROGRAM MAIN LOOP
+ * TO DISPATCH TRIGGERED AND DUE TASKS
+ */
+void MonocleScheduler::loop(){
+  // take the pending triggers atomically
+  noInterrupts();
+  uint32_t pending = triggers;
+  triggers = 0;
+  interrupts();
+
+  unsigned long now = millis();
+
+  // run triggered tasks first (in task order)
+  for(uint8_t index = 0; pending != 0 && index < MONOCLE_SCHEDULER_MAX_TASKS; index++){
+    if(!(pending & (1UL << index))) continue;
+    pending &= ~(1UL << index);
+    if(tasks[index].type == MONOCLE_TASK_NONE || tasks[index].suspended) continue;
+    run(index);
+  }
+
+  // run due tasks in deadline order; tasks are due against the time
+  // sampled on entry, so a periodic task runs at most once per loop
+  // (also when it overruns its period) and cannot starve the caller
+  uint8_t dispatched = 0;
+  while(heapSize > 0 && dispatched < MONOCLE_SCHEDULER_MAX_TASKS){
+    uint8_t task = heap[0];
+    Task& entry = tasks[task];
+    if((long)(now - entry.due) < 0) break;
+
+    // lateness is measured at the actual start, after the tasks before it
+    long lateness = (long)(millis() - entry.due);
+
+    if((unsigned long)lateness > entry.stats.maxLateness) entry.stats.maxLateness = lateness;
+    if(telemetry != NULL) telemetry->sample(MONOCLE_TELEMETRY_LATENESS, lateness);
+
+    if(entry.type == MONOCLE_TASK_PERIODIC){
+      // advance the deadline by whole periods (drift free);
+      // deadlines missed entirely are skipped and counted
+      entry.due += entry.period;
+      if((long)(now - entry.due) >= 0){
+        unsigned long missed = (now - entry.due) / entry.period + 1;
+        entry.stats.skipped += missed;
+        if(telemetry != NULL) telemetry->count(MONOCLE_TELEMETRY_SKIPPED, missed);
+        entry.due += missed * entry.period;
+      }
+      siftDown(0);
+    }
+    else{
+      remove(task);
+    }
+
+    run(task);
+    dispatched++;
+
+    // release one-shot tasks after they run
+    if(entry.type == MONOCLE_TASK_ONESHOT && position[task] == MONOCLE_SCHEDULER_NOT_QUEUED)
+      entry.type = MONOCLE_TASK_NONE;
+  }
+
+  // nothing left to do; let the application sleep until the next deadline
+  if(idleCallback != NULL){
+    unsigned long idle = idleTime();
+    if(idle > 0) idleCallback(idle);
+  }
+}
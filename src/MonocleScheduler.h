@@ -0,0 +1,222 @@
+/*
+ **********************************************************************
+ *             __  __  ___  _  _  ___   ___ _    ___
+ *            |  \/  |/ _ \| \| |/ _ \ / __| |  | __|
+ *            | |\/| | (_) | .` | (_) | (__| |__| _|
+ *            |_|  |_|\___/|_|\_|\___/ \___|____|___|
+ *
+ * -------------------------------------------------------------------
+ *                     MONOCLE SCHEDULER
+ * -------------------------------------------------------------------
+ *
+ *  This library provides a tiny fixed capacity cooperative task
+ *  scheduler.  Periodic, one-shot and event triggered tasks are
+ *  dispatched in deadline order (min-heap) from the 'loop()' method,
+ *  each task may be given a time budget and per-task overrun
+ *  statistics are collected.  When no task is due, an optional idle
+ *  callback is provided the time until the next deadline so the MCU
+ *  can sleep instead of busy-waiting.
+ *
+ *  Author:   Robert Savage
+ *  Date:     2018-02-18
+ *  Website:  http://monoclecam.com
+ *
+ * -------------------------------------------------------------------
+ *        COPYRIGHT SHADEBLUE, LLC @ 2018, ALL RIGHTS RESERVED
+ * -------------------------------------------------------------------
+ *
+ **********************************************************************
+ */
+#ifndef MONOCLE_SCHEDULER_H
+#define MONOCLE_SCHEDULER_H
+
+#include <Arduino.h>
+
+class MonocleTelemetry;
+
+/* MAXIMUM NUMBER OF TASKS */
+#ifndef MONOCLE_SCHEDULER_MAX_TASKS
+#define MONOCLE_SCHEDULER_MAX_TASKS 16
+#endif
+
+/* MAXIMUM TIME PROVIDED TO THE IDLE CALLBACK WHEN NO TASK IS SCHEDULED */
+#ifndef MONOCLE_SCHEDULER_MAX_IDLE
+#define MONOCLE_SCHEDULER_MAX_IDLE 1000   // milliseconds
+#endif
+
+#if MONOCLE_SCHEDULER_MAX_TASKS > 32
+#error("MONOCLE_SCHEDULER_MAX_TASKS cannot exceed 32 tasks")
+#endif
+
+/* TASK TYPES */
+#define MONOCLE_TASK_NONE      0
+#define MONOCLE_TASK_PERIODIC  1
+#define MONOCLE_TASK_ONESHOT   2
+#define MONOCLE_TASK_TRIGGERED 3
+
+/* RETURNED WHEN A TASK CANNOT BE CREATED */
+#define MONOCLE_TASK_INVALID   -1
+
+/* TASK CALLBACK; THE CONTEXT POINTER IS PASSED BACK AS REGISTERED */
+typedef void (*MonocleTaskCallback)(void* context);
+
+/**
+ * PER-TASK EXECUTION STATISTICS
+ */
+struct MonocleTaskStats {
+  unsigned long runs;          // number of executions
+  unsigned long overruns;      // executions exceeding the task budget
+  unsigned long skipped;       // periodic deadlines missed entirely
+  unsigned long maxDuration;   // longest execution (microseconds)
+  unsigned long maxLateness;   // longest delay past the deadline (milliseconds)
+};
+
+class MonocleScheduler
+{
+   private:
+     struct Task {
+       MonocleTaskCallback callback;
+       void* context;
+       unsigned long due;       // next deadline (millis)
+       unsigned long period;    // periodic interval (milliseconds)
+       unsigned long budget;    // allowed execution time (microseconds; 0 = unlimited)
+       uint8_t type;
+       bool suspended;
+       MonocleTaskStats stats;
+     };
+
+     /* TASK TABLE */
+     Task tasks[MONOCLE_SCHEDULER_MAX_TASKS];
+
+     /* MIN-HEAP OF SCHEDULED TASK IDS ORDERED BY DEADLINE */
+     uint8_t heap[MONOCLE_SCHEDULER_MAX_TASKS];
+     uint8_t position[MONOCLE_SCHEDULER_MAX_TASKS];   // heap position of each task
+     uint8_t heapSize = 0;
+
+     /* PENDING TRIGGERS (ONE BIT PER TASK; MAY BE SET FROM AN ISR) */
+     volatile uint32_t triggers = 0;
+
+     /* IDLE CALLBACK */
+     void (*idleCallback)(unsigned long milliseconds);
+
+     /* OPTIONAL TELEMETRY (TASK TIMING, OVERRUNS AND SKIPPED DEADLINES) */
+     MonocleTelemetry* telemetry = NULL;
+
+     /* INTERNAL PROCESSING */
+     int create(const uint8_t type, unsigned long delay, unsigned long period,
+                MonocleTaskCallback callback, void* context, unsigned long budget);
+     bool earlier(const uint8_t a, const uint8_t b);
+     void swap(const uint8_t a, const uint8_t b);
+     void siftUp(uint8_t index);
+     void siftDown(uint8_t index);
+     void push(const uint8_t task);
+     void remove(const uint8_t task);
+     void run(const uint8_t task);
+     bool valid(const int task);
+
+   public:
+    /**
+     * Default Constructor
+     */
+     MonocleScheduler();
+
+     /**
+      * CREATE A PERIODIC TASK; THE FIRST RUN IS DUE IMMEDIATELY AND
+      * LATER DEADLINES ARE SPACED BY 'period' WITHOUT DRIFT.
+      * RETURNS THE TASK ID OR MONOCLE_TASK_INVALID IF THE TABLE IS FULL
+      */
+     int every(unsigned long period, MonocleTaskCallback callback, void* context = NULL, unsigned long budget = 0);
+
+     /**
+      * CREATE A ONE-SHOT TASK DUE AFTER 'delay' MILLISECONDS; THE TASK
+      * IS REMOVED AFTER IT RUNS.
+      * RETURNS THE TASK ID OR MONOCLE_TASK_INVALID IF THE TABLE IS FULL
+      */
+     int after(unsigned long delay, MonocleTaskCallback callback, void* context = NULL, unsigned long budget = 0);
+
+     /**
+      * CREATE AN EVENT TRIGGERED TASK; THE TASK ONLY RUNS
+      * (ONCE PER 'loop()') AFTER 'trigger()' IS CALLED.
+      * RETURNS THE TASK ID OR MONOCLE_TASK_INVALID IF THE TABLE IS FULL
+      */
+     int triggered(MonocleTaskCallback callback, void* context = NULL, unsigned long budget = 0);
+
+     /**
+      * REQUEST A TASK TO RUN ON THE NEXT 'loop()' (ANY TASK TYPE)
+      */
+     void trigger(const int task);
+
+     /**
+      * REQUEST A TASK TO RUN ON THE NEXT 'loop()'; SAFE TO CALL
+      * FROM AN INTERRUPT SERVICE ROUTINE
+      */
+     void triggerFromISR(const int task);
+
+     /**
+      * MOVE THE NEXT DEADLINE OF A PERIODIC OR ONE-SHOT TASK
+      * TO 'delay' MILLISECONDS FROM NOW
+      */
+     bool reschedule(const int task, unsigned long delay);
+
+     /**
+      * CHANGE THE INTERVAL OF A PERIODIC TASK
+      */
+     bool setPeriod(const int task, unsigned long period);
+
+     /**
+      * SUSPEND A TASK; IT KEEPS ITS ID BUT DOES NOT RUN UNTIL RESUMED
+      */
+     void suspend(const int task);
+
+     /**
+      * RESUME A SUSPENDED TASK; IT IS DUE IMMEDIATELY
+      */
+     void resume(const int task);
+
+     /**
+      * REMOVE A TASK AND RELEASE ITS ID
+      */
+     void cancel(const int task);
+
+     /**
+      * GET THE EXECUTION STATISTICS OF A TASK (NULL IF INVALID)
+      */
+     const MonocleTaskStats* stats(const int task);
+
+     /**
+      * RESET THE EXECUTION STATISTICS OF ALL TASKS
+      */
+     void resetStats();
+
+     /**
+      * GET THE NUMBER OF ACTIVE TASKS
+      */
+     int taskCount();
+
+     /**
+      * GET THE TIME (MILLISECONDS) UNTIL THE NEXT DEADLINE
+      * (0 IF A TASK IS DUE OR TRIGGERED)
+      */
+     unsigned long idleTime();
+
+     /**
+      * REGISTERS A CALLBACK FUNCTION POINTER CALLED WHEN NO TASK IS DUE;
+      * THE CALLBACK RECEIVES THE TIME UNTIL THE NEXT DEADLINE AND MAY
+      * SLEEP THE MCU FOR UP TO THAT LONG (OR UNTIL AN INTERRUPT)
+      */
+     void onIdle(void (*idleCallback)(unsigned long milliseconds));
+
+     /**
+      * REPORT TASK EXECUTION TIMES, LATENESS, BUDGET OVERRUNS AND
+      * SKIPPED DEADLINES TO A TELEMETRY COLLECTOR
+      */
+     void reportTo(MonocleTelemetry* telemetry);
+
+     /**
+      * THIS METHOD MUST BE CALLED IN THE PROGRAM MAIN LOOP
+      * TO DISPATCH TRIGGERED AND DUE TASKS
+      */
+     void loop();
+};
+
+#endif //MONOCLE_SCHEDULER_H
@@ -0,0 +1,253 @@
+/*
+ **********************************************************************
+ *             __  __  ___  _  _  ___   ___ _    ___
+ *            |  \/  |/ _ \| \| |/ _ \ / __| |  | __|
+ *            | |\/| | (_) | .` | (_) | (__| |__| _|
+ *            |_|  |_|\___/|_|\_|\___/ \___|____|___|
+ *
+ * -------------------------------------------------------------------
+ *                     MONOCLE BOOT SNAPSHOT
+ * -------------------------------------------------------------------
+ *
+ *  This library persists the controller state needed for a fast
+ *  boot: the last active camera source, the gateway endpoint, the
+ *  Wi-Fi channel and access point BSSID and the joystick
+ *  calibration.  The state is kept in one compact, versioned and
+ *  CRC-protected record in 'MonocleStorage'.  At boot the record is
+ *  restored before the network is up so the display and controls
+ *  are live immediately; the network join and gateway connection
+ *  continue in the background.
+ *
+ *  Changes are saved after a short delay so a burst of updates
+ *  results in a single storage write.
+ *
+ *  Author:   Robert Savage
+ *  Date:     2018-02-18
+ *  Website:  http://monoclecam.com
+ *
+ * -------------------------------------------------------------------
+ *        COPYRIGHT SHADEBLUE, LLC @ 2018, ALL RIGHTS RESERVED
+ * -------------------------------------------------------------------
+ *
+ **********************************************************************
+ */
+
+#include "Arduino.h"
+#include "MonocleSnapshot.h"
+
+/**
+ * COPY A (POSSIBLY NULL) TEXT VALUE INTO A ZERO PADDED RECORD FIELD
+ */
+static void copySnapshotText(char* target, const char* value){
+  if(value == NULL) value = "";
+  strncpy(target, value, MONOCLE_GATEWAY_CAMERA_TEXT_LENGTH);
+  target[MONOCLE_GATEWAY_CAMERA_TEXT_LENGTH] = '\0';
+}
+
+/**
+ * Default Constructor
+ */
+MonocleSnapshot::MonocleSnapshot(MonocleStorage& storage, size_t address) : storage(storage), address(address) {
+  // the record is compared byte for byte; clear any padding
+  memset(&record, 0, sizeof(record));
+}
+
+/**
+ * LOAD THE SNAPSHOT FROM STORAGE.
+ * RETURNS 'false' IF NO VALID SNAPSHOT IS STORED
+ */
+bool MonocleSnapshot::restore(){
+  MonocleSnapshotRecord stored;
+  if(!storage.load(address, MONOCLE_SNAPSHOT_VERSION, &stored, sizeof(stored))) return false;
+  record = stored;
+  dirty = false;
+  return true;
+}
+
+/**
+ * DETERMINE IF A SECTION (MONOCLE_SNAPSHOT_*) HOLDS A SAVED VALUE
+ */
+bool MonocleSnapshot::has(const uint8_t section){
+  return (record.sections & section) == section;
+}
+
+/**
+ * GET THE SAVED ACTIVE CAMERA SOURCE (THE TEXT VALUES ARE
+ * OWNED BY THIS SNAPSHOT)
+ */
+CameraSource MonocleSnapshot::camera(){
+  CameraSource camera;
+  camera.uuid = record.cameraUuid;
+  camera.name = record.cameraName;
+  camera.manufacturer = record.cameraManufacturer;
+  camera.model = record.cameraModel;
+  camera.ptz = record.cameraPtz;
+  camera.error = record.cameraError;
+  camera.errorMessage = "";
+  return camera;
+}
+
+/**
+ * GET THE SAVED GATEWAY ENDPOINT
+ */
+IPAddress MonocleSnapshot::gatewayAddress(){
+  return IPAddress(record.gatewayAddress[0], record.gatewayAddress[1], record.gatewayAddress[2], record.gatewayAddress[3]);
+}
+uint16_t MonocleSnapshot::gatewayPort(){
+  return record.gatewayPort;
+}
+
+/**
+ * GET THE SAVED WI-FI CHANNEL AND ACCESS POINT BSSID
+ */
+uint8_t MonocleSnapshot::wifiChannel(){
+  return record.wifiChannel;
+}
+uint8_t* MonocleSnapshot::wifiBSSID(){
+  return record.wifiBSSID;
+}
+
+/**
+ * GET THE SAVED JOYSTICK CALIBRATION
+ */
+const MonocleJoystickCalibration& MonocleSnapshot::calibration(){
+  return record.calibration;
+}
+
+/**
+ * APPLY THE SAVED ACTIVE CAMERA SOURCE TO A GATEWAY CLIENT
+ * (RAISES ITS CAMERA CHANGE CALLBACK).
+ * RETURNS 'false' IF NO CAMERA IS SAVED
+ */
+bool MonocleSnapshot::restoreCamera(MonocleGatewayClient& gateway){
+  if(!has(MONOCLE_SNAPSHOT_CAMERA)) return false;
+  gateway.restoreCamera(camera());
+  return true;
+}
+
+/**
+ * APPLY THE SAVED CALIBRATION TO A JOYSTICK.
+ * RETURNS 'false' IF NO CALIBRATION IS SAVED
+ */
+bool MonocleSnapshot::restoreCalibration(MonoclePTZJoystick& joystick){
+  if(!has(MONOCLE_SNAPSHOT_CALIBRATION)) return false;
+  joystick.setCalibration(record.calibration);
+  return true;
+}
+
+/**
+ * UPDATE THE SNAPSHOT; CHANGES ARE SAVED AFTER THE SAVE DELAY
+ * (VALUES EQUAL TO THE SAVED ONES DO NOT CAUSE A WRITE)
+ */
+void MonocleSnapshot::setCamera(const CameraSource& camera){
+  MonocleSnapshotRecord update = record;
+  update.sections |= MONOCLE_SNAPSHOT_CAMERA;
+  update.cameraPtz = camera.ptz;
+  update.cameraError = camera.error;
+  copySnapshotText(update.cameraUuid, camera.uuid);
+  copySnapshotText(update.cameraName, camera.name);
+  copySnapshotText(update.cameraManufacturer, camera.manufacturer);
+  copySnapshotText(update.cameraModel, camera.model);
+  if(memcmp(&update, &record, sizeof(record)) == 0) return;
+  record = update;
+  changed();
+}
+void MonocleSnapshot::setGateway(const IPAddress& address, const uint16_t port){
+  MonocleSnapshotRecord update = record;
+  update.sections |= MONOCLE_SNAPSHOT_GATEWAY;
+  for(int index = 0; index < 4; index++) update.gatewayAddress[index] = address[index];
+  update.gatewayPort = port;
+  if(memcmp(&update, &record, sizeof(record)) == 0) return;
+  record = update;
+  changed();
+}
+void MonocleSnapshot::setWiFi(const uint8_t channel, const uint8_t* bssid){
+  if(bssid == NULL) return;
+  MonocleSnapshotRecord update = record;
+  update.sections |= MONOCLE_SNAPSHOT_WIFI;
+  update.wifiChannel = channel;
+  memcpy(update.wifiBSSID, bssid, sizeof(update.wifiBSSID));
+  if(memcmp(&update, &record, sizeof(record)) == 0) return;
+  record = update;
+  changed();
+}
+void MonocleSnapshot::setCalibration(const MonocleJoystickCalibration& calibration){
+  MonocleSnapshotRecord update = record;
+  update.sections |= MONOCLE_SNAPSHOT_CALIBRATION;
+  update.calibration = calibration;
+  if(memcmp(&update, &record, sizeof(record)) == 0) return;
+  record = update;
+  changed();
+}
+void MonocleSnapshot::setCalibration(MonoclePTZJoystick& joystick){
+  MonocleJoystickCalibration calibration;
+  memset(&calibration, 0, sizeof(calibration));
+  joystick.getCalibration(calibration);
+  setCalibration(calibration);
+}
+
+/**
+ * FORGET ALL SAVED SECTIONS
+ */
+void MonocleSnapshot::clear(){
+  memset(&record, 0, sizeof(record));
+  changed();
+}
+
+/**
+ * MARK THE SNAPSHOT CHANGED; THE SAVE DELAY RESTARTS
+ */
+void MonocleSnapshot::changed(){
+  dirty = true;
+  changeTime = millis();
+}
+
+/**
+ * WRITE PENDING CHANGES TO STORAGE NOW.
+ * RETURNS 'false' ON FAILURE
+ */
+bool MonocleSnapshot::save(){
+  if(!dirty) return true;
+  if(!storage.save(address, MONOCLE_SNAPSHOT_VERSION, &record, sizeof(record))) return false;
+  dirty = false;
+  return true;
+}
+
+/**
+ * EVENT BUS SUBSCRIBER; SAVES THE ACTIVE CAMERA SOURCE
+ */
+void MonocleSnapshot::internal_snapshot_event_handler(const MonocleEvent& event, void* context){
+  if(event.camera != NULL) ((MonocleSnapshot*)context)->setCamera(*event.camera);
+}
+
+/**
+ * SAVE ACTIVE CAMERA CHANGES PUBLISHED ON AN EVENT BUS
+ */
+bool MonocleSnapshot::subscribeTo(MonocleEventBus* bus){
+  if(bus == NULL) return false;
+  return bus->subscribe(MONOCLE_EVENT_CAMERA, internal_snapshot_event_handler, this);
+}
+
+/**
+ * SCHEDULER TASK ENTRY POINT
+ */
+void MonocleSnapshot::internal_snapshot_task(void* context){
+  ((MonocleSnapshot*)context)->loop();
+}
+
+/**
+ * REGISTER THIS SNAPSHOT AS A TASK OF A SCHEDULER (REPLACES
+ * CALLING 'loop()' FROM THE PROGRAM MAIN LOOP).
+ * RETURNS THE TASK ID OR MONOCLE_TASK_INVALID
+ */
+int MonocleSnapshot::schedule(MonocleScheduler& scheduler){
+  return scheduler.every(MONOCLE_SNAPSHOT_TASK_INTERVAL, internal_snapshot_task, this, MONOCLE_SNAPSHOT_TASK_BUDGET);
+}
+
+/**
+ * THIS METHOD MUST BE CALLED IN THE PROGRAM MAIN LOOP
+ * TO SAVE CHANGES AFTER THE SAVE DELAY
+ */
+void MonocleSnapshot::loop(){
+  if(dirty && (millis() - changeTime) >= MONOCLE_SNAPSHOT_SAVE_DELAY) save();
+}
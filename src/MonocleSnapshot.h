@@ -0,0 +1,208 @@
+/*
+ **********************************************************************
+ *             __  __  ___  _  _  ___   ___ _    ___
+ *            |  \/  |/ _ \| \| |/ _ \ / __| |  | __|
+ *            | |\/| | (_) | .` | (_) | (__| |__| _|
+ *            |_|  |_|\___/|_|\_|\___/ \___|____|___|
+ *
+ * -------------------------------------------------------------------
+ *                     MONOCLE BOOT SNAPSHOT
+ * -------------------------------------------------------------------
+ *
+ *  This library persists the controller state needed for a fast
+ *  boot: the last active camera source, the gateway endpoint, the
+ *  Wi-Fi channel and access point BSSID and the joystick
+ *  calibration.  The state is kept in one compact, versioned and
+ *  CRC-protected record in 'MonocleStorage'.  At boot the record is
+ *  restored before the network is up so the display and controls
+ *  are live immediately; the network join and gateway connection
+ *  continue in the background.
+ *
+ *  Changes are saved after a short delay so a burst of updates
+ *  results in a single storage write.
+ *
+ *  Author:   Robert Savage
+ *  Date:     2018-02-18
+ *  Website:  http://monoclecam.com
+ *
+ * -------------------------------------------------------------------
+ *        COPYRIGHT SHADEBLUE, LLC @ 2018, ALL RIGHTS RESERVED
+ * -------------------------------------------------------------------
+ *
+ **********************************************************************
+ */
+#ifndef MONOCLE_SNAPSHOT_H
+#define MONOCLE_SNAPSHOT_H
+
+#include <Arduino.h>
+#include "MonocleStorage.h"
+#include "MonocleGatewayClient.h"
+#include "MonoclePTZJoystick.h"
+#include "MonocleEventBus.h"
+#include "MonocleScheduler.h"
+
+/* VERSION OF THE SNAPSHOT RECORD (INCREMENT WHEN THE LAYOUT CHANGES) */
+#define MONOCLE_SNAPSHOT_VERSION 1
+
+/* DELAY BEFORE CHANGES ARE WRITTEN TO STORAGE */
+#ifndef MONOCLE_SNAPSHOT_SAVE_DELAY
+#define MONOCLE_SNAPSHOT_SAVE_DELAY 5000   // milliseconds
+#endif
+
+/* SCHEDULER TASK INTERVAL AND EXECUTION BUDGET */
+#ifndef MONOCLE_SNAPSHOT_TASK_INTERVAL
+#define MONOCLE_SNAPSHOT_TASK_INTERVAL 500    // milliseconds
+#endif
+#ifndef MONOCLE_SNAPSHOT_TASK_BUDGET
+#define MONOCLE_SNAPSHOT_TASK_BUDGET   500    // microseconds (excluding storage writes)
+#endif
+
+/* SNAPSHOT SECTIONS */
+#define MONOCLE_SNAPSHOT_CAMERA      0x01
+#define MONOCLE_SNAPSHOT_GATEWAY     0x02
+#define MONOCLE_SNAPSHOT_WIFI        0x04
+#define MONOCLE_SNAPSHOT_CALIBRATION 0x08
+
+/**
+ * PERSISTED SNAPSHOT RECORD
+ */
+struct MonocleSnapshotRecord {
+  uint8_t sections;                 // MONOCLE_SNAPSHOT_* flags of the valid sections
+
+  // last active camera source (the error message is not kept)
+  bool cameraPtz;
+  bool cameraError;
+  char cameraUuid[MONOCLE_GATEWAY_CAMERA_TEXT_LENGTH + 1];
+  char cameraName[MONOCLE_GATEWAY_CAMERA_TEXT_LENGTH + 1];
+  char cameraManufacturer[MONOCLE_GATEWAY_CAMERA_TEXT_LENGTH + 1];
+  char cameraModel[MONOCLE_GATEWAY_CAMERA_TEXT_LENGTH + 1];
+
+  // gateway endpoint
+  uint8_t gatewayAddress[4];
+  uint16_t gatewayPort;
+
+  // wireless access point
+  uint8_t wifiChannel;
+  uint8_t wifiBSSID[6];
+
+  // joystick calibration
+  MonocleJoystickCalibration calibration;
+};
+
+class MonocleSnapshot
+{
+   private:
+     MonocleStorage& storage;
+     size_t address;
+
+     /* SNAPSHOT STATE */
+     MonocleSnapshotRecord record;
+     bool dirty = false;
+     unsigned long changeTime = 0;
+
+     /* INTERNAL PROCESSING */
+     void changed();
+
+     /* EVENT BUS SUBSCRIBER (CAMERA EVENTS) */
+     static void internal_snapshot_event_handler(const MonocleEvent& event, void* context);
+
+     /* SCHEDULER TASK ENTRY POINT */
+     static void internal_snapshot_task(void* context);
+
+   public:
+    /**
+     * Default Constructor; the record occupies
+     * 'MonocleStorage::footprint(sizeof(MonocleSnapshotRecord))'
+     * bytes of storage at the given address
+     */
+     MonocleSnapshot(MonocleStorage& storage, size_t address = 0);
+
+     /**
+      * LOAD THE SNAPSHOT FROM STORAGE.
+      * RETURNS 'false' IF NO VALID SNAPSHOT IS STORED
+      */
+     bool restore();
+
+     /**
+      * DETERMINE IF A SECTION (MONOCLE_SNAPSHOT_*) HOLDS A SAVED VALUE
+      */
+     bool has(const uint8_t section);
+
+     /**
+      * GET THE SAVED ACTIVE CAMERA SOURCE (THE TEXT VALUES ARE
+      * OWNED BY THIS SNAPSHOT)
+      */
+     CameraSource camera();
+
+     /**
+      * GET THE SAVED GATEWAY ENDPOINT
+      */
+     IPAddress gatewayAddress();
+     uint16_t gatewayPort();
+
+     /**
+      * GET THE SAVED WI-FI CHANNEL AND ACCESS POINT BSSID
+      * (E.G. FOR 'WiFi.begin(ssid, pass, channel, bssid)' ON THE ESP32/ESP8266)
+      */
+     uint8_t wifiChannel();
+     uint8_t* wifiBSSID();
+
+     /**
+      * GET THE SAVED JOYSTICK CALIBRATION
+      */
+     const MonocleJoystickCalibration& calibration();
+
+     /**
+      * APPLY THE SAVED ACTIVE CAMERA SOURCE TO A GATEWAY CLIENT
+      * (RAISES ITS CAMERA CHANGE CALLBACK).
+      * RETURNS 'false' IF NO CAMERA IS SAVED
+      */
+     bool restoreCamera(MonocleGatewayClient& gateway);
+
+     /**
+      * APPLY THE SAVED CALIBRATION TO A JOYSTICK.
+      * RETURNS 'false' IF NO CALIBRATION IS SAVED
+      */
+     bool restoreCalibration(MonoclePTZJoystick& joystick);
+
+     /**
+      * UPDATE THE SNAPSHOT; CHANGES ARE SAVED AFTER THE SAVE DELAY
+      * (VALUES EQUAL TO THE SAVED ONES DO NOT CAUSE A WRITE)
+      */
+     void setCamera(const CameraSource& camera);
+     void setGateway(const IPAddress& address, const uint16_t port);
+     void setWiFi(const uint8_t channel, const uint8_t* bssid);
+     void setCalibration(const MonocleJoystickCalibration& calibration);
+     void setCalibration(MonoclePTZJoystick& joystick);
+
+     /**
+      * FORGET ALL SAVED SECTIONS
+      */
+     void clear();
+
+     /**
+      * WRITE PENDING CHANGES TO STORAGE NOW.
+      * RETURNS 'false' ON FAILURE
+      */
+     bool save();
+
+     /**
+      * SAVE ACTIVE CAMERA CHANGES PUBLISHED ON AN EVENT BUS
+      */
+     bool subscribeTo(MonocleEventBus* bus);
+
+     /**
+      * REGISTER THIS SNAPSHOT AS A TASK OF A SCHEDULER (REPLACES
+      * CALLING 'loop()' FROM THE PROGRAM MAIN LOOP).
+      * RETURNS THE TASK ID OR MONOCLE_TASK_INVALID
+      */
+     int schedule(MonocleScheduler& scheduler);
+
+     /**
+      * THIS METHOD MUST BE CALLED IN THE PROGRAM MAIN LOOP
+      * TO SAVE CHANGES AFTER THE SAVE DELAY
+      */
+     void loop();
+};
+
+#endif //MONOCLE_SNAPSHOT_H
@@ -0,0 +1,274 @@
+/*
+ **********************************************************************
+ *             __  __  ___  _  _  ___   ___ _    ___
+ *            |  \/  |/ _ \| \| |/ _ \ / __| |  | __|
+ *            | |\/| | (_) | .` | (_) | (__| |__| _|
+ *            |_|  |_|\___/|_|\_|\___/ \___|____|___|
+ *
+ * -------------------------------------------------------------------
+ *                     MONOCLE STORAGE
+ * -------------------------------------------------------------------
+ *
+ *  This library provides small persistent records for the Monocle
+ *  components (cached gateway endpoints, boot snapshots and runtime
+ *  configuration).  'MonocleStorage' is a byte addressable storage
+ *  interface; records are stored with a header holding a magic
+ *  number, a version and the record length, and are protected by a
+ *  CRC so that blank, stale or corrupted storage is never restored.
+ *  Unchanged records are not written again to spare the flash.
+ *
+ *  'MonocleEEPROMStorage' implements the interface on top of the
+ *  EEPROM (emulation) library of the ESP8266, ESP32 and AVR cores.
+ *  'MonocleFlashStorage' implements it on the SAMD21 (MKR1000) using
+ *  a reserved region of the program flash.  The region is part of the
+ *  sketch image, so it is erased on every reflash: all records are
+ *  lost whenever a new sketch is uploaded and the components fall
+ *  back to their defaults on the next boot.
+ *
+ *  Author:   Robert Savage
+ *  Date:     2018-02-18
+ *  Website:  http://monoclecam.com
+ *
+ * -------------------------------------------------------------------
+ *        COPYRIGHT SHADEBLUE, LLC @ 2018, ALL RIGHTS RESERVED
+ * -------------------------------------------------------------------
+ *
+ **********************************************************************
+ */
+
+#include "Arduino.h"
+#include "MonocleStorage.h"
+
+#ifdef MONOCLE_STORAGE_EEPROM
+#include <EEPROM.h>
+#endif
+
+/**
+ * CALCULATE THE CRC-16 (CCITT) OF A BLOCK OF BYTES
+ */
+uint16_t MonocleStorage::crc16(const void* data, size_t length, uint16_t crc){
+  const uint8_t* bytes = (const uint8_t*)data;
+  while(length--){
+    crc ^= (uint16_t)(*bytes++) << 8;
+    for(uint8_t bit = 0; bit < 8; bit++){
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+    }
+  }
+  return crc;
+}
+
+/**
+ * GET THE NUMBER OF STORAGE BYTES USED BY A RECORD
+ */
+size_t MonocleStorage::footprint(size_t length){
+  return sizeof(MonocleRecordHeader) + length;
+}
+
+/**
+ * LOAD A RECORD STORED AT AN ADDRESS; THE RECORD IS ONLY COPIED
+ * WHEN THE MAGIC NUMBER, VERSION, LENGTH AND CRC ALL MATCH.
+ * RETURNS 'false' IF NO VALID RECORD IS STORED
+ */
+bool MonocleStorage::load(size_t address, uint8_t version, void* record, size_t length){
+  MonocleRecordHeader header;
+  if(!read(address, &header, sizeof(header))) return false;
+  if(header.magic != MONOCLE_STORAGE_MAGIC || header.version != version || header.length != length) return false;
+
+  // verify the stored bytes before touching the caller's record
+  uint16_t crc = crc16(&header, sizeof(header) - sizeof(header.crc));
+  uint8_t buffer[32];
+  size_t offset = 0;
+  while(offset < length){
+    size_t chunk = length - offset;
+    if(chunk > sizeof(buffer)) chunk = sizeof(buffer);
+    if(!read(address + sizeof(header) + offset, buffer, chunk)) return false;
+    crc = crc16(buffer, chunk, crc);
+    offset += chunk;
+  }
+  if(crc != header.crc) return false;
+
+  return read(address + sizeof(header), record, length);
+}
+
+/**
+ * SAVE A RECORD TO AN ADDRESS (SKIPPED IF THE STORED RECORD IS
+ * IDENTICAL). A RECORD OCCUPIES 'footprint(length)' BYTES.
+ * RETURNS 'false' ON FAILURE
+ */
+bool MonocleStorage::save(size_t address, uint8_t version, const void* record, size_t length){
+  if(length > 0xFFFF || address + footprint(length) > size()) return false;
+
+  MonocleRecordHeader header;
+  header.magic = MONOCLE_STORAGE_MAGIC;
+  header.version = version;
+  header.reserved = 0;
+  header.length = (uint16_t)length;
+  header.crc = crc16(&header, sizeof(header) - sizeof(header.crc));
+  header.crc = crc16(record, length, header.crc);
+
+  // an identical header (same CRC) almost certainly means an identical record;
+  // compare the bytes to be sure before skipping the write
+  MonocleRecordHeader stored;
+  if(read(address, &stored, sizeof(stored)) && memcmp(&stored, &header, sizeof(header)) == 0){
+    const uint8_t* bytes = (const uint8_t*)record;
+    uint8_t buffer[32];
+    size_t offset = 0;
+    bool same = true;
+    while(same && offset < length){
+      size_t chunk = length - offset;
+      if(chunk > sizeof(buffer)) chunk = sizeof(buffer);
+      same = read(address + sizeof(header) + offset, buffer, chunk) && memcmp(buffer, bytes + offset, chunk) == 0;
+      offset += chunk;
+    }
+    if(same) return true;
+  }
+
+  if(!write(address + sizeof(header), record, length)) return false;
+  if(!write(address, &header, sizeof(header))) return false;
+  return commit();
+}
+
+/**
+ * INVALIDATE THE RECORD STORED AT AN ADDRESS
+ */
+bool MonocleStorage::erase(size_t address){
+  uint16_t blank = 0xFFFF;
+  if(!write(address, &blank, sizeof(blank))) return false;
+  return commit();
+}
+
+#ifdef MONOCLE_STORAGE_EEPROM
+/**
+ * Default Constructor
+ */
+MonocleEEPROMStorage::MonocleEEPROMStorage(size_t capacity) {
+  this->capacity = capacity;
+}
+
+/**
+ * START THE EEPROM (EMULATION); MUST BE CALLED BEFORE USE
+ */
+void MonocleEEPROMStorage::begin(){
+#if defined(ESP8266) || defined(ESP32)
+  EEPROM.begin(capacity);
+#else
+  if(capacity > EEPROM.length()) capacity = EEPROM.length();
+#endif
+}
+
+size_t MonocleEEPROMStorage::size(){
+  return capacity;
+}
+
+bool MonocleEEPROMStorage::read(size_t address, void* data, size_t length){
+  if(address + length > capacity) return false;
+  uint8_t* bytes = (uint8_t*)data;
+  for(size_t index = 0; index < length; index++){
+    bytes[index] = EEPROM.read(address + index);
+  }
+  return true;
+}
+
+bool MonocleEEPROMStorage::write(size_t address, const void* data, size_t length){
+  if(address + length > capacity) return false;
+  const uint8_t* bytes = (const uint8_t*)data;
+  for(size_t index = 0; index < length; index++){
+#if defined(ESP8266) || defined(ESP32)
+    EEPROM.write(address + index, bytes[index]);
+#else
+    EEPROM.update(address + index, bytes[index]);
+#endif
+  }
+  return true;
+}
+
+bool MonocleEEPROMStorage::commit(){
+#if defined(ESP8266) || defined(ESP32)
+  return EEPROM.commit();
+#else
+  return true;
+#endif
+}
+#endif
+
+#ifdef MONOCLE_STORAGE_FLASH
+/* RESERVED FLASH REGION; ROW ALIGNED SO IT CAN BE ERASED WITHOUT TOUCHING THE PROGRAM
+   (BEING PART OF THE SKETCH IMAGE, THE UPLOADER ERASES IT ON EVERY REFLASH) */
+__attribute__((__aligned__(MONOCLE_STORAGE_FLASH_ROW_SIZE)))
+static const uint8_t monocle_flash_region[MONOCLE_STORAGE_FLASH_SIZE] = { };
+
+/**
+ * Default Constructor
+ */
+MonocleFlashStorage::MonocleFlashStorage() {
+}
+
+/**
+ * LOAD THE FLASH REGION; MUST BE CALLED BEFORE USE
+ * (THE REGION IS BLANK AFTER EVERY REFLASH OF THE SKETCH)
+ */
+void MonocleFlashStorage::begin(){
+  // read through a volatile pointer; the compiler must not assume the blank initializer
+  const volatile uint8_t* flash = monocle_flash_region;
+  uint8_t* bytes = (uint8_t*)cache;
+  for(size_t index = 0; index < MONOCLE_STORAGE_FLASH_SIZE; index++){
+    bytes[index] = flash[index];
+  }
+  dirty = false;
+}
+
+size_t MonocleFlashStorage::size(){
+  return MONOCLE_STORAGE_FLASH_SIZE;
+}
+
+bool MonocleFlashStorage::read(size_t address, void* data, size_t length){
+  if(address + length > MONOCLE_STORAGE_FLASH_SIZE) return false;
+  memcpy(data, ((uint8_t*)cache) + address, length);
+  return true;
+}
+
+bool MonocleFlashStorage::write(size_t address, const void* data, size_t length){
+  if(address + length > MONOCLE_STORAGE_FLASH_SIZE) return false;
+  memcpy(((uint8_t*)cache) + address, data, length);
+  dirty = true;
+  return true;
+}
+
+/**
+ * ERASE AND REWRITE THE FLASH REGION IF ANYTHING CHANGED
+ * (THE CPU STALLS FOR A FEW MILLISECONDS WHILE A ROW IS ERASED)
+ */
+bool MonocleFlashStorage::commit(){
+  if(!dirty) return true;
+
+  const uint32_t pageSize = 8 << NVMCTRL->PARAM.bit.PSZ;
+  const uint32_t rowSize = pageSize * 4;
+  if(rowSize != MONOCLE_STORAGE_FLASH_ROW_SIZE) return false;   // region not row aligned on this part
+  volatile uint32_t* flash = (volatile uint32_t*)monocle_flash_region;
+  const uint32_t* source = cache;
+
+  // pages are written manually once the page buffer is filled
+  NVMCTRL->CTRLB.bit.MANW = 1;
+
+  for(uint32_t row = 0; row < MONOCLE_STORAGE_FLASH_SIZE; row += rowSize){
+    // erase the row
+    NVMCTRL->ADDR.reg = ((uintptr_t)monocle_flash_region + row) / 2;
+    NVMCTRL->CTRLA.reg = NVMCTRL_CTRLA_CMDEX_KEY | NVMCTRL_CTRLA_CMD_ER;
+    while(!NVMCTRL->INTFLAG.bit.READY) { }
+
+    // write the row one page at a time
+    for(uint32_t page = 0; page < rowSize; page += pageSize){
+      NVMCTRL->CTRLA.reg = NVMCTRL_CTRLA_CMDEX_KEY | NVMCTRL_CTRLA_CMD_PBC;
+      while(!NVMCTRL->INTFLAG.bit.READY) { }
+      for(uint32_t word = 0; word < pageSize / 4; word++){
+        *flash++ = *source++;
+      }
+      NVMCTRL->CTRLA.reg = NVMCTRL_CTRLA_CMDEX_KEY | NVMCTRL_CTRLA_CMD_WP;
+      while(!NVMCTRL->INTFLAG.bit.READY) { }
+    }
+  }
+
+  dirty = false;
+  return true;
+}
+#endif
@@ -0,0 +1,198 @@
+/*
+ **********************************************************************
+ *             __  __  ___  _  _  ___   ___ _    ___
+ *            |  \/  |/ _ \| \| |/ _ \ / __| |  | __|
+ *            | |\/| | (_) | .` | (_) | (__| |__| _|
+ *            |_|  |_|\___/|_|\_|\___/ \___|____|___|
+ *
+ * -------------------------------------------------------------------
+ *                     MONOCLE STORAGE
+ * -------------------------------------------------------------------
+ *
+ *  This library provides small persistent records for the Monocle
+ *  components (cached gateway endpoints, boot snapshots and runtime
+ *  configuration).  'MonocleStorage' is a byte addressable storage
+ *  interface; records are stored with a header holding a magic
+ *  number, a version and the record length, and are protected by a
+ *  CRC so that blank, stale or corrupted storage is never restored.
+ *  Unchanged records are not written again to spare the flash.
+ *
+ *  'MonocleEEPROMStorage' implements the interface on top of the
+ *  EEPROM (emulation) library of the ESP8266, ESP32 and AVR cores.
+ *  'MonocleFlashStorage' implements it on the SAMD21 (MKR1000) using
+ *  a reserved region of the program flash.  The region is part of the
+ *  sketch image, so it is erased on every reflash: all records are
+ *  lost whenever a new sketch is uploaded and the components fall
+ *  back to their defaults on the next boot.
+ *
+ *  Author:   Robert Savage
+ *  Date:     2018-02-18
+ *  Website:  http://monoclecam.com
+ *
+ * -------------------------------------------------------------------
+ *        COPYRIGHT SHADEBLUE, LLC @ 2018, ALL RIGHTS RESERVED
+ * -------------------------------------------------------------------
+ *
+ **********************************************************************
+ */
+#ifndef MONOCLE_STORAGE_H
+#define MONOCLE_STORAGE_H
+
+#include <Arduino.h>
+
+/* BOARDS WITH AN EEPROM (EMULATION) LIBRARY */
+#if defined(ESP8266) || defined(ESP32) || defined(__AVR__)
+#define MONOCLE_STORAGE_EEPROM
+#endif
+
+/* SIZE OF THE EMULATED EEPROM ON THE ESP8266 AND ESP32 */
+#ifndef MONOCLE_STORAGE_EEPROM_SIZE
+#define MONOCLE_STORAGE_EEPROM_SIZE 512
+#endif
+
+/* BOARDS STORING RECORDS IN PROGRAM FLASH */
+#if defined(ARDUINO_ARCH_SAMD)
+#define MONOCLE_STORAGE_FLASH
+#endif
+
+/* SAMD21 FLASH ROW SIZE (THE ERASE UNIT: FOUR 64 BYTE PAGES) */
+#define MONOCLE_STORAGE_FLASH_ROW_SIZE 256
+
+/* SIZE OF THE RESERVED FLASH REGION (MULTIPLE OF THE FLASH ROW SIZE);
+   THE REGION IS ERASED ON EVERY REFLASH OF THE SKETCH AND HOLDS THE
+   RECORDS BACK TO BACK, E.G. THE BOOT SNAPSHOT (ABOUT 220 BYTES), THE
+   CONFIGURATION (ABOUT 205) AND FOUR MACROS (4 x 74) IN ABOUT 720 BYTES */
+#ifndef MONOCLE_STORAGE_FLASH_SIZE
+#define MONOCLE_STORAGE_FLASH_SIZE 1024
+#endif
+
+/* RECORD HEADER MAGIC NUMBER ("MC") */
+#define MONOCLE_STORAGE_MAGIC 0x4D43
+
+/**
+ * HEADER STORED IN FRONT OF EACH RECORD
+ */
+struct MonocleRecordHeader {
+  uint16_t magic;
+  uint8_t version;
+  uint8_t reserved;
+  uint16_t length;
+  uint16_t crc;
+};
+
+class MonocleStorage
+{
+   public:
+     virtual ~MonocleStorage() {}
+
+     /**
+      * GET THE STORAGE CAPACITY (BYTES)
+      */
+     virtual size_t size() = 0;
+
+     /**
+      * READ BYTES FROM STORAGE; RETURNS 'false' IF OUT OF RANGE
+      */
+     virtual bool read(size_t address, void* data, size_t length) = 0;
+
+     /**
+      * WRITE BYTES TO STORAGE (PERSISTED BY 'commit()');
+      * RETURNS 'false' IF OUT OF RANGE
+      */
+     virtual bool write(size_t address, const void* data, size_t length) = 0;
+
+     /**
+      * PERSIST PENDING WRITES; RETURNS 'false' ON FAILURE
+      */
+     virtual bool commit() { return true; }
+
+     /**
+      * LOAD A RECORD STORED AT AN ADDRESS; THE RECORD IS ONLY COPIED
+      * WHEN THE MAGIC NUMBER, VERSION, LENGTH AND CRC ALL MATCH.
+      * RETURNS 'false' IF NO VALID RECORD IS STORED
+      */
+     bool load(size_t address, uint8_t version, void* record, size_t length);
+
+     /**
+      * SAVE A RECORD TO AN ADDRESS (SKIPPED IF THE STORED RECORD IS
+      * IDENTICAL). A RECORD OCCUPIES 'footprint(length)' BYTES.
+      * RETURNS 'false' ON FAILURE
+      */
+     bool save(size_t address, uint8_t version, const void* record, size_t length);
+
+     /**
+      * INVALIDATE THE RECORD STORED AT AN ADDRESS
+      */
+     bool erase(size_t address);
+
+     /**
+      * GET THE NUMBER OF STORAGE BYTES USED BY A RECORD
+      */
+     static size_t footprint(size_t length);
+
+     /**
+      * CALCULATE THE CRC-16 (CCITT) OF A BLOCK OF BYTES
+      */
+     static uint16_t crc16(const void* data, size_t length, uint16_t crc = 0xFFFF);
+};
+
+#ifdef MONOCLE_STORAGE_EEPROM
+class MonocleEEPROMStorage : public MonocleStorage
+{
+   private:
+     size_t capacity;
+
+   public:
+    /**
+     * Default Constructor
+     */
+     MonocleEEPROMStorage(size_t capacity = MONOCLE_STORAGE_EEPROM_SIZE);
+
+     /**
+      * START THE EEPROM (EMULATION); MUST BE CALLED BEFORE USE
+      */
+     void begin();
+
+     size_t size();
+     bool read(size_t address, void* data, size_t length);
+     bool write(size_t address, const void* data, size_t length);
+     bool commit();
+};
+#endif
+
+#ifdef MONOCLE_STORAGE_FLASH
+static_assert(MONOCLE_STORAGE_FLASH_SIZE > 0 && MONOCLE_STORAGE_FLASH_SIZE % MONOCLE_STORAGE_FLASH_ROW_SIZE == 0,
+              "MONOCLE_STORAGE_FLASH_SIZE must be a multiple of the flash row size");
+
+class MonocleFlashStorage : public MonocleStorage
+{
+   private:
+     /* RAM COPY OF THE FLASH REGION (WORD ALIGNED FOR PAGE WRITES) */
+     uint32_t cache[MONOCLE_STORAGE_FLASH_SIZE / 4];
+     bool dirty = false;
+
+   public:
+    /**
+     * Default Constructor
+     */
+     MonocleFlashStorage();
+
+     /**
+      * LOAD THE FLASH REGION; MUST BE CALLED BEFORE USE
+      * (THE REGION IS BLANK AFTER EVERY REFLASH OF THE SKETCH)
+      */
+     void begin();
+
+     size_t size();
+     bool read(size_t address, void* data, size_t length);
+     bool write(size_t address, const void* data, size_t length);
+
+     /**
+      * ERASE AND REWRITE THE FLASH REGION IF ANYTHING CHANGED
+      * (THE CPU STALLS FOR A FEW MILLISECONDS WHILE A ROW IS ERASED)
+      */
+     bool commit();
+};
+#endif
+
+#endif //MONOCLE_STORAGE_H
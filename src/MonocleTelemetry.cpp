@@ -0,0 +1,256 @@
+/*
+ **********************************************************************
+ *             __  __  ___  _  _  ___   ___ _    ___
+ *            |  \/  |/ _ \| \| |/ _ \ / __| |  | __|
+ *            | |\/| | (_) | .` | (_) | (__| |__| _|
+ *            |_|  |_|\___/|_|\_|\___/ \___|____|___|
+ *
+ * -------------------------------------------------------------------
+ *                     MONOCLE TELEMETRY
+ * -------------------------------------------------------------------
+ *
+ *  This library collects performance counters, gauges and histograms
+ *  from the library components in fixed memory and formats them as
+ *  a compact telemetry frame.  'MonocleGatewayClient' sends a frame
+ *  to the Monocle Gateway at the configured interval so a fleet of
+ *  controllers can be monitored in one place.
+ *
+ *  Frames are text ('TELEMETRY:seq=12,up=3600,heap=20480,...');
+ *  counters are totals since boot (a lost frame loses no counts)
+ *  and histograms hold the samples since the previous frame in
+ *  power-of-two buckets.  A frame is held back while camera commands
+ *  are queued or were just sent, so telemetry never delays PTZ
+ *  traffic.
+ *
+ *  Author:   Robert Savage
+ *  Date:     2018-02-18
+ *  Website:  http://monoclecam.com
+ *
+ * -------------------------------------------------------------------
+ *        COPYRIGHT SHADEBLUE, LLC @ 2018, ALL RIGHTS RESERVED
+ * -------------------------------------------------------------------
+ *
+ **********************************************************************
+ */
+
+#include "Arduino.h"
+#include "MonocleTelemetry.h"
+
+#if defined(__arm__)
+extern "C" char* sbrk(int increment);
+#elif defined(__AVR__)
+extern char* __brkval;
+extern char __heap_start;
+#endif
+
+/**
+ * FIELD KEYS USED IN A FRAME (INDEXED BY FIELD)
+ */
+static const char* const MONOCLE_TELEMETRY_KEYS[MONOCLE_TELEMETRY_FIELDS] = {
+  "up", "heap", "rssi",
+  "conn", "disc", "cmd", "msg", "ovr", "skip", "defer",
+  "task", "late", "send", "rtt"
+};
+
+/**
+ * GET THE FREE MEMORY (BYTES) BETWEEN THE HEAP AND THE STACK
+ * (THE FREE HEAP ON ESP BOARDS; 0 WHERE IT IS NOT KNOWN)
+ */
+static long freeMemory(){
+#if defined(ESP8266) || defined(ESP32)
+  return ESP.getFreeHeap();
+#elif defined(__arm__)
+  char top;
+  return &top - sbrk(0);
+#elif defined(__AVR__)
+  char top;
+  return &top - ((__brkval == NULL) ? &__heap_start : __brkval);
+#else
+  return 0;
+#endif
+}
+
+/**
+ * Default Constructor
+ */
+MonocleTelemetry::MonocleTelemetry(){
+  this->sampleCallback = NULL;
+  reset();
+}
+
+/**
+ * SET THE FRAME INTERVAL (MILLISECONDS; 0 DISABLES TELEMETRY FRAMES)
+ */
+void MonocleTelemetry::setInterval(unsigned long milliseconds){
+  if(milliseconds > 0 && milliseconds < MONOCLE_TELEMETRY_MIN_INTERVAL)
+    milliseconds = MONOCLE_TELEMETRY_MIN_INTERVAL;
+  frameInterval = milliseconds;
+}
+unsigned long MonocleTelemetry::interval(){
+  return frameInterval;
+}
+
+/**
+ * SELECT THE FIELDS INCLUDED IN A FRAME (ONE BIT PER FIELD;
+ * E.G. (1 << MONOCLE_TELEMETRY_HEAP) | (1 << MONOCLE_TELEMETRY_RSSI))
+ */
+void MonocleTelemetry::setFields(uint16_t mask){
+  fieldMask = mask & MONOCLE_TELEMETRY_ALL_FIELDS;
+}
+uint16_t MonocleTelemetry::fields(){
+  return fieldMask;
+}
+
+/**
+ * SET A GAUGE FIELD (E.G. MONOCLE_TELEMETRY_RSSI)
+ */
+void MonocleTelemetry::set(const uint8_t field, long value){
+  if(field < MONOCLE_TELEMETRY_CONNECTS) gauges[field] = value;
+}
+
+/**
+ * ADD TO A COUNTER FIELD
+ */
+void MonocleTelemetry::count(const uint8_t field, uint32_t amount){
+  if(field < MONOCLE_TELEMETRY_CONNECTS || field >= MONOCLE_TELEMETRY_TASK_TIME) return;
+  counters[field - MONOCLE_TELEMETRY_CONNECTS] += amount;
+}
+
+/**
+ * GET THE HISTOGRAM BUCKET OF A SAMPLE VALUE
+ */
+uint8_t MonocleTelemetry::bucketOf(unsigned long value){
+  uint8_t bucket = 0;
+  while(value != 0 && bucket < MONOCLE_TELEMETRY_BUCKETS - 1){
+    value >>= 1;
+    bucket++;
+  }
+  return bucket;
+}
+
+/**
+ * ADD A SAMPLE TO A HISTOGRAM FIELD
+ */
+void MonocleTelemetry::sample(const uint8_t field, unsigned long value){
+  if(field < MONOCLE_TELEMETRY_TASK_TIME || field >= MONOCLE_TELEMETRY_FIELDS) return;
+  uint16_t& bucket = histograms[field - MONOCLE_TELEMETRY_TASK_TIME][bucketOf(value)];
+  if(bucket < 0xFFFF) bucket++;   // saturate rather than wrap
+}
+
+/**
+ * GET A GAUGE, COUNTER OR HISTOGRAM BUCKET VALUE
+ */
+long MonocleTelemetry::gauge(const uint8_t field){
+  return (field < MONOCLE_TELEMETRY_CONNECTS) ? gauges[field] : 0;
+}
+uint32_t MonocleTelemetry::counter(const uint8_t field){
+  if(field < MONOCLE_TELEMETRY_CONNECTS || field >= MONOCLE_TELEMETRY_TASK_TIME) return 0;
+  return counters[field - MONOCLE_TELEMETRY_CONNECTS];
+}
+uint16_t MonocleTelemetry::bucket(const uint8_t field, const uint8_t index){
+  if(field < MONOCLE_TELEMETRY_TASK_TIME || field >= MONOCLE_TELEMETRY_FIELDS) return 0;
+  if(index >= MONOCLE_TELEMETRY_BUCKETS) return 0;
+  return histograms[field - MONOCLE_TELEMETRY_TASK_TIME][index];
+}
+
+/**
+ * DETERMINE IF A FRAME IS DUE; WHILE 'busy' (CAMERA COMMAND TRAFFIC)
+ * A DUE FRAME IS HELD BACK AND COUNTED AS DEFERRED.  RETURNS 'true'
+ * WHEN THE FRAME SHOULD BE FORMATTED AND SENT NOW
+ */
+bool MonocleTelemetry::ready(bool busy){
+  if(frameInterval == 0) return false;
+  unsigned long now = millis();
+  if((now - frameTime) < frameInterval) return false;
+
+  // count each held back frame once, however long the traffic lasts
+  if(busy){
+    if(!deferring) counters[MONOCLE_TELEMETRY_DEFERRED - MONOCLE_TELEMETRY_CONNECTS]++;
+    deferring = true;
+    return false;
+  }
+  deferring = false;
+  frameTime = now;
+  return true;
+}
+
+/**
+ * FORMAT A FRAME OF THE SELECTED FIELDS (SAMPLES THE GAUGES FIRST)
+ * AND START THE NEXT HISTOGRAM INTERVAL.
+ * RETURNS THE FRAME LENGTH
+ */
+size_t MonocleTelemetry::format(char* frame, size_t size){
+  if(frame == NULL || size == 0) return 0;
+
+  // sample the gauges; the program may add its own (e.g. RSSI)
+  gauges[MONOCLE_TELEMETRY_UPTIME] = millis() / 1000;
+  gauges[MONOCLE_TELEMETRY_HEAP] = freeMemory();
+  if(sampleCallback != NULL) sampleCallback();
+
+  int written = snprintf(frame, size, "TELEMETRY:seq=%lu", sequence++);
+  if(written < 0 || (size_t)written >= size){
+    frame[0] = '\0';
+    return 0;
+  }
+  size_t length = written;
+
+  for(uint8_t field = 0; field < MONOCLE_TELEMETRY_FIELDS; field++){
+    if(!(fieldMask & (1U << field))) continue;
+    size_t start = length;
+
+    // gauges and counters are a single value; histograms list their
+    // buckets up to the last non-empty one ("task=0/12/40/3")
+    if(field < MONOCLE_TELEMETRY_TASK_TIME){
+      if(field < MONOCLE_TELEMETRY_CONNECTS)
+        written = snprintf(frame + length, size - length, ",%s=%ld", MONOCLE_TELEMETRY_KEYS[field], gauges[field]);
+      else
+        written = snprintf(frame + length, size - length, ",%s=%lu", MONOCLE_TELEMETRY_KEYS[field], (unsigned long)counter(field));
+      if(written < 0 || (size_t)written >= size - length) written = -1;
+      else length += written;
+    }
+    else {
+      const uint16_t* buckets = histograms[field - MONOCLE_TELEMETRY_TASK_TIME];
+      int last = MONOCLE_TELEMETRY_BUCKETS - 1;
+      while(last > 0 && buckets[last] == 0) last--;
+      written = snprintf(frame + length, size - length, ",%s=", MONOCLE_TELEMETRY_KEYS[field]);
+      for(int index = 0; index <= last && written >= 0; index++){
+        if((size_t)written >= size - length){
+          written = -1;
+          break;
+        }
+        length += written;
+        written = snprintf(frame + length, size - length, (index == 0) ? "%u" : "/%u", (unsigned int)buckets[index]);
+      }
+      if(written < 0 || (size_t)written >= size - length) written = -1;
+      else length += written;
+    }
+
+    // leave out a field that does not fit (and keep trying smaller ones)
+    if(written < 0){
+      length = start;
+      frame[length] = '\0';
+    }
+  }
+
+  // the histograms restart with each frame
+  memset(histograms, 0, sizeof(histograms));
+  return length;
+}
+
+/**
+ * CLEAR ALL COLLECTED VALUES
+ */
+void MonocleTelemetry::reset(){
+  memset(gauges, 0, sizeof(gauges));
+  memset(counters, 0, sizeof(counters));
+  memset(histograms, 0, sizeof(histograms));
+  deferring = false;
+}
+
+/**
+ * REGISTERS A CALLBACK FUNCTION POINTER CALLED BEFORE EACH FRAME
+ * IS FORMATTED (E.G. TO SET MONOCLE_TELEMETRY_RSSI)
+ */
+void MonocleTelemetry::onSample(void (*sampleCallback)(void)){
+  this->sampleCallback = sampleCallback;
+}
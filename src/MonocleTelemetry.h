@@ -0,0 +1,173 @@
+/*
+ **********************************************************************
+ *             __  __  ___  _  _  ___   ___ _    ___
+ *            |  \/  |/ _ \| \| |/ _ \ / __| |  | __|
+ *            | |\/| | (_) | .` | (_) | (__| |__| _|
+ *            |_|  |_|\___/|_|\_|\___/ \___|____|___|
+ *
+ * -------------------------------------------------------------------
+ *                     MONOCLE TELEMETRY
+ * -------------------------------------------------------------------
+ *
+ *  This library collects performance counters, gauges and histograms
+ *  from the library components in fixed memory and formats them as
+ *  a compact telemetry frame.  'MonocleGatewayClient' sends a frame
+ *  to the Monocle Gateway at the configured interval so a fleet of
+ *  controllers can be monitored in one place.
+ *
+ *  Frames are text ('TELEMETRY:seq=12,up=3600,heap=20480,...');
+ *  counters are totals since boot (a lost frame loses no counts)
+ *  and histograms hold the samples since the previous frame in
+ *  power-of-two buckets.  A frame is held back while camera commands
+ *  are queued or were just sent, so telemetry never delays PTZ
+ *  traffic.
+ *
+ *  Author:   Robert Savage
+ *  Date:     2018-02-18
+ *  Website:  http://monoclecam.com
+ *
+ * -------------------------------------------------------------------
+ *        COPYRIGHT SHADEBLUE, LLC @ 2018, ALL RIGHTS RESERVED
+ * -------------------------------------------------------------------
+ *
+ **********************************************************************
+ */
+#ifndef MONOCLE_TELEMETRY_H
+#define MONOCLE_TELEMETRY_H
+
+#include <Arduino.h>
+
+/* DEFAULT AND MINIMUM FRAME INTERVAL (0 DISABLES TELEMETRY) */
+#ifndef MONOCLE_TELEMETRY_DEFAULT_INTERVAL
+#define MONOCLE_TELEMETRY_DEFAULT_INTERVAL 60000   // milliseconds
+#endif
+#define MONOCLE_TELEMETRY_MIN_INTERVAL     1000    // milliseconds
+
+/* A FRAME IS HELD BACK FOR THIS LONG AFTER A CAMERA COMMAND WAS SENT */
+#ifndef MONOCLE_TELEMETRY_QUIET_TIME
+#define MONOCLE_TELEMETRY_QUIET_TIME 250   // milliseconds
+#endif
+
+/* LONGEST FRAME (FIELDS THAT DO NOT FIT ARE LEFT OUT OF THE FRAME) */
+#ifndef MONOCLE_TELEMETRY_FRAME_LENGTH
+#define MONOCLE_TELEMETRY_FRAME_LENGTH 256
+#endif
+
+/* HISTOGRAM BUCKETS; BUCKET 0 COUNTS ZERO, BUCKET N COUNTS 2^(N-1) .. 2^N-1 */
+/* AND THE LAST BUCKET COUNTS EVERYTHING ABOVE                              */
+#ifndef MONOCLE_TELEMETRY_BUCKETS
+#define MONOCLE_TELEMETRY_BUCKETS 16
+#endif
+
+/* TELEMETRY FIELDS: GAUGES (LAST VALUE) */
+#define MONOCLE_TELEMETRY_UPTIME      0    // seconds since boot
+#define MONOCLE_TELEMETRY_HEAP        1    // free memory (bytes)
+#define MONOCLE_TELEMETRY_RSSI        2    // Wi-Fi signal strength (dBm; set by the program)
+
+/* TELEMETRY FIELDS: COUNTERS (TOTALS SINCE BOOT) */
+#define MONOCLE_TELEMETRY_CONNECTS    3    // gateway connections established
+#define MONOCLE_TELEMETRY_DISCONNECTS 4    // gateway connections lost
+#define MONOCLE_TELEMETRY_COMMANDS    5    // commands sent to the gateway
+#define MONOCLE_TELEMETRY_MESSAGES    6    // messages received from the gateway
+#define MONOCLE_TELEMETRY_OVERRUNS    7    // scheduler task executions exceeding their budget
+#define MONOCLE_TELEMETRY_SKIPPED     8    // scheduler task deadlines missed entirely
+#define MONOCLE_TELEMETRY_DEFERRED    9    // frames held back by camera command traffic
+
+/* TELEMETRY FIELDS: HISTOGRAMS (SAMPLES SINCE THE PREVIOUS FRAME) */
+#define MONOCLE_TELEMETRY_TASK_TIME   10   // scheduler task execution time (microseconds)
+#define MONOCLE_TELEMETRY_LATENESS    11   // scheduler task start past its deadline (milliseconds)
+#define MONOCLE_TELEMETRY_SEND_TIME   12   // gateway command send time (microseconds)
+#define MONOCLE_TELEMETRY_ROUND_TRIP  13   // gateway heartbeat round trip time (milliseconds)
+
+#define MONOCLE_TELEMETRY_FIELDS      14
+#define MONOCLE_TELEMETRY_ALL_FIELDS  0x3FFF   // one bit per field (1 << field)
+
+class MonocleTelemetry
+{
+   private:
+     /* FRAME TIMING AND CONTENT */
+     unsigned long frameInterval = MONOCLE_TELEMETRY_DEFAULT_INTERVAL;
+     unsigned long frameTime = 0;
+     unsigned long sequence = 0;
+     uint16_t fieldMask = MONOCLE_TELEMETRY_ALL_FIELDS;
+     bool deferring = false;
+
+     /* COLLECTED VALUES */
+     long gauges[MONOCLE_TELEMETRY_CONNECTS];
+     uint32_t counters[MONOCLE_TELEMETRY_TASK_TIME - MONOCLE_TELEMETRY_CONNECTS];
+     uint16_t histograms[MONOCLE_TELEMETRY_FIELDS - MONOCLE_TELEMETRY_TASK_TIME][MONOCLE_TELEMETRY_BUCKETS];
+
+     /* USER CALLBACKS */
+     void (*sampleCallback)(void);
+
+     /* INTERNAL PROCESSING */
+     static uint8_t bucketOf(unsigned long value);
+
+   public:
+    /**
+     * Default Constructor
+     */
+     MonocleTelemetry();
+
+     /**
+      * SET THE FRAME INTERVAL (MILLISECONDS; 0 DISABLES TELEMETRY FRAMES)
+      */
+     void setInterval(unsigned long milliseconds);
+     unsigned long interval();
+
+     /**
+      * SELECT THE FIELDS INCLUDED IN A FRAME (ONE BIT PER FIELD;
+      * E.G. (1 << MONOCLE_TELEMETRY_HEAP) | (1 << MONOCLE_TELEMETRY_RSSI))
+      */
+     void setFields(uint16_t mask);
+     uint16_t fields();
+
+     /**
+      * SET A GAUGE FIELD (E.G. MONOCLE_TELEMETRY_RSSI)
+      */
+     void set(const uint8_t field, long value);
+
+     /**
+      * ADD TO A COUNTER FIELD
+      */
+     void count(const uint8_t field, uint32_t amount = 1);
+
+     /**
+      * ADD A SAMPLE TO A HISTOGRAM FIELD
+      */
+     void sample(const uint8_t field, unsigned long value);
+
+     /**
+      * GET A GAUGE, COUNTER OR HISTOGRAM BUCKET VALUE
+      */
+     long gauge(const uint8_t field);
+     uint32_t counter(const uint8_t field);
+     uint16_t bucket(const uint8_t field, const uint8_t index);
+
+     /**
+      * DETERMINE IF A FRAME IS DUE; WHILE 'busy' (CAMERA COMMAND TRAFFIC)
+      * A DUE FRAME IS HELD BACK AND COUNTED AS DEFERRED.  RETURNS 'true'
+      * WHEN THE FRAME SHOULD BE FORMATTED AND SENT NOW
+      */
+     bool ready(bool busy);
+
+     /**
+      * FORMAT A FRAME OF THE SELECTED FIELDS (SAMPLES THE GAUGES FIRST)
+      * AND START THE NEXT HISTOGRAM INTERVAL.
+      * RETURNS THE FRAME LENGTH
+      */
+     size_t format(char* frame, size_t size);
+
+     /**
+      * CLEAR ALL COLLECTED VALUES
+      */
+     void reset();
+
+     /**
+      * REGISTERS A CALLBACK FUNCTION POINTER CALLED BEFORE EACH FRAME
+      * IS FORMATTED (E.G. TO SET MONOCLE_TELEMETRY_RSSI)
+      */
+     void onSample(void (*sampleCallback)(void));
+};
+
+#endif //MONOCLE_TELEMETRY_H